@@ -0,0 +1,81 @@
+/*
+ * Performance of the Arakawa bracket of two 3D fields
+ *
+ * Reports the time per call and the floating point rate of
+ * bracket(f, g, BRACKET_ARAKAWA), compared with the reference
+ * BRACKET_ARAKAWA_OLD implementation
+ */
+
+#include <bout/bout.hxx>
+#include <bout/difops.hxx>
+#include <bout/initialprofiles.hxx>
+#include <bout/sys/timer.hxx>
+
+#include <algorithm>
+#include <string>
+
+namespace {
+/// Floating point operations per point in the Arakawa bracket of two
+/// 3D fields: 7 for J++, 11 each for J+x and Jx+, and 3 to combine
+/// them and multiply by the grid spacing factor
+constexpr int flops_per_point = 32;
+
+/// Time \p iterations calls of the bracket with \p method, and print
+/// the slowest processor's time per call and the total GFLOP/s
+Field3D timeBracket(const Field3D& f, const Field3D& g, BRACKET_METHOD method,
+                    const std::string& name, int iterations, BoutReal npoints) {
+  Field3D result = bracket(f, g, method); // Warm up
+  Timer timer(name);
+  for (int i = 0; i < iterations; ++i) {
+    result = bracket(f, g, method);
+  }
+  BoutReal elapsed = timer.getTime();
+  MPI_Allreduce(MPI_IN_PLACE, &elapsed, 1, MPI_DOUBLE, MPI_MAX, BoutComm::get());
+
+  const BoutReal per_call = elapsed / iterations;
+  const BoutReal gflops = flops_per_point * npoints / per_call / 1e9;
+  output.write("{:<16s} {:12.4e} s/call {:10.3f} GFLOP/s\n", name, per_call, gflops);
+  return result;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  BoutInitialise(argc, argv);
+
+  const int iterations = Options::root()["iterations"]
+                             .doc("Number of calls to time for each method")
+                             .withDefault(100);
+
+  Field3D f, g;
+  initial_profile("f", f);
+  initial_profile("g", g);
+  Mesh* mesh = f.getMesh();
+  mesh->communicate(f, g);
+
+  // Total number of points evaluated on all processors
+  BoutReal npoints = f.getRegion("RGN_NOBNDRY").size();
+  MPI_Allreduce(MPI_IN_PLACE, &npoints, 1, MPI_DOUBLE, MPI_SUM, BoutComm::get());
+
+  int nthreads = 1;
+#if BOUT_USE_OPENMP
+  nthreads = omp_get_max_threads();
+#endif
+
+  output.enable();
+  output.write("Arakawa bracket, {:d} processors, {:d} threads, {:d}x{:d}x{:d} grid\n",
+               BoutComm::size(), nthreads, mesh->GlobalNx, mesh->GlobalNy,
+               mesh->GlobalNz);
+
+  const Field3D result =
+      timeBracket(f, g, BRACKET_ARAKAWA, "ARAKAWA", iterations, npoints);
+  const Field3D reference =
+      timeBracket(f, g, BRACKET_ARAKAWA_OLD, "ARAKAWA_OLD", iterations, npoints);
+
+  // Check the two implementations agree
+  const BoutReal difference = max(abs(result - reference), true, "RGN_NOBNDRY");
+  const BoutReal scale = std::max(max(abs(reference), true, "RGN_NOBNDRY"), 1e-30);
+  output.write("Maximum relative difference: {:e}\n", difference / scale);
+
+  BoutFinalise();
+  return 0;
+}
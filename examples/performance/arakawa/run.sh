@@ -0,0 +1,5 @@
+#!/usr/bin/env bash
+
+make || exit
+
+./arakawa -q -q -q
@@ -6,6 +6,7 @@
 #include <bout/physicsmodel.hxx>
 
 #include <bout/expr.hxx>
+#include <bout/field_expr.hxx>
 
 #include <chrono>
 
@@ -39,14 +40,14 @@ protected:
     Field3D b = 2.0;
     Field3D c = 3.0;
 
-    Field3D result1, result2, result3, result4;
+    Field3D result1, result2, result3, result4, result5;
 
     // Using Field methods (classic operator overloading)
 
     result1 = 2. * a + b * c;
 #define dur_init {Duration::min(), Duration::max(), Duration::zero(), 0}
     Durations elapsed1 = dur_init, elapsed2 = dur_init, elapsed3 = dur_init,
-              elapsed4 = dur_init;
+              elapsed4 = dur_init, elapsed5 = dur_init;
 
     for (int ik = 0; ik < 1e2; ++ik) {
       TIMEIT(elapsed1, result1 = 2. * a + b * c;);
@@ -74,6 +75,10 @@ protected:
       // Range iterator
       result4.allocate();
       TIMEIT(elapsed4, for (auto i : result4) result4[i] = 2. * a[i] + b[i] * c[i];);
+
+      // Lazy field expressions
+      using bout::expr::lazy;
+      TIMEIT(elapsed5, result5 = 2. * lazy(a) + lazy(b) * c;);
     }
 
     output.enable();
@@ -87,6 +92,7 @@ protected:
     PRINT("C loop:    ", elapsed2);
     PRINT("Templates: ", elapsed3);
     PRINT("Range For: ", elapsed4);
+    PRINT("Lazy:      ", elapsed5);
     output.disable();
     SOLVE_FOR(n);
     return 0;
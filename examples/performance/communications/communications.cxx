@@ -9,14 +9,53 @@ int main(int argc, char** argv) {
   Field3D f;
   initial_profile("f", f);
   int iterations = Options::root()["iterations"].withDefault(10000);
+  int deriv_iterations = Options::root()["deriv_iterations"]
+                             .doc("Iterations of communication with a derivative")
+                             .withDefault(iterations / 10);
+
+  Mesh* mesh = f.getMesh();
 
   Timer timer("comms");
   for (int i = 0; i < iterations; ++i) {
-    f.getMesh()->communicate(f);
+    mesh->communicate(f);
   }
   BoutReal run_length = timer.getTime();
 
-  output << iterations << " iterations took " << run_length << "s";
+  output << iterations << " iterations took " << run_length << "s\n";
+
+  // d/dx with second order central differences, written straight
+  // into result over region
+  Coordinates* coord = mesh->getCoordinates();
+  Field3D result{emptyFrom(f)};
+  auto ddx = [&](const Region<Ind3D>& region) {
+    BOUT_FOR(i, region) { result[i] = (f[i.xp()] - f[i.xm()]) / (2. * coord->dx[i]); }
+  };
+
+  // Communicate, then take a derivative
+  Timer timer_blocking("comms_blocking");
+  for (int i = 0; i < deriv_iterations; ++i) {
+    mesh->communicate(f);
+    ddx(result.getRegion("RGN_NOBNDRY"));
+  }
+  BoutReal blocking_length = timer_blocking.getTime();
+
+  output << deriv_iterations << " blocking communicate + DDX took " << blocking_length
+         << "s\n";
+
+  // Overlap the communication with the derivative in the interior. If
+  // mesh:include_corner_cells is set, the corner cells are exchanged
+  // afterwards in finishCommunicate
+  Timer timer_overlap("comms_overlap");
+  for (int i = 0; i < deriv_iterations; ++i) {
+    comm_handle handle = mesh->startCommunicate(f);
+    ddx(result.getRegion("RGN_NOBNDRY_INTERIOR"));
+    mesh->finishCommunicate(handle, f);
+    ddx(result.getRegion("RGN_NOBNDRY_SHELL"));
+  }
+  BoutReal overlap_length = timer_overlap.getTime();
+
+  output << deriv_iterations << " overlapped communicate + DDX took " << overlap_length
+         << "s\n";
 
   BoutFinalise();
 
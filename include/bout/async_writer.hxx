@@ -0,0 +1,97 @@
+#pragma once
+
+#ifndef BOUT_ASYNC_WRITER_H
+#define BOUT_ASYNC_WRITER_H
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bout/options.hxx"
+#include "bout/options_netcdf.hxx"
+
+namespace bout {
+
+/// Make a copy of \p options which doesn't share any field or array
+/// data with the original, so that the original can be modified
+/// while the copy is being written out
+Options snapshot(const Options& options);
+
+/// Writes `Options` to `OptionsNetCDF` files, optionally from a
+/// background thread
+///
+/// Writes are collected into a batch, one batch per output
+/// timestep. When asynchronous, the data to write is snapshotted
+/// when it is added to the batch, and `finishStep` hands the batch
+/// to the writer thread. This is double-buffered: the simulation
+/// only waits if the writer is still busy with the previous batch.
+///
+/// When not asynchronous, everything is written immediately.
+///
+/// Any exception thrown while writing is rethrown on the
+/// simulation thread as a `BoutException` with the same message, by
+/// the next call to `finishStep` or `flush`
+///
+/// The files must not be used directly while there are writes
+/// still pending: call `flush` first. Other `OptionsNetCDF` files
+/// can be read at any time, as all NetCDF calls share one lock.
+class AsyncWriter {
+public:
+  explicit AsyncWriter(bool async = false);
+  AsyncWriter(const AsyncWriter&) = delete;
+  AsyncWriter& operator=(const AsyncWriter&) = delete;
+  /// Waits for all pending writes to finish
+  ~AsyncWriter();
+
+  /// Write \p options to \p file, with time dimension \p time_dim
+  void write(OptionsNetCDF& file, const Options& options,
+             const std::string& time_dim = "t");
+
+  /// Check the time dimensions of \p file, after the writes before it
+  void verifyTimesteps(OptionsNetCDF& file);
+
+  /// Hand the writes added since the last call to the writer
+  /// thread, first waiting for the previous batch to finish
+  void finishStep();
+
+  /// Write everything that is pending and wait for it to finish
+  void flush();
+
+  /// Are writes done on a background thread?
+  bool isAsync() const { return async; }
+
+private:
+  using Batch = std::vector<std::function<void()>>;
+
+  /// Run \p task now, or add it to the current batch
+  void add(std::function<void()> task);
+  /// Wait for the writer thread to finish the batch in flight
+  void waitForWriter();
+  /// Main loop of the writer thread
+  void run();
+
+  bool async;
+
+  /// Batch being filled by the simulation thread
+  Batch pending;
+  /// Batch owned by the writer thread while `busy`. Only cleared by
+  /// the simulation thread, so that snapshots are freed on that thread
+  Batch in_flight;
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  bool busy{false};
+  bool stop{false};
+  /// First error from the batch in flight
+  std::exception_ptr error;
+
+  std::thread writer;
+};
+
+} // namespace bout
+
+#endif // BOUT_ASYNC_WRITER_H
@@ -221,7 +221,7 @@ public:
   Field2D Laplace_perpXY(const Field2D& A, const Field2D& f);
 
 private:
-  int nz; // Size of mesh in Z. This is mesh->ngz-1
+  int nz; // Size of mesh in Z. This is mesh->GlobalNz
   Mesh* localmesh;
   CELL_LOC location;
 
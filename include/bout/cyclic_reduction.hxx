@@ -58,6 +58,9 @@
 
 #include "bout/openmpwrap.hxx"
 
+#include <algorithm>
+#include <vector>
+
 template <class T>
 class CyclicReduce {
 public:
@@ -92,6 +95,13 @@ public:
   /// By default not periodic
   void setPeriodic(bool p = true) { periodic = p; }
 
+  /// Solve the equations coupling processors with parallel cyclic
+  /// reduction, exchanging data only with other processors at
+  /// distances 1, 2, 4, ... (the default). Otherwise, or if the
+  /// system is periodic, they are gathered onto one processor for
+  /// each system, solved there, and the solution scattered back
+  void setInterfacePCR(bool pcr = true) { interface_pcr = pcr; }
+
   void setCoefs(const Array<T>& a, const Array<T>& b, const Array<T>& c) {
     ASSERT2(a.size() == b.size());
     ASSERT2(a.size() == c.size());
@@ -135,6 +145,9 @@ public:
         // 4*i + 3 will contain RHS
       }
     }
+
+    // The elimination of the local rows needs to be redone
+    factorised = false;
   }
 
   /// Solve a set of tridiagonal systems
@@ -192,12 +205,73 @@ public:
     }
 
     ///////////////////////////////////////
-    // Reduce local part of the matrix to interface equations
-    reduce(Nsys, N, coefs, myif);
+    // Reduce local part of the matrix to interface equations. The
+    // elimination of the coefficients only depends on the matrix, so is
+    // re-used until setCoefs is called again
+    if (not factorised) {
+      factorise();
+    }
+    reduceRHS();
+
+    ///////////////////////////////////////
+    // Solve the interface equations, giving x1 and xn for each system
+    if (interface_pcr and (nprocs > 1) and not periodic) {
+      solveInterfacePCR();
+    } else {
+      solveInterfaceGather();
+    }
+
+    ///////////////////////////////////////
+    // Solve local equations
+    back_solve_factorised(x);
+  }
+
+private:
+  MPI_Comm comm;             ///< Communicator
+  int nprocs{0}, myproc{-1}; ///< Number of processors and ID of my processor
+
+  int N{0};    ///< Total size of the problem
+  int Nsys{0}; ///< Number of independent systems to solve
+  int myns;    ///< Number of systems for interface solve on this processor
+  int sys0;    ///< Starting system index for interface solve
+
+  bool periodic{false};     ///< Is the domain periodic?
+  bool interface_pcr{true}; ///< Solve interface equations with PCR?
+
+  /// Smallest pivot allowed, relative to the sum of the magnitudes of
+  /// the coefficients in its row
+  static constexpr BoutReal pivot_tolerance = 1e-10;
+
+  Matrix<T> coefs; ///< Starting coefficients, rhs [Nsys, {3*coef,rhs}*N]
+  Matrix<T> myif;  ///< Interface equations for this processor
+
+  Matrix<T> recvbuffer; ///< Buffer for receiving from other processors
+  Matrix<T> ifcs;       ///< Coefficients for interface solve
+  Matrix<T> if2x2;      ///< 2x2 interface equations on this processor
+  Matrix<T> ifx;        ///< Solution of interface equations
+  Array<T> ifp;         ///< Interface equations returned to processor p
+  Array<T> x1, xn;      ///< Interface solutions for back-solving
+
+  std::vector<MPI_Request> requests; ///< Communication requests, kept between solves
+
+  Matrix<T> pcr_rows;  ///< Interface equations during PCR [Nsys, 8]
+  Matrix<T> pcr_left;  ///< Interface equations received from the left [Nsys, 8]
+  Matrix<T> pcr_right; ///< Interface equations received from the right [Nsys, 8]
+
+  /// Has the local part of the matrix been eliminated, and the
+  /// multipliers stored, since the coefficients were last set?
+  bool factorised{false};
+  Matrix<T> upper_beta;  ///< Multipliers for upper interface equation [Nsys, N]
+  Matrix<T> lower_alpha; ///< Multipliers for lower interface equation [Nsys, N]
+  Matrix<T> thomas_bet;  ///< Pivots of the local back-solve [Nsys, N]
+  Matrix<T> thomas_gam;  ///< Upper diagonal of the local back-solve [Nsys, N]
 
+  /// Gather the interface equations for each system onto one
+  /// processor, solve them there and scatter the solutions back.
+  /// Sets x1 and xn for all systems
+  void solveInterfaceGather() {
     ///////////////////////////////////////
     // Gather all interface equations onto single processor
-    // NOTE: Need to replace with divide-and-conquer at some point
     //
     // There are Nsys sets of equations to gather, and nprocs processors
     // which can be used. Each processor therefore sends interface equations
@@ -217,7 +291,7 @@ public:
     int ns = Nsys / nprocs;      // Number of systems to assign to all processors
     int nsextra = Nsys % nprocs; // Number of processors with 1 extra
 
-    auto* req = new MPI_Request[nprocs];
+    MPI_Request* req = requests.data();
 
     if (myns > 0) {
       // Post receives from all other processors
@@ -440,33 +514,172 @@ public:
         }
       } while (fromproc != MPI_UNDEFINED);
     }
-
-    ///////////////////////////////////////
-    // Solve local equations
-    back_solve(Nsys, N, coefs, x1, xn, x);
-    delete[] req;
   }
 
-private:
-  MPI_Comm comm;             ///< Communicator
-  int nprocs{0}, myproc{-1}; ///< Number of processors and ID of my processor
+  /// Solve the interface equations with parallel cyclic reduction,
+  /// without gathering them onto one processor. Sets x1 and xn for
+  /// all systems. Not used for periodic systems.
+  ///
+  /// The interface equations of all processors form a tridiagonal
+  /// system of 2 * nprocs rows for each system, ordered (x1, xn) on
+  /// processor 0, then (x1, xn) on processor 1 etc. Each processor
+  /// keeps its own two rows. At each step, row g is combined with rows
+  /// g - s and g + s to eliminate the coupling to them, doubling the
+  /// stride s. Rows g +/- s are on the processors dist = max(s / 2, 1)
+  /// to the left and right, so each step is one exchange with each of
+  /// these, containing the rows of all systems. After
+  /// ceil(log2(2 * nprocs)) steps each row is decoupled, and the
+  /// solutions are already on the processor which needs them.
+  void solveInterfacePCR() {
+    const int nrows = 2 * nprocs;
+    const int len = 8 * Nsys * sizeof(T); // Two rows of 3 coefficients + RHS
+
+    pcr_rows.ensureUnique();
+    pcr_left.ensureUnique();
+    pcr_right.ensureUnique();
 
-  int N{0};    ///< Total size of the problem
-  int Nsys{0}; ///< Number of independent systems to solve
-  int myns;    ///< Number of systems for interface solve on this processor
-  int sys0;    ///< Starting system index for interface solve
+    BOUT_OMP(parallel for)
+    for (int j = 0; j < Nsys; j++) {
+      for (int i = 0; i < 8; i++) {
+        pcr_rows(j, i) = myif(j, i);
+      }
+    }
+    // Not periodic, so no coupling outside the domain
+    if (myproc == 0) {
+      for (int j = 0; j < Nsys; j++) {
+        pcr_rows(j, 0) = 0.0;
+      }
+    }
+    if (myproc == nprocs - 1) {
+      for (int j = 0; j < Nsys; j++) {
+        pcr_rows(j, 4 + 2) = 0.0;
+      }
+    }
 
-  bool periodic{false}; ///< Is the domain periodic?
+    // Set if any system had a zero pivot. The steps are still all
+    // taken, so that every processor finishes the exchanges, and the
+    // exception is thrown at the end
+    int failed = 0;
+
+    int step = 0;
+    for (int stride = 1; stride < nrows; stride *= 2, ++step) {
+      const int dist = std::max(stride / 2, 1);
+      const int left = myproc - dist;
+      const int right = myproc + dist;
+      const bool has_left = left >= 0;
+      const bool has_right = right < nprocs;
+
+      // Messages sent to the right are tagged 2 * step, to the left 2 * step + 1
+      int nreq = 0;
+      if (has_left) {
+        MPI_Irecv(&pcr_left(0, 0), len, MPI_BYTE, left, 2 * step, comm,
+                  &requests[nreq++]);
+        MPI_Isend(&pcr_rows(0, 0), len, MPI_BYTE, left, 2 * step + 1, comm,
+                  &requests[nreq++]);
+      }
+      if (has_right) {
+        MPI_Irecv(&pcr_right(0, 0), len, MPI_BYTE, right, 2 * step + 1, comm,
+                  &requests[nreq++]);
+        MPI_Isend(&pcr_rows(0, 0), len, MPI_BYTE, right, 2 * step, comm,
+                  &requests[nreq++]);
+      }
+      MPI_Waitall(nreq, requests.data(), MPI_STATUSES_IGNORE);
+
+      BOUT_OMP(parallel for reduction(max:failed))
+      for (int j = 0; j < Nsys; j++) {
+        // Rows (a, b, c, r) at offset 0 (x1) and 4 (xn). For stride 1 the
+        // neighbours of a row are the other row on the same processor and
+        // the nearest row on the neighbouring processor, otherwise the
+        // same row on the processors to the left and right
+        const T* upper = &pcr_rows(j, 0);
+        const T* lower = &pcr_rows(j, 4);
+        const T* upper_prev = nullptr;
+        const T* upper_next = nullptr;
+        const T* lower_prev = nullptr;
+        const T* lower_next = nullptr;
+        if (stride == 1) {
+          upper_prev = has_left ? &pcr_left(j, 4) : nullptr;
+          upper_next = lower;
+          lower_prev = upper;
+          lower_next = has_right ? &pcr_right(j, 0) : nullptr;
+        } else {
+          upper_prev = has_left ? &pcr_left(j, 0) : nullptr;
+          upper_next = has_right ? &pcr_right(j, 0) : nullptr;
+          lower_prev = has_left ? &pcr_left(j, 4) : nullptr;
+          lower_next = has_right ? &pcr_right(j, 4) : nullptr;
+        }
 
-  Matrix<T> coefs; ///< Starting coefficients, rhs [Nsys, {3*coef,rhs}*N]
-  Matrix<T> myif;  ///< Interface equations for this processor
+        T result[8];
+        if (not(pcrEliminate(upper, upper_prev, upper_next, &result[0])
+                and pcrEliminate(lower, lower_prev, lower_next, &result[4]))) {
+          failed = 1;
+          continue;
+        }
+        for (int i = 0; i < 8; i++) {
+          pcr_rows(j, i) = result[i];
+        }
+      }
+    }
 
-  Matrix<T> recvbuffer; ///< Buffer for receiving from other processors
-  Matrix<T> ifcs;       ///< Coefficients for interface solve
-  Matrix<T> if2x2;      ///< 2x2 interface equations on this processor
-  Matrix<T> ifx;        ///< Solution of interface equations
-  Array<T> ifp;         ///< Interface equations returned to processor p
-  Array<T> x1, xn;      ///< Interface solutions for back-solving
+    if (failed != 0) {
+      throw BoutException("Zero pivot in CyclicReduce::solveInterfacePCR");
+    }
+
+    // Each row now only contains the diagonal
+    BOUT_OMP(parallel for)
+    for (int j = 0; j < Nsys; j++) {
+      x1[j] = pcr_rows(j, 3) / pcr_rows(j, 1);
+      xn[j] = pcr_rows(j, 4 + 3) / pcr_rows(j, 4 + 1);
+    }
+  }
+
+  /// Is the diagonal coefficient of \p row = (a, b, c, ...) too small
+  /// to divide by? The test is relative to the size of the row, so it
+  /// doesn't depend on how the equations are scaled. This doesn't
+  /// throw, as it is called inside OpenMP parallel loops: callers
+  /// record the failure and throw after the loop
+  static bool smallPivot(const T* row) {
+    return std::abs(row[1])
+           <= pivot_tolerance * (std::abs(row[0]) + std::abs(row[1]) + std::abs(row[2]));
+  }
+
+  /// One step of parallel cyclic reduction: eliminate the coupling of
+  /// \p row to the rows \p prev and \p next, putting the result in
+  /// \p result. Rows are (a, b, c, r), and \p prev or \p next are
+  /// nullptr if outside the domain, in which case the corresponding
+  /// coefficient of \p row is zero. Returns false if a pivot is too
+  /// small, in which case \p result is not usable
+  static bool pcrEliminate(const T* row, const T* prev, const T* next, T* result) {
+    T alpha = 0.0;
+    T gamma = 0.0;
+    result[0] = 0.0;
+    result[2] = 0.0;
+    if (prev != nullptr) {
+      if (smallPivot(prev)) {
+        return false;
+      }
+      alpha = row[0] / prev[1];
+      result[0] = -alpha * prev[0];
+    }
+    if (next != nullptr) {
+      if (smallPivot(next)) {
+        return false;
+      }
+      gamma = row[2] / next[1];
+      result[2] = -gamma * next[2];
+    }
+    result[1] = row[1];
+    result[3] = row[3];
+    if (prev != nullptr) {
+      result[1] -= alpha * prev[2];
+      result[3] -= alpha * prev[3];
+    }
+    if (next != nullptr) {
+      result[1] -= gamma * next[0];
+      result[3] -= gamma * next[3];
+    }
+    return true;
+  }
 
   /// Allocate memory arrays
   /// @param[in] np   Number of processors
@@ -520,6 +733,124 @@ private:
 
     x1.reallocate(Nsys);
     xn.reallocate(Nsys);
+
+    // Up to one send and receive to each side in PCR
+    requests.resize(std::max(nprocs, 4));
+    if (nprocs > 1) {
+      pcr_rows.reallocate(Nsys, 8);
+      pcr_left.reallocate(Nsys, 8);
+      pcr_right.reallocate(Nsys, 8);
+    }
+
+    upper_beta.reallocate(Nsys, N);
+    lower_alpha.reallocate(Nsys, N);
+    thomas_bet.reallocate(Nsys, N);
+    thomas_gam.reallocate(Nsys, N);
+    factorised = false;
+  }
+
+  /// Eliminate the local rows of the coefficients, as in `reduce`,
+  /// storing the interface coefficients in myif and the multipliers
+  /// so that `reduceRHS` and `back_solve_factorised` only need to
+  /// operate on the right hand side
+  void factorise() {
+    myif.ensureUnique();
+    upper_beta.ensureUnique();
+    lower_alpha.ensureUnique();
+    thomas_bet.ensureUnique();
+    thomas_gam.ensureUnique();
+
+    // Set if any system had a zero pivot, which is thrown after the loop
+    int failed = 0;
+
+    BOUT_OMP(parallel for reduction(max:failed))
+    for (int j = 0; j < Nsys; j++) {
+      // Upper interface equation
+      for (int i = 0; i < 3; i++) {
+        myif(j, i) = coefs(j, 4 * (N - 2) + i);
+      }
+      for (int i = N - 3; i >= 0; i--) {
+        if (smallPivot(&myif(j, 0))) {
+          failed = 1;
+          break;
+        }
+        const T beta = coefs(j, 4 * i + 2) / myif(j, 1);
+        upper_beta(j, i) = beta;
+        myif(j, 1) = coefs(j, 4 * i + 1) - beta * myif(j, 0);
+        myif(j, 0) = coefs(j, 4 * i);
+        myif(j, 2) *= -beta;
+      }
+
+      // Lower interface equation
+      for (int i = 0; i < 3; i++) {
+        myif(j, 4 + i) = coefs(j, 4 + i);
+      }
+      for (int i = 2; i < N; i++) {
+        if (smallPivot(&myif(j, 4))) {
+          failed = 1;
+          break;
+        }
+        const T alpha = coefs(j, 4 * i) / myif(j, 4 + 1);
+        lower_alpha(j, i) = alpha;
+        myif(j, 4 + 0) *= -alpha;
+        myif(j, 4 + 1) = coefs(j, 4 * i + 1) - alpha * myif(j, 4 + 2);
+        myif(j, 4 + 2) = coefs(j, 4 * i + 2);
+      }
+
+      // Thomas algorithm for the rows between the interfaces
+      thomas_gam(j, 1) = 0.;
+      for (int i = 1; i < N - 1; i++) {
+        const T bet = coefs(j, 4 * i + 1) - coefs(j, 4 * i) * thomas_gam(j, i);
+        thomas_bet(j, i) = bet;
+        thomas_gam(j, i + 1) = coefs(j, 4 * i + 2) / bet;
+      }
+    }
+
+    if (failed != 0) {
+      throw BoutException("Zero pivot in CyclicReduce::factorise");
+    }
+    factorised = true;
+  }
+
+  /// Calculate the right hand side of the interface equations in
+  /// myif, using the multipliers from `factorise`
+  void reduceRHS() {
+    myif.ensureUnique();
+
+    BOUT_OMP(parallel for)
+    for (int j = 0; j < Nsys; j++) {
+      T upper = coefs(j, 4 * (N - 2) + 3);
+      for (int i = N - 3; i >= 0; i--) {
+        upper = coefs(j, 4 * i + 3) - upper_beta(j, i) * upper;
+      }
+      myif(j, 3) = upper;
+
+      T lower = coefs(j, 4 + 3);
+      for (int i = 2; i < N; i++) {
+        lower = coefs(j, 4 * i + 3) - lower_alpha(j, i) * lower;
+      }
+      myif(j, 4 + 3) = lower;
+    }
+  }
+
+  /// Back-solve the local equations from x at the ends (x1, xn),
+  /// using the pivots from `factorise`
+  void back_solve_factorised(Matrix<T>& xa) {
+    xa.ensureUnique();
+
+    BOUT_OMP(parallel for)
+    for (int i = 0; i < Nsys; i++) {
+      xa(i, 0) = x1[i];
+      for (int j = 1; j < N - 1; j++) {
+        xa(i, j) =
+            (coefs(i, 4 * j + 3) - coefs(i, 4 * j) * xa(i, j - 1)) / thomas_bet(i, j);
+      }
+      xa(i, N - 1) = xn[i];
+
+      for (int j = N - 2; j > 0; j--) {
+        xa(i, j) = xa(i, j) - thomas_gam(i, j + 1) * xa(i, j + 1);
+      }
+    }
   }
 
   /// Calculate interface equations
@@ -540,7 +871,10 @@ private:
     }
 #endif
 
-    BOUT_OMP(parallel for)
+    // Set if any system had a zero pivot, which is thrown after the loop
+    int failed = 0;
+
+    BOUT_OMP(parallel for reduction(max:failed))
     for (int j = 0; j < ns; j++) {
       // Calculate upper interface equation
 
@@ -552,8 +886,9 @@ private:
 
       for (int i = nloc - 3; i >= 0; i--) {
         // Check for zero pivot
-        if (std::abs(ifc(j, 1)) < 1e-10) {
-          throw BoutException("Zero pivot in CyclicReduce::reduce");
+        if (smallPivot(&ifc(j, 0))) {
+          failed = 1;
+          break;
         }
 
         // beta <- v_{i,i+1} / v_u,i
@@ -580,8 +915,9 @@ private:
 
       for (int i = 2; i < nloc; i++) {
 
-        if (std::abs(ifc(j, 4 + 1)) < 1e-10) {
-          throw BoutException("Zero pivot in CyclicReduce::reduce");
+        if (smallPivot(&ifc(j, 4))) {
+          failed = 1;
+          break;
         }
 
         // alpha <- v_{i,i-1} / v_l,i-1
@@ -605,6 +941,10 @@ private:
 #endif
     }
 
+    if (failed != 0) {
+      throw BoutException("Zero pivot in CyclicReduce::reduce");
+    }
+
     // Lower system couples {0, N-1, N}
     // Upper system couples {-1. 0, N-1}
   }
@@ -29,6 +29,7 @@
 #ifndef __DERIV_STORE_HXX__
 #define __DERIV_STORE_HXX__
 
+#include <array>
 #include <functional>
 #include <map>
 #include <set>
@@ -48,6 +49,12 @@
 /// a DIRECTION (e.g. DIRECTION::X) and a STAGGER (e.g. STAGGER::None). There is
 /// one routine for each class of derivative (standard, standard2nd, standard4th,
 /// upwind and flux).
+///
+/// Looking up a method by name hashes the name, direction and stagger
+/// on every call. To avoid this for the common case of DIFF_DEFAULT, the
+/// default methods are bound once into a flat table of function pointers
+/// (`bindDefaultMethods`, called by `initialise`), which is indexed
+/// directly by the derivative type, direction and stagger.
 template <typename FieldType>
 struct DerivativeStore {
   using standardFunc =
@@ -56,6 +63,11 @@ struct DerivativeStore {
                                       const std::string&)>;
   using upwindFunc = flowFunc;
   using fluxFunc = flowFunc;
+  /// The registered kernels are plain functions, which the default
+  /// methods are bound to
+  using standardFuncPointer = void (*)(const FieldType&, FieldType&, const std::string&);
+  using flowFuncPointer = void (*)(const FieldType&, const FieldType&, FieldType&,
+                                   const std::string&);
 
 #ifdef USE_ORDERED_MAP_FOR_DERIVATIVE_STORE
   template <typename K, typename V>
@@ -170,6 +182,9 @@ struct DerivativeStore {
 
     // Register this method name in lookup of known methods
     registeredMethods[getKey(direction, stagger, toString(derivType))].insert(methodName);
+
+    // This may be the default method, which can now be bound
+    bindDefaultMethod(derivType, direction, stagger);
   };
 
   /// Register a function with upwindFunc/fluxFunc interface. Which map is used
@@ -204,6 +219,9 @@ struct DerivativeStore {
 
     // Register this method name in lookup of known methods
     registeredMethods[getKey(direction, stagger, toString(derivType))].insert(methodName);
+
+    // This may be the default method, which can now be bound
+    bindDefaultMethod(derivType, direction, stagger);
   };
 
   /// Templated versions of the above registration routines.
@@ -230,21 +248,33 @@ struct DerivativeStore {
   standardFunc getStandardDerivative(std::string name, DIRECTION direction,
                                      STAGGER stagger = STAGGER::None,
                                      DERIV derivType = DERIV::Standard) const {
-
     AUTO_TRACE();
+    return findStandardDerivative(name, direction, stagger, derivType);
+  };
+
+  /// If \p name selects the default method and it has been bound,
+  /// the function to call, otherwise nullptr
+  standardFuncPointer findDefaultStandardDerivative(
+      const std::string& name, DIRECTION direction, STAGGER stagger = STAGGER::None,
+      DERIV derivType = DERIV::Standard) const {
+    if (name != defaultName) {
+      return nullptr;
+    }
+    return defaultStandard[getIndex(derivType, direction, stagger)];
+  }
+
+  /// As getStandardDerivative, but returns a reference to the stored
+  /// function rather than a copy
+  const standardFunc& findStandardDerivative(const std::string& name,
+                                             DIRECTION direction,
+                                             STAGGER stagger = STAGGER::None,
+                                             DERIV derivType = DERIV::Standard) const {
     const auto realName = nameLookup(
         name, defaultMethods.at(getKey(direction, stagger, toString(derivType))));
     const auto key = getKey(direction, stagger, realName);
 
-    const storageType<std::size_t, standardFunc>* theMap = nullptr;
-
-    if (derivType == DERIV::Standard) {
-      theMap = &standard;
-    } else if (derivType == DERIV::StandardSecond) {
-      theMap = &standardSecond;
-    } else if (derivType == DERIV::StandardFourth) {
-      theMap = &standardFourth;
-    } else {
+    const auto* theMap = getStandardMap(derivType);
+    if (theMap == nullptr) {
       throw BoutException("getStandardDerivative only works for derivType in {{Standard, "
                           "StandardSecond, StandardFourth}} but receieved {:s}",
                           toString(derivType));
@@ -276,17 +306,32 @@ struct DerivativeStore {
                              STAGGER stagger = STAGGER::None,
                              DERIV derivType = DERIV::Upwind) const {
     AUTO_TRACE();
+    return findFlowDerivative(name, direction, stagger, derivType);
+  }
+
+  /// If \p name selects the default method and it has been bound,
+  /// the function to call, otherwise nullptr
+  flowFuncPointer findDefaultFlowDerivative(const std::string& name,
+                                            DIRECTION direction,
+                                            STAGGER stagger = STAGGER::None,
+                                            DERIV derivType = DERIV::Upwind) const {
+    if (name != defaultName) {
+      return nullptr;
+    }
+    return defaultFlow[getIndex(derivType, direction, stagger)];
+  }
+
+  /// As getFlowDerivative, but returns a reference to the stored
+  /// function rather than a copy
+  const flowFunc& findFlowDerivative(const std::string& name, DIRECTION direction,
+                                     STAGGER stagger = STAGGER::None,
+                                     DERIV derivType = DERIV::Upwind) const {
     const auto realName = nameLookup(
         name, defaultMethods.at(getKey(direction, stagger, toString(derivType))));
     const auto key = getKey(direction, stagger, realName);
 
-    const storageType<std::size_t, flowFunc>* theMap = nullptr;
-
-    if (derivType == DERIV::Upwind) {
-      theMap = &upwind;
-    } else if (derivType == DERIV::Flux) {
-      theMap = &flux;
-    } else {
+    const auto* theMap = getFlowMap(derivType);
+    if (theMap == nullptr) {
       throw BoutException(
           "getFlowDerivative only works for derivType in {{Upwind, Flux}} "
           "but received {:s}",
@@ -366,8 +411,7 @@ struct DerivativeStore {
 
         // Now we have the default method we should store it in defaultMethods
         theDefault = uppercase(theDefault);
-        defaultMethods[getKey(theDirection, STAGGER::None, theDerivTypeString)] =
-            theDefault;
+        setDefaultMethod(theDefault, theDerivType, theDirection, STAGGER::None);
         output_verbose << "The default method for derivative type " << theDerivTypeString
                        << " in direction " << toString(theDirection) << " is "
                        << theDefault << "\n";
@@ -388,15 +432,52 @@ struct DerivativeStore {
 
         // Now we have the default method we should store it in defaultMethods
         theDefault = uppercase(theDefault);
-        defaultMethods[getKey(theDirection, STAGGER::L2C, theDerivTypeString)] =
-            theDefault;
-        defaultMethods[getKey(theDirection, STAGGER::C2L, theDerivTypeString)] =
-            theDefault;
+        setDefaultMethod(theDefault, theDerivType, theDirection, STAGGER::L2C);
+        setDefaultMethod(theDefault, theDerivType, theDirection, STAGGER::C2L);
         output_verbose << "The default method for staggered derivative type "
                        << theDerivTypeString << " in direction " << toString(theDirection)
                        << " is " << theDefault << "\n";
       }
     }
+
+    bindDefaultMethods();
+  }
+
+  /// Bind the current default methods into the dispatch table used
+  /// for DIFF_DEFAULT. Defaults which haven't been registered, or
+  /// which aren't plain functions, are left unbound, and are looked up
+  /// by name as before
+  void bindDefaultMethods() {
+    AUTO_TRACE();
+    for (const auto direction : {DIRECTION::X, DIRECTION::Y, DIRECTION::YOrthogonal,
+                                 DIRECTION::Z}) {
+      for (const auto stagger : {STAGGER::None, STAGGER::C2L, STAGGER::L2C}) {
+        for (const auto derivType :
+             {DERIV::Standard, DERIV::StandardSecond, DERIV::StandardFourth,
+              DERIV::Upwind, DERIV::Flux}) {
+          bindDefaultMethod(derivType, direction, stagger);
+        }
+      }
+    }
+  }
+
+  /// Fix the default method, so that it can't be changed by the
+  /// input file, and bind it into the dispatch table
+  void fixDefaultMethod(const std::string& methodName, DERIV deriv, DIRECTION direction,
+                        STAGGER stagger = STAGGER::None) {
+    forceDefaultMethod(methodName, deriv, direction, stagger);
+    fixedDefaults[getIndex(deriv, direction, stagger)] = uppercase(methodName);
+  }
+
+  /// Allow the defaults fixed with fixDefaultMethod to be changed
+  /// again. Only intended for testing
+  void releaseDefaultMethods() { fixedDefaults.fill(""); }
+
+  /// The name of the default method
+  std::string getDefaultMethod(DERIV deriv, DIRECTION direction,
+                               STAGGER stagger = STAGGER::None) const {
+    const auto method = defaultMethods.find(getKey(direction, stagger, toString(deriv)));
+    return method == defaultMethods.end() ? "" : method->second;
   }
 
   /// Provide a method to override/force a specific default method
@@ -404,9 +485,11 @@ struct DerivativeStore {
                           STAGGER stagger = STAGGER::None) {
     const auto key = getKey(direction, stagger, toString(deriv));
     defaultMethods[key] = uppercase(methodName);
+    bindDefaultMethod(deriv, direction, stagger);
   }
 
-  /// Empty all member storage
+  /// Empty all member storage, except for the default methods fixed
+  /// with fixDefaultMethod, which are kept
   void clear() {
     defaultMethods.clear();
     standard.clear();
@@ -415,6 +498,9 @@ struct DerivativeStore {
     upwind.clear();
     flux.clear();
     registeredMethods.clear();
+    defaultStandard.fill(nullptr);
+    defaultFlow.fill(nullptr);
+    restoreFixedDefaults();
   }
 
   /// Reset to initial state
@@ -422,6 +508,7 @@ struct DerivativeStore {
     clear();
 
     setDefaults();
+    restoreFixedDefaults();
   }
 
 private:
@@ -449,6 +536,115 @@ private:
   /// it might be useful to relax this assumption!
   storageType<std::size_t, std::string> defaultMethods;
 
+  /// Name which selects the default method
+  const std::string defaultName{toString(DIFF_DEFAULT)};
+
+  /// Number of entries in the dispatch tables, one for each
+  /// combination of DERIV, DIRECTION and STAGGER
+  static constexpr std::size_t tableSize = 5 * 5 * 3;
+
+  /// Dispatch tables for DIFF_DEFAULT, holding the functions wrapped
+  /// by the maps above, indexed by getIndex. Entries for the wrong kind
+  /// of derivative, or defaults which haven't been bound, are nullptr
+  std::array<standardFuncPointer, tableSize> defaultStandard{};
+  std::array<flowFuncPointer, tableSize> defaultFlow{};
+  /// Defaults which have been fixed with fixDefaultMethod, or empty
+  /// if not fixed
+  std::array<std::string, tableSize> fixedDefaults{};
+
+  static std::size_t getIndex(DERIV derivType, DIRECTION direction, STAGGER stagger) {
+    return (static_cast<std::size_t>(derivType) * 5
+            + static_cast<std::size_t>(direction))
+               * 3
+           + static_cast<std::size_t>(stagger);
+  }
+
+  const storageType<std::size_t, standardFunc>* getStandardMap(DERIV derivType) const {
+    switch (derivType) {
+    case DERIV::Standard:
+      return &standard;
+    case DERIV::StandardSecond:
+      return &standardSecond;
+    case DERIV::StandardFourth:
+      return &standardFourth;
+    default:
+      return nullptr;
+    }
+  }
+
+  const storageType<std::size_t, flowFunc>* getFlowMap(DERIV derivType) const {
+    switch (derivType) {
+    case DERIV::Upwind:
+      return &upwind;
+    case DERIV::Flux:
+      return &flux;
+    default:
+      return nullptr;
+    }
+  }
+
+  /// Set the default method, unless it has been fixed to a different one
+  void setDefaultMethod(const std::string& methodName, DERIV deriv, DIRECTION direction,
+                        STAGGER stagger) {
+    const auto key = getKey(direction, stagger, toString(deriv));
+    const auto& fixed = fixedDefaults[getIndex(deriv, direction, stagger)];
+    if (not fixed.empty() and fixed != methodName) {
+      throw BoutException(
+          "Default {:s} derivative method {:s} can't be changed to {:s}: BOUT++ was "
+          "built with BOUT_ENABLE_STATIC_DERIVATIVE_DEFAULTS",
+          toString(deriv), getMethodName(fixed, direction, stagger), methodName);
+    }
+    defaultMethods[key] = methodName;
+  }
+
+  /// Put the defaults fixed with fixDefaultMethod back into
+  /// defaultMethods. They are bound when their methods are registered
+  void restoreFixedDefaults() {
+    for (const auto direction : {DIRECTION::X, DIRECTION::Y, DIRECTION::YOrthogonal,
+                                 DIRECTION::Z}) {
+      for (const auto stagger : {STAGGER::None, STAGGER::C2L, STAGGER::L2C}) {
+        for (const auto derivType :
+             {DERIV::Standard, DERIV::StandardSecond, DERIV::StandardFourth,
+              DERIV::Upwind, DERIV::Flux}) {
+          const auto& fixed = fixedDefaults[getIndex(derivType, direction, stagger)];
+          if (not fixed.empty()) {
+            defaultMethods[getKey(direction, stagger, toString(derivType))] = fixed;
+          }
+        }
+      }
+    }
+  }
+
+  /// Set the dispatch table entry to the registered function for the
+  /// current default method, if there is one and it is a plain
+  /// function
+  void bindDefaultMethod(DERIV derivType, DIRECTION direction, STAGGER stagger) {
+    const auto index = getIndex(derivType, direction, stagger);
+    defaultStandard[index] = nullptr;
+    defaultFlow[index] = nullptr;
+
+    const auto defaultMethod =
+        defaultMethods.find(getKey(direction, stagger, toString(derivType)));
+    if (defaultMethod == defaultMethods.end()) {
+      return;
+    }
+    const auto key = getKey(direction, stagger, defaultMethod->second);
+
+    if (const auto* theMap = getStandardMap(derivType)) {
+      const auto func = theMap->find(key);
+      if (func != theMap->end()) {
+        const auto* target = func->second.template target<standardFuncPointer>();
+        defaultStandard[index] = (target != nullptr) ? *target : nullptr;
+      }
+    } else if (const auto* theMap = getFlowMap(derivType)) {
+      const auto func = theMap->find(key);
+      if (func != theMap->end()) {
+        const auto* target = func->second.template target<flowFuncPointer>();
+        defaultFlow[index] = (target != nullptr) ? *target : nullptr;
+      }
+    }
+  }
+
   void setDefaults() {
     std::map<DERIV, std::string> initialDefaultMethods = {{DERIV::Standard, "C2"},
                                                           {DERIV::StandardSecond, "C2"},
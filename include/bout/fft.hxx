@@ -73,6 +73,46 @@ void rfft(const BoutReal* in, int length, dcomplex* out);
  */
 void irfft(const dcomplex* in, int length, BoutReal* out);
 
+/*!
+ * Forward FFT of \p howmany real signals in one call, normalised in
+ * the same way as rfft(const BoutReal*, int, dcomplex*)
+ *
+ * Uses batched FFTW plans, which are created on first use and cached.
+ * Plans are only made for batches of up to 64 signals whose size is a
+ * power of two, so varying \p howmany doesn't keep making new plans.
+ * This is thread safe. If called outside of an OpenMP parallel region,
+ * the transforms are split between the threads
+ *
+ * \param[in] in      The signals, each of \p length points, one
+ *                    after another (e.g. a contiguous set of Z
+ *                    columns of a Field3D or FieldPerp)
+ * \param[in] length  Number of points in each signal
+ * \param[in] howmany Number of signals
+ * \param[out] out    The (length / 2) + 1 modes of each signal,
+ *                    one after another
+ */
+void rfft(const BoutReal* in, int length, int howmany, dcomplex* out);
+
+/*!
+ * Inverse FFT of \p howmany signals in one call, the inverse of
+ * rfft(const BoutReal*, int, int, dcomplex*)
+ *
+ * \param[in] in      The (length / 2) + 1 modes of each signal, one
+ *                    after another
+ * \param[in] length  Number of points in each output signal
+ * \param[in] howmany Number of signals
+ * \param[out] out    The signals, each of \p length points, one after
+ *                    another
+ */
+void irfft(const dcomplex* in, int length, int howmany, BoutReal* out);
+
+/*!
+ * As irfft(const dcomplex*, int, int, BoutReal*), but \p in is used
+ * as working space and its contents are lost. This saves copying the
+ * modes when the caller no longer needs them
+ */
+void irfft_overwrite_input(dcomplex* in, int length, int howmany, BoutReal* out);
+
 /*!
  * Discrete Sine Transform
  *
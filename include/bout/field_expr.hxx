@@ -0,0 +1,415 @@
+/*!*************************************************************************
+ * \file field_expr.hxx
+ *
+ * Lazy evaluation of arithmetic expressions of fields
+ *
+ * The usual field operators (e.g. `Field3D operator*(const Field3D&,
+ * const Field3D&)`) each create a new field and make a pass over
+ * memory, so `a * b + c * d` makes three temporary fields. Wrapping
+ * fields with `lazy` instead builds an expression, which is evaluated
+ * in a single loop when it is assigned to a field:
+ *
+ *     using bout::expr::lazy;
+ *     ddt(n) = lazy(a) * b + lazy(c) * d - lazy(e) / f;
+ *
+ * An operator between an expression and a field, `BoutReal` or another
+ * expression gives a new expression, so one operand of each operator
+ * must be an expression: `lazy(c) * d` above. `c * d` would be
+ * calculated immediately by the usual operator, and then used in the
+ * expression. Field3D, Field2D and BoutReal operands can be mixed; the
+ * result is a Field3D if there are any Field3D operands, and a Field2D
+ * otherwise.
+ *
+ * Assigning an expression evaluates it over RGN_ALL, like the usual
+ * operators; `evaluate(expression, rgn)` evaluates it over region
+ * `rgn` only.
+ *
+ * Expressions hold copies of the fields (which share data with the
+ * originals), so can be stored with `auto` and evaluated later, but
+ * they see any changes made to the original field data in between.
+ *
+ **************************************************************************/
+
+#pragma once
+#ifndef BOUT_FIELD_EXPR_H
+#define BOUT_FIELD_EXPR_H
+
+#include "bout/bout_types.hxx"
+#include "bout/field2d.hxx"
+#include "bout/field3d.hxx"
+#include "bout/mesh.hxx"
+#include "bout/openmpwrap.hxx"
+#include "bout/region.hxx"
+#include "bout/unused.hxx"
+
+#include <cmath>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace bout {
+namespace expr {
+
+/// Base class of all expressions, using CRTP. Each expression
+/// `Derived` provides:
+///
+///  - `static constexpr bool is3D`: true if any operand is a Field3D
+///  - `BoutReal operator()(int i3D, int i2D) const`: the value at the
+///     point with 3D index `i3D`, and 2D index `i2D` of the same X-Y
+///     point
+///  - `forEachField(function)`: call `function` with each field operand
+///  - `field3D()`, `field2D()`: the first Field3D or Field2D operand,
+///     or nullptr if there are none
+///
+/// Expressions convert implicitly to their result type, evaluating
+/// the whole expression in one loop
+template <typename Derived>
+struct FieldExpr {
+  const Derived& self() const { return static_cast<const Derived&>(*this); }
+
+  template <typename T, typename D = Derived,
+            typename = std::enable_if_t<std::is_same<T, typename D::result_type>::value>>
+  operator T() const;
+};
+
+template <typename T>
+using is_expr = std::is_base_of<FieldExpr<T>, T>;
+
+/// A Field3D operand
+class Field3DLeaf : public FieldExpr<Field3DLeaf> {
+public:
+  static constexpr bool is3D = true;
+  using result_type = Field3D;
+
+  explicit Field3DLeaf(const Field3D& f)
+      : field(f), data(f.isAllocated() ? &f(0, 0, 0) : nullptr) {}
+
+  BoutReal operator()(int i3D, int UNUSED(i2D)) const { return data[i3D]; }
+
+  template <typename Function>
+  void forEachField(Function&& function) const {
+    function(field);
+  }
+  const Field3D* field3D() const { return &field; }
+  const Field2D* field2D() const { return nullptr; }
+
+private:
+  Field3D field;
+  const BoutReal* data;
+};
+
+/// A Field2D operand
+class Field2DLeaf : public FieldExpr<Field2DLeaf> {
+public:
+  static constexpr bool is3D = false;
+  using result_type = Field2D;
+
+  explicit Field2DLeaf(const Field2D& f)
+      : field(f), data(f.isAllocated() ? &f(0, 0) : nullptr) {}
+
+  BoutReal operator()(int UNUSED(i3D), int i2D) const { return data[i2D]; }
+
+  template <typename Function>
+  void forEachField(Function&& function) const {
+    function(field);
+  }
+  const Field3D* field3D() const { return nullptr; }
+  const Field2D* field2D() const { return &field; }
+
+private:
+  Field2D field;
+  const BoutReal* data;
+};
+
+/// A BoutReal operand
+class ScalarLeaf : public FieldExpr<ScalarLeaf> {
+public:
+  static constexpr bool is3D = false;
+
+  explicit ScalarLeaf(BoutReal value) : value(value) {}
+
+  BoutReal operator()(int UNUSED(i3D), int UNUSED(i2D)) const { return value; }
+
+  template <typename Function>
+  void forEachField(Function&& UNUSED(function)) const {}
+  const Field3D* field3D() const { return nullptr; }
+  const Field2D* field2D() const { return nullptr; }
+
+private:
+  BoutReal value;
+};
+
+/// Start an expression from a field
+inline Field3DLeaf lazy(const Field3D& f) { return Field3DLeaf{f}; }
+inline Field2DLeaf lazy(const Field2D& f) { return Field2DLeaf{f}; }
+
+/// Convert operands to expressions
+inline Field3DLeaf toExpr(const Field3D& f) { return Field3DLeaf{f}; }
+inline Field2DLeaf toExpr(const Field2D& f) { return Field2DLeaf{f}; }
+inline ScalarLeaf toExpr(BoutReal value) { return ScalarLeaf{value}; }
+template <typename T>
+const T& toExpr(const FieldExpr<T>& e) {
+  return e.self();
+}
+
+template <typename T>
+using ExprOf = std::decay_t<decltype(toExpr(std::declval<const T&>()))>;
+
+namespace details {
+/// Backport of std::void_t
+template <typename...>
+struct make_void {
+  using type = void;
+};
+template <typename... Ts>
+using void_t = typename make_void<Ts...>::type;
+
+/// Backport of std::disjunction
+template <class...>
+struct disjunction : std::false_type {};
+template <class B1>
+struct disjunction<B1> : B1 {};
+template <class B1, class... Bn>
+struct disjunction<B1, Bn...>
+    : std::conditional_t<bool(B1::value), B1, disjunction<Bn...>> {};
+} // namespace details
+
+/// Enable a function if any of the Ts is an expression, and all of
+/// them can be converted to expressions
+template <typename... Ts>
+using EnableIfExpr =
+    std::enable_if_t<details::disjunction<is_expr<std::decay_t<Ts>>...>::value,
+                     details::void_t<ExprOf<std::decay_t<Ts>>...>>;
+
+/// The first non-null pointer
+template <typename T>
+const T* firstOf(const T* a, const T* b) {
+  return a != nullptr ? a : b;
+}
+
+/// An operator applied to two expressions
+template <typename Op, typename Lhs, typename Rhs>
+class BinaryExpr : public FieldExpr<BinaryExpr<Op, Lhs, Rhs>> {
+public:
+  static constexpr bool is3D = Lhs::is3D or Rhs::is3D;
+  using result_type = std::conditional_t<is3D, Field3D, Field2D>;
+
+  BinaryExpr(Lhs lhs, Rhs rhs) : lhs(std::move(lhs)), rhs(std::move(rhs)) {}
+
+  BoutReal operator()(int i3D, int i2D) const {
+    return Op::apply(lhs(i3D, i2D), rhs(i3D, i2D));
+  }
+
+  template <typename Function>
+  void forEachField(Function&& function) const {
+    lhs.forEachField(function);
+    rhs.forEachField(function);
+  }
+  const Field3D* field3D() const { return firstOf(lhs.field3D(), rhs.field3D()); }
+  const Field2D* field2D() const { return firstOf(lhs.field2D(), rhs.field2D()); }
+
+private:
+  Lhs lhs;
+  Rhs rhs;
+};
+
+/// A function applied to one expression
+template <typename Op, typename Arg>
+class UnaryExpr : public FieldExpr<UnaryExpr<Op, Arg>> {
+public:
+  static constexpr bool is3D = Arg::is3D;
+  using result_type = std::conditional_t<is3D, Field3D, Field2D>;
+
+  explicit UnaryExpr(Arg arg) : arg(std::move(arg)) {}
+
+  BoutReal operator()(int i3D, int i2D) const { return Op::apply(arg(i3D, i2D)); }
+
+  template <typename Function>
+  void forEachField(Function&& function) const {
+    arg.forEachField(function);
+  }
+  const Field3D* field3D() const { return arg.field3D(); }
+  const Field2D* field2D() const { return arg.field2D(); }
+
+private:
+  Arg arg;
+};
+
+/// Choose between two expressions, like `::where`
+template <typename Test, typename Gt0, typename Le0>
+class WhereExpr : public FieldExpr<WhereExpr<Test, Gt0, Le0>> {
+public:
+  static constexpr bool is3D = Test::is3D or Gt0::is3D or Le0::is3D;
+  using result_type = std::conditional_t<is3D, Field3D, Field2D>;
+
+  WhereExpr(Test test, Gt0 gt0, Le0 le0)
+      : test(std::move(test)), gt0(std::move(gt0)), le0(std::move(le0)) {}
+
+  BoutReal operator()(int i3D, int i2D) const {
+    return (test(i3D, i2D) > 0.0) ? gt0(i3D, i2D) : le0(i3D, i2D);
+  }
+
+  template <typename Function>
+  void forEachField(Function&& function) const {
+    test.forEachField(function);
+    gt0.forEachField(function);
+    le0.forEachField(function);
+  }
+  const Field3D* field3D() const {
+    return firstOf(test.field3D(), firstOf(gt0.field3D(), le0.field3D()));
+  }
+  const Field2D* field2D() const {
+    return firstOf(test.field2D(), firstOf(gt0.field2D(), le0.field2D()));
+  }
+
+private:
+  Test test;
+  Gt0 gt0;
+  Le0 le0;
+};
+
+namespace details {
+/// The field operand of \p expr which has the same type as the
+/// result, chosen by whether the result is 3D
+template <typename Derived>
+const Field3D* likeField(const Derived& expr, std::true_type UNUSED(is3D)) {
+  return expr.field3D();
+}
+template <typename Derived>
+const Field2D* likeField(const Derived& expr, std::false_type UNUSED(is3D)) {
+  return expr.field2D();
+}
+
+/// Evaluate \p expr into the Field3D \p result over \p rgn
+template <typename Derived>
+void evaluateInto(const Derived& expr, Field3D& result, const std::string& rgn,
+                  std::true_type UNUSED(is3D)) {
+  BoutReal* out = &result(0, 0, 0);
+  Mesh* mesh = result.getMesh();
+  const int nz = mesh->LocalNz;
+  if (rgn == "RGN_ALL") {
+    // Loop over X-Y points, and Z inside, so that Field2D operands
+    // are indexed without a division
+    BOUT_FOR(index, mesh->getRegion2D("RGN_ALL")) {
+      const int i2D = index.ind;
+      const int base = i2D * nz;
+      BOUT_OMP(simd)
+      for (int jz = 0; jz < nz; ++jz) {
+        out[base + jz] = expr(base + jz, i2D);
+      }
+    }
+  } else {
+    BOUT_FOR(index, result.getRegion(rgn)) {
+      out[index.ind] = expr(index.ind, index.ind / nz);
+    }
+  }
+}
+
+/// Evaluate \p expr into the Field2D \p result over \p rgn
+template <typename Derived>
+void evaluateInto(const Derived& expr, Field2D& result, const std::string& rgn,
+                  std::false_type UNUSED(is3D)) {
+  BoutReal* out = &result(0, 0);
+  BOUT_FOR(index, result.getRegion(rgn)) { out[index.ind] = expr(index.ind, index.ind); }
+}
+} // namespace details
+
+/// Evaluate expression \p e over region \p rgn in a single loop. Like
+/// the usual operators and functions, the result is only set in
+/// \p rgn, which is all points by default
+template <typename Derived>
+auto evaluate(const FieldExpr<Derived>& e, const std::string& rgn = "RGN_ALL") ->
+    typename Derived::result_type {
+  using ResultType = typename Derived::result_type;
+  using Is3D = std::integral_constant<bool, Derived::is3D>;
+  const Derived& expr = e.self();
+
+  const ResultType* like = details::likeField(expr, Is3D{});
+  ASSERT0(like != nullptr);
+
+  expr.forEachField([&](const auto& field) {
+    ASSERT1_FIELDS_COMPATIBLE(*like, field);
+    checkData(field);
+  });
+
+  ResultType result{emptyFrom(*like)};
+  details::evaluateInto(expr, result, rgn, Is3D{});
+
+  checkData(result);
+  return result;
+}
+
+template <typename Derived>
+template <typename T, typename D, typename>
+FieldExpr<Derived>::operator T() const {
+  return evaluate(*this);
+}
+
+/// Arithmetic operators
+#define BOUT_EXPR_BINARY_OP(name, op)                                              \
+  struct name {                                                                    \
+    static BoutReal apply(BoutReal a, BoutReal b) { return a op b; }               \
+  };                                                                               \
+  template <typename L, typename R, typename = EnableIfExpr<L, R>>                 \
+  BinaryExpr<name, ExprOf<L>, ExprOf<R>> operator op(const L& lhs, const R& rhs) { \
+    return {toExpr(lhs), toExpr(rhs)};                                             \
+  }
+
+BOUT_EXPR_BINARY_OP(Add, +)
+BOUT_EXPR_BINARY_OP(Subtract, -)
+BOUT_EXPR_BINARY_OP(Multiply, *)
+BOUT_EXPR_BINARY_OP(Divide, /)
+
+#undef BOUT_EXPR_BINARY_OP
+
+/// Function of two arguments
+#define BOUT_EXPR_BINARY_FUNC(name, func, expression)                     \
+  struct name {                                                           \
+    static BoutReal apply(BoutReal a, BoutReal b) { return expression; }  \
+  };                                                                      \
+  template <typename L, typename R, typename = EnableIfExpr<L, R>>        \
+  BinaryExpr<name, ExprOf<L>, ExprOf<R>> func(const L& lhs, const R& rhs) { \
+    return {toExpr(lhs), toExpr(rhs)};                                    \
+  }
+
+BOUT_EXPR_BINARY_FUNC(Power, pow, std::pow(a, b))
+
+#undef BOUT_EXPR_BINARY_FUNC
+
+/// Functions of one argument
+#define BOUT_EXPR_UNARY_FUNC(name, func, expression)                       \
+  struct name {                                                            \
+    static BoutReal apply(BoutReal a) { return expression; }               \
+  };                                                                       \
+  template <typename T, typename = std::enable_if_t<is_expr<T>::value>>    \
+  UnaryExpr<name, T> func(const FieldExpr<T>& arg) {                       \
+    return UnaryExpr<name, T>{arg.self()};                                 \
+  }
+
+BOUT_EXPR_UNARY_FUNC(Negate, operator-, -a)
+BOUT_EXPR_UNARY_FUNC(SquareRoot, sqrt, std::sqrt(a))
+BOUT_EXPR_UNARY_FUNC(Absolute, abs, std::abs(a))
+BOUT_EXPR_UNARY_FUNC(Exponential, exp, std::exp(a))
+BOUT_EXPR_UNARY_FUNC(Logarithm, log, std::log(a))
+BOUT_EXPR_UNARY_FUNC(Sine, sin, std::sin(a))
+BOUT_EXPR_UNARY_FUNC(Cosine, cos, std::cos(a))
+BOUT_EXPR_UNARY_FUNC(Tangent, tan, std::tan(a))
+BOUT_EXPR_UNARY_FUNC(HyperbolicSine, sinh, std::sinh(a))
+BOUT_EXPR_UNARY_FUNC(HyperbolicCosine, cosh, std::cosh(a))
+BOUT_EXPR_UNARY_FUNC(HyperbolicTangent, tanh, std::tanh(a))
+
+#undef BOUT_EXPR_UNARY_FUNC
+
+/// For each point, choose \p gt0 if \p test > 0, otherwise \p le0.
+/// Any of the arguments can be expressions, fields or BoutReals, as
+/// long as at least one is an expression
+template <typename T, typename U, typename V, typename = EnableIfExpr<T, U, V>>
+WhereExpr<ExprOf<T>, ExprOf<U>, ExprOf<V>> where(const T& test, const U& gt0,
+                                                 const V& le0) {
+  return {toExpr(test), toExpr(gt0), toExpr(le0)};
+}
+
+} // namespace expr
+} // namespace bout
+
+#endif // BOUT_FIELD_EXPR_H
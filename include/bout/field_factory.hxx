@@ -115,6 +115,13 @@ private:
   /// Should we transform input from field-aligned coordinates (if possible)?
   bool transform_from_field_aligned{true};
 
+  /// Evaluate 3D fields with a compiled bout::generator::Program?
+  bool compile_expressions{true};
+
+  /// Evaluate \p gen into \p result one z column at a time
+  void evaluateColumns(FieldGeneratorPtr gen, Field3D& result, CELL_LOC loc,
+                       BoutReal t) const;
+
   int max_recursion_depth{0};
 
   /// The default options used in resolve(), can be *temporarily*
@@ -155,6 +162,9 @@ class FieldNull : public FieldGenerator {
 public:
   FieldNull() = default;
   BoutReal generate(const bout::generator::Context&) override { return 0.0; }
+  int compile(bout::generator::Program& program) override {
+    return program.addConstant(0.0);
+  }
   FieldGeneratorPtr clone(const std::list<FieldGeneratorPtr> UNUSED(args)) override {
     return get();
   }
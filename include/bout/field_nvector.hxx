@@ -0,0 +1,55 @@
+// A SUNDIALS N_Vector which holds its data in BOUT++ fields
+//
+// This lets the SUNDIALS solvers work directly on the evolving
+// variables, without copying them into and out of a contiguous array
+// on every function evaluation. Only the evolving points of each
+// field (see `SolverFields::Regions`) are part of the vector; the
+// guard cells are ignored by all the vector operations.
+//
+// The vector has no array pointer, so it can't be used with parts of
+// SUNDIALS which need one, such as the band-block-diagonal (BBD)
+// preconditioner.
+//
+// SPDX-License-Identifier: LGPLv3
+
+#ifndef BOUT_FIELD_NVECTOR_H
+#define BOUT_FIELD_NVECTOR_H
+
+#include "bout/build_defines.hxx"
+
+#if BOUT_HAS_SUNDIALS
+
+#include "bout/solver.hxx"
+#include "bout/sundials_backports.hxx"
+
+#include <mpi.h>
+
+namespace bout {
+
+/// Create a vector with the data in \p fields, which must all be
+/// allocated. The vector takes ownership of \p fields
+N_Vector createFieldNVector(SolverFields fields, MPI_Comm comm, sundials::Context& ctx);
+
+/// Is \p v a vector created by `createFieldNVector`?
+bool isFieldNVector(N_Vector v);
+
+/// The fields holding the data of \p v, which must have been created
+/// by `createFieldNVector`
+SolverFields& getFieldNVectorFields(N_Vector v);
+
+/// Call \p function with either the fields of \p v, if it was created
+/// by `createFieldNVector`, or else its array pointer. Used to pass
+/// vectors to the `Solver::load_vars` etc. overloads
+template <typename Function>
+decltype(auto) visitNVector(N_Vector v, Function&& function) {
+  if (isFieldNVector(v)) {
+    return function(getFieldNVectorFields(v));
+  }
+  return function(N_VGetArrayPointer(v));
+}
+
+} // namespace bout
+
+#endif // BOUT_HAS_SUNDIALS
+
+#endif // BOUT_FIELD_NVECTOR_H
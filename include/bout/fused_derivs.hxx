@@ -0,0 +1,104 @@
+#pragma once
+#ifndef BOUT_FUSED_DERIVS_H
+#define BOUT_FUSED_DERIVS_H
+
+#include "bout/bout_types.hxx"
+#include "bout/coordinates.hxx"
+#include "bout/field3d.hxx"
+#include "bout/region.hxx"
+#include "bout/stencils.hxx"
+
+#include <string>
+
+namespace bout {
+namespace derivatives {
+namespace fused {
+
+/// First and second derivatives in X and Z of a field at one point
+struct XZDerivatives {
+  BoutReal ddx;    ///< DDX(f)
+  BoutReal ddz;    ///< DDZ(f)
+  BoutReal d2dx2;  ///< D2DX2(f)
+  BoutReal d2dz2;  ///< D2DZ2(f)
+  BoutReal d2dxdz; ///< D2DXDZ(f)
+};
+
+/// Can the X and Z derivatives of \p f at \p outloc be calculated by
+/// `forEachXZ`, giving the same result as DDX, DDZ, D2DX2, D2DZ2 and
+/// D2DXDZ with the default methods? This needs the default first and
+/// second derivative methods in X and Z to be "C2", no staggering,
+/// no BOUT-06 style integrated shear, and Z not split between
+/// processors, so that neighbours in Z wrap around
+bool canFuseXZ(const Field3D& f, CELL_LOC outloc = CELL_DEFAULT);
+
+/// Calculate all the X and Z derivatives of \p f in one pass over
+/// \p region, using second order central differences, and call
+/// `function(i, derivs)` at each point with the `XZDerivatives`. The
+/// function can combine the derivatives with metric coefficients, or
+/// store them, without making a pass over a temporary field for each
+/// derivative. Derivatives which aren't used are optimised out.
+///
+/// Only valid if `canFuseXZ(f)` is true. Calls to \p function are
+/// made in parallel
+template <typename Function>
+void forEachXZ(const Field3D& f, const std::string& region, Function&& function) {
+  checkData(f);
+
+  Coordinates* coords = f.getCoordinates();
+  const auto& dx = coords->dx;
+  const auto& dz = coords->dz;
+  const auto& d1_dx = coords->d1_dx;
+  const bool non_uniform = coords->non_uniform;
+
+  BOUT_FOR(i, f.getRegion(region)) {
+    const auto sx = populateStencil<DIRECTION::X, STAGGER::None, 1>(f, i);
+    const auto sz = populateStencil<DIRECTION::Z, STAGGER::None, 1>(f, i);
+
+    // Same order of operations as the separate derivatives, so the
+    // results match
+    const BoutReal ddx_index = 0.5 * (sx.p - sx.m);
+    XZDerivatives derivs;
+    derivs.ddx = ddx_index / dx[i];
+    derivs.ddz = 0.5 * (sz.p - sz.m) / dz[i];
+    derivs.d2dx2 = (sx.p + sx.m - 2. * sx.c) / SQ(dx[i]);
+    if (non_uniform) {
+      derivs.d2dx2 += d1_dx[i] * ddx_index / dx[i];
+    }
+    derivs.d2dz2 = (sz.p + sz.m - 2. * sz.c) / SQ(dz[i]);
+
+    // DDZ(DDX(f)), from DDX at the neighbouring points in Z
+    const auto izp = i.zp();
+    const auto izm = i.zm();
+    const BoutReal ddx_zp = 0.5 * (f[izp.xp()] - f[izp.xm()]) / dx[izp];
+    const BoutReal ddx_zm = 0.5 * (f[izm.xp()] - f[izm.xm()]) / dx[izm];
+    derivs.d2dxdz = 0.5 * (ddx_zp - ddx_zm) / dz[i];
+
+    function(i, derivs);
+  }
+}
+
+/// Can `simpleBracket(f, g)` be used for `bracket(f, g,
+/// BRACKET_SIMPLE, outloc)`? As well as `canFuseXZ(f, outloc)`, this
+/// needs \p g at the same location as \p f, and the default upwind
+/// methods in X and Z to be "U1"
+bool canFuseSimpleBracket(const Field3D& f, const Field3D& g,
+                          CELL_LOC outloc = CELL_DEFAULT);
+
+/// `bracket(f, g, BRACKET_SIMPLE)`, which is `VDDX(DDZ(f), g) +
+/// VDDZ(-DDX(f), g)`, in one pass over \p region. The velocities are
+/// used as they are calculated, rather than stored in temporary
+/// fields. Only valid if `canFuseSimpleBracket(f, g)` is true
+Field3D simpleBracket(const Field3D& f, const Field3D& g,
+                      const std::string& region = "RGN_NOBNDRY");
+
+/// Calculate any of the X and Z derivatives of \p f in one pass,
+/// storing them in the given fields. Outputs which are nullptr are
+/// not calculated. Only valid if `canFuseXZ(f)` is true
+void XZ(const Field3D& f, Field3D* ddx, Field3D* ddz, Field3D* d2dx2, Field3D* d2dz2,
+        Field3D* d2dxdz, const std::string& region = "RGN_NOBNDRY");
+
+} // namespace fused
+} // namespace derivatives
+} // namespace bout
+
+#endif // BOUT_FUSED_DERIVS_H
@@ -9,6 +9,9 @@
 #include <bout/region.hxx>
 #include <bout/traits.hxx>
 
+#include <algorithm>
+#include <vector>
+
 template <class T>
 class GlobalIndexer;
 
@@ -155,6 +158,18 @@ public:
     return numOffDiagonal;
   }
 
+  /// The global column indices of the non-zero elements in each local
+  /// row of a matrix using this indexer's stencil, sorted within each
+  /// row. Rows are numbered from the start of this processor's range,
+  /// as for getNumDiagonal().
+  const std::vector<std::vector<int>>& getSparsityPattern() const {
+    ASSERT2(sparsityPatternAvailable());
+    if (!patternCalculated) {
+      calculatePattern();
+    }
+    return pattern;
+  }
+
   int size() const { return regionAll.size(); }
 
 protected:
@@ -202,6 +217,29 @@ private:
     sparsityCalculated = true;
   }
 
+  void calculatePattern() const {
+    pattern = std::vector<std::vector<int>>(size());
+    const int npoints = indices.getRegion("RGN_ALL").size();
+
+    BOUT_FOR_SERIAL(i, regionAll) {
+      auto& columns = pattern[getGlobal(i) - globalStart];
+      for (const IndexOffset<ind_type>& offset : stencils.getStencilPart(i)) {
+        const ind_type j = i + offset;
+        if (j.ind < 0 || j.ind >= npoints) {
+          continue;
+        }
+        const int column = getGlobal(j);
+        if (column >= 0) {
+          columns.push_back(column);
+        }
+      }
+      std::sort(columns.begin(), columns.end());
+      columns.erase(std::unique(columns.begin(), columns.end()), columns.end());
+    }
+
+    patternCalculated = true;
+  }
+
   Mesh* fieldmesh;
 
   /// Fields containing the indices for each element (as reals)
@@ -219,6 +257,8 @@ private:
 
   mutable bool sparsityCalculated = false;
   mutable std::vector<int> numDiagonal, numOffDiagonal;
+  mutable bool patternCalculated = false;
+  mutable std::vector<std::vector<int>> pattern;
 };
 
 #endif // BOUT_GLOBALINDEXER_H
@@ -31,10 +31,15 @@ class GridDataSource;
 #include "mesh.hxx"
 #include "bout/bout_types.hxx"
 #include "bout/options.hxx"
+#include "bout/options_netcdf.hxx"
 
 #include <bout/field2d.hxx>
 #include <bout/field3d.hxx>
 
+#include <map>
+#include <string>
+#include <vector>
+
 /// Interface class to serve grid data
 /*!
  * Provides a generic interface for sources of
@@ -90,6 +95,10 @@ public:
 /*!
  * This is a thin wrapper around a DataFormat object. Only needs to implement
  * reading routines.
+ *
+ * Scalars, strings and 1D arrays are read when the file is opened.
+ * 2D and 3D variables are read when they are requested, and only the
+ * part of them on this processor is read.
  */
 class GridFile : public GridDataSource {
 public:
@@ -126,8 +135,16 @@ public:
   /// Are y-boundary guard cells read from the source?
   bool hasYBoundaryGuards() override { return grid_yguards > 0; }
 
+  /// Global shape of variable \p name, or empty if it isn't in the file
+  std::vector<int> getShape(const std::string& name);
+
 private:
+  /// Values of the scalars, strings and 1D arrays in the file, and
+  /// the attributes of all variables
   Options data;
+  /// Global shapes of the variables which are read in parts when needed
+  std::map<std::string, std::vector<int>> slab_shapes;
+  bout::OptionsNetCDF file;
   std::string filename;
   int grid_yguards{0};
   int ny_inner{0};
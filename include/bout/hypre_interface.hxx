@@ -20,7 +20,9 @@
 #include "HYPRE_utilities.h"
 #include "_hypre_utilities.h"
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 // BOUT_ENUM_CLASS does not work inside namespaces
 BOUT_ENUM_CLASS(HYPRE_SOLVER_TYPE, gmres, bicgstab, pcg);
@@ -327,6 +329,39 @@ class HypreMatrix {
   std::vector<std::vector<HYPRE_Complex>>* V;
   HypreLib hyprelib{};
 
+  /// Flattened copy of I, J and V passed to HYPRE_IJMatrixSetValues.
+  /// These are kept between calls to assemble(), and the row and
+  /// column arrays are only rebuilt if an element has been added.
+  struct AssemblyArrays {
+    HYPRE_BigInt num_entries{0};
+    HYPRE_BigInt* num_cols{nullptr};
+    HYPRE_BigInt* rawI{nullptr};
+    HYPRE_BigInt* cols{nullptr};
+    HYPRE_Complex* vals{nullptr};
+    bool structure_changed{true};
+    /// The columns were set from the stencil, and can't be added to
+    bool fixed_sparsity{false};
+
+    AssemblyArrays() = default;
+    AssemblyArrays(const AssemblyArrays&) = delete;
+    AssemblyArrays& operator=(const AssemblyArrays&) = delete;
+    ~AssemblyArrays() { release(); }
+
+    void release() {
+      if (num_cols != nullptr) {
+        HypreFree(num_cols);
+        HypreFree(rawI);
+        HypreFree(cols);
+        HypreFree(vals);
+      }
+      num_cols = nullptr;
+      rawI = nullptr;
+      cols = nullptr;
+      vals = nullptr;
+    }
+  };
+  std::shared_ptr<AssemblyArrays> arrays{nullptr};
+
   // todo also take care of I,J,V
   struct MatrixDeleter {
     void operator()(HYPRE_IJMatrix* matrix) const {
@@ -348,7 +383,8 @@ public:
         index_converter(other.index_converter), location(other.location),
         initialised(other.initialised), yoffset(other.yoffset),
         parallel_transform(other.parallel_transform), assembled(other.assembled),
-        num_rows(other.num_rows), I(other.I), J(other.J), V(other.V) {
+        num_rows(other.num_rows), I(other.I), J(other.J), V(other.V),
+        arrays(other.arrays) {
     std::swap(hypre_matrix, other.hypre_matrix);
     std::swap(parallel_matrix, other.parallel_matrix);
   }
@@ -369,15 +405,24 @@ public:
     I = other.I;
     J = other.J;
     V = other.V;
+    arrays = other.arrays;
     return *this;
   }
 
   /// Construct a matrix capable of operating on the specified field,
   /// preallocating memory if requeted and possible.
   ///
+  /// If \p fixedSparsity is true, the rows are filled with the
+  /// sparsity pattern of the indexer's stencil, so that setting
+  /// elements in the stencil never changes the structure of the
+  /// matrix, and repeated calls to assemble() only copy the values.
+  /// Setting an element outside the stencil throws a BoutException.
+  ///
   /// note: preallocate not currently used, but here to match PetscMatrix interface
-  explicit HypreMatrix(IndexerPtr<T> indConverter, bool UNUSED(preallocate) = true)
-      : hypre_matrix(new HYPRE_IJMatrix, MatrixDeleter{}), index_converter(indConverter) {
+  explicit HypreMatrix(IndexerPtr<T> indConverter, bool UNUSED(preallocate) = true,
+                       bool fixedSparsity = false)
+      : hypre_matrix(new HYPRE_IJMatrix, MatrixDeleter{}), index_converter(indConverter),
+        arrays(std::make_shared<AssemblyArrays>()) {
     Mesh* mesh = indConverter->getMesh();
     const MPI_Comm comm =
         std::is_same<T, FieldPerp>::value ? mesh->getXcomm() : BoutComm::get();
@@ -401,6 +446,19 @@ public:
       (*V)[i].reserve(10);
     }
 
+    if (fixedSparsity) {
+      if (!indConverter->sparsityPatternAvailable()) {
+        throw BoutException("HypreMatrix with a fixed sparsity pattern needs an "
+                            "indexer with a stencil");
+      }
+      const auto& pattern = indConverter->getSparsityPattern();
+      for (HYPRE_BigInt i = 0; i < num_rows; ++i) {
+        (*J)[i].assign(pattern[i].begin(), pattern[i].end());
+        (*V)[i].assign(pattern[i].size(), 0.0);
+      }
+      arrays->fixed_sparsity = true;
+    }
+
     checkHypreError(
         HYPRE_IJMatrixCreate(comm, ilower, iupper, ilower, iupper, &*hypre_matrix));
     checkHypreError(HYPRE_IJMatrixSetObjectType(*hypre_matrix, HYPRE_PARCSR));
@@ -521,12 +579,10 @@ public:
     HYPRE_Complex value = 0.0;
     HYPRE_BigInt i = row - ilower;
     ASSERT2(i >= 0 && i < num_rows);
-    const HYPRE_BigInt ncolumns = static_cast<HYPRE_BigInt>((*J)[i].size());
-    for (HYPRE_BigInt col_ind = 0; col_ind < ncolumns; ++col_ind) {
-      if ((*J)[i][col_ind] == column) {
-        value = (*V)[i][col_ind];
-        break;
-      }
+    const auto& columns = (*J)[i];
+    const auto col_ind = std::lower_bound(columns.begin(), columns.end(), column);
+    if (col_ind != columns.end() and *col_ind == column) {
+      value = (*V)[i][std::distance(columns.begin(), col_ind)];
     }
     return static_cast<BoutReal>(value);
   }
@@ -549,20 +605,7 @@ public:
     CALI_CXX_MARK_FUNCTION;
     HYPRE_BigInt i = row - ilower;
     ASSERT2(i >= 0 && i < num_rows);
-    bool value_set = false;
-    const HYPRE_BigInt ncolumns = static_cast<HYPRE_BigInt>((*J)[i].size());
-    for (HYPRE_BigInt col_ind = 0; col_ind < ncolumns; ++col_ind) {
-      if ((*J)[i][col_ind] == column) {
-        (*V)[i][col_ind] = value;
-        value_set = true;
-        break;
-      }
-    }
-
-    if (!value_set) {
-      (*V)[i].push_back(value);
-      (*J)[i].push_back(column);
-    }
+    getEntry(i, column) = value;
   }
 
   void addVal(const ind_type& row, const ind_type& column, BoutReal value) {
@@ -583,20 +626,28 @@ public:
     CALI_CXX_MARK_FUNCTION;
     HYPRE_BigInt i = row - ilower;
     ASSERT2(i >= 0 && i < num_rows);
-    bool value_set = false;
-    const HYPRE_BigInt ncolumns = static_cast<HYPRE_BigInt>((*J)[i].size());
-    for (HYPRE_BigInt col_ind = 0; col_ind < ncolumns; ++col_ind) {
-      if ((*J)[i][col_ind] == column) {
-        (*V)[i][col_ind] += value;
-        value_set = true;
-        break;
+    getEntry(i, column) += value;
+  }
+
+  /// Reference to the stored value at local row \p i and global
+  /// \p column. Rows are kept sorted by column, and a zero entry is
+  /// inserted if the column is not yet present, unless the matrix has
+  /// a fixed sparsity pattern.
+  HYPRE_Complex& getEntry(HYPRE_BigInt i, HYPRE_BigInt column) {
+    auto& columns = (*J)[i];
+    const auto col_ind = std::lower_bound(columns.begin(), columns.end(), column);
+    const auto n = std::distance(columns.begin(), col_ind);
+    if (col_ind == columns.end() or *col_ind != column) {
+      if (arrays->fixed_sparsity) {
+        throw BoutException("HypreMatrix with a fixed sparsity pattern: column {:d} of "
+                            "row {:d} is not in the stencil",
+                            column, ilower + i);
       }
+      columns.insert(col_ind, column);
+      (*V)[i].insert((*V)[i].begin() + n, 0.0);
+      arrays->structure_changed = true;
     }
-
-    if (!value_set) {
-      (*V)[i].push_back(value);
-      (*J)[i].push_back(column);
-    }
+    return (*V)[i][n];
   }
 
   BoutReal operator()(const ind_type& row, const ind_type& column) const {
@@ -671,42 +722,41 @@ public:
   void assemble() {
     CALI_CXX_MARK_FUNCTION;
 
-    HYPRE_BigInt num_entries = 0;
-    HYPRE_BigInt* num_cols;
-    HYPRE_BigInt* cols;
-    HYPRE_BigInt* rawI;
-    HYPRE_Complex* vals;
+    auto& raw = *arrays;
+    if (raw.structure_changed) {
+      raw.release();
+      raw.num_entries = 0;
+      HypreMalloc(raw.num_cols, num_rows * sizeof(HYPRE_BigInt));
+      for (HYPRE_BigInt i = 0; i < num_rows; ++i) {
+        raw.num_cols[i] = (*J)[i].size();
+        raw.num_entries += (*J)[i].size();
+      }
 
-    HypreMalloc(num_cols, num_rows * sizeof(HYPRE_BigInt));
-    for (HYPRE_BigInt i = 0; i < num_rows; ++i) {
-      num_cols[i] = (*J)[i].size();
-      num_entries += (*J)[i].size();
-    }
+      HypreMalloc(raw.rawI, num_rows * sizeof(HYPRE_BigInt));
+      HypreMalloc(raw.cols, raw.num_entries * sizeof(HYPRE_BigInt));
+      HypreMalloc(raw.vals, raw.num_entries * sizeof(HYPRE_Complex));
 
-    HypreMalloc(rawI, num_rows * sizeof(HYPRE_BigInt));
-    HypreMalloc(cols, num_entries * sizeof(HYPRE_BigInt));
-    HypreMalloc(vals, num_entries * sizeof(HYPRE_Complex));
+      HYPRE_BigInt entry = 0;
+      for (HYPRE_BigInt i = 0; i < num_rows; ++i) {
+        raw.rawI[i] = (*I)[i];
+        std::copy((*J)[i].begin(), (*J)[i].end(), raw.cols + entry);
+        entry += raw.num_cols[i];
+      }
+      raw.structure_changed = false;
+    }
 
+    // Only the values can have changed since the last call
     HYPRE_BigInt entry = 0;
     for (HYPRE_BigInt i = 0; i < num_rows; ++i) {
-      rawI[i] = (*I)[i];
-      for (HYPRE_BigInt col_ind = 0; col_ind < num_cols[i]; ++col_ind) {
-        cols[entry] = (*J)[i][col_ind];
-        vals[entry] = (*V)[i][col_ind];
-        entry++;
-      }
+      std::copy((*V)[i].begin(), (*V)[i].end(), raw.vals + entry);
+      entry += raw.num_cols[i];
     }
-    checkHypreError(
-        HYPRE_IJMatrixSetValues(*hypre_matrix, num_rows, num_cols, rawI, cols, vals));
+    checkHypreError(HYPRE_IJMatrixSetValues(*hypre_matrix, num_rows, raw.num_cols,
+                                            raw.rawI, raw.cols, raw.vals));
     checkHypreError(HYPRE_IJMatrixAssemble(*hypre_matrix));
     checkHypreError(HYPRE_IJMatrixGetObject(*hypre_matrix,
                                             reinterpret_cast<void**>(&parallel_matrix)));
     assembled = true;
-
-    HypreFree(rawI);
-    HypreFree(num_cols);
-    HypreFree(cols);
-    HypreFree(vals);
   }
 
   bool isAssembled() const { return assembled; }
@@ -733,6 +783,7 @@ public:
     result.I = I; // We want the pointer to transfer so this works like a view
     result.J = J;
     result.V = V;
+    result.arrays = arrays;
 
     return result;
   }
@@ -31,6 +31,7 @@
 
 #include <functional>
 #include <iostream>
+#include <type_traits>
 
 #include <bout/assert.hxx>
 #include <bout/constants.hxx>
@@ -38,6 +39,7 @@
 #include <bout/index_derivs_interface.hxx>
 #include <bout/region.hxx>
 #include <bout/scorepwrapper.hxx>
+#include <bout/sys/profiler.hxx>
 #include <bout/template_combinations.hxx>
 
 #include <bout/bout_types.hxx>
@@ -89,6 +91,21 @@ public:
             || meta.derivType == DERIV::StandardFourth)
     ASSERT2(var.getMesh()->getNguard(direction) >= nGuards);
 
+    if (direction == DIRECTION::Z) {
+      // Away from the periodic seam the stencil is at plain offsets,
+      // so the interior of each z row can vectorise
+      var.getRegion(region).forZInteriorAndSeam(
+          nGuards,
+          [&](const auto& i) {
+            result[i] =
+                apply(populateStencil<direction, stagger, nGuards, T, false>(var, i));
+          },
+          [&](const auto& i) {
+            result[i] = apply(populateStencil<direction, stagger, nGuards>(var, i));
+          });
+      return;
+    }
+
     BOUT_FOR(i, var.getRegion(region)) {
       result[i] = apply(populateStencil<direction, stagger, nGuards>(var, i));
     }
@@ -102,6 +119,26 @@ public:
     ASSERT2(meta.derivType == DERIV::Upwind || meta.derivType == DERIV::Flux)
     ASSERT2(var.getMesh()->getNguard(direction) >= nGuards);
 
+    if (direction == DIRECTION::Z) {
+      const bool use_vel_stencil =
+          meta.derivType == DERIV::Flux || stagger != STAGGER::None;
+      const auto kernel = [&](const auto& i, auto zwrap) {
+        constexpr bool wrap = decltype(zwrap)::value;
+        if (use_vel_stencil) {
+          result[i] =
+              apply(populateStencil<direction, stagger, nGuards, T, wrap>(vel, i),
+                    populateStencil<direction, STAGGER::None, nGuards, T, wrap>(var, i));
+        } else {
+          result[i] = apply(
+              vel[i], populateStencil<direction, STAGGER::None, nGuards, T, wrap>(var, i));
+        }
+      };
+      var.getRegion(region).forZInteriorAndSeam(
+          nGuards, [&](const auto& i) { kernel(i, std::false_type{}); },
+          [&](const auto& i) { kernel(i, std::true_type{}); });
+      return;
+    }
+
     if (meta.derivType == DERIV::Flux || stagger != STAGGER::None) {
       BOUT_FOR(i, var.getRegion(region)) {
         result[i] = apply(populateStencil<direction, stagger, nGuards>(vel, i),
@@ -136,16 +173,52 @@ constexpr metaData DerivativeType<FF>::meta;
 /// template combinations, in conjunction with the template_combinations code.
 /////////////////////////////////////////////////////////////////////////////////
 
+/// Count the bytes and flops of a derivative kernel reading \p nfields
+/// fields over \p region. These are estimates: each field and the
+/// result are streamed through memory once, and each point of each
+/// field takes a multiply and an add for every point of the stencil
+template <int nGuards, typename FieldType>
+void profileKernel(const FieldType& var, const std::string& region, int nfields) {
+  if (not bout::Profiler::enabled()) {
+    return;
+  }
+  const auto npoints = static_cast<std::uint64_t>(var.getRegion(region).size());
+  const auto nfields_u64 = static_cast<std::uint64_t>(nfields);
+  bout::Profiler::addBytes(npoints * (nfields_u64 + 1) * sizeof(BoutReal));
+  bout::Profiler::addFlops(npoints * nfields_u64 * 2 * (2 * nGuards + 1));
+}
+
+/// Free functions calling the kernels of a derivative method. These
+/// are stored in the DerivativeStore as plain function pointers, so
+/// calling them doesn't go through a bound member function
+template <typename Method, DIRECTION direction, STAGGER stagger, int nGuards,
+          typename FieldType>
+void standardKernel(const FieldType& var, FieldType& result, const std::string& region) {
+  BOUT_PROFILE_REGION("derivative");
+  profileKernel<nGuards>(var, region, 1);
+  Method{}.template standard<direction, stagger, nGuards, FieldType>(var, result, region);
+}
+
+template <typename Method, DIRECTION direction, STAGGER stagger, int nGuards,
+          typename FieldType>
+void upwindOrFluxKernel(const FieldType& vel, const FieldType& var, FieldType& result,
+                        const std::string& region) {
+  BOUT_PROFILE_REGION("derivative");
+  profileKernel<nGuards>(var, region, 2);
+  Method{}.template upwindOrFlux<direction, stagger, nGuards, FieldType>(vel, var, result,
+                                                                        region);
+}
+
 struct registerMethod {
   template <typename Direction, typename Stagger, typename FieldTypeContainer,
             typename Method>
   void operator()(Direction, Stagger, FieldTypeContainer, Method) {
     AUTO_TRACE();
-    using namespace std::placeholders;
 
     // Now we want to get the actual field type out of the TypeContainer
     // used to pass this around
     using FieldType = typename FieldTypeContainer::type;
+    using Store = DerivativeStore<FieldType>;
 
     Method method{};
 
@@ -156,27 +229,19 @@ struct registerMethod {
     // removed and we can use nGuard directly in the template statement.
     const int nGuards = method.meta.nGuards;
 
-    auto& derivativeRegister = DerivativeStore<FieldType>::getInstance();
+    auto& derivativeRegister = Store::getInstance();
 
     switch (method.meta.derivType) {
     case (DERIV::Standard):
     case (DERIV::StandardSecond):
     case (DERIV::StandardFourth): {
       if (nGuards == 1) {
-        const auto theFunc = std::bind(
-            // Method to store in function
-            &Method::template standard<Direction::value, Stagger::value, 1, FieldType>,
-            // Arguments -- first is hidden this of type-bound, others are placeholders
-            // for input field, output field, region
-            method, _1, _2, _3);
+        const typename Store::standardFunc theFunc =
+            &standardKernel<Method, Direction::value, Stagger::value, 1, FieldType>;
         derivativeRegister.registerDerivative(theFunc, Direction{}, Stagger{}, method);
       } else {
-        const auto theFunc = std::bind(
-            // Method to store in function
-            &Method::template standard<Direction::value, Stagger::value, 2, FieldType>,
-            // Arguments -- first is hidden this of type-bound, others are placeholders
-            // for input field, output field, region
-            method, _1, _2, _3);
+        const typename Store::standardFunc theFunc =
+            &standardKernel<Method, Direction::value, Stagger::value, 2, FieldType>;
         derivativeRegister.registerDerivative(theFunc, Direction{}, Stagger{}, method);
       }
       break;
@@ -184,26 +249,12 @@ struct registerMethod {
     case (DERIV::Upwind):
     case (DERIV::Flux): {
       if (nGuards == 1) {
-        const std::function<void(const FieldType&, const FieldType&, FieldType&,
-                                 const std::string&)>
-            theFunc = std::bind(
-                // Method to store in function
-                &Method::template upwindOrFlux<Direction::value, Stagger::value, 1,
-                                               FieldType>,
-                // Arguments -- first is hidden this of type-bound, others are placeholders
-                // for input field, output field, region
-                method, _1, _2, _3, _4);
+        const typename Store::flowFunc theFunc =
+            &upwindOrFluxKernel<Method, Direction::value, Stagger::value, 1, FieldType>;
         derivativeRegister.registerDerivative(theFunc, Direction{}, Stagger{}, method);
       } else {
-        const std::function<void(const FieldType&, const FieldType&, FieldType&,
-                                 const std::string&)>
-            theFunc = std::bind(
-                // Method to store in function
-                &Method::template upwindOrFlux<Direction::value, Stagger::value, 2,
-                                               FieldType>,
-                // Arguments -- first is hidden this of type-bound, others are placeholders
-                // for input field, output field, region
-                method, _1, _2, _3, _4);
+        const typename Store::flowFunc theFunc =
+            &upwindOrFluxKernel<Method, Direction::value, Stagger::value, 2, FieldType>;
         derivativeRegister.registerDerivative(theFunc, Direction{}, Stagger{}, method);
       }
       break;
@@ -214,6 +265,21 @@ struct registerMethod {
   }
 };
 
+/// Fix a registered method as the default (DIFF_DEFAULT) method, for
+/// all template combinations. Used when building with
+/// BOUT_ENABLE_STATIC_DERIVATIVE_DEFAULTS
+struct registerDefaultMethod {
+  template <typename Direction, typename Stagger, typename FieldTypeContainer,
+            typename Method>
+  void operator()(Direction, Stagger, FieldTypeContainer, Method) {
+    AUTO_TRACE();
+    using FieldType = typename FieldTypeContainer::type;
+    DerivativeStore<FieldType>::getInstance().fixDefaultMethod(
+        Method::meta.key, Method::meta.derivType, Direction{}.lookup(),
+        Stagger{}.lookup());
+  }
+};
+
 #define DEFINE_STANDARD_DERIV_CORE(name, key, nGuards, type)                        \
   struct name {                                                                     \
     BoutReal operator()(const stencil& f) const;                                    \
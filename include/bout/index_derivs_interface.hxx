@@ -87,20 +87,23 @@ T flowDerivative(const T& vel, const T& f, CELL_LOC outloc, const std::string& m
     return zeroFrom(f).setLocation(outloc);
   }
 
-  // Lookup the method
-  auto derivativeMethod = DerivativeStore<T>::getInstance().getFlowDerivative(
-      method, direction, stagger, derivType);
-
   // Create the result field
   T result{emptyFrom(f).setLocation(outloc)};
 
-  // Apply method
-  derivativeMethod(vel, f, result, region);
+  // Apply method, calling the bound default method directly if we can
+  const auto& store = DerivativeStore<T>::getInstance();
+  if (const auto defaultMethod =
+          store.findDefaultFlowDerivative(method, direction, stagger, derivType)) {
+    defaultMethod(vel, f, result, region);
+  } else {
+    store.findFlowDerivative(method, direction, stagger, derivType)(vel, f, result,
+                                                                    region);
+  }
 
   // Check the result is valid
   {
     TRACE("Checking result");
-    checkData(result);
+    checkData(result, region);
   }
 
   return result;
@@ -149,20 +152,23 @@ T standardDerivative(const T& f, CELL_LOC outloc, const std::string& method,
     return zeroFrom(f).setLocation(outloc);
   }
 
-  // Lookup the method
-  auto derivativeMethod = DerivativeStore<T>::getInstance().getStandardDerivative(
-      method, direction, stagger, derivType);
-
   // Create the result field
   T result{emptyFrom(f).setLocation(outloc)};
 
-  // Apply method
-  derivativeMethod(f, result, region);
+  // Apply method, calling the bound default method directly if we can
+  const auto& store = DerivativeStore<T>::getInstance();
+  if (const auto defaultMethod =
+          store.findDefaultStandardDerivative(method, direction, stagger, derivType)) {
+    defaultMethod(f, result, region);
+  } else {
+    store.findStandardDerivative(method, direction, stagger, derivType)(f, result,
+                                                                        region);
+  }
 
   // Check the result is valid
   {
     TRACE("Checking result");
-    checkData(result);
+    checkData(result, region);
   }
 
   return result;
@@ -46,6 +46,7 @@ class Laplacian;
 #include "bout/generic_factory.hxx"
 #include "bout/monitor.hxx"
 #include "bout/unused.hxx"
+#include "bout/utils.hxx"
 #include <bout/boutexception.hxx>
 
 #include "bout/dcomplex.hxx"
@@ -333,6 +334,55 @@ protected:
                     int outer_boundary_flags, const Field2D* a, const Field2D* c1coef,
                     const Field2D* c2coef, const Field2D* d, bool includeguards = true,
                     bool zperiodic = true);
+
+  /// The tridiagonal matrices from `tridagMatrix` for a set of
+  /// systems, without guard cells. System `(jy - ys) * nmode + kz` is
+  /// in each row
+  struct TridagMatrices {
+    Matrix<dcomplex> a, b, c;
+    /// Non-zero where `tridagMatrix` sets the right hand side to zero
+    /// for the boundary conditions
+    Matrix<int> zero_rhs;
+  };
+
+  /// Get the tridiagonal matrices for Y indices \p ys to \p ye and
+  /// \p nmode Fourier modes starting from \p kz_start, with wave
+  /// numbers `kz * 2 * pi / zlength`. Row `kz` of each Y index holds
+  /// mode `kz_start + kz`, so \p kz_start is non-zero when the modes
+  /// are shared between processors in Z. If `cache_tridag_matrices`
+  /// is set, the matrices are only rebuilt if the arguments, flags or
+  /// coefficient values have changed, or `invalidateTridagMatrices`
+  /// has been called because a coefficient has been set. \p rebuilt
+  /// is set to true if the matrices are new
+  const TridagMatrices& getTridagMatrices(int ys, int ye, int nmode, BoutReal zlength,
+                                          const Field2D* a, const Field2D* c1coef,
+                                          const Field2D* c2coef, const Field2D* d,
+                                          bool zperiodic, bool& rebuilt,
+                                          int kz_start = 0);
+
+  /// Set the elements of the right hand side \p bk which are fixed by
+  /// the boundary conditions in \p matrices to zero
+  static void applyTridagBoundaries(const TridagMatrices& matrices,
+                                    Matrix<dcomplex>& bk);
+
+  /// For solvers which modify the matrices: get the matrices from
+  /// `getTridagMatrices`, apply their boundary conditions to \p bk,
+  /// and return a copy of `a`, `b` and `c`. The copy is held in
+  /// storage which is re-used by the next call
+  TridagMatrices& getTridagWorkMatrices(int ys, int ye, int nmode, BoutReal zlength,
+                                        const Field2D* a, const Field2D* c1coef,
+                                        const Field2D* c2coef, const Field2D* d,
+                                        bool zperiodic, Matrix<dcomplex>& bk,
+                                        int kz_start = 0);
+
+  /// The coefficients have changed, so the tridiagonal matrices need
+  /// to be rebuilt
+  void invalidateTridagMatrices() { tridag_cache.valid = false; }
+
+  /// Re-use the tridiagonal matrices from `getTridagMatrices` between
+  /// solves? Only valid if the metric doesn't change
+  bool cache_tridag_matrices{false};
+
   CELL_LOC location;   ///< staggered grid location of this solver
   Mesh* localmesh;     ///< Mesh object for this solver
   Coordinates* coords; ///< Coordinates object, so we only have to call
@@ -341,6 +391,25 @@ protected:
 private:
   /// Singleton instance
   static std::unique_ptr<Laplacian> instance;
+
+  /// The matrices from the last call to `getTridagMatrices`, and the
+  /// arguments and flags they were built with
+  struct {
+    bool valid{false};
+    int ys, ye, nmode, kz_start;
+    BoutReal zlength;
+    bool zperiodic;
+    int global_flags, inner_boundary_flags, outer_boundary_flags;
+    /// Copies of the coefficients, to catch fields changed in place
+    Field2D a, c1coef, c2coef, d;
+    TridagMatrices matrices;
+  } tridag_cache;
+
+  /// Storage for the copies from `getTridagWorkMatrices`
+  TridagMatrices tridag_work;
+
+  /// Number of calls to `getTridagMatrices` which re-used the matrices
+  int tridag_cache_hits{0};
   /// Name for writing performance infomation; default taken from
   /// constructing `Options` section
   std::string performance_name;
@@ -361,6 +430,10 @@ public:
   /// Get name for writing performance information
   std::string getPerformanceName() const { return performance_name; };
 
+  /// Number of solves which re-used the tridiagonal matrices from the
+  /// previous solve, see `cache_coefficients` option
+  int getTridagCacheHits() const { return tridag_cache_hits; }
+
 protected:
   /// Set the name for writing performance information
   void setPerformanceName(std::string name) { performance_name = std::move(name); }
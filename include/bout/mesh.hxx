@@ -295,6 +295,62 @@ public:
   /// @param g  The group of fields to communicate. Guard cells will be modified
   void communicateYZ(FieldGroup& g);
 
+  /// Start communicating guard cells of a list of FieldData objects,
+  /// without waiting for the communication to finish. Packs arguments
+  /// into a FieldGroup and passes to startCommunicate(FieldGroup&).
+  template <typename... Ts>
+  comm_handle startCommunicate(Ts&... ts) {
+    FieldGroup g(ts...);
+    return startCommunicate(g);
+  }
+
+  /// Finish a communication started with startCommunicate(Ts&...)
+  template <typename... Ts>
+  void finishCommunicate(comm_handle handle, Ts&... ts) {
+    FieldGroup g(ts...);
+    finishCommunicate(handle, g);
+  }
+
+  /// First half of a split-phase communicate(FieldGroup&)
+  ///
+  /// Starts communicating the guard cells of \p g, and returns
+  /// without waiting for the data to arrive. Until
+  /// finishCommunicate() is called, operators can be evaluated on
+  /// the "RGN_NOBNDRY_INTERIOR" region, whose stencils do not reach
+  /// into the guard cells. Afterwards, the remaining points are in
+  /// "RGN_NOBNDRY_SHELL":
+  ///
+  ///     comm_handle handle = mesh->startCommunicate(comms);
+  ///     // ... calculate on "RGN_NOBNDRY_INTERIOR"
+  ///     mesh->finishCommunicate(handle, comms);
+  ///     // ... calculate on "RGN_NOBNDRY_SHELL"
+  ///
+  /// Both the X and Y communications are started here. If
+  /// `include_corner_cells` is set, the corner cells are left out,
+  /// and are exchanged by finishCommunicate() once the Y guard cells
+  /// they come from have arrived.
+  ///
+  /// The built-in differential operators return new fields over the
+  /// whole of their region, so the calculation on
+  /// "RGN_NOBNDRY_INTERIOR" has to be written by hand, for example as
+  /// a BOUT_FOR loop over the region writing into an existing field.
+  ///
+  /// \param g Group of fields to communicate. Must not be modified
+  ///           before finishCommunicate() is called
+  /// \returns handle to be passed to finishCommunicate()
+  comm_handle startCommunicate(FieldGroup& g);
+
+  /// Second half of a split-phase communicate(FieldGroup&)
+  ///
+  /// Waits for the communication started by startCommunicate() to
+  /// finish, exchanges the corner cells if `include_corner_cells` is
+  /// set, and then calculates the parallel slices of 3D fields if
+  /// needed, as in communicate(FieldGroup&)
+  ///
+  /// \param handle The handle returned by startCommunicate()
+  /// \param g      The same group of fields passed to startCommunicate()
+  void finishCommunicate(comm_handle handle, FieldGroup& g);
+
   /*!
    * Communicate an X-Z field
    */
@@ -343,6 +399,17 @@ public:
   /// Send only the y-guard cells
   virtual comm_handle sendY(FieldGroup& g, comm_handle handle = nullptr) = 0;
 
+  /// Send as much of the guard cells as possible before the corner
+  /// cells are known, used by startCommunicate() when
+  /// `include_corner_cells` is set. The default only sends the
+  /// y-guard cells
+  virtual comm_handle sendWithoutCorners(FieldGroup& g) { return sendY(g); }
+
+  /// Send whatever sendWithoutCorners() left out, once the guard
+  /// cells it sent have arrived. Returns nullptr if there is nothing
+  /// to send. The default sends all the x-guard cells
+  virtual comm_handle sendXCorners(FieldGroup& g) { return sendX(g); }
+
   /// Wait for the handle, return error code
   virtual int wait(comm_handle handle) = 0; ///< Wait for the handle, return error code
 
@@ -353,6 +420,22 @@ public:
   virtual int getXProcIndex() = 0; ///< This processor's index in X direction
   virtual int getYProcIndex() = 0; ///< This processor's index in Y direction
 
+  /// The number of processors in the Z direction
+  virtual int getNZPE() { return 1; }
+  /// This processor's index in Z direction
+  virtual int getZProcIndex() { return 0; }
+
+  /// Global X index, excluding boundaries, of the first point on X
+  /// processor \p xproc. Passing getNXPE() gives the number of X
+  /// points excluding boundaries. Assumes every X processor has the
+  /// same number of points, unless overridden
+  virtual int getXProcOffset(int xproc) const { return xproc * (xend - xstart + 1); }
+  /// Global Y index, excluding boundaries, of the first point on Y
+  /// processor \p yproc. Passing getNYPE() gives the number of Y
+  /// points excluding boundaries. Assumes every Y processor has the
+  /// same number of points, unless overridden
+  virtual int getYProcOffset(int yproc) const { return yproc * (yend - ystart + 1); }
+
   // X communications
   virtual bool firstX()
       const = 0; ///< Is this processor first in X? i.e. is there a boundary to the left in X?
@@ -397,6 +480,9 @@ public:
   } ///< Return communicator containing all processors in X
   virtual MPI_Comm getXcomm(int jy) const = 0; ///< Return X communicator
   virtual MPI_Comm getYcomm(int jx) const = 0; ///< Return Y communicator
+  /// Return communicator containing the processors with the same X
+  /// and Y indices as this one, ordered by Z processor index
+  virtual MPI_Comm getZcomm() const { return MPI_COMM_SELF; }
 
   /// Return pointer to the mesh's MPI Wrapper object
   MpiWrapper& getMpi() { return *mpi; }
@@ -658,7 +744,9 @@ public:
     case (DIRECTION::YAligned):
       return ystart;
     case (DIRECTION::Z):
-      return 2;
+      // Without guard cells Z is periodic on each processor, so
+      // stencils wrap around
+      return (zstart > 0) ? zstart : 2;
     default:
       throw BoutException("Unhandled direction encountered in getNguard");
     }
@@ -47,6 +47,14 @@ public:
     return ::MPI_Allreduce(sendbuf, recvbuf, count, datatype, op, comm);
   }
 
+  virtual int MPI_Alltoallv(const void* sendbuf, const int* sendcounts,
+                            const int* sdispls, MPI_Datatype sendtype, void* recvbuf,
+                            const int* recvcounts, const int* rdispls,
+                            MPI_Datatype recvtype, MPI_Comm comm) {
+    return ::MPI_Alltoallv(sendbuf, sendcounts, sdispls, sendtype, recvbuf, recvcounts,
+                           rdispls, recvtype, comm);
+  }
+
   virtual int MPI_Barrier(MPI_Comm comm) { return ::MPI_Barrier(comm); }
 
   virtual int MPI_Comm_create(MPI_Comm comm, MPI_Group group, MPI_Comm* newcomm) {
@@ -108,6 +116,15 @@ public:
     return ::MPI_Recv(buf, count, datatype, source, tag, comm, status);
   }
 
+  virtual int MPI_Recv_init(void* buf, int count, MPI_Datatype datatype, int source,
+                            int tag, MPI_Comm comm, MPI_Request* request) {
+    return ::MPI_Recv_init(buf, count, datatype, source, tag, comm, request);
+  }
+
+  virtual int MPI_Request_free(MPI_Request* request) {
+    return ::MPI_Request_free(request);
+  }
+
   virtual int MPI_Scan(const void* sendbuf, void* recvbuf, int count,
                        MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {
     return ::MPI_Scan(sendbuf, recvbuf, count, datatype, op, comm);
@@ -125,6 +142,15 @@ public:
     return ::MPI_Send(buf, count, datatype, dest, tag, comm);
   }
 
+  virtual int MPI_Send_init(const void* buf, int count, MPI_Datatype datatype, int dest,
+                            int tag, MPI_Comm comm, MPI_Request* request) {
+    return ::MPI_Send_init(buf, count, datatype, dest, tag, comm, request);
+  }
+
+  virtual int MPI_Startall(int count, MPI_Request array_of_requests[]) {
+    return ::MPI_Startall(count, array_of_requests);
+  }
+
   virtual int MPI_Type_commit(MPI_Datatype* datatype) {
     return ::MPI_Type_commit(datatype);
   }
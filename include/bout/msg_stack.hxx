@@ -39,6 +39,7 @@ class MsgStack;
 #include <cstdarg>
 #include <exception>
 #include <string>
+#include <thread>
 #include <vector>
 
 /// The __PRETTY_FUNCTION__ variable is defined by GCC (and some other families) but is
@@ -103,8 +104,17 @@ public:
 #endif
 
 private:
+#if BOUT_USE_MSGSTACK
+  /// Is this called from a thread other than the one which created
+  /// the stack, outside any OpenMP region? Such threads, e.g. the
+  /// output writer (see bout::AsyncWriter), don't use the stack, so
+  /// that exceptions thrown on them don't race with the main thread
+  bool isOtherThread() const;
+#endif
+
   std::vector<std::string> stack;                  ///< Message stack;
   std::vector<std::string>::size_type position{0}; ///< Position in stack
+  std::thread::id owner{std::this_thread::get_id()}; ///< Thread using the stack
 };
 
 /*!
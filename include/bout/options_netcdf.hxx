@@ -6,12 +6,35 @@
 
 #include "bout/build_config.hxx"
 
+namespace bout {
+/// How variables are stored in NetCDF-4 files. This is applied when
+/// variables are first created. Individual variables can override
+/// `deflate`, `shuffle` and `quantize` with attributes of the same
+/// names. These attributes are not written to the file
+struct NetCDFStorage {
+  /// Compression level, from 0 (no compression) to 9
+  int deflate{0};
+  /// Apply the shuffle filter before compressing?
+  bool shuffle{false};
+  /// Number of significant decimal digits to keep in floating point
+  /// values. This is lossy, but makes the data compress better. 0
+  /// keeps all the digits
+  int quantize{0};
+  /// Number of time slices in each chunk of time-evolving
+  /// variables. Chunks contain all of this processor's domain
+  int chunk_time{1};
+};
+} // namespace bout
+
 #if !BOUT_HAS_NETCDF || BOUT_HAS_LEGACY_NETCDF
 
+#include <map>
 #include <string>
+#include <vector>
 
 #include "bout/boutexception.hxx"
 #include "bout/options.hxx"
+#include "bout/unused.hxx"
 
 namespace bout {
 
@@ -22,7 +45,9 @@ public:
     append   ///< Append to file when writing
   };
 
-  OptionsNetCDF(const std::string& filename, FileMode mode = FileMode::replace) {}
+  OptionsNetCDF() {}
+  OptionsNetCDF(const std::string& UNUSED(filename),
+                FileMode UNUSED(mode) = FileMode::replace, bool UNUSED(parallel) = false) {}
   OptionsNetCDF(const OptionsNetCDF&) = default;
   OptionsNetCDF(OptionsNetCDF&&) = default;
   OptionsNetCDF& operator=(const OptionsNetCDF&) = default;
@@ -30,19 +55,37 @@ public:
 
   /// Read options from file
   Options read() { throw BoutException("OptionsNetCDF not available\n"); }
+  Options read(int UNUSED(max_dimensions),
+               std::map<std::string, std::vector<int>>& UNUSED(skipped)) {
+    throw BoutException("OptionsNetCDF not available\n");
+  }
+
+  /// Read part of a variable from file
+  Options readSlab(const std::string& UNUSED(name),
+                   const std::vector<int>& UNUSED(start),
+                   const std::vector<int>& UNUSED(count)) {
+    throw BoutException("OptionsNetCDF not available\n");
+  }
 
   /// Write options to file
-  void write(const Options& options) {
+  void write(const Options& options) { write(options, "t"); }
+  void write(const Options& UNUSED(options), const std::string& UNUSED(time_dim)) {
     throw BoutException("OptionsNetCDF not available\n");
   }
+
+  void verifyTimesteps() const { throw BoutException("OptionsNetCDF not available\n"); }
+
+  void setStorage(const NetCDFStorage& UNUSED(storage)) {}
 };
 
 } // namespace bout
 
 #else
 
+#include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "bout/options.hxx"
 
@@ -64,7 +107,12 @@ public:
   // Constructors need to be defined in implementation due to forward
   // declaration of NcFile
   OptionsNetCDF();
-  explicit OptionsNetCDF(std::string filename, FileMode mode = FileMode::replace);
+  /// If \p parallel is true, all processors write to a single file
+  /// \p filename using parallel NetCDF-4/HDF5 I/O. Fields are written
+  /// as global arrays, excluding the Y boundary cells. This requires
+  /// NetCDF to have been built with parallel I/O support
+  explicit OptionsNetCDF(std::string filename, FileMode mode = FileMode::replace,
+                         bool parallel = false);
   ~OptionsNetCDF();
   OptionsNetCDF(const OptionsNetCDF&) = delete;
   OptionsNetCDF(OptionsNetCDF&&) noexcept;
@@ -74,7 +122,26 @@ public:
   /// Read options from file
   Options read();
 
-  /// Write options to file
+  /// Read options from file, except for the values of floating point
+  /// variables with more than \p max_dimensions dimensions. These
+  /// are only given their attributes, and their names and shapes are
+  /// added to \p skipped, so that they can be read in parts with
+  /// readSlab(). Names of variables in groups are separated by ':'
+  Options read(int max_dimensions, std::map<std::string, std::vector<int>>& skipped);
+
+  /// Read the part of floating point variable \p name which starts
+  /// at index \p start and has \p count elements in each dimension.
+  /// The result holds an Array, Matrix or Tensor for 1, 2 or 3
+  /// dimensions. The file is kept open for further calls, until
+  /// this object is destroyed or written to
+  Options readSlab(const std::string& name, const std::vector<int>& start,
+                   const std::vector<int>& count);
+
+  /// Write options to file. A time-evolving value which is first
+  /// written after other values with the same time dimension can
+  /// have a floating point attribute "backfill": its earlier time
+  /// slices are then filled with this value, rather than the value
+  /// starting from the first time slice
   void write(const Options& options) { write(options, "t"); }
   void write(const Options& options, const std::string& time_dim);
 
@@ -83,6 +150,10 @@ public:
   /// any differences, otherwise is silent
   void verifyTimesteps() const;
 
+  /// Set how new variables are stored: chunking, compression and
+  /// quantisation
+  void setStorage(const NetCDFStorage& new_storage) { storage = new_storage; }
+
 private:
   /// Name of the file on disk
   std::string filename;
@@ -90,6 +161,18 @@ private:
   FileMode file_mode{FileMode::replace};
   /// Pointer to netCDF file so we don't introduce direct dependence
   std::unique_ptr<netCDF::NcFile> data_file;
+  /// File opened for reading by readSlab()
+  std::unique_ptr<netCDF::NcFile> slab_file;
+  /// Write a single file from all processors?
+  bool parallel{false};
+  /// How to store new variables
+  NetCDFStorage storage;
+  /// NetCDF ID of the file opened for parallel writing. NcFile can't
+  /// open files for parallel I/O, so this is opened with the C API
+  int parallel_file_id{-1};
+
+  /// Open the file for parallel writing, if it isn't already open
+  void openParallel();
 };
 
 } // namespace bout
@@ -107,6 +190,15 @@ std::string getRestartFilename(Options& options, int rank);
 std::string getOutputFilename(Options& options);
 /// Name of the main output file on \p rank
 std::string getOutputFilename(Options& options, int rank);
+/// Should the main output be written to a single file by all
+/// processors? Reads "output:parallel"
+bool isParallelOutput(Options& options);
+/// Name of the main output file, taking into account whether it is
+/// written in parallel to a single file
+std::string getDefaultOutputFilename(Options& options);
+/// Read how to store variables from \p options, e.g. the "output"
+/// section. If \p lossless, `quantize` is not read and stays 0
+NetCDFStorage getNetCDFStorage(Options& options, bool lossless = false);
 /// Write `Options::root()` to the main output file, overwriting any
 /// existing files
 void writeDefaultOutputFile();
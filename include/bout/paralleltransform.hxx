@@ -295,14 +295,18 @@ private:
                    const std::string& region = "RGN_NOX") const;
 
   /*!
-   * Shift a given 1D array, assumed to be in Z, by the given \p zangle
+   * Shift \p ncolumns Z columns, stored one after another, by the
+   * given phases. The columns are transformed in one batch
    *
-   * @param[in] in  A 1D array of length mesh.LocalNz
-   * @param[in] phs Phase shift, assumed to have length (mesh.LocalNz/2 + 1) i.e. the
-   * number of modes
-   * @param[out] out  A 1D array of length mesh.LocalNz, already allocated
+   * @param[in] in  The columns, each of length mesh.GlobalNz
+   * @param[in] phs Phase shift of the first column, of length
+   * (mesh.GlobalNz/2 + 1) i.e. the number of modes
+   * @param[in] ncolumns  Number of columns to shift
+   * @param[in] phs_stride  Distance between the phase shifts of consecutive columns
+   * @param[out] out  The shifted columns, already allocated
    */
-  void shiftZ(const BoutReal* in, const dcomplex* phs, BoutReal* out) const;
+  void shiftZ(const BoutReal* in, const dcomplex* phs, int ncolumns, int phs_stride,
+              BoutReal* out) const;
 
   /// Calculate and store the phases for to/from field aligned and for
   /// the parallel slices using zShift
@@ -310,11 +314,13 @@ private:
 
   /// Shift a 3D field \p f in Z to all the parallel slices in \p phases
   ///
-  /// @param[in] f      The field to shift
+  /// The whole of \p f is transformed once, then each slice is
+  /// shifted and transformed back straight into the parallel slices
+  /// of \p f, which must already be allocated
+  ///
+  /// @param[inout] f   The field to shift
   /// @param[in] phases The phase and offset information for each parallel slice
-  /// @return The shifted parallel slices
-  std::vector<Field3D> shiftZ(const Field3D& f,
-                              const std::vector<ParallelSlicePhase>& phases) const;
+  void shiftZ(Field3D& f, const std::vector<ParallelSlicePhase>& phases) const;
 };
 
 #endif // __PARALLELTRANSFORM_H__
@@ -33,6 +33,8 @@
 #include "bout/build_config.hxx"
 
 #include <algorithm>
+#include <exception>
+#include <functional>
 #include <memory>
 #include <type_traits>
 #include <vector>
@@ -42,6 +44,7 @@
 #include <bout/globalindexer.hxx>
 #include <bout/mesh.hxx>
 #include <bout/operatorstencil.hxx>
+#include <bout/output.hxx>
 #include <bout/paralleltransform.hxx>
 #include <bout/petsclib.hxx>
 #include <bout/region.hxx>
@@ -307,12 +310,35 @@ public:
     }
   };
 
+  /// Local rows of a matrix with a fixed sparsity pattern, with the
+  /// columns of each row kept sorted
+  struct RowCache {
+    PetscInt rowStart = 0;
+    std::vector<std::vector<PetscInt>> columns;
+    std::vector<std::vector<PetscScalar>> values;
+  };
+
+  /// The operator applied by a matrix-free (shell) matrix
+  struct ShellContext {
+    IndexerPtr<T> indexConverter;
+    std::function<T(const T&)> function;
+  };
+
   /// Default constructor does nothing
   PetscMatrix() : matrix(new Mat(), MatrixDeleter()) {}
 
   /// Copy constructor
-  PetscMatrix(const PetscMatrix<T>& m) : matrix(new Mat(), MatrixDeleter()), pt(m.pt) {
-    MatDuplicate(*m.matrix, MAT_COPY_VALUES, matrix.get());
+  PetscMatrix(const PetscMatrix<T>& m)
+      : matrix(new Mat(), MatrixDeleter()), shell(m.shell), pt(m.pt) {
+    if (shell) {
+      // A shell matrix holds no values, so can be shared
+      matrix = m.matrix;
+    } else {
+      MatDuplicate(*m.matrix, MAT_COPY_VALUES, matrix.get());
+    }
+    if (m.cache) {
+      cache = std::make_shared<RowCache>(*m.cache);
+    }
     indexConverter = m.indexConverter;
     yoffset = m.yoffset;
     initialised = m.initialised;
@@ -321,6 +347,8 @@ public:
   /// Move constrcutor
   PetscMatrix(PetscMatrix<T>&& m) : pt(m.pt) {
     matrix = m.matrix;
+    cache = m.cache;
+    shell = m.shell;
     indexConverter = m.indexConverter;
     yoffset = m.yoffset;
     initialised = m.initialised;
@@ -329,7 +357,17 @@ public:
 
   // Construct a matrix capable of operating on the specified field,
   // preallocating memory if requeted and possible.
-  PetscMatrix(IndexerPtr<T> indConverter, bool preallocate = true)
+  //
+  // If \p fixedSparsity is true then the indexer must have a stencil,
+  // and the local rows are stored in compressed row form built once
+  // from that stencil. Setting elements then only updates these
+  // values, and assemble() copies each row into the PETSc matrix with
+  // a single call, so the structure of the matrix is reused when the
+  // coefficients change. Setting an element outside the stencil
+  // (e.g. from parallel interpolation with a stencil which doesn't
+  // include it) throws a BoutException.
+  PetscMatrix(IndexerPtr<T> indConverter, bool preallocate = true,
+              bool fixedSparsity = false)
       : matrix(new Mat(), MatrixDeleter()), indexConverter(indConverter) {
     const MPI_Comm comm = std::is_same<T, FieldPerp>::value
                               ? indConverter->getMesh()->getXcomm()
@@ -342,16 +380,43 @@ public:
     MatSetType(*matrix, MATMPIAIJ);
 
     // If a stencil has been provided, preallocate memory
-    if (preallocate && indexConverter->sparsityPatternAvailable()) {
+    if ((preallocate || fixedSparsity) && indexConverter->sparsityPatternAvailable()) {
       MatMPIAIJSetPreallocation(*matrix, 0, indexConverter->getNumDiagonal().data(), 0,
                                 indexConverter->getNumOffDiagonal().data());
     }
 
     MatSetUp(*matrix);
+
+    if (fixedSparsity) {
+      if (!indexConverter->sparsityPatternAvailable()) {
+        throw BoutException("PetscMatrix with a fixed sparsity pattern needs an "
+                            "indexer with a stencil");
+      }
+      cache = std::make_shared<RowCache>();
+      cache->rowStart = indexConverter->getGlobalStart();
+      for (const auto& row : indexConverter->getSparsityPattern()) {
+        cache->columns.emplace_back(row.begin(), row.end());
+        cache->values.emplace_back(row.size(), 0.0);
+      }
+      // Only locally owned rows are ever set, so assembly needs no
+      // communication
+      MatSetOption(*matrix, MAT_NO_OFF_PROC_ENTRIES, PETSC_TRUE);
+    }
+
     yoffset = 0;
     initialised = true;
   }
 
+  /// Construct a matrix-free operator, for use with Krylov methods
+  /// which only need matrix-vector products. Multiplying by the
+  /// matrix calls \p function on the field held in the vector, which
+  /// is zero in the guard cells, so \p function must communicate if
+  /// it needs them. Elements of the matrix can not be set or read.
+  static PetscMatrix<T> matrixFree(IndexerPtr<T> indConverter,
+                                   std::function<T(const T&)> function) {
+    return PetscMatrix<T>(indConverter, std::move(function));
+  }
+
   /// Copy assignment
   PetscMatrix<T>& operator=(PetscMatrix<T> rhs) {
     swap(*this, rhs);
@@ -360,6 +425,8 @@ public:
   /// Move assignment
   PetscMatrix<T>& operator=(PetscMatrix<T>&& rhs) {
     matrix = rhs.matrix;
+    cache = rhs.cache;
+    shell = rhs.shell;
     indexConverter = rhs.indexConverter;
     pt = rhs.pt;
     yoffset = rhs.yoffset;
@@ -386,8 +453,9 @@ public:
     Element() = delete;
     Element(const Element& other) = default;
     Element(Mat* matrix, PetscInt row, PetscInt col, std::vector<PetscInt> p = {},
-            std::vector<BoutReal> w = {})
-        : petscMatrix(matrix), petscRow(row), petscCol(col), positions(p), weights(w) {
+            std::vector<BoutReal> w = {}, RowCache* rows = nullptr)
+        : petscMatrix(matrix), petscRow(row), petscCol(col), positions(p), weights(w),
+          cache(rows) {
       ASSERT2(positions.size() == weights.size());
 #if CHECK > 2
       for (const auto val : weights) {
@@ -398,6 +466,10 @@ public:
         positions = {col};
         weights = {1.0};
       }
+      if (cache != nullptr) {
+        value = getCachedValue(*cache, petscRow, petscCol);
+        return;
+      }
       PetscBool assembled;
       MatAssembled(*petscMatrix, &assembled);
       if (assembled == PETSC_TRUE) {
@@ -441,6 +513,20 @@ public:
       std::transform(weights.begin(), weights.end(), std::back_inserter(values),
                      [&val](BoutReal weight) -> PetscScalar { return weight * val; });
 
+      if (cache != nullptr) {
+        // Don't throw inside the critical section, as the exception
+        // can't leave an OpenMP structured block
+        bool valid;
+        BOUT_OMP(critical)
+        valid = setCachedValues(values, mode);
+        if (!valid) {
+          throw BoutException("PetscMatrix with a fixed sparsity pattern: element "
+                              "({:d}, {:d}) is not in the stencil of a local row",
+                              petscRow, petscCol);
+        }
+        return;
+      }
+
       int status;
       BOUT_OMP(critical)
       status = MatSetValues(*petscMatrix, 1, &petscRow, positions.size(),
@@ -449,14 +535,46 @@ public:
         throw BoutException("Error when setting elements of a PETSc matrix.");
       }
     }
+    /// Set or add \p values in the cached row. Returns false, leaving
+    /// the row unchanged, if the row isn't local or any of the columns
+    /// isn't in the stencil
+    bool setCachedValues(const std::vector<PetscScalar>& values, InsertMode mode) {
+      const PetscInt row = petscRow - cache->rowStart;
+      if (row < 0 || row >= static_cast<PetscInt>(cache->columns.size())) {
+        return false;
+      }
+      const auto& columns = cache->columns[row];
+      std::vector<std::size_t> offsets;
+      offsets.reserve(positions.size());
+      for (const auto position : positions) {
+        const auto column = std::lower_bound(columns.begin(), columns.end(), position);
+        if (column == columns.end() || *column != position) {
+          return false;
+        }
+        offsets.push_back(std::distance(columns.begin(), column));
+      }
+      auto& rowValues = cache->values[row];
+      for (std::size_t i = 0; i < offsets.size(); ++i) {
+        if (mode == INSERT_VALUES) {
+          rowValues[offsets[i]] = values[i];
+        } else {
+          rowValues[offsets[i]] += values[i];
+        }
+      }
+      return true;
+    }
     Mat* petscMatrix;
     PetscInt petscRow, petscCol;
     PetscScalar value;
     std::vector<PetscInt> positions;
     std::vector<BoutReal> weights;
+    RowCache* cache = nullptr;
   };
 
   Element operator()(const ind_type& index1, const ind_type& index2) {
+    if (shell) {
+      throw BoutException("Can not set elements of a matrix-free PetscMatrix");
+    }
     const int global1 = indexConverter->getGlobal(index1),
               global2 = indexConverter->getGlobal(index2);
 #if CHECKLEVEL >= 1
@@ -499,11 +617,14 @@ public:
                        return p.weight;
                      });
     }
-    return Element(matrix.get(), global1, global2, positions, weights);
+    return Element(matrix.get(), global1, global2, positions, weights, cache.get());
   }
 
   BoutReal operator()(const ind_type& index1, const ind_type& index2) const {
     ASSERT2(yoffset == 0);
+    if (shell) {
+      throw BoutException("Can not get elements of a matrix-free PetscMatrix");
+    }
     const int global1 = indexConverter->getGlobal(index1),
               global2 = indexConverter->getGlobal(index2);
 #if CHECKLEVEL >= 1
@@ -515,6 +636,9 @@ public:
       throw BoutException("Request to return invalid matrix element");
     }
 #endif
+    if (cache) {
+      return getCachedValue(*cache, global1, global2);
+    }
     BoutReal value;
     int status;
     BOUT_OMP(critical)
@@ -527,6 +651,23 @@ public:
 
   // Assemble the matrix prior to use
   void assemble() {
+    if (cache) {
+      // Copy the cached rows into the matrix. Once every element has
+      // been set once, this only overwrites existing entries.
+      for (std::size_t i = 0; i < cache->columns.size(); ++i) {
+        const auto& columns = cache->columns[i];
+        if (columns.empty()) {
+          continue;
+        }
+        const PetscInt row = cache->rowStart + static_cast<PetscInt>(i);
+        const int status =
+            MatSetValues(*matrix, 1, &row, static_cast<PetscInt>(columns.size()),
+                         columns.data(), cache->values[i].data(), INSERT_VALUES);
+        if (status != 0) {
+          throw BoutException("Error when setting elements of a PETSc matrix.");
+        }
+      }
+    }
     MatAssemblyBegin(*matrix, MAT_FINAL_ASSEMBLY);
     MatAssemblyEnd(*matrix, MAT_FINAL_ASSEMBLY);
   }
@@ -534,6 +675,10 @@ public:
   // Partially assemble the matrix so you can switch between adding
   // and inserting values
   void partialAssemble() {
+    if (cache) {
+      // Values are only copied to PETSc in assemble()
+      return;
+    }
     MatAssemblyBegin(*matrix, MAT_FLUSH_ASSEMBLY);
     MatAssemblyEnd(*matrix, MAT_FLUSH_ASSEMBLY);
   }
@@ -555,6 +700,8 @@ public:
     PetscMatrix<T> result; // Can't use copy constructor because don't
                            // want to duplicate the matrix
     result.matrix = matrix;
+    result.cache = cache;
+    result.shell = shell;
     result.indexConverter = indexConverter;
     result.pt = pt;
     result.yoffset = std::is_same<T, Field2D>::value ? 0 : yoffset + dir;
@@ -566,9 +713,85 @@ public:
   Mat* get() { return matrix.get(); }
   const Mat* get() const { return matrix.get(); }
 
+  /// True if the sparsity pattern is built once and values are
+  /// cached until assemble()
+  bool hasFixedSparsity() const { return cache != nullptr; }
+
+  /// True if this is a matrix-free operator
+  bool isShell() const { return shell != nullptr; }
+
 private:
+  /// Create a shell matrix, see matrixFree()
+  PetscMatrix(IndexerPtr<T> indConverter, std::function<T(const T&)> function)
+      : matrix(new Mat(), MatrixDeleter()),
+        shell(std::make_shared<ShellContext>(ShellContext{indConverter, function})),
+        indexConverter(indConverter) {
+    const MPI_Comm comm = std::is_same<T, FieldPerp>::value
+                              ? indConverter->getMesh()->getXcomm()
+                              : BoutComm::get();
+    pt = &indConverter->getMesh()->getCoordinates()->getParallelTransform();
+    const int size = indexConverter->size();
+
+    MatCreateShell(comm, size, size, PETSC_DETERMINE, PETSC_DETERMINE, shell.get(),
+                   matrix.get());
+    MatShellSetOperation(*matrix, MATOP_MULT,
+                         reinterpret_cast<void (*)()>(&PetscMatrix<T>::shellMultiply));
+    yoffset = 0;
+    initialised = true;
+  }
+
+  static PetscScalar getCachedValue(const RowCache& rows, PetscInt row, PetscInt col) {
+    const PetscInt local = row - rows.rowStart;
+    if (local < 0 || local >= static_cast<PetscInt>(rows.columns.size())) {
+      return 0.0;
+    }
+    const auto& columns = rows.columns[local];
+    const auto column = std::lower_bound(columns.begin(), columns.end(), col);
+    if (column == columns.end() || *column != col) {
+      return 0.0;
+    }
+    return rows.values[local][std::distance(columns.begin(), column)];
+  }
+
+  static PetscErrorCode shellMultiply(Mat mat, Vec x, Vec y) {
+    PetscFunctionBegin;
+    ShellContext* ctx;
+    MatShellGetContext(mat, reinterpret_cast<void**>(&ctx));
+    const auto& indexer = *ctx->indexConverter;
+    const PetscInt start = indexer.getGlobalStart();
+
+    T input(indexer.getMesh());
+    input = 0.0;
+    const PetscScalar* xdata;
+    VecGetArrayRead(x, &xdata);
+    BOUT_FOR_SERIAL(i, indexer.getRegionAll()) {
+      input[i] = xdata[indexer.getGlobal(i) - start];
+    }
+    VecRestoreArrayRead(x, &xdata);
+
+    // Exceptions can't be passed back through PETSc, so report them
+    // and return an error code
+    T output;
+    try {
+      output = ctx->function(input);
+    } catch (const std::exception& e) {
+      output_error.write("Error in matrix-free PetscMatrix: {:s}\n", e.what());
+      PetscFunctionReturn(PETSC_ERR_LIB);
+    }
+
+    PetscScalar* ydata;
+    VecGetArray(y, &ydata);
+    BOUT_FOR_SERIAL(i, indexer.getRegionAll()) {
+      ydata[indexer.getGlobal(i) - start] = output[i];
+    }
+    VecRestoreArray(y, &ydata);
+    PetscFunctionReturn(0);
+  }
+
   PetscLib lib;
   std::shared_ptr<Mat> matrix = nullptr;
+  std::shared_ptr<RowCache> cache = nullptr;
+  std::shared_ptr<ShellContext> shell = nullptr;
   IndexerPtr<T> indexConverter;
   ParallelTransform* pt;
   int yoffset = 0;
@@ -594,6 +817,8 @@ void swap(PetscVector<T>& first, PetscVector<T>& second) {
 template <class T>
 void swap(PetscMatrix<T>& first, PetscMatrix<T>& second) {
   std::swap(first.matrix, second.matrix);
+  std::swap(first.cache, second.cache);
+  std::swap(first.shell, second.shell);
   std::swap(first.indexConverter, second.indexConverter);
   std::swap(first.pt, second.pt);
   std::swap(first.yoffset, second.yoffset);
@@ -611,7 +836,11 @@ PetscVector<T> operator*(const PetscMatrix<T>& mat, const PetscVector<T>& vec) {
   VecAssemblyBegin(*result);
   VecAssemblyEnd(*result);
   const int err = MatMult(*mat.get(), rhs, *result);
-  ASSERT2(err == 0);
+  if (err != 0) {
+    VecDestroy(result);
+    delete result;
+    throw BoutException("Error in PETSc matrix-vector multiplication");
+  }
   return PetscVector<T>(vec, result);
 }
 
@@ -39,6 +39,7 @@ class PhysicsModel;
 
 #include "solver.hxx"
 #include "bout/bout.hxx"
+#include "bout/async_writer.hxx"
 #include "bout/macro_for_each.hxx"
 #include "bout/msg_stack.hxx"
 #include "bout/options.hxx"
@@ -235,7 +236,15 @@ public:
 
   /// Finish the output for this timestep, verifying all evolving
   /// variables have the correct length
-  void finishOutputTimestep() const;
+  ///
+  /// If writing asynchronously (`output:async`), this hands the
+  /// output for this timestep to the writer thread, first waiting
+  /// for the previous timestep to be written
+  void finishOutputTimestep();
+
+  /// Wait until everything has been written to the output and
+  /// restart files
+  void flushOutput();
 
 protected:
   // The init and rhs functions are implemented by user code to specify problem
@@ -349,9 +358,11 @@ protected:
   /// Helper function for reading from restart_options
   Options& readFromRestartFile(const std::string& name) { return restart_options[name]; }
 
-  /// Write the restart file to disk now
+  /// Write the restart file to disk now, or with the next output
+  /// timestep if writing asynchronously
   void writeRestartFile();
-  /// Write the output file to disk now
+  /// Write the output file to disk now, or with the next output
+  /// timestep if writing asynchronously
   void writeOutputFile();
 
   /*!
@@ -374,6 +385,9 @@ protected:
     PhysicsModelMonitor() = delete;
     PhysicsModelMonitor(PhysicsModel* model) : model(model) {}
     int call(Solver* solver, BoutReal simtime, int iter, int nout) override;
+    /// Wait for any output still being written. Errors from writing
+    /// are logged, not thrown
+    void cleanup() override;
 
   private:
     PhysicsModel* model;
@@ -392,6 +406,9 @@ private:
   bout::OptionsNetCDF restart_file;
   /// Should we write restart files
   bool restart_enabled{true};
+  /// Writes to `output_file` and `restart_file`, possibly from a
+  /// background thread. Must be destroyed before the files
+  bout::AsyncWriter writer;
   /// Split operator model?
   bool splitop{false};
   /// Pointer to user-supplied preconditioner function
@@ -229,8 +229,9 @@ struct SpecificInd {
 
   /// Templated routine to return index.?p(offset), where `?` is one of {x,y,z}
   /// and is determined by the `dir` template argument. The offset corresponds
-  /// to the `dd` template argument.
-  template <int dd, DIRECTION dir>
+  /// to the `dd` template argument. If `zwrap` is false, z offsets
+  /// are assumed not to cross the periodic seam, see zpNoWrap()
+  template <int dd, DIRECTION dir, bool zwrap = true>
   const inline SpecificInd plus() const {
     static_assert(dir == DIRECTION::X || dir == DIRECTION::Y || dir == DIRECTION::Z
                       || dir == DIRECTION::YAligned || dir == DIRECTION::YOrthogonal,
@@ -243,14 +244,15 @@ struct SpecificInd {
     case (DIRECTION::YOrthogonal):
       return yp(dd);
     case (DIRECTION::Z):
-      return zp(dd);
+      return zwrap ? zp(dd) : zpNoWrap(dd);
     }
   }
 
   /// Templated routine to return index.?m(offset), where `?` is one of {x,y,z}
   /// and is determined by the `dir` template argument. The offset corresponds
-  /// to the `dd` template argument.
-  template <int dd, DIRECTION dir>
+  /// to the `dd` template argument. If `zwrap` is false, z offsets
+  /// are assumed not to cross the periodic seam, see zmNoWrap()
+  template <int dd, DIRECTION dir, bool zwrap = true>
   const inline SpecificInd minus() const {
     static_assert(dir == DIRECTION::X || dir == DIRECTION::Y || dir == DIRECTION::Z
                       || dir == DIRECTION::YAligned || dir == DIRECTION::YOrthogonal,
@@ -263,7 +265,7 @@ struct SpecificInd {
     case (DIRECTION::YOrthogonal):
       return ym(dd);
     case (DIRECTION::Z):
-      return zm(dd);
+      return zwrap ? zm(dd) : zmNoWrap(dd);
     }
   }
 
@@ -301,6 +303,20 @@ struct SpecificInd {
     return {(ind) % nz < dz ? ind + nz - dz : ind - dz, ny, nz};
   }
 
+  /// The index \p dz points +z, for points where this doesn't wrap
+  /// around zend. This is a plain offset, so loops using it can
+  /// vectorise. See Region::forZInteriorAndSeam
+  const inline SpecificInd zpNoWrap(int dz = 1) const {
+    ASSERT3(dz >= 0 and z() + dz < nz);
+    return {ind + dz, ny, nz};
+  }
+  /// The index \p dz points -z, for points where this doesn't wrap
+  /// around zstart
+  const inline SpecificInd zmNoWrap(int dz = 1) const {
+    ASSERT3(dz >= 0 and z() - dz >= 0);
+    return {ind - dz, ny, nz};
+  }
+
   // and for 2 cells
   const inline SpecificInd xpp() const { return xp(2); }
   const inline SpecificInd xmm() const { return xm(2); }
@@ -583,6 +599,48 @@ public:
   const ContiguousBlocks& getBlocks() const { return blocks; };
   const RegionIndices& getIndices() const { return indices; };
 
+  /// Loop over the region, calling \p interior for indices which are
+  /// at least \p width points away from the periodic seam in z, and
+  /// \p seam for the rest. Both are called with the index. In the
+  /// interior zpNoWrap() and zmNoWrap() can be used for offsets of up
+  /// to \p width, and the calls are made over unit-stride runs of
+  /// indices marked `omp simd`, so each call must be independent of
+  /// the others. Like BOUT_FOR, the blocks are shared between OpenMP
+  /// threads
+  template <typename InteriorFunc, typename SeamFunc>
+  void forZInteriorAndSeam(int width, const InteriorFunc& interior,
+                           const SeamFunc& seam) const {
+    BOUT_OMP(parallel for schedule(BOUT_OPENMP_SCHEDULE))
+    for (auto block = blocks.cbegin(); block < blocks.cend(); ++block) {
+      const int block_ny = block->first.ny;
+      const int block_nz = block->first.nz;
+      const int last = block->second.ind;
+
+      // Split the block at the ends of each z row, so only one
+      // modulo is needed per row rather than per point
+      int first = block->first.ind;
+      while (first < last) {
+        const int row_start = first - (first % block_nz);
+        const int row_end = std::min(row_start + block_nz, last);
+        const int interior_start = std::min(std::max(row_start + width, first), row_end);
+        const int interior_end =
+            std::min(std::max(row_start + block_nz - width, interior_start), row_end);
+
+        for (int ind = first; ind < interior_start; ++ind) {
+          seam(T{ind, block_ny, block_nz});
+        }
+        BOUT_OMP(simd)
+        for (int ind = interior_start; ind < interior_end; ++ind) {
+          interior(T{ind, block_ny, block_nz});
+        }
+        for (int ind = interior_end; ind < row_end; ++ind) {
+          seam(T{ind, block_ny, block_nz});
+        }
+        first = row_end;
+      }
+    }
+  }
+
   /// Set the indices and ensure blocks updated
   void setIndices(RegionIndices& indicesIn, int maxregionblocksize = MAXREGIONBLOCKSIZE) {
     indices = indicesIn;
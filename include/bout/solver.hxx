@@ -38,6 +38,7 @@
 
 #include "bout/build_config.hxx"
 
+#include "bout/bout_enum_class.hxx"
 #include "bout/bout_types.hxx"
 #include "bout/boutexception.hxx"
 #include "bout/monitor.hxx"
@@ -74,8 +75,10 @@ using TimestepMonitorFunc = int (*)(Solver* solver, BoutReal simtime, BoutReal l
 #include "physicsmodel.hxx"
 #undef BOUT_NO_USING_NAMESPACE_BOUTGLOBALS
 
+#include <functional>
 #include <list>
 #include <string>
+#include <vector>
 
 using SolverType = std::string;
 constexpr auto SOLVERCVODE = "cvode";
@@ -94,6 +97,39 @@ constexpr auto SOLVERRKGENERIC = "rkgeneric";
 
 enum class SOLVER_VAR_OP { LOAD_VARS, LOAD_DERIVS, SET_ID, SAVE_VARS, SAVE_DERIVS };
 
+/// How the evolving variables are arranged in the solver's state vector
+///
+/// - interleaved: all the variables at each point are together. For
+///   each (x, y) point, every 2D variable, then for each z every 3D
+///   variable
+/// - block: each variable is in one contiguous block, in the same
+///   order as in memory, so can be copied in and out in large chunks
+BOUT_ENUM_CLASS(SolverVarLayout, interleaved, block);
+
+/// How the sparsity pattern of a finite difference Jacobian is found
+///
+/// - star: every variable depends on every variable at the same
+///   point and the nearest neighbours in X and Y, and 3D variables on
+///   3D variables at the nearest neighbours in Z
+/// - probe: found by perturbing each variable and calling the RHS
+///   function, see `Solver::probeJacobianPattern`
+BOUT_ENUM_CLASS(JacobianPattern, star, probe);
+
+/// The evolving variables held as separate fields rather than packed
+/// into one array, for solvers that operate on the fields directly
+struct SolverFields {
+  /// The points of each variable which are evolved
+  struct Regions {
+    std::vector<Region<Ind2D>> f2d;
+    std::vector<Region<Ind3D>> f3d;
+  };
+
+  std::vector<Field2D> f2d;
+  std::vector<Field3D> f3d;
+  /// Shared between all copies, as it doesn't change
+  std::shared_ptr<const Regions> regions;
+};
+
 /// A type to set where in the list monitors are added
 enum class MonitorPosition { BACK, FRONT };
 
@@ -493,10 +529,89 @@ protected:
   void save_vars(BoutReal* udata);
   void save_derivs(BoutReal* dudata);
   void set_id(BoutReal* udata);
+  /// Set every point of each variable in \p udata to one value: the
+  /// values for the 2D variables are \p f2d_values, and for the 3D
+  /// variables \p f3d_values. Used for per-variable tolerances and
+  /// constraints
+  void set_field_values(BoutReal* udata, const std::vector<BoutReal>& f2d_values,
+                        const std::vector<BoutReal>& f3d_values);
+
+  /// Create fields to hold the state, with the same shape as the
+  /// evolving variables
+  SolverFields create_solver_fields();
+  /// Versions of the above for state held in fields. These avoid
+  /// copying: the variables are made to share the data of \p u, and
+  /// the time derivatives exchange their data with \p du. The
+  /// variables must not be modified in place by the RHS function,
+  /// and `release_vars` must be called before \p u is changed
+  ///
+  /// Preconditioners and Jacobians can modify the time derivatives in
+  /// place, so `load_derivs` copies the data
+  void load_vars(const SolverFields& u);
+  void load_derivs(const SolverFields& du);
+  void save_vars(SolverFields& u);
+  void save_derivs(SolverFields& du);
+  void set_id(SolverFields& u);
+  void set_field_values(SolverFields& u, const std::vector<BoutReal>& f2d_values,
+                        const std::vector<BoutReal>& f3d_values);
+  /// Stop the variables sharing data with the state passed to
+  /// `load_vars`, leaving them unallocated
+  void release_vars();
 
   /// Returns a Field3D containing the global indices
+  ///
+  /// This is the index of the first variable at each point, with the
+  /// other variables at that point following it. Only valid for the
+  /// interleaved layout
   Field3D globalIndex(int localStart);
 
+  /// How the variables are arranged in the state vector
+  SolverVarLayout getVarLayout() const { return var_layout; }
+
+  /// A block of non-zero entries in the Jacobian: the time derivative
+  /// of variable `row` depends on variable `column` at the point
+  /// offset by (`x`, `y`, `z`). Variables are numbered as at each
+  /// point of the interleaved state vector: the 2D variables, then
+  /// the 3D variables
+  struct JacobianCoupling {
+    int row;
+    int column;
+    int x, y, z;
+    /// Depends on `column` at every point in Z (`row` is a 2D
+    /// variable and `column` a 3D variable)
+    bool all_z;
+  };
+
+  /// The nearest neighbour star pattern, see `JacobianPattern`
+  std::vector<JacobianCoupling> starJacobianPattern() const;
+
+  /// Find the couplings by perturbing each variable in turn on a
+  /// lattice of points and calling \p rhs, which should calculate the
+  /// time derivatives of the evolving variables from their current
+  /// values. This takes one call to \p rhs per variable, plus two.
+  ///
+  /// Offsets are found up to \p width points away in each direction
+  /// (limited by the number of guard cells in X and Y). A warning is
+  /// printed if couplings are found further away, as wider ones may
+  /// be missing. Dependencies which happen to be zero for the current
+  /// state are not found, so the diagonal is always included
+  std::vector<JacobianCoupling> probeJacobianPattern(const std::function<void()>& rhs,
+                                                     int width);
+
+  /// Get the pattern chosen by the `jacobian_pattern` option, using
+  /// \p rhs if it is probed
+  std::vector<JacobianCoupling> getJacobianPattern(const std::function<void()>& rhs);
+
+  /// Call \p function(row, columns) for each row of the Jacobian in
+  /// the bulk of the domain, with the sorted column indices of the
+  /// non-zero entries in \p pattern. \p index is the result of
+  /// `globalIndex`, communicated so that the guard cells hold the
+  /// indices on neighbouring processors
+  void forEachJacobianRow(
+      const std::vector<JacobianCoupling>& pattern, const Field3D& index,
+      const std::function<void(int row, const std::vector<int>& columns)>& function)
+      const;
+
   /// Maximum internal timestep
   BoutReal max_dt{-1.0};
 
@@ -524,6 +639,10 @@ protected:
   BoutReal getOutputTimestep() const { return output_timestep; }
 
 private:
+  /// Convert vector time derivatives to the right basis, and check
+  /// their locations, before saving them
+  void prepare_save_derivs();
+
   /// Generate a random UUID (version 4) and broadcast it to all processors
   std::string createRunID() const;
 
@@ -542,6 +661,9 @@ private:
   /// Current iteration (output time-step) number
   int iteration{0};
 
+  /// Number of evolving values on this processor, cached by getLocalN
+  int cached_local_N{-1};
+
   /// Number of calls to the RHS function
   int rhs_ncalls{0};
   /// Number of calls to the explicit (convective) RHS function
@@ -576,9 +698,15 @@ private:
   /// Should be run after user RHS is called
   void post_rhs(BoutReal t);
 
+  /// How the variables are arranged in the state vector
+  SolverVarLayout var_layout{SolverVarLayout::interleaved};
+
   /// Loading data from BOUT++ to/from solver
   void loop_vars_op(Ind2D i2d, BoutReal* udata, int& p, SOLVER_VAR_OP op, bool bndry);
   void loop_vars(BoutReal* udata, SOLVER_VAR_OP op);
+  /// Perform \p op on variable \p f for the block layout
+  template <class T>
+  void loop_var_block(const VarStr<T>& f, BoutReal* udata, int& p, SOLVER_VAR_OP op);
 
   /// Check if a variable has already been added
   bool varAdded(const std::string& name);
@@ -37,8 +37,11 @@ struct stencil {
   BoutReal mm = BoutNaN, m = BoutNaN, c = BoutNaN, p = BoutNaN, pp = BoutNaN;
 };
 
+/// Fill \p s with the values of \p f around \p i. If \p zwrap is
+/// false, the stencil must not cross the periodic seam in z, so that
+/// the offsets are plain index arithmetic
 template <DIRECTION direction, STAGGER stagger = STAGGER::None, int nGuard = 1,
-          typename FieldType>
+          typename FieldType, bool zwrap = true>
 void inline populateStencil(stencil& s, const FieldType& f,
                             const typename FieldType::ind_type i) {
   static_assert(nGuard == 1 || nGuard == 2,
@@ -48,69 +51,69 @@ void inline populateStencil(stencil& s, const FieldType& f,
   case (STAGGER::None):
     if (nGuard == 2) {
       if (direction == DIRECTION::YOrthogonal) {
-        s.mm = f.ynext(-2)[i.template minus<2, direction>()];
+        s.mm = f.ynext(-2)[i.template minus<2, direction, zwrap>()];
       } else {
-        s.mm = f[i.template minus<2, direction>()];
+        s.mm = f[i.template minus<2, direction, zwrap>()];
       }
     }
     if (direction == DIRECTION::YOrthogonal) {
-      s.m = f.ynext(-1)[i.template minus<1, direction>()];
+      s.m = f.ynext(-1)[i.template minus<1, direction, zwrap>()];
     } else {
-      s.m = f[i.template minus<1, direction>()];
+      s.m = f[i.template minus<1, direction, zwrap>()];
     }
     s.c = f[i];
     if (direction == DIRECTION::YOrthogonal) {
-      s.p = f.ynext(1)[i.template plus<1, direction>()];
+      s.p = f.ynext(1)[i.template plus<1, direction, zwrap>()];
     } else {
-      s.p = f[i.template plus<1, direction>()];
+      s.p = f[i.template plus<1, direction, zwrap>()];
     }
     if (nGuard == 2) {
       if (direction == DIRECTION::YOrthogonal) {
-        s.pp = f.ynext(2)[i.template plus<2, direction>()];
+        s.pp = f.ynext(2)[i.template plus<2, direction, zwrap>()];
       } else {
-        s.pp = f[i.template plus<2, direction>()];
+        s.pp = f[i.template plus<2, direction, zwrap>()];
       }
     }
     break;
   case (STAGGER::C2L):
     if (nGuard == 2) {
       if (direction == DIRECTION::YOrthogonal) {
-        s.mm = f.ynext(-2)[i.template minus<2, direction>()];
+        s.mm = f.ynext(-2)[i.template minus<2, direction, zwrap>()];
       } else {
-        s.mm = f[i.template minus<2, direction>()];
+        s.mm = f[i.template minus<2, direction, zwrap>()];
       }
     }
     if (direction == DIRECTION::YOrthogonal) {
-      s.m = f.ynext(-1)[i.template minus<1, direction>()];
+      s.m = f.ynext(-1)[i.template minus<1, direction, zwrap>()];
     } else {
-      s.m = f[i.template minus<1, direction>()];
+      s.m = f[i.template minus<1, direction, zwrap>()];
     }
     s.c = f[i];
     s.p = s.c;
     if (direction == DIRECTION::YOrthogonal) {
-      s.pp = f.ynext(1)[i.template plus<1, direction>()];
+      s.pp = f.ynext(1)[i.template plus<1, direction, zwrap>()];
     } else {
-      s.pp = f[i.template plus<1, direction>()];
+      s.pp = f[i.template plus<1, direction, zwrap>()];
     }
     break;
   case (STAGGER::L2C):
     if (direction == DIRECTION::YOrthogonal) {
-      s.mm = f.ynext(-1)[i.template minus<1, direction>()];
+      s.mm = f.ynext(-1)[i.template minus<1, direction, zwrap>()];
     } else {
-      s.mm = f[i.template minus<1, direction>()];
+      s.mm = f[i.template minus<1, direction, zwrap>()];
     }
     s.m = f[i];
     s.c = s.m;
     if (direction == DIRECTION::YOrthogonal) {
-      s.p = f.ynext(1)[i.template plus<1, direction>()];
+      s.p = f.ynext(1)[i.template plus<1, direction, zwrap>()];
     } else {
-      s.p = f[i.template plus<1, direction>()];
+      s.p = f[i.template plus<1, direction, zwrap>()];
     }
     if (nGuard == 2) {
       if (direction == DIRECTION::YOrthogonal) {
-        s.pp = f.ynext(2)[i.template plus<2, direction>()];
+        s.pp = f.ynext(2)[i.template plus<2, direction, zwrap>()];
       } else {
-        s.pp = f[i.template plus<2, direction>()];
+        s.pp = f[i.template plus<2, direction, zwrap>()];
       }
     }
     break;
@@ -119,10 +122,10 @@ void inline populateStencil(stencil& s, const FieldType& f,
 }
 
 template <DIRECTION direction, STAGGER stagger = STAGGER::None, int nGuard = 1,
-          typename FieldType>
+          typename FieldType, bool zwrap = true>
 stencil inline populateStencil(const FieldType& f, const typename FieldType::ind_type i) {
   stencil s;
-  populateStencil<direction, stagger, nGuard, FieldType>(s, f, i);
+  populateStencil<direction, stagger, nGuard, FieldType, zwrap>(s, f, i);
   return s;
 }
 #endif /* __STENCILS_H__ */
@@ -33,8 +33,10 @@
 
 #if SUNDIALS_VERSION_MAJOR < 6
 using sundials_real_type = realtype;
+using sundials_bool_type = booleantype;
 #else
 using sundials_real_type = sunrealtype;
+using sundials_bool_type = sunbooleantype;
 #endif
 
 static_assert(std::is_same<BoutReal, sundials_real_type>::value,
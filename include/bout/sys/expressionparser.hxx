@@ -42,6 +42,7 @@
 #include <utility>
 
 #include "generator_context.hxx"
+#include "generator_program.hxx"
 
 class FieldGenerator;
 using FieldGeneratorPtr = std::shared_ptr<FieldGenerator>;
@@ -68,7 +69,9 @@ public:
   [[deprecated("This will be removed in a future version. Implementations should "
                "override the Context version of this function.")]] virtual double
   generate(BoutReal x, BoutReal y, BoutReal z, BoutReal t) {
-    return generate(bout::generator::Context().set("x", x, "y", y, "z", z, "t", t));
+    using bout::generator::Context;
+    return generate(Context().set(Context::x_slot, x, Context::y_slot, y, Context::z_slot,
+                                  z, Context::t_slot, t));
   }
 
   /// Generate a value at the given coordinates (x,y,z,t)
@@ -81,6 +84,12 @@ public:
   /// this function will be made pure virtual.
   virtual double generate(const bout::generator::Context& ctx);
 
+  /// Add the operations which evaluate this generator over a column
+  /// of points to \p program, returning the register which holds the
+  /// result. The default calls generate() at each point. Generators
+  /// which change the context of their arguments must use the default
+  virtual int compile(bout::generator::Program& program);
+
   /// Create a string representation of the generator, for debugging output
   virtual std::string str() const { return std::string("?"); }
 };
@@ -211,6 +220,7 @@ public:
       : lhs(std::move(l)), rhs(std::move(r)), op(o) {}
   FieldGeneratorPtr clone(const std::list<FieldGeneratorPtr> args) override;
   double generate(const bout::generator::Context& context) override;
+  int compile(bout::generator::Program& program) override;
 
   std::string str() const override {
     return std::string("(") + lhs->str() + std::string(1, op) + rhs->str()
@@ -232,6 +242,9 @@ public:
   }
 
   double generate(const bout::generator::Context&) override { return value; }
+  int compile(bout::generator::Program& program) override {
+    return program.addConstant(value);
+  }
   std::string str() const override {
     std::stringstream ss;
     ss << value;
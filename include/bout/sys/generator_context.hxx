@@ -6,6 +6,8 @@
 class BoundaryRegion;
 class Mesh;
 
+#include <array>
+#include <cstdint>
 #include <map>
 #include <string>
 
@@ -39,28 +41,78 @@ public:
   Context(const BoundaryRegion* bndry, CELL_LOC loc, BoutReal t, Mesh* msh)
       : Context(bndry, 0, loc, t, msh){};
 
-  BoutReal x() const { return get("x"); }
-  BoutReal y() const { return get("y"); }
-  BoutReal z() const { return get("z"); }
-  BoutReal t() const { return get("t"); }
+  /// Parameters are stored in numbered slots. Each name is given a
+  /// slot the first time it is seen, and keeps it for the whole run,
+  /// so generators can look up slots when they are parsed, and avoid
+  /// string comparisons when they are evaluated.
+  ///
+  /// The first inline_slots slots, including x, y, z and t, are held
+  /// in the Context itself. Any further slots are kept in a map, so
+  /// there is no limit on the number of names
+  static constexpr int inline_slots = 32;
+
+  /// Slots of the coordinates and time
+  static constexpr int x_slot = 0;
+  static constexpr int y_slot = 1;
+  static constexpr int z_slot = 2;
+  static constexpr int t_slot = 3;
+
+  /// The slot holding parameter \p name, adding one if needed
+  static int slot(const std::string& name);
+
+  /// The name of the parameter held in \p slot
+  static std::string slotName(int slot);
+
+  BoutReal x() const { return values[x_slot]; }
+  BoutReal y() const { return values[y_slot]; }
+  BoutReal z() const { return values[z_slot]; }
+  BoutReal t() const { return values[t_slot]; }
+
+  /// Set the value of a parameter in a given slot
+  Context& set(int slot, BoutReal value) {
+    ASSERT2(slot >= 0);
+    if (slot >= inline_slots) {
+      extra_values[slot] = value;
+      return *this;
+    }
+    values[slot] = value;
+    is_set |= slot_bit(slot);
+    return *this;
+  }
 
   /// Set the value of a parameter with given name
   Context& set(const std::string& name, BoutReal value) {
-    parameters[name] = value;
-    return *this;
+    return set(slot(name), value);
   }
 
-  /// Set multiple values, by passing alternating strings and values
+  /// Set multiple values, by passing alternating slots or strings and values
   ///
   /// eg. set("x", 1, "y", 2)
   template <typename... Args>
+  Context& set(int slot, BoutReal value, Args... args) {
+    set(slot, value);
+    return set(args...);
+  }
+  template <typename... Args>
   Context& set(const std::string& name, BoutReal value, Args... args) {
     set(name, value);
     return set(args...);
   }
 
+  /// Retrieve a value previously set in \p slot
+  BoutReal get(int slot) const {
+    ASSERT2(slot >= 0);
+    if (slot >= inline_slots) {
+      return getExtra(slot);
+    }
+    if ((is_set & slot_bit(slot)) == 0) {
+      throwNotSet(slot);
+    }
+    return values[slot];
+  }
+
   /// Retrieve a value previously set
-  BoutReal get(const std::string& name) const { return parameters.at(name); }
+  BoutReal get(const std::string& name) const;
 
   /// Get the mesh for this context (position)
   /// If the mesh is null this will throw a BoutException (if CHECK >= 1)
@@ -72,9 +124,22 @@ public:
 private:
   Mesh* localmesh{nullptr}; ///< The mesh on which the position is defined
 
-  /// Contains user-set values which can be set and retrieved
-  std::map<std::string, BoutReal> parameters{
-      {"x", 0.0}, {"y", 0.0}, {"z", 0.0}, {"t", 0.0}};
+  /// Values of the parameters in the first inline_slots slots
+  std::array<BoutReal, inline_slots> values{};
+
+  /// Bit i is set if slot i has a value. x, y, z and t always do
+  std::uint32_t is_set{0xf};
+
+  /// Values of the parameters in later slots, if any are set
+  std::map<int, BoutReal> extra_values;
+
+  BoutReal getExtra(int slot) const;
+
+  static constexpr std::uint32_t slot_bit(int slot) {
+    return std::uint32_t{1} << static_cast<unsigned>(slot);
+  }
+
+  [[noreturn]] static void throwNotSet(int slot);
 };
 
 } // namespace generator
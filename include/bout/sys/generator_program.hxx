@@ -0,0 +1,129 @@
+#pragma once
+
+#include "bout/bout_types.hxx"
+#include "bout/sys/generator_context.hxx"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+class FieldGenerator;
+using FieldGeneratorPtr = std::shared_ptr<FieldGenerator>;
+
+namespace bout {
+namespace generator {
+
+/// A tree of FieldGenerators flattened into a list of operations on
+/// columns of points, for example all the z points at one (x, y).
+/// Each operation is a loop over the whole column, so the tree is
+/// walked once per column rather than once per point, and the
+/// arithmetic can vectorise.
+///
+/// Generators take part by overriding FieldGenerator::compile, which
+/// adds their operations and returns the register holding their
+/// result. The default compile() adds an operation which calls
+/// generate() at each point, so any tree of generators can be used.
+///
+///     Program program(generator);
+///     Program::Workspace workspace(program, nz);
+///     program.evaluate(workspace, nz, x, y, z, t, result, context);
+class Program {
+public:
+  using UnaryFunction = BoutReal (*)(BoutReal);
+  using BinaryFunction = BoutReal (*)(BoutReal, BoutReal);
+
+  /// Registers which hold the coordinates of each point and the time
+  static constexpr int x_register = 0;
+  static constexpr int y_register = 1;
+  static constexpr int z_register = 2;
+  static constexpr int t_register = 3;
+
+  /// Compile \p generator. The Program shares ownership of it
+  explicit Program(FieldGeneratorPtr generator);
+
+  /// Functions for FieldGenerator::compile. Each adds an operation,
+  /// and returns the register which will hold its result
+
+  /// A constant value
+  int addConstant(BoutReal value);
+  /// A value which is read through \p value at each evaluation
+  int addValuePointer(const BoutReal* value);
+  /// One of the arithmetic operators '+', '-', '*', '/' or '^'
+  int addOperator(char op, int lhs, int rhs);
+  /// Apply \p function to each point
+  int addFunction(UnaryFunction function, int arg);
+  int addFunction(BinaryFunction function, int arg1, int arg2);
+  /// The minimum or maximum of two registers
+  int addMin(int lhs, int rhs);
+  int addMax(int lhs, int rhs);
+  /// Call generator.generate() at each point
+  int addGeneric(FieldGenerator& generator);
+
+  /// Number of registers, including the coordinates
+  int numRegisters() const { return num_registers; }
+
+  /// Number of operations which evaluate a generator point by point
+  int numGeneric() const;
+
+  /// Scratch space for the registers. Each thread evaluating the
+  /// same Program needs its own Workspace
+  class Workspace {
+  public:
+    /// Space for columns of up to \p max_points points
+    Workspace(const Program& program, int max_points)
+        : max_points(max_points),
+          data(static_cast<std::size_t>(program.numRegisters()) * max_points) {}
+
+  private:
+    friend class Program;
+    int max_points;
+    std::vector<BoutReal> data;
+  };
+
+  /// Evaluate at \p n points, with coordinates \p x, \p y and \p z
+  /// and time \p t, putting the values in \p result. Generators
+  /// which aren't compiled are called with \p context(i), the full
+  /// context of point i
+  void evaluate(Workspace& workspace, int n, const BoutReal* x, const BoutReal* y,
+                const BoutReal* z, BoutReal t, BoutReal* result,
+                const std::function<Context(int)>& context) const;
+
+private:
+  enum class OpCode {
+    constant,
+    value_pointer,
+    add,
+    subtract,
+    multiply,
+    divide,
+    power,
+    min,
+    max,
+    unary,
+    binary,
+    generic
+  };
+
+  struct Instruction {
+    OpCode code;
+    int result;
+    int arg1{-1};
+    int arg2{-1};
+    BoutReal value{0.0};
+    const BoutReal* value_pointer{nullptr};
+    UnaryFunction unary{nullptr};
+    BinaryFunction binary{nullptr};
+    FieldGenerator* generator{nullptr};
+  };
+
+  int addInstruction(Instruction instruction);
+
+  /// Keeps the generators used by generic operations alive
+  FieldGeneratorPtr root;
+  std::vector<Instruction> instructions;
+  int num_registers{4};
+  int result_register{0};
+};
+
+} // namespace generator
+} // namespace bout
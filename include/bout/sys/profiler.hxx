@@ -0,0 +1,134 @@
+#ifndef BOUT_PROFILER_H
+#define BOUT_PROFILER_H
+
+#include <cstdint>
+#include <string>
+
+#include "bout/msg_stack.hxx"
+
+class Options;
+
+namespace bout {
+
+/*!
+ * Built-in hierarchical profiler
+ *
+ * Regions are opened with a ProfileRegion object (or the
+ * BOUT_PROFILE_REGION macro), and closed when it goes out of
+ * scope. Regions nest, so the same name can appear under several
+ * parents, and each thread keeps its own tree of regions. Every
+ * `Timer` also opens a region with its label, so the usual "rhs",
+ * "invert", "comms" and "io" buckets appear in the tree.
+ *
+ *     void someFunction() {
+ *       BOUT_PROFILE_REGION("someFunction");
+ *       ...
+ *       Profiler::addFlops(10 * n); // Counted in "someFunction"
+ *     }
+ *
+ * The profiler is disabled by default, in which case a region costs
+ * a single branch. It is configured from the "profiler" section of
+ * the input options:
+ *
+ *  - `enabled`: switch the profiler on
+ *  - `trace`: also record every region as a Chrome trace event. This
+ *    is off by default, here and in setEnabled()
+ *  - `max_trace_events`: limit on the number of events per thread,
+ *    100000 by default
+ *
+ * At each output the times, byte and flop counts of every region are
+ * reduced across processors and written to the output file, see
+ * outputVars(). At the end of the run each processor writes
+ * `BOUT.profile.<rank>.json` to the data directory, which can be
+ * loaded into chrome://tracing or Perfetto.
+ */
+class Profiler {
+public:
+  /// Is the profiler recording?
+  static bool enabled() { return is_enabled; }
+
+  /// Switch the profiler on or off, and trace events with it if
+  /// \p trace is true. Regions which are open when this is called
+  /// are not affected
+  static void setEnabled(bool enable, bool trace = false);
+
+  /// Set up the profiler from the "profiler" section of the options
+  static void configure(Options& options);
+
+  /// Open a region nested in the current region of this thread
+  static void enter(const std::string& name);
+
+  /// Close the current region of this thread
+  static void leave();
+
+  /// Add to the number of bytes moved by the current region
+  static void addBytes(std::uint64_t bytes);
+
+  /// Add to the number of floating-point operations of the current region
+  static void addFlops(std::uint64_t flops);
+
+  /// Total time in seconds spent in a region on this processor,
+  /// summed over threads. Nested regions are given by their path,
+  /// with names separated by "/", e.g. "run/rhs/comms"
+  static double getTime(const std::string& path);
+
+  /// Number of times a region was entered on this processor
+  static std::uint64_t getCalls(const std::string& path);
+
+  /// Number of bytes counted in a region on this processor
+  static std::uint64_t getBytes(const std::string& path);
+
+  /// Number of floating-point operations counted in a region on this processor
+  static std::uint64_t getFlops(const std::string& path);
+
+  /// Add the minimum, maximum and mean over processors of the time,
+  /// bytes and flops of each region to \p output_options. Names are
+  /// "profile_" followed by the path with "/" replaced by ".". This
+  /// is collective over BoutComm
+  static void outputVars(Options& output_options);
+
+  /// Print a tree of the regions on this processor to `output`
+  static void printReport();
+
+  /// Write the regions and trace events of this processor to
+  /// \p filename as a Chrome trace JSON file
+  static void writeTrace(const std::string& filename);
+
+  /// Remove all regions and switch the profiler off
+  static void cleanup();
+
+private:
+  static bool is_enabled;
+};
+
+/// Profile the enclosing scope as a region called \p name
+class ProfileRegion {
+public:
+  explicit ProfileRegion(const char* name) : active(Profiler::enabled()) {
+    if (active) {
+      Profiler::enter(name);
+    }
+  }
+  explicit ProfileRegion(const std::string& name) : active(Profiler::enabled()) {
+    if (active) {
+      Profiler::enter(name);
+    }
+  }
+  ProfileRegion(const ProfileRegion&) = delete;
+  ProfileRegion& operator=(const ProfileRegion&) = delete;
+  ~ProfileRegion() {
+    if (active) {
+      Profiler::leave();
+    }
+  }
+
+private:
+  bool active;
+};
+
+} // namespace bout
+
+#define BOUT_PROFILE_REGION(name) \
+  bout::ProfileRegion CONCATENATE(profile_region_, __LINE__)(name)
+
+#endif // BOUT_PROFILER_H
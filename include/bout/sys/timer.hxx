@@ -28,6 +28,9 @@
  * To reset the timer, use resetTime
  *
  *     Timer::resetTime("test"); // Timer reset to zero, returning time as double
+ *
+ * When bout::Profiler is enabled, a named Timer also opens a profiler
+ * region with the same label
  */
 class Timer {
 public:
@@ -112,6 +115,9 @@ private:
   /// The current timing information
   timer_info& timing;
 
+  /// Did this timer open a region in bout::Profiler?
+  bool profiled{false};
+
   /// Get the elapsed time in seconds for timing info
   static double getTime(const timer_info& info);
 
@@ -0,0 +1,90 @@
+/// \file z_transpose.hxx
+///
+/// Operations on complete lines in Z, for when Z may be split
+/// between processors
+
+#ifndef BOUT_Z_TRANSPOSE_H
+#define BOUT_Z_TRANSPOSE_H
+
+#include "bout/bout_types.hxx"
+#include "bout/dcomplex.hxx"
+#include "bout/region.hxx"
+#include "bout/utils.hxx"
+
+#include <functional>
+#include <vector>
+
+class Field3D;
+class Mesh;
+
+namespace bout {
+
+/// Function applied to one line in Z by forEachZLine. \p in and \p
+/// out each hold Mesh::GlobalNz values in global Z order, and may be
+/// the same array. \p modes is working space for the Mesh::GlobalNz /
+/// 2 + 1 Fourier modes of a line, which is private to the calling
+/// thread and reused between calls, so needn't be allocated per line
+using ZLineFunction = std::function<void(Ind2D, const BoutReal* in, BoutReal* out,
+                                         dcomplex* modes)>;
+
+/// Call \p function for the complete line in Z of \p f at each point
+/// of \p region, putting the results in the same points of \p result.
+/// Only Z points between zstart and zend are set in \p result.
+///
+/// If Z is split between processors, the lines are first transposed
+/// so that each processor in the Z communicator holds complete lines
+/// for a share of the points in \p region, and the results are
+/// transposed back afterwards. All the processors in the Z
+/// communicator must call this together, with the same \p region.
+///
+/// Otherwise \p function is called directly on the data of \p f and
+/// \p result, in parallel if OpenMP is enabled
+void forEachZLine(const Field3D& f, Field3D& result, const Region<Ind2D>& region,
+                  const ZLineFunction& function);
+
+/// Fourier transforms in Z of a set of lines, with the modes shared
+/// between the processors in the Z communicator, for the FFT-based
+/// solvers which solve an independent system for each mode.
+///
+/// If Z is split between processors, forward() transposes the lines
+/// so that each processor holds complete lines for a share of them,
+/// transforms those, and transposes the modes so that each processor
+/// holds modes firstMode() to firstMode() + localModes() - 1 of every
+/// line. backward() reverses this. All the processors in the Z
+/// communicator must call these together, with the same number of
+/// lines.
+///
+/// Otherwise no communication is needed, and each processor holds
+/// all the modes
+class ZFourierTranspose {
+public:
+  /// Transform lines of \p mesh, keeping the first \p nmode modes
+  ZFourierTranspose(Mesh* mesh, int nmode);
+
+  /// Index of the first mode held on this processor
+  int firstMode() const { return modeStart(zproc); }
+  /// Number of modes held on this processor
+  int localModes() const { return modeStart(zproc + 1) - modeStart(zproc); }
+
+  /// Transform \p lines, each of which points to the values between
+  /// zstart and zend of one line. Row i of the result holds modes
+  /// firstMode() onwards of line i
+  Matrix<dcomplex> forward(const std::vector<const BoutReal*>& lines) const;
+
+  /// Inverse of forward(): transform \p modes back into the values
+  /// between zstart and zend of each of \p lines. Modes from \p
+  /// nmode upwards are set to zero
+  void backward(const Matrix<dcomplex>& modes, const std::vector<BoutReal*>& lines) const;
+
+private:
+  Mesh* mesh;
+  int nmode;
+  int nzpe, zproc;
+
+  /// First mode held on Z processor \p p
+  int modeStart(int p) const { return (nmode * p) / nzpe; }
+};
+
+} // namespace bout
+
+#endif // BOUT_Z_TRANSPOSE_H
@@ -52,6 +52,7 @@ const char DEFAULT_DIR[] = "data";
 #include "bout/rkscheme.hxx"
 #include "bout/slepclib.hxx"
 #include "bout/solver.hxx"
+#include "bout/sys/profiler.hxx"
 #include "bout/sys/timer.hxx"
 #include "bout/version.hxx"
 
@@ -196,6 +197,8 @@ int BoutInitialise(int& argc, char**& argv) {
 
     bout::globals::mpi = new MpiWrapper();
 
+    bout::Profiler::configure(Options::root()["profiler"]);
+
     // Create the mesh
     bout::globals::mesh = Mesh::create();
     // Load from sources. Required for Field initialisation
@@ -751,6 +754,18 @@ int BoutFinalise(bool write_settings) {
     output.write("\n");
   }
 
+  if (bout::Profiler::enabled()) {
+    bout::Profiler::printReport();
+    try {
+      const auto data_dir =
+          Options::root()["datadir"].withDefault(std::string{DEFAULT_DIR});
+      bout::Profiler::writeTrace(
+          fmt::format("{}/BOUT.profile.{}.json", data_dir, BoutComm::rank()));
+    } catch (const BoutException& e) {
+      output_error << _("Error whilst writing profile") << e.what() << endl;
+    }
+  }
+
   // Delete the mesh
   delete bout::globals::mesh;
 
@@ -774,6 +789,7 @@ int BoutFinalise(bool write_settings) {
 
   // Cleanup timer
   Timer::cleanup();
+  bout::Profiler::cleanup();
 
   // Options tree
   Options::cleanup();
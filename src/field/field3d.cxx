@@ -44,6 +44,7 @@
 #include <bout/msg_stack.hxx>
 #include <bout/output.hxx>
 #include <bout/utils.hxx>
+#include <bout/z_transpose.hxx>
 
 /// Constructor
 Field3D::Field3D(Mesh* localmesh, CELL_LOC location_in, DirectionTypes directions_in)
@@ -606,7 +607,8 @@ Field3D filter(const Field3D& var, int N0, const std::string& rgn) {
 
   checkData(var);
 
-  int ncz = var.getNz();
+  // Z may be split between processors, so use the global number of points
+  const int ncz = var.getMesh()->GlobalNz;
 
   Field3D result{emptyFrom(var)};
 
@@ -618,25 +620,22 @@ Field3D filter(const Field3D& var, int N0, const std::string& rgn) {
 
   const Region<Ind2D>& region = var.getRegion2D(region_str);
 
-  BOUT_OMP(parallel)
-  {
-    Array<dcomplex> f(ncz / 2 + 1);
+  bout::forEachZLine(var, result, region,
+                     [&](Ind2D UNUSED(i), const BoutReal* in, BoutReal* out,
+                         dcomplex* f) {
+                       // Forward FFT
+                       rfft(in, ncz, f);
 
-    BOUT_FOR_INNER(i, region) {
-      // Forward FFT
-      rfft(var(i.x(), i.y()), ncz, f.begin());
+                       for (int jz = 0; jz <= ncz / 2; jz++) {
+                         if (jz != N0) {
+                           // Zero this component
+                           f[jz] = 0.0;
+                         }
+                       }
 
-      for (int jz = 0; jz <= ncz / 2; jz++) {
-        if (jz != N0) {
-          // Zero this component
-          f[jz] = 0.0;
-        }
-      }
-
-      // Reverse FFT
-      irfft(f.begin(), ncz, result(i.x(), i.y()));
-    }
-  }
+                       // Reverse FFT
+                       irfft(f, ncz, out);
+                     });
 
 #if BOUT_USE_TRACK
   result.name = "filter(" + var.name + ")";
@@ -651,7 +650,7 @@ Field3D lowPass(const Field3D& var, int zmax, bool keep_zonal, const std::string
   TRACE("lowPass(Field3D, {}, {})", zmax, keep_zonal);
 
   checkData(var);
-  int ncz = var.getNz();
+  const int ncz = var.getMesh()->GlobalNz;
 
   if (((zmax >= ncz / 2) || (zmax < 0)) && keep_zonal) {
     // Removing nothing
@@ -668,27 +667,24 @@ Field3D lowPass(const Field3D& var, int zmax, bool keep_zonal, const std::string
 
   const Region<Ind2D>& region = var.getRegion2D(region_str);
 
-  BOUT_OMP(parallel)
-  {
-    Array<dcomplex> f(ncz / 2 + 1);
-
-    BOUT_FOR_INNER(i, region) {
-      // Take FFT in the Z direction
-      rfft(var(i.x(), i.y()), ncz, f.begin());
-
-      // Filter in z
-      for (int jz = zmax + 1; jz <= ncz / 2; jz++) {
-        f[jz] = 0.0;
-      }
-
-      // Filter zonal mode
-      if (!keep_zonal) {
-        f[0] = 0.0;
-      }
-      // Reverse FFT
-      irfft(f.begin(), ncz, result(i.x(), i.y()));
-    }
-  }
+  bout::forEachZLine(var, result, region,
+                     [&](Ind2D UNUSED(i), const BoutReal* in, BoutReal* out,
+                         dcomplex* f) {
+                       // Take FFT in the Z direction
+                       rfft(in, ncz, f);
+
+                       // Filter in z
+                       for (int jz = zmax + 1; jz <= ncz / 2; jz++) {
+                         f[jz] = 0.0;
+                       }
+
+                       // Filter zonal mode
+                       if (!keep_zonal) {
+                         f[0] = 0.0;
+                       }
+                       // Reverse FFT
+                       irfft(f, ncz, out);
+                     });
 
   checkData(result);
   return result;
@@ -707,6 +703,10 @@ void shiftZ(Field3D& var, int jx, int jy, double zangle) {
   if (ncz == 1) {
     return; // Shifting doesn't do anything
   }
+  if (localmesh->getNZPE() > 1) {
+    throw BoutException("Can't shift a single line in Z when Z is split between "
+                        "processors (NZPE > 1)");
+  }
 
   Array<dcomplex> v(ncz / 2 + 1);
 
@@ -775,12 +775,25 @@ Field2D DC(const Field3D& f, const std::string& rgn) {
   Field2D result(localmesh, f.getLocation());
   result.allocate();
 
-  BOUT_FOR(i, result.getRegion(rgn)) {
+  const auto& region = result.getRegion(rgn);
+
+  BOUT_FOR(i, region) {
     result[i] = 0.0;
-    for (int k = 0; k < localmesh->LocalNz; k++) {
+    for (int k = localmesh->zstart; k <= localmesh->zend; k++) {
       result[i] += f[localmesh->ind2Dto3D(i, k)];
     }
-    result[i] /= (localmesh->LocalNz);
+    result[i] /= (localmesh->GlobalNz);
+  }
+
+  if (localmesh->getNZPE() > 1) {
+    // Add the parts of the average from the other processors in Z
+    Array<BoutReal> average(static_cast<int>(region.size()));
+    int n = 0;
+    BOUT_FOR_SERIAL(i, region) { average[n++] = result[i]; }
+    localmesh->getMpi().MPI_Allreduce(MPI_IN_PLACE, average.begin(), average.size(),
+                                      MPI_DOUBLE, MPI_SUM, localmesh->getZcomm());
+    n = 0;
+    BOUT_FOR_SERIAL(i, region) { result[i] = average[n++]; }
   }
 
   checkData(result);
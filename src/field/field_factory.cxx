@@ -23,7 +23,9 @@
 
 #include <bout/field_factory.hxx>
 
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
 #include <bout/constants.hxx>
 #include <bout/output.hxx>
@@ -96,6 +98,11 @@ FieldFactory::FieldFactory(Mesh* localmesh, Options* opt)
   transform_from_field_aligned =
       nonconst_options["input"]["transform_from_field_aligned"].withDefault(true);
 
+  compile_expressions =
+      nonconst_options["input"]["compile_expressions"]
+          .doc("Evaluate 3D expressions a z column at a time, rather than point by point")
+          .withDefault(true);
+
   // Convert using stoi rather than Options, or a FieldFactory is used to parse
   // the string, leading to infinite loop.
   try {
@@ -215,9 +222,13 @@ Field3D FieldFactory::create3D(FieldGeneratorPtr gen, Mesh* localmesh, CELL_LOC
 
   auto result = Field3D(localmesh).setLocation(loc).setDirectionY(y_direction).allocate();
 
-  BOUT_FOR(i, result.getRegion("RGN_ALL")) {
-    result[i] = gen->generate(Context(i, loc, localmesh, t));
-  };
+  if (compile_expressions) {
+    evaluateColumns(gen, result, loc, t);
+  } else {
+    BOUT_FOR(i, result.getRegion("RGN_ALL")) {
+      result[i] = gen->generate(Context(i, loc, localmesh, t));
+    };
+  }
 
   if (transform_from_field_aligned) {
     auto coords = result.getCoordinates();
@@ -241,6 +252,37 @@ Field3D FieldFactory::create3D(FieldGeneratorPtr gen, Mesh* localmesh, CELL_LOC
   return result;
 }
 
+void FieldFactory::evaluateColumns(FieldGeneratorPtr gen, Field3D& result, CELL_LOC loc,
+                                   BoutReal t) const {
+  Mesh* localmesh = result.getMesh();
+  const int nz = localmesh->LocalNz;
+
+  const bout::generator::Program program(std::move(gen));
+
+  // The z coordinates are the same in every column
+  std::vector<BoutReal> z(nz);
+  for (int iz = 0; iz < nz; ++iz) {
+    z[iz] = Context(localmesh->xstart, localmesh->ystart, iz, loc, localmesh, t).z();
+  }
+
+  BOUT_OMP(parallel) {
+    bout::generator::Program::Workspace workspace(program, nz);
+    std::vector<BoutReal> x(nz);
+    std::vector<BoutReal> y(nz);
+
+    BOUT_FOR_INNER(i, localmesh->getRegion2D("RGN_ALL")) {
+      const Context column(i.x(), i.y(), 0, loc, localmesh, t);
+      std::fill(x.begin(), x.end(), column.x());
+      std::fill(y.begin(), y.end(), column.y());
+
+      program.evaluate(workspace, nz, x.data(), y.data(), z.data(), t,
+                       &result[localmesh->ind2Dto3D(i)], [&](int iz) {
+                         return Context(i.x(), i.y(), iz, loc, localmesh, t);
+                       });
+    }
+  }
+}
+
 FieldPerp FieldFactory::createPerp(const std::string& value, const Options* opt,
                                    Mesh* localmesh, CELL_LOC loc, BoutReal t) const {
   return createPerp(parse(value, opt), localmesh, loc, t);
@@ -45,6 +45,11 @@ BoutReal FieldHeaviside::generate(const Context& ctx) {
   return (gen->generate(ctx) > 0.0) ? 1.0 : 0.0;
 }
 
+int FieldHeaviside::compile(bout::generator::Program& program) {
+  return program.addFunction([](BoutReal value) { return (value > 0.0) ? 1.0 : 0.0; },
+                             gen->compile(program));
+}
+
 //////////////////////////////////////////////////////////
 // Ballooning transform
 // Use a truncated Ballooning transform to enforce periodicity in y and z
@@ -92,13 +97,12 @@ BoutReal FieldBallooning::generate(const Context& ctx) {
 
     for (int i = 1; i <= ball_n; i++) {
       // y - i * 2pi
-      // clang-format off
-      value += arg->generate(Context(ctx).set("y", ctx.y() - i * TWOPI,
-                                              "z", ctx.z() + i * ts * TWOPI / zlength));
+      const BoutReal zshift = i * ts * TWOPI / zlength;
+      value += arg->generate(Context(ctx).set(Context::y_slot, ctx.y() - i * TWOPI,
+                                              Context::z_slot, ctx.z() + zshift));
 
-      value += arg->generate(Context(ctx).set("y", ctx.y() + i * TWOPI,
-                                              "z", ctx.z() - i * ts * TWOPI / zlength));
-      // clang-format on
+      value += arg->generate(Context(ctx).set(Context::y_slot, ctx.y() + i * TWOPI,
+                                              Context::z_slot, ctx.z() - zshift));
     }
     return value;
   }
@@ -25,6 +25,9 @@ public:
     return std::make_shared<FieldValuePtr>(ptr);
   }
   BoutReal generate(const bout::generator::Context&) override { return *ptr; }
+  int compile(bout::generator::Program& program) override {
+    return program.addValuePointer(ptr);
+  }
 
 private:
   BoutReal* ptr;
@@ -50,6 +53,9 @@ public:
   BoutReal generate(const bout::generator::Context& pos) override {
     return Op(gen->generate(pos));
   }
+  int compile(bout::generator::Program& program) override {
+    return program.addFunction(Op, gen->compile(program));
+  }
   std::string str() const override {
     return name + std::string("(") + gen->str() + std::string(")");
   }
@@ -77,6 +83,9 @@ public:
   BoutReal generate(const bout::generator::Context& pos) override {
     return Op(A->generate(pos), B->generate(pos));
   }
+  int compile(bout::generator::Program& program) override {
+    return program.addFunction(Op, A->compile(program), B->compile(program));
+  }
   std::string str() const override {
     return name + std::string("(") + A->str() + "," + B->str() + std::string(")");
   }
@@ -106,6 +115,14 @@ public:
     }
     return atan2(A->generate(pos), B->generate(pos));
   }
+  int compile(bout::generator::Program& program) override {
+    if (B == nullptr) {
+      return program.addFunction(static_cast<BoutReal (*)(BoutReal)>(atan),
+                                 A->compile(program));
+    }
+    return program.addFunction(static_cast<BoutReal (*)(BoutReal, BoutReal)>(atan2),
+                               A->compile(program), B->compile(program));
+  }
 
 private:
   FieldGeneratorPtr A, B;
@@ -130,6 +147,7 @@ public:
 
   FieldGeneratorPtr clone(const std::list<FieldGeneratorPtr> args) override;
   BoutReal generate(const bout::generator::Context& pos) override;
+  int compile(bout::generator::Program& program) override;
   std::string str() const override {
     return std::string("H(") + gen->str() + std::string(")");
   }
@@ -160,6 +178,14 @@ public:
     }
     return result;
   }
+  int compile(bout::generator::Program& program) override {
+    auto it = input.begin();
+    int result = (*it)->compile(program);
+    for (++it; it != input.end(); ++it) {
+      result = program.addMin(result, (*it)->compile(program));
+    }
+    return result;
+  }
 
 private:
   std::list<FieldGeneratorPtr> input;
@@ -187,6 +213,14 @@ public:
     }
     return result;
   }
+  int compile(bout::generator::Program& program) override {
+    auto it = input.begin();
+    int result = (*it)->compile(program);
+    for (++it; it != input.end(); ++it) {
+      result = program.addMax(result, (*it)->compile(program));
+    }
+    return result;
+  }
 
 private:
   std::list<FieldGeneratorPtr> input;
@@ -36,8 +36,16 @@
 #include <bout/constants.hxx>
 #include <bout/openmpwrap.hxx>
 
+#include <algorithm>
 #include <cmath>
 #include <fftw3.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #if BOUT_USE_OPENMP
 #include <omp.h>
@@ -104,288 +112,288 @@ void fft_init(bool fft_measure) {
  * Real FFTs
  ***********************************************************/
 
-#if !BOUT_USE_OPENMP
-// Serial code
-void rfft(MAYBE_UNUSED(const BoutReal* in), MAYBE_UNUSED(int length),
-          MAYBE_UNUSED(dcomplex* out)) {
-#if !BOUT_HAS_FFTW
-  throw BoutException("This instance of BOUT++ has been compiled without fftw support.");
-#else
-  // static variables initialized once
-  static double* fin;
-  static fftw_complex* fout;
-  static fftw_plan p;
-  static int n = 0;
-
-  // If the current length mismatches n
-  if (length != n) {
-    // If n has been used before
-    if (n > 0) {
-      // Free the previously initialized data
-      fftw_destroy_plan(p);
-      fftw_free(fin);
-      fftw_free(fout);
-    }
-
-    fft_init();
-
-    // Initialize the input for the fourier transformation
-    fin = static_cast<double*>(fftw_malloc(sizeof(double) * length));
-    // Initialize the output of the fourier transformation
-    /* NOTE: Only the non-redundant output is given
-     *       I.e the offset and the positive frequencies (so no mirroring
-     *       around the Nyquist frequency)
-     */
-    fout =
-        static_cast<fftw_complex*>(fftw_malloc(sizeof(fftw_complex) * (length / 2 + 1)));
-
-    auto flags = get_measurement_flag(fft_measurement_flag);
-
-    /* fftw call
-     * Plan a real-input/complex-output discrete Fourier transform (DFT)
-     * in 1 dimensions. Returns a fftw_plan (containing pointers etc.)
-     * r2c = real to complex
-     */
-    p = fftw_plan_dft_r2c_1d(length, fin, fout, flags);
+#if BOUT_HAS_FFTW
+namespace {
+/// FFTW's planner is not thread safe, so everything which creates or
+/// destroys a plan holds this lock. It is recursive because dropping
+/// the last reference to a cached plan destroys it, which can happen
+/// while the lock is already held
+std::recursive_mutex& plannerMutex() {
+  static std::recursive_mutex mutex;
+  return mutex;
+}
 
-    n = length;
+/// Identifies a batched plan: \p howmany transforms, each of
+/// \p length points, stored one after another
+struct PlanKey {
+  int length;
+  int howmany;
+  bool forward;
+  /// Are the arrays aligned for SIMD? Plans made for aligned arrays
+  /// can only be executed on aligned arrays
+  bool aligned;
+
+  bool operator==(const PlanKey& other) const {
+    return std::tie(length, howmany, forward, aligned)
+           == std::tie(other.length, other.howmany, other.forward, other.aligned);
   }
-
-  // Put the input to fin
-  for (int i = 0; i < n; i++) {
-    fin[i] = in[i];
+};
+
+/// Shared ownership of a plan, which is destroyed (under the planner
+/// lock) once neither the cache nor any thread is using it
+using PlanPtr = std::shared_ptr<std::remove_pointer_t<fftw_plan>>;
+
+/// Owns the plans used by rfft and irfft
+///
+/// Plans are only made for batches whose size is a power of two up
+/// to max_batch, so there are only a few plans for each length
+/// however the transforms are split between calls and threads. At
+/// most max_plans are kept, and the least recently used is dropped
+/// when another is needed
+class PlanCache {
+public:
+  /// Largest number of transforms done by one plan
+  static constexpr int max_batch = 64;
+
+  static PlanCache& instance() {
+    static PlanCache cache;
+    return cache;
   }
 
-  // fftw call executing the fft
-  fftw_execute(p);
+  PlanPtr get(const PlanKey& key) {
+    // Each thread remembers the plans it used most recently, so that
+    // most calls don't take the lock
+    thread_local std::vector<std::pair<PlanKey, PlanPtr>> recent;
+    auto found = std::find_if(recent.begin(), recent.end(),
+                              [&](const auto& entry) { return entry.first == key; });
+    if (found != recent.end()) {
+      return found->second;
+    }
 
-  //Normalising factor
-  const BoutReal fac = 1.0 / n;
-  const int nmodes = (n / 2) + 1;
+    PlanPtr plan;
+    {
+      std::lock_guard<std::recursive_mutex> lock(plannerMutex());
+      auto it = std::find_if(plans.begin(), plans.end(),
+                             [&](const auto& entry) { return entry.first == key; });
+      if (it != plans.end()) {
+        // Move to the front, so that the least recently used plans are at the back
+        plans.splice(plans.begin(), plans, it);
+      } else {
+        plans.emplace_front(key, createPlan(key));
+        if (plans.size() > max_plans) {
+          plans.pop_back();
+        }
+      }
+      plan = plans.front().second;
+    }
 
-  // Store the output in out, and normalize
-  for (int i = 0; i < nmodes; i++) {
-    out[i] = dcomplex(fout[i][0], fout[i][1]) * fac; // Normalise
+    if (recent.size() == max_recent) {
+      recent.erase(recent.begin());
+    }
+    recent.emplace_back(key, plan);
+    return plan;
   }
-#endif
-}
 
-void irfft(MAYBE_UNUSED(const dcomplex* in), MAYBE_UNUSED(int length),
-           MAYBE_UNUSED(BoutReal* out)) {
-#if !BOUT_HAS_FFTW
-  throw BoutException("This instance of BOUT++ has been compiled without fftw support.");
-#else
-  // static variables initialized once
-  static fftw_complex* fin;
-  static double* fout;
-  static fftw_plan p;
-  static int n = 0;
+private:
+  /// Maximum number of plans kept by the cache
+  static constexpr std::size_t max_plans = 64;
+  /// Maximum number of plans remembered by each thread
+  static constexpr std::size_t max_recent = 8;
 
-  // If the current length mismatches n
-  if (length != n) {
-    // If n has been used before
-    if (n > 0) {
-      // Free the previously initialized data
-      fftw_destroy_plan(p);
-      fftw_free(fin);
-      fftw_free(fout);
-    }
+  /// Plans, ordered from most to least recently used
+  std::list<std::pair<PlanKey, PlanPtr>> plans;
 
+  // Make sure the planner lock outlives the cache, which uses it to
+  // destroy the plans
+  PlanCache() { plannerMutex(); }
+
+  /// Must be called with the planner lock held
+  static PlanPtr createPlan(const PlanKey& key) {
     fft_init();
 
-    // Initilaize the input for the inverse fourier transformation
-    /* NOTE: Only the non-redundant input is given
-     *       I.e the offset and the positive frequencies (so no mirroring
-     *       around the Nyquist frequency)
-     */
-    fin =
-        static_cast<fftw_complex*>(fftw_malloc(sizeof(fftw_complex) * (length / 2 + 1)));
-    // Initialize the output of the fourier transformation
-    fout = static_cast<double*>(fftw_malloc(sizeof(double) * length));
+    const int length = key.length;
+    const int nmodes = (length / 2) + 1;
 
     auto flags = get_measurement_flag(fft_measurement_flag);
+    if (key.forward) {
+      // Forward plans are executed on the caller's arrays, so the
+      // input must not be overwritten
+      flags |= FFTW_PRESERVE_INPUT;
+    }
+    if (not key.aligned) {
+      flags |= FFTW_UNALIGNED;
+    }
 
-    /* fftw call
-     * Plan a complex-input/real-output discrete Fourier transform (DFT)
-     * in 1 dimensions. Returns a fftw_plan (containing pointers etc.)
-     * c2r = complex to real
-     */
-    p = fftw_plan_dft_c2r_1d(length, fin, fout, flags);
+    // Temporary arrays, only used for planning. FFTW_MEASURE and
+    // FFTW_EXHAUSTIVE overwrite these
+    auto* real_data =
+        static_cast<double*>(fftw_malloc(sizeof(double) * length * key.howmany));
+    auto* complex_data = static_cast<fftw_complex*>(
+        fftw_malloc(sizeof(fftw_complex) * nmodes * key.howmany));
 
-    n = length;
+    /* Plan key.howmany 1D real-to-complex (r2c, forward) or
+     * complex-to-real (c2r, backward) transforms, with consecutive
+     * transforms length (real) or nmodes (complex) apart
+     */
+    fftw_plan plan =
+        key.forward
+            ? fftw_plan_many_dft_r2c(1, &length, key.howmany, real_data, nullptr, 1,
+                                     length, complex_data, nullptr, 1, nmodes, flags)
+            : fftw_plan_many_dft_c2r(1, &length, key.howmany, complex_data, nullptr, 1,
+                                     nmodes, real_data, nullptr, 1, length, flags);
+
+    fftw_free(real_data);
+    fftw_free(complex_data);
+
+    if (plan == nullptr) {
+      throw BoutException("Could not create FFTW plan for {:d} transforms of length {:d}",
+                          key.howmany, key.length);
+    }
+    return {plan, [](fftw_plan p) {
+              std::lock_guard<std::recursive_mutex> lock(plannerMutex());
+              fftw_destroy_plan(p);
+            }};
   }
-
-  // Store the real and imaginary parts in the proper way
-  const int nmodes = (n / 2) + 1;
-  for (int i = 0; i < nmodes; i++) {
-    fin[i][0] = in[i].real();
-    fin[i][1] = in[i].imag();
+};
+
+/// Split \p count transforms into batches whose sizes are powers of
+/// two, no larger than PlanCache::max_batch, calling \p func(offset,
+/// batch) for each
+template <typename F>
+void forEachBatch(int count, F func) {
+  int offset = 0;
+  while (offset < count) {
+    int batch = PlanCache::max_batch;
+    while (batch > count - offset) {
+      batch /= 2;
+    }
+    func(offset, batch);
+    offset += batch;
   }
+}
 
-  // fftw call executing the fft
-  fftw_execute(p);
+/// Can arrays starting at \p in and \p out use a plan made for aligned arrays?
+bool isAligned(const void* in, const void* out) {
+  return fftw_alignment_of(static_cast<double*>(const_cast<void*>(in))) == 0
+         and fftw_alignment_of(static_cast<double*>(const_cast<void*>(out))) == 0;
+}
 
-  // Store the output of the fftw to the out
-  for (int i = 0; i < n; i++) {
-    out[i] = fout[i];
+/// Call \p func(start, count) on chunks of [0, \p howmany). Outside
+/// of a parallel region, the chunks are split between OpenMP threads
+template <typename F>
+void forEachChunk(int howmany, F func) {
+#if BOUT_USE_OPENMP
+  if (howmany > 1 and omp_in_parallel() == 0) {
+    BOUT_OMP(parallel)
+    {
+      const int nthreads = omp_get_num_threads();
+      const int thread = omp_get_thread_num();
+      const int start = (howmany * thread) / nthreads;
+      const int end = (howmany * (thread + 1)) / nthreads;
+      if (end > start) {
+        func(start, end - start);
+      }
+    }
+    return;
   }
 #endif
+  func(0, howmany);
 }
-#else
-// Parallel thread-safe version of rfft and irfft
+} // namespace
+#endif
+
 void rfft(MAYBE_UNUSED(const BoutReal* in), MAYBE_UNUSED(int length),
-          MAYBE_UNUSED(dcomplex* out)) {
+          MAYBE_UNUSED(int howmany), MAYBE_UNUSED(dcomplex* out)) {
 #if !BOUT_HAS_FFTW
   throw BoutException("This instance of BOUT++ has been compiled without fftw support.");
 #else
-  // ensure we are not nested
-  ASSERT1(omp_get_active_level() < 2);
-  static double* finall;
-  static fftw_complex* foutall;
-  static fftw_plan* p;
-  static int size = 0, nthreads = 0;
-
-  int th_id = omp_get_thread_num();
-  int n_th = omp_get_num_threads(); // Number of threads
-
-  // Sort out memory. Also, FFTW planning routines not thread safe
-  if ((size != length) || (nthreads < n_th)) {
-    // We make the check to see if the problem size has changed twice
-    // intentionally. The first check ensures we don't pay the cost of
-    // obtaining a lock for the critical section if we don't need to do
-    // any work here. The second check is required to make sure that
-    // only one thread does the actual setup when required. Note we can't
-    // use a `single` block here as that requires all threads to reach the
-    // block (implicit barrier) which may not be true in all cases (e.g.
-    // if there are 8 threads but only 4 call the fft routine).
-    BOUT_OMP(critical(rfft))
-    if ((size != length) || (nthreads < n_th)) {
-      if (size > 0) {
-        // Free all memory
-        for (int i = 0; i < nthreads; i++) {
-          fftw_destroy_plan(p[i]);
-        }
-        delete[] p;
-        fftw_free(finall);
-        fftw_free(foutall);
-      }
-
-      fft_init();
-
-      finall = static_cast<double*>(fftw_malloc(sizeof(double) * length * n_th));
-      foutall = static_cast<fftw_complex*>(
-          fftw_malloc(sizeof(fftw_complex) * (length / 2 + 1) * n_th));
-      p = new fftw_plan[n_th]; //Never freed
-
-      auto flags = get_measurement_flag(fft_measurement_flag);
-
-      for (int i = 0; i < n_th; i++) {
-        // fftw call
-        // Plan a real-input/complex-output discrete Fourier transform (DFT)
-        // in 1 dimensions. Returns a fftw_plan (containing pointers etc.)
-        p[i] = fftw_plan_dft_r2c_1d(length, finall + i * length,
-                                    foutall + i * (length / 2 + 1), flags);
-      }
-      size = length;
-      nthreads = n_th;
+  ASSERT1(length > 0);
+  ASSERT1(howmany > 0);
+
+  const int nmodes = (length / 2) + 1;
+  // Normalising factor
+  const BoutReal fac = 1.0 / static_cast<BoutReal>(length);
+
+  forEachChunk(howmany, [&](int start, int count) {
+    forEachBatch(count, [&](int offset, int batch) {
+      // Plans are made with FFTW_PRESERVE_INPUT, so the input isn't modified
+      auto* fin = const_cast<BoutReal*>(in) + (start + offset) * length;
+      // std::complex<double> has the same layout as fftw_complex
+      auto* fout = reinterpret_cast<fftw_complex*>(out + (start + offset) * nmodes);
+
+      const PlanKey key{length, batch, true, isAligned(fin, fout)};
+      fftw_execute_dft_r2c(PlanCache::instance().get(key).get(), fin, fout);
+    });
+
+    dcomplex* chunk_out = out + start * nmodes;
+    for (int i = 0; i < count * nmodes; i++) {
+      chunk_out[i] *= fac;
     }
-  }
-
-  // Get working arrays for this thread
-  double* fin = finall + th_id * size;
-  fftw_complex* fout = foutall + th_id * (size / 2 + 1);
-
-  for (int i = 0; i < size; i++) {
-    fin[i] = in[i];
-  }
-
-  // fftw call executing the fft
-  fftw_execute(p[th_id]);
-
-  //Normalising factor
-  const BoutReal fac = 1.0 / static_cast<BoutReal>(size);
-  const int nmodes = (size / 2) + 1;
-
-  for (int i = 0; i < nmodes; i++) {
-    out[i] = dcomplex(fout[i][0], fout[i][1]) * fac; // Normalise
-  }
+  });
 #endif
 }
 
+#if BOUT_HAS_FFTW
+namespace {
+/// Inverse transform of \p count signals, overwriting \p in
+void irfftChunk(dcomplex* in, int length, int count, BoutReal* out) {
+  const int nmodes = (length / 2) + 1;
+  forEachBatch(count, [&](int offset, int batch) {
+    // std::complex<double> has the same layout as fftw_complex
+    auto* fin = reinterpret_cast<fftw_complex*>(in + offset * nmodes);
+    BoutReal* fout = out + offset * length;
+
+    const PlanKey key{length, batch, false, isAligned(fin, fout)};
+    fftw_execute_dft_c2r(PlanCache::instance().get(key).get(), fin, fout);
+  });
+}
+} // namespace
+#endif
+
 void irfft(MAYBE_UNUSED(const dcomplex* in), MAYBE_UNUSED(int length),
-           MAYBE_UNUSED(BoutReal* out)) {
+           MAYBE_UNUSED(int howmany), MAYBE_UNUSED(BoutReal* out)) {
 #if !BOUT_HAS_FFTW
   throw BoutException("This instance of BOUT++ has been compiled without fftw support.");
 #else
-  static fftw_complex* finall;
-  static double* foutall;
-  static fftw_plan* p;
-  static int size = 0, nthreads = 0;
-
-  int th_id = omp_get_thread_num();
-  int n_th = omp_get_num_threads(); // Number of threads
-
-  // Sort out memory. Also, FFTW planning routines not thread safe
-  if ((size != length) || (nthreads < n_th)) {
-    // We make the check to see if the problem size has changed twice
-    // intentionally. The first check ensures we don't pay the cost of
-    // obtaining a lock for the critical section if we don't need to do
-    // any work here. The second check is required to make sure that
-    // only one thread does the actual setup when required. Note we can't
-    // use a `single` block here as that requires all threads to reach the
-    // block (implicit barrier) which may not be true in all cases (e.g.
-    // if there are 8 threads but only 4 call the fft routine).
-    BOUT_OMP(critical(irfft))
-    if ((size != length) || (nthreads < n_th)) {
-      if (size > 0) {
-        // Free all memory
-        for (int i = 0; i < nthreads; i++) {
-          fftw_destroy_plan(p[i]);
-        }
-        delete[] p;
-        fftw_free(finall);
-        fftw_free(foutall);
-      }
-
-      fft_init();
-
-      finall = static_cast<fftw_complex*>(
-          fftw_malloc(sizeof(fftw_complex) * (length / 2 + 1) * n_th));
-      foutall = static_cast<double*>(fftw_malloc(sizeof(double) * length * n_th));
-
-      p = new fftw_plan[n_th]; // Never freed
+  ASSERT1(length > 0);
+  ASSERT1(howmany > 0);
 
-      auto flags = get_measurement_flag(fft_measurement_flag);
+  const int nmodes = (length / 2) + 1;
 
-      for (int i = 0; i < n_th; i++) {
-        p[i] = fftw_plan_dft_c2r_1d(length, finall + i * (length / 2 + 1),
-                                    foutall + i * length, flags);
-      }
-      size = length;
-      nthreads = n_th;
+  forEachChunk(howmany, [&](int start, int count) {
+    // Complex-to-real transforms overwrite their input, so work on a
+    // copy. Each thread keeps its buffer between calls
+    thread_local std::vector<dcomplex> chunk_in;
+    if (chunk_in.size() < static_cast<std::size_t>(count * nmodes)) {
+      chunk_in.resize(count * nmodes);
     }
-  }
-
-  // Get working arrays for this thread
-  fftw_complex* fin = finall + th_id * (size / 2 + 1);
-  double* fout = foutall + th_id * size;
+    std::copy(in + start * nmodes, in + (start + count) * nmodes, chunk_in.begin());
 
-  const int nmodes = (size / 2) + 1;
+    irfftChunk(chunk_in.data(), length, count, out + start * length);
+  });
+#endif
+}
 
-  for (int i = 0; i < nmodes; i++) {
-    fin[i][0] = in[i].real();
-    fin[i][1] = in[i].imag();
-  }
+void irfft_overwrite_input(MAYBE_UNUSED(dcomplex* in), MAYBE_UNUSED(int length),
+                           MAYBE_UNUSED(int howmany), MAYBE_UNUSED(BoutReal* out)) {
+#if !BOUT_HAS_FFTW
+  throw BoutException("This instance of BOUT++ has been compiled without fftw support.");
+#else
+  ASSERT1(length > 0);
+  ASSERT1(howmany > 0);
 
-  // fftw call executing the fft
-  fftw_execute(p[th_id]);
+  const int nmodes = (length / 2) + 1;
 
-  for (int i = 0; i < size; i++) {
-    out[i] = fout[i];
-  }
+  forEachChunk(howmany, [&](int start, int count) {
+    irfftChunk(in + start * nmodes, length, count, out + start * length);
+  });
 #endif
 }
-#endif
+
+void rfft(const BoutReal* in, int length, dcomplex* out) { rfft(in, length, 1, out); }
+
+void irfft(const dcomplex* in, int length, BoutReal* out) { irfft(in, length, 1, out); }
+
 //  Discrete sine transforms (B Shanahan)
 
 void DST(MAYBE_UNUSED(const BoutReal* in), MAYBE_UNUSED(int length),
@@ -401,6 +409,7 @@ void DST(MAYBE_UNUSED(const BoutReal* in), MAYBE_UNUSED(int length),
   ASSERT1(length > 0);
 
   if (length != n) {
+    std::lock_guard<std::recursive_mutex> lock(plannerMutex());
     if (n > 0) {
       fftw_destroy_plan(p);
       fftw_free(fin);
@@ -459,6 +468,7 @@ void DST_rev(MAYBE_UNUSED(dcomplex* in), MAYBE_UNUSED(int length),
   ASSERT1(length > 0);
 
   if (length != n) {
+    std::lock_guard<std::recursive_mutex> lock(plannerMutex());
     if (n > 0) {
       fftw_destroy_plan(p);
       fftw_free(fin);
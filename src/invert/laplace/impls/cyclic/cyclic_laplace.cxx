@@ -47,6 +47,8 @@
 #include <bout/sys/timer.hxx>
 #include <bout/utils.hxx>
 
+#include <vector>
+
 #include "cyclic_laplace.hxx"
 
 LaplaceCyclic::LaplaceCyclic(Options* opt, const CELL_LOC loc, Mesh* mesh_in,
@@ -65,10 +67,16 @@ LaplaceCyclic::LaplaceCyclic(Options* opt, const CELL_LOC loc, Mesh* mesh_in,
             .withDefault<bool>(false);
 
   if (dst) {
+    if (localmesh->getNZPE() > 1) {
+      throw BoutException("LaplaceCyclic error: dst can't be used when Z is split "
+                          "between processors (NZPE must be 1)");
+    }
     nmode = localmesh->LocalNz - 2;
   } else {
     // Number of Z modes. maxmode set in invert_laplace.cxx from options
     nmode = maxmode + 1;
+    // If Z is split between processors, so are the modes
+    zfourier = std::make_unique<bout::ZFourierTranspose>(localmesh, nmode);
   }
 
   // Note nmode == nsys of cyclic_reduction
@@ -90,15 +98,23 @@ LaplaceCyclic::LaplaceCyclic(Options* opt, const CELL_LOC loc, Mesh* mesh_in,
   int n = xe - xs + 1; // Number of X points on this processor,
                        // including boundaries but not guard cells
 
-  a.reallocate(nmode, n);
-  b.reallocate(nmode, n);
-  c.reallocate(nmode, n);
-  xcmplx.reallocate(nmode, n);
-  bcmplx.reallocate(nmode, n);
+  const int nlocal = dst ? nmode : zfourier->localModes();
+  xcmplx.reallocate(nlocal, n);
+  bcmplx.reallocate(nlocal, n);
+
+  cache_tridag_matrices = (*opt)["cache_coefficients"]
+                              .doc("Re-use the tridiagonal matrices and their "
+                                   "factorisation between solves if the coefficients "
+                                   "and flags have not changed")
+                              .withDefault(true);
 
   // Create a cyclic reduction object, operating on dcomplex values
   cr = new CyclicReduce<dcomplex>(localmesh->getXcomm(), n);
   cr->setPeriodic(localmesh->periodicX);
+  cr->setInterfacePCR((*opt)["interface_pcr"]
+                          .doc("Solve the equations coupling X processors with parallel "
+                               "cyclic reduction, rather than gathering them")
+                          .withDefault(true));
 }
 
 LaplaceCyclic::~LaplaceCyclic() {
@@ -158,26 +174,23 @@ FieldPerp LaplaceCyclic::solve(const FieldPerp& rhs, const FieldPerp& x0) {
         }
       }
 
-      // Get elements of the tridiagonal matrix
-      // including boundary conditions
-      BoutReal zlen = getUniform(coords->dz) * (localmesh->LocalNz - 3);
-      BOUT_OMP(for nowait)
-      for (int kz = 0; kz < nmode; kz++) {
-        // wave number is 1/[rad]; DST has extra 2.
-        BoutReal kwave = kz * 2.0 * PI / (2. * zlen);
-
-        tridagMatrix(&a(kz, 0), &b(kz, 0), &c(kz, 0), &bcmplx(kz, 0), jy,
-                     kz,    // wave number index
-                     kwave, // kwave (inverse wave length)
-                     global_flags, inner_boundary_flags, outer_boundary_flags, &Acoef,
-                     &C1coef, &C2coef, &Dcoef,
-                     false,  // Don't include guard cells in arrays
-                     false); // Z domain not periodic
-      }
     }
 
+    // Get elements of the tridiagonal matrix
+    // including boundary conditions
+    // wave number is 1/[rad]; DST has extra 2.
+    const BoutReal zlen = getUniform(coords->dz) * (localmesh->LocalNz - 3);
+    bool rebuilt = false;
+    const auto& matrices =
+        getTridagMatrices(jy, jy, nmode, 2. * zlen, &Acoef, &C1coef, &C2coef, &Dcoef,
+                          false, // Z domain not periodic
+                          rebuilt);
+    applyTridagBoundaries(matrices, bcmplx);
+
     // Solve tridiagonal systems
-    cr->setCoefs(a, b, c);
+    if (rebuilt) {
+      cr->setCoefs(matrices.a, matrices.b, matrices.c);
+    }
     cr->solve(bcmplx, xcmplx);
 
     // FFT back to real space
@@ -206,52 +219,48 @@ FieldPerp LaplaceCyclic::solve(const FieldPerp& rhs, const FieldPerp& x0) {
     }
   } else {
     const BoutReal zlength = getUniform(coords->zlength());
-    BOUT_OMP(parallel)
-    {
-      /// Create a local thread-scope working array
-      // ZFFT routine expects input of this length
-      auto k1d = Array<dcomplex>((localmesh->LocalNz) / 2 + 1);
-
-      // Loop over X indices, including boundaries but not guard
-      // cells (unless periodic in x)
-      BOUT_OMP(for)
-      for (int ix = xs; ix <= xe; ix++) {
-        // Take FFT in Z direction, apply shift, and put result in k1d
-
-        if (((ix < inbndry) && (inner_boundary_flags & INVERT_SET) && localmesh->firstX())
-            || ((localmesh->LocalNx - ix - 1 < outbndry)
-                && (outer_boundary_flags & INVERT_SET) && localmesh->lastX())) {
-          // Use the values in x0 in the boundary
-          rfft(x0[ix], localmesh->LocalNz, std::begin(k1d));
-        } else {
-          rfft(rhs[ix], localmesh->LocalNz, std::begin(k1d));
-        }
-
-        // Copy into array, transposing so kz is first index
-        for (int kz = 0; kz < nmode; kz++) {
-          bcmplx(kz, ix - xs) = k1d[kz];
-        }
-      }
+    const int nx = xe - xs + 1;
+    // Modes kz_start to kz_start + nlocal - 1 are solved on this processor
+    const int kz_start = zfourier->firstMode();
+    const int nlocal = zfourier->localModes();
+
+    // Use the values in x0 in the boundary
+    const auto use_x0 = [&](int ix) {
+      return ((ix < inbndry) && ((inner_boundary_flags & INVERT_SET) != 0)
+              && localmesh->firstX())
+             || ((localmesh->LocalNx - ix - 1 < outbndry)
+                 && ((outer_boundary_flags & INVERT_SET) != 0) && localmesh->lastX());
+    };
+
+    // Take FFT in Z direction
+    std::vector<const BoutReal*> lines(nx);
+    for (int ix = xs; ix <= xe; ix++) {
+      lines[ix - xs] = (use_x0(ix) ? x0[ix] : rhs[ix]) + localmesh->zstart;
+    }
+    auto k2d = zfourier->forward(lines);
 
-      // Get elements of the tridiagonal matrix
-      // including boundary conditions
-      BOUT_OMP(for nowait)
-      for (int kz = 0; kz < nmode; kz++) {
-        BoutReal kwave = kz * 2.0 * PI / zlength; // wave number is 1/[rad]
-        tridagMatrix(&a(kz, 0), &b(kz, 0), &c(kz, 0), &bcmplx(kz, 0), jy,
-                     kz,    // True for the component constant (DC) in Z
-                     kwave, // Z wave number
-                     global_flags, inner_boundary_flags, outer_boundary_flags, &Acoef,
-                     &C1coef, &C2coef, &Dcoef,
-                     false); // Don't include guard cells in arrays
+    // Copy into array, transposing so kz is first index
+    BOUT_OMP(parallel for)
+    for (int ix = xs; ix <= xe; ix++) {
+      for (int kz = 0; kz < nlocal; kz++) {
+        bcmplx(kz, ix - xs) = k2d(ix - xs, kz);
       }
     }
 
+    // Get elements of the tridiagonal matrix
+    // including boundary conditions
+    bool rebuilt = false;
+    const auto& matrices = getTridagMatrices(jy, jy, nlocal, zlength, &Acoef, &C1coef,
+                                             &C2coef, &Dcoef, true, rebuilt, kz_start);
+    applyTridagBoundaries(matrices, bcmplx);
+
     // Solve tridiagonal systems
-    cr->setCoefs(a, b, c);
+    if (rebuilt) {
+      cr->setCoefs(matrices.a, matrices.b, matrices.c);
+    }
     cr->solve(bcmplx, xcmplx);
 
-    if (localmesh->periodicX) {
+    if (localmesh->periodicX and kz_start == 0) {
       // Subtract X average of kz=0 mode
       BoutReal local[2] = {
           0.0,                               // index 0 = sum of coefficients
@@ -269,31 +278,24 @@ FieldPerp LaplaceCyclic::solve(const FieldPerp& rhs, const FieldPerp& x0) {
     }
 
     // FFT back to real space
-    BOUT_OMP(parallel)
-    {
-      /// Create a local thread-scope working array
-      // ZFFT routine expects input of this length
-      auto k1d = Array<dcomplex>((localmesh->LocalNz) / 2 + 1);
-
-      const bool zero_DC = (global_flags & INVERT_ZERO_DC) != 0;
-
-      BOUT_OMP(for nowait)
-      for (int ix = xs; ix <= xe; ix++) {
-        if (zero_DC) {
-          k1d[0] = 0.;
-        }
+    const bool zero_DC = ((global_flags & INVERT_ZERO_DC) != 0) and (kz_start == 0);
 
-        for (int kz = static_cast<int>(zero_DC); kz < nmode; kz++) {
-          k1d[kz] = xcmplx(kz, ix - xs);
-        }
-
-        for (int kz = nmode; kz < (localmesh->LocalNz) / 2 + 1; kz++) {
-          k1d[kz] = 0.0; // Filtering out all higher harmonics
-        }
+    BOUT_OMP(parallel for)
+    for (int ix = xs; ix <= xe; ix++) {
+      if (zero_DC) {
+        k2d(ix - xs, 0) = 0.;
+      }
 
-        irfft(std::begin(k1d), localmesh->LocalNz, x[ix]);
+      for (int kz = static_cast<int>(zero_DC); kz < nlocal; kz++) {
+        k2d(ix - xs, kz) = xcmplx(kz, ix - xs);
       }
     }
+
+    std::vector<BoutReal*> out(nx);
+    for (int ix = xs; ix <= xe; ix++) {
+      out[ix - xs] = x[ix] + localmesh->zstart;
+    }
+    zfourier->backward(k2d, out);
   }
 
   checkData(x);
@@ -347,13 +349,11 @@ Field3D LaplaceCyclic::solve(const Field3D& rhs, const Field3D& x0) {
   }
 
   const int ny = (ye - ys + 1); // Number of Y points
-  const int nsys = nmode * ny;  // Number of systems of equations to solve
+  // Number of modes on this processor, if Z is split between processors
+  const int nlocal = dst ? nmode : zfourier->localModes();
+  const int nsys = nlocal * ny; // Number of systems of equations to solve
   const int nxny = nx * ny;     // Number of points in X-Y
 
-  auto a3D = Matrix<dcomplex>(nsys, nx);
-  auto b3D = Matrix<dcomplex>(nsys, nx);
-  auto c3D = Matrix<dcomplex>(nsys, nx);
-
   auto xcmplx3D = Matrix<dcomplex>(nsys, nx);
   auto bcmplx3D = Matrix<dcomplex>(nsys, nx);
 
@@ -389,31 +389,23 @@ Field3D LaplaceCyclic::solve(const Field3D& rhs, const Field3D& x0) {
           bcmplx3D((iy - ys) * nmode + kz, ix - xs) = k1d[kz];
         }
       }
-
-      // Get elements of the tridiagonal matrix
-      // including boundary conditions
-      const BoutReal zlen = getUniform(coords->dz) * (localmesh->LocalNz - 3);
-      BOUT_OMP(for nowait)
-      for (int ind = 0; ind < nsys; ind++) {
-        // ind = (iy - ys) * nmode + kz
-        int iy = ys + ind / nmode;
-        int kz = ind % nmode;
-
-        // wave number is 1/[rad]; DST has extra 2.
-        BoutReal kwave = kz * 2.0 * PI / (2. * zlen);
-
-        tridagMatrix(&a3D(ind, 0), &b3D(ind, 0), &c3D(ind, 0), &bcmplx3D(ind, 0), iy,
-                     kz,    // wave number index
-                     kwave, // kwave (inverse wave length)
-                     global_flags, inner_boundary_flags, outer_boundary_flags, &Acoef,
-                     &C1coef, &C2coef, &Dcoef,
-                     false,  // Don't include guard cells in arrays
-                     false); // Z domain not periodic
-      }
     }
 
+    // Get elements of the tridiagonal matrix
+    // including boundary conditions
+    // wave number is 1/[rad]; DST has extra 2.
+    const BoutReal zlen = getUniform(coords->dz) * (localmesh->LocalNz - 3);
+    bool rebuilt = false;
+    const auto& matrices =
+        getTridagMatrices(ys, ye, nmode, 2. * zlen, &Acoef, &C1coef, &C2coef, &Dcoef,
+                          false, // Z domain not periodic
+                          rebuilt);
+    applyTridagBoundaries(matrices, bcmplx3D);
+
     // Solve tridiagonal systems
-    cr->setCoefs(a3D, b3D, c3D);
+    if (rebuilt) {
+      cr->setCoefs(matrices.a, matrices.b, matrices.c);
+    }
     cr->solve(bcmplx3D, xcmplx3D);
 
     // FFT back to real space
@@ -445,68 +437,57 @@ Field3D LaplaceCyclic::solve(const Field3D& rhs, const Field3D& x0) {
     }
   } else {
     const BoutReal zlength = getUniform(coords->zlength());
-    BOUT_OMP(parallel)
-    {
-      /// Create a local thread-scope working array
-      // ZFFT routine expects input of this length
-      auto k1d = Array<dcomplex>(localmesh->LocalNz / 2 + 1);
-
-      // Loop over X and Y indices, including boundaries but not guard cells
-      // (unless periodic in x)
-
-      BOUT_OMP(for)
-      for (int ind = 0; ind < nxny; ++ind) {
-        // ind = (ix - xs)*(ye - ys + 1) + (iy - ys)
-        int ix = xs + ind / ny;
-        int iy = ys + ind % ny;
-
-        // Take FFT in Z direction, apply shift, and put result in k1d
-
-        if (((ix < inbndry) && ((inner_boundary_flags & INVERT_SET) != 0)
-             && localmesh->firstX())
-            || ((localmesh->LocalNx - ix - 1 < outbndry)
-                && ((outer_boundary_flags & INVERT_SET) != 0) && localmesh->lastX())) {
-          // Use the values in x0 in the boundary
-          rfft(x0(ix, iy), localmesh->LocalNz, std::begin(k1d));
-        } else {
-          rfft(rhs(ix, iy), localmesh->LocalNz, std::begin(k1d));
-        }
-
-        // Copy into array, transposing so kz is first index
-        for (int kz = 0; kz < nmode; kz++) {
-          bcmplx3D((iy - ys) * nmode + kz, ix - xs) = k1d[kz];
-        }
+    // Modes kz_start to kz_start + nlocal - 1 are solved on this processor
+    const int kz_start = zfourier->firstMode();
+
+    // Use the values in x0 in the boundary
+    const auto use_x0 = [&](int ix) {
+      return ((ix < inbndry) && ((inner_boundary_flags & INVERT_SET) != 0)
+              && localmesh->firstX())
+             || ((localmesh->LocalNx - ix - 1 < outbndry)
+                 && ((outer_boundary_flags & INVERT_SET) != 0) && localmesh->lastX());
+    };
+
+    // Take FFT in Z direction of line (ix - xs) * ny + (iy - ys)
+    std::vector<const BoutReal*> lines(nxny);
+    for (int ix = xs; ix <= xe; ix++) {
+      const Field3D& in = use_x0(ix) ? x0 : rhs;
+      for (int iy = ys; iy <= ye; iy++) {
+        lines[(ix - xs) * ny + (iy - ys)] = &in(ix, iy, localmesh->zstart);
       }
-
-      // Get elements of the tridiagonal matrix
-      // including boundary conditions
-      BOUT_OMP(for nowait)
-      for (int ind = 0; ind < nsys; ind++) {
-        // ind = (iy - ys) * nmode + kz
-        int iy = ys + ind / nmode;
-        int kz = ind % nmode;
-
-        BoutReal kwave = kz * 2.0 * PI / zlength; // wave number is 1/[rad]
-        tridagMatrix(&a3D(ind, 0), &b3D(ind, 0), &c3D(ind, 0), &bcmplx3D(ind, 0), iy,
-                     kz,    // True for the component constant (DC) in Z
-                     kwave, // Z wave number
-                     global_flags, inner_boundary_flags, outer_boundary_flags, &Acoef,
-                     &C1coef, &C2coef, &Dcoef,
-                     false); // Don't include guard cells in arrays
+    }
+    auto k2d = zfourier->forward(lines);
+
+    // Copy into array, transposing so kz is first index
+    BOUT_OMP(parallel for)
+    for (int ind = 0; ind < nxny; ++ind) {
+      const int ix = ind / ny;
+      const int iy = ind % ny;
+      for (int kz = 0; kz < nlocal; kz++) {
+        bcmplx3D(iy * nlocal + kz, ix) = k2d(ind, kz);
       }
     }
 
+    // Get elements of the tridiagonal matrix
+    // including boundary conditions
+    bool rebuilt = false;
+    const auto& matrices = getTridagMatrices(ys, ye, nlocal, zlength, &Acoef, &C1coef,
+                                             &C2coef, &Dcoef, true, rebuilt, kz_start);
+    applyTridagBoundaries(matrices, bcmplx3D);
+
     // Solve tridiagonal systems
-    cr->setCoefs(a3D, b3D, c3D);
+    if (rebuilt) {
+      cr->setCoefs(matrices.a, matrices.b, matrices.c);
+    }
     cr->solve(bcmplx3D, xcmplx3D);
 
-    if (localmesh->periodicX) {
+    if (localmesh->periodicX and kz_start == 0) {
       // Subtract X average of kz=0 mode
       BoutReal local[ny + 1];
       for (int y = 0; y < ny; y++) {
         local[y] = 0.0;
         for (int ix = xs; ix <= xe; ix++) {
-          local[y] += xcmplx3D(y * nmode, ix - xs).real();
+          local[y] += xcmplx3D(y * nlocal, ix - xs).real();
         }
       }
       local[ny] = static_cast<BoutReal>(xe - xs + 1);
@@ -518,41 +499,34 @@ Field3D LaplaceCyclic::solve(const Field3D& rhs, const Field3D& x0) {
       for (int y = 0; y < ny; y++) {
         BoutReal avg = global[y] / global[ny];
         for (int ix = xs; ix <= xe; ix++) {
-          xcmplx3D(y * nmode, ix - xs) -= avg;
+          xcmplx3D(y * nlocal, ix - xs) -= avg;
         }
       }
     }
 
     // FFT back to real space
-    BOUT_OMP(parallel)
-    {
-      /// Create a local thread-scope working array
-      auto k1d = Array<dcomplex>((localmesh->LocalNz) / 2
-                                 + 1); // ZFFT routine expects input of this length
-
-      const bool zero_DC = (global_flags & INVERT_ZERO_DC) != 0;
-
-      BOUT_OMP(for nowait)
-      for (int ind = 0; ind < nxny; ++ind) { // Loop over X and Y
-        // ind = (ix - xs)*(ye - ys + 1) + (iy - ys)
-        int ix = xs + ind / ny;
-        int iy = ys + ind % ny;
-
-        if (zero_DC) {
-          k1d[0] = 0.;
-        }
-
-        for (int kz = static_cast<int>(zero_DC); kz < nmode; kz++) {
-          k1d[kz] = xcmplx3D((iy - ys) * nmode + kz, ix - xs);
-        }
+    const bool zero_DC = ((global_flags & INVERT_ZERO_DC) != 0) and (kz_start == 0);
+
+    BOUT_OMP(parallel for)
+    for (int ind = 0; ind < nxny; ++ind) {
+      const int ix = ind / ny;
+      const int iy = ind % ny;
+      if (zero_DC) {
+        k2d(ind, 0) = 0.;
+      }
 
-        for (int kz = nmode; kz < localmesh->LocalNz / 2 + 1; kz++) {
-          k1d[kz] = 0.0; // Filtering out all higher harmonics
-        }
+      for (int kz = static_cast<int>(zero_DC); kz < nlocal; kz++) {
+        k2d(ind, kz) = xcmplx3D(iy * nlocal + kz, ix);
+      }
+    }
 
-        irfft(std::begin(k1d), localmesh->LocalNz, x(ix, iy));
+    std::vector<BoutReal*> out(nxny);
+    for (int ix = xs; ix <= xe; ix++) {
+      for (int iy = ys; iy <= ye; iy++) {
+        out[(ix - xs) * ny + (iy - ys)] = &x(ix, iy, localmesh->zstart);
       }
     }
+    zfourier->backward(k2d, out);
   }
 
   checkData(x);
@@ -46,9 +46,12 @@ RegisterUnavailableLaplace registerlaplacecycle(LAPLACE_CYCLIC,
 #include <bout/cyclic_reduction.hxx>
 #include <bout/dcomplex.hxx>
 #include <bout/options.hxx>
+#include <bout/z_transpose.hxx>
 
 #include "bout/utils.hxx"
 
+#include <memory>
+
 namespace {
 RegisterLaplace<LaplaceCyclic> registerlaplacecycle(LAPLACE_CYCLIC);
 }
@@ -68,6 +71,7 @@ public:
     ASSERT1(val.getLocation() == location);
     ASSERT1(localmesh == val.getMesh());
     Acoef = val;
+    invalidateTridagMatrices();
   }
   using Laplacian::setCoefC;
   void setCoefC(const Field2D& val) override {
@@ -79,18 +83,21 @@ public:
     ASSERT1(val.getLocation() == location);
     ASSERT1(localmesh == val.getMesh());
     C1coef = val;
+    invalidateTridagMatrices();
   }
   using Laplacian::setCoefC2;
   void setCoefC2(const Field2D& val) override {
     ASSERT1(val.getLocation() == location);
     ASSERT1(localmesh == val.getMesh());
     C2coef = val;
+    invalidateTridagMatrices();
   }
   using Laplacian::setCoefD;
   void setCoefD(const Field2D& val) override {
     ASSERT1(val.getLocation() == location);
     ASSERT1(localmesh == val.getMesh());
     Dcoef = val;
+    invalidateTridagMatrices();
   }
   using Laplacian::setCoefEx;
   void setCoefEx(const Field2D& UNUSED(val)) override {
@@ -116,10 +123,13 @@ private:
 
   int nmode;  // Number of modes being solved
   int xs, xe; // Start and end X indices
-  Matrix<dcomplex> a, b, c, bcmplx, xcmplx;
+  Matrix<dcomplex> bcmplx, xcmplx;
 
   bool dst;
 
+  /// FFTs in Z, which may be split between processors. Not used with dst
+  std::unique_ptr<bout::ZFourierTranspose> zfourier;
+
   CyclicReduce<dcomplex>* cr; ///< Tridiagonal solver
 };
 
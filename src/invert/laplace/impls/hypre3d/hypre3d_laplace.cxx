@@ -48,7 +48,11 @@ LaplaceHypre3d::LaplaceHypre3d(Options* opt, const CELL_LOC loc, Mesh* mesh_in,
       lowerY(localmesh->iterateBndryLowerY()), upperY(localmesh->iterateBndryUpperY()),
       indexer(std::make_shared<GlobalIndexer<Field3D>>(
           localmesh, getStencil(localmesh, lowerY, upperY))),
-      operator3D(indexer), solution(indexer), rhs(indexer),
+      operator3D(indexer, true,
+                 (*opts)["fixed_sparsity"]
+                     .doc("Build the matrix sparsity pattern once from the stencil")
+                     .withDefault(false)),
+      solution(indexer), rhs(indexer),
       linearSystem(*localmesh, *opts), monitor(*this) {
   // Provide basic initialisation of field coefficients, etc.
   // Get relevent options from user input
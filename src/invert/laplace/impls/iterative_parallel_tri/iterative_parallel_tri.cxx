@@ -71,6 +71,11 @@ LaplaceIPT::LaplaceIPT(Options* opt, CELL_LOC loc, Mesh* mesh_in, Solver* UNUSED
   C.setLocation(location);
   D.setLocation(location);
 
+  if (localmesh->getNZPE() > 1) {
+    throw BoutException("LaplaceIPT error: Z can't be split between processors "
+                        "(NZPE must be 1)");
+  }
+
   // Number of procs must be a factor of 2
   const int n = localmesh->NXPE;
   if (!is_pow2(n)) {
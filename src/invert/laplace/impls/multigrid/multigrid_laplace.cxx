@@ -105,6 +105,17 @@ LaplaceMultigrid::LaplaceMultigrid(Options* opt, const CELL_LOC loc, Mesh* mesh_
 
   commX = localmesh->getXcomm();
 
+  // The grids are coarsened and gathered assuming every X processor
+  // has the same number of points, which may not be the case if
+  // load_balance is set
+  for (int pex = 1; pex < localmesh->getNXPE(); ++pex) {
+    if (localmesh->getXProcOffset(pex + 1) - localmesh->getXProcOffset(pex)
+        != localmesh->getXProcOffset(1)) {
+      throw BoutException("LaplaceMultigrid error: every X processor must have the "
+                          "same number of points");
+    }
+  }
+
   Nx_local = localmesh->xend - localmesh->xstart + 1;      // excluding guard cells
   Nx_global = localmesh->GlobalNx - 2 * localmesh->xstart; // excluding guard cells
 
@@ -72,6 +72,11 @@ LaplacePCR::LaplacePCR(Options* opt, CELL_LOC loc, Mesh* mesh_in, Solver* UNUSED
   C2coef.setLocation(location);
   Dcoef.setLocation(location);
 
+  if (localmesh->getNZPE() > 1) {
+    throw BoutException("LaplacePCR error: Z can't be split between processors "
+                        "(NZPE must be 1)");
+  }
+
   // Number of X procs must be a power of 2
   const int nxpe = localmesh->getNXPE();
   if (!is_pow2(nxpe)) {
@@ -83,6 +88,16 @@ LaplacePCR::LaplacePCR(Options* opt, CELL_LOC loc, Mesh* mesh_in, Solver* UNUSED
     throw BoutException("LaplacePCR error: GlobalNxNoBoundaries must be a power of 2");
   }
 
+  // Every X processor must have the same number of points, which may
+  // not be the case if load_balance is set
+  for (int pex = 1; pex < nxpe; ++pex) {
+    if (localmesh->getXProcOffset(pex + 1) - localmesh->getXProcOffset(pex)
+        != localmesh->getXProcOffset(1)) {
+      throw BoutException("LaplacePCR error: every X processor must have the same "
+                          "number of points");
+    }
+  }
+
   Acoef.setLocation(location);
   C1coef.setLocation(location);
   C2coef.setLocation(location);
@@ -120,12 +135,14 @@ LaplacePCR::LaplacePCR(Options* opt, CELL_LOC loc, Mesh* mesh_in, Solver* UNUSED
   int n = xe - xs + 1; // Number of X points on this processor,
                        // including boundaries but not guard cells
 
-  a.reallocate(nmode, n);
-  b.reallocate(nmode, n);
-  c.reallocate(nmode, n);
   xcmplx.reallocate(nmode, n);
   bcmplx.reallocate(nmode, n);
 
+  cache_tridag_matrices = (*opt)["cache_coefficients"]
+                              .doc("Re-use the tridiagonal matrices between solves if "
+                                   "the coefficients and flags have not changed")
+                              .withDefault(false);
+
   xproc = localmesh->getXProcIndex(); // Local rank in x proc space
   const int yproc = localmesh->getYProcIndex();
   nprocs = localmesh->getNXPE();                    // Number of processors in x
@@ -188,25 +205,16 @@ FieldPerp LaplacePCR::solve(const FieldPerp& rhs, const FieldPerp& x0) {
           bcmplx(kz, ix - xs) = k1d[kz];
         }
       }
-
-      // Get elements of the tridiagonal matrix
-      // including boundary conditions
-      BOUT_OMP(for nowait)
-      for (int kz = 0; kz < nmode; kz++) {
-        BoutReal kwave =
-            kz * 2.0 * PI / (2. * zlen); // wave number is 1/[rad]; DST has extra 2.
-
-        tridagMatrix(&a(kz, 0), &b(kz, 0), &c(kz, 0), &bcmplx(kz, 0), jy,
-                     kz,    // wave number index
-                     kwave, // kwave (inverse wave length)
-                     global_flags, inner_boundary_flags, outer_boundary_flags, &Acoef,
-                     &C1coef, &C2coef, &Dcoef,
-                     false); // Don't include guard cells in arrays
-      }
     } // BOUT_OMP(parallel)
 
+    // Get elements of the tridiagonal matrix
+    // including boundary conditions
+    // wave number is 1/[rad]; DST has extra 2.
+    auto& matrices = getTridagWorkMatrices(jy, jy, nmode, 2. * zlen, &Acoef, &C1coef,
+                                           &C2coef, &Dcoef, true, bcmplx);
+
     // Solve tridiagonal systems
-    cr_pcr_solver(a, b, c, bcmplx, xcmplx);
+    cr_pcr_solver(matrices.a, matrices.b, matrices.c, bcmplx, xcmplx);
 
     // FFT back to real space
     BOUT_OMP(parallel)
@@ -233,77 +241,67 @@ FieldPerp LaplacePCR::solve(const FieldPerp& rhs, const FieldPerp& x0) {
     }
   } else {
     const BoutReal zlength = getUniform(coords->zlength());
-    BOUT_OMP(parallel)
-    {
-      /// Create a local thread-scope working array
-      auto k1d = Array<dcomplex>((localmesh->LocalNz) / 2
-                                 + 1); // ZFFT routine expects input of this length
-
-      // Loop over X indices, including boundaries but not guard cells (unless periodic in
-      // x)
-      BOUT_OMP(for)
-      for (int ix = xs; ix <= xe; ix++) {
-        // Take FFT in Z direction, apply shift, and put result in k1d
-
-        if (((ix < inbndry) && ((inner_boundary_flags & INVERT_SET) != 0)
-             && localmesh->firstX())
-            || ((localmesh->LocalNx - ix - 1 < outbndry)
-                && ((outer_boundary_flags & INVERT_SET) != 0) && localmesh->lastX())) {
-          // Use the values in x0 in the boundary
-          rfft(x0[ix], localmesh->LocalNz, std::begin(k1d));
-        } else {
-          rfft(rhs[ix], localmesh->LocalNz, std::begin(k1d));
-        }
-
-        // Copy into array, transposing so kz is first index
-        for (int kz = 0; kz < nmode; kz++) {
-          bcmplx(kz, ix - xs) = k1d[kz];
-        }
+    const int nx = xe - xs + 1;
+    const int nfft = localmesh->LocalNz / 2 + 1;
+
+    // Use the values in x0 in the boundary
+    const auto use_x0 = [&](int ix) {
+      return ((ix < inbndry) && ((inner_boundary_flags & INVERT_SET) != 0)
+              && localmesh->firstX())
+             || ((localmesh->LocalNx - ix - 1 < outbndry)
+                 && ((outer_boundary_flags & INVERT_SET) != 0) && localmesh->lastX());
+    };
+
+    // Take FFT in Z direction. Consecutive X points which use the
+    // same input are transformed together in one batch
+    auto k2d = Matrix<dcomplex>(nx, nfft);
+    int batch_start = xs;
+    while (batch_start <= xe) {
+      const bool batch_x0 = use_x0(batch_start);
+      int batch_end = batch_start;
+      while (batch_end < xe && use_x0(batch_end + 1) == batch_x0) {
+        ++batch_end;
       }
+      bout::fft::rfft(batch_x0 ? x0[batch_start] : rhs[batch_start], localmesh->LocalNz,
+                      batch_end - batch_start + 1, &k2d(batch_start - xs, 0));
+      batch_start = batch_end + 1;
+    }
 
-      // Get elements of the tridiagonal matrix
-      // including boundary conditions
-      BOUT_OMP(for nowait)
+    // Copy into array, transposing so kz is first index
+    BOUT_OMP(parallel for)
+    for (int ix = xs; ix <= xe; ix++) {
       for (int kz = 0; kz < nmode; kz++) {
-        BoutReal kwave = kz * 2.0 * PI / zlength; // wave number is 1/[rad]
-        tridagMatrix(&a(kz, 0), &b(kz, 0), &c(kz, 0), &bcmplx(kz, 0), jy,
-                     kz,    // True for the component constant (DC) in Z
-                     kwave, // Z wave number
-                     global_flags, inner_boundary_flags, outer_boundary_flags, &Acoef,
-                     &C1coef, &C2coef, &Dcoef,
-                     false); // Don't include guard cells in arrays
+        bcmplx(kz, ix - xs) = k2d(ix - xs, kz);
       }
-    } // BOUT_OMP(parallel)
+    }
+
+    // Get elements of the tridiagonal matrix
+    // including boundary conditions
+    auto& matrices = getTridagWorkMatrices(jy, jy, nmode, zlength, &Acoef, &C1coef,
+                                           &C2coef, &Dcoef, true, bcmplx);
 
     // Solve tridiagonal systems
-    cr_pcr_solver(a, b, c, bcmplx, xcmplx);
+    cr_pcr_solver(matrices.a, matrices.b, matrices.c, bcmplx, xcmplx);
 
     // FFT back to real space
-    BOUT_OMP(parallel)
-    {
-      /// Create a local thread-scope working array
-      auto k1d = Array<dcomplex>((localmesh->LocalNz) / 2
-                                 + 1); // ZFFT routine expects input of this length
-
-      const bool zero_DC = (global_flags & INVERT_ZERO_DC) != 0;
+    const bool zero_DC = (global_flags & INVERT_ZERO_DC) != 0;
 
-      BOUT_OMP(for nowait)
-      for (int ix = xs; ix <= xe; ix++) {
-        if (zero_DC) {
-          k1d[0] = 0.;
-        }
-
-        for (int kz = static_cast<int>(zero_DC); kz < nmode; kz++) {
-          k1d[kz] = xcmplx(kz, ix - xs);
-        }
+    BOUT_OMP(parallel for)
+    for (int ix = xs; ix <= xe; ix++) {
+      if (zero_DC) {
+        k2d(ix - xs, 0) = 0.;
+      }
 
-        for (int kz = nmode; kz < (localmesh->LocalNz) / 2 + 1; kz++) {
-          k1d[kz] = 0.0; // Filtering out all higher harmonics
-        }
+      for (int kz = static_cast<int>(zero_DC); kz < nmode; kz++) {
+        k2d(ix - xs, kz) = xcmplx(kz, ix - xs);
+      }
 
-        irfft(std::begin(k1d), localmesh->LocalNz, x[ix]);
+      for (int kz = nmode; kz < nfft; kz++) {
+        k2d(ix - xs, kz) = 0.0; // Filtering out all higher harmonics
       }
     }
+
+    bout::fft::irfft(&k2d(0, 0), localmesh->LocalNz, nx, x[xs]);
   }
 
   checkData(x);
@@ -362,10 +360,6 @@ Field3D LaplacePCR::solve(const Field3D& rhs, const Field3D& x0) {
   nsys = nmode * ny;            // Number of systems of equations to solve
   const int nxny = nx * ny;     // Number of points in X-Y
 
-  auto a3D = Matrix<dcomplex>(nsys, nx);
-  auto b3D = Matrix<dcomplex>(nsys, nx);
-  auto c3D = Matrix<dcomplex>(nsys, nx);
-
   auto xcmplx3D = Matrix<dcomplex>(nsys, nx);
   auto bcmplx3D = Matrix<dcomplex>(nsys, nx);
 
@@ -402,29 +396,16 @@ Field3D LaplacePCR::solve(const Field3D& rhs, const Field3D& x0) {
           bcmplx3D((iy - ys) * nmode + kz, ix - xs) = k1d[kz];
         }
       }
-
-      // Get elements of the tridiagonal matrix
-      // including boundary conditions
-      BOUT_OMP(for nowait)
-      for (int ind = 0; ind < nsys; ind++) {
-        // ind = (iy - ys) * nmode + kz
-        int iy = ys + ind / nmode;
-        int kz = ind % nmode;
-
-        BoutReal kwave =
-            kz * 2.0 * PI / (2. * zlen); // wave number is 1/[rad]; DST has extra 2.
-
-        tridagMatrix(&a3D(ind, 0), &b3D(ind, 0), &c3D(ind, 0), &bcmplx3D(ind, 0), iy,
-                     kz,    // wave number index
-                     kwave, // kwave (inverse wave length)
-                     global_flags, inner_boundary_flags, outer_boundary_flags, &Acoef,
-                     &C1coef, &C2coef, &Dcoef,
-                     false); // Don't include guard cells in arrays
-      }
     } // BOUT_OMP(parallel)
 
+    // Get elements of the tridiagonal matrix
+    // including boundary conditions
+    // wave number is 1/[rad]; DST has extra 2.
+    auto& matrices = getTridagWorkMatrices(ys, ye, nmode, 2. * zlen, &Acoef, &C1coef,
+                                           &C2coef, &Dcoef, true, bcmplx3D);
+
     // Solve tridiagonal systems
-    cr_pcr_solver(a3D, b3D, c3D, bcmplx3D, xcmplx3D);
+    cr_pcr_solver(matrices.a, matrices.b, matrices.c, bcmplx3D, xcmplx3D);
 
     // FFT back to real space
     BOUT_OMP(parallel)
@@ -455,87 +436,73 @@ Field3D LaplacePCR::solve(const Field3D& rhs, const Field3D& x0) {
     }
   } else {
     const BoutReal zlength = getUniform(coords->zlength());
+    const int nfft = localmesh->LocalNz / 2 + 1;
+
+    // Use the values in x0 in the boundary
+    const auto use_x0 = [&](int ix) {
+      return ((ix < inbndry) && ((inner_boundary_flags & INVERT_SET) != 0)
+              && localmesh->firstX())
+             || ((localmesh->LocalNx - ix - 1 < outbndry)
+                 && ((outer_boundary_flags & INVERT_SET) != 0) && localmesh->lastX());
+    };
+
     BOUT_OMP(parallel)
     {
       /// Create a local thread-scope working array
-      auto k1d = Array<dcomplex>(localmesh->LocalNz / 2
-                                 + 1); // ZFFT routine expects input of this length
+      auto k2d = Matrix<dcomplex>(ny, nfft);
 
-      // Loop over X and Y indices, including boundaries but not guard cells
+      // Loop over X indices, including boundaries but not guard cells
       // (unless periodic in x)
-
       BOUT_OMP(for)
-      for (int ind = 0; ind < nxny; ++ind) {
-        // ind = (ix - xs)*(ye - ys + 1) + (iy - ys)
-        int ix = xs + ind / ny;
-        int iy = ys + ind % ny;
-
-        // Take FFT in Z direction, apply shift, and put result in k1d
-
-        if (((ix < inbndry) && ((inner_boundary_flags & INVERT_SET) != 0)
-             && localmesh->firstX())
-            || ((localmesh->LocalNx - ix - 1 < outbndry)
-                && ((outer_boundary_flags & INVERT_SET) != 0) && localmesh->lastX())) {
-          // Use the values in x0 in the boundary
-          rfft(x0(ix, iy), localmesh->LocalNz, std::begin(k1d));
-        } else {
-          rfft(rhs(ix, iy), localmesh->LocalNz, std::begin(k1d));
-        }
+      for (int ix = xs; ix <= xe; ix++) {
+        // Take FFT in Z direction of all the Y points in one batch,
+        // and put result in k2d
+        bout::fft::rfft(use_x0(ix) ? x0(ix, ys) : rhs(ix, ys), localmesh->LocalNz, ny,
+                        &k2d(0, 0));
 
         // Copy into array, transposing so kz is first index
-        for (int kz = 0; kz < nmode; kz++) {
-          bcmplx3D((iy - ys) * nmode + kz, ix - xs) = k1d[kz];
+        for (int iy = ys; iy <= ye; iy++) {
+          for (int kz = 0; kz < nmode; kz++) {
+            bcmplx3D((iy - ys) * nmode + kz, ix - xs) = k2d(iy - ys, kz);
+          }
         }
       }
-
-      // Get elements of the tridiagonal matrix
-      // including boundary conditions
-      BOUT_OMP(for nowait)
-      for (int ind = 0; ind < nsys; ind++) {
-        // ind = (iy - ys) * nmode + kz
-        int iy = ys + ind / nmode;
-        int kz = ind % nmode;
-
-        BoutReal kwave = kz * 2.0 * PI / zlength; // wave number is 1/[rad]
-        tridagMatrix(&a3D(ind, 0), &b3D(ind, 0), &c3D(ind, 0), &bcmplx3D(ind, 0), iy,
-                     kz,    // True for the component constant (DC) in Z
-                     kwave, // Z wave number
-                     global_flags, inner_boundary_flags, outer_boundary_flags, &Acoef,
-                     &C1coef, &C2coef, &Dcoef,
-                     false); // Don't include guard cells in arrays
-      }
     } // BOUT_OMP(parallel)
 
+    // Get elements of the tridiagonal matrix
+    // including boundary conditions
+    auto& matrices = getTridagWorkMatrices(ys, ye, nmode, zlength, &Acoef, &C1coef,
+                                           &C2coef, &Dcoef, true, bcmplx3D);
+
     // Solve tridiagonal systems
-    cr_pcr_solver(a3D, b3D, c3D, bcmplx3D, xcmplx3D);
+    cr_pcr_solver(matrices.a, matrices.b, matrices.c, bcmplx3D, xcmplx3D);
 
     // FFT back to real space
     BOUT_OMP(parallel)
     {
       /// Create a local thread-scope working array
-      auto k1d = Array<dcomplex>((localmesh->LocalNz) / 2
-                                 + 1); // ZFFT routine expects input of this length
+      auto k2d = Matrix<dcomplex>(ny, nfft);
 
       const bool zero_DC = (global_flags & INVERT_ZERO_DC) != 0;
 
       BOUT_OMP(for nowait)
-      for (int ind = 0; ind < nxny; ++ind) { // Loop over X and Y
-        int ix = xs + ind / ny;
-        int iy = ys + ind % ny;
-
-        if (zero_DC) {
-          k1d[0] = 0.;
-        }
-
-        for (int kz = static_cast<int>(zero_DC); kz < nmode; kz++) {
-          k1d[kz] = xcmplx3D((iy - ys) * nmode + kz, ix - xs);
-        }
-
-        for (int kz = nmode; kz < localmesh->LocalNz / 2 + 1; kz++) {
-          k1d[kz] = 0.0; // Filtering out all higher harmonics
+      for (int ix = xs; ix <= xe; ix++) {
+        for (int iy = ys; iy <= ye; iy++) {
+          if (zero_DC) {
+            k2d(iy - ys, 0) = 0.;
+          }
+
+          for (int kz = static_cast<int>(zero_DC); kz < nmode; kz++) {
+            k2d(iy - ys, kz) = xcmplx3D((iy - ys) * nmode + kz, ix - xs);
+          }
+
+          for (int kz = nmode; kz < nfft; kz++) {
+            k2d(iy - ys, kz) = 0.0; // Filtering out all higher harmonics
+          }
         }
 
-        irfft(std::begin(k1d), localmesh->LocalNz, x(ix, iy));
+        // All the Y points are transformed in one batch
+        bout::fft::irfft(&k2d(0, 0), localmesh->LocalNz, ny, x(ix, ys));
       }
     }
   }
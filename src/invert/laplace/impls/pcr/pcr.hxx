@@ -49,6 +49,7 @@ public:
     ASSERT1(val.getLocation() == location);
     ASSERT1(localmesh == val.getMesh());
     Acoef = val;
+    invalidateTridagMatrices();
   }
   using Laplacian::setCoefC;
   void setCoefC(const Field2D& val) override {
@@ -60,18 +61,21 @@ public:
     ASSERT1(val.getLocation() == location);
     ASSERT1(localmesh == val.getMesh());
     C1coef = val;
+    invalidateTridagMatrices();
   }
   using Laplacian::setCoefC2;
   void setCoefC2(const Field2D& val) override {
     ASSERT1(val.getLocation() == location);
     ASSERT1(localmesh == val.getMesh());
     C2coef = val;
+    invalidateTridagMatrices();
   }
   using Laplacian::setCoefD;
   void setCoefD(const Field2D& val) override {
     ASSERT1(val.getLocation() == location);
     ASSERT1(localmesh == val.getMesh());
     Dcoef = val;
+    invalidateTridagMatrices();
   }
   using Laplacian::setCoefEx;
   void setCoefEx(const Field2D& UNUSED(val)) override {
@@ -124,11 +128,11 @@ private:
   int outbndry;
 
   /// Local private pointer for coefficient maxtix a
-  Matrix<dcomplex> a, aa;
+  Matrix<dcomplex> aa;
   /// Local private pointer for coefficient maxtix b
-  Matrix<dcomplex> b, bb;
+  Matrix<dcomplex> bb;
   /// Local private pointer for coefficient maxtix c
-  Matrix<dcomplex> c, cc;
+  Matrix<dcomplex> cc;
   /// Local private pointer for RHS vector r
   Matrix<dcomplex> r;
   /// Local private pointer for solution vector x
@@ -70,6 +70,11 @@ LaplacePCR_THOMAS::LaplacePCR_THOMAS(Options* opt, CELL_LOC loc, Mesh* mesh_in,
   C2coef.setLocation(location);
   Dcoef.setLocation(location);
 
+  if (localmesh->getNZPE() > 1) {
+    throw BoutException("LaplacePCR_THOMAS error: Z can't be split between processors "
+                        "(NZPE must be 1)");
+  }
+
   // Number of X procs must be a power of 2
   const int nxpe = localmesh->getNXPE();
   if (!is_pow2(nxpe)) {
@@ -81,6 +86,16 @@ LaplacePCR_THOMAS::LaplacePCR_THOMAS(Options* opt, CELL_LOC loc, Mesh* mesh_in,
     throw BoutException("LaplacePCR_THOMAS error: GlobalNx must be a power of 2");
   }
 
+  // Every X processor must have the same number of points, which may
+  // not be the case if load_balance is set
+  for (int pex = 1; pex < nxpe; ++pex) {
+    if (localmesh->getXProcOffset(pex + 1) - localmesh->getXProcOffset(pex)
+        != localmesh->getXProcOffset(1)) {
+      throw BoutException("LaplacePCR_THOMAS error: every X processor must have the same "
+                          "number of points");
+    }
+  }
+
   Acoef.setLocation(location);
   C1coef.setLocation(location);
   C2coef.setLocation(location);
@@ -116,12 +131,14 @@ LaplacePCR_THOMAS::LaplacePCR_THOMAS(Options* opt, CELL_LOC loc, Mesh* mesh_in,
   int n = xe - xs + 1; // Number of X points on this processor,
                        // including boundaries but not guard cells
 
-  a.reallocate(nmode, n);
-  b.reallocate(nmode, n);
-  c.reallocate(nmode, n);
   xcmplx.reallocate(nmode, n);
   bcmplx.reallocate(nmode, n);
 
+  cache_tridag_matrices = (*opt)["cache_coefficients"]
+                              .doc("Re-use the tridiagonal matrices between solves if "
+                                   "the coefficients and flags have not changed")
+                              .withDefault(false);
+
   xproc = localmesh->getXProcIndex(); // Local rank in x proc space
   const int yproc = localmesh->getYProcIndex();
   nprocs = localmesh->getNXPE();                    // Number of processors in x
@@ -184,25 +201,16 @@ FieldPerp LaplacePCR_THOMAS::solve(const FieldPerp& rhs, const FieldPerp& x0) {
           bcmplx(kz, ix - xs) = k1d[kz];
         }
       }
-
-      // Get elements of the tridiagonal matrix
-      // including boundary conditions
-      BOUT_OMP(for nowait)
-      for (int kz = 0; kz < nmode; kz++) {
-        // wave number is 1/[rad]; DST has extra 2.
-        const BoutReal kwave = kz * 2.0 * PI / (2. * zlength);
-
-        tridagMatrix(&a(kz, 0), &b(kz, 0), &c(kz, 0), &bcmplx(kz, 0), jy,
-                     kz,    // wave number index
-                     kwave, // kwave (inverse wave length)
-                     global_flags, inner_boundary_flags, outer_boundary_flags, &Acoef,
-                     &C1coef, &C2coef, &Dcoef,
-                     false); // Don't include guard cells in arrays
-      }
     }
 
+    // Get elements of the tridiagonal matrix
+    // including boundary conditions
+    // wave number is 1/[rad]; DST has extra 2.
+    auto& matrices = getTridagWorkMatrices(jy, jy, nmode, 2. * zlength, &Acoef, &C1coef,
+                                           &C2coef, &Dcoef, true, bcmplx);
+
     // Solve tridiagonal systems
-    pcr_thomas_solver(a, b, c, bcmplx, xcmplx);
+    pcr_thomas_solver(matrices.a, matrices.b, matrices.c, bcmplx, xcmplx);
 
     // FFT back to real space
     BOUT_OMP(parallel)
@@ -256,23 +264,15 @@ FieldPerp LaplacePCR_THOMAS::solve(const FieldPerp& rhs, const FieldPerp& x0) {
           bcmplx(kz, ix - xs) = k1d[kz];
         }
       }
-
-      // Get elements of the tridiagonal matrix
-      // including boundary conditions
-      BOUT_OMP(for nowait)
-      for (int kz = 0; kz < nmode; kz++) {
-        const BoutReal kwave = kz * 2.0 * PI / zlength; // wave number is 1/[rad]
-        tridagMatrix(&a(kz, 0), &b(kz, 0), &c(kz, 0), &bcmplx(kz, 0), jy,
-                     kz,    // True for the component constant (DC) in Z
-                     kwave, // Z wave number
-                     global_flags, inner_boundary_flags, outer_boundary_flags, &Acoef,
-                     &C1coef, &C2coef, &Dcoef,
-                     false); // Don't include guard cells in arrays
-      }
     }
 
+    // Get elements of the tridiagonal matrix
+    // including boundary conditions
+    auto& matrices = getTridagWorkMatrices(jy, jy, nmode, zlength, &Acoef, &C1coef,
+                                           &C2coef, &Dcoef, true, bcmplx);
+
     // Solve tridiagonal systems
-    pcr_thomas_solver(a, b, c, bcmplx, xcmplx);
+    pcr_thomas_solver(matrices.a, matrices.b, matrices.c, bcmplx, xcmplx);
 
     // FFT back to real space
     BOUT_OMP(parallel)
@@ -358,10 +358,6 @@ Field3D LaplacePCR_THOMAS::solve(const Field3D& rhs, const Field3D& x0) {
   nsys = nmode * ny;            // Number of systems of equations to solve
   const int nxny = nx * ny;     // Number of points in X-Y
 
-  auto a3D = Matrix<dcomplex>(nsys, nx);
-  auto b3D = Matrix<dcomplex>(nsys, nx);
-  auto c3D = Matrix<dcomplex>(nsys, nx);
-
   auto xcmplx3D = Matrix<dcomplex>(nsys, nx);
   auto bcmplx3D = Matrix<dcomplex>(nsys, nx);
 
@@ -398,29 +394,16 @@ Field3D LaplacePCR_THOMAS::solve(const Field3D& rhs, const Field3D& x0) {
           bcmplx3D((iy - ys) * nmode + kz, ix - xs) = k1d[kz];
         }
       }
-
-      // Get elements of the tridiagonal matrix
-      // including boundary conditions
-      BOUT_OMP(for nowait)
-      for (int ind = 0; ind < nsys; ind++) {
-        // ind = (iy - ys) * nmode + kz
-        int iy = ys + ind / nmode;
-        int kz = ind % nmode;
-
-        // wave number is 1/[rad]; DST has extra 2.
-        BoutReal kwave = kz * 2.0 * PI / (2. * zlength);
-
-        tridagMatrix(&a3D(ind, 0), &b3D(ind, 0), &c3D(ind, 0), &bcmplx3D(ind, 0), iy,
-                     kz,    // wave number index
-                     kwave, // kwave (inverse wave length)
-                     global_flags, inner_boundary_flags, outer_boundary_flags, &Acoef,
-                     &C1coef, &C2coef, &Dcoef,
-                     false); // Don't include guard cells in arrays
-      }
     }
 
+    // Get elements of the tridiagonal matrix
+    // including boundary conditions
+    // wave number is 1/[rad]; DST has extra 2.
+    auto& matrices = getTridagWorkMatrices(ys, ye, nmode, 2. * zlength, &Acoef, &C1coef,
+                                           &C2coef, &Dcoef, true, bcmplx3D);
+
     // Solve tridiagonal systems
-    pcr_thomas_solver(a3D, b3D, c3D, bcmplx3D, xcmplx3D);
+    pcr_thomas_solver(matrices.a, matrices.b, matrices.c, bcmplx3D, xcmplx3D);
 
     // FFT back to real space
     BOUT_OMP(parallel)
@@ -483,28 +466,15 @@ Field3D LaplacePCR_THOMAS::solve(const Field3D& rhs, const Field3D& x0) {
           bcmplx3D((iy - ys) * nmode + kz, ix - xs) = k1d[kz];
         }
       }
-
-      // Get elements of the tridiagonal matrix
-      // including boundary conditions
-      BOUT_OMP(for nowait)
-      for (int ind = 0; ind < nsys; ind++) {
-        // ind = (iy - ys) * nmode + kz
-        int iy = ys + ind / nmode;
-        int kz = ind % nmode;
-
-        // wave number is 1/[rad]
-        BoutReal kwave = kz * 2.0 * PI / zlength;
-        tridagMatrix(&a3D(ind, 0), &b3D(ind, 0), &c3D(ind, 0), &bcmplx3D(ind, 0), iy,
-                     kz,    // True for the component constant (DC) in Z
-                     kwave, // Z wave number
-                     global_flags, inner_boundary_flags, outer_boundary_flags, &Acoef,
-                     &C1coef, &C2coef, &Dcoef,
-                     false); // Don't include guard cells in arrays
-      }
     }
 
+    // Get elements of the tridiagonal matrix
+    // including boundary conditions
+    auto& matrices = getTridagWorkMatrices(ys, ye, nmode, zlength, &Acoef, &C1coef,
+                                           &C2coef, &Dcoef, true, bcmplx3D);
+
     // Solve tridiagonal systems
-    pcr_thomas_solver(a3D, b3D, c3D, bcmplx3D, xcmplx3D);
+    pcr_thomas_solver(matrices.a, matrices.b, matrices.c, bcmplx3D, xcmplx3D);
 
     // FFT back to real space
     BOUT_OMP(parallel)
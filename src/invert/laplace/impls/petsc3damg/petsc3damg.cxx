@@ -45,7 +45,11 @@ LaplacePetsc3dAmg::LaplacePetsc3dAmg(Options* opt, const CELL_LOC loc, Mesh* mes
       lowerY(localmesh->iterateBndryLowerY()), upperY(localmesh->iterateBndryUpperY()),
       indexer(std::make_shared<GlobalIndexer<Field3D>>(
           localmesh, getStencil(localmesh, lowerY, upperY))),
-      operator3D(indexer), kspInitialised(false),
+      operator3D(indexer, true,
+                 (opt == nullptr ? Options::root()["laplace"] : *opt)["fixed_sparsity"]
+                     .doc("Build the matrix sparsity pattern once from the stencil")
+                     .withDefault(false)),
+      kspInitialised(false),
       lib(opt == nullptr ? &(Options::root()["laplace"]) : opt) {
   // Provide basic initialisation of field coefficients, etc.
   // Get relevent options from user input
@@ -461,6 +465,18 @@ void LaplacePetsc3dAmg::updateMatrix3D() {
   operator3D.assemble();
   MatSetBlockSize(*operator3D.get(), 1);
 
+  if (kspInitialised && operator3D.hasFixedSparsity()) {
+    // The nonzero pattern has not changed, so keep the Krylov solver
+    // and only give it the new values
+#if PETSC_VERSION_GE(3, 5, 0)
+    KSPSetOperators(ksp, *operator3D.get(), *operator3D.get());
+#else
+    KSPSetOperators(ksp, *operator3D.get(), *operator3D.get(), SAME_NONZERO_PATTERN);
+#endif
+    updateRequired = false;
+    return;
+  }
+
   // Declare KSP Context (abstract PETSc object that manages all Krylov methods)
   if (kspInitialised) {
     KSPDestroy(&ksp);
@@ -36,6 +36,7 @@
 #include <bout/lapack_routines.hxx>
 #include <bout/mesh.hxx>
 #include <bout/openmpwrap.hxx>
+#include <bout/sys/timer.hxx>
 #include <bout/utils.hxx>
 
 #include <bout/output.hxx>
@@ -49,6 +50,11 @@ LaplaceSerialBand::LaplaceSerialBand(Options* opt, const CELL_LOC loc, Mesh* mes
   Ccoef.setLocation(location);
   Dcoef.setLocation(location);
 
+  if (localmesh->getNZPE() > 1) {
+    throw BoutException("LaplaceSerialBand error: Z can't be split between processors "
+                        "(NZPE must be 1)");
+  }
+
   if (!localmesh->firstX() || !localmesh->lastX()) {
     throw BoutException("LaplaceSerialBand only works for localmesh->NXPE = 1");
   }
@@ -116,6 +122,149 @@ FieldPerp LaplaceSerialBand::solve(const FieldPerp& b, const FieldPerp& x0) {
     }
   }
 
+  const auto kwave_fac = TWOPI / coords->zlength(); // wave number is 1/[rad]
+  for (int iz = 0; iz <= maxmode; iz++) {
+    // set bk1d
+    for (int ix = 0; ix < localmesh->LocalNx; ix++) {
+      bk1d[ix] = bk(ix, iz);
+    }
+
+    solveMode(jy, iz, kwave_fac, A, bk1d);
+
+    // Fill xk
+    for (int ix = 0; ix <= ncx; ix++) {
+      xk(ix, iz) = bk1d[ix];
+    }
+  }
+
+  // Done inversion, transform back
+
+  for (int ix = 0; ix <= ncx; ix++) {
+    if (global_flags & INVERT_ZERO_DC) {
+      xk(ix, 0) = 0.0;
+    }
+
+    irfft(&xk(ix, 0), ncz, x[ix]);
+  }
+
+  checkData(x);
+  return x;
+}
+
+Field3D LaplaceSerialBand::solve(const Field3D& b, const Field3D& x0) {
+  TRACE("LaplaceSerialBand::solve(Field3D, Field3D)");
+
+  ASSERT1(localmesh == b.getMesh() && localmesh == x0.getMesh());
+  ASSERT1(b.getLocation() == location);
+  ASSERT1(x0.getLocation() == location);
+
+  Timer timer("invert");
+
+  Field3D x{emptyFrom(b)};
+
+  // Range of Y indices, as in Laplacian::solve(Field3D)
+  int ys = localmesh->ystart, ye = localmesh->yend;
+  if (localmesh->hasBndryLowerY()) {
+    if (include_yguards) {
+      ys = 0;
+    }
+    ys += extra_yguards_lower;
+  }
+  if (localmesh->hasBndryUpperY()) {
+    if (include_yguards) {
+      ye = localmesh->LocalNy - 1;
+    }
+    ye -= extra_yguards_upper;
+  }
+
+  const int ncz = localmesh->LocalNz;
+  const int nx = localmesh->LocalNx;
+  const int ncx = nx - 1;
+  const int ny = ye - ys + 1;
+  const int nmode = maxmode + 1;
+  const int nfft = ncz / 2 + 1;
+  const int nsys = ny * nmode; // Number of band systems to solve
+
+  int xbndry = localmesh->xstart; // Width of the x boundary
+  // If the flags to assign that only one guard cell should be used is set
+  if ((global_flags & INVERT_BOTH_BNDRY_ONE) || (localmesh->xstart < 2)) {
+    xbndry = 1;
+  }
+
+  // Right hand sides, and then solutions, of all the systems, with
+  // system (iy - ys) * nmode + kz in each row
+  auto bk3d = Matrix<dcomplex>(nsys, nx);
+
+  const auto kwave_fac = TWOPI / coords->zlength(); // wave number is 1/[rad]
+
+  BOUT_OMP(parallel)
+  {
+    auto k2d = Matrix<dcomplex>(ny, nfft);
+
+    BOUT_OMP(for)
+    for (int ix = 0; ix < nx; ix++) {
+      // Take FFT in Z direction of all the Y points in one batch
+      const bool use_x0 = ((ix < xbndry) && (inner_boundary_flags & INVERT_SET))
+                          || ((ncx - ix < xbndry) && (outer_boundary_flags & INVERT_SET));
+      bout::fft::rfft(use_x0 ? x0(ix, ys) : b(ix, ys), ncz, ny, &k2d(0, 0));
+
+      for (int iy = 0; iy < ny; iy++) {
+        for (int kz = 0; kz < nmode; kz++) {
+          bk3d(iy * nmode + kz, ix) = k2d(iy, kz);
+        }
+      }
+    }
+
+    // Each thread needs its own band matrix and work array
+    auto matrix = Matrix<dcomplex>(nx, 5);
+    auto bk1d = Array<dcomplex>(nx);
+
+    BOUT_OMP(for)
+    for (int ind = 0; ind < nsys; ind++) {
+      const int jy = ys + ind / nmode;
+      const int kz = ind % nmode;
+
+      for (int ix = 0; ix < nx; ix++) {
+        bk1d[ix] = bk3d(ind, ix);
+      }
+      solveMode(jy, kz, kwave_fac, matrix, bk1d);
+      for (int ix = 0; ix < nx; ix++) {
+        bk3d(ind, ix) = bk1d[ix];
+      }
+    }
+
+    // Done inversion, transform back
+    const bool zero_DC = (global_flags & INVERT_ZERO_DC) != 0;
+
+    BOUT_OMP(for nowait)
+    for (int ix = 0; ix < nx; ix++) {
+      for (int iy = 0; iy < ny; iy++) {
+        for (int kz = 0; kz < nfft; kz++) {
+          k2d(iy, kz) = (kz < nmode) ? bk3d(iy * nmode + kz, ix) : 0.0;
+        }
+        if (zero_DC) {
+          k2d(iy, 0) = 0.0;
+        }
+      }
+
+      bout::fft::irfft(&k2d(0, 0), ncz, ny, x(ix, ys));
+    }
+  }
+
+  checkData(x);
+  return x;
+}
+
+void LaplaceSerialBand::solveMode(int jy, int iz, const Field2D& kwave_fac,
+                                  Matrix<dcomplex>& matrix, Array<dcomplex>& bk1d) {
+  int ncx = localmesh->LocalNx - 1;
+
+  int xbndry = localmesh->xstart; // Width of the x boundary
+  // If the flags to assign that only one guard cell should be used is set
+  if ((global_flags & INVERT_BOTH_BNDRY_ONE) || (localmesh->xstart < 2)) {
+    xbndry = 1;
+  }
+
   int xstart, xend;
   // Get range for 4th order: Need at least 2 each side
   if (xbndry > 1) {
@@ -126,329 +275,301 @@ FieldPerp LaplaceSerialBand::solve(const FieldPerp& b, const FieldPerp& x0) {
     xend = localmesh->LocalNx - 2;
   }
 
-  const auto kwave_fac = TWOPI / coords->zlength(); // wave number is 1/[rad]
-  for (int iz = 0; iz <= maxmode; iz++) {
-    // solve differential equation in x
-
-    BoutReal coef1 = 0.0, coef2 = 0.0, coef3 = 0.0, coef4 = 0.0, coef5 = 0.0, coef6 = 0.0;
-    ///////// PERFORM INVERSION /////////
+  // solve differential equation in x
 
-    // shift freqs according to FFT convention
-    const Field2D kwave_ = iz * kwave_fac;
+  BoutReal coef1 = 0.0, coef2 = 0.0, coef3 = 0.0, coef4 = 0.0, coef5 = 0.0, coef6 = 0.0;
+  ///////// PERFORM INVERSION /////////
 
-    // set bk1d
-    for (int ix = 0; ix < localmesh->LocalNx; ix++) {
-      bk1d[ix] = bk(ix, iz);
-    }
+  // Fill in interior points
 
-    // Fill in interior points
-
-    for (int ix = xstart; ix <= xend; ix++) {
-      BoutReal kwave = kwave_(ix, jy);
+  for (int ix = xstart; ix <= xend; ix++) {
+    BoutReal kwave = iz * kwave_fac(ix, jy);
 #ifdef SECONDORDER
-      // Use second-order differencing. Useful for testing the tridiagonal solver
-      // with different boundary conditions
-      dcomplex a, b, c;
-      tridagCoefs(ix, jy, iz, a, b, c, &Ccoef, &Dcoef);
-
-      A(ix, 0) = 0.;
-      A(ix, 1) = a;
-      A(ix, 2) = b + Acoef(ix, jy);
-      A(ix, 3) = c;
-      A(ix, 4) = 0.;
+    // Use second-order differencing. Useful for testing the tridiagonal solver
+    // with different boundary conditions
+    dcomplex a, b, c;
+    tridagCoefs(ix, jy, iz, a, b, c, &Ccoef, &Dcoef);
+
+    matrix(ix, 0) = 0.;
+    matrix(ix, 1) = a;
+    matrix(ix, 2) = b + Acoef(ix, jy);
+    matrix(ix, 3) = c;
+    matrix(ix, 4) = 0.;
 #else
-      // Set coefficients
-      coef1 = coords->g11(ix, jy); // X 2nd derivative
-      coef2 = coords->g33(ix, jy); // Z 2nd derivative
-      coef3 = coords->g13(ix, jy); // X-Z mixed derivatives
-      coef4 = 0.0;                 // X 1st derivative
-      coef5 = 0.0;                 // Z 1st derivative
-      coef6 = Acoef(ix, jy);       // Constant
-
-      // Multiply Delp2 component by a factor
-      coef1 *= Dcoef(ix, jy);
-      coef2 *= Dcoef(ix, jy);
-      coef3 *= Dcoef(ix, jy);
-
-      if (all_terms) {
-        coef4 = coords->G1(ix, jy);
-        coef5 = coords->G3(ix, jy);
-      }
+    // Set coefficients
+    coef1 = coords->g11(ix, jy); // X 2nd derivative
+    coef2 = coords->g33(ix, jy); // Z 2nd derivative
+    coef3 = coords->g13(ix, jy); // X-Z mixed derivatives
+    coef4 = 0.0;                 // X 1st derivative
+    coef5 = 0.0;                 // Z 1st derivative
+    coef6 = Acoef(ix, jy);       // Constant
+
+    // Multiply Delp2 component by a factor
+    coef1 *= Dcoef(ix, jy);
+    coef2 *= Dcoef(ix, jy);
+    coef3 *= Dcoef(ix, jy);
+
+    if (all_terms) {
+      coef4 = coords->G1(ix, jy);
+      coef5 = coords->G3(ix, jy);
+    }
 
-      if (nonuniform) {
-        // non-uniform localmesh correction
-        if ((ix != 0) && (ix != ncx)) {
-          coef4 += coords->g11(ix, jy)
-                   * ((1.0 / coords->dx(ix + 1, jy)) - (1.0 / coords->dx(ix - 1, jy)))
-                   / (2.0 * coords->dx(ix, jy));
-        }
+    if (nonuniform) {
+      // non-uniform localmesh correction
+      if ((ix != 0) && (ix != ncx)) {
+        coef4 += coords->g11(ix, jy)
+                 * ((1.0 / coords->dx(ix + 1, jy)) - (1.0 / coords->dx(ix - 1, jy)))
+                 / (2.0 * coords->dx(ix, jy));
       }
+    }
 
-      // A first order derivative term (1/c)\nabla_perp c\cdot\nabla_\perp x
+    // A first order derivative term (1/c)\nabla_perp c\cdot\nabla_\perp x
 
-      if ((ix > 1) && (ix < (localmesh->LocalNx - 2))) {
-        coef4 += coords->g11(ix, jy)
-                 * (Ccoef(ix - 2, jy) - 8. * Ccoef(ix - 1, jy) + 8. * Ccoef(ix + 1, jy)
-                    - Ccoef(ix + 2, jy))
-                 / (12. * coords->dx(ix, jy) * (Ccoef(ix, jy)));
-      }
+    if ((ix > 1) && (ix < (localmesh->LocalNx - 2))) {
+      coef4 += coords->g11(ix, jy)
+               * (Ccoef(ix - 2, jy) - 8. * Ccoef(ix - 1, jy) + 8. * Ccoef(ix + 1, jy)
+                  - Ccoef(ix + 2, jy))
+               / (12. * coords->dx(ix, jy) * (Ccoef(ix, jy)));
+    }
 
-      // Put into matrix
-      coef1 /= 12. * SQ(coords->dx(ix, jy));
-      coef2 *= SQ(kwave);
-      coef3 *= kwave / (12. * coords->dx(ix, jy));
-      coef4 /= 12. * coords->dx(ix, jy);
-      coef5 *= kwave;
-
-      A(ix, 0) = dcomplex(-coef1 + coef4, coef3);
-      A(ix, 1) = dcomplex(16. * coef1 - 8 * coef4, -8. * coef3);
-      A(ix, 2) = dcomplex(-30. * coef1 - coef2 + coef6, coef5);
-      A(ix, 3) = dcomplex(16. * coef1 + 8 * coef4, 8. * coef3);
-      A(ix, 4) = dcomplex(-coef1 - coef4, -coef3);
+    // Put into matrix
+    coef1 /= 12. * SQ(coords->dx(ix, jy));
+    coef2 *= SQ(kwave);
+    coef3 *= kwave / (12. * coords->dx(ix, jy));
+    coef4 /= 12. * coords->dx(ix, jy);
+    coef5 *= kwave;
+
+    matrix(ix, 0) = dcomplex(-coef1 + coef4, coef3);
+    matrix(ix, 1) = dcomplex(16. * coef1 - 8 * coef4, -8. * coef3);
+    matrix(ix, 2) = dcomplex(-30. * coef1 - coef2 + coef6, coef5);
+    matrix(ix, 3) = dcomplex(16. * coef1 + 8 * coef4, 8. * coef3);
+    matrix(ix, 4) = dcomplex(-coef1 - coef4, -coef3);
 #endif
-    }
+  }
 
-    if (xbndry < 2) {
-      // Use 2nd order near edges
+  if (xbndry < 2) {
+    // Use 2nd order near edges
 
-      int ix = 1;
+    int ix = 1;
 
-      auto kwave = kwave_(ix, jy);
-      coef1 = coords->g11(ix, jy) / (SQ(coords->dx(ix, jy)));
-      coef2 = coords->g33(ix, jy);
-      coef3 = kwave * coords->g13(ix, jy) / (2. * coords->dx(ix, jy));
+    auto kwave = iz * kwave_fac(ix, jy);
+    coef1 = coords->g11(ix, jy) / (SQ(coords->dx(ix, jy)));
+    coef2 = coords->g33(ix, jy);
+    coef3 = kwave * coords->g13(ix, jy) / (2. * coords->dx(ix, jy));
 
-      // Multiply Delp2 component by a factor
-      coef1 *= Dcoef(ix, jy);
-      coef2 *= Dcoef(ix, jy);
-      coef3 *= Dcoef(ix, jy);
+    // Multiply Delp2 component by a factor
+    coef1 *= Dcoef(ix, jy);
+    coef2 *= Dcoef(ix, jy);
+    coef3 *= Dcoef(ix, jy);
 
-      A(ix, 0) = 0.0; // Should never be used
-      A(ix, 1) = dcomplex(coef1, -coef3);
-      A(ix, 2) = dcomplex(-2.0 * coef1 - SQ(kwave) * coef2 + coef4, 0.0);
-      A(ix, 3) = dcomplex(coef1, coef3);
-      A(ix, 4) = 0.0;
+    matrix(ix, 0) = 0.0; // Should never be used
+    matrix(ix, 1) = dcomplex(coef1, -coef3);
+    matrix(ix, 2) = dcomplex(-2.0 * coef1 - SQ(kwave) * coef2 + coef4, 0.0);
+    matrix(ix, 3) = dcomplex(coef1, coef3);
+    matrix(ix, 4) = 0.0;
 
-      ix = ncx - 1;
+    ix = ncx - 1;
 
-      coef1 = coords->g11(ix, jy) / (SQ(coords->dx(ix, jy)));
-      coef2 = coords->g33(ix, jy);
-      coef3 = kwave * coords->g13(ix, jy) / (2. * coords->dx(ix, jy));
+    coef1 = coords->g11(ix, jy) / (SQ(coords->dx(ix, jy)));
+    coef2 = coords->g33(ix, jy);
+    coef3 = kwave * coords->g13(ix, jy) / (2. * coords->dx(ix, jy));
+
+    matrix(ix, 0) = 0.0;
+    matrix(ix, 1) = dcomplex(coef1, -coef3);
+    matrix(ix, 2) = dcomplex(-2.0 * coef1 - SQ(kwave) * coef2 + coef4, 0.0);
+    matrix(ix, 3) = dcomplex(coef1, coef3);
+    matrix(ix, 4) = 0.0; // Should never be used
+  }
+
+  // Boundary conditions
 
-      A(ix, 0) = 0.0;
-      A(ix, 1) = dcomplex(coef1, -coef3);
-      A(ix, 2) = dcomplex(-2.0 * coef1 - SQ(kwave) * coef2 + coef4, 0.0);
-      A(ix, 3) = dcomplex(coef1, coef3);
-      A(ix, 4) = 0.0; // Should never be used
+  for (int ix = 0; ix < xbndry; ix++) {
+    // Set zero-value. Change to zero-gradient if needed
+
+    if (!(inner_boundary_flags & (INVERT_RHS | INVERT_SET))) {
+      bk1d[ix] = 0.0;
+    }
+    if (!(outer_boundary_flags & (INVERT_RHS | INVERT_SET))) {
+      bk1d[ncx - ix] = 0.0;
     }
 
-    // Boundary conditions
+    matrix(ix, 0) = matrix(ix, 1) = matrix(ix, 3) = matrix(ix, 4) = 0.0;
+    matrix(ix, 2) = 1.0;
 
-    for (int ix = 0; ix < xbndry; ix++) {
-      // Set zero-value. Change to zero-gradient if needed
+    matrix(ncx - ix, 0) = matrix(ncx - ix, 1) = matrix(ncx - ix, 3) =
+        matrix(ncx - ix, 4) = 0.0;
+    matrix(ncx - ix, 2) = 1.0;
+  }
 
-      if (!(inner_boundary_flags & (INVERT_RHS | INVERT_SET))) {
-        bk1d[ix] = 0.0;
-      }
-      if (!(outer_boundary_flags & (INVERT_RHS | INVERT_SET))) {
-        bk1d[ncx - ix] = 0.0;
+  if (iz == 0) {
+    // DC
+
+    // Inner boundary
+    if (inner_boundary_flags & (INVERT_DC_GRAD + INVERT_SET)
+        || inner_boundary_flags & (INVERT_DC_GRAD + INVERT_RHS)) {
+      // Zero gradient at inner boundary. 2nd-order accurate
+      // Boundary at midpoint
+      for (int ix = 0; ix < xbndry; ix++) {
+        matrix(ix, 0) = 0.;
+        matrix(ix, 1) = 0.;
+        matrix(ix, 2) = -.5 / sqrt(coords->g_11(ix, jy)) / coords->dx(ix, jy);
+        matrix(ix, 3) = .5 / sqrt(coords->g_11(ix, jy)) / coords->dx(ix, jy);
+        matrix(ix, 4) = 0.;
       }
 
-      A(ix, 0) = A(ix, 1) = A(ix, 3) = A(ix, 4) = 0.0;
-      A(ix, 2) = 1.0;
+    } else if (inner_boundary_flags & INVERT_DC_GRAD) {
+      // Zero gradient at inner boundary. 2nd-order accurate
+      // Boundary at midpoint
+      for (int ix = 0; ix < xbndry; ix++) {
+        matrix(ix, 0) = 0.;
+        matrix(ix, 1) = 0.;
+        matrix(ix, 2) = -.5;
+        matrix(ix, 3) = .5;
+        matrix(ix, 4) = 0.;
+      }
 
-      A(ncx - ix, 0) = A(ncx - ix, 1) = A(ncx - ix, 3) = A(ncx - ix, 4) = 0.0;
-      A(ncx - ix, 2) = 1.0;
+    } else if (inner_boundary_flags & INVERT_DC_GRADPAR) {
+      for (int ix = 0; ix < xbndry; ix++) {
+        matrix(ix, 0) = 0.;
+        matrix(ix, 1) = 0.;
+        matrix(ix, 2) = -3. / sqrt(coords->g_22(ix, jy));
+        matrix(ix, 3) = 4. / sqrt(coords->g_22(ix + 1, jy));
+        matrix(ix, 4) = -1. / sqrt(coords->g_22(ix + 2, jy));
+      }
+    } else if (inner_boundary_flags & INVERT_DC_GRADPARINV) {
+      for (int ix = 0; ix < xbndry; ix++) {
+        matrix(ix, 0) = 0.;
+        matrix(ix, 1) = 0.;
+        matrix(ix, 2) = -3. * sqrt(coords->g_22(ix, jy));
+        matrix(ix, 3) = 4. * sqrt(coords->g_22(ix + 1, jy));
+        matrix(ix, 4) = -sqrt(coords->g_22(ix + 2, jy));
+      }
+    } else if (inner_boundary_flags & INVERT_DC_LAP) {
+      for (int ix = 0; ix < xbndry; ix++) {
+        matrix(ix, 0) = 0.;
+        matrix(ix, 1) = 0.;
+        matrix(ix, 2) = 1.;
+        matrix(ix, 3) = -2;
+        matrix(ix, 4) = 1.;
+      }
     }
 
-    if (iz == 0) {
-      // DC
-
-      // Inner boundary
-      if (inner_boundary_flags & (INVERT_DC_GRAD + INVERT_SET)
-          || inner_boundary_flags & (INVERT_DC_GRAD + INVERT_RHS)) {
-        // Zero gradient at inner boundary. 2nd-order accurate
-        // Boundary at midpoint
-        for (int ix = 0; ix < xbndry; ix++) {
-          A(ix, 0) = 0.;
-          A(ix, 1) = 0.;
-          A(ix, 2) = -.5 / sqrt(coords->g_11(ix, jy)) / coords->dx(ix, jy);
-          A(ix, 3) = .5 / sqrt(coords->g_11(ix, jy)) / coords->dx(ix, jy);
-          A(ix, 4) = 0.;
-        }
+    // Outer boundary
+    if (outer_boundary_flags & INVERT_DC_GRAD) {
+      // Zero gradient at outer boundary
+      for (int ix = 0; ix < xbndry; ix++) {
+        matrix(ncx - ix, 1) = -1.0;
+      }
+    }
 
-      } else if (inner_boundary_flags & INVERT_DC_GRAD) {
-        // Zero gradient at inner boundary. 2nd-order accurate
-        // Boundary at midpoint
-        for (int ix = 0; ix < xbndry; ix++) {
-          A(ix, 0) = 0.;
-          A(ix, 1) = 0.;
-          A(ix, 2) = -.5;
-          A(ix, 3) = .5;
-          A(ix, 4) = 0.;
-        }
+  } else {
+    // AC
 
-      } else if (inner_boundary_flags & INVERT_DC_GRADPAR) {
-        for (int ix = 0; ix < xbndry; ix++) {
-          A(ix, 0) = 0.;
-          A(ix, 1) = 0.;
-          A(ix, 2) = -3. / sqrt(coords->g_22(ix, jy));
-          A(ix, 3) = 4. / sqrt(coords->g_22(ix + 1, jy));
-          A(ix, 4) = -1. / sqrt(coords->g_22(ix + 2, jy));
-        }
-      } else if (inner_boundary_flags & INVERT_DC_GRADPARINV) {
-        for (int ix = 0; ix < xbndry; ix++) {
-          A(ix, 0) = 0.;
-          A(ix, 1) = 0.;
-          A(ix, 2) = -3. * sqrt(coords->g_22(ix, jy));
-          A(ix, 3) = 4. * sqrt(coords->g_22(ix + 1, jy));
-          A(ix, 4) = -sqrt(coords->g_22(ix + 2, jy));
-        }
-      } else if (inner_boundary_flags & INVERT_DC_LAP) {
-        for (int ix = 0; ix < xbndry; ix++) {
-          A(ix, 0) = 0.;
-          A(ix, 1) = 0.;
-          A(ix, 2) = 1.;
-          A(ix, 3) = -2;
-          A(ix, 4) = 1.;
-        }
+    // Inner boundarySQ(kwave)*coef2
+    if (inner_boundary_flags & INVERT_AC_GRAD) {
+      // Zero gradient at inner boundary
+      for (int ix = 0; ix < xbndry; ix++) {
+        matrix(ix, 3) = -1.0;
       }
+    } else if (inner_boundary_flags & INVERT_AC_LAP) {
+      // Enforce zero laplacian for 2nd and 4th-order
 
-      // Outer boundary
-      if (outer_boundary_flags & INVERT_DC_GRAD) {
-        // Zero gradient at outer boundary
-        for (int ix = 0; ix < xbndry; ix++) {
-          A(ncx - ix, 1) = -1.0;
-        }
-      }
+      int ix = 1;
 
-    } else {
-      // AC
+      auto kwave = iz * kwave_fac(ix, jy);
+      coef1 = coords->g11(ix, jy) / (12. * SQ(coords->dx(ix, jy)));
 
-      // Inner boundarySQ(kwave)*coef2
-      if (inner_boundary_flags & INVERT_AC_GRAD) {
-        // Zero gradient at inner boundary
-        for (int ix = 0; ix < xbndry; ix++) {
-          A(ix, 3) = -1.0;
-        }
-      } else if (inner_boundary_flags & INVERT_AC_LAP) {
-        // Enforce zero laplacian for 2nd and 4th-order
+      coef2 = coords->g33(ix, jy);
 
-        int ix = 1;
+      coef3 = kwave * coords->g13(ix, jy) / (2. * coords->dx(ix, jy));
 
-        auto kwave = kwave_(ix, jy);
-        coef1 = coords->g11(ix, jy) / (12. * SQ(coords->dx(ix, jy)));
+      coef4 = Acoef(ix, jy);
 
-        coef2 = coords->g33(ix, jy);
+      // Combine 4th order at 1 with 2nd order at 0
+      matrix(1, 0) = 0.0; // Not used
+      matrix(1, 1) = dcomplex(
+          (14.
+           - SQ(coords->dx(0, jy) * kwave) * coords->g33(0, jy) / coords->g11(0, jy))
+              * coef1,
+          -coef3);
+      matrix(1, 2) = dcomplex(-29. * coef1 - SQ(kwave) * coef2 + coef4, 0.0);
+      matrix(1, 3) = dcomplex(16. * coef1, coef3);
+      matrix(1, 4) = dcomplex(-coef1, 0.0);
 
-        coef3 = kwave * coords->g13(ix, jy) / (2. * coords->dx(ix, jy));
+      coef1 = coords->g11(ix, jy) / (SQ(coords->dx(ix, jy)));
+      coef2 = coords->g33(ix, jy);
+      coef3 = kwave * coords->g13(ix, jy) / (2. * coords->dx(ix, jy));
 
-        coef4 = Acoef(ix, jy);
+      // Use 2nd order at 1
+      matrix(0, 0) = 0.0; // Should never be used
+      matrix(0, 1) = 0.0;
+      matrix(0, 2) = dcomplex(coef1, -coef3);
+      matrix(0, 3) = dcomplex(-2.0 * coef1 - SQ(kwave) * coef2 + coef4, 0.0);
+      matrix(0, 4) = dcomplex(coef1, coef3);
+    }
 
-        // Combine 4th order at 1 with 2nd order at 0
-        A(1, 0) = 0.0; // Not used
-        A(1, 1) = dcomplex(
-            (14.
-             - SQ(coords->dx(0, jy) * kwave) * coords->g33(0, jy) / coords->g11(0, jy))
-                * coef1,
-            -coef3);
-        A(1, 2) = dcomplex(-29. * coef1 - SQ(kwave) * coef2 + coef4, 0.0);
-        A(1, 3) = dcomplex(16. * coef1, coef3);
-        A(1, 4) = dcomplex(-coef1, 0.0);
+    // Outer boundary
+    if (outer_boundary_flags & INVERT_AC_GRAD) {
+      // Zero gradient at outer boundary
+      for (int ix = 0; ix < xbndry; ix++) {
+        matrix(ncx - ix, 1) = -1.0;
+      }
+    } else if (outer_boundary_flags & INVERT_AC_LAP) {
+      // Enforce zero laplacian for 2nd and 4th-order
+      // NOTE: Currently ignoring XZ term and coef4 assumed zero on boundary
+      // FIX THIS IF IT WORKS
 
-        coef1 = coords->g11(ix, jy) / (SQ(coords->dx(ix, jy)));
-        coef2 = coords->g33(ix, jy);
-        coef3 = kwave * coords->g13(ix, jy) / (2. * coords->dx(ix, jy));
+      int ix = ncx - 1;
 
-        // Use 2nd order at 1
-        A(0, 0) = 0.0; // Should never be used
-        A(0, 1) = 0.0;
-        A(0, 2) = dcomplex(coef1, -coef3);
-        A(0, 3) = dcomplex(-2.0 * coef1 - SQ(kwave) * coef2 + coef4, 0.0);
-        A(0, 4) = dcomplex(coef1, coef3);
-      }
+      coef1 = coords->g11(ix, jy) / (12. * SQ(coords->dx(ix, jy)));
 
-      // Outer boundary
-      if (outer_boundary_flags & INVERT_AC_GRAD) {
-        // Zero gradient at outer boundary
-        for (int ix = 0; ix < xbndry; ix++) {
-          A(ncx - ix, 1) = -1.0;
-        }
-      } else if (outer_boundary_flags & INVERT_AC_LAP) {
-        // Enforce zero laplacian for 2nd and 4th-order
-        // NOTE: Currently ignoring XZ term and coef4 assumed zero on boundary
-        // FIX THIS IF IT WORKS
-
-        int ix = ncx - 1;
-
-        coef1 = coords->g11(ix, jy) / (12. * SQ(coords->dx(ix, jy)));
-
-        coef2 = coords->g33(ix, jy);
-
-        auto kwave = kwave_(ix, jy);
-        coef3 = kwave * coords->g13(ix, jy) / (2. * coords->dx(ix, jy));
-
-        coef4 = Acoef(ix, jy);
-
-        // Combine 4th order at ncx-1 with 2nd order at ncx
-        A(ix, 0) = dcomplex(-coef1, 0.0);
-        A(ix, 1) = dcomplex(16. * coef1, -coef3);
-        A(ix, 2) = dcomplex(-29. * coef1 - SQ(kwave) * coef2 + coef4, 0.0);
-        A(ix, 3) = dcomplex((14.
-                             - SQ(coords->dx(ncx, jy) * kwave) * coords->g33(ncx, jy)
-                                   / coords->g11(ncx, jy))
-                                * coef1,
-                            coef3);
-        A(ix, 4) = 0.0; // Not used
-
-        coef1 = coords->g11(ix, jy) / (SQ(coords->dx(ix, jy)));
-        coef2 = coords->g33(ix, jy);
-        coef3 = kwave * coords->g13(ix, jy) / (2. * coords->dx(ix, jy));
-
-        // Use 2nd order at ncx - 1
-        A(ncx, 0) = dcomplex(coef1, -coef3);
-        A(ncx, 1) = dcomplex(-2.0 * coef1 - SQ(kwave) * coef2 + coef4, 0.0);
-        A(ncx, 2) = dcomplex(coef1, coef3);
-        A(ncx, 3) = 0.0; // Should never be used
-        A(ncx, 4) = 0.0;
-      }
-    }
+      coef2 = coords->g33(ix, jy);
 
-    // Perform inversion
-    cband_solve(A, localmesh->LocalNx, 2, 2, bk1d);
+      auto kwave = iz * kwave_fac(ix, jy);
+      coef3 = kwave * coords->g13(ix, jy) / (2. * coords->dx(ix, jy));
 
-    if ((global_flags & INVERT_KX_ZERO) && (iz == 0)) {
-      // Set the Kx = 0, n = 0 component to zero. For now just subtract
-      // Should do in the inversion e.g. Sherman-Morrison formula
+      coef4 = Acoef(ix, jy);
 
-      dcomplex offset(0.0);
-      for (int ix = 0; ix <= ncx; ix++) {
-        offset += bk1d[ix];
-      }
-      offset /= static_cast<BoutReal>(ncx + 1);
-      for (int ix = 0; ix <= ncx; ix++) {
-        bk1d[ix] -= offset;
-      }
-    }
+      // Combine 4th order at ncx-1 with 2nd order at ncx
+      matrix(ix, 0) = dcomplex(-coef1, 0.0);
+      matrix(ix, 1) = dcomplex(16. * coef1, -coef3);
+      matrix(ix, 2) = dcomplex(-29. * coef1 - SQ(kwave) * coef2 + coef4, 0.0);
+      matrix(ix, 3) = dcomplex((14.
+                                - SQ(coords->dx(ncx, jy) * kwave) * coords->g33(ncx, jy)
+                                      / coords->g11(ncx, jy))
+                                   * coef1,
+                               coef3);
+      matrix(ix, 4) = 0.0; // Not used
 
-    // Fill xk
-    for (int ix = 0; ix <= ncx; ix++) {
-      xk(ix, iz) = bk1d[ix];
+      coef1 = coords->g11(ix, jy) / (SQ(coords->dx(ix, jy)));
+      coef2 = coords->g33(ix, jy);
+      coef3 = kwave * coords->g13(ix, jy) / (2. * coords->dx(ix, jy));
+
+      // Use 2nd order at ncx - 1
+      matrix(ncx, 0) = dcomplex(coef1, -coef3);
+      matrix(ncx, 1) = dcomplex(-2.0 * coef1 - SQ(kwave) * coef2 + coef4, 0.0);
+      matrix(ncx, 2) = dcomplex(coef1, coef3);
+      matrix(ncx, 3) = 0.0; // Should never be used
+      matrix(ncx, 4) = 0.0;
     }
   }
 
-  // Done inversion, transform back
+  // Perform inversion
+  cband_solve(matrix, localmesh->LocalNx, 2, 2, bk1d);
 
-  for (int ix = 0; ix <= ncx; ix++) {
-    if (global_flags & INVERT_ZERO_DC) {
-      xk(ix, 0) = 0.0;
-    }
+  if ((global_flags & INVERT_KX_ZERO) && (iz == 0)) {
+    // Set the Kx = 0, n = 0 component to zero. For now just subtract
+    // Should do in the inversion e.g. Sherman-Morrison formula
 
-    irfft(&xk(ix, 0), ncz, x[ix]);
+    dcomplex offset(0.0);
+    for (int ix = 0; ix <= ncx; ix++) {
+      offset += bk1d[ix];
+    }
+    offset /= static_cast<BoutReal>(ncx + 1);
+    for (int ix = 0; ix <= ncx; ix++) {
+      bk1d[ix] -= offset;
+    }
   }
-
-  checkData(x);
-  return x;
 }
 
 #endif // BOUT_USE_METRIC_3D
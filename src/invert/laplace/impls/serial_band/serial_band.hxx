@@ -86,9 +86,19 @@ public:
   FieldPerp solve(const FieldPerp& b) override;
   FieldPerp solve(const FieldPerp& b, const FieldPerp& x0) override;
 
+  /// Solve all the Y slices together, in parallel over Y and Z modes
+  Field3D solve(const Field3D& b) override { return solve(b, b); }
+  Field3D solve(const Field3D& b, const Field3D& x0) override;
+
 private:
   Field2D Acoef, Ccoef, Dcoef;
 
+  /// Set up the band matrix for Z mode \p iz of Y slice \p jy in
+  /// \p matrix, and solve it, with the Fourier transformed right hand
+  /// side in \p bk1d, replaced by the solution
+  void solveMode(int jy, int iz, const Field2D& kwave_fac, Matrix<dcomplex>& matrix,
+                 Array<dcomplex>& bk1d);
+
   Matrix<dcomplex> bk, xk, A;
   Array<dcomplex> bk1d, xk1d;
 };
@@ -33,14 +33,17 @@
 #include <bout/lapack_routines.hxx>
 #include <bout/mesh.hxx>
 #include <bout/openmpwrap.hxx>
+#include <bout/sys/timer.hxx>
 #include <bout/utils.hxx>
 #include <cmath>
+#include <vector>
 
 #include <bout/output.hxx>
 
 LaplaceSerialTri::LaplaceSerialTri(Options* opt, CELL_LOC loc, Mesh* mesh_in,
                                    Solver* UNUSED(solver))
-    : Laplacian(opt, loc, mesh_in), A(0.0), C(1.0), D(1.0) {
+    : Laplacian(opt, loc, mesh_in), A(0.0), C(1.0), D(1.0),
+      zfourier(localmesh, maxmode + 1) {
   A.setLocation(location);
   C.setLocation(location);
   D.setLocation(location);
@@ -81,9 +84,13 @@ FieldPerp LaplaceSerialTri::solve(const FieldPerp& b, const FieldPerp& x0) {
 
   int jy = b.getIndex();
 
-  int ncz = localmesh->LocalNz; // No of z pnts
   int ncx = localmesh->LocalNx; // No of x pnts
 
+  // Modes kz_start to kz_start + nlocal - 1 are solved on this
+  // processor, if Z is split between processors
+  const int kz_start = zfourier.firstMode();
+  const int nlocal = zfourier.localModes();
+
   BoutReal kwaveFactor = 2.0 * PI / getUniform(coords->zlength());
 
   // Setting the width of the boundary.
@@ -102,25 +109,15 @@ FieldPerp LaplaceSerialTri::solve(const FieldPerp& b, const FieldPerp& x0) {
   }
 
   /* Allocation fo
-   * bk   = The fourier transformed of b, where b is one of the inputs in
-   *        LaplaceSerialTri::solve()
-   * bk1d = The 1d array of bk
+   * bk1d = The 1d array of bk, the fourier transformed of b
    * xk   = The fourier transformed of x, where x the output of
    *        LaplaceSerialTri::solve()
    * xk1d = The 1d array of xk
    */
-  auto bk = Matrix<dcomplex>(ncx, ncz / 2 + 1);
   auto bk1d = Array<dcomplex>(ncx);
-  auto xk = Matrix<dcomplex>(ncx, ncz / 2 + 1);
+  auto xk = Matrix<dcomplex>(ncx, nlocal);
   auto xk1d = Array<dcomplex>(ncx);
 
-  // Initialise xk to 0 as we only visit 0<= kz <= maxmode in solve
-  for (int ix = 0; ix < ncx; ix++) {
-    for (int kz = maxmode + 1; kz < ncz / 2 + 1; kz++) {
-      xk(ix, kz) = 0.0;
-    }
-  }
-
   /* Coefficents in the tridiagonal solver matrix
    * Following the notation in "Numerical recipes"
    * avec is the lower diagonal of the matrix
@@ -133,38 +130,34 @@ FieldPerp LaplaceSerialTri::solve(const FieldPerp& b, const FieldPerp& x0) {
   auto bvec = Array<dcomplex>(ncx);
   auto cvec = Array<dcomplex>(ncx);
 
-  BOUT_OMP(parallel for)
+  std::vector<const BoutReal*> lines(ncx);
   for (int ix = 0; ix < ncx; ix++) {
-    /* This for loop will set the bk (initialized by the constructor)
-     * bk is the z fourier modes of b in z
+    /* This for loop will set the lines to transform
      * If the INVERT_SET flag is set (meaning that x0 will be used to set the
      * bounadry values),
      */
     if (((ix < inbndry) && (inner_boundary_flags & INVERT_SET))
         || ((ncx - 1 - ix < outbndry) && (outer_boundary_flags & INVERT_SET))) {
       // Use the values in x0 in the boundary
-
-      // x0 is the input
-      // bk is the output
-      rfft(x0[ix], ncz, &bk(ix, 0));
-
+      lines[ix] = x0[ix] + localmesh->zstart;
     } else {
-      // b is the input
-      // bk is the output
-      rfft(b[ix], ncz, &bk(ix, 0));
+      lines[ix] = b[ix] + localmesh->zstart;
     }
   }
 
+  // bk is the z fourier modes of b in z
+  const auto bk = zfourier.forward(lines);
+
   /* Solve differential equation in x for each fourier mode
    * Note that only the non-degenerate fourier modes are being used (i.e. the
    * offset and all the modes up to the Nyquist frequency)
    */
-  for (int kz = 0; kz <= maxmode; kz++) {
+  for (int kz = kz_start; kz < kz_start + nlocal; kz++) {
 
     // set bk1d
     for (int ix = 0; ix < ncx; ix++) {
       // Get bk of the current fourier mode
-      bk1d[ix] = bk(ix, kz);
+      bk1d[ix] = bk(ix, kz - kz_start);
     }
 
     /* Set the matrix A used in the inversion of Ax=b
@@ -221,28 +214,212 @@ FieldPerp LaplaceSerialTri::solve(const FieldPerp& b, const FieldPerp& x0) {
 
     // Store the solution xk for the current fourier mode in a 2D array
     for (int ix = 0; ix < ncx; ix++) {
-      xk(ix, kz) = xk1d[ix];
+      xk(ix, kz - kz_start) = xk1d[ix];
     }
   }
 
   // Done inversion, transform back
+  std::vector<BoutReal*> out(ncx);
   for (int ix = 0; ix < ncx; ix++) {
 
-    if (global_flags & INVERT_ZERO_DC) {
+    if ((global_flags & INVERT_ZERO_DC) && (kz_start == 0)) {
       xk(ix, 0) = 0.0;
     }
 
-    irfft(&xk(ix, 0), ncz, x[ix]);
+    out[ix] = x[ix] + localmesh->zstart;
+  }
+  zfourier.backward(xk, out);
 
 #if CHECK > 2
-    for (int kz = 0; kz < ncz; kz++) {
+  for (int ix = 0; ix < ncx; ix++) {
+    for (int kz = localmesh->zstart; kz <= localmesh->zend; kz++) {
       if (!finite(x(ix, kz))) {
         throw BoutException("Non-finite at {:d}, {:d}, {:d}", ix, jy, kz);
       }
     }
+  }
 #endif
+
+  checkData(x);
+
+  return x; // Result of the inversion
+}
+
+/*!
+ * Solve Ax=b for all the y-slices of x given b
+ *
+ * The same as solving each y-slice with solve(FieldPerp, FieldPerp),
+ * but the FFTs in Z are done for all the y-slices in one batch, and
+ * the tridiagonal systems for all the y-slices and Fourier modes are
+ * solved in parallel
+ *
+ * \param[in] b     The right hand side of the equation Ax = b
+ * \param[in] x0    Variable used to set BC (if the right flags are set, see
+ *                  the user manual)
+ *
+ * \return          The inverted variable.
+ */
+Field3D LaplaceSerialTri::solve(const Field3D& b, const Field3D& x0) {
+  TRACE("LaplaceSerialTri::solve(Field3D, Field3D)");
+
+  ASSERT1(localmesh == b.getMesh() && localmesh == x0.getMesh());
+  ASSERT1(b.getLocation() == location);
+  ASSERT1(x0.getLocation() == location);
+
+  Timer timer("invert");
+
+  Field3D x{emptyFrom(b)};
+
+  // Range of Y indices, as in Laplacian::solve(Field3D)
+  int ys = localmesh->ystart, ye = localmesh->yend;
+  if (localmesh->hasBndryLowerY()) {
+    if (include_yguards) {
+      ys = 0;
+    }
+    ys += extra_yguards_lower;
+  }
+  if (localmesh->hasBndryUpperY()) {
+    if (include_yguards) {
+      ye = localmesh->LocalNy - 1;
+    }
+    ye -= extra_yguards_upper;
+  }
+
+  const int ncx = localmesh->LocalNx; // No of x pnts
+  const int ny = ye - ys + 1;
+  // Modes kz_start to kz_start + nmode - 1 are solved on this
+  // processor, if Z is split between processors
+  const int kz_start = zfourier.firstMode();
+  const int nmode = zfourier.localModes();
+  const int nsys = ny * nmode; // Number of tridiagonal systems to solve
+
+  const BoutReal kwaveFactor = 2.0 * PI / getUniform(coords->zlength());
+
+  // Setting the width of the boundary.
+  // NOTE: The default is a width of 2 guard cells
+  int inbndry = localmesh->xstart, outbndry = localmesh->xstart;
+
+  // If the flags to assign that only one guard cell should be used is set
+  if ((global_flags & INVERT_BOTH_BNDRY_ONE) || (localmesh->xstart < 2)) {
+    inbndry = outbndry = 1;
+  }
+  if (inner_boundary_flags & INVERT_BNDRY_ONE) {
+    inbndry = 1;
+  }
+  if (outer_boundary_flags & INVERT_BNDRY_ONE) {
+    outbndry = 1;
+  }
+
+  // Fourier transformed right hand sides and solutions of all the
+  // systems, with system (iy - ys) * nmode + (kz - kz_start) in each row
+  auto bk = Matrix<dcomplex>(nsys, ncx);
+  auto xk = Matrix<dcomplex>(nsys, ncx);
+
+  // Take FFT in Z direction of line ix * ny + (iy - ys), using the
+  // values in x0 in the boundary if INVERT_SET
+  std::vector<const BoutReal*> lines(ncx * ny);
+  for (int ix = 0; ix < ncx; ix++) {
+    const bool use_x0 =
+        ((ix < inbndry) && (inner_boundary_flags & INVERT_SET))
+        || ((ncx - 1 - ix < outbndry) && (outer_boundary_flags & INVERT_SET));
+    for (int iy = 0; iy < ny; iy++) {
+      lines[ix * ny + iy] = &(use_x0 ? x0 : b)(ix, ys + iy, localmesh->zstart);
+    }
+  }
+  auto k2d = zfourier.forward(lines);
+
+  BOUT_OMP(parallel)
+  {
+    BOUT_OMP(for)
+    for (int ix = 0; ix < ncx; ix++) {
+      for (int iy = 0; iy < ny; iy++) {
+        for (int kz = 0; kz < nmode; kz++) {
+          bk(iy * nmode + kz, ix) = k2d(ix * ny + iy, kz);
+        }
+      }
+    }
+
+    // Each thread needs its own tridiagonal matrix
+    auto avec = Array<dcomplex>(ncx);
+    auto bvec = Array<dcomplex>(ncx);
+    auto cvec = Array<dcomplex>(ncx);
+
+    BOUT_OMP(for)
+    for (int ind = 0; ind < nsys; ind++) {
+      const int jy = ys + ind / nmode;
+      const int kz = kz_start + ind % nmode;
+
+      dcomplex* bk1d = &bk(ind, 0);
+      dcomplex* xk1d = &xk(ind, 0);
+
+      tridagMatrix(std::begin(avec), std::begin(bvec), std::begin(cvec), bk1d, jy, kz,
+                   kz * kwaveFactor, global_flags, inner_boundary_flags,
+                   outer_boundary_flags, &A, &C, &D);
+
+      if (!localmesh->periodicX) {
+        tridag(std::begin(avec), std::begin(bvec), std::begin(cvec), bk1d, xk1d, ncx);
+      } else {
+        // Periodic in X, so cyclic tridiagonal
+        int xs = localmesh->xstart;
+        cyclic_tridag(&avec[xs], &bvec[xs], &cvec[xs], &bk1d[xs], &xk1d[xs],
+                      ncx - 2 * xs);
+
+        // Copy boundary regions
+        for (int ix = 0; ix < xs; ix++) {
+          xk1d[ix] = xk1d[ncx - 2 * xs + ix];
+          xk1d[ncx - xs + ix] = xk1d[xs + ix];
+        }
+      }
+
+      // If the global flag is set to INVERT_KX_ZERO
+      if ((global_flags & INVERT_KX_ZERO) && (kz == 0)) {
+        dcomplex offset(0.0);
+        for (int ix = localmesh->xstart; ix <= localmesh->xend; ix++) {
+          offset += xk1d[ix];
+        }
+        offset /= static_cast<BoutReal>(localmesh->xend - localmesh->xstart + 1);
+        for (int ix = localmesh->xstart; ix <= localmesh->xend; ix++) {
+          xk1d[ix] -= offset;
+        }
+      }
+    }
+
+    // Done inversion, transform back
+    const bool zero_DC = ((global_flags & INVERT_ZERO_DC) != 0) && (kz_start == 0);
+
+    BOUT_OMP(for)
+    for (int ix = 0; ix < ncx; ix++) {
+      for (int iy = 0; iy < ny; iy++) {
+        for (int kz = 0; kz < nmode; kz++) {
+          k2d(ix * ny + iy, kz) = xk(iy * nmode + kz, ix);
+        }
+        if (zero_DC) {
+          k2d(ix * ny + iy, 0) = 0.0;
+        }
+      }
+    }
   }
 
+  std::vector<BoutReal*> out(ncx * ny);
+  for (int ix = 0; ix < ncx; ix++) {
+    for (int iy = 0; iy < ny; iy++) {
+      out[ix * ny + iy] = &x(ix, ys + iy, localmesh->zstart);
+    }
+  }
+  zfourier.backward(k2d, out);
+
+#if CHECK > 2
+  for (int ix = 0; ix < ncx; ix++) {
+    for (int jy = ys; jy <= ye; jy++) {
+      for (int kz = localmesh->zstart; kz <= localmesh->zend; kz++) {
+        if (!finite(x(ix, jy, kz))) {
+          throw BoutException("Non-finite at {:d}, {:d}, {:d}", ix, jy, kz);
+        }
+      }
+    }
+  }
+#endif
+
   checkData(x);
 
   return x; // Result of the inversion
@@ -32,6 +32,7 @@ class LaplaceSerialTri;
 #include <bout/dcomplex.hxx>
 #include <bout/invert_laplace.hxx>
 #include <bout/options.hxx>
+#include <bout/z_transpose.hxx>
 
 namespace {
 RegisterLaplace<LaplaceSerialTri> registerlaplaceserialtri(LAPLACE_TRI);
@@ -74,10 +75,17 @@ public:
   FieldPerp solve(const FieldPerp& b) override;
   FieldPerp solve(const FieldPerp& b, const FieldPerp& x0) override;
 
+  /// Solve all the Y slices together, in parallel over Y and Z modes
+  Field3D solve(const Field3D& b) override { return solve(b, b); }
+  Field3D solve(const Field3D& b, const Field3D& x0) override;
+
 private:
   // The coefficents in
   // D*grad_perp^2(x) + (1/C)*(grad_perp(C))*grad_perp(x) + A*x = b
   Field2D A, C, D;
+
+  /// FFTs in Z, which may be split between processors
+  bout::ZFourierTranspose zfourier;
 };
 
 #endif // __SERIAL_TRI_H__
@@ -49,6 +49,11 @@ LaplaceSPT::LaplaceSPT(Options* opt, const CELL_LOC loc, Mesh* mesh_in,
   Ccoef.setLocation(location);
   Dcoef.setLocation(location);
 
+  if (localmesh->getNZPE() > 1) {
+    throw BoutException("LaplaceSPT error: Z can't be split between processors "
+                        "(NZPE must be 1)");
+  }
+
   if (localmesh->periodicX) {
     throw BoutException("LaplaceSPT does not work with periodicity in the x direction "
                         "(localmesh->PeriodicX == true). Change boundary conditions or "
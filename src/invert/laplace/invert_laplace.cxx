@@ -44,6 +44,7 @@
 #include <bout/solver.hxx>
 #include <bout/sys/timer.hxx>
 #include <bout/utils.hxx>
+#include <algorithm>
 #include <cmath>
 
 // Implementations:
@@ -90,7 +91,8 @@ Laplacian::Laplacian(Options* options, const CELL_LOC loc, Mesh* mesh_in,
   const BoutReal filter = (*options)["filter"]
                               .doc("Fraction of Z modes to filter out. Between 0 and 1")
                               .withDefault(0.0);
-  const int ncz = localmesh->LocalNz;
+  // All of Z, which may be split between processors
+  const int ncz = localmesh->GlobalNz;
   // convert filtering into an integer number of modes
   maxmode = (*options)["maxmode"]
                 .doc("The maximum Z mode to solve for")
@@ -771,6 +773,159 @@ void Laplacian::tridagMatrix(dcomplex* avec, dcomplex* bvec, dcomplex* cvec, dco
 }
 #endif
 
+namespace {
+/// Does the coefficient \p coef, which may be nullptr, have the same
+/// values as the \p cached copy?
+bool sameCoefficient(const Field2D* coef, const Field2D& cached) {
+  if (coef == nullptr or not coef->isAllocated()) {
+    return not cached.isAllocated();
+  }
+  if (not cached.isAllocated() or coef->getNx() != cached.getNx()
+      or coef->getNy() != cached.getNy()) {
+    return false;
+  }
+  BOUT_FOR_SERIAL(i, coef->getRegion("RGN_ALL")) {
+    if ((*coef)[i] != cached[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// A copy of the coefficient \p coef, or an empty field if nullptr
+Field2D copyCoefficient(const Field2D* coef) {
+  return (coef == nullptr or not coef->isAllocated()) ? Field2D{} : copy(*coef);
+}
+} // namespace
+
+const Laplacian::TridagMatrices&
+Laplacian::getTridagMatrices(int ys, int ye, int nmode, BoutReal zlength,
+                             const Field2D* a, const Field2D* c1coef,
+                             const Field2D* c2coef, const Field2D* d, bool zperiodic,
+                             bool& rebuilt, int kz_start) {
+  auto& cache = tridag_cache;
+  if (cache_tridag_matrices and cache.valid and cache.ys == ys and cache.ye == ye
+      and cache.nmode == nmode and cache.kz_start == kz_start
+      and cache.zlength == zlength
+      and cache.zperiodic == zperiodic and cache.global_flags == global_flags
+      and cache.inner_boundary_flags == inner_boundary_flags
+      and cache.outer_boundary_flags == outer_boundary_flags
+      and sameCoefficient(a, cache.a) and sameCoefficient(c1coef, cache.c1coef)
+      and sameCoefficient(c2coef, cache.c2coef) and sameCoefficient(d, cache.d)) {
+    ++tridag_cache_hits;
+    rebuilt = false;
+    return cache.matrices;
+  }
+
+  // X range as in tridagMatrix without guard cells
+  int xs = 0;
+  int xe = localmesh->LocalNx - 1;
+  if (!localmesh->firstX() || localmesh->periodicX) {
+    xs = localmesh->xstart;
+  }
+  if (!localmesh->lastX() || localmesh->periodicX) {
+    xe = localmesh->xend;
+  }
+  const int nx = xe - xs + 1;
+  const int nsys = (ye - ys + 1) * nmode;
+
+  auto& matrices = cache.matrices;
+  matrices.a.reallocate(nsys, nx);
+  matrices.b.reallocate(nsys, nx);
+  matrices.c.reallocate(nsys, nx);
+  matrices.zero_rhs.reallocate(nsys, nx);
+
+  BOUT_OMP(parallel)
+  {
+    // Find which elements of the right hand side are set to zero
+    auto bk = Array<dcomplex>(nx);
+
+    BOUT_OMP(for)
+    for (int ind = 0; ind < nsys; ind++) {
+      // ind = (jy - ys) * nmode + (kz - kz_start)
+      const int jy = ys + ind / nmode;
+      const int kz = kz_start + ind % nmode;
+
+      std::fill(std::begin(bk), std::end(bk), 1.0);
+
+      const BoutReal kwave = kz * 2.0 * PI / zlength; // wave number is 1/[rad]
+      tridagMatrix(&matrices.a(ind, 0), &matrices.b(ind, 0), &matrices.c(ind, 0),
+                   std::begin(bk), jy, kz, kwave, global_flags, inner_boundary_flags,
+                   outer_boundary_flags, a, c1coef, c2coef, d,
+                   false, // Don't include guard cells in arrays
+                   zperiodic);
+
+      for (int ix = 0; ix < nx; ix++) {
+        matrices.zero_rhs(ind, ix) = static_cast<int>(bk[ix] == 0.0);
+      }
+    }
+  }
+
+  cache.valid = true;
+  cache.ys = ys;
+  cache.ye = ye;
+  cache.nmode = nmode;
+  cache.kz_start = kz_start;
+  cache.zlength = zlength;
+  cache.zperiodic = zperiodic;
+  cache.global_flags = global_flags;
+  cache.inner_boundary_flags = inner_boundary_flags;
+  cache.outer_boundary_flags = outer_boundary_flags;
+  if (cache_tridag_matrices) {
+    cache.a = copyCoefficient(a);
+    cache.c1coef = copyCoefficient(c1coef);
+    cache.c2coef = copyCoefficient(c2coef);
+    cache.d = copyCoefficient(d);
+  }
+
+  rebuilt = true;
+  return matrices;
+}
+
+void Laplacian::applyTridagBoundaries(const TridagMatrices& matrices,
+                                      Matrix<dcomplex>& bk) {
+  const int nsys = std::get<0>(bk.shape());
+  const int nx = std::get<1>(bk.shape());
+  ASSERT1(static_cast<int>(std::get<0>(matrices.zero_rhs.shape())) == nsys);
+  ASSERT1(static_cast<int>(std::get<1>(matrices.zero_rhs.shape())) == nx);
+
+  bk.ensureUnique();
+  BOUT_OMP(parallel for)
+  for (int ind = 0; ind < nsys; ind++) {
+    for (int ix = 0; ix < nx; ix++) {
+      if (matrices.zero_rhs(ind, ix) != 0) {
+        bk(ind, ix) = 0.0;
+      }
+    }
+  }
+}
+
+Laplacian::TridagMatrices&
+Laplacian::getTridagWorkMatrices(int ys, int ye, int nmode, BoutReal zlength,
+                                 const Field2D* a, const Field2D* c1coef,
+                                 const Field2D* c2coef, const Field2D* d, bool zperiodic,
+                                 Matrix<dcomplex>& bk, int kz_start) {
+  bool rebuilt = false;
+  const auto& matrices = getTridagMatrices(ys, ye, nmode, zlength, a, c1coef, c2coef, d,
+                                           zperiodic, rebuilt, kz_start);
+  applyTridagBoundaries(matrices, bk);
+
+  // Copy element by element, so the storage is only reallocated if
+  // the size has changed
+  const auto copy = [](const Matrix<dcomplex>& from, Matrix<dcomplex>& to) {
+    if (to.shape() != from.shape()) {
+      to.reallocate(std::get<0>(from.shape()), std::get<1>(from.shape()));
+    }
+    to.ensureUnique();
+    std::copy(from.begin(), from.end(), to.begin());
+  };
+  copy(matrices.a, tridag_work.a);
+  copy(matrices.b, tridag_work.b);
+  copy(matrices.c, tridag_work.c);
+
+  return tridag_work;
+}
+
 void Laplacian::savePerformance(Solver& solver, const std::string& name) {
   // add values to be saved to the output
   if (not name.empty()) {
@@ -182,6 +182,10 @@ LaplaceXY::LaplaceXY(Mesh* m, Options* opt, const CELL_LOC loc)
   MatMPIAIJSetPreallocation(MatA, 0, d_nnz, 0, o_nnz);
   MatSetUp(MatA);
 
+  // Only locally owned rows are set, so assembly needs no
+  // communication
+  MatSetOption(MatA, MAT_NO_OFF_PROC_ENTRIES, PETSC_TRUE);
+
   PetscFree(d_nnz);
   PetscFree(o_nnz);
 
@@ -879,6 +883,11 @@ void LaplaceXY::setCoefs(const Field2D& A, const Field2D& B) {
   MatAssemblyBegin(MatA, MAT_FINAL_ASSEMBLY);
   MatAssemblyEnd(MatA, MAT_FINAL_ASSEMBLY);
 
+  // The same elements are set every time, so keep the structure from
+  // the first assembly. Later assemblies then only update values,
+  // without checking for new nonzeros
+  MatSetOption(MatA, MAT_NEW_NONZERO_LOCATION_ERR, PETSC_TRUE);
+
   // Set the operator
 #if PETSC_VERSION_GE(3, 5, 0)
   KSPSetOperators(ksp, MatA, MatA);
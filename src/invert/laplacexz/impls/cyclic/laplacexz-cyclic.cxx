@@ -15,6 +15,11 @@ LaplaceXZcyclic::LaplaceXZcyclic(Mesh* m, Options* options, const CELL_LOC loc)
     : LaplaceXZ(m, options, loc) {
   // Note: `m` may be nullptr, but localmesh is set in LaplaceXZ base constructor
 
+  if (localmesh->getNZPE() > 1) {
+    throw BoutException("LaplaceXZcyclic error: Z can't be split between processors "
+                        "(NZPE must be 1)");
+  }
+
   // Number of Z Fourier modes, including DC
   nmode = (localmesh->LocalNz) / 2 + 1;
 
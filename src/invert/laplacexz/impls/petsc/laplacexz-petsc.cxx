@@ -232,6 +232,10 @@ LaplaceXZpetsc::LaplaceXZpetsc(Mesh* m, Options* opt, const CELL_LOC loc)
     PetscFree(d_nnz);
     PetscFree(o_nnz);
 
+    // Only locally owned rows are set, so assembly needs no
+    // communication
+    MatSetOption(data.MatA, MAT_NO_OFF_PROC_ENTRIES, PETSC_TRUE);
+
     //////////////////////////////////////////////////
     // Declare KSP Context
     KSPCreate(comm, &data.ksp);
@@ -709,6 +713,11 @@ void LaplaceXZpetsc::setCoefs(const Field3D& Ain, const Field3D& Bin) {
     // Assemble Matrix
     MatAssemblyBegin(it.MatA, MAT_FINAL_ASSEMBLY);
     MatAssemblyEnd(it.MatA, MAT_FINAL_ASSEMBLY);
+
+    // The same elements are set every time, so keep the structure
+    // from the first assembly. Later assemblies then only update
+    // values, without checking for new nonzeros
+    MatSetOption(it.MatA, MAT_NEW_NONZERO_LOCATION_ERR, PETSC_TRUE);
   }
 
   // Increase reuse count
@@ -721,10 +730,11 @@ void LaplaceXZpetsc::setCoefs(const Field3D& Ain, const Field3D& Bin) {
     for (auto& it : slice) {
       // Copy matrix into preconditioner
       if (coefs_set) {
-        // Preconditioner already set
-        MatDestroy(&it.MatP);
+        // Preconditioner already set, with the same structure
+        MatCopy(it.MatA, it.MatP, SAME_NONZERO_PATTERN);
+      } else {
+        MatConvert(it.MatA, MATSAME, MAT_INITIAL_MATRIX, &it.MatP);
       }
-      MatConvert(it.MatA, MATSAME, MAT_INITIAL_MATRIX, &it.MatP);
     }
 
     // Set operators
@@ -733,6 +743,7 @@ void LaplaceXZpetsc::setCoefs(const Field3D& Ain, const Field3D& Bin) {
       // Note: This is a hack to force update of the preconditioner matrix
 #if PETSC_VERSION_GE(3, 5, 0)
       KSPSetOperators(it.ksp, it.MatA, it.MatP);
+      KSPSetReusePreconditioner(it.ksp, PETSC_FALSE);
 #else
       KSPSetOperators(it.ksp, it.MatA, it.MatP, SAME_NONZERO_PATTERN);
 #endif
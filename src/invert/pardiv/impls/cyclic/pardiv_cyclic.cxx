@@ -54,6 +54,11 @@
 
 InvertParDivCR::InvertParDivCR(Options* opt, CELL_LOC location, Mesh* mesh_in)
     : InvertParDiv(opt, location, mesh_in) {
+  if (localmesh->getNZPE() > 1) {
+    throw BoutException("InvertParDivCR error: Z can't be split between processors "
+                        "(NZPE must be 1)");
+  }
+
   // Number of k equations to solve for each x location
   nsys = 1 + (localmesh->LocalNz) / 2;
 }
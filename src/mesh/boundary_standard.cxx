@@ -470,7 +470,8 @@ void BoundaryDirichlet::apply(Field3D& f, BoutReal t) {
 
         for (int zk = 0; zk < mesh->LocalNz; zk++) {
           if (fg) {
-            val = fg->generate(xnorm, TWOPI * ynorm, TWOPI * (zk - 0.5) / (mesh->LocalNz),
+            val = fg->generate(xnorm, TWOPI * ynorm,
+                               TWOPI * (mesh->getGlobalZIndex(zk) - 0.5) / (mesh->GlobalNz),
                                t);
           }
           f(bndry->x, bndry->y, zk) =
@@ -515,7 +516,9 @@ void BoundaryDirichlet::apply(Field3D& f, BoutReal t) {
           for (int zk = 0; zk < mesh->LocalNz; zk++) {
             if (fg) {
               val = fg->generate(xnorm, TWOPI * ynorm,
-                                 TWOPI * (zk - 0.5) / (mesh->LocalNz), t);
+                                 TWOPI * (mesh->getGlobalZIndex(zk) - 0.5)
+                                     / (mesh->GlobalNz),
+                                 t);
             }
             f(xi, yi, zk) = val;
           }
@@ -975,7 +978,8 @@ void BoundaryDirichlet_O3::apply(Field3D& f, BoutReal t) {
 
         for (int zk = 0; zk < mesh->LocalNz; zk++) {
           if (fg) {
-            val = fg->generate(xnorm, TWOPI * ynorm, TWOPI * (zk - 0.5) / (mesh->LocalNz),
+            val = fg->generate(xnorm, TWOPI * ynorm,
+                               TWOPI * (mesh->getGlobalZIndex(zk) - 0.5) / (mesh->GlobalNz),
                                t);
           }
 
@@ -1441,7 +1445,8 @@ void BoundaryDirichlet_O4::apply(Field3D& f, BoutReal t) {
 
         for (int zk = 0; zk < mesh->LocalNz; zk++) {
           if (fg) {
-            val = fg->generate(xnorm, TWOPI * ynorm, TWOPI * (zk - 0.5) / (mesh->LocalNz),
+            val = fg->generate(xnorm, TWOPI * ynorm,
+                               TWOPI * (mesh->getGlobalZIndex(zk) - 0.5) / (mesh->GlobalNz),
                                t);
           }
 
@@ -2150,7 +2155,9 @@ void BoundaryNeumann_NonOrthogonal::apply(Field3D& f) {
                              + bndry->by * metric->dy(bndry->x, bndry->y, zk);
             if (fg) {
               val = fg->generate(xnorm, TWOPI * ynorm,
-                                 TWOPI * (zk - 0.5) / (mesh->LocalNz), t);
+                                 TWOPI * (mesh->getGlobalZIndex(zk) - 0.5)
+                                     / (mesh->GlobalNz),
+                                 t);
             }
             f(bndry->x, bndry->y, zk) =
                 f(bndry->x - bndry->bx, bndry->y - bndry->by, zk) + delta * val;
@@ -2631,6 +2638,11 @@ void BoundaryNeumann_NonOrthogonal::apply(Field3D& f) {
     ASSERT1(mesh == f.getMesh());
     int ncz = mesh->LocalNz;
 
+    if (mesh->getNZPE() > 1) {
+      throw BoutException("ERROR: Can't apply Zero Laplace condition when Z is split "
+                          "between processors\n");
+    }
+
     Coordinates* metric = f.getCoordinates();
 
     Array<dcomplex> c0(ncz / 2 + 1);
@@ -2734,6 +2746,11 @@ void BoundaryNeumann_NonOrthogonal::apply(Field3D& f) {
     ASSERT1(mesh == f.getMesh());
     const int ncz = mesh->LocalNz;
 
+    if (mesh->getNZPE() > 1) {
+      throw BoutException("ERROR: Can't apply Zero Laplace 2 condition when Z is split "
+                          "between processors\n");
+    }
+
     ASSERT0(ncz % 2 == 0); // Allocation assumes even number
 
     // allocate memory
@@ -2845,6 +2862,11 @@ void BoundaryNeumann_NonOrthogonal::apply(Field3D& f) {
 
     int ncz = mesh->LocalNz;
 
+    if (mesh->getNZPE() > 1) {
+      throw BoutException("ERROR: Can't apply Const Laplace condition when Z is split "
+                          "between processors\n");
+    }
+
     // Allocate memory
     Array<dcomplex> c0(ncz / 2 + 1), c1(ncz / 2 + 1), c2(ncz / 2 + 1);
 
@@ -14,6 +14,7 @@
 
 #include <bout/derivs.hxx>
 #include <bout/fft.hxx>
+#include <bout/fused_derivs.hxx>
 #include <bout/interpolation.hxx>
 
 #include <bout/globals.hxx>
@@ -378,7 +379,7 @@ Coordinates::Coordinates(Mesh* mesh, FieldMetric dx, FieldMetric dy, FieldMetric
       g13(std::move(g13)), g23(std::move(g23)), g_11(std::move(g_11)),
       g_22(std::move(g_22)), g_33(std::move(g_33)), g_12(std::move(g_12)),
       g_13(std::move(g_13)), g_23(std::move(g_23)), ShiftTorsion(std::move(ShiftTorsion)),
-      IntShiftTorsion(std::move(IntShiftTorsion)), nz(mesh->LocalNz), localmesh(mesh),
+      IntShiftTorsion(std::move(IntShiftTorsion)), nz(mesh->GlobalNz), localmesh(mesh),
       location(CELL_CENTRE) {}
 
 Coordinates::Coordinates(Mesh* mesh, Options* options)
@@ -419,7 +420,7 @@ Coordinates::Coordinates(Mesh* mesh, Options* options)
   mesh->get(dx, "dx", 1.0, false);
   mesh->get(dy, "dy", 1.0, false);
 
-  nz = mesh->LocalNz;
+  nz = mesh->GlobalNz;
 
   {
     auto& options = Options::root();
@@ -618,7 +619,7 @@ Coordinates::Coordinates(Mesh* mesh, Options* options, const CELL_LOC loc,
 
   std::string suffix = getLocationSuffix(location);
 
-  nz = mesh->LocalNz;
+  nz = mesh->GlobalNz;
 
   // Default to true in case staggered quantities are not read from file
   bool extrapolate_x = true;
@@ -1671,7 +1672,9 @@ Field3D Coordinates::Delp2(const Field3D& f, CELL_LOC outloc, bool useFFT) {
 
   Field3D result{emptyFrom(f).setLocation(outloc)};
 
-  if (useFFT and not bout::build::use_metric_3d) {
+  // The FFT method needs the whole of Z on each processor, so falls
+  // back to finite differences if Z is split between processors
+  if (useFFT and not bout::build::use_metric_3d and localmesh->getNZPE() == 1) {
     int ncz = localmesh->LocalNz;
 
     // Allocate memory
@@ -1709,6 +1712,14 @@ Field3D Coordinates::Delp2(const Field3D& f, CELL_LOC outloc, bool useFFT) {
         irfft(&delft(jx, 0), ncz, &result(jx, jy, 0));
       }
     }
+  } else if (bout::derivatives::fused::canFuseXZ(f, outloc)) {
+    // All the derivatives in one pass, without temporary fields
+    bout::derivatives::fused::forEachXZ(
+        f, "RGN_NOBNDRY",
+        [&](const Ind3D& i, const bout::derivatives::fused::XZDerivatives& d) {
+          result[i] = G1[i] * d.ddx + G3[i] * d.ddz + g11[i] * d.d2dx2
+                      + g33[i] * d.d2dz2 + 2 * g13[i] * d.d2dxdz;
+        });
   } else {
     result = G1 * ::DDX(f, outloc) + G3 * ::DDZ(f, outloc) + g11 * ::D2DX2(f, outloc)
              + g33 * ::D2DZ2(f, outloc) + 2 * g13 * ::D2DXDZ(f, outloc);
@@ -1741,6 +1752,10 @@ FieldPerp Coordinates::Delp2(const FieldPerp& f, CELL_LOC outloc, bool useFFT) {
   result.setIndex(jy);
 
   if (useFFT) {
+    if (localmesh->getNZPE() > 1) {
+      throw BoutException("FFT Delp2 of a FieldPerp needs the whole of Z on each "
+                          "processor, but Z is split between processors (NZPE > 1)");
+    }
     int ncz = localmesh->LocalNz;
 
     // Allocate memory
@@ -1815,6 +1830,24 @@ Field3D Coordinates::Laplace(const Field3D& f, CELL_LOC outloc,
   TRACE("Coordinates::Laplace( Field3D )");
   ASSERT1(location == outloc || outloc == CELL_DEFAULT);
 
+  if (bout::derivatives::fused::canFuseXZ(f, outloc)) {
+    // X-Z terms in one pass, then the terms involving Y
+    Field3D result{emptyFrom(f)};
+    bout::derivatives::fused::forEachXZ(
+        f, "RGN_NOBNDRY",
+        [&](const Ind3D& i, const bout::derivatives::fused::XZDerivatives& d) {
+          result[i] = G1[i] * d.ddx + G3[i] * d.ddz + g11[i] * d.d2dx2
+                      + g33[i] * d.d2dz2 + 2.0 * g13[i] * d.d2dxdz;
+        });
+    result += G2 * ::DDY(f, outloc) + g22 * D2DY2(f, outloc)
+              + 2.0
+                    * (g12
+                           * D2DXDY(f, outloc, "DEFAULT", "RGN_NOBNDRY",
+                                    dfdy_boundary_conditions, dfdy_dy_region)
+                       + g23 * D2DYDZ(f, outloc));
+    return result;
+  }
+
   Field3D result = G1 * ::DDX(f, outloc) + G2 * ::DDY(f, outloc) + G3 * ::DDZ(f, outloc)
                    + g11 * D2DX2(f, outloc) + g22 * D2DY2(f, outloc)
                    + g33 * D2DZ2(f, outloc)
@@ -11,13 +11,17 @@
 #include <bout/sys/timer.hxx>
 #include <bout/unused.hxx>
 #include <bout/utils.hxx>
+#include <algorithm>
 #include <utility>
 
 GridFile::GridFile(std::string gridfilename)
-    : GridDataSource(true), data(bout::OptionsNetCDF(gridfilename).read()),
-      filename(std::move(gridfilename)) {
+    : GridDataSource(true), file(gridfilename), filename(std::move(gridfilename)) {
   TRACE("GridFile constructor");
 
+  // Fields are read when they're needed, and only this processor's
+  // part of them
+  data = file.read(1, slab_shapes);
+
   // Get number of y-boundary guard cells saved in the grid file
   grid_yguards = data["y_boundary_guards"].withDefault<int>(0);
   // Get number ny_inner from the grid file.
@@ -30,7 +34,9 @@ GridFile::GridFile(std::string gridfilename)
  * Tests whether a variable exists in the file
  *
  */
-bool GridFile::hasVar(const std::string& name) { return data.isSet(name); }
+bool GridFile::hasVar(const std::string& name) {
+  return data.isSet(name) or (slab_shapes.count(name) > 0);
+}
 
 /*!
  * Read a string from file. If the string is not
@@ -153,6 +159,17 @@ struct GetDimensions {
 };
 } // namespace
 
+std::vector<int> GridFile::getShape(const std::string& name) {
+  const auto slab_shape = slab_shapes.find(name);
+  if (slab_shape != slab_shapes.end()) {
+    return slab_shape->second;
+  }
+  if (not data.isSet(name)) {
+    return {};
+  }
+  return bout::utils::visit(GetDimensions{}, data[name].value);
+}
+
 template <typename T>
 bool GridFile::getField(Mesh* m, T& var, const std::string& name, BoutReal def,
                         CELL_LOC location) {
@@ -163,7 +180,7 @@ bool GridFile::getField(Mesh* m, T& var, const std::string& name, BoutReal def,
   Timer timer("io");
   AUTO_TRACE();
 
-  if (not data.isSet(name)) {
+  if (not hasVar(name)) {
     // Variable not found
     output_warn.write("\tWARNING: Could not read '{:s}' from grid. Setting to {:e}\n",
                       name, def);
@@ -172,10 +189,8 @@ bool GridFile::getField(Mesh* m, T& var, const std::string& name, BoutReal def,
     return false;
   }
 
-  Options option = data[name];
-
   // Global (x, y, z) dimensions of field
-  const std::vector<int> size = bout::utils::visit(GetDimensions{}, option.value);
+  const std::vector<int> size = getShape(name);
 
   switch (size.size()) {
   case 1: {
@@ -185,7 +200,7 @@ bool GridFile::getField(Mesh* m, T& var, const std::string& name, BoutReal def,
           "Expecting a 2D variable, but '{:s}' is 1D with {:d} elements\n", name,
           size[0]);
     }
-    var = option.as<BoutReal>();
+    var = data[name].as<BoutReal>();
     var.setLocation(location);
     return true;
   }
@@ -375,11 +390,12 @@ void GridFile::readField(Mesh* UNUSED(m), const std::string& name, int ys, int y
 
   var.allocate();
 
-  const auto full_var = data[name].as<Matrix<BoutReal>>();
+  const auto local_var =
+      file.readSlab(name, {xs, ys}, {nx_to_read, ny_to_read}).as<Matrix<BoutReal>>();
 
-  for (int x = xs; x < xs + nx_to_read; ++x) {
-    for (int y = ys; y < ys + ny_to_read; ++y) {
-      var(x - xs + xd, y - ys + yd) = full_var(x, y);
+  for (int x = 0; x < nx_to_read; ++x) {
+    for (int y = 0; y < ny_to_read; ++y) {
+      var(x + xd, y + yd) = local_var(x, y);
     }
   }
 }
@@ -394,10 +410,11 @@ void GridFile::readField(Mesh* m, const std::string& name, int ys, int yd, int n
 
   // Check whether "nz" is defined
   if (hasVar("nz")) {
-    // Check the array is the right size
-    if (size[2] != m->LocalNz) {
+    // Check the array is the right size. The file holds all of Z,
+    // which may be split between processors
+    if (size[2] != m->GlobalNz) {
       throw BoutException("3D variable '{:s}' has incorrect size {:d} (expecting {:d})",
-                          name, size[2], m->LocalNz);
+                          name, size[2], m->GlobalNz);
     }
 
     if (!readgrid_3dvar_real(name,
@@ -442,11 +459,12 @@ void GridFile::readField(Mesh* m, const std::string& name, int UNUSED(ys), int U
 
     // Check whether "nz" is defined
     if (hasVar("nz")) {
-      // Check the array is the right size
-      if (size[2] != m->LocalNz) {
+      // Check the array is the right size. The file holds all of Z,
+      // which may be split between processors
+      if (size[2] != m->GlobalNz) {
         throw BoutException(
             "FieldPerp variable '{:s}' has incorrect size {:d} (expecting {:d})", name,
-            size[2], m->LocalNz);
+            size[2], m->GlobalNz);
       }
 
       if (!readgrid_perpvar_real(name,
@@ -499,8 +517,7 @@ bool GridFile::get(Mesh* UNUSED(m), std::vector<BoutReal>& var, const std::strin
 bool GridFile::hasXBoundaryGuards(Mesh* m) {
   // Global (x,y) dimensions of some field
   // a grid file should always contain "dx"
-  Options option = data["dx"];
-  const std::vector<int> size = bout::utils::visit(GetDimensions{}, option.value);
+  const std::vector<int> size = getShape("dx");
 
   if (size.empty()) {
     // handle case where "dx" is not present - non-standard grid file
@@ -535,8 +552,7 @@ bool GridFile::readgrid_3dvar_fft(Mesh* m, const std::string& name, int yread, i
   }
 
   /// Check the size of the data
-  Options option = data[name];
-  const std::vector<int> size = bout::utils::visit(GetDimensions{}, option.value);
+  const std::vector<int> size = getShape(name);
 
   if (size.size() != 3) {
     output_warn.write("\tWARNING: Number of dimensions of {:s} incorrect\n", name);
@@ -545,7 +561,9 @@ bool GridFile::readgrid_3dvar_fft(Mesh* m, const std::string& name, int yread, i
 
   int maxmode = (size[2] - 1) / 2; ///< Maximum mode-number n
 
-  int ncz = m->LocalNz;
+  // Transform to all of Z, then keep this processor's part
+  const int ncz = m->GlobalNz;
+  const int mzsub = m->zend - m->zstart + 1;
 
   /// we should be able to replace the following with
   /// var.getCoordinates()->zlength();
@@ -578,15 +596,18 @@ bool GridFile::readgrid_3dvar_fft(Mesh* m, const std::string& name, int yread, i
   /// Data for FFT. Only positive frequencies
   Array<dcomplex> fdata(ncz / 2 + 1);
   Array<BoutReal> zdata(size[2]);
+  Array<BoutReal> line(ncz);
 
-  const auto full_var = data[name].as<Tensor<BoutReal>>();
+  const auto local_var =
+      file.readSlab(name, {xread, yread, 0}, {xsize, ysize, size[2]})
+          .as<Tensor<BoutReal>>();
 
   for (int jx = xread; jx < xread + xsize; jx++) {
     // jx is global x-index to start from
     for (int jy = yread; jy < yread + ysize; jy++) {
       // jy is global y-index to start from
       for (int jz = 0; jz < size[2]; ++jz) {
-        zdata[jz] = full_var(jx, jy, jz);
+        zdata[jz] = local_var(jx - xread, jy - yread, jz);
       }
 
       /// Load into dcomplex array
@@ -602,7 +623,9 @@ bool GridFile::readgrid_3dvar_fft(Mesh* m, const std::string& name, int yread, i
           fdata[i] = 0.0;
         }
       }
-      irfft(std::begin(fdata), ncz, &var(jx - xread + xdest, jy - yread + ydest, 0));
+      irfft(std::begin(fdata), ncz, std::begin(line));
+      std::copy(std::begin(line) + m->OffsetZ, std::begin(line) + m->OffsetZ + mzsub,
+                &var(jx - xread + xdest, jy - yread + ydest, m->zstart));
     }
   }
 
@@ -622,24 +645,30 @@ bool GridFile::readgrid_3dvar_real(const std::string& name, int yread, int ydest
     return false;
   }
 
-  Options option = data[name];
-
   /// Check the size of the data
-  const std::vector<int> size = bout::utils::visit(GetDimensions{}, option.value);
+  const std::vector<int> size = getShape(name);
 
   if (size.size() != 3) {
     output_warn.write("\tWARNING: Number of dimensions of {:s} incorrect\n", name);
     return false;
   }
 
-  const auto full_var = option.as<Tensor<BoutReal>>();
+  // Only read this processor's part of Z, which may be split
+  // between processors
+  const Mesh* mesh = var.getMesh();
+  const int zsize = mesh->zend - mesh->zstart + 1;
+
+  const auto local_var =
+      file.readSlab(name, {xread, yread, mesh->OffsetZ}, {xsize, ysize, zsize})
+          .as<Tensor<BoutReal>>();
 
   for (int jx = xread; jx < xread + xsize; jx++) {
     // jx is global x-index to start from
     for (int jy = yread; jy < yread + ysize; jy++) {
       // jy is global y-index to start from
-      for (int jz = 0; jz < size[2]; ++jz) {
-        var(jx - xread + xdest, jy - yread + ydest, jz) = full_var(jx, jy, jz);
+      for (int jz = 0; jz < zsize; ++jz) {
+        var(jx - xread + xdest, jy - yread + ydest, jz + mesh->zstart) =
+            local_var(jx - xread, jy - yread, jz);
       }
     }
   }
@@ -665,8 +694,7 @@ bool GridFile::readgrid_perpvar_fft(Mesh* m, const std::string& name, int xread,
   }
 
   /// Check the size of the data
-  Options option = data[name];
-  const std::vector<int> size = bout::utils::visit(GetDimensions{}, option.value);
+  const std::vector<int> size = getShape(name);
 
   if (size.size() != 2) {
     output_warn.write("\tWARNING: Number of dimensions of {:s} incorrect\n", name);
@@ -675,7 +703,9 @@ bool GridFile::readgrid_perpvar_fft(Mesh* m, const std::string& name, int xread,
 
   int maxmode = (size[1] - 1) / 2; ///< Maximum mode-number n
 
-  int ncz = m->LocalNz;
+  // Transform to all of Z, then keep this processor's part
+  const int ncz = m->GlobalNz;
+  const int mzsub = m->zend - m->zstart + 1;
 
   /// we should be able to replace the following with
   /// var.getCoordinates()->zlength();
@@ -708,13 +738,15 @@ bool GridFile::readgrid_perpvar_fft(Mesh* m, const std::string& name, int xread,
   /// Data for FFT. Only positive frequencies
   Array<dcomplex> fdata(ncz / 2 + 1);
   Array<BoutReal> zdata(size[1]);
+  Array<BoutReal> line(ncz);
 
-  const auto full_var = option.as<Matrix<BoutReal>>();
+  const auto local_var =
+      file.readSlab(name, {xread, 0}, {xsize, size[1]}).as<Matrix<BoutReal>>();
 
   for (int jx = xread; jx < xread + xsize; jx++) {
     // jx is global x-index to start from
     for (int jz = 0; jz < size[1]; ++jz) {
-      zdata[jz] = full_var(jx, jz);
+      zdata[jz] = local_var(jx - xread, jz);
     }
 
     /// Load into dcomplex array
@@ -730,7 +762,9 @@ bool GridFile::readgrid_perpvar_fft(Mesh* m, const std::string& name, int xread,
         fdata[i] = 0.0;
       }
     }
-    irfft(std::begin(fdata), ncz, &var(jx - xread + xdest, 0));
+    irfft(std::begin(fdata), ncz, std::begin(line));
+    std::copy(std::begin(line) + m->OffsetZ, std::begin(line) + m->OffsetZ + mzsub,
+              &var(jx - xread + xdest, m->zstart));
   }
 
   return true;
@@ -748,20 +782,25 @@ bool GridFile::readgrid_perpvar_real(const std::string& name, int xread, int xde
   }
 
   /// Check the size of the data
-  Options option = data[name];
-  const std::vector<int> size = bout::utils::visit(GetDimensions{}, option.value);
+  const std::vector<int> size = getShape(name);
 
   if (size.size() != 2) {
     output_warn.write("\tWARNING: Number of dimensions of {:s} incorrect\n", name);
     return false;
   }
 
-  const auto full_var = option.as<Matrix<BoutReal>>();
+  // Only read this processor's part of Z, which may be split
+  // between processors
+  const Mesh* mesh = var.getMesh();
+  const int zsize = mesh->zend - mesh->zstart + 1;
+
+  const auto local_var =
+      file.readSlab(name, {xread, mesh->OffsetZ}, {xsize, zsize}).as<Matrix<BoutReal>>();
 
   for (int jx = xread; jx < xread + xsize; jx++) {
     // jx is global x-index to start from
-    for (int jz = 0; jz < size[1]; ++jz) {
-      var(jx - xread + xdest, jz) = full_var(jx, jz);
+    for (int jz = 0; jz < zsize; ++jz) {
+      var(jx - xread + xdest, jz + mesh->zstart) = local_var(jx - xread, jz);
     }
   }
 
@@ -147,7 +147,7 @@ bool GridFromOptions::get(Mesh* m, std::vector<BoutReal>& var, const std::string
   case GridDataSource::Z: {
     for (int z = 0; z < len; z++) {
       pos.set("z",
-              (TWOPI * (z - m->OffsetZ + offset)) / static_cast<BoutReal>(m->LocalNz));
+              (TWOPI * (z - m->OffsetZ + offset)) / static_cast<BoutReal>(m->GlobalNz));
       var[z] = gen->generate(pos);
     }
     break;
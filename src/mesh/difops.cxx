@@ -29,6 +29,7 @@
 #include <bout/derivs.hxx>
 #include <bout/difops.hxx>
 #include <bout/fft.hxx>
+#include <bout/fused_derivs.hxx>
 #include <bout/globals.hxx>
 #include <bout/msg_stack.hxx>
 #include <bout/solver.hxx>
@@ -103,7 +104,7 @@ Field3D Grad_parP(const Field3D& apar, const Field3D& f) {
 
   for (int x = 1; x <= mesh->LocalNx - 2; x++) {
     for (int y = mesh->ystart; y <= mesh->yend; y++) {
-      for (int z = 0; z < ncz; z++) {
+      for (int z = mesh->zstart; z <= mesh->zend; z++) {
         BoutReal by = 1. / sqrt(metric->g_22(x, y, z));
         // Z indices zm and zp
         int zm = (z - 1 + ncz) % ncz;
@@ -579,9 +580,14 @@ Field3D b0xGrad_dot_Grad(const Field3D& phi, const Field3D& A, CELL_LOC outloc)
   Coordinates* metric = phi.getCoordinates(outloc);
 
   // Calculate phi derivatives
-  Field3D dpdx = DDX(phi, outloc);
+  Field3D dpdx, dpdz;
+  if (bout::derivatives::fused::canFuseXZ(phi, outloc)) {
+    bout::derivatives::fused::XZ(phi, &dpdx, &dpdz, nullptr, nullptr, nullptr);
+  } else {
+    dpdx = DDX(phi, outloc);
+    dpdz = DDZ(phi, outloc);
+  }
   Field3D dpdy = DDY(phi, outloc);
-  Field3D dpdz = DDZ(phi, outloc);
 
   // Calculate advection velocity
   Field3D vx = metric->g_22 * dpdz - metric->g_23 * dpdy;
@@ -611,6 +617,53 @@ Field3D b0xGrad_dot_Grad(const Field3D& phi, const Field3D& A, CELL_LOC outloc)
  * Terms of form b0 x Grad(f) dot Grad(g) / B = [f, g]
  *******************************************************************************/
 
+namespace {
+/// The factor 1 / (12 dx dz) in the Arakawa bracket, along one z row
+#if BOUT_USE_METRIC_3D
+struct ArakawaSpacing {
+  ArakawaSpacing(Coordinates* metric, int jx, int jy)
+      : dx(metric->dx(jx, jy)), dz(metric->dz(jx, jy)) {}
+  BoutReal operator[](int jz) const { return 1.0 / (12 * dx[jz] * dz[jz]); }
+  const BoutReal* dx;
+  const BoutReal* dz;
+};
+#else
+struct ArakawaSpacing {
+  ArakawaSpacing(Coordinates* metric, int jx, int jy)
+      : factor(1.0 / (12 * metric->dz(jx, jy) * metric->dx(jx, jy))) {}
+  BoutReal operator[](int UNUSED(jz)) const { return factor; }
+  BoutReal factor;
+};
+#endif
+
+/// Fill one z row of \p result with `point(jz, jzm, jzp) * spacing[jz]`,
+/// where jzm and jzp are the neighbours of jz. If Z is split between
+/// processors the neighbours of the end points are in the Z guard
+/// cells. Otherwise the neighbours are periodic, and the first and
+/// last points are done separately, so that the loop over the rest of
+/// the row has no wrap-around and can be vectorised
+template <typename Point>
+void arakawaRow(BoutReal* result, const Mesh& mesh, const ArakawaSpacing& spacing,
+                Point point) {
+  if (mesh.zstart > 0) {
+    BOUT_OMP(simd)
+    for (int jz = mesh.zstart; jz <= mesh.zend; jz++) {
+      result[jz] = point(jz, jz - 1, jz + 1) * spacing[jz];
+    }
+    return;
+  }
+  const int ncz = mesh.LocalNz;
+  result[0] = point(0, ncz - 1, 1 % ncz) * spacing[0];
+  BOUT_OMP(simd)
+  for (int jz = 1; jz < ncz - 1; jz++) {
+    result[jz] = point(jz, jz - 1, jz + 1) * spacing[jz];
+  }
+  if (ncz > 1) {
+    result[ncz - 1] = point(ncz - 1, ncz - 2, 0) * spacing[ncz - 1];
+  }
+}
+} // namespace
+
 Coordinates::FieldMetric bracket(const Field2D& f, const Field2D& g,
                                  BRACKET_METHOD method, CELL_LOC outloc,
                                  Solver* UNUSED(solver)) {
@@ -665,7 +718,7 @@ Field3D bracket(const Field3D& f, const Field2D& g, BRACKET_METHOD method,
 
     for (int x = mesh->xstart; x <= mesh->xend; x++) {
       for (int y = mesh->ystart; y <= mesh->yend; y++) {
-        for (int z = 0; z < ncz; z++) {
+        for (int z = mesh->zstart; z <= mesh->zend; z++) {
           int zm = (z - 1 + ncz) % ncz;
           int zp = (z + 1) % ncz;
 
@@ -700,46 +753,21 @@ Field3D bracket(const Field3D& f, const Field2D& g, BRACKET_METHOD method,
   }
   case BRACKET_ARAKAWA: {
     // Arakawa scheme for perpendicular flow. Here as a test
-
-#if not(BOUT_USE_METRIC_3D)
-    const int ncz = mesh->LocalNz;
-
     BOUT_FOR(j2D, result.getRegion2D("RGN_NOBNDRY")) {
       // Get constants for this iteration
-      const BoutReal spacingFactor = 1.0 / (12 * metric->dz[j2D] * metric->dx[j2D]);
       const int jy = j2D.y(), jx = j2D.x();
       const int xm = jx - 1, xp = jx + 1;
+      const ArakawaSpacing spacing(metric, jx, jy);
 
       // Extract relevant Field2D values
       const BoutReal gxm = g(xm, jy), gc = g(jx, jy), gxp = g(xp, jy);
 
       // Index Field3D as 2D to get start of z data block
-      const auto fxm = f(xm, jy), fc = f(jx, jy), fxp = f(xp, jy);
-
-      // Here we split the loop over z into three parts; the first value, the middle block
-      // and the last value
-      // this is to allow the loop used in the middle block to vectorise.
-
-      // The first value
-      {
-        const int jzp = 1;
-        const int jzm = ncz - 1;
-
-        // J++ = DDZ(f)*DDX(g) - DDX(f)*DDZ(g)
-        const BoutReal Jpp = 2 * (fc[jzp] - fc[jzm]) * (gxp - gxm);
-
-        // J+x
-        const BoutReal Jpx = gxp * (fxp[jzp] - fxp[jzm]) - gxm * (fxm[jzp] - fxm[jzm])
-                             + gc * (fxp[jzm] - fxp[jzp] - fxm[jzm] + fxm[jzp]);
-
-        result(jx, jy, 0) = (Jpp + Jpx) * spacingFactor;
-      }
-
-      // The middle block
-      for (int jz = 1; jz < mesh->LocalNz - 1; jz++) {
-        const int jzp = jz + 1;
-        const int jzm = jz - 1;
+      const BoutReal* fxm = f(xm, jy);
+      const BoutReal* fc = f(jx, jy);
+      const BoutReal* fxp = f(xp, jy);
 
+      arakawaRow(result(jx, jy), *mesh, spacing, [&](int UNUSED(jz), int jzm, int jzp) {
         // J++ = DDZ(f)*DDX(g) - DDX(f)*DDZ(g)
         const BoutReal Jpp = 2 * (fc[jzp] - fc[jzm]) * (gxp - gxm);
 
@@ -747,28 +775,9 @@ Field3D bracket(const Field3D& f, const Field2D& g, BRACKET_METHOD method,
         const BoutReal Jpx = gxp * (fxp[jzp] - fxp[jzm]) - gxm * (fxm[jzp] - fxm[jzm])
                              + gc * (fxp[jzm] - fxp[jzp] - fxm[jzm] + fxm[jzp]);
 
-        result(jx, jy, jz) = (Jpp + Jpx) * spacingFactor;
-      }
-
-      // The last value
-      {
-        const int jzp = 0;
-        const int jzm = ncz - 2;
-
-        // J++ = DDZ(f)*DDX(g) - DDX(f)*DDZ(g)
-        const BoutReal Jpp = 2 * (fc[jzp] - fc[jzm]) * (gxp - gxm);
-
-        // J+x
-        const BoutReal Jpx = gxp * (fxp[jzp] - fxp[jzm]) - gxm * (fxm[jzp] - fxm[jzm])
-                             + gc * (fxp[jzm] - fxp[jzp] - fxm[jzm] + fxm[jzp]);
-
-        result(jx, jy, ncz - 1) = (Jpp + Jpx) * spacingFactor;
-      }
+        return Jpp + Jpx;
+      });
     }
-#else
-    throw BoutException("BRACKET_ARAKAWA not valid with 3D metrics yet.");
-#endif
-
     break;
   }
   case BRACKET_ARAKAWA_OLD: {
@@ -779,7 +788,7 @@ Field3D bracket(const Field3D& f, const Field2D& g, BRACKET_METHOD method,
       for (int jy = mesh->ystart; jy <= mesh->yend; jy++) {
         const BoutReal partialFactor = 1.0 / (12 * metric->dz(jx, jy));
         const BoutReal spacingFactor = partialFactor / metric->dx(jx, jy);
-        for (int jz = 0; jz < mesh->LocalNz; jz++) {
+        for (int jz = mesh->zstart; jz <= mesh->zend; jz++) {
           const int jzp = jz + 1 < ncz ? jz + 1 : 0;
           // Above is alternative to const int jzp = (jz + 1) % ncz;
           const int jzm = jz - 1 >= 0 ? jz - 1 : ncz - 1;
@@ -904,7 +913,7 @@ Field3D bracket(const Field3D& f, const Field3D& g, BRACKET_METHOD method,
     int ncz = mesh->LocalNz;
     for (int y = mesh->ystart; y <= mesh->yend; y++) {
       for (int x = 1; x <= mesh->LocalNx - 2; x++) {
-        for (int z = 0; z < mesh->LocalNz; z++) {
+        for (int z = mesh->zstart; z <= mesh->zend; z++) {
           int zm = (z - 1 + ncz) % ncz;
           int zp = (z + 1) % ncz;
 
@@ -924,7 +933,7 @@ Field3D bracket(const Field3D& f, const Field3D& g, BRACKET_METHOD method,
       // Simplest form: use cell-centered velocities (no divergence included so not flux conservative)
 
       for (int x = mesh->xstart; x <= mesh->xend; x++) {
-        for (int z = 0; z < ncz; z++) {
+        for (int z = mesh->zstart; z <= mesh->zend; z++) {
           int zm = (z - 1 + ncz) % ncz;
           int zp = (z + 1) % ncz;
 
@@ -990,36 +999,20 @@ Field3D bracket(const Field3D& f, const Field3D& g, BRACKET_METHOD method,
   }
   case BRACKET_ARAKAWA: {
     // Arakawa scheme for perpendicular flow
-    const int ncz = mesh->LocalNz;
-
-    // We need to discard const qualifier in order to manipulate
-    // storage array directly
-    Field3D f_temp = f;
-    Field3D g_temp = g;
-
     BOUT_FOR(j2D, result.getRegion2D("RGN_NOBNDRY")) {
-#if not(BOUT_USE_METRIC_3D)
-      const BoutReal spacingFactor = 1.0 / (12 * metric->dz[j2D] * metric->dx[j2D]);
-#endif
       const int jy = j2D.y(), jx = j2D.x();
       const int xm = jx - 1, xp = jx + 1;
+      const ArakawaSpacing spacing(metric, jx, jy);
 
-      const auto Fxm = f_temp(xm, jy), Fx = f_temp(jx, jy), Fxp = f_temp(xp, jy);
-      const auto Gxm = g_temp(xm, jy), Gx = g_temp(jx, jy), Gxp = g_temp(xp, jy);
-
-      // Here we split the loop over z into three parts; the first value, the middle block
-      // and the last value
-      // this is to allow the loop used in the middle block to vectorise.
-
-      {
-        const int jz = 0;
-        const int jzp = 1;
-        const int jzm = ncz - 1;
-#if BOUT_USE_METRIC_3D
-        const BoutReal spacingFactor =
-            1.0 / (12 * metric->dz(jx, jy, jz) * metric->dx(jx, jy, jz));
-#endif
+      // Index the fields as 2D to get the start of each z row
+      const BoutReal* Fxm = f(xm, jy);
+      const BoutReal* Fx = f(jx, jy);
+      const BoutReal* Fxp = f(xp, jy);
+      const BoutReal* Gxm = g(xm, jy);
+      const BoutReal* Gx = g(jx, jy);
+      const BoutReal* Gxp = g(xp, jy);
 
+      arakawaRow(result(jx, jy), *mesh, spacing, [&](int jz, int jzm, int jzp) {
         // J++ = DDZ(f)*DDX(g) - DDX(f)*DDZ(g)
         const BoutReal Jpp = ((Fx[jzp] - Fx[jzm]) * (Gxp[jz] - Gxm[jz])
                               - (Fxp[jz] - Fxm[jz]) * (Gx[jzp] - Gx[jzm]));
@@ -1034,59 +1027,8 @@ Field3D bracket(const Field3D& f, const Field3D& g, BRACKET_METHOD method,
             (Gxp[jzp] * (Fx[jzp] - Fxp[jz]) - Gxm[jzm] * (Fxm[jz] - Fx[jzm])
              - Gxm[jzp] * (Fx[jzp] - Fxm[jz]) + Gxp[jzm] * (Fxp[jz] - Fx[jzm]));
 
-        result(jx, jy, jz) = (Jpp + Jpx + Jxp) * spacingFactor;
-      }
-
-      for (int jz = 1; jz < mesh->LocalNz - 1; jz++) {
-#if BOUT_USE_METRIC_3D
-        const BoutReal spacingFactor =
-            1.0 / (12 * metric->dz(jx, jy, jz) * metric->dx(jx, jy, jz));
-#endif
-        const int jzp = jz + 1;
-        const int jzm = jz - 1;
-
-        // J++ = DDZ(f)*DDX(g) - DDX(f)*DDZ(g)
-        const BoutReal Jpp = ((Fx[jzp] - Fx[jzm]) * (Gxp[jz] - Gxm[jz])
-                              - (Fxp[jz] - Fxm[jz]) * (Gx[jzp] - Gx[jzm]));
-
-        // J+x
-        const BoutReal Jpx =
-            (Gxp[jz] * (Fxp[jzp] - Fxp[jzm]) - Gxm[jz] * (Fxm[jzp] - Fxm[jzm])
-             - Gx[jzp] * (Fxp[jzp] - Fxm[jzp]) + Gx[jzm] * (Fxp[jzm] - Fxm[jzm]));
-
-        // Jx+
-        const BoutReal Jxp =
-            (Gxp[jzp] * (Fx[jzp] - Fxp[jz]) - Gxm[jzm] * (Fxm[jz] - Fx[jzm])
-             - Gxm[jzp] * (Fx[jzp] - Fxm[jz]) + Gxp[jzm] * (Fxp[jz] - Fx[jzm]));
-
-        result(jx, jy, jz) = (Jpp + Jpx + Jxp) * spacingFactor;
-      }
-
-      {
-        const int jz = ncz - 1;
-        const int jzp = 0;
-        const int jzm = ncz - 2;
-#if BOUT_USE_METRIC_3D
-        const BoutReal spacingFactor =
-            1.0 / (12 * metric->dz(jx, jy, jz) * metric->dx(jx, jy, jz));
-#endif
-
-        // J++ = DDZ(f)*DDX(g) - DDX(f)*DDZ(g)
-        const BoutReal Jpp = ((Fx[jzp] - Fx[jzm]) * (Gxp[jz] - Gxm[jz])
-                              - (Fxp[jz] - Fxm[jz]) * (Gx[jzp] - Gx[jzm]));
-
-        // J+x
-        const BoutReal Jpx =
-            (Gxp[jz] * (Fxp[jzp] - Fxp[jzm]) - Gxm[jz] * (Fxm[jzp] - Fxm[jzm])
-             - Gx[jzp] * (Fxp[jzp] - Fxm[jzp]) + Gx[jzm] * (Fxp[jzm] - Fxm[jzm]));
-
-        // Jx+
-        const BoutReal Jxp =
-            (Gxp[jzp] * (Fx[jzp] - Fxp[jz]) - Gxm[jzm] * (Fxm[jz] - Fx[jzm])
-             - Gxm[jzp] * (Fx[jzp] - Fxm[jz]) + Gxp[jzm] * (Fxp[jz] - Fx[jzm]));
-
-        result(jx, jy, jz) = (Jpp + Jpx + Jxp) * spacingFactor;
-      }
+        return Jpp + Jpx + Jxp;
+      });
     }
     break;
   }
@@ -1113,7 +1055,7 @@ Field3D bracket(const Field3D& f, const Field3D& g, BRACKET_METHOD method,
         const BoutReal* Gxm = g_temp(jx - 1, jy);
         const BoutReal* Gx = g_temp(jx, jy);
         const BoutReal* Gxp = g_temp(jx + 1, jy);
-        for (int jz = 0; jz < mesh->LocalNz; jz++) {
+        for (int jz = mesh->zstart; jz <= mesh->zend; jz++) {
 #if BOUT_USE_METRIC_3D
           const BoutReal spacingFactor =
               1.0 / (12 * metric->dz(jx, jy, jz) * metric->dx(jx, jy, jz));
@@ -1149,7 +1091,11 @@ Field3D bracket(const Field3D& f, const Field3D& g, BRACKET_METHOD method,
   }
   case BRACKET_SIMPLE: {
     // Use a subset of terms for comparison to BOUT-06
-    result = VDDX(DDZ(f, outloc), g, outloc) + VDDZ(-DDX(f, outloc), g, outloc);
+    if (bout::derivatives::fused::canFuseSimpleBracket(f, g, outloc)) {
+      result = bout::derivatives::fused::simpleBracket(f, g);
+    } else {
+      result = VDDX(DDZ(f, outloc), g, outloc) + VDDZ(-DDX(f, outloc), g, outloc);
+    }
     break;
   }
   default: {
@@ -44,11 +44,15 @@
 #include <bout/msg_stack.hxx>
 #include <bout/options.hxx>
 #include <bout/output.hxx>
+#include <bout/sys/profiler.hxx>
 #include <bout/sys/timer.hxx>
 #include <bout/utils.hxx>
 
+#include <fmt/ranges.h>
+
 #include <algorithm>
 #include <iterator>
+#include <numeric>
 #include <set>
 
 /// MPI type of BoutReal for communications
@@ -76,6 +80,10 @@ BoutMesh::~BoutMesh() {
   // Delete the communication handles
   clear_handles();
 
+  // Free the persistent communication requests while the MPI wrapper
+  // is still valid
+  comm_plans.clear();
+
   // Delete the boundary regions
   for (const auto& bndry : boundary) {
     delete bndry;
@@ -87,6 +95,9 @@ BoutMesh::~BoutMesh() {
   if (comm_x != MPI_COMM_NULL) {
     MPI_Comm_free(&comm_x);
   }
+  if (comm_z != MPI_COMM_NULL) {
+    MPI_Comm_free(&comm_z);
+  }
   if (comm_inner != MPI_COMM_NULL) {
     MPI_Comm_free(&comm_inner);
   }
@@ -236,6 +247,141 @@ CheckMeshResult checkBoutMeshYDecomposition(int num_y_processors, int ny,
 
   return {true, ""};
 }
+
+std::vector<int> boutMeshYProcessorBoundaries(int ny, int jyseps1_1, int jyseps2_1,
+                                              int jyseps1_2, int jyseps2_2,
+                                              int ny_inner) {
+  // Lower X-point
+  std::vector<int> candidates{jyseps1_1 + 1, jyseps2_2 + 1};
+  if (jyseps2_1 != jyseps1_2) {
+    // Double null, so also the upper X-point and the upper targets
+    candidates.insert(candidates.end(), {jyseps2_1 + 1, ny_inner, jyseps1_2 + 1});
+  }
+
+  std::vector<int> boundaries;
+  std::copy_if(candidates.begin(), candidates.end(), std::back_inserter(boundaries),
+               [ny](int y) { return (y > 0) and (y < ny); });
+  std::sort(boundaries.begin(), boundaries.end());
+  boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+  return boundaries;
+}
+
+CheckMeshResult checkWeightedDecomposition(int num_points, int num_processors,
+                                           int min_points,
+                                           const std::vector<int>& boundaries) {
+  const int min_size = std::max(min_points, 1);
+
+  // Each range between boundaries needs at least one processor, and
+  // can't have more than fit with min_size points each
+  int min_processors = 0;
+  int max_processors = 0;
+  int start = 0;
+  for (std::size_t i = 0; i <= boundaries.size(); ++i) {
+    const int end = (i < boundaries.size()) ? boundaries[i] : num_points;
+    if (end - start < min_size) {
+      return {false, fmt::format(_("	 -> Range {:d} to {:d} between processor "
+                                   "boundaries must have at least {:d} points\n"),
+                                 start, end - 1, min_size)};
+    }
+    ++min_processors;
+    max_processors += (end - start) / min_size;
+    start = end;
+  }
+
+  if (num_processors < min_processors) {
+    return {false,
+            fmt::format(_("	 -> Need at least {:d} processors, one for each range "
+                          "between processor boundaries, but have {:d}\n"),
+                        min_processors, num_processors)};
+  }
+  if (num_processors > max_processors) {
+    return {false, fmt::format(_("	 -> Too many processors ({:d}) to have at least "
+                                 "{:d} points on each\n"),
+                               num_processors, min_size)};
+  }
+
+  return {true, ""};
+}
+
+std::vector<int> weightedDecomposition(const std::vector<BoutReal>& weights,
+                                       int num_processors, int min_points,
+                                       const std::vector<int>& boundaries) {
+  const int num_points = static_cast<int>(weights.size());
+
+  auto result =
+      checkWeightedDecomposition(num_points, num_processors, min_points, boundaries);
+  if (not result.success) {
+    throw BoutException(result.reason);
+  }
+  if (std::any_of(weights.begin(), weights.end(), [](BoutReal w) { return w < 0.0; })) {
+    throw BoutException(_("Cost weights for the processor split must not be negative"));
+  }
+
+  const int min_size = std::max(min_points, 1);
+
+  // Total weight before each point
+  std::vector<BoutReal> cumulative(num_points + 1, 0.0);
+  std::partial_sum(weights.begin(), weights.end(), std::next(cumulative.begin()));
+  if (cumulative.back() <= 0.0) {
+    // No information, so split equally
+    std::iota(cumulative.begin(), cumulative.end(), 0.0);
+  }
+
+  // Ranges between boundaries are split separately
+  std::vector<int> range_starts{0};
+  range_starts.insert(range_starts.end(), boundaries.begin(), boundaries.end());
+  range_starts.push_back(num_points);
+  const int num_ranges = static_cast<int>(range_starts.size()) - 1;
+
+  const auto rangeWeight = [&](int r) {
+    return cumulative[range_starts[r + 1]] - cumulative[range_starts[r]];
+  };
+
+  // Start with one processor in each range, then give each of the
+  // rest to the range with the most weight per processor
+  std::vector<int> range_processors(num_ranges, 1);
+  for (int p = num_ranges; p < num_processors; ++p) {
+    int best = -1;
+    for (int r = 0; r < num_ranges; ++r) {
+      if ((range_processors[r] + 1) * min_size > range_starts[r + 1] - range_starts[r]) {
+        continue; // Full
+      }
+      if ((best < 0)
+          or (rangeWeight(r) * range_processors[best]
+              > rangeWeight(best) * range_processors[r])) {
+        best = r;
+      }
+    }
+    ++range_processors[best];
+  }
+
+  std::vector<int> offsets{0};
+  for (int r = 0; r < num_ranges; ++r) {
+    const int first = range_starts[r];
+    const int last = range_starts[r + 1];
+    const int nproc = range_processors[r];
+
+    for (int k = 1; k < nproc; ++k) {
+      // Split at the point where the total weight is nearest to k
+      // shares of the weight in this range
+      const BoutReal target = cumulative[first] + (rangeWeight(r) * k) / nproc;
+      auto split = static_cast<int>(std::distance(
+          cumulative.begin(), std::lower_bound(std::next(cumulative.begin(), first),
+                                               std::next(cumulative.begin(), last),
+                                               target)));
+      if ((split > first)
+          and (target - cumulative[split - 1] < cumulative[split] - target)) {
+        --split;
+      }
+      // Leave at least min_size points on this and each remaining processor
+      split = std::max(split, offsets.back() + min_size);
+      split = std::min(split, last - (nproc - k) * min_size);
+      offsets.push_back(split);
+    }
+    offsets.push_back(last);
+  }
+  return offsets;
+}
 } // namespace bout
 
 void BoutMesh::chooseProcessorSplit(Options& options) {
@@ -244,35 +390,44 @@ void BoutMesh::chooseProcessorSplit(Options& options) {
   // - can set NXPE > nx
   // - can set NYPE > ny (if only one processor)
 
+  // Processors in each Z slab, which are split between X and Y
+  const int npes_xy = NPES / NZPE;
+
   if (options.isSet("NXPE")) {
     NXPE = options["NXPE"]
                .doc("Decomposition in the radial direction. If not given then calculated "
                     "automatically.")
                .withDefault(1);
-    if ((NPES % NXPE) != 0) {
+    if ((npes_xy % NXPE) != 0) {
       throw BoutException(
           _("Number of processors ({:d}) not divisible by NPs in x direction ({:d})\n"),
-          NPES, NXPE);
+          npes_xy, NXPE);
     }
 
-    NYPE = NPES / NXPE;
+    NYPE = npes_xy / NXPE;
   } else {
     // NXPE not set, but NYPE is
     NYPE = options["NYPE"]
                .doc("Decomposition in the parallel direction. Can be given instead of "
                     "NXPE. If neither is given, then calculated automatically.")
                .withDefault(1);
-    if ((NPES % NYPE) != 0) {
+    if ((npes_xy % NYPE) != 0) {
       throw BoutException(
           _("Number of processors ({:d}) not divisible by NPs in y direction ({:d})\n"),
-          NPES, NYPE);
+          npes_xy, NYPE);
     }
 
-    NXPE = NPES / NYPE;
+    NXPE = npes_xy / NYPE;
   }
 
-  auto result = bout::checkBoutMeshYDecomposition(NYPE, ny, MYG, jyseps1_1, jyseps2_1,
-                                                  jyseps1_2, jyseps2_2, ny_inner);
+  auto result =
+      load_balance
+          ? bout::checkWeightedDecomposition(
+              ny, NYPE, MYG,
+              bout::boutMeshYProcessorBoundaries(ny, jyseps1_1, jyseps2_1, jyseps1_2,
+                                                 jyseps2_2, ny_inner))
+          : bout::checkBoutMeshYDecomposition(NYPE, ny, MYG, jyseps1_1, jyseps2_1,
+                                              jyseps1_2, jyseps2_2, ny_inner);
 
   if (not result.success) {
     throw BoutException(result.reason);
@@ -284,22 +439,38 @@ void BoutMesh::findProcessorSplit() {
 
   NXPE = -1; // Best option
 
+  // Processors in each Z slab, which are split between X and Y
+  const int npes_xy = NPES / NZPE;
+
   // Results in square domains
-  const BoutReal ideal = sqrt(MX * NPES / static_cast<BoutReal>(ny));
+  const BoutReal ideal = sqrt(MX * npes_xy / static_cast<BoutReal>(ny));
 
   output_info.write(_("Finding value for NXPE (ideal = {:f})\n"), ideal);
 
-  for (int i = 1; i <= NPES; i++) { // Loop over all possibilities
-    if ((NPES % i == 0) &&          // Processors divide equally
-        (MX % i == 0) &&            // Mesh in X divides equally
-        (ny % (NPES / i) == 0)) {   // Mesh in Y divides equally
+  // With load balancing the mesh doesn't need to divide equally, as
+  // long as there are enough points for each processor
+  const std::vector<int> y_boundaries = bout::boutMeshYProcessorBoundaries(
+      ny, jyseps1_1, jyseps2_1, jyseps1_2, jyseps2_2, ny_inner);
+  const auto xSplits = [&](int nxp) {
+    return load_balance
+               ? bout::checkWeightedDecomposition(MX, nxp, (nxp > 1) ? MXG : 1).success
+               : (MX % nxp == 0);
+  };
+
+  for (int i = 1; i <= npes_xy; i++) { // Loop over all possibilities
+    if ((npes_xy % i == 0) &&          // Processors divide equally
+        xSplits(i) &&                  // Mesh in X can be split
+        (load_balance or (ny % (npes_xy / i) == 0))) { // Mesh in Y divides equally
 
       output_info.write(_("\tCandidate value: {:d}\n"), i);
 
-      const int nyp = NPES / i;
+      const int nyp = npes_xy / i;
 
-      auto result = bout::checkBoutMeshYDecomposition(nyp, ny, MYG, jyseps1_1, jyseps2_1,
-                                                      jyseps1_2, jyseps2_2, ny_inner);
+      auto result =
+          load_balance
+              ? bout::checkWeightedDecomposition(ny, nyp, MYG, y_boundaries)
+              : bout::checkBoutMeshYDecomposition(nyp, ny, MYG, jyseps1_1, jyseps2_1,
+                                                  jyseps1_2, jyseps2_2, ny_inner);
 
       if (not result.success) {
         output_info.write(result.reason);
@@ -319,13 +490,88 @@ void BoutMesh::findProcessorSplit() {
                           "number of processors."));
   }
 
-  NYPE = NPES / NXPE;
+  NYPE = npes_xy / NXPE;
 
   output_progress.write(_("\tDomain split (NXPE={:d}, NYPE={:d}) into domains "
                           "(localNx={:d}, localNy={:d})\n"),
                         NXPE, NYPE, MX / NXPE, ny / NYPE);
 }
 
+void BoutMesh::chooseWeightedDecomposition() {
+  // Start from a nearly equal split, so that the mesh is set up
+  // enough for the mesh source to evaluate the cost profiles
+  MX = nx - 2 * MXG;
+  MY = ny;
+  x_offsets.resize(NXPE + 1);
+  for (int i = 0; i <= NXPE; i++) {
+    x_offsets[i] = (i * MX) / NXPE;
+  }
+  y_offsets.resize(NYPE + 1);
+  for (int i = 0; i <= NYPE; i++) {
+    y_offsets[i] = (i * MY) / NYPE;
+  }
+  setDerivedGridSizes();
+
+  const auto readWeights = [this](const std::string& name, int length, int offset,
+                                  GridDataSource::Direction direction) {
+    std::vector<BoutReal> weights(length, 1.0);
+    if (source->hasVar(name)) {
+      // Profiles in a grid file are copied as they are, so must have
+      // exactly one value per point
+      auto* file = dynamic_cast<GridFile*>(source);
+      if (file != nullptr and file->getShape(name) != std::vector<int>{length}) {
+        throw BoutException(_("{:s} in the grid file must be a 1D array of {:d} "
+                              "values{:s}"),
+                            name, length,
+                            direction == GridDataSource::Y
+                                ? _(", without Y boundary cells even if "
+                                    "y_boundary_guards > 0")
+                                : "");
+      }
+      source->get(this, weights, name, length, offset, direction);
+      output_info.write(_("\tRead {:s} for load balancing\n"), name);
+    }
+    return weights;
+  };
+
+  // Only the points between the X boundaries are split
+  const auto x_weights = readWeights("cost_weight_x", nx, 0, GridDataSource::X);
+  x_offsets = bout::weightedDecomposition(
+      std::vector<BoutReal>(std::next(x_weights.begin(), MXG),
+                            std::prev(x_weights.end(), MXG)),
+      NXPE, (NXPE > 1) ? MXG : 1);
+
+  // cost_weight_y has ny values, even if the 2D fields in a grid file
+  // have Y boundary cells (y_boundary_guards > 0). The options source
+  // evaluates the profile at local indices, which include the lower
+  // Y boundary cells, so skip over those
+  const int y_weights_offset = source->is_file ? 0 : MYG;
+  y_offsets = bout::weightedDecomposition(
+      readWeights("cost_weight_y", ny, y_weights_offset, GridDataSource::Y), NYPE, MYG,
+      bout::boutMeshYProcessorBoundaries(ny, jyseps1_1, jyseps2_1, jyseps1_2, jyseps2_2,
+                                         ny_inner));
+
+  output_info.write(_("\tLoad balanced X processor offsets: {:s}\n"),
+                    fmt::format("{}", fmt::join(x_offsets, ", ")));
+  output_info.write(_("\tLoad balanced Y processor offsets: {:s}\n"),
+                    fmt::format("{}", fmt::join(y_offsets, ", ")));
+
+  const auto uneven = [](const std::vector<int>& offsets) {
+    for (std::size_t i = 2; i < offsets.size(); i++) {
+      if (offsets[i] - offsets[i - 1] != offsets[1] - offsets[0]) {
+        return true;
+      }
+    }
+    return false;
+  };
+  if (uneven(x_offsets) or uneven(y_offsets)) {
+    output_warn.write(_("\tWARNING: load_balance gives processors different numbers of "
+                        "points. Each output file records its OffsetX and OffsetY, but "
+                        "tools which assume the same MXSUB and MYSUB in every file "
+                        "can't collect the output\n"));
+  }
+}
+
 void BoutMesh::setDerivedGridSizes() {
   // Check that nx is large enough
   if (nx <= 2 * MXG) {
@@ -350,20 +596,32 @@ void BoutMesh::setDerivedGridSizes() {
   // Split MX points between NXPE processors
   // MXG at each end needed for edge boundary regions
   MX = nx - 2 * MXG;
-  MXSUB = MX / NXPE;
-  if ((MX % NXPE) != 0) {
-    throw BoutException(_("Cannot split {:d} X points equally between {:d} processors\n"),
-                        MX, NXPE);
+  if ((static_cast<int>(x_offsets.size()) != NXPE + 1) or (x_offsets.back() != MX)) {
+    if ((MX % NXPE) != 0) {
+      throw BoutException(
+          _("Cannot split {:d} X points equally between {:d} processors\n"), MX, NXPE);
+    }
+    x_offsets.resize(NXPE + 1);
+    for (int i = 0; i <= NXPE; i++) {
+      x_offsets[i] = i * (MX / NXPE);
+    }
   }
+  MXSUB = x_offsets[PE_XIND + 1] - x_offsets[PE_XIND];
 
   // NOTE: No grid data reserved for Y boundary cells - copy from neighbours
   MY = ny;
-  MYSUB = MY / NYPE;
-  if ((MY % NYPE) != 0) {
-    throw BoutException(
-        _("\tERROR: Cannot split {:d} Y points equally between {:d} processors\n"), MY,
-        NYPE);
+  if ((static_cast<int>(y_offsets.size()) != NYPE + 1) or (y_offsets.back() != MY)) {
+    if ((MY % NYPE) != 0) {
+      throw BoutException(
+          _("\tERROR: Cannot split {:d} Y points equally between {:d} processors\n"), MY,
+          NYPE);
+    }
+    y_offsets.resize(NYPE + 1);
+    for (int i = 0; i <= NYPE; i++) {
+      y_offsets[i] = i * (MY / NYPE);
+    }
   }
+  MYSUB = y_offsets[PE_YIND + 1] - y_offsets[PE_YIND];
 
   MZ = nz;
   MZSUB = MZ / NZPE;
@@ -372,11 +630,16 @@ void BoutMesh::setDerivedGridSizes() {
         _("\tERROR: Cannot split {:d} Z points equally between {:d} processors\n"), MZ,
         NZPE);
   }
+  if (MZSUB < MZG) {
+    throw BoutException(
+        _("\tERROR: Need at least MZG ({:d}) Z points on each processor, but have {:d}\n"),
+        MZG, MZSUB);
+  }
 
   // Set global offsets
-  OffsetX = PE_XIND * MXSUB;
-  OffsetY = PE_YIND * MYSUB;
-  OffsetZ = 0;
+  OffsetX = x_offsets[PE_XIND];
+  OffsetY = y_offsets[PE_YIND];
+  OffsetZ = PE_ZIND * MZSUB;
 
   // Number of grid cells on this processor is ng* = M*SUB + guard/boundary cells
   LocalNx = MXSUB + 2 * MXG;
@@ -453,12 +716,28 @@ int BoutMesh::load() {
   }
   ASSERT0(MYG >= 0);
 
-  // For now only support no z-guard cells
-  MZG = 0;
-  ASSERT0(MZG >= 0);
+  NZPE = options["NZPE"]
+             .doc("Decomposition in the toroidal (Z) direction")
+             .withDefault(1);
+  if ((NZPE < 1) or (NPES % NZPE) != 0) {
+    throw BoutException(
+        _("Number of processors ({:d}) not divisible by NPs in z direction ({:d})\n"),
+        NPES, NZPE);
+  }
 
-  // For now don't parallelise z
-  NZPE = 1;
+  if (NZPE > 1) {
+    // Z guard cells are exchanged with the neighbouring processors
+    // in Z, so must be at least as wide as the Z derivative stencils
+    MZG = options["MZG"]
+              .doc("Number of guard cells on each side in Z. Only used if NZPE > 1")
+              .withDefault(2);
+    if (MZG < 1) {
+      throw BoutException(_("Need at least one guard cell in Z (MZG) when NZPE > 1"));
+    }
+  } else {
+    // Z is periodic on each processor, so no guard cells are needed
+    MZG = 0;
+  }
 
   output_info << _("\tGuard cells (x,y,z): ") << MXG << ", " << MYG << ", " << MZG
               << std::endl;
@@ -475,16 +754,29 @@ int BoutMesh::load() {
   // Check inputs
   setYDecompositionIndices(jyseps1_1, jyseps2_1, jyseps1_2, jyseps2_2, ny_inner);
 
+  load_balance =
+      options["load_balance"]
+          .doc("Split X and Y between processors so that each has a similar cost, "
+               "using cost_weight_x and cost_weight_y from the grid, rather than "
+               "the same number of points")
+          .withDefault(false);
+
   if (options.isSet("NXPE") or options.isSet("NYPE")) {
     chooseProcessorSplit(options);
   } else {
     findProcessorSplit();
   }
 
-  // Get X and Y processor indices
-  PE_YIND = MYPE / NXPE;
+  // Get X, Y and Z processor indices. Each Z slab is a complete
+  // X-Y decomposition, numbered in the same order as with NZPE = 1
+  PE_ZIND = MYPE / (NXPE * NYPE);
+  PE_YIND = (MYPE % (NXPE * NYPE)) / NXPE;
   PE_XIND = MYPE % NXPE;
 
+  if (load_balance) {
+    chooseWeightedDecomposition();
+  }
+
   // Set the other grid sizes from nx, ny, nz
   setDerivedGridSizes();
 
@@ -496,6 +788,12 @@ int BoutMesh::load() {
                    .doc("Whether to use asyncronous MPI sends")
                    .withDefault(false);
 
+  persistent_comms =
+      options["persistent_comms"]
+          .doc("Reuse persistent MPI requests and buffers for repeated communications "
+               "of the same group of fields")
+          .withDefault(false);
+
   if (options.isSet("zperiod")) {
     OPTION(options, zperiod, 1);
     ZMIN = 0.0;
@@ -527,6 +825,10 @@ int BoutMesh::load() {
   }
 
   if (TwistShift) {
+    if (NZPE > 1) {
+      throw BoutException("Twist-shift can't be used with NZPE > 1, as it needs the "
+                          "whole of Z on each processor");
+    }
     output_info.write("Applying Twist-Shift condition. Interpolation: FFT\n");
     if (ShiftAngle.empty()) {
       throw BoutException("ERROR: Twist-shift angle 'ShiftAngle' not found. "
@@ -919,6 +1221,16 @@ void BoutMesh::createCommunicators() {
   }
   MPI_Group_free(&group_world);
   // Now have communicators for all regions.
+
+  //////////////////////////////////////////////////////
+  /// Communicator in Z
+
+  // Processors with the same X and Y indices, ordered by Z index
+  if (MPI_Comm_split(BoutComm::get(), PE_YIND * NXPE + PE_XIND, PE_ZIND, &comm_z)
+      != MPI_SUCCESS) {
+    throw BoutException("Could not create Z communicator (xind={:d},yind={:d})\n",
+                        PE_XIND, PE_YIND);
+  }
 }
 
 void BoutMesh::createXBoundaries() {
@@ -1062,6 +1374,15 @@ void BoutMesh::setShiftAngle(const std::vector<BoutReal>& shift_angle) {
   ShiftAngle = shift_angle;
 }
 
+void BoutMesh::setZDecomposition(int nzpe, int pe_zind, int mzg) {
+  NZPE = nzpe;
+  PE_ZIND = pe_zind;
+  MZG = mzg;
+  NPES = NXPE * NYPE * NZPE;
+  MYPE = (PE_ZIND * NYPE + PE_YIND) * NXPE + PE_XIND;
+  setDerivedGridSizes();
+}
+
 /****************************************************************
  *                 COMMUNICATIONS
  ****************************************************************/
@@ -1073,24 +1394,32 @@ const int OUT_SENT_DOWN = 3; ///< Data higher in X than branch-cut, at lower bou
 // X communication signals
 const int IN_SENT_OUT = 4; ///< Data going in positive X direction (in to out)
 const int OUT_SENT_IN = 5; ///< Data going in negative X direction (out to in)
+// Z communication signals
+const int Z_SENT_UP = 6;   ///< Data going in positive Z direction
+const int Z_SENT_DOWN = 7; ///< Data going in negative Z direction
+/// Data going in positive Z direction, in columns received from X or Y neighbours
+const int Z_CORNERS_SENT_UP = 8;
+/// Data going in negative Z direction, in columns received from X or Y neighbours
+const int Z_CORNERS_SENT_DOWN = 9;
 
 void BoutMesh::post_receiveX(CommHandle& ch) {
+  // Number of rows in each message
+  const int ny = ch.x_corners_only ? 2 * MYG : (ch.include_x_corners ? LocalNy : MYSUB);
+
   /// Post receive data from left (x-1)
 
   if (IDATA_DEST != -1) {
-    mpi->MPI_Irecv(
-        std::begin(ch.imsg_recvbuff),
-        msg_len(ch.var_list.get(), 0, MXG, 0, ch.include_x_corners ? LocalNy : MYSUB),
-        PVEC_REAL_MPI_TYPE, IDATA_DEST, OUT_SENT_IN, BoutComm::get(), &ch.request[4]);
+    mpi->MPI_Irecv(std::begin(ch.imsg_recvbuff), msg_len(ch.var_list.get(), 0, MXG, 0, ny),
+                   PVEC_REAL_MPI_TYPE, IDATA_DEST, OUT_SENT_IN, BoutComm::get(),
+                   &ch.request[4]);
   }
 
   // Post receive data from right (x+1)
 
   if (ODATA_DEST != -1) {
-    mpi->MPI_Irecv(
-        std::begin(ch.omsg_recvbuff),
-        msg_len(ch.var_list.get(), 0, MXG, 0, ch.include_x_corners ? LocalNy : MYSUB),
-        PVEC_REAL_MPI_TYPE, ODATA_DEST, IN_SENT_OUT, BoutComm::get(), &ch.request[5]);
+    mpi->MPI_Irecv(std::begin(ch.omsg_recvbuff), msg_len(ch.var_list.get(), 0, MXG, 0, ny),
+                   PVEC_REAL_MPI_TYPE, ODATA_DEST, IN_SENT_OUT, BoutComm::get(),
+                   &ch.request[5]);
   }
 }
 
@@ -1131,15 +1460,25 @@ void BoutMesh::post_receiveY(CommHandle& ch) {
 }
 
 comm_handle BoutMesh::send(FieldGroup& g) {
-  /// Start timer
-  Timer timer("comms");
-
   if (include_corner_cells) {
     throw BoutException("Cannot use send() when include_corner_cells==true as it sends "
                         "in x- and y-directions simultaneously. Use sendX() and sendY() "
                         "instead.");
   }
 
+  return sendWithoutCorners(g);
+}
+
+comm_handle BoutMesh::sendWithoutCorners(FieldGroup& g) {
+  /// Start timer
+  Timer timer("comms");
+
+  if (persistent_comms) {
+    if (CommHandle* ch = sendPlan(g, true, true, false)) {
+      return static_cast<void*>(ch);
+    }
+  }
+
   /// Work out length of buffer needed
   int xlen = msg_len(g.get(), 0, MXG, 0, MYSUB);
   int ylen = msg_len(g.get(), 0, LocalNx, 0, MYG);
@@ -1151,6 +1490,8 @@ comm_handle BoutMesh::send(FieldGroup& g) {
   sendX(g, ch, true);
   sendY(g, ch);
 
+  startZComms(*ch, true, true, false);
+
   return static_cast<void*>(ch);
 }
 
@@ -1160,6 +1501,12 @@ comm_handle BoutMesh::sendX(FieldGroup& g, comm_handle handle, bool disable_corn
 
   const bool with_corners = include_corner_cells and not disable_corners;
 
+  if (persistent_comms and handle == nullptr) {
+    if (CommHandle* ch = sendPlan(g, true, false, with_corners)) {
+      return static_cast<void*>(ch);
+    }
+  }
+
   CommHandle* ch = nullptr;
   if (handle == nullptr) {
     /// Work out length of buffer needed
@@ -1209,6 +1556,71 @@ comm_handle BoutMesh::sendX(FieldGroup& g, comm_handle handle, bool disable_corn
     }
   }
 
+  if (handle == nullptr) {
+    startZComms(*ch, true, false, with_corners);
+  }
+
+  /// Mark communication handle as in progress
+  ch->in_progress = true;
+
+  return static_cast<void*>(ch);
+}
+
+comm_handle BoutMesh::sendXCorners(FieldGroup& g) {
+  if ((IDATA_DEST == -1 and ODATA_DEST == -1) or MYG == 0) {
+    // No x-neighbours, or no corners
+    return nullptr;
+  }
+
+  if (persistent_comms or NZPE > 1) {
+    // The persistent plans and the z-communication of the corners
+    // only handle whole columns, so resend all the x-guard cells
+    return sendX(g);
+  }
+
+  /// Start timer
+  Timer timer("comms");
+
+  // Only the MYG rows at each end of the columns are sent
+  CommHandle* ch = get_handle(msg_len(g.get(), 0, MXG, 0, 2 * MYG), 0);
+  ch->var_list = g;
+  ch->x_corners_only = true;
+
+  /// Post receives
+  post_receiveX(*ch);
+
+  /// Send to the left (x-1)
+
+  if (IDATA_DEST != -1) {
+    int len = pack_data(ch->var_list.get(), MXG, 2 * MXG, 0, MYG,
+                        std::begin(ch->imsg_sendbuff));
+    len += pack_data(ch->var_list.get(), MXG, 2 * MXG, MYSUB + MYG, LocalNy,
+                     &ch->imsg_sendbuff[len]);
+    if (async_send) {
+      mpi->MPI_Isend(std::begin(ch->imsg_sendbuff), len, PVEC_REAL_MPI_TYPE, IDATA_DEST,
+                     IN_SENT_OUT, BoutComm::get(), &(ch->sendreq[4]));
+    } else {
+      mpi->MPI_Send(std::begin(ch->imsg_sendbuff), len, PVEC_REAL_MPI_TYPE, IDATA_DEST,
+                    IN_SENT_OUT, BoutComm::get());
+    }
+  }
+
+  /// Send to the right (x+1)
+
+  if (ODATA_DEST != -1) {
+    int len = pack_data(ch->var_list.get(), MXSUB, MXSUB + MXG, 0, MYG,
+                        std::begin(ch->omsg_sendbuff));
+    len += pack_data(ch->var_list.get(), MXSUB, MXSUB + MXG, MYSUB + MYG, LocalNy,
+                     &ch->omsg_sendbuff[len]);
+    if (async_send) {
+      mpi->MPI_Isend(std::begin(ch->omsg_sendbuff), len, PVEC_REAL_MPI_TYPE, ODATA_DEST,
+                     OUT_SENT_IN, BoutComm::get(), &(ch->sendreq[5]));
+    } else {
+      mpi->MPI_Send(std::begin(ch->omsg_sendbuff), len, PVEC_REAL_MPI_TYPE, ODATA_DEST,
+                    OUT_SENT_IN, BoutComm::get());
+    }
+  }
+
   /// Mark communication handle as in progress
   ch->in_progress = true;
 
@@ -1219,6 +1631,12 @@ comm_handle BoutMesh::sendY(FieldGroup& g, comm_handle handle) {
   /// Start timer
   Timer timer("comms");
 
+  if (persistent_comms and handle == nullptr) {
+    if (CommHandle* ch = sendPlan(g, false, true, false)) {
+      return static_cast<void*>(ch);
+    }
+  }
+
   CommHandle* ch;
   if (handle == nullptr) {
     /// Work out length of buffer needed
@@ -1303,6 +1721,10 @@ comm_handle BoutMesh::sendY(FieldGroup& g, comm_handle handle) {
     }
   }
 
+  if (handle == nullptr) {
+    startZComms(*ch, false, true, false);
+  }
+
   /// Mark communication handle as in progress
   ch->in_progress = true;
 
@@ -1342,74 +1764,96 @@ int BoutMesh::wait(comm_handle handle) {
     return 0;
   }
 
-  do {
-    mpi->MPI_Waitany(6, ch->request, &ind, &status);
-    switch (ind) {
-    case 0: { // Up, inner
-      unpack_data(ch->var_list.get(), 0, UDATA_XSPLIT, MYSUB + MYG, MYSUB + 2 * MYG,
-                  std::begin(ch->umsg_recvbuff));
-      break;
-    }
-    case 1: { // Up, outer
-      len = msg_len(ch->var_list.get(), 0, UDATA_XSPLIT, 0, MYG);
-      unpack_data(ch->var_list.get(), UDATA_XSPLIT, LocalNx, MYSUB + MYG, MYSUB + 2 * MYG,
-                  &(ch->umsg_recvbuff[len]));
-      break;
-    }
-    case 2: { // Down, inner
-      unpack_data(ch->var_list.get(), 0, DDATA_XSPLIT, 0, MYG,
-                  std::begin(ch->dmsg_recvbuff));
-      break;
-    }
-    case 3: { // Down, outer
-      len = msg_len(ch->var_list.get(), 0, DDATA_XSPLIT, 0, MYG);
-      unpack_data(ch->var_list.get(), DDATA_XSPLIT, LocalNx, 0, MYG,
-                  &(ch->dmsg_recvbuff[len]));
-      break;
-    }
-    case 4: { // inner
-      unpack_data(ch->var_list.get(), 0, MXG, ch->include_x_corners ? 0 : MYG,
-                  ch->include_x_corners ? LocalNy : MYG + MYSUB,
-                  std::begin(ch->imsg_recvbuff));
-      break;
-    }
-    case 5: { // outer
-      unpack_data(ch->var_list.get(), MXSUB + MXG, MXSUB + 2 * MXG,
-                  ch->include_x_corners ? 0 : MYG,
-                  ch->include_x_corners ? LocalNy : MYG + MYSUB,
-                  std::begin(ch->omsg_recvbuff));
-      break;
-    }
-    }
-    if (ind != MPI_UNDEFINED) {
-      ch->request[ind] = MPI_REQUEST_NULL;
-    }
-  } while (ind != MPI_UNDEFINED);
+  if (ch->plan != nullptr) {
+    waitCommPlan(*ch->plan);
+  } else {
+    do {
+      mpi->MPI_Waitany(6, ch->request, &ind, &status);
+      switch (ind) {
+      case 0: { // Up, inner
+        unpack_data(ch->var_list.get(), 0, UDATA_XSPLIT, MYSUB + MYG, MYSUB + 2 * MYG,
+                    std::begin(ch->umsg_recvbuff));
+        break;
+      }
+      case 1: { // Up, outer
+        len = msg_len(ch->var_list.get(), 0, UDATA_XSPLIT, 0, MYG);
+        unpack_data(ch->var_list.get(), UDATA_XSPLIT, LocalNx, MYSUB + MYG, MYSUB + 2 * MYG,
+                    &(ch->umsg_recvbuff[len]));
+        break;
+      }
+      case 2: { // Down, inner
+        unpack_data(ch->var_list.get(), 0, DDATA_XSPLIT, 0, MYG,
+                    std::begin(ch->dmsg_recvbuff));
+        break;
+      }
+      case 3: { // Down, outer
+        len = msg_len(ch->var_list.get(), 0, DDATA_XSPLIT, 0, MYG);
+        unpack_data(ch->var_list.get(), DDATA_XSPLIT, LocalNx, 0, MYG,
+                    &(ch->dmsg_recvbuff[len]));
+        break;
+      }
+      case 4: { // inner
+        if (ch->x_corners_only) {
+          len = unpack_data(ch->var_list.get(), 0, MXG, 0, MYG,
+                            std::begin(ch->imsg_recvbuff));
+          unpack_data(ch->var_list.get(), 0, MXG, MYSUB + MYG, LocalNy,
+                      &(ch->imsg_recvbuff[len]));
+          break;
+        }
+        unpack_data(ch->var_list.get(), 0, MXG, ch->include_x_corners ? 0 : MYG,
+                    ch->include_x_corners ? LocalNy : MYG + MYSUB,
+                    std::begin(ch->imsg_recvbuff));
+        break;
+      }
+      case 5: { // outer
+        if (ch->x_corners_only) {
+          len = unpack_data(ch->var_list.get(), MXSUB + MXG, MXSUB + 2 * MXG, 0, MYG,
+                            std::begin(ch->omsg_recvbuff));
+          unpack_data(ch->var_list.get(), MXSUB + MXG, MXSUB + 2 * MXG, MYSUB + MYG,
+                      LocalNy, &(ch->omsg_recvbuff[len]));
+          break;
+        }
+        unpack_data(ch->var_list.get(), MXSUB + MXG, MXSUB + 2 * MXG,
+                    ch->include_x_corners ? 0 : MYG,
+                    ch->include_x_corners ? LocalNy : MYG + MYSUB,
+                    std::begin(ch->omsg_recvbuff));
+        break;
+      }
+      }
+      if (ind != MPI_UNDEFINED) {
+        ch->request[ind] = MPI_REQUEST_NULL;
+      }
+    } while (ind != MPI_UNDEFINED);
 
-  if (async_send) {
-    /// Asyncronous sending: Need to check if sends have completed (frees MPI memory)
-    MPI_Status async_status;
+    if (async_send) {
+      /// Asyncronous sending: Need to check if sends have completed (frees MPI memory)
+      MPI_Status async_status;
 
-    if (UDATA_INDEST != -1) {
-      mpi->MPI_Wait(ch->sendreq, &async_status);
-    }
-    if (UDATA_OUTDEST != -1) {
-      mpi->MPI_Wait(ch->sendreq + 1, &async_status);
-    }
-    if (DDATA_INDEST != -1) {
-      mpi->MPI_Wait(ch->sendreq + 2, &async_status);
-    }
-    if (DDATA_OUTDEST != -1) {
-      mpi->MPI_Wait(ch->sendreq + 3, &async_status);
-    }
-    if (IDATA_DEST != -1) {
-      mpi->MPI_Wait(ch->sendreq + 4, &async_status);
-    }
-    if (ODATA_DEST != -1) {
-      mpi->MPI_Wait(ch->sendreq + 5, &async_status);
+      if (UDATA_INDEST != -1) {
+        mpi->MPI_Wait(ch->sendreq, &async_status);
+      }
+      if (UDATA_OUTDEST != -1) {
+        mpi->MPI_Wait(ch->sendreq + 1, &async_status);
+      }
+      if (DDATA_INDEST != -1) {
+        mpi->MPI_Wait(ch->sendreq + 2, &async_status);
+      }
+      if (DDATA_OUTDEST != -1) {
+        mpi->MPI_Wait(ch->sendreq + 3, &async_status);
+      }
+      if (IDATA_DEST != -1) {
+        mpi->MPI_Wait(ch->sendreq + 4, &async_status);
+      }
+      if (ODATA_DEST != -1) {
+        mpi->MPI_Wait(ch->sendreq + 5, &async_status);
+      }
     }
   }
 
+  // Z guard cells, including the corners with the X and Y guard
+  // cells which have just been received
+  waitZComms(*ch);
+
   if (ch->has_y_communication) {
     // TWIST-SHIFT CONDITION
     // Loop over 3D fields
@@ -1479,6 +1923,14 @@ int BoutMesh::getXProcIndex() { return PE_XIND; }
 
 int BoutMesh::getYProcIndex() { return PE_YIND; }
 
+int BoutMesh::getNZPE() { return NZPE; }
+
+int BoutMesh::getZProcIndex() { return PE_ZIND; }
+
+int BoutMesh::getXProcOffset(int xproc) const { return x_offsets.at(xproc); }
+
+int BoutMesh::getYProcOffset(int yproc) const { return y_offsets.at(yproc); }
+
 /****************************************************************
  *                 X COMMUNICATIONS
  *
@@ -1609,35 +2061,35 @@ int BoutMesh::PROC_NUM(int xind, int yind) const {
     return -1;
   }
 
-  return yind * NXPE + xind;
+  return (PE_ZIND * NYPE + yind) * NXPE + xind;
 }
 
 /// Returns the global X index given a local index
 int BoutMesh::XGLOBAL(BoutReal xloc, BoutReal& xglo) const {
-  xglo = xloc + PE_XIND * MXSUB;
+  xglo = xloc + OffsetX;
   return static_cast<int>(xglo);
 }
 
-int BoutMesh::getGlobalXIndex(int xlocal) const { return xlocal + PE_XIND * MXSUB; }
+int BoutMesh::getGlobalXIndex(int xlocal) const { return xlocal + OffsetX; }
 
 int BoutMesh::getGlobalXIndexNoBoundaries(int xlocal) const {
-  return xlocal + PE_XIND * MXSUB - MXG;
+  return xlocal + OffsetX - MXG;
 }
 
-int BoutMesh::getLocalXIndex(int xglobal) const { return xglobal - PE_XIND * MXSUB; }
+int BoutMesh::getLocalXIndex(int xglobal) const { return xglobal - OffsetX; }
 
 int BoutMesh::getLocalXIndexNoBoundaries(int xglobal) const {
-  return xglobal - PE_XIND * MXSUB + MXG;
+  return xglobal - OffsetX + MXG;
 }
 
 int BoutMesh::YGLOBAL(BoutReal yloc, BoutReal& yglo) const {
-  yglo = yloc + PE_YIND * MYSUB - MYG;
+  yglo = yloc + OffsetY - MYG;
   return static_cast<int>(yglo);
 }
 
 int BoutMesh::getGlobalYIndex(int ylocal) const {
-  int yglobal = ylocal + PE_YIND * MYSUB;
-  if (jyseps1_2 > jyseps2_1 and PE_YIND * MYSUB + 2 * MYG + 1 > ny_inner) {
+  int yglobal = ylocal + OffsetY;
+  if (jyseps1_2 > jyseps2_1 and OffsetY + 2 * MYG + 1 > ny_inner) {
     // Double null, and we are past the upper target
     yglobal += 2 * MYG;
   }
@@ -1645,12 +2097,12 @@ int BoutMesh::getGlobalYIndex(int ylocal) const {
 }
 
 int BoutMesh::getGlobalYIndexNoBoundaries(int ylocal) const {
-  return ylocal + PE_YIND * MYSUB - MYG;
+  return ylocal + OffsetY - MYG;
 }
 
 int BoutMesh::getLocalYIndex(int yglobal) const {
-  int ylocal = yglobal - PE_YIND * MYSUB;
-  if (jyseps1_2 > jyseps2_1 and PE_YIND * MYSUB + 2 * MYG + 1 > ny_inner) {
+  int ylocal = yglobal - OffsetY;
+  if (jyseps1_2 > jyseps2_1 and OffsetY + 2 * MYG + 1 > ny_inner) {
     // Double null, and we are past the upper target
     ylocal -= 2 * MYG;
   }
@@ -1658,29 +2110,44 @@ int BoutMesh::getLocalYIndex(int yglobal) const {
 }
 
 int BoutMesh::getLocalYIndexNoBoundaries(int yglobal) const {
-  return yglobal - PE_YIND * MYSUB + MYG;
+  return yglobal - OffsetY + MYG;
 }
 
-int BoutMesh::YGLOBAL(int yloc, int yproc) const { return yloc + yproc * MYSUB - MYG; }
+int BoutMesh::YGLOBAL(int yloc, int yproc) const { return yloc + y_offsets[yproc] - MYG; }
 
-int BoutMesh::YLOCAL(int yglo, int yproc) const { return yglo - yproc * MYSUB + MYG; }
+int BoutMesh::YLOCAL(int yglo, int yproc) const { return yglo - y_offsets[yproc] + MYG; }
 
-int BoutMesh::getGlobalZIndex(int zlocal) const { return zlocal; }
+// There are no boundary cells in Z, so the global indices are the
+// same with or without boundaries
 
-int BoutMesh::getGlobalZIndexNoBoundaries(int zlocal) const { return zlocal; }
+int BoutMesh::getGlobalZIndex(int zlocal) const { return zlocal - MZG + OffsetZ; }
 
-int BoutMesh::getLocalZIndex(int zglobal) const { return zglobal; }
+int BoutMesh::getGlobalZIndexNoBoundaries(int zlocal) const {
+  return zlocal - MZG + OffsetZ;
+}
 
-int BoutMesh::getLocalZIndexNoBoundaries(int zglobal) const { return zglobal; }
+int BoutMesh::getLocalZIndex(int zglobal) const { return zglobal - OffsetZ + MZG; }
+
+int BoutMesh::getLocalZIndexNoBoundaries(int zglobal) const {
+  return zglobal - OffsetZ + MZG;
+}
 
 int BoutMesh::YPROC(int yind) const {
   if ((yind < 0) || (yind >= ny)) {
     return -1;
   }
-  return yind / MYSUB;
+  // Last processor starting at or before yind
+  const auto next = std::upper_bound(y_offsets.begin(), y_offsets.end(), yind);
+  return static_cast<int>(std::distance(y_offsets.begin(), next)) - 1;
 }
 
-int BoutMesh::XPROC(int xind) const { return (xind >= MXG) ? (xind - MXG) / MXSUB : 0; }
+int BoutMesh::XPROC(int xind) const {
+  if (xind < MXG) {
+    return 0;
+  }
+  const auto next = std::upper_bound(x_offsets.begin(), x_offsets.end(), xind - MXG);
+  return static_cast<int>(std::distance(x_offsets.begin(), next)) - 1;
+}
 
 /****************************************************************
  *                     TESTING UTILITIES
@@ -1807,13 +2274,17 @@ void BoutMesh::set_connection(int ypos1, int ypos2, int xge, int xlt, bool ts) {
   const int yind1 = YLOCAL(ypos1, ype1);
   const int yind2 = YLOCAL(ypos2, ype2);
 
+  /* y index of the last point on each processor */
+  const int yend1 = YLOCAL(y_offsets[ype1 + 1] - 1, ype1);
+  const int yend2 = YLOCAL(y_offsets[ype2 + 1] - 1, ype2);
+
   /* Check which boundary the connection is on */
   int ypeup = 0;
   int ypedown = 0;
-  if ((yind1 == MYG) && (yind2 == MYSUB + MYG - 1)) {
+  if ((yind1 == MYG) && (yind2 == yend2)) {
     ypeup = ype2;   /* processor sending data up (+ve y) */
     ypedown = ype1; /* processor sending data down (-ve y) */
-  } else if ((yind2 == MYG) && (yind1 == MYSUB + MYG - 1)) {
+  } else if ((yind2 == MYG) && (yind1 == yend1)) {
     ypeup = ype1;
     ypedown = ype2;
   } else {
@@ -1992,24 +2463,31 @@ void BoutMesh::add_target(int ypos, int xge, int xlt) {
 void BoutMesh::topology() {
   // Perform checks common to all topologies
 
-  if (NPES != NXPE * NYPE) {
-    throw BoutException("\tTopology error: npes={:d} is not equal to NXPE*NYPE={:d}\n",
-                        NPES, NXPE * NYPE);
+  if (NPES != NXPE * NYPE * NZPE) {
+    throw BoutException(
+        "\tTopology error: npes={:d} is not equal to NXPE*NYPE*NZPE={:d}\n", NPES,
+        NXPE * NYPE * NZPE);
   }
-  if (MYSUB * NYPE != MY) {
-    throw BoutException("\tTopology error: MYSUB[{:d}] * NYPE[{:d}] != MY[{:d}]\n", MYSUB,
-                        NYPE, MY);
+  if (y_offsets.back() != MY) {
+    throw BoutException("\tTopology error: Y processors cover {:d} points, not MY[{:d}]\n",
+                        y_offsets.back(), MY);
   }
-  if (MXSUB * NXPE != MX) {
-    throw BoutException("\tTopology error: MXSUB[{:d}] * NXPE[{:d}] != MX[{:d}]\n", MXSUB,
-                        NXPE, MX);
+  if (x_offsets.back() != MX) {
+    throw BoutException("\tTopology error: X processors cover {:d} points, not MX[{:d}]\n",
+                        x_offsets.back(), MX);
   }
 
-  if ((NXPE > 1) && (MXSUB < MXG)) {
-    throw BoutException("\tERROR: Grid X size must be >= guard cell size\n");
+  // All processors must be at least as large as the guard cells, as
+  // neighbours' guard cells are filled from them
+  for (int i = 0; i < NXPE; i++) {
+    if ((NXPE > 1) && (x_offsets[i + 1] - x_offsets[i] < MXG)) {
+      throw BoutException("\tERROR: Grid X size must be >= guard cell size\n");
+    }
   }
-  if (MYSUB < MYG) {
-    throw BoutException("\tERROR: Grid Y size must be >= guard cell size\n");
+  for (int i = 0; i < NYPE; i++) {
+    if (y_offsets[i + 1] - y_offsets[i] < MYG) {
+      throw BoutException("\tERROR: Grid Y size must be >= guard cell size\n");
+    }
   }
 
   if (jyseps2_1 == jyseps1_2) {
@@ -2029,11 +2507,14 @@ void BoutMesh::topology() {
     /* UPPER LEGS: Do not have to be the same length as each
        other or lower legs, but do have to have an integer number
        of processors */
-    if ((ny_inner - jyseps2_1 - 1) % MYSUB != 0) {
+    const auto onProcessorBoundary = [this](int y) {
+      return std::binary_search(y_offsets.begin(), y_offsets.end(), y);
+    };
+    if (not(onProcessorBoundary(jyseps2_1 + 1) and onProcessorBoundary(ny_inner))) {
       throw BoutException("\tTopology error: Upper inner leg does not have integer "
                           "number of processors\n");
     }
-    if ((jyseps1_2 - ny_inner + 1) % MYSUB != 0) {
+    if (not(onProcessorBoundary(ny_inner) and onProcessorBoundary(jyseps1_2 + 1))) {
       throw BoutException("\tTopology error: Upper outer leg does not have integer "
                           "number of processors\n");
     }
@@ -2074,8 +2555,8 @@ void BoutMesh::topology() {
   }
 
   if ((ixseps_inner > 0)
-      && (((PE_YIND * MYSUB > jyseps1_1) && (PE_YIND * MYSUB <= jyseps2_1))
-          || ((PE_YIND * MYSUB > jyseps1_2) && (PE_YIND * MYSUB <= jyseps2_2)))) {
+      && (((OffsetY > jyseps1_1) && (OffsetY <= jyseps2_1))
+          || ((OffsetY > jyseps1_2) && (OffsetY <= jyseps2_2)))) {
     MYPE_IN_CORE = true; /* processor is in the core */
   }
 
@@ -2122,6 +2603,9 @@ BoutMesh::CommHandle* BoutMesh::get_handle(int xlen, int ylen) {
     for (auto& i : ch->request) {
       i = MPI_REQUEST_NULL;
     }
+    for (auto& i : ch->sendreq) {
+      i = MPI_REQUEST_NULL;
+    }
 
     if (ylen > 0) {
       ch->umsg_sendbuff.reallocate(ylen);
@@ -2169,6 +2653,7 @@ BoutMesh::CommHandle* BoutMesh::get_handle(int xlen, int ylen) {
 
   ch->in_progress = false;
   ch->include_x_corners = false;
+  ch->x_corners_only = false;
   ch->has_y_communication = false;
 
   ch->var_list.clear();
@@ -2178,6 +2663,9 @@ BoutMesh::CommHandle* BoutMesh::get_handle(int xlen, int ylen) {
 
 void BoutMesh::free_handle(CommHandle* h) {
   h->var_list.clear();
+  h->plan = nullptr;
+  h->z_plan = nullptr;
+  h->own_z_plan.reset();
   comm_list.push_front(h);
 }
 
@@ -2191,6 +2679,385 @@ void BoutMesh::clear_handles() {
   }
 }
 
+/****************************************************************
+ *                Persistent communication plans
+ ****************************************************************/
+
+BoutMesh::CommHandle* BoutMesh::sendPlan(FieldGroup& g, bool x_comms, bool y_comms,
+                                         bool include_x_corners) {
+  if (g.empty()) {
+    return nullptr;
+  }
+
+  CommPlan* plan = getCommPlan(g, x_comms, y_comms, include_x_corners);
+  if (plan == nullptr) {
+    // Same group is already being communicated, so fall back to a
+    // one-off communication
+    return nullptr;
+  }
+
+  CommHandle* ch = get_handle(0, 0);
+  ch->var_list = g;
+  ch->plan = plan;
+  ch->include_x_corners = include_x_corners;
+  ch->has_y_communication = y_comms;
+
+  startCommPlan(*plan);
+  startZComms(*ch, x_comms, y_comms, include_x_corners);
+
+  ch->in_progress = true;
+  return ch;
+}
+
+void BoutMesh::startZComms(CommHandle& ch, bool x_comms, bool y_comms,
+                           bool include_x_corners) {
+  if ((NZPE == 1) or ch.var_list.field3d().empty()) {
+    return;
+  }
+
+  ch.z_plan = getCommPlan(ch.var_list, x_comms, y_comms, include_x_corners, true);
+  if (ch.z_plan == nullptr) {
+    // Same group is already being communicated, so use a one-off plan
+    ch.own_z_plan = createZCommPlan(ch.var_list, x_comms, y_comms, include_x_corners);
+    ch.z_plan = ch.own_z_plan.get();
+  }
+
+  startCommPlan(*ch.z_plan);
+}
+
+void BoutMesh::waitZComms(CommHandle& ch) {
+  if (ch.z_plan == nullptr) {
+    return;
+  }
+
+  startCommPlan(*ch.z_plan->z_received);
+  waitCommPlan(*ch.z_plan);
+  waitCommPlan(*ch.z_plan->z_received);
+}
+
+BoutMesh::CommPlan* BoutMesh::getCommPlan(const FieldGroup& g, bool x_comms,
+                                          bool y_comms, bool include_x_corners,
+                                          bool z_comms) {
+  const auto& fields = g.get();
+
+  auto matches = [&](const CommPlan& plan) {
+    if (plan.x_comms != x_comms or plan.y_comms != y_comms
+        or plan.include_x_corners != include_x_corners or plan.z_comms != z_comms
+        or plan.fields != fields) {
+      return false;
+    }
+    for (std::size_t i = 0; i < fields.size(); ++i) {
+      if (plan.fields_3d[i] != fields[i]->is3D()) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  auto it = std::find_if(comm_plans.begin(), comm_plans.end(),
+                         [&](const auto& plan) { return matches(*plan); });
+
+  if (it != comm_plans.end()) {
+    if ((*it)->in_progress) {
+      return nullptr;
+    }
+    // Move to the front, so that the least recently used plans are at the back
+    comm_plans.splice(comm_plans.begin(), comm_plans, it);
+    return comm_plans.front().get();
+  }
+
+  comm_plans.push_front(z_comms
+                            ? createZCommPlan(g, x_comms, y_comms, include_x_corners)
+                            : createCommPlan(g, x_comms, y_comms, include_x_corners));
+
+  if (comm_plans.size() > max_comm_plans and not comm_plans.back()->in_progress) {
+    comm_plans.pop_back();
+  }
+
+  return comm_plans.front().get();
+}
+
+std::unique_ptr<BoutMesh::CommPlan> BoutMesh::createCommPlan(const FieldGroup& g,
+                                                             bool x_comms, bool y_comms,
+                                                             bool include_x_corners) {
+  TRACE("BoutMesh::createCommPlan");
+
+  auto plan = std::make_unique<CommPlan>(mpi);
+
+  plan->fields = g.get();
+  for (const auto& var : plan->fields) {
+    plan->fields_3d.push_back(var->is3D());
+  }
+  plan->field_data.resize(plan->fields.size());
+  plan->x_comms = x_comms;
+  plan->y_comms = y_comms;
+  plan->include_x_corners = include_x_corners;
+
+  // List the contiguous blocks of data in the region xge <= x < xlt, yge <= y < ylt,
+  // in the same order as pack_data/unpack_data
+  auto segments = [&](int xge, int xlt, int yge, int ylt) {
+    std::vector<CommPlan::Segment> result;
+    for (std::size_t i = 0; i < plan->fields.size(); ++i) {
+      const int nz = plan->fields_3d[i] ? LocalNz : 1;
+      for (int jx = xge; jx < xlt; jx++) {
+        const int offset = (jx * LocalNy + yge) * nz;
+        const int length = (ylt - yge) * nz;
+        if (length <= 0) {
+          continue;
+        }
+        if (not result.empty() and result.back().field == static_cast<int>(i)
+            and result.back().offset + result.back().length == offset) {
+          // Merge with the previous block
+          result.back().length += length;
+        } else {
+          result.push_back({static_cast<int>(i), offset, length});
+        }
+      }
+    }
+    return result;
+  };
+
+  // Add a matching pair of messages to and from processor \p proc,
+  // with send tag \p send_tag and receive tag \p recv_tag
+  auto add_messages = [&](int proc, int send_tag, int recv_tag,
+                          std::vector<CommPlan::Segment> send_segments,
+                          std::vector<CommPlan::Segment> recv_segments) {
+    plan->addMessages(proc, send_tag, recv_tag, BoutComm::get(),
+                      std::move(send_segments), std::move(recv_segments));
+  };
+
+  if (y_comms) {
+    // Up, inner and outer
+    add_messages(UDATA_INDEST, IN_SENT_UP, IN_SENT_DOWN,
+                 segments(0, UDATA_XSPLIT, MYSUB, MYSUB + MYG),
+                 segments(0, UDATA_XSPLIT, MYSUB + MYG, MYSUB + 2 * MYG));
+    add_messages(UDATA_OUTDEST, OUT_SENT_UP, OUT_SENT_DOWN,
+                 segments(UDATA_XSPLIT, LocalNx, MYSUB, MYSUB + MYG),
+                 segments(UDATA_XSPLIT, LocalNx, MYSUB + MYG, MYSUB + 2 * MYG));
+    // Down, inner and outer
+    add_messages(DDATA_INDEST, IN_SENT_DOWN, IN_SENT_UP,
+                 segments(0, DDATA_XSPLIT, MYG, 2 * MYG), segments(0, DDATA_XSPLIT, 0, MYG));
+    add_messages(DDATA_OUTDEST, OUT_SENT_DOWN, OUT_SENT_UP,
+                 segments(DDATA_XSPLIT, LocalNx, MYG, 2 * MYG),
+                 segments(DDATA_XSPLIT, LocalNx, 0, MYG));
+  }
+
+  if (x_comms) {
+    const int yge = include_x_corners ? 0 : MYG;
+    const int ylt = include_x_corners ? LocalNy : MYG + MYSUB;
+    // Inner and outer
+    add_messages(IDATA_DEST, IN_SENT_OUT, OUT_SENT_IN, segments(MXG, 2 * MXG, yge, ylt),
+                 segments(0, MXG, yge, ylt));
+    add_messages(ODATA_DEST, OUT_SENT_IN, IN_SENT_OUT,
+                 segments(MXSUB, MXSUB + MXG, yge, ylt),
+                 segments(MXSUB + MXG, MXSUB + 2 * MXG, yge, ylt));
+  }
+
+  return plan;
+}
+
+std::unique_ptr<BoutMesh::CommPlan> BoutMesh::createZCommPlan(const FieldGroup& g,
+                                                              bool x_comms,
+                                                              bool y_comms,
+                                                              bool include_x_corners) {
+  TRACE("BoutMesh::createZCommPlan");
+
+  // Mark the (x, y) columns which are received from X or Y
+  // neighbours. The processors in Z have the same X and Y neighbours,
+  // so the columns in each phase match on both sides
+  std::vector<bool> received(LocalNx * LocalNy, false);
+  auto mark = [&](int proc, int xge, int xlt, int yge, int ylt) {
+    if (proc == -1) {
+      return;
+    }
+    for (int jx = xge; jx < xlt; jx++) {
+      for (int jy = yge; jy < ylt; jy++) {
+        received[jx * LocalNy + jy] = true;
+      }
+    }
+  };
+  if (y_comms) {
+    mark(UDATA_INDEST, 0, UDATA_XSPLIT, MYSUB + MYG, LocalNy);
+    mark(UDATA_OUTDEST, UDATA_XSPLIT, LocalNx, MYSUB + MYG, LocalNy);
+    mark(DDATA_INDEST, 0, DDATA_XSPLIT, 0, MYG);
+    mark(DDATA_OUTDEST, DDATA_XSPLIT, LocalNx, 0, MYG);
+  }
+  if (x_comms) {
+    const int yge = include_x_corners ? 0 : MYG;
+    const int ylt = include_x_corners ? LocalNy : MYG + MYSUB;
+    mark(IDATA_DEST, 0, MXG, yge, ylt);
+    mark(ODATA_DEST, MXSUB + MXG, LocalNx, yge, ylt);
+  }
+
+  // Z is periodic, so the first and last processors are neighbours.
+  // Ranks in comm_z are the Z processor indices
+  const int zdown = (PE_ZIND + NZPE - 1) % NZPE;
+  const int zup = (PE_ZIND + 1) % NZPE;
+
+  // Plan for the columns which are received (or not), sending MZG
+  // points from each end of the column into the guard cells of the
+  // neighbours
+  auto phase = [&](bool columns_received, int tag_up, int tag_down) {
+    auto plan = std::make_unique<CommPlan>(mpi);
+
+    plan->fields = g.get();
+    for (const auto& var : plan->fields) {
+      plan->fields_3d.push_back(var->is3D());
+    }
+    plan->field_data.resize(plan->fields.size());
+    plan->x_comms = x_comms;
+    plan->y_comms = y_comms;
+    plan->include_x_corners = include_x_corners;
+    plan->z_comms = true;
+
+    std::vector<CommPlan::Segment> send_down, send_up, recv_down, recv_up;
+    for (std::size_t i = 0; i < plan->fields.size(); ++i) {
+      if (not plan->fields_3d[i]) {
+        continue;
+      }
+      const int field = static_cast<int>(i);
+      for (int jx = 0; jx < LocalNx; jx++) {
+        for (int jy = 0; jy < LocalNy; jy++) {
+          if (received[jx * LocalNy + jy] != columns_received) {
+            continue;
+          }
+          const int column = (jx * LocalNy + jy) * LocalNz;
+          send_down.push_back({field, column + zstart, MZG});
+          send_up.push_back({field, column + zend - MZG + 1, MZG});
+          recv_down.push_back({field, column, MZG});
+          recv_up.push_back({field, column + zend + 1, MZG});
+        }
+      }
+    }
+
+    if (not send_down.empty()) {
+      plan->addMessages(zdown, tag_down, tag_up, comm_z, std::move(send_down),
+                        std::move(recv_down));
+      plan->addMessages(zup, tag_up, tag_down, comm_z, std::move(send_up),
+                        std::move(recv_up));
+    }
+    return plan;
+  };
+
+  auto plan = phase(false, Z_SENT_UP, Z_SENT_DOWN);
+  plan->z_received = phase(true, Z_CORNERS_SENT_UP, Z_CORNERS_SENT_DOWN);
+  return plan;
+}
+
+void BoutMesh::CommPlan::addMessages(int proc, int send_tag, int recv_tag,
+                                     MPI_Comm comm, std::vector<Segment> send_segments,
+                                     std::vector<Segment> recv_segments) {
+  if (proc == -1) {
+    return;
+  }
+
+  auto total_length = [](const std::vector<Segment>& segs) {
+    int len = 0;
+    for (const auto& seg : segs) {
+      len += seg.length;
+    }
+    return len;
+  };
+  const int send_len = total_length(send_segments);
+  const int recv_len = total_length(recv_segments);
+
+  sends.push_back({Array<BoutReal>(send_len), std::move(send_segments)});
+  send_requests.push_back(MPI_REQUEST_NULL);
+  mpi->MPI_Send_init(std::begin(sends.back().buffer), send_len, PVEC_REAL_MPI_TYPE, proc,
+                     send_tag, comm, &send_requests.back());
+
+  receives.push_back({Array<BoutReal>(recv_len), std::move(recv_segments)});
+  recv_requests.push_back(MPI_REQUEST_NULL);
+  mpi->MPI_Recv_init(std::begin(receives.back().buffer), recv_len, PVEC_REAL_MPI_TYPE,
+                     proc, recv_tag, comm, &recv_requests.back());
+}
+
+void BoutMesh::startCommPlan(CommPlan& plan) {
+  // The data in each field may have been reallocated since the last use
+  for (std::size_t i = 0; i < plan.fields.size(); ++i) {
+    if (plan.fields_3d[i]) {
+      auto& var3d_ref = *dynamic_cast<Field3D*>(plan.fields[i]);
+      ASSERT2(var3d_ref.isAllocated());
+      plan.field_data[i] = &var3d_ref(0, 0, 0);
+    } else {
+      auto& var2d_ref = *dynamic_cast<Field2D*>(plan.fields[i]);
+      ASSERT2(var2d_ref.isAllocated());
+      plan.field_data[i] = &var2d_ref(0, 0);
+    }
+  }
+
+  // Post receives before sending
+  if (not plan.recv_requests.empty()) {
+    mpi->MPI_Startall(static_cast<int>(plan.recv_requests.size()),
+                      plan.recv_requests.data());
+  }
+
+  for (auto& message : plan.sends) {
+    BoutReal* buffer = std::begin(message.buffer);
+    for (const auto& seg : message.segments) {
+      std::copy_n(plan.field_data[seg.field] + seg.offset, seg.length, buffer);
+      buffer += seg.length;
+    }
+  }
+  if (bout::Profiler::enabled()) {
+    std::uint64_t bytes = 0;
+    for (const auto& message : plan.sends) {
+      bytes += message.buffer.size() * sizeof(BoutReal);
+    }
+    bout::Profiler::addBytes(bytes);
+  }
+
+  if (not plan.send_requests.empty()) {
+    mpi->MPI_Startall(static_cast<int>(plan.send_requests.size()),
+                      plan.send_requests.data());
+  }
+
+  plan.in_progress = true;
+}
+
+void BoutMesh::waitCommPlan(CommPlan& plan) {
+  int ind;
+  MPI_Status status;
+
+  // Completed persistent requests become inactive rather than null,
+  // and MPI_Waitany returns MPI_UNDEFINED once none are active
+  do {
+    mpi->MPI_Waitany(static_cast<int>(plan.recv_requests.size()),
+                     plan.recv_requests.data(), &ind, &status);
+    if (ind != MPI_UNDEFINED) {
+      const auto& message = plan.receives[ind];
+      const BoutReal* buffer = std::begin(message.buffer);
+      for (const auto& seg : message.segments) {
+        std::copy_n(buffer, seg.length, plan.field_data[seg.field] + seg.offset);
+        buffer += seg.length;
+      }
+    }
+  } while (ind != MPI_UNDEFINED);
+
+  // Send buffers can't be reused until the sends have completed
+  if (not plan.send_requests.empty()) {
+    mpi->MPI_Waitall(static_cast<int>(plan.send_requests.size()),
+                     plan.send_requests.data(), MPI_STATUSES_IGNORE);
+  }
+
+  plan.in_progress = false;
+}
+
+BoutMesh::CommPlan::~CommPlan() {
+  for (auto& request : send_requests) {
+    if (request != MPI_REQUEST_NULL) {
+      mpi->MPI_Request_free(&request);
+    }
+  }
+  for (auto& request : recv_requests) {
+    if (request != MPI_REQUEST_NULL) {
+      mpi->MPI_Request_free(&request);
+    }
+  }
+}
+
+std::size_t BoutMesh::numCommPlans() const { return comm_plans.size(); }
+
 /// For debugging purposes (when creating fake parallel meshes), make
 /// the send and receive buffers share memory. This allows for
 /// communications to be faked between meshes as though they were on
@@ -2273,6 +3140,9 @@ int BoutMesh::pack_data(const std::vector<FieldData*>& var_list, int xge, int xl
     }
   }
 
+  // Bytes sent in the halo exchange
+  bout::Profiler::addBytes(static_cast<std::uint64_t>(len) * sizeof(BoutReal));
+
   return (len);
 }
 
@@ -2419,6 +3289,9 @@ MPI_Comm BoutMesh::getYcomm(int xpos) const {
 void BoutMesh::addBoundaryRegions() {
   std::list<std::string> all_boundaries; ///< Keep track of all boundary regions
 
+  // The 3D regions don't include the Z guard cells, which are copies
+  // of points on the neighbouring processors in Z
+
   // Lower Inner Y
   int xs = 0;
   int xe = LocalNx - 1;
@@ -2451,7 +3324,7 @@ void BoutMesh::addBoundaryRegions() {
     }
   }
 
-  addRegion3D("RGN_LOWER_INNER_Y", Region<Ind3D>(xs, xe, 0, ystart - 1, 0, LocalNz - 1,
+  addRegion3D("RGN_LOWER_INNER_Y", Region<Ind3D>(xs, xe, 0, ystart - 1, zstart, zend,
                                                  LocalNy, LocalNz, maxregionblocksize));
   addRegion2D("RGN_LOWER_INNER_Y",
               Region<Ind2D>(xs, xe, 0, ystart - 1, 0, 0, LocalNy, 1, maxregionblocksize));
@@ -2490,7 +3363,7 @@ void BoutMesh::addBoundaryRegions() {
     xe = -2;
   }
 
-  addRegion3D("RGN_LOWER_OUTER_Y", Region<Ind3D>(xs, xe, 0, ystart - 1, 0, LocalNz - 1,
+  addRegion3D("RGN_LOWER_OUTER_Y", Region<Ind3D>(xs, xe, 0, ystart - 1, zstart, zend,
                                                  LocalNy, LocalNz, maxregionblocksize));
   addRegion2D("RGN_LOWER_OUTER_Y",
               Region<Ind2D>(xs, xe, 0, ystart - 1, 0, 0, LocalNy, 1, maxregionblocksize));
@@ -2523,7 +3396,7 @@ void BoutMesh::addBoundaryRegions() {
     xe = LocalNx - 1;
   }
 
-  addRegion3D("RGN_LOWER_Y", Region<Ind3D>(xs, xe, 0, ystart - 1, 0, LocalNz - 1, LocalNy,
+  addRegion3D("RGN_LOWER_Y", Region<Ind3D>(xs, xe, 0, ystart - 1, zstart, zend, LocalNy,
                                            LocalNz, maxregionblocksize));
   addRegion2D("RGN_LOWER_Y",
               Region<Ind2D>(xs, xe, 0, ystart - 1, 0, 0, LocalNy, 1, maxregionblocksize));
@@ -2563,7 +3436,7 @@ void BoutMesh::addBoundaryRegions() {
   }
 
   addRegion3D("RGN_UPPER_INNER_Y",
-              Region<Ind3D>(xs, xe, yend + 1, LocalNy - 1, 0, LocalNz - 1, LocalNy,
+              Region<Ind3D>(xs, xe, yend + 1, LocalNy - 1, zstart, zend, LocalNy,
                             LocalNz, maxregionblocksize));
   addRegion2D("RGN_UPPER_INNER_Y", Region<Ind2D>(xs, xe, yend + 1, LocalNy - 1, 0, 0,
                                                  LocalNy, 1, maxregionblocksize));
@@ -2603,7 +3476,7 @@ void BoutMesh::addBoundaryRegions() {
   }
 
   addRegion3D("RGN_UPPER_OUTER_Y",
-              Region<Ind3D>(xs, xe, yend + 1, LocalNy - 1, 0, LocalNz - 1, LocalNy,
+              Region<Ind3D>(xs, xe, yend + 1, LocalNy - 1, zstart, zend, LocalNy,
                             LocalNz, maxregionblocksize));
   addRegion2D("RGN_UPPER_OUTER_Y", Region<Ind2D>(xs, xe, yend + 1, LocalNy - 1, 0, 0,
                                                  LocalNy, 1, maxregionblocksize));
@@ -2636,7 +3509,7 @@ void BoutMesh::addBoundaryRegions() {
     xe = LocalNx - 1;
   }
 
-  addRegion3D("RGN_UPPER_Y", Region<Ind3D>(xs, xe, yend + 1, LocalNy - 1, 0, LocalNz - 1,
+  addRegion3D("RGN_UPPER_Y", Region<Ind3D>(xs, xe, yend + 1, LocalNy - 1, zstart, zend,
                                            LocalNy, LocalNz, maxregionblocksize));
   addRegion2D("RGN_UPPER_Y", Region<Ind2D>(xs, xe, yend + 1, LocalNy - 1, 0, 0, LocalNy,
                                            1, maxregionblocksize));
@@ -2645,18 +3518,18 @@ void BoutMesh::addBoundaryRegions() {
   // Inner X
   if (firstX() && !periodicX) {
     addRegion3D("RGN_INNER_X_THIN",
-                Region<Ind3D>(xstart - 1, xstart - 1, ystart, yend, 0, LocalNz - 1,
+                Region<Ind3D>(xstart - 1, xstart - 1, ystart, yend, zstart, zend,
                               LocalNy, LocalNz, maxregionblocksize));
     addRegion2D("RGN_INNER_X_THIN", Region<Ind2D>(xstart - 1, xstart - 1, ystart, yend, 0,
                                                   0, LocalNy, 1, maxregionblocksize));
     addRegionPerp("RGN_INNER_X_THIN",
-                  Region<IndPerp>(xstart - 1, xstart - 1, 0, 0, 0, LocalNz - 1, 1,
+                  Region<IndPerp>(xstart - 1, xstart - 1, 0, 0, zstart, zend, 1,
                                   LocalNz, maxregionblocksize));
-    addRegion3D("RGN_INNER_X", Region<Ind3D>(0, xstart - 1, ystart, yend, 0, LocalNz - 1,
+    addRegion3D("RGN_INNER_X", Region<Ind3D>(0, xstart - 1, ystart, yend, zstart, zend,
                                              LocalNy, LocalNz, maxregionblocksize));
     addRegion2D("RGN_INNER_X", Region<Ind2D>(0, xstart - 1, ystart, yend, 0, 0, LocalNy,
                                              1, maxregionblocksize));
-    addRegionPerp("RGN_INNER_X", Region<IndPerp>(0, xstart - 1, 0, 0, 0, LocalNz - 1, 1,
+    addRegionPerp("RGN_INNER_X", Region<IndPerp>(0, xstart - 1, 0, 0, zstart, zend, 1,
                                                  LocalNz, maxregionblocksize));
     all_boundaries.emplace_back("RGN_INNER_X");
 
@@ -2680,20 +3553,20 @@ void BoutMesh::addBoundaryRegions() {
   // Outer X
   if (lastX() && !periodicX) {
     addRegion3D("RGN_OUTER_X_THIN",
-                Region<Ind3D>(xend + 1, xend + 1, ystart, yend, 0, LocalNz - 1, LocalNy,
+                Region<Ind3D>(xend + 1, xend + 1, ystart, yend, zstart, zend, LocalNy,
                               LocalNz, maxregionblocksize));
     addRegion2D("RGN_OUTER_X_THIN", Region<Ind2D>(xend + 1, xend + 1, ystart, yend, 0, 0,
                                                   LocalNy, 1, maxregionblocksize));
     addRegionPerp("RGN_OUTER_X_THIN",
-                  Region<IndPerp>(xend + 1, xend + 1, 0, 0, 0, LocalNz - 1, 1, LocalNz,
+                  Region<IndPerp>(xend + 1, xend + 1, 0, 0, zstart, zend, 1, LocalNz,
                                   maxregionblocksize));
     addRegion3D("RGN_OUTER_X",
-                Region<Ind3D>(xend + 1, LocalNx - 1, ystart, yend, 0, LocalNz - 1,
+                Region<Ind3D>(xend + 1, LocalNx - 1, ystart, yend, zstart, zend,
                               LocalNy, LocalNz, maxregionblocksize));
     addRegion2D("RGN_OUTER_X", Region<Ind2D>(xend + 1, LocalNx - 1, ystart, yend, 0, 0,
                                              LocalNy, 1, maxregionblocksize));
     addRegionPerp("RGN_OUTER_X",
-                  Region<IndPerp>(xend + 1, LocalNx - 1, 0, 0, 0, LocalNz - 1, 1, LocalNz,
+                  Region<IndPerp>(xend + 1, LocalNx - 1, 0, 0, zstart, zend, 1, LocalNz,
                                   maxregionblocksize));
     all_boundaries.emplace_back("RGN_OUTER_X");
 
@@ -3131,6 +4004,10 @@ void BoutMesh::outputVars(Options& output_options) {
   output_options["MZSUB"].force(MZSUB, "BoutMesh");
   output_options["PE_XIND"].force(PE_XIND, "BoutMesh");
   output_options["PE_YIND"].force(PE_YIND, "BoutMesh");
+  // Needed to collect the output when processors have different
+  // numbers of points (load_balance = true)
+  output_options["OffsetX"].force(OffsetX, "BoutMesh");
+  output_options["OffsetY"].force(OffsetY, "BoutMesh");
   output_options["MYPE"].force(MYPE, "BoutMesh");
   output_options["MXG"].force(MXG, "BoutMesh");
   output_options["MYG"].force(MYG, "BoutMesh");
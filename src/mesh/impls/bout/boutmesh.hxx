@@ -9,6 +9,7 @@
 
 #include <cmath>
 #include <list>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -51,6 +52,14 @@ public:
   /// Send only in the y-direction
   comm_handle sendY(FieldGroup& g, comm_handle handle = nullptr) override;
 
+  /// Send in the x- and y-directions at once, leaving out the corner
+  /// cells. Same as send(), but allowed if include_corner_cells is set
+  comm_handle sendWithoutCorners(FieldGroup& g) override;
+
+  /// Send only the x-guard cells in the y-guard rows, after
+  /// sendWithoutCorners() has finished
+  comm_handle sendXCorners(FieldGroup& g) override;
+
   /// Wait for a send operation to complete
   /// @param[in] handle  The handle returned by send()
   int wait(comm_handle handle) override;
@@ -62,6 +71,10 @@ public:
   int getNYPE() override;       ///< The number of processors in the Y direction
   int getXProcIndex() override; ///< This processor's index in X direction
   int getYProcIndex() override; ///< This processor's index in Y direction
+  int getNZPE() override;       ///< The number of processors in the Z direction
+  int getZProcIndex() override; ///< This processor's index in Z direction
+  int getXProcOffset(int xproc) const override;
+  int getYProcOffset(int yproc) const override;
 
   /////////////////////////////////////////////
   // X communications
@@ -105,6 +118,8 @@ public:
   MPI_Comm getXcomm(int UNUSED(jy)) const override { return comm_x; }
   /// Return communicator containing all processors in Y
   MPI_Comm getYcomm(int xpos) const override;
+  /// Return communicator containing all processors in Z
+  MPI_Comm getZcomm() const override { return comm_z; }
 
   /// Is local X index \p jx periodic in Y?
   ///
@@ -252,6 +267,14 @@ protected:
   /// Find a value for NXPE
   void findProcessorSplit();
 
+  /// Choose the X and Y ranges of each processor so that the total
+  /// cost on each is as even as possible, using the 1D cost profiles
+  /// `cost_weight_x` (length nx) and `cost_weight_y` (length ny) from
+  /// the mesh source. Missing profiles are taken to be uniform.
+  ///
+  /// Requires NXPE and NYPE to be set first
+  void chooseWeightedDecomposition();
+
   struct XDecompositionIndices {
     int ixseps1;
     int ixseps2;
@@ -269,6 +292,9 @@ protected:
   /// - NXPE, NYPE, NZPE
   /// - PE_XIND, PE_YIND
   /// - jyseps1_2, jyseps2_1
+  ///
+  /// Uses `x_offsets` and `y_offsets` if they have been set for the
+  /// current NXPE and NYPE, otherwise splits X and Y equally
   void setDerivedGridSizes();
 
   /// Create the various sub-communicators
@@ -282,6 +308,11 @@ protected:
   /// Set the shift angle and enable twist shift. Should only be used for testing!
   void setShiftAngle(const std::vector<BoutReal>& shift_angle);
 
+  /// Split Z between \p nzpe processors with \p mzg guard cells, as Z
+  /// processor \p pe_zind, and set the derived grid sizes. Should only
+  /// be used for testing!
+  void setZDecomposition(int nzpe, int pe_zind, int mzg);
+
 private:
   std::string gridname;
   int nx, ny, nz; ///< Size of the grid in the input file
@@ -295,7 +326,18 @@ private:
   int PE_YIND; ///< Y index of this processor
   int NYPE;    // Number of processors in the Y direction
 
-  int NZPE;
+  int PE_ZIND{0}; ///< Z index of this processor
+  int NZPE{1};    ///< Number of processors in the Z direction
+
+  /// Global X index (excluding boundaries) of the first point on each
+  /// X processor, followed by MX
+  std::vector<int> x_offsets;
+  /// Global Y index (excluding boundaries) of the first point on each
+  /// Y processor, followed by MY
+  std::vector<int> y_offsets;
+
+  /// Split X and Y by cost rather than equally?
+  bool load_balance{false};
 
   /// Is this processor in the core region?
   bool MYPE_IN_CORE{false};
@@ -316,7 +358,8 @@ protected:
 
   // Processor number, local <-> global translation
   /// Returns the processor number, given X (\p xind) and Y (\p yind)
-  /// processor indices. Returns -1 if out of range (no processor)
+  /// processor indices, in the same Z slab as this processor.
+  /// Returns -1 if out of range (no processor)
   int PROC_NUM(int xind, int yind) const;
   int YGLOBAL(int yloc, int yproc) const;
   int YLOCAL(int yglo, int yproc) const;
@@ -392,6 +435,15 @@ protected:
   /// Adds 2D and 3D regions for boundaries
   void addBoundaryRegions();
 
+  /// Use persistent communication plans (MPI_Send_init/MPI_Recv_init)
+  /// for FieldGroups which are communicated repeatedly
+  bool persistent_comms{false};
+  /// Number of persistent communication plans currently kept
+  std::size_t numCommPlans() const;
+  /// Maximum number of plans to keep. The least recently used plan is
+  /// freed when this is exceeded
+  static constexpr std::size_t max_comm_plans = 32;
+
 private:
   std::vector<BoundaryRegion*> boundary;        // Vector of boundary regions
   std::vector<BoundaryRegionPar*> par_boundary; // Vector of parallel boundary regions
@@ -401,6 +453,8 @@ private:
 
   bool async_send{false}; ///< Switch to asyncronous sends (ISend, not Send)
 
+  struct CommPlan;
+
   /// Communication handle
   /// Used to keep track of communications between send and receive
   struct CommHandle {
@@ -417,25 +471,145 @@ private:
     /// Receiving buffers
     Array<BoutReal> umsg_recvbuff, dmsg_recvbuff, imsg_recvbuff, omsg_recvbuff;
     /// Is the communication still going?
-    bool in_progress;
+    bool in_progress{false};
     /// Are corner cells included in x-communication?
-    bool include_x_corners;
+    bool include_x_corners{false};
+    /// Does the x-communication only send the corner cells?
+    bool x_corners_only{false};
     /// Is there a y-communication
-    bool has_y_communication;
+    bool has_y_communication{false};
     /// List of fields being communicated
     FieldGroup var_list;
+    /// Persistent plan used for this communication, or nullptr if
+    /// the communication is done with the buffers above
+    CommPlan* plan{nullptr};
+    /// Plan exchanging the Z guard cells, if Z is split between processors
+    CommPlan* z_plan{nullptr};
+    /// Owns `z_plan` if the cached plan was already in use
+    std::unique_ptr<CommPlan> own_z_plan;
   };
   void free_handle(CommHandle* h);
   CommHandle* get_handle(int xlen, int ylen);
   void clear_handles();
   std::list<CommHandle*> comm_list; // List of allocated communication handles
 
+  /// Pre-registered guard cell exchange for a fixed group of fields
+  ///
+  /// Created the first time a FieldGroup is communicated when
+  /// `persistent_comms` is enabled, and reused every time the same
+  /// group is communicated again. The plan owns the send and receive
+  /// buffers, the persistent MPI requests bound to them, and the list
+  /// of contiguous blocks of field data to pack and unpack, so that
+  /// re-running a plan does no allocation or index calculation.
+  struct CommPlan {
+    /// A contiguous block of data in one field
+    struct Segment {
+      int field;  ///< Index of the field in `fields`
+      int offset; ///< Offset of the first value from the start of the field data
+      int length; ///< Number of contiguous values
+    };
+    /// One message to or from a neighbouring processor
+    struct Message {
+      Array<BoutReal> buffer;
+      std::vector<Segment> segments;
+    };
+
+    /// The fields this plan was created for
+    std::vector<FieldData*> fields;
+    /// Which fields are 3D, to catch fields being replaced at the same address
+    std::vector<bool> fields_3d;
+    bool x_comms, y_comms, include_x_corners;
+    /// Does this plan exchange the Z guard cells, to go with the X
+    /// and Y communications described by the flags above?
+    bool z_comms{false};
+
+    std::vector<Message> sends, receives;
+    std::vector<MPI_Request> send_requests, recv_requests;
+
+    /// Pointers to the data in each field, updated before each use
+    std::vector<BoutReal*> field_data;
+    bool in_progress{false};
+
+    /// For Z plans, the exchange in the (x, y) columns which are
+    /// received from X or Y neighbours. This starts once they have
+    /// arrived, while the plan itself covers the other columns and
+    /// starts with the X and Y sends
+    std::unique_ptr<CommPlan> z_received;
+
+    /// Add a matching pair of messages to and from processor \p proc
+    /// in \p comm, unless \p proc is -1, creating their persistent requests
+    void addMessages(int proc, int send_tag, int recv_tag, MPI_Comm comm,
+                     std::vector<Segment> send_segments,
+                     std::vector<Segment> recv_segments);
+
+    explicit CommPlan(MpiWrapper* mpi) : mpi(mpi) {}
+    CommPlan(const CommPlan&) = delete;
+    CommPlan& operator=(const CommPlan&) = delete;
+    /// Frees the persistent MPI requests
+    ~CommPlan();
+
+  private:
+    /// Wrapper used to create the requests, and to free them
+    MpiWrapper* mpi;
+  };
+  /// List of plans which is emptied rather than copied, as the plans
+  /// refer to the fields and MPI requests of the mesh that made them
+  struct CommPlanList : public std::list<std::unique_ptr<CommPlan>> {
+    using Base = std::list<std::unique_ptr<CommPlan>>;
+    CommPlanList() = default;
+    CommPlanList(const CommPlanList& UNUSED(other)) : Base() {}
+    CommPlanList(CommPlanList&& other) = default;
+    CommPlanList& operator=(const CommPlanList& UNUSED(other)) {
+      clear();
+      return *this;
+    }
+    CommPlanList& operator=(CommPlanList&& other) = default;
+    ~CommPlanList() = default;
+  };
+  /// Plans, ordered from most to least recently used. Removing a plan
+  /// from the list frees its MPI requests
+  CommPlanList comm_plans;
+
+  /// Find the plan to communicate \p g, creating one if needed. If
+  /// \p z_comms is true, find the plan for the Z guard cells instead.
+  /// Returns nullptr if the matching plan is already in use
+  CommPlan* getCommPlan(const FieldGroup& g, bool x_comms, bool y_comms,
+                        bool include_x_corners, bool z_comms = false);
+  /// Create a new plan for communicating \p g
+  std::unique_ptr<CommPlan> createCommPlan(const FieldGroup& g, bool x_comms,
+                                           bool y_comms, bool include_x_corners);
+  /// Create a new plan for exchanging the Z guard cells of the 3D
+  /// fields in \p g with the neighbouring processors in Z, at all X
+  /// and Y points, after the X and Y communications given by the flags
+  std::unique_ptr<CommPlan> createZCommPlan(const FieldGroup& g, bool x_comms,
+                                            bool y_comms, bool include_x_corners);
+  /// Pack send buffers and start all the persistent requests of \p plan
+  void startCommPlan(CommPlan& plan);
+  /// Wait for \p plan to complete and unpack the received data
+  void waitCommPlan(CommPlan& plan);
+  /// Start communicating \p g with a persistent plan, returning the
+  /// handle to pass to wait(), or nullptr if a plan can't be used
+  CommHandle* sendPlan(FieldGroup& g, bool x_comms, bool y_comms, bool include_x_corners);
+  /// Start exchanging the Z guard cells of the fields in \p ch which
+  /// aren't received from X or Y neighbours. Does nothing if Z isn't
+  /// split between processors
+  void startZComms(CommHandle& ch, bool x_comms, bool y_comms, bool include_x_corners);
+  /// Exchange the rest of the Z guard cells of \p ch, once the X and Y
+  /// communications are complete, and wait for all of them
+  void waitZComms(CommHandle& ch);
+
   //////////////////////////////////////////////////
   // X communicator
 
   /// Communicator containing all processors in X
   MPI_Comm comm_x{MPI_COMM_NULL};
 
+  //////////////////////////////////////////////////
+  // Z communicator
+
+  /// Communicator containing all processors in Z
+  MPI_Comm comm_z{MPI_COMM_NULL};
+
   //////////////////////////////////////////////////
   // Surface communications
 
@@ -483,6 +657,34 @@ CheckMeshResult checkBoutMeshYDecomposition(int num_y_processors, int ny,
                                             int num_y_guards, int jyseps1_1,
                                             int jyseps2_1, int jyseps1_2, int jyseps2_2,
                                             int ny_inner);
+
+/// The global Y indices (excluding boundaries) which must be the
+/// first point on a processor for the given `BoutMesh` topology
+/// parameters, because there is a branch cut or target between them
+/// and the point before. Sorted, and excludes 0 and \p ny
+std::vector<int> boutMeshYProcessorBoundaries(int ny, int jyseps1_1, int jyseps2_1,
+                                              int jyseps1_2, int jyseps2_2,
+                                              int ny_inner);
+
+/// Check that \p num_points can be split between \p num_processors,
+/// with at least \p min_points on each, and with a processor starting
+/// at each of \p boundaries
+CheckMeshResult checkWeightedDecomposition(int num_points, int num_processors,
+                                           int min_points,
+                                           const std::vector<int>& boundaries = {});
+
+/// Split points with the given cost \p weights between \p
+/// num_processors, so that the total weight on each processor is as
+/// even as possible. Each processor gets at least \p min_points, and a
+/// processor starts at each of \p boundaries, so processors don't span
+/// them.
+///
+/// Returns the index of the first point on each processor, followed
+/// by the total number of points. Throws `BoutException` if the
+/// points can't be split
+std::vector<int> weightedDecomposition(const std::vector<BoutReal>& weights,
+                                       int num_processors, int min_points,
+                                       const std::vector<int>& boundaries = {});
 } // namespace bout
 
 #endif // __BOUTMESH_H__
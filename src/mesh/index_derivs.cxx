@@ -23,10 +23,12 @@
 #include "bout/build_config.hxx"
 
 #include "bout/traits.hxx"
+#include <bout/fused_derivs.hxx>
 #include <bout/index_derivs.hxx>
 #include <bout/mesh.hxx>
 #include <bout/msg_stack.hxx>
 #include <bout/unused.hxx>
+#include <bout/z_transpose.hxx>
 
 /*******************************************************************************
  * Helper routines
@@ -68,6 +70,109 @@ STAGGER Mesh::getStagger(const CELL_LOC vloc, MAYBE_UNUSED(const CELL_LOC inloc)
   return getStagger(vloc, outloc, allowedStaggerLoc);
 }
 
+////////////////////// FUSED DERIVATIVES /////////////////////
+
+namespace bout {
+namespace derivatives {
+namespace fused {
+
+bool canFuseXZ(const Field3D& f, CELL_LOC outloc) {
+  if (outloc != CELL_DEFAULT and outloc != f.getLocation()) {
+    return false;
+  }
+
+  // If Z is split between processors, the neighbours in Z come from
+  // the Z guard cells rather than wrapping around, and the mixed
+  // derivative would need the X-Z corners
+  const Mesh* mesh = f.getMesh();
+  if (mesh->IncIntShear or mesh->getNpoints(DIRECTION::X) == 1
+      or mesh->getNpoints(DIRECTION::Z) == 1 or mesh->getNguard(DIRECTION::X) < 1
+      or mesh->zstart > 0) {
+    return false;
+  }
+
+  // The fused kernels are the same as the C2 methods
+  const auto& store = DerivativeStore<Field3D>::getInstance();
+  for (const auto direction : {DIRECTION::X, DIRECTION::Z}) {
+    for (const auto derivType : {DERIV::Standard, DERIV::StandardSecond}) {
+      if (store.getDefaultMethod(derivType, direction) != "C2") {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool canFuseSimpleBracket(const Field3D& f, const Field3D& g, CELL_LOC outloc) {
+  if (g.getLocation() != f.getLocation() or not canFuseXZ(f, outloc)) {
+    return false;
+  }
+
+  // The upwinding is the same as the U1 methods
+  const auto& store = DerivativeStore<Field3D>::getInstance();
+  for (const auto direction : {DIRECTION::X, DIRECTION::Z}) {
+    if (store.getDefaultMethod(DERIV::Upwind, direction) != "U1") {
+      return false;
+    }
+  }
+  return true;
+}
+
+Field3D simpleBracket(const Field3D& f, const Field3D& g, const std::string& region) {
+  ASSERT1(canFuseSimpleBracket(f, g));
+  checkData(g);
+
+  Coordinates* coords = g.getCoordinates();
+  const auto& dx = coords->dx;
+  const auto& dz = coords->dz;
+
+  // First order upwinding of g with velocity v, as VDDX_U1
+  const auto upwind = [](BoutReal v, const stencil& s) {
+    return v >= 0.0 ? v * (s.c - s.m) : v * (s.p - s.c);
+  };
+
+  Field3D result{emptyFrom(g)};
+  forEachXZ(f, region, [&](const Ind3D& i, const XZDerivatives& derivs) {
+    const auto gx = populateStencil<DIRECTION::X, STAGGER::None, 1>(g, i);
+    const auto gz = populateStencil<DIRECTION::Z, STAGGER::None, 1>(g, i);
+    result[i] = upwind(derivs.ddz, gx) / dx[i] + upwind(-derivs.ddx, gz) / dz[i];
+  });
+  return result;
+}
+
+void XZ(const Field3D& f, Field3D* ddx, Field3D* ddz, Field3D* d2dx2, Field3D* d2dz2,
+        Field3D* d2dxdz, const std::string& region) {
+  ASSERT1(canFuseXZ(f));
+
+  for (auto* output : {ddx, ddz, d2dx2, d2dz2, d2dxdz}) {
+    if (output != nullptr) {
+      *output = emptyFrom(f);
+    }
+  }
+
+  forEachXZ(f, region, [&](const Ind3D& i, const XZDerivatives& derivs) {
+    if (ddx != nullptr) {
+      (*ddx)[i] = derivs.ddx;
+    }
+    if (ddz != nullptr) {
+      (*ddz)[i] = derivs.ddz;
+    }
+    if (d2dx2 != nullptr) {
+      (*d2dx2)[i] = derivs.d2dx2;
+    }
+    if (d2dz2 != nullptr) {
+      (*d2dz2)[i] = derivs.d2dz2;
+    }
+    if (d2dxdz != nullptr) {
+      (*d2dxdz)[i] = derivs.d2dxdz;
+    }
+  });
+}
+
+} // namespace fused
+} // namespace derivatives
+} // namespace bout
+
 ////////////////////// FIRST DERIVATIVES /////////////////////
 
 /// central, 2nd order
@@ -433,8 +538,9 @@ public:
 
     auto* theMesh = var.getMesh();
 
-    // Calculate how many Z wavenumbers will be removed
-    const int ncz = theMesh->getNpoints(direction);
+    // Calculate how many Z wavenumbers will be removed. Z may be split
+    // between processors, so use the global number of points
+    const int ncz = theMesh->GlobalNz;
 
     int kfilter = static_cast<int>(theMesh->fft_derivs_filter * ncz
                                    / 2); // truncates, rounding down
@@ -446,35 +552,25 @@ public:
     }
     const int kmax = ncz / 2 - kfilter; // Up to and including this wavenumber index
 
-    BOUT_OMP(parallel)
-    {
-      Array<dcomplex> cv(ncz / 2 + 1);
-      const BoutReal kwaveFac = TWOPI / ncz;
-
-      // Note we lookup a 2D region here even though we're operating on a Field3D
-      // as we only want to loop over {x, y} and then handle z differently. The
-      // Region<Ind2D> blocks are constructed for elements contiguous assuming nz=1,
-      // as that isn't the case for Field3D (in general) this shouldn't be expected
-      // to vectorise (not that it would anyway) but it should still OpenMP parallelise
-      // ok.
-      // With this in mind we could perhaps avoid the use of the BOUT_FOR_INNER macro
-      // here,
-      // but should be ok for now.
-      BOUT_FOR_INNER(i, theMesh->getRegion2D(region)) {
-        auto i3D = theMesh->ind2Dto3D(i, 0);
-        rfft(&var[i3D], ncz, cv.begin()); // Forward FFT
-
-        for (int jz = 0; jz <= kmax; jz++) {
-          const BoutReal kwave = jz * kwaveFac; // wave number is 1/[rad]
-          cv[jz] *= dcomplex(0, kwave);
-        }
-        for (int jz = kmax + 1; jz <= ncz / 2; jz++) {
-          cv[jz] = 0.0;
-        }
-
-        irfft(cv.begin(), ncz, &result[i3D]); // Reverse FFT
-      }
-    }
+    const BoutReal kwaveFac = TWOPI / ncz;
+
+    // Each line in z is transformed as a whole, transposing it onto
+    // one processor first if z is split between processors
+    bout::forEachZLine(
+        var, result, theMesh->getRegion2D(region),
+        [&](Ind2D UNUSED(i), const BoutReal* in, BoutReal* out, dcomplex* cv) {
+          rfft(in, ncz, cv); // Forward FFT
+
+          for (int jz = 0; jz <= kmax; jz++) {
+            const BoutReal kwave = jz * kwaveFac; // wave number is 1/[rad]
+            cv[jz] *= dcomplex(0, kwave);
+          }
+          for (int jz = kmax + 1; jz <= ncz / 2; jz++) {
+            cv[jz] = 0.0;
+          }
+
+          irfft(cv, ncz, out); // Reverse FFT
+        });
   }
 
   template <DIRECTION direction, STAGGER stagger, int nGuards, typename T>
@@ -502,38 +598,25 @@ public:
     auto* theMesh = var.getMesh();
 
     // Calculate how many Z wavenumbers will be removed
-    const int ncz = theMesh->getNpoints(direction);
+    const int ncz = theMesh->GlobalNz;
     const int kmax = ncz / 2;
-
-    BOUT_OMP(parallel)
-    {
-      Array<dcomplex> cv(ncz / 2 + 1);
-      const BoutReal kwaveFac = TWOPI / ncz;
-
-      // Note we lookup a 2D region here even though we're operating on a Field3D
-      // as we only want to loop over {x, y} and then handle z differently. The
-      // Region<Ind2D> blocks are constructed for elements contiguous assuming nz=1,
-      // as that isn't the case for Field3D (in general) this shouldn't be expected
-      // to vectorise (not that it would anyway) but it should still OpenMP parallelise
-      // ok.
-      // With this in mind we could perhaps avoid the use of the BOUT_FOR_INNER macro
-      // here,
-      // but should be ok for now.
-      BOUT_FOR_INNER(i, theMesh->getRegion2D(region)) {
-        auto i3D = theMesh->ind2Dto3D(i, 0);
-        rfft(&var[i3D], ncz, cv.begin()); // Forward FFT
-
-        for (int jz = 0; jz <= kmax; jz++) {
-          const BoutReal kwave = jz * kwaveFac; // wave number is 1/[rad]
-          cv[jz] *= -kwave * kwave;
-        }
-        for (int jz = kmax + 1; jz <= ncz / 2; jz++) {
-          cv[jz] = 0.0;
-        }
-
-        irfft(cv.begin(), ncz, &result[i3D]); // Reverse FFT
-      }
-    }
+    const BoutReal kwaveFac = TWOPI / ncz;
+
+    bout::forEachZLine(
+        var, result, theMesh->getRegion2D(region),
+        [&](Ind2D UNUSED(i), const BoutReal* in, BoutReal* out, dcomplex* cv) {
+          rfft(in, ncz, cv); // Forward FFT
+
+          for (int jz = 0; jz <= kmax; jz++) {
+            const BoutReal kwave = jz * kwaveFac; // wave number is 1/[rad]
+            cv[jz] *= -kwave * kwave;
+          }
+          for (int jz = kmax + 1; jz <= ncz / 2; jz++) {
+            cv[jz] = 0.0;
+          }
+
+          irfft(cv, ncz, out); // Reverse FFT
+        });
   }
 
   template <DIRECTION direction, STAGGER stagger, int nGuards, typename T>
@@ -582,3 +665,24 @@ produceCombinations<
     Set<WRAP_ENUM(STAGGER, None), WRAP_ENUM(STAGGER, C2L), WRAP_ENUM(STAGGER, L2C)>,
     Set<TypeContainer<Field3D>, TypeContainer<Field2D>>, Set<SplitFluxDerivativeType>>
     registerSplitDerivative(registerMethod{});
+
+#if BOUT_USE_STATIC_DERIVATIVE_DEFAULTS
+// Fix the default methods at compile time, rather than reading them
+// from the input file. These must come after the methods are registered
+produceCombinations<
+    Set<WRAP_ENUM(DIRECTION, X), WRAP_ENUM(DIRECTION, Y),
+        WRAP_ENUM(DIRECTION, YOrthogonal), WRAP_ENUM(DIRECTION, Z)>,
+    Set<WRAP_ENUM(STAGGER, None)>, Set<TypeContainer<Field3D>, TypeContainer<Field2D>>,
+    Set<DerivativeType<DDX_C2>, DerivativeType<D2DX2_C2>, DerivativeType<D4DX4_C2>,
+        DerivativeType<VDDX_U1>, DerivativeType<FDDX_U1>>>
+    registerStaticDefaults(registerDefaultMethod{});
+
+produceCombinations<
+    Set<WRAP_ENUM(DIRECTION, X), WRAP_ENUM(DIRECTION, Y),
+        WRAP_ENUM(DIRECTION, YOrthogonal), WRAP_ENUM(DIRECTION, Z)>,
+    Set<WRAP_ENUM(STAGGER, C2L), WRAP_ENUM(STAGGER, L2C)>,
+    Set<TypeContainer<Field3D>, TypeContainer<Field2D>>,
+    Set<DerivativeType<DDX_C2_stag>, DerivativeType<D2DX2_C2_stag>,
+        DerivativeType<VDDX_U1_stag>, DerivativeType<FDDX_U1_stag>>>
+    registerStaticStaggeredDefaults(registerDefaultMethod{});
+#endif
@@ -344,6 +344,40 @@ void Mesh::communicate(FieldGroup& g) {
   }
 }
 
+comm_handle Mesh::startCommunicate(FieldGroup& g) {
+  TRACE("Mesh::startCommunicate(FieldGroup&)");
+
+  if (include_corner_cells) {
+    // The corner cells are received in the y-communication, so can't
+    // be sent in x yet. Start everything else here, and exchange the
+    // corners in finishCommunicate
+    return sendWithoutCorners(g);
+  }
+  return send(g);
+}
+
+void Mesh::finishCommunicate(comm_handle handle, FieldGroup& g) {
+  TRACE("Mesh::finishCommunicate(FieldGroup&)");
+
+  // Wait for data from other processors
+  wait(handle);
+
+  if (include_corner_cells) {
+    // Now the y guard cells have arrived, send the corner cells in
+    // the x-direction
+    if (comm_handle corners = sendXCorners(g)) {
+      wait(corners);
+    }
+  }
+
+  // Calculate yup and ydown fields for 3D fields
+  if (calcParallelSlices_on_communicate) {
+    for (const auto& fptr : g.field3d()) {
+      fptr->calcParallelSlices();
+    }
+  }
+}
+
 /// This is a bit of a hack for now to get FieldPerp communications
 /// The FieldData class needs to be changed to accomodate FieldPerp objects
 void Mesh::communicate(FieldPerp& f) {
@@ -621,6 +655,14 @@ void Mesh::addRegionPerp(const std::string& region_name, const Region<IndPerp>&
 }
 
 void Mesh::createDefaultRegions() {
+  // Width of the guard cells on each side
+  const int xguards_lower = xstart;
+  const int xguards_upper = LocalNx - 1 - xend;
+  const int yguards_lower = ystart;
+  const int yguards_upper = LocalNy - 1 - yend;
+  const int zguards_lower = zstart;
+  const int zguards_upper = LocalNz - 1 - zend;
+
   //3D regions
   addRegion3D("RGN_ALL", Region<Ind3D>(0, LocalNx - 1, 0, LocalNy - 1, 0, LocalNz - 1,
                                        LocalNy, LocalNz, maxregionblocksize));
@@ -651,6 +693,16 @@ void Mesh::createDefaultRegions() {
   addRegion3D("RGN_NOCORNERS", (getRegion3D("RGN_NOBNDRY") + getRegion3D("RGN_XGUARDS")
                                 + getRegion3D("RGN_YGUARDS") + getRegion3D("RGN_ZGUARDS"))
                                    .unique());
+  // Points whose stencils (of at most the guard cell width) don't
+  // reach into the guard cells, so can be calculated while the guard
+  // cells are being communicated, and the rest of RGN_NOBNDRY
+  addRegion3D("RGN_NOBNDRY_INTERIOR",
+              Region<Ind3D>(xstart + xguards_lower, xend - xguards_upper,
+                            ystart + yguards_lower, yend - yguards_upper,
+                            zstart + zguards_lower, zend - zguards_upper, LocalNy,
+                            LocalNz, maxregionblocksize));
+  addRegion3D("RGN_NOBNDRY_SHELL",
+              mask(getRegion3D("RGN_NOBNDRY"), getRegion3D("RGN_NOBNDRY_INTERIOR")));
 
   //2D regions
   addRegion2D("RGN_ALL", Region<Ind2D>(0, LocalNx - 1, 0, LocalNy - 1, 0, 0, LocalNy, 1,
@@ -679,6 +731,12 @@ void Mesh::createDefaultRegions() {
   addRegion2D("RGN_NOCORNERS", (getRegion2D("RGN_NOBNDRY") + getRegion2D("RGN_XGUARDS")
                                 + getRegion2D("RGN_YGUARDS") + getRegion2D("RGN_ZGUARDS"))
                                    .unique());
+  addRegion2D("RGN_NOBNDRY_INTERIOR",
+              Region<Ind2D>(xstart + xguards_lower, xend - xguards_upper,
+                            ystart + yguards_lower, yend - yguards_upper, 0, 0, LocalNy, 1,
+                            maxregionblocksize));
+  addRegion2D("RGN_NOBNDRY_SHELL",
+              mask(getRegion2D("RGN_NOBNDRY"), getRegion2D("RGN_NOBNDRY_INTERIOR")));
 
   // Perp regions
   addRegionPerp("RGN_ALL", Region<IndPerp>(0, LocalNx - 1, 0, 0, 0, LocalNz - 1, 1,
@@ -712,6 +770,12 @@ void Mesh::createDefaultRegions() {
                 (getRegionPerp("RGN_NOBNDRY") + getRegionPerp("RGN_XGUARDS")
                  + getRegionPerp("RGN_YGUARDS") + getRegionPerp("RGN_ZGUARDS"))
                     .unique());
+  addRegionPerp("RGN_NOBNDRY_INTERIOR",
+                Region<IndPerp>(xstart + xguards_lower, xend - xguards_upper, 0, 0,
+                                zstart + zguards_lower, zend - zguards_upper, 1, LocalNz,
+                                maxregionblocksize));
+  addRegionPerp("RGN_NOBNDRY_SHELL", mask(getRegionPerp("RGN_NOBNDRY"),
+                                          getRegionPerp("RGN_NOBNDRY_INTERIOR")));
 
   // Construct index lookup for 3D-->2D
   indexLookup3Dto2D = Array<int>(LocalNx * LocalNy * LocalNz);
@@ -12,8 +12,11 @@
 #include <bout/mesh.hxx>
 #include <bout/output.hxx>
 #include <bout/sys/timer.hxx>
+#include <bout/z_transpose.hxx>
 
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
 ShiftedMetric::ShiftedMetric(Mesh& m, CELL_LOC location_in, Field2D zShift_,
                              BoutReal zlength_in, Options* opt)
@@ -57,8 +60,9 @@ void ShiftedMetric::cachePhases() {
 
   // As we're attached to a mesh we can expect the z direction to
   // not change once we've been created so precalculate the complex
-  // phases used in transformations
-  nmodes = mesh.LocalNz / 2 + 1;
+  // phases used in transformations. Z may be split between
+  // processors, so the modes are those of the whole of Z
+  nmodes = mesh.GlobalNz / 2 + 1;
 
   // Allocate storage for our 3d phase information.
   fromAlignedPhs = Tensor<dcomplex>(mesh.LocalNx, mesh.LocalNy, nmodes);
@@ -156,7 +160,7 @@ Field3D ShiftedMetric::shiftZ(const Field3D& f, const Tensor<dcomplex>& phs,
   ASSERT1(f.getMesh() == &mesh);
   ASSERT1(f.getLocation() == location);
 
-  if (mesh.LocalNz == 1) {
+  if (mesh.GlobalNz == 1) {
     // Shifting does not change the array values
     Field3D result = copy(f).setDirectionY(y_direction_out);
     return result;
@@ -164,8 +168,25 @@ Field3D ShiftedMetric::shiftZ(const Field3D& f, const Tensor<dcomplex>& phs,
 
   Field3D result{emptyFrom(f).setDirectionY(y_direction_out)};
 
-  BOUT_FOR(i, mesh.getRegion2D(toString(region))) {
-    shiftZ(&f(i, 0), &phs(i.x(), i.y(), 0), &result(i, 0));
+  if (mesh.getNZPE() > 1) {
+    // Z is split between processors, so shift whole lines in Z,
+    // transposed onto one processor
+    bout::forEachZLine(f, result, mesh.getRegion2D(toString(region)),
+                       [&](Ind2D i, const BoutReal* in, BoutReal* out,
+                           dcomplex* UNUSED(modes)) {
+                         shiftZ(in, &phs(i.x(), i.y(), 0), 1, nmodes, out);
+                       });
+    return result;
+  }
+
+  // Each contiguous block of the region is a set of Z columns which
+  // are consecutive in memory, so can be shifted in one batch
+  const auto& blocks = mesh.getRegion2D(toString(region)).getBlocks();
+  BOUT_OMP(parallel for schedule(BOUT_OPENMP_SCHEDULE))
+  for (auto block = blocks.cbegin(); block < blocks.cend(); ++block) {
+    const auto& i = block->first;
+    shiftZ(&f(i, 0), &phs(i.x(), i.y(), 0), block->second.ind - i.ind, nmodes,
+           &result(i, 0));
   }
 
   return result;
@@ -177,47 +198,63 @@ FieldPerp ShiftedMetric::shiftZ(const FieldPerp& f, const Tensor<dcomplex>& phs,
   ASSERT1(f.getMesh() == &mesh);
   ASSERT1(f.getLocation() == location);
 
-  if (mesh.LocalNz == 1) {
+  if (mesh.GlobalNz == 1) {
     // Shifting does not change the array values
     FieldPerp result = copy(f).setDirectionY(y_direction_out);
     return result;
   }
 
+  if (mesh.getNZPE() > 1) {
+    // A FieldPerp is only on the processors at one Y index, so can't
+    // be transposed between all the processors in the Z communicator
+    throw BoutException("Can't shift a FieldPerp in Z with ShiftedMetric when Z is "
+                        "split between processors (NZPE > 1)");
+  }
+
   FieldPerp result{emptyFrom(f).setDirectionY(y_direction_out)};
 
   int y = f.getIndex();
-  // Note that this loop is essentially hardcoded to be RGN_NOX
-  for (int i = mesh.xstart; i <= mesh.xend; ++i) {
-    shiftZ(&f(i, 0), &phs(i, y, 0), &result(i, 0));
-  }
+  // Note that this is essentially hardcoded to be RGN_NOX. The phases
+  // for consecutive x are LocalNy * nmodes apart
+  shiftZ(&f(mesh.xstart, 0), &phs(mesh.xstart, y, 0), mesh.xend - mesh.xstart + 1,
+         mesh.LocalNy * nmodes, &result(mesh.xstart, 0));
 
   return result;
 }
 
-void ShiftedMetric::shiftZ(const BoutReal* in, const dcomplex* phs, BoutReal* out) const {
+void ShiftedMetric::shiftZ(const BoutReal* in, const dcomplex* phs, int ncolumns,
+                           int phs_stride, BoutReal* out) const {
 #if BOUT_HAS_UMPIRE
   // TODO: This static keyword is a hotfix and should be removed in
   //      future iterations. It is here because otherwise many allocations
   //      lead to very poor performance
-  static Array<dcomplex> cmplx(nmodes);
+  static Array<dcomplex> cmplx;
+  if (cmplx.size() < ncolumns * nmodes) {
+    cmplx = Array<dcomplex>(ncolumns * nmodes);
+  }
 #warning static hotfix used in ShiftedMetric::shiftZ. Not thread-safe.
 #else
-  Array<dcomplex> cmplx(nmodes);
+  // Working space, kept between calls as this is called for every
+  // column when Z is split between processors
+  thread_local std::vector<dcomplex> cmplx;
+  if (cmplx.size() < static_cast<std::size_t>(ncolumns * nmodes)) {
+    cmplx.resize(ncolumns * nmodes);
+  }
 #endif
 
-  // Take forward FFT
-  rfft(in, mesh.LocalNz, &cmplx[0]);
-
-  // Following is an algorithm approach to write a = a*b where a and b are
-  // vectors of dcomplex.
-  //  std::transform(cmplxOneOff.begin(),cmplxOneOff.end(), ptr.begin(),
-  //		 cmplxOneOff.begin(), std::multiplies<dcomplex>());
+  // Take forward FFT of all the columns
+  bout::fft::rfft(in, mesh.GlobalNz, ncolumns, &cmplx[0]);
 
-  for (int jz = 1; jz < nmodes; jz++) {
-    cmplx[jz] *= phs[jz];
+  for (int column = 0; column < ncolumns; column++) {
+    dcomplex* column_modes = &cmplx[column * nmodes];
+    const dcomplex* column_phs = phs + column * phs_stride;
+    for (int jz = 1; jz < nmodes; jz++) {
+      column_modes[jz] *= column_phs[jz];
+    }
   }
 
-  irfft(&cmplx[0], mesh.LocalNz, out); // Reverse FFT
+  // Reverse FFT. The shifted modes aren't needed afterwards
+  bout::fft::irfft_overwrite_input(&cmplx[0], mesh.GlobalNz, ncolumns, out);
 }
 
 void ShiftedMetric::calcParallelSlices(Field3D& f) {
@@ -230,63 +267,84 @@ void ShiftedMetric::calcParallelSlices(Field3D& f) {
   f.splitParallelSlices();
 
   for (const auto& phase : parallel_slice_phases) {
-    auto& f_slice = f.ynext(phase.y_offset);
-    f_slice.allocate();
-    BOUT_FOR(i, mesh.getRegion2D("RGN_NOY")) {
-      const int ix = i.x();
-      const int iy = i.y();
-      const int iy_offset = iy + phase.y_offset;
-      shiftZ(&(f(ix, iy_offset, 0)), &(phase.phase_shift(ix, iy, 0)),
-             &(f_slice(ix, iy_offset, 0)));
-    }
+    f.ynext(phase.y_offset).allocate();
   }
+
+  shiftZ(f, parallel_slice_phases);
 }
 
-std::vector<Field3D>
-ShiftedMetric::shiftZ(const Field3D& f,
-                      const std::vector<ParallelSlicePhase>& phases) const {
+void ShiftedMetric::shiftZ(Field3D& f,
+                           const std::vector<ParallelSlicePhase>& phases) const {
   ASSERT1(f.getMesh() == &mesh);
   ASSERT1(f.getLocation() == location);
   ASSERT1(f.getDirectionY() == YDirectionType::Standard);
 
-  const int nmodes = mesh.LocalNz / 2 + 1;
-
-  // FFT in Z of input field at each (x, y) point
-  Matrix<Array<dcomplex>> f_fft(mesh.LocalNx, mesh.LocalNy);
-  f_fft = Array<dcomplex>(nmodes);
-
-  BOUT_FOR(i, mesh.getRegion2D("RGN_ALL")) {
-    int ix = i.x();
-    int iy = i.y();
-    f_fft(ix, iy).ensureUnique();
-    rfft(&f(i, 0), mesh.LocalNz, f_fft(ix, iy).begin());
+  if (mesh.getNZPE() > 1) {
+    // Z is split between processors, so shift whole lines in Z one
+    // slice at a time. The slices are at the points of RGN_NOY offset
+    // in Y, with the phases of the points they are offset from
+    for (const auto& phase : phases) {
+      auto region = mesh.getRegion2D("RGN_NOY");
+      region.offset(phase.y_offset);
+      bout::forEachZLine(f, f.ynext(phase.y_offset), region,
+                         [&](Ind2D i, const BoutReal* in, BoutReal* out,
+                             dcomplex* UNUSED(modes)) {
+                           const auto i_orig = i.ym(phase.y_offset);
+                           shiftZ(in, &phase.phase_shift(i.x(), i_orig.y(), 0), 1,
+                                  nmodes, out);
+                         });
+    }
+    return;
   }
 
-  std::vector<Field3D> results{};
+  const int nz = mesh.LocalNz;
 
-  for (auto& phase : phases) {
-    // In C++17 std::vector::emplace_back returns a reference, which
-    // would be very useful here!
-    results.emplace_back(&mesh);
-    auto& current_result = results.back();
-    current_result.allocate();
-    current_result.setLocation(f.getLocation());
+  // FFT in Z of input field at every (x, y) point, in one batch. This
+  // is shared by all the slices
+  Array<dcomplex> f_fft(mesh.LocalNx * mesh.LocalNy * nmodes);
+  bout::fft::rfft(&f(0, 0, 0), nz, mesh.LocalNx * mesh.LocalNy, f_fft.begin());
 
-    BOUT_FOR(i, mesh.getRegion2D("RGN_NOY")) {
-      // Deep copy the FFT'd field
-      int ix = i.x();
-      int iy = i.y();
-
-      Array<dcomplex> shifted_temp(f_fft(ix, iy + phase.y_offset));
-      shifted_temp.ensureUnique();
+  const auto& blocks = mesh.getRegion2D("RGN_NOY").getBlocks();
+  int max_block_size = 0;
+  for (const auto& block : blocks) {
+    max_block_size = std::max(max_block_size, block.second.ind - block.first.ind);
+  }
 
-      for (int jz = 1; jz < nmodes; ++jz) {
-        shifted_temp[jz] *= phase.phase_shift(ix, iy, jz);
+  BOUT_OMP(parallel)
+  {
+    // Working space for the shifted modes of one block, allocated
+    // once per thread
+    Array<dcomplex> shifted(max_block_size * nmodes);
+
+    for (const auto& phase : phases) {
+      Field3D& f_slice = f.ynext(phase.y_offset);
+
+      BOUT_OMP(for schedule(BOUT_OPENMP_SCHEDULE))
+      for (auto block = blocks.cbegin(); block < blocks.cend(); ++block) {
+        const auto& i = block->first;
+        const auto i_offset = i.yp(phase.y_offset);
+        const int size = (block->second.ind - i.ind) * nmodes;
+
+        // The columns of the block are consecutive, and so are their
+        // modes and phases
+        const dcomplex* f_modes = &f_fft[i_offset.ind * nmodes];
+        const dcomplex* phs = &phase.phase_shift(i.x(), i.y(), 0);
+
+        // Complex multiply written out, so that it can be vectorised.
+        // The phase of the kz = 0 mode is exactly 1
+        for (int k = 0; k < size; ++k) {
+          const BoutReal a = f_modes[k].real();
+          const BoutReal b = f_modes[k].imag();
+          const BoutReal c = phs[k].real();
+          const BoutReal d = phs[k].imag();
+          shifted[k] = dcomplex(a * c - b * d, a * d + b * c);
+        }
+
+        // Transform straight into the parallel slice. The shifted
+        // modes are only working space, so don't need to be kept
+        bout::fft::irfft_overwrite_input(shifted.begin(), nz, block->second.ind - i.ind,
+                                         &f_slice(i_offset, 0));
       }
-
-      irfft(shifted_temp.begin(), mesh.LocalNz, &current_result(i.yp(phase.y_offset), 0));
     }
   }
-
-  return results;
 }
@@ -0,0 +1,353 @@
+#include "bout/z_transpose.hxx"
+
+#include "bout/array.hxx"
+#include "bout/assert.hxx"
+#include "bout/boutexception.hxx"
+#include "bout/fft.hxx"
+#include "bout/field3d.hxx"
+#include "bout/mesh.hxx"
+#include "bout/mpi_wrapper.hxx"
+#include "bout/openmpwrap.hxx"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace bout {
+namespace {
+/// Split \p lines into runs of lines which follow each other in
+/// memory, each \p length long, so that each run can be transformed
+/// in one batch. Returns the first line and number of lines in each
+template <typename T>
+std::vector<std::pair<int, int>> contiguousRuns(const std::vector<T*>& lines,
+                                                int length) {
+  std::vector<std::pair<int, int>> runs;
+  const int nlines = static_cast<int>(lines.size());
+  int start = 0;
+  while (start < nlines) {
+    int end = start + 1;
+    while (end < nlines and lines[end] == lines[end - 1] + length) {
+      ++end;
+    }
+    runs.emplace_back(start, end - start);
+    start = end;
+  }
+  return runs;
+}
+
+/// Call \p func(start, count) for each of \p runs. A single run is
+/// left to the FFT routines to split between OpenMP threads,
+/// otherwise the runs are shared between the threads
+template <typename F>
+void forEachRun(const std::vector<std::pair<int, int>>& runs, F func) {
+  if (runs.size() == 1) {
+    func(runs[0].first, runs[0].second);
+    return;
+  }
+  const int nruns = static_cast<int>(runs.size());
+  BOUT_OMP(parallel for)
+  for (int r = 0; r < nruns; ++r) {
+    func(runs[r].first, runs[r].second);
+  }
+}
+} // namespace
+
+void forEachZLine(const Field3D& f, Field3D& result, const Region<Ind2D>& region,
+                  const ZLineFunction& function) {
+  Mesh* mesh = f.getMesh();
+  result.allocate();
+
+  const int nz = mesh->GlobalNz;
+
+  const int nzpe = mesh->getNZPE();
+  if (nzpe == 1) {
+    // Z isn't split, so every line is already on this processor
+    BOUT_OMP(parallel)
+    {
+      Array<dcomplex> modes((nz / 2) + 1);
+
+      BOUT_FOR_INNER(i, region) {
+        const auto i3D = mesh->ind2Dto3D(i, mesh->zstart);
+        function(i, &f[i3D], &result[i3D], modes.begin());
+      }
+    }
+    return;
+  }
+
+  const int mzsub = mesh->zend - mesh->zstart + 1;
+  ASSERT1(nz == nzpe * mzsub);
+
+  const auto& indices = region.getIndices();
+  const int npoints = static_cast<int>(indices.size());
+
+  // Points first(p) to first(p + 1) - 1 are transformed on Z processor p
+  const auto first = [&](int p) { return (npoints * p) / nzpe; };
+  const int zproc = mesh->getZProcIndex();
+  const int nlines = first(zproc + 1) - first(zproc);
+
+  // Counts and offsets are in the same units (BoutReals) on all
+  // processors, so the same arrays describe the reverse transpose
+  std::vector<int> part_counts(nzpe);
+  std::vector<int> part_displs(nzpe);
+  std::vector<int> line_counts(nzpe, nlines * mzsub);
+  std::vector<int> line_displs(nzpe);
+  for (int p = 0; p < nzpe; ++p) {
+    part_counts[p] = (first(p + 1) - first(p)) * mzsub;
+    part_displs[p] = first(p) * mzsub;
+    line_displs[p] = p * nlines * mzsub;
+  }
+
+  // This processor's part of every line, in the order of region
+  Array<BoutReal> parts(npoints * mzsub);
+  BOUT_OMP(parallel for)
+  for (int n = 0; n < npoints; ++n) {
+    const BoutReal* in = &f[mesh->ind2Dto3D(indices[n], mesh->zstart)];
+    std::copy(in, in + mzsub, parts.begin() + n * mzsub);
+  }
+
+  // Parts of this processor's lines, grouped by the processor they came from
+  Array<BoutReal> received(nlines * nz);
+  auto& mpi = mesh->getMpi();
+  mpi.MPI_Alltoallv(parts.begin(), part_counts.data(), part_displs.data(), MPI_DOUBLE,
+                    received.begin(), line_counts.data(), line_displs.data(), MPI_DOUBLE,
+                    mesh->getZcomm());
+
+  Array<BoutReal> lines(nlines * nz);
+  BOUT_OMP(parallel)
+  {
+    Array<dcomplex> modes((nz / 2) + 1);
+
+    BOUT_OMP(for)
+    for (int j = 0; j < nlines; ++j) {
+      BoutReal* line = lines.begin() + j * nz;
+      for (int p = 0; p < nzpe; ++p) {
+        const BoutReal* part = received.begin() + line_displs[p] + j * mzsub;
+        std::copy(part, part + mzsub, line + p * mzsub);
+      }
+      function(indices[first(zproc) + j], line, line, modes.begin());
+      for (int p = 0; p < nzpe; ++p) {
+        std::copy(line + p * mzsub, line + (p + 1) * mzsub,
+                  received.begin() + line_displs[p] + j * mzsub);
+      }
+    }
+  }
+
+  mpi.MPI_Alltoallv(received.begin(), line_counts.data(), line_displs.data(), MPI_DOUBLE,
+                    parts.begin(), part_counts.data(), part_displs.data(), MPI_DOUBLE,
+                    mesh->getZcomm());
+
+  BOUT_OMP(parallel for)
+  for (int n = 0; n < npoints; ++n) {
+    BoutReal* out = &result[mesh->ind2Dto3D(indices[n], mesh->zstart)];
+    std::copy(parts.begin() + n * mzsub, parts.begin() + (n + 1) * mzsub, out);
+  }
+}
+
+ZFourierTranspose::ZFourierTranspose(Mesh* mesh, int nmode)
+    : mesh(mesh), nmode(nmode), nzpe(mesh->getNZPE()), zproc(mesh->getZProcIndex()) {
+  if (nmode > mesh->GlobalNz / 2 + 1) {
+    throw BoutException("ZFourierTranspose: {:d} modes requested, but only {:d} are "
+                        "available from {:d} points in Z",
+                        nmode, mesh->GlobalNz / 2 + 1, mesh->GlobalNz);
+  }
+  if (nmode < nzpe) {
+    throw BoutException("ZFourierTranspose: {:d} modes can't be shared between {:d} "
+                        "processors in Z",
+                        nmode, nzpe);
+  }
+}
+
+Matrix<dcomplex> ZFourierTranspose::forward(const std::vector<const BoutReal*>& lines) const {
+  const int nlines = static_cast<int>(lines.size());
+  const int nz = mesh->GlobalNz;
+  const int nfft = (nz / 2) + 1;
+  const int nlocal = localModes();
+
+  Matrix<dcomplex> modes(nlines, nlocal);
+  if (nlines == 0) {
+    return modes;
+  }
+
+  if (nzpe == 1) {
+    Matrix<dcomplex> spectrum(nlines, nfft);
+    forEachRun(contiguousRuns(lines, nz), [&](int start, int count) {
+      fft::rfft(lines[start], nz, count, &spectrum(start, 0));
+    });
+
+    BOUT_OMP(parallel for)
+    for (int i = 0; i < nlines; ++i) {
+      std::copy(&spectrum(i, 0), &spectrum(i, 0) + nlocal, &modes(i, 0));
+    }
+    return modes;
+  }
+
+  const int mzsub = mesh->zend - mesh->zstart + 1;
+  ASSERT1(nz == nzpe * mzsub);
+
+  // Lines first(p) to first(p + 1) - 1 are transformed on Z processor p
+  const auto first = [&](int p) { return (nlines * p) / nzpe; };
+  const int mine = first(zproc + 1) - first(zproc);
+
+  // Transpose so this processor has complete lines, as in forEachZLine
+  std::vector<int> part_counts(nzpe);
+  std::vector<int> part_displs(nzpe);
+  std::vector<int> line_counts(nzpe, mine * mzsub);
+  std::vector<int> line_displs(nzpe);
+  // Modes are sent as pairs of doubles
+  std::vector<int> spectrum_counts(nzpe);
+  std::vector<int> spectrum_displs(nzpe);
+  std::vector<int> mode_counts(nzpe);
+  std::vector<int> mode_displs(nzpe);
+  for (int p = 0; p < nzpe; ++p) {
+    part_counts[p] = (first(p + 1) - first(p)) * mzsub;
+    part_displs[p] = first(p) * mzsub;
+    line_displs[p] = p * mine * mzsub;
+    spectrum_counts[p] = 2 * mine * (modeStart(p + 1) - modeStart(p));
+    spectrum_displs[p] = 2 * mine * modeStart(p);
+    mode_counts[p] = 2 * (first(p + 1) - first(p)) * nlocal;
+    mode_displs[p] = 2 * first(p) * nlocal;
+  }
+
+  Array<BoutReal> parts(nlines * mzsub);
+  BOUT_OMP(parallel for)
+  for (int i = 0; i < nlines; ++i) {
+    std::copy(lines[i], lines[i] + mzsub, parts.begin() + i * mzsub);
+  }
+
+  Array<BoutReal> received(mine * nz);
+  auto& mpi = mesh->getMpi();
+  mpi.MPI_Alltoallv(parts.begin(), part_counts.data(), part_displs.data(), MPI_DOUBLE,
+                    received.begin(), line_counts.data(), line_displs.data(), MPI_DOUBLE,
+                    mesh->getZcomm());
+
+  // Transform complete lines, and sort the modes by the processor
+  // they are sent to
+  Array<dcomplex> sorted(mine * nmode);
+  if (mine > 0) {
+    Array<BoutReal> complete(mine * nz);
+    BOUT_OMP(parallel for)
+    for (int j = 0; j < mine; ++j) {
+      for (int p = 0; p < nzpe; ++p) {
+        const BoutReal* part = received.begin() + line_displs[p] + j * mzsub;
+        std::copy(part, part + mzsub, complete.begin() + j * nz + p * mzsub);
+      }
+    }
+
+    Matrix<dcomplex> spectrum(mine, nfft);
+    fft::rfft(complete.begin(), nz, mine, &spectrum(0, 0));
+
+    BOUT_OMP(parallel for)
+    for (int j = 0; j < mine; ++j) {
+      for (int p = 0; p < nzpe; ++p) {
+        const int count = modeStart(p + 1) - modeStart(p);
+        std::copy(&spectrum(j, modeStart(p)), &spectrum(j, modeStart(p)) + count,
+                  sorted.begin() + mine * modeStart(p) + j * count);
+      }
+    }
+  }
+
+  // Blocks of lines arrive in order, so are received directly into
+  // the rows of the result
+  mpi.MPI_Alltoallv(sorted.begin(), spectrum_counts.data(), spectrum_displs.data(),
+                    MPI_DOUBLE, modes.begin(), mode_counts.data(), mode_displs.data(),
+                    MPI_DOUBLE, mesh->getZcomm());
+  return modes;
+}
+
+void ZFourierTranspose::backward(const Matrix<dcomplex>& modes,
+                                 const std::vector<BoutReal*>& lines) const {
+  const int nlines = static_cast<int>(lines.size());
+  const int nz = mesh->GlobalNz;
+  const int nfft = (nz / 2) + 1;
+  const int nlocal = localModes();
+  ASSERT1(static_cast<int>(std::get<0>(modes.shape())) == nlines);
+  ASSERT1(static_cast<int>(std::get<1>(modes.shape())) == nlocal);
+
+  if (nlines == 0) {
+    return;
+  }
+
+  if (nzpe == 1) {
+    Matrix<dcomplex> spectrum(nlines, nfft);
+    BOUT_OMP(parallel for)
+    for (int i = 0; i < nlines; ++i) {
+      std::copy(&modes(i, 0), &modes(i, 0) + nlocal, &spectrum(i, 0));
+      std::fill(&spectrum(i, 0) + nlocal, &spectrum(i, 0) + nfft, 0.0);
+    }
+
+    forEachRun(contiguousRuns(lines, nz), [&](int start, int count) {
+      fft::irfft_overwrite_input(&spectrum(start, 0), nz, count, lines[start]);
+    });
+    return;
+  }
+
+  const int mzsub = mesh->zend - mesh->zstart + 1;
+  ASSERT1(nz == nzpe * mzsub);
+
+  // The same division of the lines as in forward()
+  const auto first = [&](int p) { return (nlines * p) / nzpe; };
+  const int mine = first(zproc + 1) - first(zproc);
+
+  std::vector<int> part_counts(nzpe);
+  std::vector<int> part_displs(nzpe);
+  std::vector<int> line_counts(nzpe, mine * mzsub);
+  std::vector<int> line_displs(nzpe);
+  std::vector<int> spectrum_counts(nzpe);
+  std::vector<int> spectrum_displs(nzpe);
+  std::vector<int> mode_counts(nzpe);
+  std::vector<int> mode_displs(nzpe);
+  for (int p = 0; p < nzpe; ++p) {
+    part_counts[p] = (first(p + 1) - first(p)) * mzsub;
+    part_displs[p] = first(p) * mzsub;
+    line_displs[p] = p * mine * mzsub;
+    spectrum_counts[p] = 2 * mine * (modeStart(p + 1) - modeStart(p));
+    spectrum_displs[p] = 2 * mine * modeStart(p);
+    mode_counts[p] = 2 * (first(p + 1) - first(p)) * nlocal;
+    mode_displs[p] = 2 * first(p) * nlocal;
+  }
+
+  // All the modes of this processor's share of the lines
+  Array<dcomplex> sorted(mine * nmode);
+  auto& mpi = mesh->getMpi();
+  mpi.MPI_Alltoallv(modes.begin(), mode_counts.data(), mode_displs.data(), MPI_DOUBLE,
+                    sorted.begin(), spectrum_counts.data(), spectrum_displs.data(),
+                    MPI_DOUBLE, mesh->getZcomm());
+
+  Array<BoutReal> received(mine * nz);
+  if (mine > 0) {
+    Matrix<dcomplex> spectrum(mine, nfft);
+    BOUT_OMP(parallel for)
+    for (int j = 0; j < mine; ++j) {
+      for (int p = 0; p < nzpe; ++p) {
+        const int count = modeStart(p + 1) - modeStart(p);
+        const dcomplex* block = sorted.begin() + mine * modeStart(p) + j * count;
+        std::copy(block, block + count, &spectrum(j, modeStart(p)));
+      }
+      // Filtering out all higher harmonics
+      std::fill(&spectrum(j, 0) + nmode, &spectrum(j, 0) + nfft, 0.0);
+    }
+
+    Array<BoutReal> complete(mine * nz);
+    fft::irfft_overwrite_input(&spectrum(0, 0), nz, mine, complete.begin());
+
+    BOUT_OMP(parallel for)
+    for (int j = 0; j < mine; ++j) {
+      for (int p = 0; p < nzpe; ++p) {
+        const BoutReal* part = complete.begin() + j * nz + p * mzsub;
+        std::copy(part, part + mzsub, received.begin() + line_displs[p] + j * mzsub);
+      }
+    }
+  }
+
+  Array<BoutReal> parts(nlines * mzsub);
+  mpi.MPI_Alltoallv(received.begin(), line_counts.data(), line_displs.data(), MPI_DOUBLE,
+                    parts.begin(), part_counts.data(), part_displs.data(), MPI_DOUBLE,
+                    mesh->getZcomm());
+
+  BOUT_OMP(parallel for)
+  for (int i = 0; i < nlines; ++i) {
+    std::copy(parts.begin() + i * mzsub, parts.begin() + (i + 1) * mzsub, lines[i]);
+  }
+}
+
+} // namespace bout
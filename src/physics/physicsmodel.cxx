@@ -33,12 +33,14 @@
 #undef BOUT_NO_USING_NAMESPACE_BOUTGLOBALS
 
 #include <bout/mesh.hxx>
+#include <bout/output.hxx>
 #include <bout/sys/timer.hxx>
 #include <bout/vector2d.hxx>
 #include <bout/vector3d.hxx>
 
 #include <fmt/core.h>
 
+#include <exception>
 #include <string>
 using namespace std::literals;
 
@@ -72,21 +74,48 @@ bool DataFileFacade::write() {
 }
 } // namespace bout
 
+namespace {
+/// Should output and restart files be written from a background thread?
+bool useAsyncOutput(Options& options) {
+  const bool async = options["output"]["async"]
+                         .doc("Write output and restart files from a background "
+                              "thread, while the simulation continues")
+                         .withDefault(false);
+  if (async and bout::isParallelOutput(options)) {
+    // Parallel output calls MPI from the writer thread
+    int provided = MPI_THREAD_SINGLE;
+    MPI_Query_thread(&provided);
+    if (provided < MPI_THREAD_MULTIPLE) {
+      output_warn.write("WARNING: output:async with output:parallel requires "
+                        "MPI_THREAD_MULTIPLE. Writing output synchronously\n");
+      return false;
+    }
+  }
+  return async;
+}
+} // namespace
+
 PhysicsModel::PhysicsModel()
     : mesh(bout::globals::mesh),
-      output_file(bout::getOutputFilename(Options::root()),
+      output_file(bout::getDefaultOutputFilename(Options::root()),
                   Options::root()["append"]
                           .doc("Add output data to existing (dump) files?")
                           .withDefault(false)
                       ? bout::OptionsNetCDF::FileMode::append
-                      : bout::OptionsNetCDF::FileMode::replace),
+                      : bout::OptionsNetCDF::FileMode::replace,
+                  bout::isParallelOutput(Options::root())),
       output_enabled(Options::root()["output"]["enabled"]
                          .doc("Write output files")
                          .withDefault(true)),
       restart_file(bout::getRestartFilename(Options::root())),
       restart_enabled(Options::root()["restart_files"]["enabled"]
                           .doc("Write restart files")
-                          .withDefault(true)) {}
+                          .withDefault(true)),
+      writer(useAsyncOutput(Options::root())) {
+  output_file.setStorage(bout::getNetCDFStorage(Options::root()["output"]));
+  // Restarting needs the exact values
+  restart_file.setStorage(bout::getNetCDFStorage(Options::root()["restart_files"], true));
+}
 
 void PhysicsModel::initialise(Solver* s) {
   if (initialised) {
@@ -187,7 +216,8 @@ int PhysicsModel::postInit(bool restarting) {
     restart_options["BOUT_VERSION"].force(bout::version::as_double, "PhysicsModel");
 
     // Write _everything_ to restart file
-    restart_file.write(restart_options);
+    Timer time("io");
+    writer.write(restart_file, restart_options);
   }
 
   // Add monitor to the solver which calls restart.write() and
@@ -219,7 +249,8 @@ void PhysicsModel::restartVars(Options& options) {
 
 void PhysicsModel::writeRestartFile() {
   if (restart_enabled) {
-    restart_file.write(restart_options);
+    Timer time("io");
+    writer.write(restart_file, restart_options);
   }
 }
 
@@ -227,21 +258,30 @@ void PhysicsModel::writeOutputFile() { writeOutputFile(output_options); }
 
 void PhysicsModel::writeOutputFile(const Options& options) {
   if (output_enabled) {
-    output_file.write(options, "t");
+    Timer time("io");
+    writer.write(output_file, options, "t");
   }
 }
 
 void PhysicsModel::writeOutputFile(const Options& options,
                                    const std::string& time_dimension) {
   if (output_enabled) {
-    output_file.write(options, time_dimension);
+    Timer time("io");
+    writer.write(output_file, options, time_dimension);
   }
 }
 
-void PhysicsModel::finishOutputTimestep() const {
+void PhysicsModel::finishOutputTimestep() {
+  Timer time("io");
   if (output_enabled) {
-    output_file.verifyTimesteps();
+    writer.verifyTimesteps(output_file);
   }
+  writer.finishStep();
+}
+
+void PhysicsModel::flushOutput() {
+  Timer time("io");
+  writer.flush();
 }
 
 int PhysicsModel::PhysicsModelMonitor::call(Solver* solver, BoutReal simtime,
@@ -263,3 +303,14 @@ int PhysicsModel::PhysicsModelMonitor::call(Solver* solver, BoutReal simtime,
   // Call user output monitor
   return model->outputMonitor(simtime, iteration, nout);
 }
+
+void PhysicsModel::PhysicsModelMonitor::cleanup() {
+  // This may be called while handling another exception in
+  // Solver::call_monitors, so report any error from the writer
+  // rather than throwing it
+  try {
+    model->flushOutput();
+  } catch (const std::exception& e) {
+    output_error.write("Error writing output: {:s}\n", e.what());
+  }
+}
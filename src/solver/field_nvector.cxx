@@ -0,0 +1,444 @@
+#include "bout/build_defines.hxx"
+
+#if BOUT_HAS_SUNDIALS
+
+#include "bout/field_nvector.hxx"
+
+#include "bout/assert.hxx"
+#include "bout/boutexception.hxx"
+#include "bout/globals.hxx"
+#include "bout/mpi_wrapper.hxx"
+#include "bout/region.hxx"
+#include "bout/unused.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+
+namespace bout {
+
+#if SUNDIALS_VERSION_MAJOR < 5
+
+N_Vector createFieldNVector(SolverFields UNUSED(fields), MPI_Comm UNUSED(comm),
+                            sundials::Context& UNUSED(ctx)) {
+  throw BoutException("Solving for the fields directly requires SUNDIALS 5 or later");
+}
+
+bool isFieldNVector(N_Vector UNUSED(v)) { return false; }
+
+SolverFields& getFieldNVectorFields(N_Vector UNUSED(v)) {
+  throw BoutException("Solving for the fields directly requires SUNDIALS 5 or later");
+}
+
+#else
+
+namespace {
+struct FieldNVectorContent {
+  SolverFields fields;
+  MPI_Comm comm;
+  sunindextype local_length;
+  sunindextype global_length;
+};
+
+FieldNVectorContent& content(N_Vector v) {
+  return *static_cast<FieldNVectorContent*>(v->content);
+}
+
+/// Call \p function for each variable, with its region and the
+/// fields of that variable in \p x and each of \p others
+template <typename Function, typename... Vectors>
+void forEachVariable(Function&& function, N_Vector x, Vectors... others) {
+  auto& fields = content(x).fields;
+  const auto& regions = *fields.regions;
+  for (std::size_t i = 0; i < fields.f2d.size(); ++i) {
+    function(regions.f2d[i], fields.f2d[i], content(others).fields.f2d[i]...);
+  }
+  for (std::size_t i = 0; i < fields.f3d.size(); ++i) {
+    function(regions.f3d[i], fields.f3d[i], content(others).fields.f3d[i]...);
+  }
+}
+
+/// Reduce \p local over all processors of \p x
+BoutReal allReduce(N_Vector x, BoutReal local, MPI_Op op) {
+  BoutReal result{0.0};
+  bout::globals::mpi->MPI_Allreduce(&local, &result, 1, MPI_DOUBLE, op, content(x).comm);
+  return result;
+}
+
+N_Vector_ID nvGetVectorID(N_Vector UNUSED(v)) { return SUNDIALS_NVEC_CUSTOM; }
+
+void nvDestroy(N_Vector v) {
+  if (v == nullptr) {
+    return;
+  }
+  delete static_cast<FieldNVectorContent*>(v->content);
+  v->content = nullptr;
+  N_VFreeEmpty(v);
+}
+
+N_Vector nvClone(N_Vector w) {
+#if SUNDIALS_VERSION_MAJOR < 6
+  N_Vector v = N_VNewEmpty();
+#else
+  N_Vector v = N_VNewEmpty(w->sunctx);
+#endif
+  if (v == nullptr) {
+    return nullptr;
+  }
+  if (N_VCopyOps(w, v) != 0) {
+    N_VFreeEmpty(v);
+    return nullptr;
+  }
+  // Called from SUNDIALS, so exceptions can't be allowed to escape:
+  // report failure by returning nullptr, as the SUNDIALS vectors do
+  try {
+    // Copying the fields shares their data, so make it unique. The
+    // values don't matter, but this keeps the guard cells sensible
+    auto clone = std::make_unique<FieldNVectorContent>(content(w));
+    for (auto& f : clone->fields.f2d) {
+      f.allocate();
+    }
+    for (auto& f : clone->fields.f3d) {
+      f.allocate();
+    }
+    v->content = clone.release();
+  } catch (const std::exception&) {
+    N_VFreeEmpty(v);
+    return nullptr;
+  }
+  return v;
+}
+
+#if SUNDIALS_VERSION_MAJOR < 7
+void* nvGetCommunicator(N_Vector v) { return &content(v).comm; }
+#else
+SUNComm nvGetCommunicator(N_Vector v) { return content(v).comm; }
+#endif
+
+sunindextype nvGetLength(N_Vector v) { return content(v).global_length; }
+
+// The outputs of the operations below may share their data with the
+// evolving variables, which is made unique before writing to it with
+// `allocate`
+
+void nvLinearSum(BoutReal a, N_Vector x, BoutReal b, N_Vector y, N_Vector z) {
+  forEachVariable(
+      [a, b](const auto& region, const auto& xf, const auto& yf, auto& zf) {
+        zf.allocate();
+        BOUT_FOR(i, region) { zf[i] = a * xf[i] + b * yf[i]; }
+      },
+      x, y, z);
+}
+
+void nvConst(BoutReal c, N_Vector z) {
+  forEachVariable(
+      [c](const auto& region, auto& zf) {
+        zf.allocate();
+        BOUT_FOR(i, region) { zf[i] = c; }
+      },
+      z);
+}
+
+void nvProd(N_Vector x, N_Vector y, N_Vector z) {
+  forEachVariable(
+      [](const auto& region, const auto& xf, const auto& yf, auto& zf) {
+        zf.allocate();
+        BOUT_FOR(i, region) { zf[i] = xf[i] * yf[i]; }
+      },
+      x, y, z);
+}
+
+void nvDiv(N_Vector x, N_Vector y, N_Vector z) {
+  forEachVariable(
+      [](const auto& region, const auto& xf, const auto& yf, auto& zf) {
+        zf.allocate();
+        BOUT_FOR(i, region) { zf[i] = xf[i] / yf[i]; }
+      },
+      x, y, z);
+}
+
+void nvScale(BoutReal c, N_Vector x, N_Vector z) {
+  forEachVariable(
+      [c](const auto& region, const auto& xf, auto& zf) {
+        zf.allocate();
+        BOUT_FOR(i, region) { zf[i] = c * xf[i]; }
+      },
+      x, z);
+}
+
+void nvAbs(N_Vector x, N_Vector z) {
+  forEachVariable(
+      [](const auto& region, const auto& xf, auto& zf) {
+        zf.allocate();
+        BOUT_FOR(i, region) { zf[i] = std::abs(xf[i]); }
+      },
+      x, z);
+}
+
+void nvInv(N_Vector x, N_Vector z) {
+  forEachVariable(
+      [](const auto& region, const auto& xf, auto& zf) {
+        zf.allocate();
+        BOUT_FOR(i, region) { zf[i] = 1.0 / xf[i]; }
+      },
+      x, z);
+}
+
+void nvAddConst(N_Vector x, BoutReal b, N_Vector z) {
+  forEachVariable(
+      [b](const auto& region, const auto& xf, auto& zf) {
+        zf.allocate();
+        BOUT_FOR(i, region) { zf[i] = xf[i] + b; }
+      },
+      x, z);
+}
+
+void nvCompare(BoutReal c, N_Vector x, N_Vector z) {
+  forEachVariable(
+      [c](const auto& region, const auto& xf, auto& zf) {
+        zf.allocate();
+        BOUT_FOR(i, region) { zf[i] = (std::abs(xf[i]) >= c) ? 1.0 : 0.0; }
+      },
+      x, z);
+}
+
+BoutReal nvDotProd(N_Vector x, N_Vector y) {
+  BoutReal sum = 0.0;
+  forEachVariable(
+      [&sum](const auto& region, const auto& xf, const auto& yf) {
+        BoutReal local = 0.0;
+        BOUT_FOR_OMP(i, region, parallel for reduction(+:local)) {
+          local += xf[i] * yf[i];
+        }
+        sum += local;
+      },
+      x, y);
+  return allReduce(x, sum, MPI_SUM);
+}
+
+BoutReal nvMaxNorm(N_Vector x) {
+  BoutReal result = 0.0;
+  forEachVariable(
+      [&result](const auto& region, const auto& xf) {
+        BoutReal local = 0.0;
+        BOUT_FOR_OMP(i, region, parallel for reduction(max:local)) {
+          local = std::max(local, std::abs(xf[i]));
+        }
+        result = std::max(result, local);
+      },
+      x);
+  return allReduce(x, result, MPI_MAX);
+}
+
+/// Sum of (x * w)^2 over the points where \p mask is positive, or all
+/// points if \p mask is null
+BoutReal weightedSumSquares(N_Vector x, N_Vector w, N_Vector mask) {
+  BoutReal sum = 0.0;
+  if (mask == nullptr) {
+    forEachVariable(
+        [&sum](const auto& region, const auto& xf, const auto& wf) {
+          BoutReal local = 0.0;
+          BOUT_FOR_OMP(i, region, parallel for reduction(+:local)) {
+            const BoutReal value = xf[i] * wf[i];
+            local += value * value;
+          }
+          sum += local;
+        },
+        x, w);
+  } else {
+    forEachVariable(
+        [&sum](const auto& region, const auto& xf, const auto& wf, const auto& mf) {
+          BoutReal local = 0.0;
+          BOUT_FOR_OMP(i, region, parallel for reduction(+:local)) {
+            if (mf[i] > 0.0) {
+              const BoutReal value = xf[i] * wf[i];
+              local += value * value;
+            }
+          }
+          sum += local;
+        },
+        x, w, mask);
+  }
+  return allReduce(x, sum, MPI_SUM);
+}
+
+BoutReal nvWrmsNorm(N_Vector x, N_Vector w) {
+  return std::sqrt(weightedSumSquares(x, w, nullptr)
+                   / static_cast<BoutReal>(content(x).global_length));
+}
+
+BoutReal nvWrmsNormMask(N_Vector x, N_Vector w, N_Vector id) {
+  return std::sqrt(weightedSumSquares(x, w, id)
+                   / static_cast<BoutReal>(content(x).global_length));
+}
+
+BoutReal nvWL2Norm(N_Vector x, N_Vector w) {
+  return std::sqrt(weightedSumSquares(x, w, nullptr));
+}
+
+BoutReal nvMin(N_Vector x) {
+  BoutReal result = std::numeric_limits<BoutReal>::max();
+  forEachVariable(
+      [&result](const auto& region, const auto& xf) {
+        BoutReal local = std::numeric_limits<BoutReal>::max();
+        BOUT_FOR_OMP(i, region, parallel for reduction(min:local)) {
+          local = std::min(local, xf[i]);
+        }
+        result = std::min(result, local);
+      },
+      x);
+  return allReduce(x, result, MPI_MIN);
+}
+
+BoutReal nvL1Norm(N_Vector x) {
+  BoutReal sum = 0.0;
+  forEachVariable(
+      [&sum](const auto& region, const auto& xf) {
+        BoutReal local = 0.0;
+        BOUT_FOR_OMP(i, region, parallel for reduction(+:local)) {
+          local += std::abs(xf[i]);
+        }
+        sum += local;
+      },
+      x);
+  return allReduce(x, sum, MPI_SUM);
+}
+
+sundials_bool_type nvInvTest(N_Vector x, N_Vector z) {
+  // Number of zeros, so that it can be reduced with a sum
+  BoutReal zeros = 0.0;
+  forEachVariable(
+      [&zeros](const auto& region, const auto& xf, auto& zf) {
+        zf.allocate();
+        BoutReal local = 0.0;
+        BOUT_FOR_OMP(i, region, parallel for reduction(+:local)) {
+          if (xf[i] == 0.0) {
+            local += 1.0;
+          } else {
+            zf[i] = 1.0 / xf[i];
+          }
+        }
+        zeros += local;
+      },
+      x, z);
+  return static_cast<sundials_bool_type>(allReduce(x, zeros, MPI_SUM) == 0.0);
+}
+
+sundials_bool_type nvConstrMask(N_Vector c, N_Vector x, N_Vector m) {
+  // Number of failed constraints, so that it can be reduced with a sum
+  BoutReal failures = 0.0;
+  forEachVariable(
+      [&failures](const auto& region, const auto& cf, const auto& xf, auto& mf) {
+        mf.allocate();
+        BoutReal local = 0.0;
+        BOUT_FOR_OMP(i, region, parallel for reduction(+:local)) {
+          mf[i] = 0.0;
+          const BoutReal constraint = cf[i];
+          // Constraint values of +/-2 mean x must be strictly
+          // positive/negative, +/-1 mean x must not be
+          // negative/positive, and 0 means no constraint
+          const bool test =
+              (std::abs(constraint) > 1.5 and xf[i] * constraint <= 0.0)
+              or (std::abs(constraint) > 0.5 and xf[i] * constraint < 0.0);
+          if (test) {
+            mf[i] = 1.0;
+            local += 1.0;
+          }
+        }
+        failures += local;
+      },
+      c, x, m);
+  return static_cast<sundials_bool_type>(allReduce(x, failures, MPI_SUM) == 0.0);
+}
+
+BoutReal nvMinQuotient(N_Vector num, N_Vector denom) {
+  constexpr BoutReal big = std::numeric_limits<BoutReal>::max();
+  BoutReal result = big;
+  forEachVariable(
+      [&result](const auto& region, const auto& nf, const auto& df) {
+        BoutReal local = big;
+        BOUT_FOR_OMP(i, region, parallel for reduction(min:local)) {
+          if (df[i] != 0.0) {
+            local = std::min(local, nf[i] / df[i]);
+          }
+        }
+        result = std::min(result, local);
+      },
+      num, denom);
+  return allReduce(num, result, MPI_MIN);
+}
+} // namespace
+
+N_Vector createFieldNVector(SolverFields fields, MPI_Comm comm, sundials::Context& ctx) {
+  std::int64_t local_length = 0;
+  for (const auto& region : fields.regions->f2d) {
+    local_length += region.size();
+  }
+  for (const auto& region : fields.regions->f3d) {
+    local_length += region.size();
+  }
+  std::int64_t global_length = 0;
+  if (bout::globals::mpi->MPI_Allreduce(&local_length, &global_length, 1, MPI_INT64_T,
+                                        MPI_SUM, comm)
+      != MPI_SUCCESS) {
+    throw BoutException("MPI_Allreduce failed in createFieldNVector");
+  }
+
+  // Created before the vector, so that nothing leaks if it throws
+  auto vector_content = std::make_unique<FieldNVectorContent>(
+      FieldNVectorContent{std::move(fields), comm,
+                          static_cast<sunindextype>(local_length),
+                          static_cast<sunindextype>(global_length)});
+
+  N_Vector v = callWithSUNContext(N_VNewEmpty, ctx);
+  if (v == nullptr) {
+    throw BoutException("SUNDIALS memory allocation failed\n");
+  }
+
+  v->content = vector_content.release();
+
+  v->ops->nvgetvectorid = nvGetVectorID;
+  v->ops->nvclone = nvClone;
+  v->ops->nvdestroy = nvDestroy;
+  v->ops->nvgetcommunicator = nvGetCommunicator;
+  v->ops->nvgetlength = nvGetLength;
+  v->ops->nvlinearsum = nvLinearSum;
+  v->ops->nvconst = nvConst;
+  v->ops->nvprod = nvProd;
+  v->ops->nvdiv = nvDiv;
+  v->ops->nvscale = nvScale;
+  v->ops->nvabs = nvAbs;
+  v->ops->nvinv = nvInv;
+  v->ops->nvaddconst = nvAddConst;
+  v->ops->nvdotprod = nvDotProd;
+  v->ops->nvmaxnorm = nvMaxNorm;
+  v->ops->nvwrmsnorm = nvWrmsNorm;
+  v->ops->nvwrmsnormmask = nvWrmsNormMask;
+  v->ops->nvmin = nvMin;
+  v->ops->nvwl2norm = nvWL2Norm;
+  v->ops->nvl1norm = nvL1Norm;
+  v->ops->nvcompare = nvCompare;
+  v->ops->nvinvtest = nvInvTest;
+  v->ops->nvconstrmask = nvConstrMask;
+  v->ops->nvminquotient = nvMinQuotient;
+
+  return v;
+}
+
+bool isFieldNVector(N_Vector v) {
+  return v != nullptr and v->ops->nvclone == nvClone;
+}
+
+SolverFields& getFieldNVectorFields(N_Vector v) {
+  ASSERT1(isFieldNVector(v));
+  return content(v).fields;
+}
+
+#endif // SUNDIALS_VERSION_MAJOR < 5
+
+} // namespace bout
+
+#endif // BOUT_HAS_SUNDIALS
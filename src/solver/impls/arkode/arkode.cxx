@@ -37,6 +37,7 @@
 #include "bout/boutexception.hxx"
 #include "bout/field2d.hxx"
 #include "bout/field3d.hxx"
+#include "bout/field_nvector.hxx"
 #include "bout/globals.hxx"
 #include "bout/mesh.hxx"
 #include "bout/mpi_wrapper.hxx"
@@ -145,6 +146,10 @@ ArkodeSolver::ArkodeSolver(Options* opts)
                        .withDefault(false)),
       optimize(
           (*options)["optimize"].doc("Use ARKode optimal parameters").withDefault(false)),
+      zero_copy((*options)["zero_copy"]
+                    .doc("Integrate the evolving fields directly, instead of copying "
+                         "them into and out of a SUNDIALS vector")
+                    .withDefault(false)),
       suncontext(createSUNContext(BoutComm::get())) {
   has_constraints = false; // This solver doesn't have constraints
 
@@ -197,13 +202,18 @@ int ArkodeSolver::init() {
                n2Dvars(), neq, local_N);
 
   // Allocate memory
-  uvec = callWithSUNContext(N_VNew_Parallel, suncontext, BoutComm::get(), local_N, neq);
+  if (zero_copy) {
+    output.write("\tIntegrating the fields directly\n");
+    uvec = bout::createFieldNVector(create_solver_fields(), BoutComm::get(), suncontext);
+  } else {
+    uvec = callWithSUNContext(N_VNew_Parallel, suncontext, BoutComm::get(), local_N, neq);
+  }
   if (uvec == nullptr) {
     throw BoutException("SUNDIALS memory allocation failed\n");
   }
 
   // Put the variables into uvec
-  save_vars(N_VGetArrayPointer(uvec));
+  bout::visitNVector(uvec, [this](auto&& udata) { save_vars(udata); });
 
   ASSERT1(solve_explicit or solve_implicit);
 
@@ -347,7 +357,9 @@ int ArkodeSolver::init() {
       throw BoutException("SUNDIALS memory allocation (abstol vector) failed\n");
     }
 
-    set_abstol_values(N_VGetArrayPointer(abstolvec), f2dtols, f3dtols);
+    bout::visitNVector(abstolvec, [&](auto&& abstoldata) {
+      set_field_values(abstoldata, f2dtols, f3dtols);
+    });
 
     if (ARKStepSVtolerances(arkode_mem, reltol, abstolvec) != ARK_SUCCESS) {
       throw BoutException("ARKStepSVtolerances failed\n");
@@ -422,6 +434,11 @@ int ArkodeSolver::init() {
         // Previous implementation was equivalent to:
         //   int MXSUB = mesh->xend - mesh->xstart + 1;
         //   int band_width_default = n3Dvars()*(MXSUB+2);
+        if (zero_copy) {
+          throw BoutException("The BBD preconditioner can't be used with "
+                              "solver:zero_copy = true");
+        }
+
         const int band_width_default = std::accumulate(
             begin(f3d), end(f3d), 0, [](int acc, const VarStr<Field3D>& fvar) {
               Mesh* localmesh = fvar.var->getMesh();
@@ -565,6 +582,11 @@ BoutReal ArkodeSolver::run(BoutReal tout) {
         return -1.0;
       }
 
+      if (zero_copy) {
+        // The variables aren't kept between RHS calls
+        load_vars(bout::getFieldNVectorFields(uvec));
+      }
+
       // Call timestep monitor
       call_timestep_monitors(internal_time, internal_time - last_time);
     }
@@ -574,7 +596,7 @@ BoutReal ArkodeSolver::run(BoutReal tout) {
   }
 
   // Copy variables
-  load_vars(N_VGetArrayPointer(uvec));
+  bout::visitNVector(uvec, [this](auto&& udata) { load_vars(udata); });
   // Call rhs function to get extra variables at this time
   run_rhs(simtime);
   // run_diffusive(simtime);
@@ -591,11 +613,11 @@ BoutReal ArkodeSolver::run(BoutReal tout) {
  * Explicit RHS function du = F_E(t, u)
  **************************************************************************/
 
-void ArkodeSolver::rhs_e(BoutReal t, BoutReal* udata, BoutReal* dudata) {
+void ArkodeSolver::rhs_e(BoutReal t, N_Vector u, N_Vector du) {
   TRACE("Running RHS: ArkodeSolver::rhs_e({:e})", t);
 
-  // Load state from udata
-  load_vars(udata);
+  // Load state from u
+  bout::visitNVector(u, [this](auto&& udata) { load_vars(udata); });
 
   // Get the current timestep
   // Note: ARKodeGetCurrentStep updated too late in older versions
@@ -604,64 +626,79 @@ void ArkodeSolver::rhs_e(BoutReal t, BoutReal* udata, BoutReal* dudata) {
   // Call RHS function
   run_convective(t);
 
-  // Save derivatives to dudata
-  save_derivs(dudata);
+  // Save derivatives to du
+  bout::visitNVector(du, [this](auto&& dudata) { save_derivs(dudata); });
+
+  if (zero_copy) {
+    release_vars();
+  }
 }
 
 /**************************************************************************
  *   Implicit RHS function du = F_I(t, u)
  **************************************************************************/
 
-void ArkodeSolver::rhs_i(BoutReal t, BoutReal* udata, BoutReal* dudata) {
+void ArkodeSolver::rhs_i(BoutReal t, N_Vector u, N_Vector du) {
   TRACE("Running RHS: ArkodeSolver::rhs_i({:e})", t);
 
-  load_vars(udata);
+  bout::visitNVector(u, [this](auto&& udata) { load_vars(udata); });
   ARKStepGetLastStep(arkode_mem, &hcur);
   // Call Implicit RHS function
   run_diffusive(t);
-  save_derivs(dudata);
+  bout::visitNVector(du, [this](auto&& dudata) { save_derivs(dudata); });
+
+  if (zero_copy) {
+    release_vars();
+  }
 }
 
 /**************************************************************************
  *   Full  RHS function du = F(t, u)
  **************************************************************************/
-void ArkodeSolver::rhs(BoutReal t, BoutReal* udata, BoutReal* dudata) {
+void ArkodeSolver::rhs(BoutReal t, N_Vector u, N_Vector du) {
   TRACE("Running RHS: ArkodeSolver::rhs({:e})", t);
 
-  load_vars(udata);
+  bout::visitNVector(u, [this](auto&& udata) { load_vars(udata); });
   ARKStepGetLastStep(arkode_mem, &hcur);
   // Call Implicit RHS function
   run_rhs(t);
-  save_derivs(dudata);
+  bout::visitNVector(du, [this](auto&& dudata) { save_derivs(dudata); });
+
+  if (zero_copy) {
+    release_vars();
+  }
 }
 
 /**************************************************************************
  * Preconditioner function
  **************************************************************************/
 
-void ArkodeSolver::pre(BoutReal t, BoutReal gamma, BoutReal delta, BoutReal* udata,
-                       BoutReal* rvec, BoutReal* zvec) {
+void ArkodeSolver::pre(BoutReal t, BoutReal gamma, BoutReal delta, N_Vector u,
+                       N_Vector rvec, N_Vector zvec) {
   TRACE("Running preconditioner: ArkodeSolver::pre({:e})", t);
 
   const BoutReal tstart = bout::globals::mpi->MPI_Wtime();
 
   if (!hasPreconditioner()) {
     // Identity (but should never happen)
-    const auto length = N_VGetLocalLength_Parallel(uvec);
-    std::copy(rvec, rvec + length, zvec);
+    N_VScale(1.0, rvec, zvec);
     return;
   }
 
-  // Load state from udata (as with res function)
-  load_vars(udata);
+  // Load state from u (as with res function)
+  bout::visitNVector(u, [this](auto&& udata) { load_vars(udata); });
 
   // Load vector to be inverted into F_vars
-  load_derivs(rvec);
+  bout::visitNVector(rvec, [this](auto&& rdata) { load_derivs(rdata); });
 
   runPreconditioner(t, gamma, delta);
 
   // Save the solution from F_vars
-  save_derivs(zvec);
+  bout::visitNVector(zvec, [this](auto&& zdata) { save_derivs(zdata); });
+
+  if (zero_copy) {
+    release_vars();
+  }
 
   pre_Wtime += bout::globals::mpi->MPI_Wtime() - tstart;
   pre_ncalls++;
@@ -671,24 +708,28 @@ void ArkodeSolver::pre(BoutReal t, BoutReal gamma, BoutReal delta, BoutReal* uda
  * Jacobian-vector multiplication function
  **************************************************************************/
 
-void ArkodeSolver::jac(BoutReal t, BoutReal* ydata, BoutReal* vdata, BoutReal* Jvdata) {
+void ArkodeSolver::jac(BoutReal t, N_Vector y, N_Vector v, N_Vector Jv) {
   TRACE("Running Jacobian: ArkodeSolver::jac({:e})", t);
 
   if (not hasJacobian()) {
     throw BoutException("No jacobian function supplied!\n");
   }
 
-  // Load state from ydate
-  load_vars(ydata);
+  // Load state from y
+  bout::visitNVector(y, [this](auto&& ydata) { load_vars(ydata); });
 
   // Load vector to be multiplied into F_vars
-  load_derivs(vdata);
+  bout::visitNVector(v, [this](auto&& vdata) { load_derivs(vdata); });
 
   // Call function
   runJacobian(t);
 
   // Save Jv from vars
-  save_derivs(Jvdata);
+  bout::visitNVector(Jv, [this](auto&& Jvdata) { save_derivs(Jvdata); });
+
+  if (zero_copy) {
+    release_vars();
+  }
 }
 
 /**************************************************************************
@@ -699,14 +740,11 @@ void ArkodeSolver::jac(BoutReal t, BoutReal* ydata, BoutReal* vdata, BoutReal* J
 namespace {
 int arkode_rhs_explicit(BoutReal t, N_Vector u, N_Vector du, void* user_data) {
 
-  BoutReal* udata = N_VGetArrayPointer(u);
-  BoutReal* dudata = N_VGetArrayPointer(du);
-
   auto* s = static_cast<ArkodeSolver*>(user_data);
 
   // Calculate RHS function
   try {
-    s->rhs_e(t, udata, dudata);
+    s->rhs_e(t, u, du);
   } catch (BoutRhsFail& error) {
     return 1;
   }
@@ -715,14 +753,11 @@ int arkode_rhs_explicit(BoutReal t, N_Vector u, N_Vector du, void* user_data) {
 
 int arkode_rhs_implicit(BoutReal t, N_Vector u, N_Vector du, void* user_data) {
 
-  BoutReal* udata = N_VGetArrayPointer(u);
-  BoutReal* dudata = N_VGetArrayPointer(du);
-
   auto* s = static_cast<ArkodeSolver*>(user_data);
 
   // Calculate RHS function
   try {
-    s->rhs_i(t, udata, dudata);
+    s->rhs_i(t, u, du);
   } catch (BoutRhsFail& error) {
     return 1;
   }
@@ -731,14 +766,11 @@ int arkode_rhs_implicit(BoutReal t, N_Vector u, N_Vector du, void* user_data) {
 
 int arkode_rhs(BoutReal t, N_Vector u, N_Vector du, void* user_data) {
 
-  BoutReal* udata = N_VGetArrayPointer(u);
-  BoutReal* dudata = N_VGetArrayPointer(du);
-
   auto* s = static_cast<ArkodeSolver*>(user_data);
 
   // Calculate RHS function
   try {
-    s->rhs(t, udata, dudata);
+    s->rhs(t, u, du);
   } catch (BoutRhsFail& error) {
     return 1;
   }
@@ -754,14 +786,10 @@ int arkode_bbd_rhs(sunindextype UNUSED(Nlocal), BoutReal t, N_Vector u, N_Vector
 /// Preconditioner function
 int arkode_pre(BoutReal t, N_Vector yy, N_Vector UNUSED(yp), N_Vector rvec, N_Vector zvec,
                BoutReal gamma, BoutReal delta, int UNUSED(lr), void* user_data) {
-  BoutReal* udata = N_VGetArrayPointer(yy);
-  BoutReal* rdata = N_VGetArrayPointer(rvec);
-  BoutReal* zdata = N_VGetArrayPointer(zvec);
-
   auto* s = static_cast<ArkodeSolver*>(user_data);
 
   // Calculate residuals
-  s->pre(t, gamma, delta, udata, rdata, zdata);
+  s->pre(t, gamma, delta, yy, rvec, zvec);
 
   return 0;
 }
@@ -769,60 +797,13 @@ int arkode_pre(BoutReal t, N_Vector yy, N_Vector UNUSED(yp), N_Vector rvec, N_Ve
 /// Jacobian-vector multiplication function
 int arkode_jac(N_Vector v, N_Vector Jv, BoutReal t, N_Vector y, N_Vector UNUSED(fy),
                void* user_data, N_Vector UNUSED(tmp)) {
-  BoutReal* ydata = N_VGetArrayPointer(y);   ///< System state
-  BoutReal* vdata = N_VGetArrayPointer(v);   ///< Input vector
-  BoutReal* Jvdata = N_VGetArrayPointer(Jv); ///< Jacobian*vector output
-
   auto* s = static_cast<ArkodeSolver*>(user_data);
 
-  s->jac(t, ydata, vdata, Jvdata);
+  s->jac(t, y, v, Jv);
 
   return 0;
 }
 } // namespace
 // NOLINTEND(readability-identifier-length)
 
-/**************************************************************************
- * vector abstol functions
- **************************************************************************/
-
-void ArkodeSolver::set_abstol_values(BoutReal* abstolvec_data,
-                                     std::vector<BoutReal>& f2dtols,
-                                     std::vector<BoutReal>& f3dtols) {
-  int p = 0; // Counter for location in abstolvec_data array
-
-  // All boundaries
-  for (const auto& i2d : bout::globals::mesh->getRegion2D("RGN_BNDRY")) {
-    loop_abstol_values_op(i2d, abstolvec_data, p, f2dtols, f3dtols, true);
-  }
-  // Bulk of points
-  for (const auto& i2d : bout::globals::mesh->getRegion2D("RGN_NOBNDRY")) {
-    loop_abstol_values_op(i2d, abstolvec_data, p, f2dtols, f3dtols, false);
-  }
-}
-
-void ArkodeSolver::loop_abstol_values_op(Ind2D UNUSED(i2d), BoutReal* abstolvec_data,
-                                         int& p, std::vector<BoutReal>& f2dtols,
-                                         std::vector<BoutReal>& f3dtols, bool bndry) {
-  // Loop over 2D variables
-  for (std::vector<BoutReal>::size_type i = 0; i < f2dtols.size(); i++) {
-    if (bndry && !f2d[i].evolve_bndry) {
-      continue;
-    }
-    abstolvec_data[p] = f2dtols[i];
-    p++;
-  }
-
-  for (int jz = 0; jz < bout::globals::mesh->LocalNz; jz++) {
-    // Loop over 3D variables
-    for (std::vector<BoutReal>::size_type i = 0; i < f3dtols.size(); i++) {
-      if (bndry && !f3d[i].evolve_bndry) {
-        continue;
-      }
-      abstolvec_data[p] = f3dtols[i];
-      p++;
-    }
-  }
-}
-
 #endif
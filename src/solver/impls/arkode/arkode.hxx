@@ -72,12 +72,12 @@ public:
   BoutReal run(BoutReal tout);
 
   // These functions used internally (but need to be public)
-  void rhs_e(BoutReal t, BoutReal* udata, BoutReal* dudata);
-  void rhs_i(BoutReal t, BoutReal* udata, BoutReal* dudata);
-  void rhs(BoutReal t, BoutReal* udata, BoutReal* dudata);
-  void pre(BoutReal t, BoutReal gamma, BoutReal delta, BoutReal* udata, BoutReal* rvec,
-           BoutReal* zvec);
-  void jac(BoutReal t, BoutReal* ydata, BoutReal* vdata, BoutReal* Jvdata);
+  void rhs_e(BoutReal t, N_Vector u, N_Vector du);
+  void rhs_i(BoutReal t, N_Vector u, N_Vector du);
+  void rhs(BoutReal t, N_Vector u, N_Vector du);
+  void pre(BoutReal t, BoutReal gamma, BoutReal delta, N_Vector u, N_Vector rvec,
+           N_Vector zvec);
+  void jac(BoutReal t, N_Vector y, N_Vector v, N_Vector Jv);
 
 private:
   BoutReal hcur; //< Current internal timestep
@@ -143,6 +143,8 @@ private:
   bool use_jacobian;
   /// Use ARKode optimal parameters
   bool optimize;
+  /// Integrate the evolving fields directly, without copying them
+  bool zero_copy;
 
   // Diagnostics from ARKODE
   int nsteps{0};
@@ -152,12 +154,6 @@ private:
   int npevals{0};
   int nliters{0};
 
-  void set_abstol_values(BoutReal* abstolvec_data, std::vector<BoutReal>& f2dtols,
-                         std::vector<BoutReal>& f3dtols);
-  void loop_abstol_values_op(Ind2D i2d, BoutReal* abstolvec_data, int& p,
-                             std::vector<BoutReal>& f2dtols,
-                             std::vector<BoutReal>& f3dtols, bool bndry);
-
   /// SPGMR solver structure
   SUNLinearSolver sun_solver{nullptr};
   /// Solver for implicit stages
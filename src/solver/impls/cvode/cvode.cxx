@@ -36,6 +36,7 @@
 #include "bout/boutexception.hxx"
 #include "bout/field2d.hxx"
 #include "bout/field3d.hxx"
+#include "bout/field_nvector.hxx"
 #include "bout/globals.hxx"
 #include "bout/mesh.hxx"
 #include "bout/mpi_wrapper.hxx"
@@ -132,6 +133,10 @@ CvodeSolver::CvodeSolver(Options* opts)
               .doc("Factor by which the Krylov linear solver’s convergence test constant "
                    "is reduced from the nonlinear solver test constant.")
               .withDefault(0.05)),
+      zero_copy((*options)["zero_copy"]
+                    .doc("Integrate the evolving fields directly, instead of copying "
+                         "them into and out of a SUNDIALS vector")
+                    .withDefault(false)),
       suncontext(createSUNContext(BoutComm::get())) {
   has_constraints = false; // This solver doesn't have constraints
   canReset = true;
@@ -190,13 +195,18 @@ int CvodeSolver::init() {
                     n3Dvars(), n2Dvars(), neq, local_N);
 
   // Allocate memory
-  uvec = callWithSUNContext(N_VNew_Parallel, suncontext, BoutComm::get(), local_N, neq);
+  if (zero_copy) {
+    output_info.write("\tIntegrating the fields directly\n");
+    uvec = bout::createFieldNVector(create_solver_fields(), BoutComm::get(), suncontext);
+  } else {
+    uvec = callWithSUNContext(N_VNew_Parallel, suncontext, BoutComm::get(), local_N, neq);
+  }
   if (uvec == nullptr) {
     throw BoutException("SUNDIALS memory allocation failed\n");
   }
 
   // Put the variables into uvec
-  save_vars(N_VGetArrayPointer(uvec));
+  bout::visitNVector(uvec, [this](auto&& udata) { save_vars(udata); });
 
   if (adams_moulton) {
     // By default use functional iteration for Adams-Moulton
@@ -266,7 +276,9 @@ int CvodeSolver::init() {
       throw BoutException("SUNDIALS memory allocation (abstol vector) failed\n");
     }
 
-    set_vector_option_values(N_VGetArrayPointer(abstolvec), f2dtols, f3dtols);
+    bout::visitNVector(abstolvec, [&](auto&& abstoldata) {
+      set_field_values(abstoldata, f2dtols, f3dtols);
+    });
 
     if (CVodeSVtolerances(cvode_mem, reltol, abstolvec) != CV_SUCCESS) {
       throw BoutException("CVodeSVtolerances failed\n");
@@ -309,8 +321,9 @@ int CvodeSolver::init() {
                           "failed\n");
     }
 
-    set_vector_option_values(N_VGetArrayPointer(constraints_vec), f2d_constraints,
-                             f3d_constraints);
+    bout::visitNVector(constraints_vec, [&](auto&& constraints_data) {
+      set_field_values(constraints_data, f2d_constraints, f3d_constraints);
+    });
 
     if (CVodeSetConstraints(cvode_mem, constraints_vec) != CV_SUCCESS) {
       throw BoutException("CVodeSetConstraints failed\n");
@@ -354,6 +367,11 @@ int CvodeSolver::init() {
       } else {
         output_info.write("\tUsing BBD preconditioner\n");
 
+        if (zero_copy) {
+          throw BoutException("The BBD preconditioner can't be used with "
+                              "solver:zero_copy = true");
+        }
+
         /// Get options
         // Compute band_width_default from actually added fields, to allow for multiple
         // Mesh objects
@@ -556,6 +574,11 @@ BoutReal CvodeSolver::run(BoutReal tout) {
                             internal_time, flag);
       }
 
+      if (zero_copy) {
+        // The variables aren't kept between RHS calls
+        load_vars(bout::getFieldNVectorFields(uvec));
+      }
+
       // Call timestep monitor
       call_timestep_monitors(internal_time, internal_time - last_time);
     }
@@ -565,7 +588,7 @@ BoutReal CvodeSolver::run(BoutReal tout) {
   }
 
   // Copy variables
-  load_vars(N_VGetArrayPointer(uvec));
+  bout::visitNVector(uvec, [this](auto&& udata) { load_vars(udata); });
 
   // Call rhs function to get extra variables at this time
   run_rhs(simtime);
@@ -582,11 +605,11 @@ BoutReal CvodeSolver::run(BoutReal tout) {
  * RHS function du = F(t, u)
  **************************************************************************/
 
-void CvodeSolver::rhs(BoutReal t, BoutReal* udata, BoutReal* dudata) {
+void CvodeSolver::rhs(BoutReal t, N_Vector u, N_Vector du) {
   TRACE("Running RHS: CvodeSolver::res({})", t);
 
-  // Load state from udata
-  load_vars(udata);
+  // Load state from u
+  bout::visitNVector(u, [this](auto&& udata) { load_vars(udata); });
 
   // Get the current timestep
   // Note: CVodeGetCurrentStep updated too late in older versions
@@ -595,40 +618,44 @@ void CvodeSolver::rhs(BoutReal t, BoutReal* udata, BoutReal* dudata) {
   // Call RHS function
   run_rhs(t);
 
-  // Save derivatives to dudata
-  save_derivs(dudata);
+  // Save derivatives to du
+  bout::visitNVector(du, [this](auto&& dudata) { save_derivs(dudata); });
+
+  if (zero_copy) {
+    release_vars();
+  }
 }
 
 /**************************************************************************
  * Preconditioner function
  **************************************************************************/
 
-void CvodeSolver::pre(BoutReal t, BoutReal gamma, BoutReal delta, BoutReal* udata,
-                      BoutReal* rvec, BoutReal* zvec) {
+void CvodeSolver::pre(BoutReal t, BoutReal gamma, BoutReal delta, N_Vector u,
+                      N_Vector rvec, N_Vector zvec) {
   TRACE("Running preconditioner: CvodeSolver::pre({})", t);
 
   BoutReal tstart = bout::globals::mpi->MPI_Wtime();
 
-  const auto length = N_VGetLocalLength_Parallel(uvec);
-
   if (!hasPreconditioner()) {
     // Identity (but should never happen)
-    for (int i = 0; i < length; i++) {
-      zvec[i] = rvec[i];
-    }
+    N_VScale(1.0, rvec, zvec);
     return;
   }
 
-  // Load state from udata (as with res function)
-  load_vars(udata);
+  // Load state from u (as with res function)
+  bout::visitNVector(u, [this](auto&& udata) { load_vars(udata); });
 
   // Load vector to be inverted into F_vars
-  load_derivs(rvec);
+  bout::visitNVector(rvec, [this](auto&& rdata) { load_derivs(rdata); });
 
   runPreconditioner(t, gamma, delta);
 
   // Save the solution from F_vars
-  save_derivs(zvec);
+  bout::visitNVector(zvec, [this](auto&& zdata) { save_derivs(zdata); });
+
+  if (zero_copy) {
+    release_vars();
+  }
 
   pre_Wtime += bout::globals::mpi->MPI_Wtime() - tstart;
   pre_ncalls++;
@@ -638,24 +665,28 @@ void CvodeSolver::pre(BoutReal t, BoutReal gamma, BoutReal delta, BoutReal* udat
  * Jacobian-vector multiplication function
  **************************************************************************/
 
-void CvodeSolver::jac(BoutReal t, BoutReal* ydata, BoutReal* vdata, BoutReal* Jvdata) {
+void CvodeSolver::jac(BoutReal t, N_Vector y, N_Vector v, N_Vector Jv) {
   TRACE("Running Jacobian: CvodeSolver::jac({})", t);
 
   if (not hasJacobian()) {
     throw BoutException("No jacobian function supplied!\n");
   }
 
-  // Load state from ydate
-  load_vars(ydata);
+  // Load state from y
+  bout::visitNVector(y, [this](auto&& ydata) { load_vars(ydata); });
 
   // Load vector to be multiplied into F_vars
-  load_derivs(vdata);
+  bout::visitNVector(v, [this](auto&& vdata) { load_derivs(vdata); });
 
   // Call function
   runJacobian(t);
 
   // Save Jv from vars
-  save_derivs(Jvdata);
+  bout::visitNVector(Jv, [this](auto&& Jvdata) { save_derivs(Jvdata); });
+
+  if (zero_copy) {
+    release_vars();
+  }
 }
 
 /**************************************************************************
@@ -666,14 +697,11 @@ void CvodeSolver::jac(BoutReal t, BoutReal* ydata, BoutReal* vdata, BoutReal* Jv
 namespace {
 int cvode_rhs(BoutReal t, N_Vector u, N_Vector du, void* user_data) {
 
-  BoutReal* udata = N_VGetArrayPointer(u);
-  BoutReal* dudata = N_VGetArrayPointer(du);
-
   auto* s = static_cast<CvodeSolver*>(user_data);
 
   // Calculate RHS function
   try {
-    s->rhs(t, udata, dudata);
+    s->rhs(t, u, du);
   } catch (BoutRhsFail& error) {
     return 1;
   }
@@ -689,14 +717,10 @@ int cvode_bbd_rhs(sunindextype UNUSED(Nlocal), BoutReal t, N_Vector u, N_Vector
 /// Preconditioner function
 int cvode_pre(BoutReal t, N_Vector yy, N_Vector UNUSED(yp), N_Vector rvec, N_Vector zvec,
               BoutReal gamma, BoutReal delta, int UNUSED(lr), void* user_data) {
-  BoutReal* udata = N_VGetArrayPointer(yy);
-  BoutReal* rdata = N_VGetArrayPointer(rvec);
-  BoutReal* zdata = N_VGetArrayPointer(zvec);
-
   auto* s = static_cast<CvodeSolver*>(user_data);
 
   // Calculate residuals
-  s->pre(t, gamma, delta, udata, rdata, zdata);
+  s->pre(t, gamma, delta, yy, rvec, zvec);
 
   return 0;
 }
@@ -704,66 +728,18 @@ int cvode_pre(BoutReal t, N_Vector yy, N_Vector UNUSED(yp), N_Vector rvec, N_Vec
 /// Jacobian-vector multiplication function
 int cvode_jac(N_Vector v, N_Vector Jv, BoutReal t, N_Vector y, N_Vector UNUSED(fy),
               void* user_data, N_Vector UNUSED(tmp)) {
-  BoutReal* ydata = N_VGetArrayPointer(y);   ///< System state
-  BoutReal* vdata = N_VGetArrayPointer(v);   ///< Input vector
-  BoutReal* Jvdata = N_VGetArrayPointer(Jv); ///< Jacobian*vector output
-
   auto* s = static_cast<CvodeSolver*>(user_data);
 
-  s->jac(t, ydata, vdata, Jvdata);
+  s->jac(t, y, v, Jv);
 
   return 0;
 }
 } // namespace
 // NOLINTEND(readability-identifier-length)
 
-/**************************************************************************
- * CVODE vector option functions
- **************************************************************************/
-
-void CvodeSolver::set_vector_option_values(BoutReal* option_data,
-                                           std::vector<BoutReal>& f2dtols,
-                                           std::vector<BoutReal>& f3dtols) {
-  int p = 0; // Counter for location in option_data array
-
-  // All boundaries
-  for (const auto& i2d : bout::globals::mesh->getRegion2D("RGN_BNDRY")) {
-    loop_vector_option_values_op(i2d, option_data, p, f2dtols, f3dtols, true);
-  }
-  // Bulk of points
-  for (const auto& i2d : bout::globals::mesh->getRegion2D("RGN_NOBNDRY")) {
-    loop_vector_option_values_op(i2d, option_data, p, f2dtols, f3dtols, false);
-  }
-}
-
-void CvodeSolver::loop_vector_option_values_op(Ind2D UNUSED(i2d), BoutReal* option_data,
-                                               int& p, std::vector<BoutReal>& f2dtols,
-                                               std::vector<BoutReal>& f3dtols,
-                                               bool bndry) {
-  // Loop over 2D variables
-  for (std::vector<BoutReal>::size_type i = 0; i < f2dtols.size(); i++) {
-    if (bndry && !f2d[i].evolve_bndry) {
-      continue;
-    }
-    option_data[p] = f2dtols[i];
-    p++;
-  }
-
-  for (int jz = 0; jz < bout::globals::mesh->LocalNz; jz++) {
-    // Loop over 3D variables
-    for (std::vector<BoutReal>::size_type i = 0; i < f3dtols.size(); i++) {
-      if (bndry && !f3d[i].evolve_bndry) {
-        continue;
-      }
-      option_data[p] = f3dtols[i];
-      p++;
-    }
-  }
-}
-
 void CvodeSolver::resetInternalFields() {
   TRACE("CvodeSolver::resetInternalFields");
-  save_vars(N_VGetArrayPointer(uvec));
+  bout::visitNVector(uvec, [this](auto&& udata) { save_vars(udata); });
 
   if (CVodeReInit(cvode_mem, simtime, uvec) != CV_SUCCESS) {
     throw BoutException("CVodeReInit failed\n");
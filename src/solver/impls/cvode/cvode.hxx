@@ -68,10 +68,10 @@ public:
   void resetInternalFields() override;
 
   // These functions used internally (but need to be public)
-  void rhs(BoutReal t, BoutReal* udata, BoutReal* dudata);
-  void pre(BoutReal t, BoutReal gamma, BoutReal delta, BoutReal* udata, BoutReal* rvec,
-           BoutReal* zvec);
-  void jac(BoutReal t, BoutReal* ydata, BoutReal* vdata, BoutReal* Jvdata);
+  void rhs(BoutReal t, N_Vector u, N_Vector du);
+  void pre(BoutReal t, BoutReal gamma, BoutReal delta, N_Vector u, N_Vector rvec,
+           N_Vector zvec);
+  void jac(BoutReal t, N_Vector y, N_Vector v, N_Vector Jv);
 
 private:
   BoutReal hcur; //< Current internal timestep
@@ -124,6 +124,8 @@ private:
   bool use_jacobian;
   BoutReal cvode_nonlinear_convergence_coef;
   BoutReal cvode_linear_convergence_coef;
+  /// Integrate the evolving fields directly, without copying them
+  bool zero_copy;
 
   // Diagnostics from CVODE
   int nsteps{0};
@@ -139,11 +141,6 @@ private:
 
   bool cvode_initialised = false;
 
-  void set_vector_option_values(BoutReal* option_data, std::vector<BoutReal>& f2dtols,
-                                std::vector<BoutReal>& f3dtols);
-  void loop_vector_option_values_op(Ind2D i2d, BoutReal* option_data, int& p,
-                                    std::vector<BoutReal>& f2dtols,
-                                    std::vector<BoutReal>& f3dtols, bool bndry);
   template <class FieldType>
   std::vector<BoutReal> create_constraints(const std::vector<VarStr<FieldType>>& fields);
 
@@ -37,6 +37,7 @@
 #include "bout/boutcomm.hxx"
 #include "bout/boutexception.hxx"
 #include "bout/field3d.hxx"
+#include "bout/field_nvector.hxx"
 #include "bout/globals.hxx"
 #include "bout/mesh.hxx"
 #include "bout/mpi_wrapper.hxx"
@@ -80,6 +81,10 @@ IdaSolver::IdaSolver(Options* opts)
       correct_start((*options)["correct_start"]
                         .doc("Correct the initial values")
                         .withDefault(true)),
+      zero_copy((*options)["zero_copy"]
+                    .doc("Integrate the evolving fields directly, instead of copying "
+                         "them into and out of a SUNDIALS vector")
+                    .withDefault(false)),
       suncontext(createSUNContext(BoutComm::get())) {
   has_constraints = true; // This solver has constraints
 }
@@ -123,7 +128,12 @@ int IdaSolver::init() {
                neq, local_N);
 
   // Allocate memory
-  uvec = callWithSUNContext(N_VNew_Parallel, suncontext, BoutComm::get(), local_N, neq);
+  if (zero_copy) {
+    output.write("\tIntegrating the fields directly\n");
+    uvec = bout::createFieldNVector(create_solver_fields(), BoutComm::get(), suncontext);
+  } else {
+    uvec = callWithSUNContext(N_VNew_Parallel, suncontext, BoutComm::get(), local_N, neq);
+  }
   if (uvec == nullptr) {
     throw BoutException("SUNDIALS memory allocation failed\n");
   }
@@ -137,16 +147,16 @@ int IdaSolver::init() {
   }
 
   // Put the variables into uvec
-  save_vars(N_VGetArrayPointer(uvec));
+  bout::visitNVector(uvec, [this](auto&& udata) { save_vars(udata); });
 
   // Get the starting time derivative
   run_rhs(simtime);
 
   // Put the time-derivatives into duvec
-  save_derivs(N_VGetArrayPointer(duvec));
+  bout::visitNVector(duvec, [this](auto&& dudata) { save_derivs(dudata); });
 
   // Set the equation type in id(Differential or Algebraic. This is optional)
-  set_id(N_VGetArrayPointer(id));
+  bout::visitNVector(id, [this](auto&& iddata) { set_id(iddata); });
 
   // Call IDACreate to initialise
   idamem = callWithSUNContext(IDACreate, suncontext);
@@ -193,6 +203,12 @@ int IdaSolver::init() {
       }
     } else {
       output.write("\tUsing BBD preconditioner\n");
+
+      if (zero_copy) {
+        throw BoutException("The BBD preconditioner can't be used with "
+                            "solver:zero_copy = true");
+      }
+
       /// Get options
       // Compute band_width_default from actually added fields, to allow for multiple Mesh
       // objects
@@ -272,7 +288,7 @@ BoutReal IdaSolver::run(BoutReal tout) {
   const int flag = IDASolve(idamem, tout, &simtime, uvec, duvec, IDA_NORMAL);
 
   // Copy variables
-  load_vars(N_VGetArrayPointer(uvec));
+  bout::visitNVector(uvec, [this](auto&& udata) { load_vars(udata); });
 
   // Call rhs function to get extra variables at this time
   run_rhs(simtime);
@@ -290,19 +306,40 @@ BoutReal IdaSolver::run(BoutReal tout) {
  * Residual function F(t, u, du)
  **************************************************************************/
 
-void IdaSolver::res(BoutReal t, BoutReal* udata, BoutReal* dudata, BoutReal* rdata) {
+void IdaSolver::res(BoutReal t, N_Vector u, N_Vector du, N_Vector rr) {
   TRACE("Running RHS: IdaSolver::res({:e})", t);
 
-  // Load state from udata
-  load_vars(udata);
+  // Load state from u
+  bout::visitNVector(u, [this](auto&& udata) { load_vars(udata); });
 
   // Call RHS function
   run_rhs(t);
 
-  // Save derivatives to rdata (residual)
-  save_derivs(rdata);
+  // Save derivatives to rr (residual)
+  bout::visitNVector(rr, [this](auto&& rdata) { save_derivs(rdata); });
+
+  if (zero_copy) {
+    release_vars();
+
+    // If a differential equation, subtract du
+    auto& residual = bout::getFieldNVectorFields(rr);
+    const auto& derivs = bout::getFieldNVectorFields(du);
+    for (std::size_t i = 0; i < f2d.size(); ++i) {
+      if (not f2d[i].constraint) {
+        residual.f2d[i] -= derivs.f2d[i];
+      }
+    }
+    for (std::size_t i = 0; i < f3d.size(); ++i) {
+      if (not f3d[i].constraint) {
+        residual.f3d[i] -= derivs.f3d[i];
+      }
+    }
+    return;
+  }
 
   // If a differential equation, subtract dudata
+  BoutReal* rdata = N_VGetArrayPointer(rr);
+  const BoutReal* dudata = N_VGetArrayPointer(du);
   const auto length = N_VGetLocalLength_Parallel(id);
   const BoutReal* idd = N_VGetArrayPointer(id);
   for (int i = 0; i < length; i++) {
@@ -316,29 +353,32 @@ void IdaSolver::res(BoutReal t, BoutReal* udata, BoutReal* dudata, BoutReal* rda
  * Preconditioner function
  **************************************************************************/
 
-void IdaSolver::pre(BoutReal t, BoutReal cj, BoutReal delta, BoutReal* udata,
-                    BoutReal* rvec, BoutReal* zvec) {
+void IdaSolver::pre(BoutReal t, BoutReal cj, BoutReal delta, N_Vector u, N_Vector rvec,
+                    N_Vector zvec) {
   TRACE("Running preconditioner: IdaSolver::pre({:e})", t);
 
   const BoutReal tstart = bout::globals::mpi->MPI_Wtime();
 
   if (!hasPreconditioner()) {
     // Identity (but should never happen)
-    const auto length = N_VGetLocalLength_Parallel(id);
-    std::copy(rvec, rvec + length, zvec);
+    N_VScale(1.0, rvec, zvec);
     return;
   }
 
-  // Load state from udata (as with res function)
-  load_vars(udata);
+  // Load state from u (as with res function)
+  bout::visitNVector(u, [this](auto&& udata) { load_vars(udata); });
 
   // Load vector to be inverted into F_vars
-  load_derivs(rvec);
+  bout::visitNVector(rvec, [this](auto&& rdata) { load_derivs(rdata); });
 
   runPreconditioner(t, cj, delta);
 
   // Save the solution from F_vars
-  save_derivs(zvec);
+  bout::visitNVector(zvec, [this](auto&& zdata) { save_derivs(zdata); });
+
+  if (zero_copy) {
+    release_vars();
+  }
 
   pre_Wtime += bout::globals::mpi->MPI_Wtime() - tstart;
   pre_ncalls++;
@@ -351,14 +391,10 @@ void IdaSolver::pre(BoutReal t, BoutReal cj, BoutReal delta, BoutReal* udata,
 // NOLINTBEGIN(readability-identifier-length)
 namespace {
 int idares(BoutReal t, N_Vector u, N_Vector du, N_Vector rr, void* user_data) {
-  BoutReal* udata = N_VGetArrayPointer(u);
-  BoutReal* dudata = N_VGetArrayPointer(du);
-  BoutReal* rdata = N_VGetArrayPointer(rr);
-
   auto* s = static_cast<IdaSolver*>(user_data);
 
   // Calculate residuals
-  s->res(t, udata, dudata, rdata);
+  s->res(t, u, du, rr);
 
   return 0;
 }
@@ -372,14 +408,10 @@ int ida_bbd_res(sunindextype UNUSED(Nlocal), BoutReal t, N_Vector u, N_Vector du
 // Preconditioner function
 int ida_pre(BoutReal t, N_Vector yy, N_Vector UNUSED(yp), N_Vector UNUSED(rr),
             N_Vector rvec, N_Vector zvec, BoutReal cj, BoutReal delta, void* user_data) {
-  BoutReal* udata = N_VGetArrayPointer(yy);
-  BoutReal* rdata = N_VGetArrayPointer(rvec);
-  BoutReal* zdata = N_VGetArrayPointer(zvec);
-
   auto* s = static_cast<IdaSolver*>(user_data);
 
   // Calculate residuals
-  s->pre(t, cj, delta, udata, rdata, zdata);
+  s->pre(t, cj, delta, yy, rvec, zvec);
 
   return 0;
 }
@@ -64,9 +64,9 @@ public:
   BoutReal run(BoutReal tout);
 
   // These functions used internally (but need to be public)
-  void res(BoutReal t, BoutReal* udata, BoutReal* dudata, BoutReal* rdata);
-  void pre(BoutReal t, BoutReal cj, BoutReal delta, BoutReal* udata, BoutReal* rvec,
-           BoutReal* zvec);
+  void res(BoutReal t, N_Vector u, N_Vector du, N_Vector rr);
+  void pre(BoutReal t, BoutReal cj, BoutReal delta, N_Vector u, N_Vector rvec,
+           N_Vector zvec);
 
 private:
   /// Absolute tolerance
@@ -79,6 +79,8 @@ private:
   bool use_precon;
   /// Correct the initial values
   bool correct_start;
+  /// Integrate the evolving fields directly, without copying them
+  bool zero_copy;
 
   N_Vector uvec{nullptr};  // Values
   N_Vector duvec{nullptr}; // Time-derivatives
@@ -12,6 +12,7 @@
 #include <bout/utils.hxx>
 
 #include <cmath>
+#include <vector>
 
 #include <bout/output.hxx>
 
@@ -248,9 +249,6 @@ int IMEXBDF2::init() {
 // Set up a snes object stored at the specified location
 void IMEXBDF2::constructSNES(SNES* snesIn) {
 
-  // Use global mesh for now
-  Mesh* mesh = bout::globals::mesh;
-
   // Nonlinear solver interface (SNES)
   SNESCreate(BoutComm::get(), snesIn);
 
@@ -288,354 +286,65 @@ void IMEXBDF2::constructSNES(SNES* snesIn) {
     if (use_coloring) {
       // Use matrix coloring to calculate Jacobian
 
-      //////////////////////////////////////////////////
-      // Get the local indices by starting at 0
-      Field3D index = globalIndex(0);
+      // Find the sparsity pattern of the implicit part once, and
+      // re-use it for all SNES objects
+      if (jacobian_pattern.empty()) {
+        jacobian_pattern =
+            getJacobianPattern([this]() { run_diffusive(simtime, true); });
+      }
+
+      // Global indices of the variables at each point, including the
+      // guard cells, so columns on other processors can be found
+      PetscInt Istart, Iend;
+      VecGetOwnershipRange(snes_x, &Istart, &Iend);
+      const Field3D index = globalIndex(static_cast<int>(Istart));
 
       //////////////////////////////////////////////////
       // Pre-allocate PETSc storage
 
-      int localN = getLocalN(); // Number of rows on this processor
-      int n2d = f2d.size();
-      int n3d = f3d.size();
-
-      // Set size of Matrix on each processor to localN x localN
+      // Set size of Matrix on each processor to nlocal x nlocal
       MatCreate(BoutComm::get(), &Jmf);
-      MatSetSizes(Jmf, localN, localN, PETSC_DETERMINE, PETSC_DETERMINE);
+      MatSetSizes(Jmf, nlocal, nlocal, PETSC_DETERMINE, PETSC_DETERMINE);
       MatSetFromOptions(Jmf);
 
-      PetscInt *d_nnz, *o_nnz;
-      PetscMalloc((localN) * sizeof(PetscInt), &d_nnz);
-      PetscMalloc((localN) * sizeof(PetscInt), &o_nnz);
-
-      // Set values for most points
-      if (mesh->LocalNz > 1) {
-        // A 3D mesh, so need points in Z
-
-        for (int i = 0; i < localN; i++) {
-          // Non-zero elements on this processor
-          d_nnz[i] = 7 * n3d + 5 * n2d; // Star pattern in 3D
-          // Non-zero elements on neighboring processor
-          o_nnz[i] = 0;
-        }
-      } else {
-        // Only one point in Z
-
-        for (int i = 0; i < localN; i++) {
-          // Non-zero elements on this processor
-          d_nnz[i] = 5 * (n3d + n2d); // Star pattern in 2D
-          // Non-zero elements on neighboring processor
-          o_nnz[i] = 0;
-        }
-      }
-
-      // X boundaries
-      if (mesh->firstX()) {
-        // Lower X boundary
-        for (int y = mesh->ystart; y <= mesh->yend; y++) {
-          for (int z = 0; z < mesh->LocalNz; z++) {
-            int localIndex = ROUND(index(mesh->xstart, y, z));
-            ASSERT2((localIndex >= 0) && (localIndex < localN));
-            if (z == 0) {
-              // All 2D and 3D fields
-              for (int i = 0; i < n2d + n3d; i++) {
-                d_nnz[localIndex + i] -= (n3d + n2d);
-              }
-            } else {
-              // Only 3D fields
-              for (int i = 0; i < n3d; i++) {
-                d_nnz[localIndex + i] -= (n3d + n2d);
-              }
-            }
-          }
-        }
-      } else {
-        // On another processor
-        for (int y = mesh->ystart; y <= mesh->yend; y++) {
-          for (int z = 0; z < mesh->LocalNz; z++) {
-            int localIndex = ROUND(index(mesh->xstart, y, z));
-            ASSERT2((localIndex >= 0) && (localIndex < localN));
-            if (z == 0) {
-              // All 2D and 3D fields
-              for (int i = 0; i < n2d + n3d; i++) {
-                d_nnz[localIndex + i] -= (n3d + n2d);
-                o_nnz[localIndex + i] += (n3d + n2d);
-              }
-            } else {
-              // Only 3D fields
-              for (int i = 0; i < n3d; i++) {
-                d_nnz[localIndex + i] -= (n3d + n2d);
-                o_nnz[localIndex + i] += (n3d + n2d);
-              }
-            }
-          }
-        }
-      }
-
-      if (mesh->lastX()) {
-        // Upper X boundary
-        for (int y = mesh->ystart; y <= mesh->yend; y++) {
-          for (int z = 0; z < mesh->LocalNz; z++) {
-            int localIndex = ROUND(index(mesh->xend, y, z));
-            ASSERT2((localIndex >= 0) && (localIndex < localN));
-            if (z == 0) {
-              // All 2D and 3D fields
-              for (int i = 0; i < n2d + n3d; i++) {
-                d_nnz[localIndex + i] -= (n3d + n2d);
-              }
-            } else {
-              // Only 3D fields
-              for (int i = 0; i < n3d; i++) {
-                d_nnz[localIndex + i] -= (n3d + n2d);
-              }
-            }
-          }
-        }
-      } else {
-        // On another processor
-        for (int y = mesh->ystart; y <= mesh->yend; y++) {
-          for (int z = 0; z < mesh->LocalNz; z++) {
-            int localIndex = ROUND(index(mesh->xend, y, z));
-            ASSERT2((localIndex >= 0) && (localIndex < localN));
-            if (z == 0) {
-              // All 2D and 3D fields
-              for (int i = 0; i < n2d + n3d; i++) {
-                d_nnz[localIndex + i] -= (n3d + n2d);
-                o_nnz[localIndex + i] += (n3d + n2d);
-              }
-            } else {
-              // Only 3D fields
-              for (int i = 0; i < n3d; i++) {
-                d_nnz[localIndex + i] -= (n3d + n2d);
-                o_nnz[localIndex + i] += (n3d + n2d);
-              }
-            }
-          }
-        }
-      }
-
-      // Y boundaries
-
-      for (int x = mesh->xstart; x <= mesh->xend; x++) {
-        // Default to no boundary
-        // NOTE: This assumes that communications in Y are to other
-        //   processors. If Y is communicated with this processor (e.g. NYPE=1)
-        //   then this will result in PETSc warnings about out of range allocations
-
-        // z = 0 case
-        int localIndex = ROUND(index(x, mesh->ystart, 0));
-        // All 2D and 3D fields
-        for (int i = 0; i < n2d + n3d; i++) {
-          // d_nnz[localIndex+i] -= (n3d + n2d);
-          o_nnz[localIndex + i] += (n3d + n2d);
-        }
-
-        for (int z = 1; z < mesh->LocalNz; z++) {
-          localIndex = ROUND(index(x, mesh->ystart, z));
-
-          // Only 3D fields
-          for (int i = 0; i < n3d; i++) {
-            // d_nnz[localIndex+i] -= (n3d + n2d);
-            o_nnz[localIndex + i] += (n3d + n2d);
-          }
-        }
-
-        // z = 0 case
-        localIndex = ROUND(index(x, mesh->yend, 0));
-        // All 2D and 3D fields
-        for (int i = 0; i < n2d + n3d; i++) {
-          // d_nnz[localIndex+i] -= (n3d + n2d);
-          o_nnz[localIndex + i] += (n3d + n2d);
-        }
-
-        for (int z = 1; z < mesh->LocalNz; z++) {
-          localIndex = ROUND(index(x, mesh->yend, z));
-
-          // Only 3D fields
-          for (int i = 0; i < n3d; i++) {
-            // d_nnz[localIndex+i] -= (n3d + n2d);
-            o_nnz[localIndex + i] += (n3d + n2d);
-          }
-        }
-      }
-
-      for (RangeIterator it = mesh->iterateBndryLowerY(); !it.isDone(); it++) {
-        // A boundary, so no communication
-
-        // z = 0 case
-        int localIndex = ROUND(index(it.ind, mesh->ystart, 0));
-        // All 2D and 3D fields
-        for (int i = 0; i < n2d + n3d; i++) {
-          o_nnz[localIndex + i] -= (n3d + n2d);
-        }
-
-        for (int z = 1; z < mesh->LocalNz; z++) {
-          int localIndex = ROUND(index(it.ind, mesh->ystart, z));
-
-          // Only 3D fields
-          for (int i = 0; i < n3d; i++) {
-            o_nnz[localIndex + i] -= (n3d + n2d);
-          }
-        }
-      }
-
-      for (RangeIterator it = mesh->iterateBndryUpperY(); !it.isDone(); it++) {
-        // A boundary, so no communication
-
-        // z = 0 case
-        int localIndex = ROUND(index(it.ind, mesh->yend, 0));
-        // All 2D and 3D fields
-        for (int i = 0; i < n2d + n3d; i++) {
-          o_nnz[localIndex + i] -= (n3d + n2d);
-        }
-
-        for (int z = 1; z < mesh->LocalNz; z++) {
-          int localIndex = ROUND(index(it.ind, mesh->yend, z));
-
-          // Only 3D fields
-          for (int i = 0; i < n3d; i++) {
-            o_nnz[localIndex + i] -= (n3d + n2d);
-          }
-        }
-      }
+      // Count the non-zero elements on this processor, and on other processors
+      std::vector<PetscInt> d_nnz(nlocal, 0);
+      std::vector<PetscInt> o_nnz(nlocal, 0);
+      forEachJacobianRow(jacobian_pattern, index,
+                         [&](int row, const std::vector<int>& columns) {
+                           for (const auto column : columns) {
+                             if (column >= Istart and column < Iend) {
+                               ++d_nnz[row - Istart];
+                             } else {
+                               ++o_nnz[row - Istart];
+                             }
+                           }
+                         });
 
       // Pre-allocate
-      MatMPIAIJSetPreallocation(Jmf, 0, d_nnz, 0, o_nnz);
+      MatMPIAIJSetPreallocation(Jmf, 0, d_nnz.data(), 0, o_nnz.data());
+      MatSeqAIJSetPreallocation(Jmf, 0, d_nnz.data());
       MatSetUp(Jmf);
-      MatSetOption(Jmf, MAT_NEW_NONZERO_ALLOCATION_ERR, PETSC_FALSE);
-      PetscFree(d_nnz);
-      PetscFree(o_nnz);
-
-      // Determine which row/columns of the matrix are locally owned
-      int Istart, Iend;
-      MatGetOwnershipRange(Jmf, &Istart, &Iend);
-
-      // Convert local into global indices
-      index += Istart;
-
-      // Now communicate to fill guard cells
-      mesh->communicate(index);
+      MatSetOption(Jmf, MAT_NEW_NONZERO_ALLOCATION_ERR, PETSC_TRUE);
 
       //////////////////////////////////////////////////
       // Mark non-zero entries
 
-      // Offsets for a 5-point pattern
-      const int xoffset[5] = {0, -1, 1, 0, 0};
-      const int yoffset[5] = {0, 0, 0, -1, 1};
-
-      PetscScalar val = 1.0;
-
-      for (int x = mesh->xstart; x <= mesh->xend; x++) {
-        for (int y = mesh->ystart; y <= mesh->yend; y++) {
-
-          int ind0 = ROUND(index(x, y, 0));
-
-          // 2D fields
-          for (int i = 0; i < n2d; i++) {
-            PetscInt row = ind0 + i;
-
-            // Loop through each point in the 5-point stencil
-            for (int c = 0; c < 5; c++) {
-              int xi = x + xoffset[c];
-              int yi = y + yoffset[c];
-
-              if ((xi < 0) || (yi < 0) || (xi >= mesh->LocalNx)
-                  || (yi >= mesh->LocalNy)) {
-                continue;
-              }
-
-              int ind2 = ROUND(index(xi, yi, 0));
-
-              if (ind2 < 0) {
-                continue; // A boundary point
-              }
-
-              // Depends on all variables on this cell
-              for (int j = 0; j < n2d; j++) {
-                PetscInt col = ind2 + j;
-
-                // output.write("SETTING 1: {:d}, {:d}\n", row, col);
-                MatSetValues(Jmf, 1, &row, 1, &col, &val, INSERT_VALUES);
-              }
-            }
-          }
-
-          // 3D fields
-          for (int z = 0; z < mesh->LocalNz; z++) {
-
-            int ind = ROUND(index(x, y, z));
-
-            for (int i = 0; i < n3d; i++) {
-              PetscInt row = ind + i;
-              if (z == 0) {
-                row += n2d;
-              }
-
-              // Depends on 2D fields
-              for (int j = 0; j < n2d; j++) {
-                PetscInt col = ind0 + j;
-                // output.write("SETTING 2: {:d}, {:d}\n", row, col);
-                MatSetValues(Jmf, 1, &row, 1, &col, &val, INSERT_VALUES);
-              }
-
-              // 5 point star pattern
-              for (int c = 0; c < 5; c++) {
-                int xi = x + xoffset[c];
-                int yi = y + yoffset[c];
-
-                if ((xi < 0) || (yi < 0) || (xi >= mesh->LocalNx)
-                    || (yi >= mesh->LocalNy)) {
-                  continue;
-                }
-
-                int ind2 = ROUND(index(xi, yi, z));
-                if (ind2 < 0) {
-                  continue; // Boundary point
-                }
-
-                if (z == 0) {
-                  ind2 += n2d;
-                }
-
-                // 3D fields on this cell
-                for (int j = 0; j < n3d; j++) {
-                  PetscInt col = ind2 + j;
-                  // output.write("SETTING 3: {:d}, {:d}\n", row, col);
-                  MatSetValues(Jmf, 1, &row, 1, &col, &val, INSERT_VALUES);
-                }
-              }
-
-              int nz = mesh->LocalNz;
-              if (nz > 1) {
-                // Multiple points in z
-
-                int zp = (z + 1) % nz;
-
-                int ind2 = ROUND(index(x, y, zp));
-                if (zp == 0) {
-                  ind2 += n2d;
-                }
-                for (int j = 0; j < n3d; j++) {
-                  PetscInt col = ind2 + j;
-                  // output.write("SETTING 4: {:d}, {:d}\n", row, col);
-                  MatSetValues(Jmf, 1, &row, 1, &col, &val, INSERT_VALUES);
-                }
-
-                int zm = (z - 1 + nz) % nz;
-                ind2 = ROUND(index(x, y, zm));
-                if (zm == 0) {
-                  ind2 += n2d;
-                }
-                for (int j = 0; j < n3d; j++) {
-                  PetscInt col = ind2 + j;
-                  // output.write("SETTING 5: {:d}, {:d}\n", row, col);
-                  MatSetValues(Jmf, 1, &row, 1, &col, &val, INSERT_VALUES);
-                }
-              }
-            }
-          }
-        }
-      }
+      std::vector<PetscInt> cols;
+      std::vector<PetscScalar> vals;
+      forEachJacobianRow(jacobian_pattern, index,
+                         [&](int row, const std::vector<int>& columns) {
+                           const PetscInt petsc_row = row;
+                           cols.assign(columns.begin(), columns.end());
+                           vals.assign(columns.size(), 1.0);
+                           if (MatSetValues(Jmf, 1, &petsc_row,
+                                            static_cast<PetscInt>(cols.size()),
+                                            cols.data(), vals.data(), INSERT_VALUES)
+                               != 0) {
+                             throw BoutException(
+                                 "Failed to set Jacobian entries in row {:d}", row);
+                           }
+                         });
       // Finished marking non-zero entries
 
       // Assemble Matrix
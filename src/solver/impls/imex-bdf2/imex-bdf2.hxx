@@ -131,6 +131,8 @@ private:
   bool matrix_free;
   /// Use matrix coloring
   bool use_coloring;
+  /// Sparsity pattern of the Jacobian, used with coloring
+  std::vector<JacobianCoupling> jacobian_pattern;
   /// Absolute tolerance
   BoutReal atol;
   /// Relative tolerance
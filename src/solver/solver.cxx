@@ -29,13 +29,16 @@
 #include "bout/field_factory.hxx"
 #include "bout/initialprofiles.hxx"
 #include "bout/interpolation.hxx"
+#include "bout/mpi_wrapper.hxx"
 #include "bout/msg_stack.hxx"
 #include "bout/output.hxx"
 #include "bout/region.hxx"
 #include "bout/solver.hxx"
+#include "bout/sys/profiler.hxx"
 #include "bout/sys/timer.hxx"
 #include "bout/sys/uuid.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <ctime>
@@ -89,6 +92,10 @@ Solver::Solver(Options* opts)
       mms_initialise((*options)["mms_initialise"]
                          .doc("Use MMS solution for field initial conditions")
                          .withDefault(mms)),
+      var_layout((*options)["layout"]
+                     .doc("Arrangement of the variables in the state vector: "
+                          "interleaved or block")
+                     .withDefault(SolverVarLayout::interleaved)),
       number_output_steps(
           (*options)["nout"]
               .doc("Number of output steps. Overrides global setting.")
@@ -719,6 +726,9 @@ void Solver::outputVars(Options& output_options, bool save_repeat) {
       output_options[d.name].assignRepeat(*(d.var), "t", true, "Solver");
       output_options[d.name].attributes["description"] = d.description;
     }
+
+    // Profile of the run so far, reduced over processors
+    bout::Profiler::outputVars(output_options);
   }
 }
 
@@ -983,9 +993,8 @@ int Solver::getLocalN() {
 
   // Cache the value, so this is not repeatedly called.
   // This value should not change after initialisation
-  static int cacheLocalN{-1};
-  if (cacheLocalN != -1) {
-    return cacheLocalN;
+  if (cached_local_N != -1) {
+    return cached_local_N;
   }
 
   // Must be initialised
@@ -993,11 +1002,9 @@ int Solver::getLocalN() {
 
   const auto local_N_2D = std::accumulate(begin(f2d), end(f2d), 0, local_N_sum<Field2D>);
   const auto local_N_3D = std::accumulate(begin(f3d), end(f3d), 0, local_N_sum<Field3D>);
-  const auto local_N = local_N_2D + local_N_3D;
-
-  cacheLocalN = local_N;
+  cached_local_N = local_N_2D + local_N_3D;
 
-  return local_N;
+  return cached_local_N;
 }
 
 std::unique_ptr<Solver> Solver::create(Options* opts) {
@@ -1021,7 +1028,9 @@ void Solver::loop_vars_op(Ind2D i2d, BoutReal* udata, int& p, SOLVER_VAR_OP op,
   // Use global mesh: FIX THIS!
   Mesh* mesh = bout::globals::mesh;
 
-  int nz = mesh->LocalNz;
+  // The Z guard cells, if any, are copies of points on other processors
+  const int zstart = mesh->zstart;
+  const int zend = mesh->zend;
 
   switch (op) {
   case SOLVER_VAR_OP::LOAD_VARS: {
@@ -1036,7 +1045,7 @@ void Solver::loop_vars_op(Ind2D i2d, BoutReal* udata, int& p, SOLVER_VAR_OP op,
       p++;
     }
 
-    for (int jz = 0; jz < nz; jz++) {
+    for (int jz = zstart; jz <= zend; jz++) {
 
       // Loop over 3D variables
       for (const auto& f : f3d) {
@@ -1062,7 +1071,7 @@ void Solver::loop_vars_op(Ind2D i2d, BoutReal* udata, int& p, SOLVER_VAR_OP op,
       p++;
     }
 
-    for (int jz = 0; jz < nz; jz++) {
+    for (int jz = zstart; jz <= zend; jz++) {
 
       // Loop over 3D variables
       for (const auto& f : f3d) {
@@ -1092,7 +1101,7 @@ void Solver::loop_vars_op(Ind2D i2d, BoutReal* udata, int& p, SOLVER_VAR_OP op,
       p++;
     }
 
-    for (int jz = 0; jz < nz; jz++) {
+    for (int jz = zstart; jz <= zend; jz++) {
 
       // Loop over 3D variables
       for (const auto& f : f3d) {
@@ -1122,7 +1131,7 @@ void Solver::loop_vars_op(Ind2D i2d, BoutReal* udata, int& p, SOLVER_VAR_OP op,
       p++;
     }
 
-    for (int jz = 0; jz < nz; jz++) {
+    for (int jz = zstart; jz <= zend; jz++) {
 
       // Loop over 3D variables
       for (const auto& f : f3d) {
@@ -1147,7 +1156,7 @@ void Solver::loop_vars_op(Ind2D i2d, BoutReal* udata, int& p, SOLVER_VAR_OP op,
       p++;
     }
 
-    for (int jz = 0; jz < nz; jz++) {
+    for (int jz = zstart; jz <= zend; jz++) {
 
       // Loop over 3D variables
       for (const auto& f : f3d) {
@@ -1163,13 +1172,64 @@ void Solver::loop_vars_op(Ind2D i2d, BoutReal* udata, int& p, SOLVER_VAR_OP op,
   }
 }
 
+/// Perform an operation on all the contiguous blocks of variable \p f,
+/// moving data between BOUT++ and the solver
+template <class T>
+void Solver::loop_var_block(const VarStr<T>& f, BoutReal* udata, int& p,
+                            SOLVER_VAR_OP op) {
+  const auto do_region = [&](const std::string& region_name) {
+    for (const auto& block : f.var->getRegion(region_name).getBlocks()) {
+      const int length = block.second.ind - block.first.ind;
+      BoutReal* u = udata + p;
+      p += length;
+
+      switch (op) {
+      case SOLVER_VAR_OP::LOAD_VARS:
+        std::copy(u, u + length, &(*f.var)[block.first]);
+        break;
+      case SOLVER_VAR_OP::LOAD_DERIVS:
+        std::copy(u, u + length, &(*f.F_var)[block.first]);
+        break;
+      case SOLVER_VAR_OP::SET_ID:
+        std::fill(u, u + length, f.constraint ? 0.0 : 1.0);
+        break;
+      case SOLVER_VAR_OP::SAVE_VARS: {
+        const BoutReal* data = &(*f.var)[block.first];
+        std::copy(data, data + length, u);
+        break;
+      }
+      case SOLVER_VAR_OP::SAVE_DERIVS: {
+        const BoutReal* data = &(*f.F_var)[block.first];
+        std::copy(data, data + length, u);
+        break;
+      }
+      }
+    }
+  };
+
+  if (f.evolve_bndry) {
+    do_region("RGN_BNDRY");
+  }
+  do_region("RGN_NOBNDRY");
+}
+
 /// Loop over variables and domain. Used for all data operations for consistency
 void Solver::loop_vars(BoutReal* udata, SOLVER_VAR_OP op) {
+  int p = 0; // Counter for location in udata array
+
+  if (var_layout == SolverVarLayout::block) {
+    for (const auto& f : f2d) {
+      loop_var_block(f, udata, p, op);
+    }
+    for (const auto& f : f3d) {
+      loop_var_block(f, udata, p, op);
+    }
+    return;
+  }
+
   // Use global mesh: FIX THIS!
   Mesh* mesh = bout::globals::mesh;
 
-  int p = 0; // Counter for location in udata array
-
   // All boundaries
   for (const auto& i2d : mesh->getRegion2D("RGN_BNDRY")) {
     loop_vars_op(i2d, udata, p, op, true);
@@ -1259,6 +1319,12 @@ void Solver::save_vars(BoutReal* udata) {
 }
 
 void Solver::save_derivs(BoutReal* dudata) {
+  prepare_save_derivs();
+
+  loop_vars(dudata, SOLVER_VAR_OP::SAVE_DERIVS);
+}
+
+void Solver::prepare_save_derivs() {
   // Make sure vectors in correct basis
   for (const auto& v : v2d) {
     if (v.covariant) {
@@ -1284,13 +1350,259 @@ void Solver::save_derivs(BoutReal* dudata) {
                           toString(f.F_var->getLocation()), f.name);
     }
   }
-
-  loop_vars(dudata, SOLVER_VAR_OP::SAVE_DERIVS);
 }
 
 void Solver::set_id(BoutReal* udata) { loop_vars(udata, SOLVER_VAR_OP::SET_ID); }
 
+void Solver::set_field_values(BoutReal* udata, const std::vector<BoutReal>& f2d_values,
+                              const std::vector<BoutReal>& f3d_values) {
+  ASSERT1(f2d_values.size() == f2d.size());
+  ASSERT1(f3d_values.size() == f3d.size());
+
+  int p = 0; // Counter for location in udata array
+
+  if (var_layout == SolverVarLayout::block) {
+    const auto fill_var = [&](const auto& f, BoutReal value) {
+      const int length = (f.evolve_bndry ? f.var->getRegion("RGN_BNDRY").size() : 0)
+                         + f.var->getRegion("RGN_NOBNDRY").size();
+      std::fill(udata + p, udata + p + length, value);
+      p += length;
+    };
+    for (std::size_t i = 0; i < f2d.size(); ++i) {
+      fill_var(f2d[i], f2d_values[i]);
+    }
+    for (std::size_t i = 0; i < f3d.size(); ++i) {
+      fill_var(f3d[i], f3d_values[i]);
+    }
+    return;
+  }
+
+  // Use global mesh: FIX THIS!
+  Mesh* mesh = bout::globals::mesh;
+
+  // Interleaved: the same order as loop_vars_op
+  const auto fill_point = [&](bool bndry) {
+    for (std::size_t i = 0; i < f2d.size(); ++i) {
+      if (bndry && !f2d[i].evolve_bndry) {
+        continue;
+      }
+      udata[p++] = f2d_values[i];
+    }
+    for (int jz = mesh->zstart; jz <= mesh->zend; jz++) {
+      for (std::size_t i = 0; i < f3d.size(); ++i) {
+        if (bndry && !f3d[i].evolve_bndry) {
+          continue;
+        }
+        udata[p++] = f3d_values[i];
+      }
+    }
+  };
+
+  // All boundaries
+  const int n_bndry = mesh->getRegion2D("RGN_BNDRY").size();
+  for (int i = 0; i < n_bndry; ++i) {
+    fill_point(true);
+  }
+  // Bulk of points
+  const int n_bulk = mesh->getRegion2D("RGN_NOBNDRY").size();
+  for (int i = 0; i < n_bulk; ++i) {
+    fill_point(false);
+  }
+}
+
+namespace {
+/// The points of \p f which are evolved
+template <class T>
+auto evolvingRegion(const T& f, bool evolve_bndry) {
+  auto region = f.getRegion("RGN_NOBNDRY");
+  if (evolve_bndry) {
+    region = (region + f.getRegion("RGN_BNDRY")).asUnique();
+  }
+  return region;
+}
+
+/// Exchange the data of \p first and \p second without copying it
+template <class T>
+void swapData(T& first, T& second) {
+  // Assignment also copies the names, so keep them
+  const std::string first_name = first.name;
+  const std::string second_name = second.name;
+  const T tmp = first;
+  first = second;
+  second = tmp;
+  first.name = first_name;
+  second.name = second_name;
+}
+
+/// Drop the data of \p f, keeping its other properties
+template <class T>
+void releaseData(T& f) {
+  const std::string name = f.name;
+  f = T{f.getMesh(), f.getLocation(), f.getDirections()};
+  f.name = name;
+}
+} // namespace
+
+SolverFields Solver::create_solver_fields() {
+  SolverFields::Regions regions;
+  SolverFields fields;
+
+  for (const auto& f : f2d) {
+    regions.f2d.push_back(evolvingRegion(*f.var, f.evolve_bndry));
+    fields.f2d.push_back(emptyFrom(*f.var));
+  }
+  for (const auto& f : f3d) {
+    regions.f3d.push_back(evolvingRegion(*f.var, f.evolve_bndry));
+    fields.f3d.push_back(emptyFrom(*f.var).setLocation(f.location));
+  }
+
+  fields.regions = std::make_shared<const SolverFields::Regions>(std::move(regions));
+  return fields;
+}
+
+void Solver::load_vars(const SolverFields& u) {
+  // Boundary conditions are applied in place, so fields which evolve
+  // their boundaries need their own copy to leave `u` unchanged
+  for (std::size_t i = 0; i < f2d.size(); ++i) {
+    *f2d[i].var = u.f2d[i];
+    if (f2d[i].evolve_bndry) {
+      f2d[i].var->allocate();
+    }
+  }
+  for (std::size_t i = 0; i < f3d.size(); ++i) {
+    *f3d[i].var = u.f3d[i];
+    if (f3d[i].evolve_bndry) {
+      f3d[i].var->allocate();
+    }
+  }
+
+  // Mark each vector as either co- or contra-variant
+
+  for (const auto& v : v2d) {
+    v.var->covariant = v.covariant;
+  }
+  for (const auto& v : v3d) {
+    v.var->covariant = v.covariant;
+  }
+}
+
+void Solver::load_derivs(const SolverFields& du) {
+  // Share the data, then copy it so that it can be modified in place
+  for (std::size_t i = 0; i < f2d.size(); ++i) {
+    *f2d[i].F_var = du.f2d[i];
+    f2d[i].F_var->allocate();
+  }
+  for (std::size_t i = 0; i < f3d.size(); ++i) {
+    *f3d[i].F_var = du.f3d[i];
+    f3d[i].F_var->allocate();
+  }
+
+  // Mark each vector as either co- or contra-variant
+
+  for (const auto& v : v2d) {
+    v.F_var->covariant = v.covariant;
+  }
+  for (const auto& v : v3d) {
+    v.F_var->covariant = v.covariant;
+  }
+}
+
+void Solver::save_vars(SolverFields& u) {
+  for (const auto& f : f2d) {
+    if (!f.var->isAllocated()) {
+      throw BoutException(_("Variable '{:s}' not initialised"), f.name);
+    }
+  }
+
+  for (const auto& f : f3d) {
+    if (!f.var->isAllocated()) {
+      throw BoutException(_("Variable '{:s}' not initialised"), f.name);
+    }
+  }
+
+  // Make sure vectors in correct basis
+  for (const auto& v : v2d) {
+    if (v.covariant) {
+      v.var->toCovariant();
+    } else {
+      v.var->toContravariant();
+    }
+  }
+  for (const auto& v : v3d) {
+    if (v.covariant) {
+      v.var->toCovariant();
+    } else {
+      v.var->toContravariant();
+    }
+  }
+
+  for (std::size_t i = 0; i < f2d.size(); ++i) {
+    u.f2d[i] = copy(*f2d[i].var);
+  }
+  for (std::size_t i = 0; i < f3d.size(); ++i) {
+    u.f3d[i] = copy(*f3d[i].var);
+  }
+}
+
+void Solver::save_derivs(SolverFields& du) {
+  prepare_save_derivs();
+
+  // The old data of du is given to the time derivatives, so that they
+  // can still be modified in place. If the time derivatives share
+  // their data with anything else, du gets its own copy
+  for (std::size_t i = 0; i < f2d.size(); ++i) {
+    if (!f2d[i].F_var->isAllocated()) {
+      throw BoutException(_("Time derivative of '{:s}' not set"), f2d[i].name);
+    }
+    swapData(du.f2d[i], *f2d[i].F_var);
+    du.f2d[i].allocate();
+  }
+  for (std::size_t i = 0; i < f3d.size(); ++i) {
+    if (!f3d[i].F_var->isAllocated()) {
+      throw BoutException(_("Time derivative of '{:s}' not set"), f3d[i].name);
+    }
+    swapData(du.f3d[i], *f3d[i].F_var);
+    du.f3d[i].allocate();
+  }
+}
+
+void Solver::set_id(SolverFields& u) {
+  for (std::size_t i = 0; i < f2d.size(); ++i) {
+    u.f2d[i] = f2d[i].constraint ? 0.0 : 1.0;
+  }
+  for (std::size_t i = 0; i < f3d.size(); ++i) {
+    u.f3d[i] = f3d[i].constraint ? 0.0 : 1.0;
+  }
+}
+
+void Solver::set_field_values(SolverFields& u, const std::vector<BoutReal>& f2d_values,
+                              const std::vector<BoutReal>& f3d_values) {
+  ASSERT1(f2d_values.size() == f2d.size());
+  ASSERT1(f3d_values.size() == f3d.size());
+
+  for (std::size_t i = 0; i < f2d.size(); ++i) {
+    u.f2d[i] = f2d_values[i];
+  }
+  for (std::size_t i = 0; i < f3d.size(); ++i) {
+    u.f3d[i] = f3d_values[i];
+  }
+}
+
+void Solver::release_vars() {
+  for (const auto& f : f2d) {
+    releaseData(*f.var);
+  }
+  for (const auto& f : f3d) {
+    releaseData(*f.var);
+  }
+}
+
 Field3D Solver::globalIndex(int localStart) {
+  if (var_layout != SolverVarLayout::interleaved) {
+    throw BoutException("Solver::globalIndex requires the interleaved variable layout "
+                        "(solver:layout = interleaved)");
+  }
+
   // Use global mesh: FIX THIS!
   Mesh* mesh = bout::globals::mesh;
 
@@ -1301,7 +1613,10 @@ Field3D Solver::globalIndex(int localStart) {
 
   int ind = localStart;
 
-  int nz = mesh->LocalNz;
+  // Only the points between zstart and zend are evolved here. The
+  // indices in the Z guard cells come from the other processors in Z
+  const int zstart = mesh->zstart;
+  const int zend = mesh->zend;
 
   // Find how many boundary cells are evolving
   int n2dbndry = 0;
@@ -1321,11 +1636,11 @@ Field3D Solver::globalIndex(int localStart) {
     // Some boundary points evolving
 
     for (const auto& i2d : mesh->getRegion2D("RGN_BNDRY")) {
-      // Zero index contains 2D and 3D variables
-      index[mesh->ind2Dto3D(i2d, 0)] = ind;
+      // First index contains 2D and 3D variables
+      index[mesh->ind2Dto3D(i2d, zstart)] = ind;
       ind += n2dbndry + n3dbndry;
 
-      for (int jz = 1; jz < nz; jz++) {
+      for (int jz = zstart + 1; jz <= zend; jz++) {
         index[mesh->ind2Dto3D(i2d, jz)] = ind;
         ind += n3dbndry;
       }
@@ -1334,11 +1649,11 @@ Field3D Solver::globalIndex(int localStart) {
 
   // Bulk of points
   for (const auto& i2d : mesh->getRegion2D("RGN_NOBNDRY")) {
-    // Zero index contains 2D and 3D variables
-    index[mesh->ind2Dto3D(i2d, 0)] = ind;
+    // First index contains 2D and 3D variables
+    index[mesh->ind2Dto3D(i2d, zstart)] = ind;
     ind += n2d + n3d;
 
-    for (int jz = 1; jz < nz; jz++) {
+    for (int jz = zstart + 1; jz <= zend; jz++) {
       index[mesh->ind2Dto3D(i2d, jz)] = ind;
       ind += n3d;
     }
@@ -1353,6 +1668,373 @@ Field3D Solver::globalIndex(int localStart) {
   return index;
 }
 
+std::vector<Solver::JacobianCoupling> Solver::starJacobianPattern() const {
+  Mesh* mesh = bout::globals::mesh;
+
+  const int n2d = f2d.size();
+  const int nvars = n2d + f3d.size();
+
+  // Offsets in X and Y. Start with the central cell
+  std::vector<std::pair<int, int>> xyoffsets{{0, 0}};
+  if (mesh->LocalNx > 1) {
+    xyoffsets.push_back({-1, 0});
+    xyoffsets.push_back({1, 0});
+  }
+  if (mesh->LocalNy > 1) {
+    xyoffsets.push_back({0, -1});
+    xyoffsets.push_back({0, 1});
+  }
+
+  std::vector<JacobianCoupling> pattern;
+  for (int row = 0; row < nvars; ++row) {
+    for (int column = 0; column < nvars; ++column) {
+      if (row < n2d and column >= n2d) {
+        // 2D variables only depend on 2D variables
+        continue;
+      }
+      if (row >= n2d and column < n2d) {
+        // 3D variables depend on 2D variables at the same point
+        pattern.push_back({row, column, 0, 0, 0, false});
+        continue;
+      }
+      for (const auto& xyoffset : xyoffsets) {
+        pattern.push_back({row, column, xyoffset.first, xyoffset.second, 0, false});
+      }
+      if (row >= n2d and mesh->LocalNz > 1) {
+        pattern.push_back({row, column, 0, 0, -1, false});
+        pattern.push_back({row, column, 0, 0, 1, false});
+      }
+    }
+  }
+  return pattern;
+}
+
+namespace {
+/// \p value modulo \p period, in the range [0, period)
+int positiveModulo(int value, int period) { return ((value % period) + period) % period; }
+
+/// The offset from \p coordinate to the nearest lattice point, where
+/// the lattice points are at multiples of \p period
+int offsetToLattice(int coordinate, int period) {
+  const int offset = positiveModulo(-coordinate, period);
+  return (offset > period / 2) ? offset - period : offset;
+}
+} // namespace
+
+std::vector<Solver::JacobianCoupling>
+Solver::probeJacobianPattern(const std::function<void()>& rhs, int width) {
+  TRACE("Solver::probeJacobianPattern");
+
+  Mesh* mesh = bout::globals::mesh;
+
+  const int n2d = f2d.size();
+  const int n3d = f3d.size();
+  const int nvars = n2d + n3d;
+
+  // Each variable is perturbed at points `period` apart in each
+  // direction, so each point is within `period / 2` of exactly one
+  // perturbed point, and any change in the time derivatives there
+  // comes from that point. The lattice reaches one point further than
+  // `width`, so that couplings wider than `width` are seen at the edge
+  // rather than being folded onto nearer offsets. The offsets in X and
+  // Y can't be more than the number of guard cells. The period in Z
+  // divides the number of points, so that offsets which wrap around
+  // are found correctly. If Z is split between processors then the
+  // offsets in Z are also limited by the guard cells
+  const int zguards = mesh->zstart;
+  const int width_x = std::min(width, mesh->xstart);
+  const int width_y = std::min(width, mesh->ystart);
+  const int period_x = 2 * width_x + 3;
+  const int period_y = 2 * width_y + 3;
+  int period_z = std::min(2 * ((zguards > 0) ? std::min(width, zguards) : width) + 3,
+                          mesh->GlobalNz);
+  while (mesh->GlobalNz % period_z != 0) {
+    ++period_z;
+  }
+  // If the lattice covers all of Z then every offset is found exactly
+  int width_z = (period_z == mesh->GlobalNz) ? period_z / 2 : width;
+  if (zguards > 0) {
+    width_z = std::min(width_z, zguards);
+  }
+
+  // Coordinates of each point on the lattice, which is the same on
+  // all processors, with the first point in the bulk at zero
+  const auto latticeX = [&](int x) { return mesh->getGlobalXIndex(x) - mesh->xstart; };
+  const auto latticeY = [&](int y) { return mesh->getGlobalYIndex(y) - mesh->ystart; };
+  const auto latticeZ = [&](int z) { return mesh->getGlobalZIndex(z); };
+
+  // Flags for which couplings have been found, for each pair of
+  // variables and offset
+  std::vector<int> coupled(nvars * nvars * period_x * period_y * period_z, 0);
+  const auto coupling = [&](int row, int column, int x, int y, int z) -> int& {
+    return coupled[(((row * nvars + column) * period_x + positiveModulo(x, period_x))
+                        * period_y
+                    + positiveModulo(y, period_y))
+                       * period_z
+                   + positiveModulo(z, period_z)];
+  };
+
+  // Position of variable `var` relative to the index of a point. The
+  // 2D variables are stored with the first point in Z
+  const int zstart = mesh->zstart;
+  const auto varOffset = [&](int var, int z) {
+    return (var < n2d) ? var : var - n2d + ((z == zstart) ? n2d : 0);
+  };
+
+  const Field3D index = globalIndex(0);
+  const int nlocal = getLocalN();
+
+  std::vector<BoutReal> state(nlocal);
+  std::vector<BoutReal> base(nlocal);
+  std::vector<BoutReal> derivs(nlocal);
+  save_vars(state.data());
+  rhs();
+  save_derivs(base.data());
+
+  // Scale of the perturbations, so that the change in the time
+  // derivatives is not lost to rounding
+  std::vector<BoutReal> scale(nvars, 0.0);
+  for (const auto& i : mesh->getRegion3D("RGN_NOBNDRY")) {
+    const int ind = ROUND(index[i]);
+    for (int var = 0; var < nvars; ++var) {
+      if (var >= n2d or i.z() == zstart) {
+        scale[var] = std::max(scale[var], std::abs(state[ind + varOffset(var, i.z())]));
+      }
+    }
+  }
+
+  std::vector<BoutReal> perturbed(nlocal);
+  for (int column = 0; column < nvars; ++column) {
+    const bool column3D = column >= n2d;
+
+    perturbed = state;
+    for (const auto& i : mesh->getRegion3D("RGN_NOBNDRY")) {
+      if ((not column3D and i.z() != zstart)
+          or positiveModulo(latticeX(i.x()), period_x) != 0
+          or positiveModulo(latticeY(i.y()), period_y) != 0
+          or (column3D and positiveModulo(latticeZ(i.z()), period_z) != 0)) {
+        continue;
+      }
+      BoutReal& value = perturbed[ROUND(index[i]) + varOffset(column, i.z())];
+      value += 1e-3 * (std::abs(value) + ((scale[column] > 0.0) ? scale[column] : 1.0));
+    }
+
+    load_vars(perturbed.data());
+    rhs();
+    save_derivs(derivs.data());
+
+    for (const auto& i : mesh->getRegion3D("RGN_NOBNDRY")) {
+      const int ind = ROUND(index[i]);
+      const int x = offsetToLattice(latticeX(i.x()), period_x);
+      const int y = offsetToLattice(latticeY(i.y()), period_y);
+      const int z = column3D ? offsetToLattice(latticeZ(i.z()), period_z) : 0;
+      for (int row = 0; row < nvars; ++row) {
+        const bool row3D = row >= n2d;
+        if (not row3D and i.z() != zstart) {
+          continue;
+        }
+        const int k = ind + varOffset(row, i.z());
+        // Note: also true if the time derivative becomes NaN
+        if (not(derivs[k] == base[k])) {
+          // 2D variables depend on all Z points of 3D variables
+          coupling(row, column, x, y, row3D ? z : 0) = 1;
+        }
+      }
+    }
+  }
+
+  // Restore the state, and anything the RHS calculates from it
+  load_vars(state.data());
+  rhs();
+
+  bout::globals::mpi->MPI_Allreduce(MPI_IN_PLACE, coupled.data(),
+                                    static_cast<int>(coupled.size()), MPI_INT, MPI_MAX,
+                                    BoutComm::get());
+
+  // Couplings at the edge of the lattice may be wider ones seen
+  // through the neighbouring lattice point. Those within the guard
+  // cells are kept, but the pattern may be incomplete. Without guard
+  // cells in Z, offsets in Z wrap around
+  bool too_wide = false;
+  std::vector<JacobianCoupling> pattern;
+  for (int row = 0; row < nvars; ++row) {
+    for (int column = 0; column < nvars; ++column) {
+      const bool all_z = row < n2d and column >= n2d;
+      for (int x = -(period_x - 1) / 2; x <= period_x / 2; ++x) {
+        for (int y = -(period_y - 1) / 2; y <= period_y / 2; ++y) {
+          for (int z = -(period_z - 1) / 2; z <= period_z / 2; ++z) {
+            if ((coupling(row, column, x, y, z) == 0)
+                and not(row == column and x == 0 and y == 0 and z == 0)) {
+              continue;
+            }
+            if (std::abs(x) > width_x or std::abs(y) > width_y
+                or std::abs(z) > width_z) {
+              too_wide = true;
+            }
+            if (std::abs(x) <= mesh->xstart and std::abs(y) <= mesh->ystart
+                and (zguards == 0 or std::abs(z) <= zguards)) {
+              pattern.push_back({row, column, x, y, z, all_z});
+            }
+          }
+        }
+      }
+    }
+  }
+
+  output_info.write("Probed Jacobian pattern: {:d} couplings between {:d} variables, "
+                    "up to {:d}, {:d}, {:d} points away in X, Y, Z\n",
+                    pattern.size(), nvars, width_x, width_y, width_z);
+  if (too_wide) {
+    output_warn.write("WARNING: Found Jacobian couplings more than {:d}, {:d}, {:d} "
+                      "points away in X, Y, Z. Wider couplings may be missing from the "
+                      "pattern: increase jacobian_probe_width, or the number of guard "
+                      "cells\n",
+                      width_x, width_y, width_z);
+  }
+  return pattern;
+}
+
+std::vector<Solver::JacobianCoupling>
+Solver::getJacobianPattern(const std::function<void()>& rhs) {
+  const auto pattern_type =
+      (*options)["jacobian_pattern"]
+          .doc("How to find the sparsity pattern of the finite difference Jacobian: "
+               "star (nearest neighbours) or probe (perturb each variable and call "
+               "the RHS function)")
+          .withDefault(JacobianPattern::star);
+
+  if (pattern_type == JacobianPattern::star) {
+    return starJacobianPattern();
+  }
+  return probeJacobianPattern(
+      rhs, (*options)["jacobian_probe_width"]
+               .doc("Maximum distance of the couplings found with "
+                    "jacobian_pattern = probe")
+               .withDefault(2));
+}
+
+void Solver::forEachJacobianRow(
+    const std::vector<JacobianCoupling>& pattern, const Field3D& index,
+    const std::function<void(int row, const std::vector<int>& columns)>& function)
+    const {
+  Mesh* mesh = bout::globals::mesh;
+
+  const int n2d = f2d.size();
+  const int nvars = n2d + f3d.size();
+
+  // The evolving points in Z. Any Z guard cells hold the indices of
+  // points on the neighbouring processors in Z
+  const int zstart = mesh->zstart;
+  const int zend = mesh->zend;
+  const int mzsub = zend - zstart + 1;
+  const int nz = mesh->LocalNz;
+  const int nzpe = mesh->getNZPE();
+
+  // The couplings of each variable
+  std::vector<std::vector<JacobianCoupling>> couplings(nvars);
+  bool any_all_z = false;
+  for (const auto& coupling : pattern) {
+    couplings[coupling.row].push_back(coupling);
+    any_all_z = any_all_z or coupling.all_z;
+  }
+
+  // Position of variable `var` relative to the index of a point. The
+  // 2D variables are stored with the first point in Z on each processor
+  const auto varOffset = [&](int var, bool first) {
+    return (var < n2d) ? var : var - n2d + (first ? n2d : 0);
+  };
+
+  // Index of variable `var` at (x, y, z), or -1 if not evolving
+  const auto columnIndex = [&](int var, int x, int y, int z) {
+    const int ind = ROUND(index(x, y, z));
+    if (ind < 0) {
+      return -1;
+    }
+    const bool first =
+        positiveModulo(mesh->getGlobalZIndex(z), mesh->GlobalNz) % mzsub == 0;
+    return ind + varOffset(var, first);
+  };
+
+  // Couplings to all of Z need the indices on the other processors
+  // in Z. Gather the index of every point in X-Y, so that the global
+  // line for the point xy is at xy * mzsub in the block of each processor
+  const int nxy = mesh->LocalNx * mesh->LocalNy;
+  Array<int> all_index;
+  if (any_all_z and nzpe > 1) {
+    Array<int> local_index(nxy * mzsub);
+    for (int x = 0; x < mesh->LocalNx; ++x) {
+      for (int y = 0; y < mesh->LocalNy; ++y) {
+        for (int k = 0; k < mzsub; ++k) {
+          local_index[(x * mesh->LocalNy + y) * mzsub + k] = ROUND(index(x, y, zstart + k));
+        }
+      }
+    }
+    all_index.reallocate(nzpe * nxy * mzsub);
+    std::vector<int> send_counts(nzpe, nxy * mzsub);
+    std::vector<int> send_displs(nzpe, 0);
+    std::vector<int> recv_displs(nzpe);
+    for (int p = 0; p < nzpe; ++p) {
+      recv_displs[p] = p * nxy * mzsub;
+    }
+    mesh->getMpi().MPI_Alltoallv(local_index.begin(), send_counts.data(),
+                                 send_displs.data(), MPI_INT, all_index.begin(),
+                                 send_counts.data(), recv_displs.data(), MPI_INT,
+                                 mesh->getZcomm());
+  }
+
+  std::vector<int> columns;
+  for (int x = mesh->xstart; x <= mesh->xend; x++) {
+    for (int y = mesh->ystart; y <= mesh->yend; y++) {
+      for (int z = zstart; z <= zend; z++) {
+        for (int row = 0; row < nvars; ++row) {
+          if (row < n2d and z != zstart) {
+            continue;
+          }
+          columns.clear();
+          for (const auto& coupling : couplings[row]) {
+            const int xi = x + coupling.x;
+            const int yi = y + coupling.y;
+            if ((xi < 0) or (yi < 0) or (xi >= mesh->LocalNx) or (yi >= mesh->LocalNy)) {
+              continue;
+            }
+            if (coupling.column < n2d) {
+              columns.push_back(columnIndex(coupling.column, xi, yi, zstart));
+            } else if (coupling.all_z and nzpe > 1) {
+              const int xy = xi * mesh->LocalNy + yi;
+              for (int p = 0; p < nzpe; ++p) {
+                for (int k = 0; k < mzsub; ++k) {
+                  const int ind = all_index[(p * nxy + xy) * mzsub + k];
+                  columns.push_back((ind < 0) ? -1
+                                              : ind + varOffset(coupling.column, k == 0));
+                }
+              }
+            } else if (coupling.all_z) {
+              for (int zi = zstart; zi <= zend; ++zi) {
+                columns.push_back(columnIndex(coupling.column, xi, yi, zi));
+              }
+            } else if (zstart > 0) {
+              // Couplings reach into the Z guard cells, but no further
+              const int zi = z + coupling.z;
+              if ((zi >= 0) and (zi < nz)) {
+                columns.push_back(columnIndex(coupling.column, xi, yi, zi));
+              }
+            } else {
+              const int zi = positiveModulo(z + coupling.z, nz);
+              columns.push_back(columnIndex(coupling.column, xi, yi, zi));
+            }
+          }
+          // Remove boundary points and duplicates
+          columns.erase(std::remove(columns.begin(), columns.end(), -1), columns.end());
+          std::sort(columns.begin(), columns.end());
+          columns.erase(std::unique(columns.begin(), columns.end()), columns.end());
+
+          function(columnIndex(row, x, y, z), columns);
+        }
+      }
+    }
+  }
+}
+
 /**************************************************************************
  * Running user-supplied functions
  **************************************************************************/
@@ -43,6 +43,10 @@ double FieldGenerator::generate(const Context& ctx) {
   return generate(ctx.x(), ctx.y(), ctx.z(), ctx.t());
 }
 
+int FieldGenerator::compile(bout::generator::Program& program) {
+  return program.addGeneric(*this);
+}
+
 /////////////////////////////////////////////
 namespace { // These classes only visible in this file
 
@@ -54,6 +58,9 @@ public:
     return std::make_shared<FieldX>();
   }
   double generate(const Context& ctx) override { return ctx.x(); }
+  int compile(bout::generator::Program&) override {
+    return bout::generator::Program::x_register;
+  }
   std::string str() const override { return "x"s; }
 };
 
@@ -63,6 +70,9 @@ public:
     return std::make_shared<FieldY>();
   }
   double generate(const Context& ctx) override { return ctx.y(); }
+  int compile(bout::generator::Program&) override {
+    return bout::generator::Program::y_register;
+  }
   std::string str() const override { return "y"s; }
 };
 
@@ -72,6 +82,9 @@ public:
     return std::make_shared<FieldZ>();
   }
   double generate(const Context& ctx) override { return ctx.z(); }
+  int compile(bout::generator::Program&) override {
+    return bout::generator::Program::z_register;
+  }
   std::string str() const override { return "z"; }
 };
 
@@ -81,19 +94,23 @@ public:
     return std::make_shared<FieldT>();
   }
   double generate(const Context& ctx) override { return ctx.t(); }
+  int compile(bout::generator::Program&) override {
+    return bout::generator::Program::t_register;
+  }
   std::string str() const override { return "t"s; }
 };
 
 class FieldParam : public FieldGenerator {
 public:
-  FieldParam(const std::string name) : name(name) {}
+  FieldParam(const std::string name) : name(name), slot(Context::slot(name)) {}
   double generate(const Context& ctx) override {
-    return ctx.get(name); // Get a parameter
+    return ctx.get(slot); // Get a parameter
   }
   std::string str() const override { return "{"s + name + "}"s; }
 
 private:
   std::string name; // The name of the parameter to look up
+  int slot;         // The Context slot holding the parameter
 };
 
 /// Define a new context to evaluate an expression in
@@ -105,15 +122,20 @@ public:
   /// Create with a list of context variables to modify
   /// and an expression to evaluate in that new context
   FieldContext(variable_list variables, FieldGeneratorPtr expr)
-      : variables(std::move(variables)), expr(std::move(expr)) {}
+      : variables(std::move(variables)), expr(std::move(expr)) {
+    slots.reserve(this->variables.size());
+    for (const auto& var : this->variables) {
+      slots.push_back(Context::slot(var.first));
+    }
+  }
 
   double generate(const Context& ctx) override {
     // Create a new context
     Context new_context{ctx};
 
     // Set values in the context by evaluating the generators
-    for (auto const& var : variables) {
-      new_context.set(var.first, var.second->generate(ctx));
+    for (std::size_t i = 0; i < variables.size(); ++i) {
+      new_context.set(slots[i], variables[i].second->generate(ctx));
     }
 
     // Evaluate the expression in the new context
@@ -130,6 +152,7 @@ public:
 
 private:
   variable_list variables; ///< A list of context variables to modify
+  std::vector<int> slots;  ///< The Context slot of each variable
   FieldGeneratorPtr expr;  ///< The expression to evaluate in the new context
 };
 
@@ -140,7 +163,7 @@ public:
   /// The count is calculated by evaluating COUNTEXPR, which must be a non-negative integer
   /// Each iteration the expression EXPR is evaluated and the results summed.
   FieldSum(const std::string& sym, FieldGeneratorPtr countexpr, FieldGeneratorPtr expr)
-      : sym(sym), countexpr(countexpr), expr(expr) {}
+      : sym(sym), slot(Context::slot(sym)), countexpr(countexpr), expr(expr) {}
 
   double generate(const Context& ctx) override {
     // Get the count by evaluating the count expression
@@ -159,7 +182,7 @@ public:
     Context new_context{ctx}; // Make a copy, so the counter value can be set
     for (int i = 0; i < count; i++) {
       // Evaluate the expression, setting the given symbol to the loop counter
-      new_context.set(sym, i);
+      new_context.set(slot, i);
       result += expr->generate(new_context);
     }
     return result;
@@ -171,6 +194,7 @@ public:
 
 private:
   std::string sym;
+  int slot; ///< The Context slot holding the loop counter
   FieldGeneratorPtr countexpr, expr;
 };
 
@@ -203,6 +227,19 @@ BoutReal FieldBinary::generate(const Context& ctx) {
   throw ParseException("Unknown binary operator '{:c}'", op);
 }
 
+int FieldBinary::compile(bout::generator::Program& program) {
+  switch (op) {
+  case '+':
+  case '-':
+  case '*':
+  case '/':
+  case '^':
+    return program.addOperator(op, lhs->compile(program), rhs->compile(program));
+  }
+  // Unknown operator, which generate() will complain about
+  return program.addGeneric(*this);
+}
+
 /////////////////////////////////////////////
 
 ExpressionParser::ExpressionParser() {
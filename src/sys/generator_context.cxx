@@ -3,23 +3,100 @@
 #include "bout/constants.hxx"
 #include "bout/mesh.hxx"
 
+#include <algorithm>
+#include <iterator>
+#include <mutex>
+#include <vector>
+
 namespace bout {
 namespace generator {
 
+namespace {
+/// Names of the parameters in each slot. Guarded by a mutex so that
+/// expressions can be parsed while other threads evaluate them
+struct SlotNames {
+  std::mutex mutex;
+  std::vector<std::string> names{"x", "y", "z", "t"};
+};
+
+SlotNames& slotNames() {
+  static SlotNames slot_names;
+  return slot_names;
+}
+
+/// Slot of \p name in \p names, or -1 if it hasn't been added
+int findSlot(const std::vector<std::string>& names, const std::string& name) {
+  const auto it = std::find(names.begin(), names.end(), name);
+  return (it == names.end()) ? -1 : static_cast<int>(std::distance(names.begin(), it));
+}
+} // namespace
+
+int Context::slot(const std::string& name) {
+  auto& slot_names = slotNames();
+  std::lock_guard<std::mutex> lock(slot_names.mutex);
+
+  auto& names = slot_names.names;
+  const int existing = findSlot(names, name);
+  if (existing >= 0) {
+    return existing;
+  }
+  names.push_back(name);
+  return static_cast<int>(names.size()) - 1;
+}
+
+std::string Context::slotName(int slot) {
+  auto& slot_names = slotNames();
+  std::lock_guard<std::mutex> lock(slot_names.mutex);
+  return slot_names.names.at(slot);
+}
+
+BoutReal Context::get(const std::string& name) const {
+  int name_slot = -1;
+  {
+    auto& slot_names = slotNames();
+    std::lock_guard<std::mutex> lock(slot_names.mutex);
+    name_slot = findSlot(slot_names.names, name);
+  }
+  if (name_slot < 0) {
+    throw BoutException("Parameter '{:s}' has not been set in this context", name);
+  }
+  return get(name_slot);
+}
+
+BoutReal Context::getExtra(int slot) const {
+  const auto it = extra_values.find(slot);
+  if (it == extra_values.end()) {
+    throwNotSet(slot);
+  }
+  return it->second;
+}
+
+void Context::throwNotSet(int slot) {
+  throw BoutException("Parameter '{:s}' has not been set in this context",
+                      slotName(slot));
+}
+
+namespace {
+/// Z coordinate of local Z index \p iz. Uses the global index, so
+/// that Z is continuous if it is split between processors
+BoutReal zCoordinate(const Mesh* msh, int iz, CELL_LOC loc) {
+  const BoutReal iz_global = msh->getGlobalZIndex(iz) - ((loc == CELL_ZLOW) ? 0.5 : 0.0);
+  return TWOPI * iz_global / static_cast<BoutReal>(msh->GlobalNz);
+}
+} // namespace
+
 Context::Context(int ix, int iy, int iz, CELL_LOC loc, Mesh* msh, BoutReal t)
     : localmesh(msh) {
 
-  parameters["x"] = (loc == CELL_XLOW) ? 0.5 * (msh->GlobalX(ix) + msh->GlobalX(ix - 1))
-                                       : msh->GlobalX(ix);
+  values[x_slot] = (loc == CELL_XLOW) ? 0.5 * (msh->GlobalX(ix) + msh->GlobalX(ix - 1))
+                                      : msh->GlobalX(ix);
 
-  parameters["y"] = (loc == CELL_YLOW) ? PI * (msh->GlobalY(iy) + msh->GlobalY(iy - 1))
-                                       : TWOPI * msh->GlobalY(iy);
+  values[y_slot] = (loc == CELL_YLOW) ? PI * (msh->GlobalY(iy) + msh->GlobalY(iy - 1))
+                                      : TWOPI * msh->GlobalY(iy);
 
-  parameters["z"] = (loc == CELL_ZLOW)
-                        ? TWOPI * (iz - 0.5) / static_cast<BoutReal>(msh->LocalNz)
-                        : TWOPI * iz / static_cast<BoutReal>(msh->LocalNz);
+  values[z_slot] = zCoordinate(msh, iz, loc);
 
-  parameters["t"] = t;
+  values[t_slot] = t;
 }
 
 Context::Context(const BoundaryRegion* bndry, int iz, CELL_LOC loc, BoutReal t, Mesh* msh)
@@ -28,21 +105,19 @@ Context::Context(const BoundaryRegion* bndry, int iz, CELL_LOC loc, BoutReal t,
   // Add one to X index if boundary is in -x direction, so that XLOW is on the boundary
   int ix = (bndry->bx < 0) ? bndry->x + 1 : bndry->x;
 
-  parameters["x"] = ((loc == CELL_XLOW) || (bndry->bx != 0))
-                        ? 0.5 * (msh->GlobalX(ix) + msh->GlobalX(ix - 1))
-                        : msh->GlobalX(ix);
+  values[x_slot] = ((loc == CELL_XLOW) || (bndry->bx != 0))
+                       ? 0.5 * (msh->GlobalX(ix) + msh->GlobalX(ix - 1))
+                       : msh->GlobalX(ix);
 
   int iy = (bndry->by < 0) ? bndry->y + 1 : bndry->y;
 
-  parameters["y"] = ((loc == CELL_YLOW) || bndry->by)
-                        ? PI * (msh->GlobalY(iy) + msh->GlobalY(iy - 1))
-                        : TWOPI * msh->GlobalY(iy);
+  values[y_slot] = ((loc == CELL_YLOW) || bndry->by)
+                       ? PI * (msh->GlobalY(iy) + msh->GlobalY(iy - 1))
+                       : TWOPI * msh->GlobalY(iy);
 
-  parameters["z"] = (loc == CELL_ZLOW)
-                        ? TWOPI * (iz - 0.5) / static_cast<BoutReal>(msh->LocalNz)
-                        : TWOPI * iz / static_cast<BoutReal>(msh->LocalNz);
+  values[z_slot] = zCoordinate(msh, iz, loc);
 
-  parameters["t"] = t;
+  values[t_slot] = t;
 }
 
 } // namespace generator
@@ -0,0 +1,182 @@
+#include "bout/sys/generator_program.hxx"
+
+#include "bout/assert.hxx"
+#include "bout/boutexception.hxx"
+#include "bout/openmpwrap.hxx"
+#include "bout/sys/expressionparser.hxx"
+
+#include <algorithm>
+#include <cmath>
+
+namespace bout {
+namespace generator {
+
+Program::Program(FieldGeneratorPtr generator) : root(std::move(generator)) {
+  if (!root) {
+    throw BoutException("Couldn't compile a null generator");
+  }
+  result_register = root->compile(*this);
+}
+
+int Program::addInstruction(Instruction instruction) {
+  instruction.result = num_registers++;
+  instructions.push_back(instruction);
+  return instruction.result;
+}
+
+int Program::addConstant(BoutReal value) {
+  Instruction instruction{OpCode::constant, 0};
+  instruction.value = value;
+  return addInstruction(instruction);
+}
+
+int Program::addValuePointer(const BoutReal* value) {
+  Instruction instruction{OpCode::value_pointer, 0};
+  instruction.value_pointer = value;
+  return addInstruction(instruction);
+}
+
+int Program::addOperator(char op, int lhs, int rhs) {
+  OpCode code{};
+  switch (op) {
+  case '+':
+    code = OpCode::add;
+    break;
+  case '-':
+    code = OpCode::subtract;
+    break;
+  case '*':
+    code = OpCode::multiply;
+    break;
+  case '/':
+    code = OpCode::divide;
+    break;
+  case '^':
+    code = OpCode::power;
+    break;
+  default:
+    throw BoutException("Can't compile unknown binary operator '{:c}'", op);
+  }
+  return addInstruction({code, 0, lhs, rhs});
+}
+
+int Program::addFunction(UnaryFunction function, int arg) {
+  Instruction instruction{OpCode::unary, 0, arg};
+  instruction.unary = function;
+  return addInstruction(instruction);
+}
+
+int Program::addFunction(BinaryFunction function, int arg1, int arg2) {
+  Instruction instruction{OpCode::binary, 0, arg1, arg2};
+  instruction.binary = function;
+  return addInstruction(instruction);
+}
+
+int Program::addMin(int lhs, int rhs) { return addInstruction({OpCode::min, 0, lhs, rhs}); }
+
+int Program::addMax(int lhs, int rhs) { return addInstruction({OpCode::max, 0, lhs, rhs}); }
+
+int Program::addGeneric(FieldGenerator& generator) {
+  Instruction instruction{OpCode::generic, 0};
+  instruction.generator = &generator;
+  return addInstruction(instruction);
+}
+
+int Program::numGeneric() const {
+  return static_cast<int>(
+      std::count_if(instructions.begin(), instructions.end(),
+                    [](const auto& ins) { return ins.code == OpCode::generic; }));
+}
+
+void Program::evaluate(Workspace& workspace, int n, const BoutReal* x, const BoutReal* y,
+                       const BoutReal* z, BoutReal t, BoutReal* result,
+                       const std::function<Context(int)>& context) const {
+  ASSERT1(n <= workspace.max_points);
+  ASSERT1(workspace.data.size()
+          >= static_cast<std::size_t>(num_registers) * workspace.max_points);
+
+  BoutReal* const data = workspace.data.data();
+  const auto stride = static_cast<std::size_t>(workspace.max_points);
+  const auto reg = [&](int index) { return data + index * stride; };
+
+  std::copy_n(x, n, reg(x_register));
+  std::copy_n(y, n, reg(y_register));
+  std::copy_n(z, n, reg(z_register));
+  std::fill_n(reg(t_register), n, t);
+
+  for (const auto& ins : instructions) {
+    BoutReal* const out = reg(ins.result);
+    const BoutReal* const a = (ins.arg1 >= 0) ? reg(ins.arg1) : nullptr;
+    const BoutReal* const b = (ins.arg2 >= 0) ? reg(ins.arg2) : nullptr;
+
+    switch (ins.code) {
+    case OpCode::constant:
+      std::fill_n(out, n, ins.value);
+      break;
+    case OpCode::value_pointer:
+      std::fill_n(out, n, *ins.value_pointer);
+      break;
+    case OpCode::add:
+      BOUT_OMP(simd)
+      for (int i = 0; i < n; ++i) {
+        out[i] = a[i] + b[i];
+      }
+      break;
+    case OpCode::subtract:
+      BOUT_OMP(simd)
+      for (int i = 0; i < n; ++i) {
+        out[i] = a[i] - b[i];
+      }
+      break;
+    case OpCode::multiply:
+      BOUT_OMP(simd)
+      for (int i = 0; i < n; ++i) {
+        out[i] = a[i] * b[i];
+      }
+      break;
+    case OpCode::divide:
+      BOUT_OMP(simd)
+      for (int i = 0; i < n; ++i) {
+        out[i] = a[i] / b[i];
+      }
+      break;
+    case OpCode::power:
+      for (int i = 0; i < n; ++i) {
+        out[i] = std::pow(a[i], b[i]);
+      }
+      break;
+    case OpCode::min:
+      BOUT_OMP(simd)
+      for (int i = 0; i < n; ++i) {
+        out[i] = (b[i] < a[i]) ? b[i] : a[i];
+      }
+      break;
+    case OpCode::max:
+      BOUT_OMP(simd)
+      for (int i = 0; i < n; ++i) {
+        out[i] = (b[i] > a[i]) ? b[i] : a[i];
+      }
+      break;
+    case OpCode::unary:
+      for (int i = 0; i < n; ++i) {
+        out[i] = ins.unary(a[i]);
+      }
+      break;
+    case OpCode::binary:
+      for (int i = 0; i < n; ++i) {
+        out[i] = ins.binary(a[i], b[i]);
+      }
+      break;
+    case OpCode::generic:
+      for (int i = 0; i < n; ++i) {
+        out[i] = ins.generator->generate(context(i));
+      }
+      break;
+    }
+  }
+
+  std::copy_n(reg(result_register), n, result);
+}
+
+} // namespace generator
+} // namespace bout
@@ -29,13 +29,27 @@
 #include <bout/output.hxx>
 #include <cstdarg>
 #include <string>
+#include <thread>
 
 #if BOUT_USE_OPENMP
 #include <omp.h>
 #endif
 
 #if BOUT_USE_MSGSTACK
+bool MsgStack::isOtherThread() const {
+#if BOUT_USE_OPENMP
+  // OpenMP threads are handled by each function
+  if (omp_in_parallel()) {
+    return false;
+  }
+#endif
+  return std::this_thread::get_id() != owner;
+}
+
 int MsgStack::push(std::string message) {
+  if (isOtherThread()) {
+    return 0;
+  }
 
 #if BOUT_USE_OPENMP
   // This is temporary fix: no messages from OMP regions if there's
@@ -55,7 +69,7 @@ int MsgStack::push(std::string message) {
 }
 
 void MsgStack::pop() {
-  if (position <= 0) {
+  if (position <= 0 or isOtherThread()) {
     return;
   }
   BOUT_OMP(single)
@@ -63,6 +77,9 @@ void MsgStack::pop() {
 }
 
 void MsgStack::pop(int id) {
+  if (isOtherThread()) {
+    return;
+  }
 #if BOUT_USE_OPENMP
   if (omp_get_num_threads() > 1) {
     return;
@@ -78,6 +95,9 @@ void MsgStack::pop(int id) {
 }
 
 void MsgStack::clear() {
+  if (isOtherThread()) {
+    return;
+  }
   BOUT_OMP(single)
   {
     stack.clear();
@@ -92,6 +112,9 @@ void MsgStack::dump() {
 
 std::string MsgStack::getDump() {
   std::string res = "====== Back trace ======\n";
+  if (isOtherThread()) {
+    return res;
+  }
   for (int i = position - 1; i >= 0; i--) {
     if (stack[i] != "") {
       res += " -> ";
@@ -0,0 +1,175 @@
+#include "bout/async_writer.hxx"
+
+#include "bout/boutexception.hxx"
+#include "bout/output.hxx"
+#include "bout/unused.hxx"
+#include "bout/utils.hxx"
+
+#include <memory>
+#include <stdexcept>
+
+namespace bout {
+namespace {
+/// Makes the data of a value unique, copying it if it is shared
+struct MakeUniqueVisitor {
+  template <typename T>
+  void operator()(T& UNUSED(value)) {}
+  void operator()(Field2D& value) { makeUnique(value); }
+  void operator()(Field3D& value) { makeUnique(value); }
+  void operator()(FieldPerp& value) { makeUnique(value); }
+  void operator()(Array<BoutReal>& value) { value.ensureUnique(); }
+  void operator()(Matrix<BoutReal>& value) { value.ensureUnique(); }
+  void operator()(Tensor<BoutReal>& value) { value.ensureUnique(); }
+
+private:
+  template <typename T>
+  void makeUnique(T& field) {
+    if (field.isAllocated()) {
+      field.allocate();
+    }
+  }
+};
+
+void makeUnique(Options& options) {
+  if (options.isValue()) {
+    bout::utils::visit(MakeUniqueVisitor{}, options.value);
+    return;
+  }
+  for (const auto& child : options.getChildren()) {
+    makeUnique(options[child.first]);
+  }
+}
+} // namespace
+
+Options snapshot(const Options& options) {
+  // Copying shares the underlying data, so now make it unique
+  Options result = options;
+  makeUnique(result);
+  return result;
+}
+
+AsyncWriter::AsyncWriter(bool async) : async(async) {
+  if (async) {
+    writer = std::thread(&AsyncWriter::run, this);
+  }
+}
+
+AsyncWriter::~AsyncWriter() {
+  try {
+    flush();
+  } catch (const std::exception& e) {
+    output_error.write("Error writing output: {:s}\n", e.what());
+  }
+  if (writer.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop = true;
+    }
+    condition.notify_all();
+    writer.join();
+  }
+}
+
+void AsyncWriter::write(OptionsNetCDF& file, const Options& options,
+                        const std::string& time_dim) {
+  if (not async) {
+    file.write(options, time_dim);
+    return;
+  }
+  // std::function must be copyable, so share the snapshot
+  auto data = std::make_shared<Options>(snapshot(options));
+  add([&file, data, time_dim]() { file.write(*data, time_dim); });
+}
+
+void AsyncWriter::verifyTimesteps(OptionsNetCDF& file) {
+  add([&file]() { file.verifyTimesteps(); });
+}
+
+void AsyncWriter::add(std::function<void()> task) {
+  if (not async) {
+    task();
+    return;
+  }
+  pending.push_back(std::move(task));
+}
+
+void AsyncWriter::waitForWriter() {
+  std::exception_ptr writer_error;
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [this]() { return not busy; });
+    std::swap(writer_error, error);
+  }
+  // Free the snapshots here rather than on the writer thread
+  in_flight.clear();
+
+  if (writer_error) {
+    // Make the BoutException on this thread, which owns the message
+    // stack (see MsgStack)
+    try {
+      std::rethrow_exception(writer_error);
+    } catch (const std::exception& e) {
+      throw BoutException(e.what());
+    }
+  }
+}
+
+void AsyncWriter::finishStep() {
+  if (not async) {
+    return;
+  }
+  waitForWriter();
+
+  if (pending.empty()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::swap(in_flight, pending);
+    busy = true;
+  }
+  condition.notify_all();
+}
+
+void AsyncWriter::flush() {
+  finishStep();
+  if (async) {
+    waitForWriter();
+  }
+}
+
+void AsyncWriter::run() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    condition.wait(lock, [this]() { return busy or stop; });
+    if (not busy) {
+      return;
+    }
+    lock.unlock();
+
+    // Stop at the first error, as later writes in the batch may
+    // depend on it
+    std::exception_ptr batch_error;
+    for (auto& task : in_flight) {
+      // Only keep the message, so that no BoutException is shared
+      // between threads
+      try {
+        task();
+      } catch (const std::exception& e) {
+        batch_error = std::make_exception_ptr(std::runtime_error(e.what()));
+        break;
+      } catch (...) {
+        batch_error =
+            std::make_exception_ptr(std::runtime_error("Unknown error writing output"));
+        break;
+      }
+    }
+
+    lock.lock();
+    error = batch_error;
+    busy = false;
+    condition.notify_all();
+  }
+}
+
+} // namespace bout
@@ -1,7 +1,5 @@
 #include "bout/build_config.hxx"
 
-#if BOUT_HAS_NETCDF && !BOUT_HAS_LEGACY_NETCDF
-
 #include "bout/options_netcdf.hxx"
 
 #include "bout/bout.hxx"
@@ -9,17 +7,38 @@
 #include "bout/mesh.hxx"
 #include "bout/sys/timer.hxx"
 
+#if BOUT_HAS_NETCDF && !BOUT_HAS_LEGACY_NETCDF
+
+#include <algorithm>
 #include <exception>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
 #include <netcdf>
+#include <netcdf_meta.h>
 #include <vector>
 
+#if NC_HAS_PARALLEL4
+#include <netcdf_par.h>
+#endif
+
 using namespace netCDF;
 
 namespace {
 /// Name of the attribute used to track individual variable's time indices
 constexpr auto current_time_index_name = "current_time_index";
 
+/// NetCDF and HDF5 aren't thread-safe, but output files may be
+/// written from a background thread (see bout::AsyncWriter) while
+/// the simulation reads other files. Every call into NetCDF,
+/// including closing files, is made with this lock held
+std::mutex& netcdfMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
 /// NetCDF doesn't keep track of the current for each variable
 /// (although the underlying HDF5 file does!), so we need to do it
 /// ourselves. We'll use an attribute in the file to do so, which
@@ -56,7 +75,14 @@ T readAttribute(const NcAtt& attribute) {
   return value;
 }
 
-void readGroup(const std::string& filename, const NcGroup& group, Options& result) {
+/// Read the variables in \p group and its subgroups into \p
+/// result. If \p max_dimensions is not negative, the values of
+/// floating point variables with more dimensions than this are not
+/// read: they are only given their attributes, and their names
+/// (prefixed with \p prefix) and shapes are added to \p skipped
+void readGroup(const std::string& filename, const NcGroup& group, Options& result,
+               int max_dimensions, const std::string& prefix,
+               std::map<std::string, std::vector<int>>& skipped) {
 
   // Iterate over all variables
   for (const auto& varpair : group.getVars()) {
@@ -67,6 +93,16 @@ void readGroup(const std::string& filename, const NcGroup& group, Options& resul
     auto ndims = var.getDimCount(); // Number of dimensions
     auto dims = var.getDims();      // Vector of dimensions
 
+    if (max_dimensions >= 0 and ndims > max_dimensions
+        and (var_type == ncDouble or var_type == ncFloat)) {
+      std::vector<int> shape;
+      for (const auto& dim : dims) {
+        shape.push_back(static_cast<int>(dim.getSize()));
+      }
+      skipped[prefix + var_name] = shape;
+      ndims = -1; // Skip reading the value
+    }
+
     switch (ndims) {
     case 0: {
       // Scalar variables
@@ -144,8 +180,23 @@ void readGroup(const std::string& filename, const NcGroup& group, Options& resul
     const auto& name = grouppair.first;
     const auto& subgroup = grouppair.second;
 
-    readGroup(filename, subgroup, result[name]);
+    readGroup(filename, subgroup, result[name], max_dimensions, prefix + name + ":",
+              skipped);
+  }
+}
+
+/// Find variable \p name, which may be in a subgroup if it contains
+/// ':' separators, e.g. "group:variable"
+NcVar findVariable(const NcGroup& group, const std::string& name) {
+  const auto separator = name.find(':');
+  if (separator == std::string::npos) {
+    return group.getVar(name);
   }
+  const auto subgroup = group.getGroup(name.substr(0, separator));
+  if (subgroup.isNull()) {
+    return {};
+  }
+  return findVariable(subgroup, name.substr(separator + 1));
 }
 } // namespace
 
@@ -153,6 +204,7 @@ namespace bout {
 
 Options OptionsNetCDF::read() {
   Timer timer("io");
+  std::lock_guard<std::mutex> lock(netcdfMutex());
 
   // Open file
   const NcFile read_file(filename, NcFile::read);
@@ -162,7 +214,100 @@ Options OptionsNetCDF::read() {
   }
 
   Options result;
-  readGroup(filename, read_file, result);
+  std::map<std::string, std::vector<int>> skipped;
+  readGroup(filename, read_file, result, -1, "", skipped);
+
+  return result;
+}
+
+Options OptionsNetCDF::read(int max_dimensions,
+                            std::map<std::string, std::vector<int>>& skipped) {
+  Timer timer("io");
+  std::lock_guard<std::mutex> lock(netcdfMutex());
+
+  const NcFile read_file(filename, NcFile::read);
+
+  if (read_file.isNull()) {
+    throw BoutException("Could not open NetCDF file '{:s}' for reading", filename);
+  }
+
+  Options result;
+  readGroup(filename, read_file, result, max_dimensions, "", skipped);
+
+  return result;
+}
+
+Options OptionsNetCDF::readSlab(const std::string& name, const std::vector<int>& start,
+                                const std::vector<int>& count) {
+  Timer timer("io");
+  std::lock_guard<std::mutex> lock(netcdfMutex());
+
+  // Keep the file open, as the variables in a grid file are usually
+  // read one after another
+  if (not slab_file) {
+    auto read_file = std::make_unique<netCDF::NcFile>(filename, NcFile::read);
+    if (read_file->isNull()) {
+      throw BoutException("Could not open NetCDF file '{:s}' for reading", filename);
+    }
+    slab_file = std::move(read_file);
+  }
+
+  const auto var = findVariable(*slab_file, name);
+  if (var.isNull()) {
+    throw BoutException("Variable '{:s}' not found in '{:s}'", name, filename);
+  }
+
+  const auto ndims = var.getDimCount();
+  if ((start.size() != static_cast<std::size_t>(ndims))
+      or (count.size() != static_cast<std::size_t>(ndims))) {
+    throw BoutException("Reading part of '{:s}' in '{:s}': expected {:d} dimensions, "
+                        "but got {:d} starts and {:d} counts",
+                        name, filename, ndims, start.size(), count.size());
+  }
+  const auto dims = var.getDims();
+  for (int i = 0; i < ndims; ++i) {
+    if (start[i] < 0 or count[i] < 0
+        or static_cast<std::size_t>(start[i]) + count[i] > dims[i].getSize()) {
+      throw BoutException("Reading part of '{:s}' in '{:s}': {:d} elements from index "
+                          "{:d} are outside dimension {:d} of size {:d}",
+                          name, filename, count[i], start[i], i, dims[i].getSize());
+    }
+  }
+  const auto var_type = var.getType();
+  if (var_type != ncDouble and var_type != ncFloat) {
+    throw BoutException("Can only read parts of floating point variables, but '{:s}' "
+                        "in '{:s}' is {:s}",
+                        name, filename, var_type.getName());
+  }
+
+  const std::vector<std::size_t> startp(start.begin(), start.end());
+  const std::vector<std::size_t> countp(count.begin(), count.end());
+
+  Options result;
+  switch (ndims) {
+  case 1: {
+    Array<BoutReal> value(count[0]);
+    var.getVar(startp, countp, value.begin());
+    result = value;
+    break;
+  }
+  case 2: {
+    Matrix<BoutReal> value(count[0], count[1]);
+    var.getVar(startp, countp, value.begin());
+    result = value;
+    break;
+  }
+  case 3: {
+    Tensor<BoutReal> value(count[0], count[1], count[2]);
+    var.getVar(startp, countp, value.begin());
+    result = value;
+    break;
+  }
+  default:
+    throw BoutException("Can't read part of '{:s}' in '{:s}' with {:d} dimensions",
+                        name, filename, ndims);
+  }
+  result.attributes["source"] = filename;
 
   return result;
 }
@@ -221,9 +366,72 @@ NcType NcTypeVisitor::operator()<FieldPerp>(const FieldPerp& UNUSED(t)) {
   return operator()<BoutReal>(0.0);
 }
 
+/// Where this processor's part of a field goes in the global arrays
+/// written to a parallel file
+struct GlobalLayout {
+  /// Range of local indices written by this processor (inclusive)
+  int xs, xe, ys, ye, zs, ze;
+  /// Global index of the point (xs, ys, zs)
+  int global_x, global_y, global_z;
+  /// Size of the global arrays
+  int nx, ny, nz;
+  /// Largest part of the global arrays on any processor. Chunk sizes
+  /// must be the same on all processors, which may have different
+  /// sized domains
+  int max_local_nx, max_local_ny, max_local_nz;
+};
+
+/// Layouts of the fields on each mesh for one parallel write.
+/// Creating a layout is collective, but fields are visited in the
+/// same order on all processors
+class GlobalLayouts {
+public:
+  const GlobalLayout& get(Mesh* mesh) {
+    auto it = layouts.find(mesh);
+    if (it != layouts.end()) {
+      return it->second;
+    }
+
+    GlobalLayout layout;
+    // X boundary cells are included, Y boundary cells are not
+    layout.xs = mesh->firstX() ? 0 : mesh->xstart;
+    layout.xe = mesh->lastX() ? mesh->LocalNx - 1 : mesh->xend;
+    layout.ys = mesh->ystart;
+    layout.ye = mesh->yend;
+    layout.zs = mesh->zstart;
+    layout.ze = mesh->zend;
+
+    layout.global_x = mesh->getGlobalXIndex(layout.xs);
+    layout.global_y = mesh->getGlobalYIndexNoBoundaries(layout.ys);
+    layout.global_z = mesh->getGlobalZIndexNoBoundaries(layout.zs);
+
+    int local_sizes[6] = {mesh->getGlobalXIndex(layout.xe) + 1,
+                          mesh->getGlobalYIndexNoBoundaries(layout.ye) + 1,
+                          mesh->getGlobalZIndexNoBoundaries(layout.ze) + 1,
+                          layout.xe - layout.xs + 1,
+                          layout.ye - layout.ys + 1,
+                          layout.ze - layout.zs + 1};
+    int max_sizes[6];
+    MPI_Allreduce(local_sizes, max_sizes, 6, MPI_INT, MPI_MAX, BoutComm::get());
+    layout.nx = max_sizes[0];
+    layout.ny = max_sizes[1];
+    layout.nz = max_sizes[2];
+    layout.max_local_nx = max_sizes[3];
+    layout.max_local_ny = max_sizes[4];
+    layout.max_local_nz = max_sizes[5];
+
+    return layouts.emplace(mesh, layout).first->second;
+  }
+
+private:
+  std::map<Mesh*, GlobalLayout> layouts;
+};
+
 /// Visit a variant type, returning dimensions
 struct NcDimVisitor {
-  NcDimVisitor(NcGroup& group) : group(group) {}
+  /// If \p layouts is not nullptr, return the global dimensions of fields
+  NcDimVisitor(NcGroup& group, GlobalLayouts* layouts = nullptr)
+      : group(group), layouts(layouts) {}
   template <typename T>
   std::vector<NcDim> operator()(const T& UNUSED(value)) {
     return {};
@@ -231,6 +439,7 @@ struct NcDimVisitor {
 
 private:
   NcGroup& group;
+  GlobalLayouts* layouts;
 };
 
 NcDim findDimension(NcGroup& group, const std::string& name, unsigned int size) {
@@ -261,10 +470,12 @@ NcDim findDimension(NcGroup& group, const std::string& name, unsigned int size)
 
 template <>
 std::vector<NcDim> NcDimVisitor::operator()<Field2D>(const Field2D& value) {
-  auto xdim = findDimension(group, "x", value.getNx());
+  const int nx = layouts ? layouts->get(value.getMesh()).nx : value.getNx();
+  auto xdim = findDimension(group, "x", nx);
   ASSERT0(!xdim.isNull());
 
-  auto ydim = findDimension(group, "y", value.getNy());
+  const int ny = layouts ? layouts->get(value.getMesh()).ny : value.getNy();
+  auto ydim = findDimension(group, "y", ny);
   ASSERT0(!ydim.isNull());
 
   return {xdim, ydim};
@@ -272,13 +483,16 @@ std::vector<NcDim> NcDimVisitor::operator()<Field2D>(const Field2D& value) {
 
 template <>
 std::vector<NcDim> NcDimVisitor::operator()<Field3D>(const Field3D& value) {
-  auto xdim = findDimension(group, "x", value.getNx());
+  const int nx = layouts ? layouts->get(value.getMesh()).nx : value.getNx();
+  auto xdim = findDimension(group, "x", nx);
   ASSERT0(!xdim.isNull());
 
-  auto ydim = findDimension(group, "y", value.getNy());
+  const int ny = layouts ? layouts->get(value.getMesh()).ny : value.getNy();
+  auto ydim = findDimension(group, "y", ny);
   ASSERT0(!ydim.isNull());
 
-  auto zdim = findDimension(group, "z", value.getNz());
+  const int nz = layouts ? layouts->get(value.getMesh()).nz : value.getNz();
+  auto zdim = findDimension(group, "z", nz);
   ASSERT0(!zdim.isNull());
 
   return {xdim, ydim, zdim};
@@ -286,15 +500,162 @@ std::vector<NcDim> NcDimVisitor::operator()<Field3D>(const Field3D& value) {
 
 template <>
 std::vector<NcDim> NcDimVisitor::operator()<FieldPerp>(const FieldPerp& value) {
-  auto xdim = findDimension(group, "x", value.getNx());
+  const int nx = layouts ? layouts->get(value.getMesh()).nx : value.getNx();
+  auto xdim = findDimension(group, "x", nx);
   ASSERT0(!xdim.isNull());
 
-  auto zdim = findDimension(group, "z", value.getNz());
+  const int nz = layouts ? layouts->get(value.getMesh()).nz : value.getNz();
+  auto zdim = findDimension(group, "z", nz);
   ASSERT0(!zdim.isNull());
 
   return {xdim, zdim};
 }
 
+/// Visit a variant type, returning the size of the chunks in each
+/// spatial dimension: this processor's part of the field
+struct NcChunkVisitor {
+  /// If \p layouts is not nullptr, fields are written as global
+  /// arrays, so chunks are the size of the largest processor's part
+  NcChunkVisitor(GlobalLayouts* layouts) : layouts(layouts) {}
+  template <typename T>
+  std::vector<size_t> operator()(const T& UNUSED(value)) {
+    return {};
+  }
+  std::vector<size_t> operator()(const Field2D& value) {
+    if (layouts != nullptr) {
+      const auto& layout = layouts->get(value.getMesh());
+      return {size(layout.max_local_nx), size(layout.max_local_ny)};
+    }
+    return {size(value.getNx()), size(value.getNy())};
+  }
+  std::vector<size_t> operator()(const Field3D& value) {
+    if (layouts != nullptr) {
+      const auto& layout = layouts->get(value.getMesh());
+      return {size(layout.max_local_nx), size(layout.max_local_ny),
+              size(layout.max_local_nz)};
+    }
+    return {size(value.getNx()), size(value.getNy()), size(value.getNz())};
+  }
+  std::vector<size_t> operator()(const FieldPerp& value) {
+    if (layouts != nullptr) {
+      const auto& layout = layouts->get(value.getMesh());
+      return {size(layout.max_local_nx), size(layout.max_local_nz)};
+    }
+    return {size(value.getNx()), size(value.getNz())};
+  }
+
+private:
+  GlobalLayouts* layouts;
+
+  static size_t size(int n) { return static_cast<size_t>(n); }
+};
+
+/// Get the storage settings for \p options, overriding \p storage
+/// with any of its attributes
+bout::NetCDFStorage getVariableStorage(const Options& options,
+                                       bout::NetCDFStorage storage) {
+  if (options.hasAttribute("deflate")) {
+    storage.deflate = options.attributes.at("deflate").as<int>();
+  }
+  if (options.hasAttribute("shuffle")) {
+    storage.shuffle = options.attributes.at("shuffle").as<bool>();
+  }
+  if (options.hasAttribute("quantize")) {
+    storage.quantize = options.attributes.at("quantize").as<int>();
+  }
+  return storage;
+}
+
+/// Is \p name one of the attributes read by getVariableStorage?
+bool isStorageAttribute(const std::string& name) {
+  return name == "deflate" or name == "shuffle" or name == "quantize";
+}
+
+/// The time index being written to the variables in \p group with
+/// time dimension \p time_dim: the smallest of their current time
+/// indices, as some may already have been written this time step
+int getGroupTimeIndex(const NcGroup& group, const NcDim& time_dim) {
+  int result = -1;
+  for (const auto& varpair : group.getVars()) {
+    const auto& var = varpair.second;
+    const auto dims = var.getDims();
+    if (dims.empty() or dims[0] != time_dim
+        or var.getAtts().count(current_time_index_name) == 0) {
+      continue;
+    }
+    const int index = getCurrentTimeIndex(var);
+    result = (result < 0) ? index : std::min(result, index);
+  }
+  return std::max(result, 0);
+}
+
+/// Start the new time-evolving variable \p var at the current time
+/// index of \p group, filling the earlier time slices with
+/// \p fill_value. Returns the time index to write to
+int backfillVariable(NcVar& var, const NcGroup& group, const NcDim& time_dim,
+                     double fill_value) {
+  const int time_index = getGroupTimeIndex(group, time_dim);
+  if (time_index > 0) {
+    const auto type = var.getType();
+    if (type == ncDouble) {
+      var.setFill(true, fill_value);
+    } else if (type == ncFloat) {
+      var.setFill(true, static_cast<float>(fill_value));
+    } else if (type == ncInt) {
+      var.setFill(true, static_cast<int>(fill_value));
+    }
+  }
+  return time_index;
+}
+
+/// Set the chunking, compression and quantisation of the new
+/// variable \p var, which has spatial chunks \p spatial_chunks and
+/// may have a time dimension \p time_dim
+void defineStorage(NcVar& var, const NcDim& time_dim,
+                   std::vector<size_t> spatial_chunks,
+                   const bout::NetCDFStorage& storage) {
+  if (spatial_chunks.empty()) {
+    // Only fields are chunked or compressed
+    return;
+  }
+
+  const auto type = var.getType();
+  const bool floating = (type == ncDouble) or (type == ncFloat);
+  const bool compress = (storage.deflate > 0) or storage.shuffle;
+  const bool quantize = floating and (storage.quantize > 0);
+
+  if (time_dim.isNull() and not compress and not quantize) {
+    // Keep the NetCDF default storage
+    return;
+  }
+
+  // Chunks are one time slice and one processor's domain by default
+  std::vector<size_t> chunks{std::move(spatial_chunks)};
+  if (not time_dim.isNull()) {
+    chunks.insert(chunks.begin(), std::max(storage.chunk_time, 1));
+  }
+  var.setChunking(NcVar::nc_CHUNKED, chunks);
+
+  if (compress) {
+    var.setCompression(storage.shuffle, storage.deflate > 0, storage.deflate);
+  }
+
+  if (quantize) {
+#if NC_HAS_QUANTIZE
+    const int status = nc_def_var_quantize(var.getParentGroup().getId(), var.getId(),
+                                           NC_QUANTIZE_BITGROOM, storage.quantize);
+    if (status != NC_NOERR) {
+      throw BoutException("Could not quantize variable '{:s}': {:s}", var.getName(),
+                          nc_strerror(status));
+    }
+#else
+    throw BoutException("Could not quantize variable '{:s}': NetCDF was built without "
+                        "quantize support (requires 4.9.0 or later)",
+                        var.getName());
+#endif
+  }
+}
+
 /// Visit a variant type, and put the data into a NcVar
 struct NcPutVarVisitor {
   NcPutVarVisitor(NcVar& var) : var(var) {}
@@ -376,6 +737,148 @@ void NcPutVarCountVisitor::operator()<FieldPerp>(const FieldPerp& value) {
   var.putVar(start, count, &value(0, 0));
 }
 
+/// Visit a variant type, and put this processor's part of the data
+/// into a NcVar in a file being written in parallel. Fields are
+/// written into the global arrays
+struct NcPutVarParallelVisitor {
+  /// If \p time_index is negative, the variable has no time dimension
+  NcPutVarParallelVisitor(NcVar& var, GlobalLayouts& layouts, int time_index)
+      : var(var), layouts(layouts), time_index(time_index) {}
+  template <typename T>
+  void operator()(const T& value) {
+    putScalar(&value);
+  }
+
+private:
+  NcVar& var;
+  GlobalLayouts& layouts;
+  int time_index;
+
+  /// Scalars are the same on every processor, so only processor 0
+  /// writes them. Time-dependent scalars are written collectively,
+  /// with the other processors writing nothing; variables without any
+  /// dimensions have independent access (see writeGroup), as there is
+  /// no count to set to zero
+  template <typename T>
+  void putScalar(const T* data) {
+    const bool root = BoutComm::rank() == 0;
+    if (time_index < 0) {
+      if (root) {
+        var.putVar(data);
+      }
+      return;
+    }
+    var.putVar({static_cast<size_t>(time_index)}, {root ? size_t{1} : size_t{0}}, data);
+  }
+
+  /// Put \p data into the hyperslab \p start, \p count, adding
+  /// the time index if there is one
+  template <typename T>
+  void put(std::vector<size_t> start, std::vector<size_t> count, const T* data) {
+    if (time_index >= 0) {
+      start.insert(start.begin(), static_cast<size_t>(time_index));
+      count.insert(count.begin(), 1);
+    }
+    if (start.empty()) {
+      var.putVar(data);
+    } else {
+      var.putVar(start, count, data);
+    }
+  }
+};
+
+template <>
+void NcPutVarParallelVisitor::operator()<bool>(const bool& value) {
+  int int_val = value ? 1 : 0;
+  putScalar(&int_val);
+}
+
+template <>
+void NcPutVarParallelVisitor::operator()<std::string>(const std::string& value) {
+  const char* cstr = value.c_str();
+  putScalar(&cstr);
+}
+
+template <>
+void NcPutVarParallelVisitor::operator()<Field2D>(const Field2D& value) {
+  const auto& layout = layouts.get(value.getMesh());
+
+  // Copy this processor's part into a contiguous buffer
+  std::vector<BoutReal> buffer;
+  buffer.reserve((layout.xe - layout.xs + 1) * (layout.ye - layout.ys + 1));
+  for (int x = layout.xs; x <= layout.xe; ++x) {
+    for (int y = layout.ys; y <= layout.ye; ++y) {
+      buffer.push_back(value(x, y));
+    }
+  }
+
+  put({static_cast<size_t>(layout.global_x), static_cast<size_t>(layout.global_y)},
+      {static_cast<size_t>(layout.xe - layout.xs + 1),
+       static_cast<size_t>(layout.ye - layout.ys + 1)},
+      buffer.data());
+}
+
+template <>
+void NcPutVarParallelVisitor::operator()<Field3D>(const Field3D& value) {
+  const auto& layout = layouts.get(value.getMesh());
+
+  // Copy this processor's part into a contiguous buffer
+  std::vector<BoutReal> buffer;
+  buffer.reserve((layout.xe - layout.xs + 1) * (layout.ye - layout.ys + 1)
+                 * (layout.ze - layout.zs + 1));
+  for (int x = layout.xs; x <= layout.xe; ++x) {
+    for (int y = layout.ys; y <= layout.ye; ++y) {
+      for (int z = layout.zs; z <= layout.ze; ++z) {
+        buffer.push_back(value(x, y, z));
+      }
+    }
+  }
+
+  put({static_cast<size_t>(layout.global_x), static_cast<size_t>(layout.global_y),
+       static_cast<size_t>(layout.global_z)},
+      {static_cast<size_t>(layout.xe - layout.xs + 1),
+       static_cast<size_t>(layout.ye - layout.ys + 1),
+       static_cast<size_t>(layout.ze - layout.zs + 1)},
+      buffer.data());
+}
+
+/// A FieldPerp is a single plane in the global array, but each
+/// processor may hold a different Y index. The plane with the lowest
+/// global Y index is written, by the processors which hold it, so that
+/// all processors agree on which one is in the file. The others take
+/// part in the collective write with nothing to write
+template <>
+void NcPutVarParallelVisitor::operator()<FieldPerp>(const FieldPerp& value) {
+  const auto& layout = layouts.get(value.getMesh());
+
+  constexpr int no_index = std::numeric_limits<int>::max();
+  const int y = value.getIndex();
+  const int local_global_y =
+      ((y >= layout.ys) and (y <= layout.ye)) ? value.getGlobalIndex() : no_index;
+  int global_y = no_index;
+  MPI_Allreduce(&local_global_y, &global_y, 1, MPI_INT, MPI_MIN, BoutComm::get());
+  const bool owner = (local_global_y != no_index) and (local_global_y == global_y);
+
+  // Replaces the per-processor attribute, which writeGroup skips
+  var.putAtt("yindex_global", ncInt, global_y == no_index ? -1 : global_y);
+
+  std::vector<BoutReal> buffer;
+  if (owner) {
+    buffer.reserve((layout.xe - layout.xs + 1) * (layout.ze - layout.zs + 1));
+    for (int x = layout.xs; x <= layout.xe; ++x) {
+      for (int z = layout.zs; z <= layout.ze; ++z) {
+        buffer.push_back(value(x, z));
+      }
+    }
+  }
+
+  put({owner ? static_cast<size_t>(layout.global_x) : 0,
+       owner ? static_cast<size_t>(layout.global_z) : 0},
+      {owner ? static_cast<size_t>(layout.xe - layout.xs + 1) : 0,
+       owner ? static_cast<size_t>(layout.ze - layout.zs + 1) : 0},
+      buffer.data());
+}
+
 /// Visit a variant type, and put the data into an attributute
 struct NcPutAttVisitor {
   NcPutAttVisitor(NcVar& var, std::string name) : var(var), name(std::move(name)) {}
@@ -412,8 +915,11 @@ void NcPutAttVisitor::operator()(const std::string& value) {
   var.putAtt(name, value);
 }
 
-void writeGroup(const Options& options, NcGroup group,
-                const std::string& time_dimension) {
+/// Write \p options into \p group, creating new variables with
+/// \p storage. If \p layouts is not nullptr, the file is being
+/// written in parallel by all processors
+void writeGroup(const Options& options, NcGroup group, const std::string& time_dimension,
+                const bout::NetCDFStorage& storage, GlobalLayouts* layouts = nullptr) {
 
   for (const auto& childpair : options.getChildren()) {
     const auto& name = childpair.first;
@@ -421,6 +927,14 @@ void writeGroup(const Options& options, NcGroup group,
 
     if (child.isValue()) {
       try {
+        if (layouts != nullptr
+            and bout::utils::holds_alternative<std::string>(child.value)) {
+          // Parallel HDF5 can't write variable length types, so
+          // strings are written as attributes of the group instead
+          group.putAtt(name, bout::utils::get<std::string>(child.value));
+          continue;
+        }
+
         auto nctype = bout::utils::visit(NcTypeVisitor(), child.value);
 
         if (nctype.isNull()) {
@@ -428,7 +942,8 @@ void writeGroup(const Options& options, NcGroup group,
         }
 
         // Get spatial dimensions
-        auto spatial_dims = bout::utils::visit(NcDimVisitor(group), child.value);
+        auto spatial_dims =
+            bout::utils::visit(NcDimVisitor(group, layouts), child.value);
 
         // Vector of all dimensions, including time
         std::vector<NcDim> dims{spatial_dims};
@@ -464,9 +979,17 @@ void writeGroup(const Options& options, NcGroup group,
           // Temporary NcType as a workaround for bug in NetCDF 4.4.0 and
           // NetCDF-CXX4 4.2.0
           var = group.addVar(name, NcType{group, nctype.getId()}, dims);
+          defineStorage(var, time_dim,
+                        bout::utils::visit(NcChunkVisitor(layouts), child.value),
+                        getVariableStorage(child, storage));
           if (!time_dim.isNull()) {
             // Time evolving variable, so we'll need to keep track of its time index
-            var.putAtt(current_time_index_name, ncInt, 0);
+            const int time_index =
+                child.hasAttribute("backfill")
+                    ? backfillVariable(var, group, time_dim,
+                                       child.attributes.at("backfill").as<double>())
+                    : 0;
+            var.putAtt(current_time_index_name, ncInt, time_index);
           }
         } else {
           // Variable does exist
@@ -510,9 +1033,27 @@ void writeGroup(const Options& options, NcGroup group,
           }
         }
 
+#if NC_HAS_PARALLEL4
+        if (layouts != nullptr) {
+          // All processors write every variable together, except
+          // dimensionless scalars which only processor 0 writes
+          nc_var_par_access(group.getId(), var.getId(),
+                            dims.empty() ? NC_INDEPENDENT : NC_COLLECTIVE);
+        }
+#endif
+
         // Write the variable
 
-        if (time_dim.isNull()) {
+        if (layouts != nullptr) {
+          const int time_index = time_dim.isNull() ? -1 : getCurrentTimeIndex(var);
+
+          bout::utils::visit(NcPutVarParallelVisitor(var, *layouts, time_index),
+                             child.value);
+
+          if (not time_dim.isNull()) {
+            var.putAtt(current_time_index_name, ncInt, time_index + 1);
+          }
+        } else if (time_dim.isNull()) {
           // No time index
 
           // Put the data into the variable
@@ -549,6 +1090,15 @@ void writeGroup(const Options& options, NcGroup group,
           const std::string& att_name = attribute.first;
           const auto& att = attribute.second;
 
+          if (layouts != nullptr and att_name == "yindex_global") {
+            // Differs between processors, so written by NcPutVarParallelVisitor
+            continue;
+          }
+          if (isStorageAttribute(att_name) or att_name == "backfill") {
+            // Already applied to the variable, which records them itself
+            continue;
+          }
+
           bout::utils::visit(NcPutAttVisitor(var, att_name), att);
         }
 
@@ -558,16 +1108,20 @@ void writeGroup(const Options& options, NcGroup group,
     }
 
     if (child.isSection()) {
-      // Check if the group exists
-      TRACE("Writing group '{:s}'", name);
+      // Not using TRACE here, as this may be called from a
+      // background writer thread (see AsyncWriter)
+      try {
+        // Check if the group exists
+        auto subgroup = group.getGroup(name);
+        if (subgroup.isNull()) {
+          // Doesn't exist yet, so create it
+          subgroup = group.addGroup(name);
+        }
 
-      auto subgroup = group.getGroup(name);
-      if (subgroup.isNull()) {
-        // Doesn't exist yet, so create it
-        subgroup = group.addGroup(name);
+        writeGroup(child, subgroup, time_dimension, storage, layouts);
+      } catch (const std::exception& e) {
+        throw BoutException("Error while writing group '{:s}' : {:s}", name, e.what());
       }
-
-      writeGroup(child, subgroup, time_dimension);
     }
   }
 }
@@ -645,16 +1199,52 @@ namespace bout {
 
 OptionsNetCDF::OptionsNetCDF() : data_file(nullptr) {}
 
-OptionsNetCDF::OptionsNetCDF(std::string filename, FileMode mode)
-    : filename(std::move(filename)), file_mode(mode), data_file(nullptr) {}
+OptionsNetCDF::OptionsNetCDF(std::string filename, FileMode mode, bool parallel)
+    : filename(std::move(filename)), file_mode(mode), data_file(nullptr),
+      parallel(parallel) {}
+
+OptionsNetCDF::~OptionsNetCDF() {
+  std::lock_guard<std::mutex> lock(netcdfMutex());
+  if (parallel_file_id >= 0) {
+    nc_close(parallel_file_id);
+  }
+  // Close the files while holding the lock
+  data_file.reset();
+  slab_file.reset();
+}
 
-OptionsNetCDF::~OptionsNetCDF() = default;
-OptionsNetCDF::OptionsNetCDF(OptionsNetCDF&&) noexcept = default;
-OptionsNetCDF& OptionsNetCDF::operator=(OptionsNetCDF&&) noexcept = default;
+OptionsNetCDF::OptionsNetCDF(OptionsNetCDF&& other) noexcept
+    : filename(std::move(other.filename)), file_mode(other.file_mode),
+      data_file(std::move(other.data_file)), slab_file(std::move(other.slab_file)),
+      parallel(other.parallel), storage(other.storage),
+      parallel_file_id(other.parallel_file_id) {
+  other.parallel_file_id = -1;
+}
+
+OptionsNetCDF& OptionsNetCDF::operator=(OptionsNetCDF&& other) noexcept {
+  // Any files this had open are closed here
+  std::lock_guard<std::mutex> lock(netcdfMutex());
+  filename = std::move(other.filename);
+  file_mode = other.file_mode;
+  data_file = std::move(other.data_file);
+  slab_file = std::move(other.slab_file);
+  parallel = other.parallel;
+  storage = other.storage;
+  // other closes any file we had open
+  std::swap(parallel_file_id, other.parallel_file_id);
+  return *this;
+}
 
 void OptionsNetCDF::verifyTimesteps() const {
-  NcFile dataFile(filename, NcFile::read);
-  auto errors = ::verifyTimesteps(dataFile);
+  const auto errors = [&]() {
+    std::lock_guard<std::mutex> lock(netcdfMutex());
+    if (parallel_file_id >= 0) {
+      // Already open for parallel writing
+      return ::verifyTimesteps(NcGroup(parallel_file_id));
+    }
+    const NcFile dataFile(filename, NcFile::read);
+    return ::verifyTimesteps(dataFile);
+  }();
 
   if (errors.empty()) {
     // No errors
@@ -673,8 +1263,24 @@ void OptionsNetCDF::verifyTimesteps() const {
 }
 
 /// Write options to file
+///
+/// Note: not timed here, as this may be called from a background
+/// writer thread. Callers should time this themselves
 void OptionsNetCDF::write(const Options& options, const std::string& time_dim) {
-  Timer timer("io");
+  std::lock_guard<std::mutex> lock(netcdfMutex());
+
+  // Anything read by readSlab() may be about to change
+  slab_file.reset();
+
+  if (parallel) {
+    openParallel();
+
+    GlobalLayouts layouts;
+    writeGroup(options, NcGroup(parallel_file_id), time_dim, storage, &layouts);
+
+    nc_sync(parallel_file_id);
+    return;
+  }
 
   // Check the file mode to use
   auto ncmode = NcFile::replace;
@@ -694,11 +1300,48 @@ void OptionsNetCDF::write(const Options& options, const std::string& time_dim) {
     throw BoutException("Could not open NetCDF file '{:s}' for writing", filename);
   }
 
-  writeGroup(options, *data_file, time_dim);
+  writeGroup(options, *data_file, time_dim, storage);
 
   data_file->sync();
 }
 
+void OptionsNetCDF::openParallel() {
+  if (parallel_file_id >= 0) {
+    return; // Already open
+  }
+#if NC_HAS_PARALLEL4
+  // Opening or creating the file are both collective, so all
+  // processors must agree on which to do, even if they don't all see
+  // the same filesystem at the same time
+  int exists = (file_mode == FileMode::append and std::ifstream(filename).good()) ? 1 : 0;
+  MPI_Bcast(&exists, 1, MPI_INT, 0, BoutComm::get());
+
+  int status = NC_NOERR;
+  if (exists != 0) {
+    status = nc_open_par(filename.c_str(), NC_WRITE, BoutComm::get(), MPI_INFO_NULL,
+                         &parallel_file_id);
+  } else {
+    status = nc_create_par(filename.c_str(), NC_NETCDF4 | NC_CLOBBER, BoutComm::get(),
+                           MPI_INFO_NULL, &parallel_file_id);
+  }
+  if (status != NC_NOERR) {
+    parallel_file_id = -1;
+    throw BoutException("Could not open NetCDF file '{:s}' for parallel writing: {:s}",
+                        filename, nc_strerror(status));
+  }
+#else
+  throw BoutException("Could not open NetCDF file '{:s}' for parallel writing: NetCDF "
+                      "was built without parallel I/O support",
+                      filename);
+#endif
+}
+
+} // namespace bout
+
+#endif // BOUT_HAS_NETCDF
+
+namespace bout {
+
 std::string getRestartDirectoryName(Options& options) {
   if (options["restartdir"].isSet()) {
     // Solver-specific restart directory
@@ -726,14 +1369,65 @@ std::string getOutputFilename(Options& options, int rank) {
                      options["datadir"].withDefault<std::string>("data"), rank);
 }
 
+bool isParallelOutput(Options& options) {
+  return options["output"]["parallel"]
+      .doc("Write a single output file from all processors, using parallel NetCDF")
+      .withDefault(false);
+}
+
+std::string getDefaultOutputFilename(Options& options) {
+  if (isParallelOutput(options)) {
+    return fmt::format("{}/BOUT.dmp.nc",
+                       options["datadir"].withDefault<std::string>("data"));
+  }
+  return getOutputFilename(options);
+}
+
+NetCDFStorage getNetCDFStorage(Options& options, bool lossless) {
+  NetCDFStorage storage;
+  storage.deflate = options["deflate"]
+                        .doc("Compression level of new variables, from 0 (no "
+                             "compression) to 9")
+                        .withDefault(storage.deflate);
+  if (storage.deflate < 0 or storage.deflate > 9) {
+    throw BoutException("Invalid compression level {:d}: must be between 0 and 9",
+                        storage.deflate);
+  }
+  storage.shuffle = options["shuffle"]
+                        .doc("Apply the shuffle filter to new variables before "
+                             "compressing them")
+                        .withDefault(storage.shuffle);
+  if (not lossless) {
+    storage.quantize = options["quantize"]
+                           .doc("Number of significant digits to keep in floating "
+                                "point variables (lossy). 0 keeps all the digits")
+                           .withDefault(storage.quantize);
+    if (storage.quantize < 0) {
+      throw BoutException("Invalid number of significant digits {:d}",
+                          storage.quantize);
+    }
+  }
+  storage.chunk_time = options["chunk_time"]
+                           .doc("Number of time slices in each chunk of "
+                                "time-evolving variables")
+                           .withDefault(storage.chunk_time);
+  if (storage.chunk_time < 1) {
+    throw BoutException("Invalid chunk_time {:d}: must be at least 1",
+                        storage.chunk_time);
+  }
+  return storage;
+}
+
 void writeDefaultOutputFile() { writeDefaultOutputFile(Options::root()); }
 
 void writeDefaultOutputFile(Options& options) {
   bout::experimental::addBuildFlagsToOptions(options);
   bout::globals::mesh->outputVars(options);
-  OptionsNetCDF(getOutputFilename(Options::root())).write(options);
+  Timer timer("io");
+  OptionsNetCDF file(getDefaultOutputFilename(Options::root()),
+                     OptionsNetCDF::FileMode::replace, isParallelOutput(Options::root()));
+  file.setStorage(getNetCDFStorage(Options::root()["output"]));
+  file.write(options);
 }
 
 } // namespace bout
-
-#endif // BOUT_HAS_NETCDF
@@ -0,0 +1,466 @@
+#include "bout/sys/profiler.hxx"
+
+#include "bout/boutcomm.hxx"
+#include "bout/boutexception.hxx"
+#include "bout/options.hxx"
+#include "bout/output.hxx"
+
+#include <fmt/format.h>
+#include <mpi.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace bout {
+
+bool Profiler::is_enabled = false;
+
+namespace {
+using clock_type =
+    typename std::conditional<std::chrono::high_resolution_clock::is_steady,
+                              std::chrono::high_resolution_clock,
+                              std::chrono::steady_clock>::type;
+using seconds = std::chrono::duration<double, std::chrono::seconds::period>;
+using microseconds = std::chrono::duration<double, std::chrono::microseconds::period>;
+
+/// One region in the tree of a thread
+struct Node {
+  std::string name;
+  Node* parent{nullptr};
+  std::vector<std::unique_ptr<Node>> children{};
+  seconds time{0};
+  std::uint64_t calls{0};
+  std::uint64_t bytes{0};
+  std::uint64_t flops{0};
+
+  /// Find or create the child region called \p child_name. The
+  /// number of children is small, so a linear search is fine
+  Node* child(const std::string& child_name) {
+    for (auto& node : children) {
+      if (node->name == child_name) {
+        return node.get();
+      }
+    }
+    children.push_back(std::make_unique<Node>());
+    auto* node = children.back().get();
+    node->name = child_name;
+    node->parent = this;
+    return node;
+  }
+};
+
+/// A completed region, times in microseconds since the profiler started
+struct TraceEvent {
+  const Node* node;
+  double start;
+  double duration;
+};
+
+struct ThreadState {
+  int id{0};
+  Node root{};
+  Node* current{&root};
+  std::vector<clock_type::time_point> starts{};
+  std::vector<TraceEvent> events{};
+  std::uint64_t dropped_events{0};
+};
+
+struct ProfilerState {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<ThreadState>> threads;
+  /// Incremented by cleanup(), so that threads register again
+  unsigned int generation{1};
+  bool trace{false};
+  std::size_t max_trace_events{100000};
+  clock_type::time_point origin{clock_type::now()};
+};
+
+ProfilerState& globalState() {
+  static ProfilerState state;
+  return state;
+}
+
+ThreadState& threadState() {
+  thread_local ThreadState* thread = nullptr;
+  thread_local unsigned int generation = 0;
+
+  auto& state = globalState();
+  if (generation != state.generation) {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.threads.push_back(std::make_unique<ThreadState>());
+    thread = state.threads.back().get();
+    thread->id = static_cast<int>(state.threads.size()) - 1;
+    generation = state.generation;
+  }
+  return *thread;
+}
+
+/// Statistics of one region path, merged over threads
+struct RegionStats {
+  double time{0.0};
+  std::uint64_t calls{0};
+  std::uint64_t bytes{0};
+  std::uint64_t flops{0};
+};
+
+using OpenTimes = std::map<const Node*, seconds>;
+
+std::string childPath(const std::string& prefix, const std::string& name) {
+  return prefix.empty() ? name : prefix + "/" + name;
+}
+
+void collect(const Node& node, const std::string& prefix, const OpenTimes& open,
+             std::map<std::string, RegionStats>& stats) {
+  for (const auto& child : node.children) {
+    const auto path = childPath(prefix, child->name);
+    auto& region = stats[path];
+
+    auto time = child->time;
+    const auto open_time = open.find(child.get());
+    if (open_time != open.end()) {
+      time += open_time->second;
+    }
+    region.time += time.count();
+    region.calls += child->calls;
+    region.bytes += child->bytes;
+    region.flops += child->flops;
+
+    collect(*child, path, open, stats);
+  }
+}
+
+/// Merge the regions of all threads, including the time so far of
+/// regions which are still open
+std::map<std::string, RegionStats> collectAll() {
+  auto& state = globalState();
+  const auto now = clock_type::now();
+
+  std::map<std::string, RegionStats> stats;
+  std::lock_guard<std::mutex> lock(state.mutex);
+  for (const auto& thread : state.threads) {
+    OpenTimes open;
+    const Node* node = thread->current;
+    for (auto start = thread->starts.rbegin(); start != thread->starts.rend(); ++start) {
+      open[node] = now - *start;
+      node = node->parent;
+    }
+    collect(thread->root, "", open, stats);
+  }
+  return stats;
+}
+
+RegionStats findRegion(const std::string& path) {
+  const auto stats = collectAll();
+  const auto region = stats.find(path);
+  if (region == stats.end()) {
+    return {};
+  }
+  return region->second;
+}
+
+/// Turn a region path into a variable name
+std::string variableName(const std::string& path) {
+  std::string name = "profile_" + path;
+  std::replace(name.begin(), name.end(), '/', '.');
+  std::replace(name.begin(), name.end(), ':', '_');
+  std::replace(name.begin(), name.end(), ' ', '_');
+  return name;
+}
+
+std::string escapeJSON(const std::string& str) {
+  std::string result;
+  result.reserve(str.size());
+  for (const char c : str) {
+    if (c == '"' or c == '\\') {
+      result += '\\';
+    }
+    result += c;
+  }
+  return result;
+}
+
+void writeNodes(std::ostream& out, const Node& node, const std::string& prefix,
+                int thread_id, bool& first) {
+  for (const auto& child : node.children) {
+    const auto path = childPath(prefix, child->name);
+    out << (first ? "" : ",\n")
+        << fmt::format(R"({{"path":"{}","thread":{},"time":{:.9g},"calls":{},)"
+                       R"("bytes":{},"flops":{}}})",
+                       escapeJSON(path), thread_id, child->time.count(), child->calls,
+                       child->bytes, child->flops);
+    first = false;
+    writeNodes(out, *child, path, thread_id, first);
+  }
+}
+} // namespace
+
+void Profiler::setEnabled(bool enable, bool trace) {
+  is_enabled = enable;
+  globalState().trace = trace;
+}
+
+void Profiler::configure(Options& options) {
+  const bool enable = options["enabled"]
+                          .doc("Record the time, bytes and flops of nested regions")
+                          .withDefault(false);
+  const bool trace = options["trace"]
+                         .doc("Record each region as an event in the trace file")
+                         .withDefault(false);
+  const int max_events = options["max_trace_events"]
+                             .doc("Maximum number of trace events kept by each thread")
+                             .withDefault(100000);
+  if (max_events < 0) {
+    throw BoutException("profiler:max_trace_events must be non-negative, got {}",
+                        max_events);
+  }
+  globalState().max_trace_events = static_cast<std::size_t>(max_events);
+  setEnabled(enable, trace);
+}
+
+void Profiler::enter(const std::string& name) {
+  auto& thread = threadState();
+  thread.current = thread.current->child(name);
+  thread.starts.push_back(clock_type::now());
+}
+
+void Profiler::leave() {
+  auto& thread = threadState();
+  if (thread.starts.empty()) {
+    // Region was opened before cleanup()
+    return;
+  }
+  const auto now = clock_type::now();
+  const auto start = thread.starts.back();
+  thread.starts.pop_back();
+
+  Node* node = thread.current;
+  node->time += now - start;
+  ++node->calls;
+
+  const auto& state = globalState();
+  if (state.trace) {
+    if (thread.events.size() < state.max_trace_events) {
+      thread.events.push_back({node, microseconds{start - state.origin}.count(),
+                               microseconds{now - start}.count()});
+    } else {
+      ++thread.dropped_events;
+    }
+  }
+  thread.current = node->parent;
+}
+
+void Profiler::addBytes(std::uint64_t bytes) {
+  if (is_enabled) {
+    threadState().current->bytes += bytes;
+  }
+}
+
+void Profiler::addFlops(std::uint64_t flops) {
+  if (is_enabled) {
+    threadState().current->flops += flops;
+  }
+}
+
+double Profiler::getTime(const std::string& path) { return findRegion(path).time; }
+
+std::uint64_t Profiler::getCalls(const std::string& path) {
+  return findRegion(path).calls;
+}
+
+std::uint64_t Profiler::getBytes(const std::string& path) {
+  return findRegion(path).bytes;
+}
+
+std::uint64_t Profiler::getFlops(const std::string& path) {
+  return findRegion(path).flops;
+}
+
+void Profiler::outputVars(Options& output_options) {
+  if (not is_enabled) {
+    return;
+  }
+  const auto stats = collectAll();
+
+  // Processors may have different regions, so first gather the
+  // union of all the paths
+  MPI_Comm comm = BoutComm::get();
+  const int npes = BoutComm::size();
+
+  std::string local_paths;
+  for (const auto& region : stats) {
+    local_paths += region.first;
+    local_paths += '\n';
+  }
+  int local_length = static_cast<int>(local_paths.size());
+  std::vector<int> lengths(npes);
+  MPI_Allgather(&local_length, 1, MPI_INT, lengths.data(), 1, MPI_INT, comm);
+
+  std::vector<int> displacements(npes, 0);
+  for (int i = 1; i < npes; ++i) {
+    displacements[i] = displacements[i - 1] + lengths[i - 1];
+  }
+  std::string all_paths(displacements.back() + lengths.back(), '\n');
+  MPI_Allgatherv(local_paths.data(), local_length, MPI_CHAR, &all_paths[0],
+                 lengths.data(), displacements.data(), MPI_CHAR, comm);
+
+  std::set<std::string> paths;
+  std::size_t begin = 0;
+  while (begin < all_paths.size()) {
+    const auto end = all_paths.find('\n', begin);
+    if (end > begin) {
+      paths.insert(all_paths.substr(begin, end - begin));
+    }
+    begin = end + 1;
+  }
+
+  // Time, calls, bytes and flops of every path on this processor
+  constexpr int nvalues = 4;
+  const auto count = static_cast<int>(paths.size()) * nvalues;
+  std::vector<double> local(count, 0.0);
+  int index = 0;
+  for (const auto& path : paths) {
+    const auto region = stats.find(path);
+    if (region != stats.end()) {
+      local[index] = region->second.time;
+      local[index + 1] = static_cast<double>(region->second.calls);
+      local[index + 2] = static_cast<double>(region->second.bytes);
+      local[index + 3] = static_cast<double>(region->second.flops);
+    }
+    index += nvalues;
+  }
+
+  std::vector<double> minimum(count), maximum(count), sum(count);
+  MPI_Allreduce(local.data(), minimum.data(), count, MPI_DOUBLE, MPI_MIN, comm);
+  MPI_Allreduce(local.data(), maximum.data(), count, MPI_DOUBLE, MPI_MAX, comm);
+  MPI_Allreduce(local.data(), sum.data(), count, MPI_DOUBLE, MPI_SUM, comm);
+
+  // Written every output step, as a time series. Regions first
+  // entered after some outputs have been written are zero in those
+  // outputs, so that all the series have the same length
+  const auto repeat = [&](const std::string& name, double value) {
+    auto& option = output_options[name];
+    option.assignRepeat(value, "t", true, "Profiler");
+    option.attributes["backfill"] = 0.0;
+  };
+  const auto write = [&](const std::string& name, int i) {
+    repeat(name + "_min", minimum[i]);
+    repeat(name + "_max", maximum[i]);
+    repeat(name + "_mean", sum[i] / npes);
+  };
+
+  index = 0;
+  for (const auto& path : paths) {
+    const auto name = variableName(path);
+    write(name + "_time", index);
+    repeat(name + "_calls", maximum[index + 1]);
+    if (maximum[index + 2] > 0) {
+      write(name + "_bytes", index + 2);
+    }
+    if (maximum[index + 3] > 0) {
+      write(name + "_flops", index + 3);
+    }
+    index += nvalues;
+  }
+}
+
+void Profiler::printReport() {
+  const auto stats = collectAll();
+  if (stats.empty()) {
+    return;
+  }
+
+  std::size_t name_width = std::string{"Region"}.length();
+  for (const auto& region : stats) {
+    const auto depth = std::count(region.first.begin(), region.first.end(), '/');
+    const auto slash = region.first.rfind('/');
+    const auto name_length =
+        region.first.length() - (slash == std::string::npos ? 0 : slash + 1);
+    name_width = std::max(name_width, 2 * depth + name_length);
+  }
+
+  output.write("\nProfile of regions (times summed over threads)\n\n");
+  output.write("{:<{}} | {:<14} | {:<9} | {:<10} | {:<12} | {:<12}\n", "Region",
+               name_width, "Total time (s)", "% parent", "Calls", "Bytes", "Flops");
+  output.write("{0:-<{1}}-|-{0:-<14}-|-{0:-<9}-|-{0:-<10}-|-{0:-<12}-|-{0:-<12}\n", "",
+               name_width);
+
+  // Paths are sorted, so parents are printed before their children
+  for (const auto& region : stats) {
+    const auto& path = region.first;
+    const auto slash = path.rfind('/');
+    const auto depth = std::count(path.begin(), path.end(), '/');
+    const auto name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+
+    double fraction = 100.0;
+    if (slash != std::string::npos) {
+      const auto parent = stats.find(path.substr(0, slash));
+      if (parent != stats.end() and parent->second.time > 0.0) {
+        fraction = 100.0 * region.second.time / parent->second.time;
+      }
+    }
+
+    output.write("{:<{}} | {:<14.6g} | {:<9.2f} | {:<10} | {:<12.4g} | {:<12.4g}\n",
+                 std::string(2 * depth, ' ') + name, name_width, region.second.time,
+                 fraction, region.second.calls,
+                 static_cast<double>(region.second.bytes),
+                 static_cast<double>(region.second.flops));
+  }
+}
+
+void Profiler::writeTrace(const std::string& filename) {
+  auto& state = globalState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+
+  std::ofstream out(filename);
+  if (not out.good()) {
+    throw BoutException("Could not open profile file '{}' for writing", filename);
+  }
+
+  const int rank = BoutComm::rank();
+  std::uint64_t dropped_events = 0;
+
+  out << "{\"traceEvents\":[\n";
+  bool first = true;
+  for (const auto& thread : state.threads) {
+    out << (first ? "" : ",\n")
+        << fmt::format(R"({{"name":"thread_name","ph":"M","pid":{},"tid":{},)"
+                       R"("args":{{"name":"thread {}"}}}})",
+                       rank, thread->id, thread->id);
+    first = false;
+    for (const auto& event : thread->events) {
+      out << fmt::format(
+          ",\n"
+          R"({{"name":"{}","cat":"bout","ph":"X","ts":{:.3f},"dur":{:.3f},)"
+          R"("pid":{},"tid":{}}})",
+          escapeJSON(event.node->name), event.start, event.duration, rank, thread->id);
+    }
+    dropped_events += thread->dropped_events;
+  }
+  out << "\n],\n\"displayTimeUnit\":\"ms\",\n";
+  out << fmt::format("\"otherData\":{{\"rank\":{},\"dropped_events\":{}}},\n", rank,
+                     dropped_events);
+
+  out << "\"profile\":[\n";
+  first = true;
+  for (const auto& thread : state.threads) {
+    writeNodes(out, thread->root, "", thread->id, first);
+  }
+  out << "\n]}\n";
+}
+
+void Profiler::cleanup() {
+  auto& state = globalState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  state.threads.clear();
+  ++state.generation;
+  state.trace = false;
+  is_enabled = false;
+}
+
+} // namespace bout
@@ -1,4 +1,5 @@
 #include "bout/sys/timer.hxx"
+#include "bout/sys/profiler.hxx"
 
 #include <fmt/core.h>
 
@@ -13,7 +14,11 @@ Timer::Timer() : timing(getInfo("")) {
   timing.counter += 1;
 }
 
-Timer::Timer(const std::string& label) : timing(getInfo(label)) {
+Timer::Timer(const std::string& label)
+    : timing(getInfo(label)), profiled(bout::Profiler::enabled()) {
+  if (profiled) {
+    bout::Profiler::enter(label);
+  }
   if (timing.counter == 0) {
     timing.started = clock_type::now();
     timing.running = true;
@@ -23,6 +28,9 @@ Timer::Timer(const std::string& label) : timing(getInfo(label)) {
 }
 
 Timer::~Timer() {
+  if (profiled) {
+    bout::Profiler::leave();
+  }
   timing.counter -= 1;
   if (timing.counter == 0) {
     const auto elapsed = clock_type::now() - timing.started;
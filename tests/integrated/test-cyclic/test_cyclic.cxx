@@ -28,6 +28,8 @@ int main(int argc, char** argv) {
   OPTION(options, tol, 1e-10);
   bool periodic;
   OPTION(options, periodic, false);
+  bool pcr;
+  OPTION(options, pcr, true);
 
   // Create a cyclic reduction object, operating on Ts
   auto* cr = new CyclicReduce<T>(BoutComm::get(), n);
@@ -85,6 +87,7 @@ int main(int argc, char** argv) {
   // Solve system
 
   cr->setPeriodic(periodic);
+  cr->setInterfacePCR(pcr);
   cr->setCoefs(a, b, c);
   cr->solve(rhs, x);
 
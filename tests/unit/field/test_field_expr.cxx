@@ -0,0 +1,96 @@
+#include "gtest/gtest.h"
+
+#include "test_extras.hxx"
+#include "bout/field_expr.hxx"
+#include "bout/where.hxx"
+
+/// Global mesh
+namespace bout {
+namespace globals {
+extern Mesh* mesh;
+} // namespace globals
+} // namespace bout
+
+// The unit tests use the global mesh
+using namespace bout::globals;
+
+using bout::expr::lazy;
+
+// Reuse the "standard" fixture for FakeMesh
+class FieldExprTest : public FakeMeshFixture {
+public:
+  FieldExprTest() : FakeMeshFixture(), a(mesh), b(mesh), c(mesh), d(mesh) {
+    a.allocate();
+    b.allocate();
+    c.allocate();
+    d.allocate();
+    BOUT_FOR(i, a.getRegion("RGN_ALL")) {
+      a[i] = 1.0 + i.x() + 0.1 * i.y() + 0.01 * i.z();
+      b[i] = 2.0 + 0.5 * i.z();
+      c[i] = -1.0 + 0.3 * i.x() * i.z();
+    }
+    BOUT_FOR(i, d.getRegion("RGN_ALL")) { d[i] = 0.5 + i.x() - i.y(); }
+  }
+
+  Field3D a, b, c;
+  Field2D d;
+};
+
+TEST_F(FieldExprTest, Field3DArithmetic) {
+  Field3D result = lazy(a) * b + lazy(c) * a - lazy(b) / a;
+
+  EXPECT_TRUE(IsFieldEqual(result, a * b + c * a - b / a));
+}
+
+TEST_F(FieldExprTest, AssignExisting) {
+  Field3D result = 1.0;
+  result = 2.0 * lazy(a) - b;
+
+  EXPECT_TRUE(IsFieldEqual(result, 2.0 * a - b));
+}
+
+TEST_F(FieldExprTest, MixedOperands) {
+  Field3D result = lazy(a) * d + 3.0 - lazy(d) / b;
+
+  EXPECT_TRUE(IsFieldEqual(result, a * d + 3.0 - d / b));
+}
+
+TEST_F(FieldExprTest, Field2DOnly) {
+  Field2D result = lazy(d) * d - 1.0;
+
+  EXPECT_TRUE(IsFieldEqual(result, d * d - 1.0));
+}
+
+TEST_F(FieldExprTest, UnaryFunctions) {
+  Field3D result = sqrt(lazy(a)) + exp(-lazy(b)) + abs(lazy(c)) + lazy(d) * d * a;
+
+  EXPECT_TRUE(IsFieldEqual(result, sqrt(a) + exp(-b) + abs(c) + d * d * a));
+}
+
+TEST_F(FieldExprTest, Pow) {
+  Field3D result = pow(lazy(a), 1.5) + pow(lazy(a), b);
+
+  EXPECT_TRUE(IsFieldEqual(result, pow(a, 1.5) + pow(a, b)));
+}
+
+TEST_F(FieldExprTest, Where) {
+  Field3D result = where(lazy(c), lazy(a) * b, 0.5 * lazy(d));
+  Field3D expected = where(c, a * b, Field3D{0.5 * d});
+
+  EXPECT_TRUE(IsFieldEqual(result, expected));
+}
+
+TEST_F(FieldExprTest, StoredExpression) {
+  auto expression = lazy(a) + b;
+  Field3D result = expression;
+
+  EXPECT_TRUE(IsFieldEqual(result, a + b));
+}
+
+TEST_F(FieldExprTest, EvaluateRegion) {
+  Field3D result = bout::expr::evaluate(lazy(a) * d - b, "RGN_NOX");
+  Field2D result2D = bout::expr::evaluate(lazy(d) * d, "RGN_NOX");
+
+  EXPECT_TRUE(IsFieldEqual(result, a * d - b, "RGN_NOX"));
+  EXPECT_TRUE(IsFieldEqual(result2D, d * d, "RGN_NOX"));
+}
@@ -786,6 +786,30 @@ TEST_F(FieldFactoryTest, Where) {
   EXPECT_DOUBLE_EQ(fieldgen->generate(Context().set("val", -1.0)), 5);
 }
 
+TEST_F(FieldFactoryTest, CompiledMatchesPointwise) {
+  Options options;
+  options["input"]["transform_from_field_aligned"] = false;
+  options["input"]["compile_expressions"] = false;
+  FieldFactory pointwise_factory{mesh_staggered, &options};
+
+  Options compiled_options;
+  compiled_options["input"]["transform_from_field_aligned"] = false;
+  FieldFactory compiled_factory{mesh_staggered, &compiled_options};
+
+  // A mix of compiled generators and ones which are evaluated point by point
+  const std::string expression =
+      "sin(x) * cos(z) + y^2 - min(x, z, 0.5) + max(y, 1) + atan(y, x) + H(y - 1) "
+      "+ [x = 2 * x](x) + where(z - 3, 1, -1) + mixmode(z)";
+
+  for (const auto loc : {CELL_CENTRE, CELL_XLOW, CELL_ZLOW}) {
+    const auto expected =
+        pointwise_factory.create3D(expression, nullptr, mesh_staggered, loc, 2.0);
+    const auto output =
+        compiled_factory.create3D(expression, nullptr, mesh_staggered, loc, 2.0);
+    EXPECT_TRUE(IsFieldEqual(output, expected));
+  }
+}
+
 TEST_F(FieldFactoryTest, Recursion) {
   // Need to enable recursion
   Options opt;
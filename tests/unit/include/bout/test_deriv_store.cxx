@@ -26,7 +26,10 @@ void flowReturnSixSetToTwo(const FieldType& UNUSED(vel), const FieldType& UNUSED
 class DerivativeStoreTest : public ::testing::Test {
 public:
   DerivativeStoreTest() : store(DerivativeStore<FieldType>::getInstance()) {}
-  ~DerivativeStoreTest() override { store.reset(); }
+  ~DerivativeStoreTest() override {
+    store.releaseDefaultMethods();
+    store.reset();
+  }
 
   DerivativeStore<FieldType>& store;
 };
@@ -332,3 +335,120 @@ TEST_F(DerivativeStoreTest, GetStandardFromFlowDerivative) {
       store.getFlowDerivative("bad type", DIRECTION::X, STAGGER::None, DERIV::Standard),
       BoutException);
 }
+
+TEST_F(DerivativeStoreTest, FindBoundDefaultMethod) {
+  const DERIV type = DERIV::Standard;
+  const DIRECTION dir = DIRECTION::X;
+
+  store.registerDerivative(standardReturnTenSetToOne, type, dir, STAGGER::None, "FIRST");
+  store.registerDerivative(standardReturnTenSetToOne, type, dir, STAGGER::None,
+                           "SECOND");
+  // Not a plain function, so can't be bound
+  store.registerDerivative(
+      [](const FieldType&, FieldType& out, const std::string&) {
+        out.resize(3, 4.0);
+      },
+      type, dir, STAGGER::None, "LAMBDA");
+
+  // Bound defaults are found in the table as plain functions
+  store.forceDefaultMethod("FIRST", type, dir);
+  EXPECT_EQ(store.findDefaultStandardDerivative("DEFAULT", dir),
+            &standardReturnTenSetToOne);
+  // Only for the default
+  EXPECT_EQ(store.findDefaultStandardDerivative("FIRST", dir), nullptr);
+  EXPECT_EQ(store.findDefaultStandardDerivative("DEFAULT", DIRECTION::Y), nullptr);
+
+  store.forceDefaultMethod("SECOND", type, dir);
+  EXPECT_EQ(store.findDefaultStandardDerivative("DEFAULT", dir),
+            &standardReturnTenSetToOne);
+
+  // Unbound defaults are still looked up by name
+  store.forceDefaultMethod("LAMBDA", type, dir);
+  EXPECT_EQ(store.findDefaultStandardDerivative("DEFAULT", dir), nullptr);
+  FieldType result;
+  store.findStandardDerivative("DEFAULT", dir)({}, result, "RGN_ALL");
+  EXPECT_EQ(result, FieldType(3, 4.0));
+
+  store.forceDefaultMethod("UNKNOWN", type, dir);
+  EXPECT_EQ(store.findDefaultStandardDerivative("DEFAULT", dir), nullptr);
+  EXPECT_THROW(store.findStandardDerivative("DEFAULT", dir), BoutException);
+}
+
+TEST_F(DerivativeStoreTest, InitialiseBindsDefaultMethods) {
+  const DERIV type = DERIV::Upwind;
+  const DIRECTION dir = DIRECTION::Z;
+
+  store.registerDerivative(flowReturnSixSetToTwo, type, dir, STAGGER::None, "U1");
+  store.registerDerivative(flowType{}, type, dir, STAGGER::None, "U2");
+
+  Options options;
+  options["ddz"]["upwind"] = "u2";
+  store.initialise(&options);
+
+  EXPECT_EQ(store.findDefaultFlowDerivative("DEFAULT", dir), nullptr);
+
+  Options bound_options;
+  bound_options["ddz"]["upwind"] = "u1";
+  store.initialise(&bound_options);
+  EXPECT_EQ(store.findDefaultFlowDerivative("DEFAULT", dir), &flowReturnSixSetToTwo);
+
+  // Resetting the store unbinds the defaults
+  store.reset();
+  EXPECT_EQ(store.findDefaultFlowDerivative("DEFAULT", dir), nullptr);
+}
+
+TEST_F(DerivativeStoreTest, FixedDefaultMethod) {
+  const DERIV type = DERIV::Standard;
+  const DIRECTION dir = DIRECTION::X;
+
+  store.registerDerivative(standardReturnTenSetToOne, type, dir, STAGGER::None, "C2");
+  store.registerDerivative(standardType{}, type, dir, STAGGER::None, "C4");
+  store.fixDefaultMethod("C2", type, dir);
+
+  // Asking for the fixed method is fine
+  Options same;
+  same["ddx"]["first"] = "C2";
+  EXPECT_NO_THROW(store.initialise(&same));
+
+  Options different;
+  different["ddx"]["first"] = "C4";
+  EXPECT_THROW(store.initialise(&different), BoutException);
+}
+
+TEST_F(DerivativeStoreTest, RegisterAfterInitialiseBindsDefault) {
+  const DERIV type = DERIV::Standard;
+  const DIRECTION dir = DIRECTION::X;
+
+  Options options;
+  store.initialise(&options);
+  EXPECT_EQ(store.findDefaultStandardDerivative("DEFAULT", dir), nullptr);
+
+  // Registering the default method binds it, without initialising again
+  store.registerDerivative(standardReturnTenSetToOne, type, dir, STAGGER::None, "C2");
+  EXPECT_EQ(store.findDefaultStandardDerivative("DEFAULT", dir),
+            &standardReturnTenSetToOne);
+}
+
+TEST_F(DerivativeStoreTest, FixedDefaultMethodKeptByClear) {
+  const DERIV type = DERIV::Standard;
+  const DIRECTION dir = DIRECTION::X;
+
+  store.registerDerivative(standardReturnTenSetToOne, type, dir, STAGGER::None, "C4");
+  store.fixDefaultMethod("C4", type, dir);
+
+  store.clear();
+  EXPECT_EQ(store.getDefaultMethod(type, dir), "C4");
+  EXPECT_EQ(store.findDefaultStandardDerivative("DEFAULT", dir), nullptr);
+
+  // Bound again once the method is registered again
+  store.registerDerivative(standardReturnTenSetToOne, type, dir, STAGGER::None, "C4");
+  EXPECT_EQ(store.findDefaultStandardDerivative("DEFAULT", dir),
+            &standardReturnTenSetToOne);
+
+  // Still fixed after a reset
+  store.reset();
+  EXPECT_EQ(store.getDefaultMethod(type, dir), "C4");
+  Options different;
+  different["ddx"]["first"] = "C2";
+  EXPECT_THROW(store.initialise(&different), BoutException);
+}
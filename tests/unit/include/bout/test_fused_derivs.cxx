@@ -0,0 +1,91 @@
+#include "gtest/gtest.h"
+
+#include "test_extras.hxx"
+
+#include "bout/derivs.hxx"
+#include "bout/difops.hxx"
+#include "bout/fused_derivs.hxx"
+
+#include <random>
+
+/// Global mesh
+namespace bout {
+namespace globals {
+extern Mesh* mesh;
+} // namespace globals
+} // namespace bout
+
+// The unit tests use the global mesh
+using namespace bout::globals;
+
+using FusedDerivsTest = FakeMeshFixture;
+
+TEST_F(FusedDerivsTest, CanFuse) {
+  Field3D input{1.0};
+
+  EXPECT_TRUE(bout::derivatives::fused::canFuseXZ(input));
+  EXPECT_TRUE(bout::derivatives::fused::canFuseXZ(input, CELL_CENTRE));
+  EXPECT_FALSE(bout::derivatives::fused::canFuseXZ(input, CELL_XLOW));
+}
+
+TEST_F(FusedDerivsTest, XZ) {
+  std::default_random_engine re;
+  const auto input = random_field<Field3D>(re);
+
+  Field3D ddx, ddz, d2dx2, d2dz2, d2dxdz;
+  bout::derivatives::fused::XZ(input, &ddx, &ddz, &d2dx2, &d2dz2, &d2dxdz);
+
+  EXPECT_TRUE(IsFieldEqual(ddx, DDX(input), "RGN_NOBNDRY"));
+  EXPECT_TRUE(IsFieldEqual(ddz, DDZ(input), "RGN_NOBNDRY"));
+  EXPECT_TRUE(IsFieldEqual(d2dx2, D2DX2(input), "RGN_NOBNDRY"));
+  EXPECT_TRUE(IsFieldEqual(d2dz2, D2DZ2(input), "RGN_NOBNDRY"));
+  EXPECT_TRUE(IsFieldEqual(d2dxdz, D2DXDZ(input), "RGN_NOBNDRY"));
+}
+
+TEST_F(FusedDerivsTest, XZSomeOutputs) {
+  std::default_random_engine re;
+  const auto input = random_field<Field3D>(re);
+
+  Field3D ddx, d2dz2;
+  bout::derivatives::fused::XZ(input, &ddx, nullptr, nullptr, &d2dz2, nullptr);
+
+  EXPECT_TRUE(IsFieldEqual(ddx, DDX(input), "RGN_NOBNDRY"));
+  EXPECT_TRUE(IsFieldEqual(d2dz2, D2DZ2(input), "RGN_NOBNDRY"));
+}
+
+TEST_F(FusedDerivsTest, ForEachXZ) {
+  std::default_random_engine re;
+  const auto input = random_field<Field3D>(re);
+
+  Field3D result{emptyFrom(input)};
+  bout::derivatives::fused::forEachXZ(
+      input, "RGN_NOBNDRY",
+      [&](const Ind3D& i, const bout::derivatives::fused::XZDerivatives& derivs) {
+        result[i] = 2.0 * derivs.ddx + derivs.d2dz2;
+      });
+
+  EXPECT_TRUE(IsFieldEqual(result, 2.0 * DDX(input) + D2DZ2(input), "RGN_NOBNDRY"));
+}
+
+TEST_F(FusedDerivsTest, CanFuseSimpleBracket) {
+  Field3D f{1.0};
+  Field3D g{2.0};
+  Field3D g_xlow{2.0, mesh_staggered};
+  g_xlow.setLocation(CELL_XLOW);
+
+  EXPECT_TRUE(bout::derivatives::fused::canFuseSimpleBracket(f, g));
+  EXPECT_FALSE(bout::derivatives::fused::canFuseSimpleBracket(f, g, CELL_XLOW));
+  EXPECT_FALSE(bout::derivatives::fused::canFuseSimpleBracket(f, g_xlow));
+}
+
+TEST_F(FusedDerivsTest, SimpleBracket) {
+  std::default_random_engine re;
+  const auto f = random_field<Field3D>(re);
+  const auto g = random_field<Field3D>(re);
+
+  const Field3D fused = bout::derivatives::fused::simpleBracket(f, g);
+  const Field3D separate = VDDX(DDZ(f), g) + VDDZ(-DDX(f), g);
+
+  EXPECT_TRUE(IsFieldEqual(fused, separate, "RGN_NOBNDRY"));
+  EXPECT_TRUE(IsFieldEqual(bracket(f, g, BRACKET_SIMPLE), separate, "RGN_NOBNDRY"));
+}
@@ -321,6 +321,43 @@ TYPED_TEST(HypreMatrixTest, SetElements) {
   }
 }
 
+TYPED_TEST(HypreMatrixTest, SetElementsFixedSparsity) {
+  HypreMatrix<TypeParam> matrix(this->indexer, true, true);
+  const auto& region = this->field.getRegion("RGN_NOBNDRY");
+  auto idx = *std::begin(region);
+  auto i_index = static_cast<HYPRE_BigInt>(this->indexer->getGlobal(idx));
+  HYPRE_Int ncolumns{1};
+  HYPRE_Complex value;
+
+  // Elements in the stencil are already present
+  EXPECT_EQ(matrix.getVal(idx, idx.xp()), 0.0);
+
+  matrix.setVal(idx, idx, 23.);
+  matrix.assemble();
+  HYPRE_IJMatrixGetValues(matrix.get(), 1, &ncolumns, &i_index, &i_index, &value);
+  EXPECT_EQ(static_cast<BoutReal>(value), 23.);
+
+  // Reassembling only updates the values
+  matrix.addVal(idx, idx, 14.);
+  matrix.assemble();
+  HYPRE_IJMatrixGetValues(matrix.get(), 1, &ncolumns, &i_index, &i_index, &value);
+  EXPECT_EQ(static_cast<BoutReal>(value), 37.);
+}
+
+TYPED_TEST(HypreMatrixTest, SetElementsFixedSparsityOutsideStencil) {
+  HypreMatrix<TypeParam> matrix(this->indexer, true, true);
+  auto idx = *std::begin(this->field.getRegion("RGN_NOBNDRY"));
+  typename TypeParam::ind_type outside;
+  if (std::is_same<TypeParam, FieldPerp>::value) {
+    outside = idx.zp().zp();
+  } else {
+    outside = idx.yp().yp();
+  }
+
+  EXPECT_THROW(matrix.setVal(idx, outside, 1.0), BoutException);
+  EXPECT_THROW(matrix.addVal(idx, outside, 1.0), BoutException);
+}
+
 TYPED_TEST(HypreMatrixTest, GetElements) {
   HypreMatrix<TypeParam> matrix(this->indexer);
 
@@ -1,5 +1,6 @@
 #include "bout/build_config.hxx"
 
+#include <algorithm>
 #include <set>
 #include <tuple>
 #include <vector>
@@ -338,6 +339,21 @@ TYPED_TEST(IndexerTest, TestGetNumOffDiagonal) {
   }
 }
 
+TYPED_TEST(IndexerTest, TestGetSparsityPattern) {
+  const auto& pattern = this->globalSquareIndexer.getSparsityPattern();
+  const auto& numDiagonal = this->globalSquareIndexer.getNumDiagonal();
+  const auto& numOffDiagonal = this->globalSquareIndexer.getNumOffDiagonal();
+  const int start = this->globalSquareIndexer.getGlobalStart();
+  ASSERT_EQ(static_cast<int>(pattern.size()), this->globalSquareIndexer.size());
+  for (std::size_t row = 0; row < pattern.size(); ++row) {
+    const auto& columns = pattern[row];
+    EXPECT_EQ(static_cast<int>(columns.size()), numDiagonal[row] + numOffDiagonal[row]);
+    EXPECT_TRUE(std::is_sorted(columns.begin(), columns.end()));
+    EXPECT_TRUE(std::binary_search(columns.begin(), columns.end(),
+                                   start + static_cast<int>(row)));
+  }
+}
+
 TYPED_TEST(IndexerTest, TestSize) {
   EXPECT_EQ(this->globalSquareIndexer.size(),
             (this->nx + 2 * this->guardx) * (this->ny + 2 * this->guardy) * this->nz);
@@ -215,6 +215,43 @@ TYPED_TEST(PetscMatrixTest, TestAssemble) {
   ASSERT_EQ(matContents, r);
 }
 
+// Test setting elements with a fixed sparsity pattern
+TYPED_TEST(PetscMatrixTest, TestFixedSparsity) {
+  PetscMatrix<TypeParam> matrix(this->indexer, true, true);
+  EXPECT_TRUE(matrix.hasFixedSparsity());
+  typename TypeParam::ind_type i = *(this->field.getRegion("RGN_NOBNDRY").begin());
+  const PetscInt row = this->indexer->getGlobal(i);
+  PetscScalar matContents;
+
+  // Inserting and adding can be mixed without assembling in between
+  matrix(i, i) = 1.0;
+  matrix(i, i) += 2.0;
+  EXPECT_EQ(static_cast<BoutReal>(matrix(i, i)), 3.0);
+  matrix.assemble();
+  MatGetValues(*matrix.get(), 1, &row, 1, &row, &matContents);
+  EXPECT_EQ(matContents, 3.0);
+
+  // Reassembling only updates the values
+  matrix(i, i) = 5.0;
+  matrix.assemble();
+  MatGetValues(*matrix.get(), 1, &row, 1, &row, &matContents);
+  EXPECT_EQ(matContents, 5.0);
+}
+
+// Test setting an element outside the stencil of a fixed sparsity pattern
+TYPED_TEST(PetscMatrixTest, TestFixedSparsityOutsideStencil) {
+  PetscMatrix<TypeParam> matrix(this->indexer, true, true);
+  typename TypeParam::ind_type i = *(this->field.getRegion("RGN_NOBNDRY").begin());
+  typename TypeParam::ind_type j;
+  if (std::is_same<TypeParam, FieldPerp>::value) {
+    j = i.zp().zp();
+  } else {
+    j = i.yp().yp();
+  }
+  EXPECT_THROW(matrix(i, j) = 1.0, BoutException);
+  EXPECT_THROW(matrix(i, j) += 1.0, BoutException);
+}
+
 #ifdef PETSC_USE_DEBUG
 
 #if CHECKLEVEL >= 3
@@ -439,4 +476,44 @@ TYPED_TEST(PetscMatrixTest, TestMatrixVectorMultiplyOnes) {
   }
 }
 
+// Test matrix/vector multiplication (matrix-free)
+TYPED_TEST(PetscMatrixTest, TestMatrixVectorMultiplyShell) {
+  auto matrix = PetscMatrix<TypeParam>::matrixFree(
+      this->indexer, [](const TypeParam& f) -> TypeParam { return 2.0 * f; });
+  EXPECT_TRUE(matrix.isShell());
+  this->field.allocate();
+  BOUT_FOR(i, this->field.getRegion("RGN_ALL")) {
+    this->field[i] = static_cast<BoutReal>(i.ind);
+  }
+  PetscVector<TypeParam> vector(this->field, this->indexer);
+  vector.assemble();
+  matrix.assemble();
+  PetscVector<TypeParam> product = matrix * vector;
+  TypeParam prodField = product.toField();
+  BOUT_FOR(i, prodField.getRegion("RGN_NOY")) {
+    EXPECT_NEAR(prodField[i], 2.0 * this->field[i], 1.e-10);
+  }
+}
+
+// Test that a matrix-free operator has no elements to set
+TYPED_TEST(PetscMatrixTest, TestShellSetElement) {
+  auto matrix = PetscMatrix<TypeParam>::matrixFree(
+      this->indexer, [](const TypeParam& f) -> TypeParam { return f; });
+  EXPECT_THROW((matrix(this->indexA, this->indexB) = 1.0), BoutException);
+}
+
+// Test that errors in a matrix-free operator are passed back
+TYPED_TEST(PetscMatrixTest, TestMatrixVectorMultiplyShellError) {
+  WithQuietOutput quiet{output_error};
+  auto matrix = PetscMatrix<TypeParam>::matrixFree(
+      this->indexer, [](const TypeParam& UNUSED(f)) -> TypeParam {
+        throw BoutException("Failed to apply operator");
+      });
+  this->field = 1.0;
+  PetscVector<TypeParam> vector(this->field, this->indexer);
+  vector.assemble();
+  matrix.assemble();
+  EXPECT_THROW(matrix * vector, BoutException);
+}
+
 #endif // BOUT_HAS_PETSC
@@ -340,6 +340,37 @@ TEST_F(RegionTest, regionLoopNoBndryInner) {
   EXPECT_EQ(numMatching, ninner);
 }
 
+TEST_F(RegionTest, regionLoopZInteriorAndSeam) {
+  constexpr int width = 2;
+  // Small blocks, so that some start and end in the middle of a z row
+  Region<Ind3D> region(0, mesh->LocalNx - 1, 0, mesh->LocalNy - 1, 0, mesh->LocalNz - 1,
+                       mesh->LocalNy, mesh->LocalNz, 3);
+
+  Field3D a{0.};
+  region.forZInteriorAndSeam(
+      width, [&](const Ind3D& i) { a[i] += 1.0; }, [&](const Ind3D& i) { a[i] += 2.0; });
+
+  for (int i = 0; i < mesh->LocalNx; ++i) {
+    for (int j = 0; j < mesh->LocalNy; ++j) {
+      for (int k = 0; k < mesh->LocalNz; ++k) {
+        const bool interior = k >= width and k < mesh->LocalNz - width;
+        EXPECT_DOUBLE_EQ(a(i, j, k), interior ? 1.0 : 2.0);
+      }
+    }
+  }
+}
+
+TEST_F(RegionTest, regionLoopZInteriorAndSeamAllSeam) {
+  const auto& region = mesh->getRegion3D("RGN_ALL");
+
+  Field3D a{0.};
+  region.forZInteriorAndSeam(
+      mesh->LocalNz, [&](const Ind3D& i) { a[i] += 1.0; },
+      [&](const Ind3D& i) { a[i] += 2.0; });
+
+  EXPECT_TRUE(IsFieldEqual(a, 2.0));
+}
+
 TEST_F(RegionTest, regionAsSorted) {
   // Contiguous blocks to insert
   std::vector<std::pair<int, int>> blocksIn = {
@@ -1802,6 +1833,23 @@ TEST_F(IndexOffsetTest, ZPlusOne) {
   }
 }
 
+TEST_F(IndexOffsetTest, ZNoWrap) {
+  const auto& region = mesh->getRegion3D("RGN_ALL");
+
+  for (const auto& index : region) {
+    if (index.z() + 2 < nz) {
+      EXPECT_EQ(index.zpNoWrap(), index.zp());
+      EXPECT_EQ(index.zpNoWrap(2), index.zpp());
+      EXPECT_EQ((index.plus<2, DIRECTION::Z, false>()), index.zpp());
+    }
+    if (index.z() - 2 >= 0) {
+      EXPECT_EQ(index.zmNoWrap(), index.zm());
+      EXPECT_EQ(index.zmNoWrap(2), index.zmm());
+      EXPECT_EQ((index.minus<2, DIRECTION::Z, false>()), index.zmm());
+    }
+  }
+}
+
 TEST_F(IndexOffsetTest, XPlusOneGeneric) {
   const auto& region = mesh->getRegion3D("RGN_ALL");
 
@@ -21,23 +21,6 @@ using namespace bout::globals;
 // Reuse the "standard" fixture for FakeMesh
 using SingleIndexOpsTest = FakeMeshFixture;
 
-/// Creates a Field filled with random, uniformly distributed numbers
-///
-/// Usage
-///   std::default_random_engine re;
-///   auto field = random_field<Field3D>(re);
-///
-template <class FieldType>
-FieldType random_field(std::default_random_engine& re) {
-  std::uniform_real_distribution<double> unif(-1.0, 1.0);
-  // Create a field of requested type
-  FieldType result;
-  result.allocate();
-  // Fill with random numbers
-  BOUT_FOR(i, result.getRegion("RGN_ALL")) { result[i] = unif(re); }
-  return result;
-}
-
 TEST_F(SingleIndexOpsTest, DDX) {
   // Fill a field with random numbers
   std::default_random_engine re;
@@ -164,8 +147,69 @@ TEST_F(SingleIndexOpsTest, bracket3d3d) {
   ASSERT_TRUE(IsFieldEqual(difops, indexops, "RGN_NOBNDRY"));
 }
 
+TEST_F(SingleIndexOpsTest, bracket3d3dArakawaOld) {
+  // Fill a field with random numbers
+  std::default_random_engine re;
+
+  auto input = random_field<Field3D>(re);
+  auto input2 = random_field<Field3D>(re);
+
+  // The vectorised and the reference implementations should agree
+  Field3D arakawa = bracket(input, input2, BRACKET_ARAKAWA);
+  Field3D arakawa_old = bracket(input, input2, BRACKET_ARAKAWA_OLD);
+
+  ASSERT_TRUE(IsFieldEqual(arakawa, arakawa_old, "RGN_NOBNDRY"));
+}
+
 #endif // !BOUT_USE_METRIC_3D
 
+// The Arakawa brackets read the grid spacing at each point with 3D
+// metrics, and once per z row otherwise
+TEST_F(SingleIndexOpsTest, bracket3d3dArakawaVaryingSpacing) {
+  std::default_random_engine re;
+
+  auto* coords = mesh->getCoordinates();
+  coords->dx = 1.0 + 0.5 * random_field<Coordinates::FieldMetric>(re);
+  coords->dz = 2.0 + 0.5 * random_field<Coordinates::FieldMetric>(re);
+
+  auto input = random_field<Field3D>(re);
+  auto input2 = random_field<Field3D>(re);
+
+  // The vectorised and the reference implementations should agree
+  Field3D arakawa = bracket(input, input2, BRACKET_ARAKAWA);
+  Field3D arakawa_old = bracket(input, input2, BRACKET_ARAKAWA_OLD);
+
+  ASSERT_TRUE(IsFieldEqual(arakawa, arakawa_old, "RGN_NOBNDRY"));
+}
+
+TEST_F(SingleIndexOpsTest, bracket3d2dArakawaVaryingSpacing) {
+  std::default_random_engine re;
+
+  auto* coords = mesh->getCoordinates();
+  coords->dx = 1.0 + 0.5 * random_field<Coordinates::FieldMetric>(re);
+  coords->dz = 2.0 + 0.5 * random_field<Coordinates::FieldMetric>(re);
+
+  auto f = random_field<Field3D>(re);
+  auto g = random_field<Field2D>(re);
+
+  Field3D arakawa = bracket(f, g, BRACKET_ARAKAWA);
+
+  // The terms of the Arakawa scheme which don't vanish when g doesn't
+  // depend on z
+  Field3D expected{0.0};
+  BOUT_FOR(i, expected.getRegion("RGN_NOBNDRY")) {
+    const auto xp = i.xp();
+    const auto xm = i.xm();
+    const BoutReal Jpp = 2 * (f[i.zp()] - f[i.zm()]) * (g[xp] - g[xm]);
+    const BoutReal Jpx = g[xp] * (f[xp.zp()] - f[xp.zm()])
+                         - g[xm] * (f[xm.zp()] - f[xm.zm()])
+                         + g[i] * (f[xp.zm()] - f[xp.zp()] - f[xm.zm()] + f[xm.zp()]);
+    expected[i] = (Jpp + Jpx) / (12 * coords->dx[i] * coords->dz[i]);
+  }
+
+  ASSERT_TRUE(IsFieldEqual(arakawa, expected, "RGN_NOBNDRY", 1e-12));
+}
+
 TEST_F(SingleIndexOpsTest, Delp2_3D) {
   // Fill a field with random numbers
   std::default_random_engine re;
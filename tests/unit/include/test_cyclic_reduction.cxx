@@ -3,6 +3,7 @@
 #include "test_extras.hxx"
 #include "bout/array.hxx"
 #include "bout/boutcomm.hxx"
+#include "bout/boutexception.hxx"
 #include "bout/cyclic_reduction.hxx"
 
 #include <algorithm>
@@ -107,3 +108,60 @@ TEST(CyclicReduction, SerialSolveDoubleMatrix) {
   EXPECT_NEAR(x(1, 3), 0.8, CyclicReduceTolerance);
   EXPECT_NEAR(x(1, 4), 6.6, CyclicReduceTolerance);
 }
+
+TEST(CyclicReduction, SerialSolveRepeated) {
+  using namespace bout::testing;
+  CyclicReduce<BoutReal> reduce{BoutComm::get(), reduction_size};
+
+  auto a = makeMatrixFromVector({{0., 1., 1., 1., 1.}});
+  auto b = makeMatrixFromVector({{5., 4., 3., 2., 1.}});
+  auto c = makeMatrixFromVector({{2., 2., 2., 2., 0.}});
+
+  reduce.setCoefs(a, b, c);
+
+  auto rhs = makeMatrixFromVector({{0., 1., 2., 2., 3.}});
+  Matrix<BoutReal> x{1, reduction_size};
+
+  reduce.solve(rhs, x);
+
+  // Solving again with the same coefficients and a different right
+  // hand side re-uses the elimination of the matrix
+  auto rhs2 = makeMatrixFromVector({{5., 4., 5., 4., 5.}});
+  reduce.solve(rhs2, x);
+
+  EXPECT_NEAR(x(0, 0), -2. / 3., CyclicReduceTolerance);
+  EXPECT_NEAR(x(0, 1), 25. / 6., CyclicReduceTolerance);
+  EXPECT_NEAR(x(0, 2), -6., CyclicReduceTolerance);
+  EXPECT_NEAR(x(0, 3), 113. / 12., CyclicReduceTolerance);
+  EXPECT_NEAR(x(0, 4), -53. / 12., CyclicReduceTolerance);
+
+  // New coefficients
+  auto a2 = makeMatrixFromVector({{0., -2., -2., -2., -2.}});
+  auto b2 = makeMatrixFromVector({{1., 1., 1., 1., 1.}});
+  reduce.setCoefs(a2, b2, c);
+  reduce.solve(rhs2, x);
+
+  EXPECT_NEAR(x(0, 0), 3.4, CyclicReduceTolerance);
+  EXPECT_NEAR(x(0, 1), 0.8, CyclicReduceTolerance);
+  EXPECT_NEAR(x(0, 2), 5., CyclicReduceTolerance);
+  EXPECT_NEAR(x(0, 3), 0.8, CyclicReduceTolerance);
+  EXPECT_NEAR(x(0, 4), 6.6, CyclicReduceTolerance);
+}
+
+TEST(CyclicReduction, SerialSolveZeroPivot) {
+  using namespace bout::testing;
+  CyclicReduce<BoutReal> reduce{BoutComm::get(), reduction_size};
+
+  // The second system has an empty row, so can't be solved
+  auto a = makeMatrixFromVector({{0., 1., 1., 1., 1.}, {0., 1., 1., 0., 1.}});
+  auto b = makeMatrixFromVector({{5., 4., 3., 2., 1.}, {5., 4., 3., 0., 1.}});
+  auto c = makeMatrixFromVector({{2., 2., 2., 2., 0.}, {2., 2., 2., 0., 0.}});
+
+  reduce.setCoefs(a, b, c);
+
+  auto rhs = makeMatrixFromVector({{0., 1., 2., 2., 3.}, {0., 1., 2., 2., 3.}});
+  Matrix<BoutReal> x{2, reduction_size};
+
+  // Thrown after the OpenMP loop over systems, rather than from inside it
+  EXPECT_THROW(reduce.solve(rhs, x), BoutException);
+}
@@ -118,6 +118,7 @@ private:
     options["outer_boundary_flags"] =
         (std::get<2>(param) ? INVERT_AC_GRAD : 0) + INVERT_RHS;
     options["fourth_order"] = false;
+    options["cache_coefficients"] = true;
     options["atol"] = tol / 30; // Need to specify smaller than desired tolerance to
     options["rtol"] = tol / 30; // ensure it is satisfied for every element.
     return &options;
@@ -142,4 +143,59 @@ TEST_P(CyclicTest, DummyTest) {
   // No test yet
 }
 
+#if BOUT_HAS_FFTW
+TEST_P(CyclicTest, CacheTridagMatrices) {
+  solver.setCoefA(coef2);
+  const Field3D first = solver.solve(f3);
+  EXPECT_EQ(solver.getTridagCacheHits(), 0);
+
+  // Nothing has changed, so the matrices are re-used
+  EXPECT_TRUE(IsFieldEqual(solver.solve(f3), first, "RGN_NOY"));
+  EXPECT_EQ(solver.getTridagCacheHits(), 1);
+
+  // Setting any coefficient rebuilds the matrices
+  solver.setCoefA(0.5 * coef2);
+  const Field3D changed = solver.solve(f3);
+  EXPECT_EQ(solver.getTridagCacheHits(), 1);
+
+  solver.setCoefC(1.0);
+  solver.solve(f3);
+  solver.setCoefC1(1.0);
+  solver.solve(f3);
+  solver.setCoefC2(1.0);
+  solver.solve(f3);
+  solver.setCoefD(1.0);
+  solver.solve(f3);
+  EXPECT_EQ(solver.getTridagCacheHits(), 1);
+
+  // The rebuilt matrices give the same result as a solver without caching
+  Options& options = Options::root()["laplace_uncached"];
+  options["inner_boundary_flags"] =
+      Options::root()["laplace"]["inner_boundary_flags"].as<int>();
+  options["outer_boundary_flags"] =
+      Options::root()["laplace"]["outer_boundary_flags"].as<int>();
+  options["cache_coefficients"] = false;
+  LaplaceCyclic uncached(&options);
+  uncached.setCoefA(0.5 * coef2);
+  EXPECT_TRUE(IsFieldEqual(uncached.solve(f3), changed, "RGN_NOY", tol));
+  uncached.solve(f3);
+  EXPECT_EQ(uncached.getTridagCacheHits(), 0);
+
+  // Changing the flags rebuilds the matrices
+  solver.setGlobalFlags(INVERT_ZERO_DC);
+  solver.solve(f3);
+  EXPECT_EQ(solver.getTridagCacheHits(), 1);
+
+  // So does changing a coefficient in place after setting it
+  Field2D coef_a = copy(coef2);
+  solver.setCoefA(coef_a);
+  solver.solve(f3);
+  solver.solve(f3);
+  EXPECT_EQ(solver.getTridagCacheHits(), 2);
+  BOUT_FOR_SERIAL(i, coef_a.getRegion("RGN_ALL")) { coef_a[i] *= 2.0; }
+  solver.solve(f3);
+  EXPECT_EQ(solver.getTridagCacheHits(), 2);
+}
+#endif // BOUT_HAS_FFTW
+
 #endif // BOUT_USE_METRIC_3D
@@ -0,0 +1,75 @@
+#include "bout/build_config.hxx"
+
+#if BOUT_HAS_FFTW and BOUT_HAS_LAPACK and not BOUT_USE_METRIC_3D
+
+#include "../../../../src/invert/laplace/impls/serial_band/serial_band.hxx"
+#include "../../../../src/invert/laplace/impls/serial_tri/serial_tri.hxx"
+#include "test_extras.hxx"
+#include "bout/invert_laplace.hxx"
+#include "gtest/gtest.h"
+
+#include "bout/field2d.hxx"
+#include "bout/field3d.hxx"
+#include "bout/options.hxx"
+
+#include <memory>
+#include <random>
+#include <string>
+#include <tuple>
+
+/// The serial solvers solve all the Y slices of a Field3D together.
+/// Check they give the same answer as the default Laplacian::solve,
+/// which solves each slice in turn with the FieldPerp solve
+class LaplaceSerialTest
+    : public FakeMeshFixture,
+      public testing::WithParamInterface<std::tuple<std::string, int, int>> {
+public:
+  WithQuietOutput info{output_info}, warn{output_warn};
+
+  LaplaceSerialTest() : FakeMeshFixture() {
+    Options& options = Options::root()["laplace"];
+    options["inner_boundary_flags"] = std::get<1>(GetParam());
+    options["outer_boundary_flags"] = std::get<2>(GetParam());
+
+    if (std::get<0>(GetParam()) == LAPLACE_TRI) {
+      solver = std::make_unique<LaplaceSerialTri>(&options);
+    } else {
+      solver = std::make_unique<LaplaceSerialBand>(&options);
+    }
+
+    std::default_random_engine re;
+    solver->setCoefA(random_field<Field2D>(re));
+    solver->setCoefC(2.0 + random_field<Field2D>(re));
+    solver->setCoefD(2.0 + random_field<Field2D>(re));
+
+    b = random_field<Field3D>(re);
+    x0 = random_field<Field3D>(re);
+  }
+
+  std::unique_ptr<Laplacian> solver;
+  Field3D b, x0;
+
+  static constexpr BoutReal tol = 1e-12;
+};
+
+INSTANTIATE_TEST_SUITE_P(
+    LaplaceSerial, LaplaceSerialTest,
+    testing::Combine(testing::Values(LAPLACE_TRI, LAPLACE_BAND),
+                     testing::Values(0, INVERT_AC_GRAD, INVERT_SET, INVERT_RHS),
+                     testing::Values(0, INVERT_AC_GRAD + INVERT_DC_GRAD, INVERT_SET)));
+
+TEST_P(LaplaceSerialTest, Solve) {
+  const Field3D batched = solver->solve(b);
+  const Field3D slices = solver->Laplacian::solve(b);
+
+  EXPECT_TRUE(IsFieldEqual(batched, slices, "RGN_NOY", tol));
+}
+
+TEST_P(LaplaceSerialTest, SolveWithGuess) {
+  const Field3D batched = solver->solve(b, x0);
+  const Field3D slices = solver->Laplacian::solve(b, x0);
+
+  EXPECT_TRUE(IsFieldEqual(batched, slices, "RGN_NOY", tol));
+}
+
+#endif // BOUT_HAS_FFTW and BOUT_HAS_LAPACK and not BOUT_USE_METRIC_3D
@@ -75,6 +75,112 @@ TEST_P(FFTTest, irfft) {
   }
 }
 
+TEST_P(FFTTest, rfftBatch) {
+
+  // Several copies of the signal, each scaled differently
+  constexpr int howmany = 3;
+  Array<BoutReal> input{size * howmany};
+  for (int j = 0; j < howmany; ++j) {
+    for (int i = 0; i < size; ++i) {
+      input[j * size + i] = (j + 1) * real_signal[i];
+    }
+  }
+
+  Array<dcomplex> output{nmodes * howmany};
+
+  // Compute all the forward real FFTs in one call
+  bout::fft::rfft(input.begin(), size, howmany, output.begin());
+
+  for (int j = 0; j < howmany; ++j) {
+    for (int i = 0; i < nmodes; ++i) {
+      EXPECT_NEAR(real(output[j * nmodes + i]), (j + 1) * real(fft_signal[i]),
+                  FFTTolerance);
+      EXPECT_NEAR(imag(output[j * nmodes + i]), (j + 1) * imag(fft_signal[i]),
+                  FFTTolerance);
+    }
+  }
+}
+
+TEST_P(FFTTest, irfftBatch) {
+
+  constexpr int howmany = 3;
+  Array<dcomplex> input{nmodes * howmany};
+  for (int j = 0; j < howmany; ++j) {
+    for (int i = 0; i < nmodes; ++i) {
+      input[j * nmodes + i] = static_cast<BoutReal>(j + 1) * fft_signal[i];
+    }
+  }
+  const Array<dcomplex> input_copy = copy(input);
+
+  Array<BoutReal> output{size * howmany};
+
+  // Compute all the inverse real FFTs in one call
+  bout::fft::irfft(input.begin(), size, howmany, output.begin());
+
+  for (int j = 0; j < howmany; ++j) {
+    for (int i = 0; i < size; ++i) {
+      EXPECT_NEAR(output[j * size + i], (j + 1) * real_signal[i], FFTTolerance);
+    }
+  }
+
+  // Input is not modified
+  for (int i = 0; i < nmodes * howmany; ++i) {
+    EXPECT_EQ(input[i], input_copy[i]);
+  }
+}
+
+TEST_P(FFTTest, irfftOverwriteInput) {
+
+  constexpr int howmany = 3;
+  Array<dcomplex> input{nmodes * howmany};
+  for (int j = 0; j < howmany; ++j) {
+    for (int i = 0; i < nmodes; ++i) {
+      input[j * nmodes + i] = static_cast<BoutReal>(j + 1) * fft_signal[i];
+    }
+  }
+
+  Array<BoutReal> output{size * howmany};
+
+  bout::fft::irfft_overwrite_input(input.begin(), size, howmany, output.begin());
+
+  for (int j = 0; j < howmany; ++j) {
+    for (int i = 0; i < size; ++i) {
+      EXPECT_NEAR(output[j * size + i], (j + 1) * real_signal[i], FFTTolerance);
+    }
+  }
+}
+
+TEST_P(FFTTest, RoundTripManyBatches) {
+
+  // More signals than fit in one batched plan, and not a power of two
+  constexpr int howmany = 100;
+  Array<BoutReal> input{size * howmany};
+  for (int j = 0; j < howmany; ++j) {
+    for (int i = 0; i < size; ++i) {
+      input[j * size + i] = (j + 1) * real_signal[i];
+    }
+  }
+
+  Array<dcomplex> modes{nmodes * howmany};
+  bout::fft::rfft(input.begin(), size, howmany, modes.begin());
+
+  for (int j = 0; j < howmany; ++j) {
+    for (int i = 0; i < nmodes; ++i) {
+      EXPECT_NEAR(real(modes[j * nmodes + i]), (j + 1) * real(fft_signal[i]),
+                  FFTTolerance * (j + 1));
+      EXPECT_NEAR(imag(modes[j * nmodes + i]), (j + 1) * imag(fft_signal[i]),
+                  FFTTolerance * (j + 1));
+    }
+  }
+
+  Array<BoutReal> output{size * howmany};
+  bout::fft::irfft(modes.begin(), size, howmany, output.begin());
+
+  for (int i = 0; i < size * howmany; ++i) {
+    EXPECT_NEAR(output[i], input[i], FFTTolerance * howmany);
+  }
+}
+
 TEST_P(FFTTest, rfftWithArray) {
 
   // Compute forward real FFT
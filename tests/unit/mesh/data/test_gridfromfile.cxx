@@ -0,0 +1,105 @@
+// Test reading fields from NetCDF grid files
+
+#include "bout/build_config.hxx"
+
+#if BOUT_HAS_NETCDF && !BOUT_HAS_LEGACY_NETCDF
+
+#include "gtest/gtest.h"
+
+#include "test_extras.hxx"
+#include "bout/field2d.hxx"
+#include "bout/field3d.hxx"
+#include "bout/griddata.hxx"
+#include "bout/mesh.hxx"
+#include "bout/options.hxx"
+#include "bout/options_netcdf.hxx"
+#include "bout/output.hxx"
+
+#include <cstdio>
+#include <string>
+
+/// Global mesh
+namespace bout {
+namespace globals {
+extern Mesh* mesh;
+}
+} // namespace bout
+
+using bout::globals::mesh;
+
+class GridFromFileTest : public FakeMeshFixture {
+public:
+  GridFromFileTest() : FakeMeshFixture() {
+    Options grid;
+    grid["nx"] = nx;
+    grid["ny"] = ny;
+    grid["nz"] = nz;
+    // Fields include the Y boundary cells, so the whole of each
+    // field in the file is read on this one processor
+    grid["y_boundary_guards"] = 1;
+
+    grid["a"] = expected_a;
+    grid["b"] = expected_b;
+    grid["c"] = expected_c;
+
+    bout::OptionsNetCDF(filename).write(grid);
+  }
+  ~GridFromFileTest() override { std::remove(filename.c_str()); }
+
+  // A temporary filename
+  std::string filename{std::tmpnam(nullptr)};
+  WithQuietOutput quiet_info{output_info};
+  WithQuietOutput quiet_warn{output_warn};
+
+  Field2D expected_a{makeField<Field2D>(
+      [](Field2D::ind_type& i) { return 10 * i.x() + i.y(); }, mesh)};
+  Field2D expected_b{makeField<Field2D>(
+      [](Field2D::ind_type& i) { return -(10 * i.x() + i.y()); }, mesh)};
+  Field3D expected_c{makeField<Field3D>(
+      [](Field3D::ind_type& i) { return 100 * i.x() + 10 * i.y() + i.z(); }, mesh)};
+};
+
+TEST_F(GridFromFileTest, ReadSeveralFields) {
+  GridFile grid(filename);
+
+  EXPECT_TRUE(grid.hasVar("a"));
+  EXPECT_TRUE(grid.hasVar("c"));
+  EXPECT_FALSE(grid.hasVar("missing"));
+
+  // Mix 2D and 3D reads, and read the same field twice, all through
+  // the file kept open by the first read
+  Field2D a;
+  EXPECT_TRUE(grid.get(mesh, a, "a"));
+  EXPECT_TRUE(IsFieldEqual(a, expected_a));
+
+  Field3D c;
+  EXPECT_TRUE(grid.get(mesh, c, "c"));
+  EXPECT_TRUE(IsFieldEqual(c, expected_c));
+
+  Field2D b;
+  EXPECT_TRUE(grid.get(mesh, b, "b"));
+  EXPECT_TRUE(IsFieldEqual(b, expected_b));
+
+  Field2D a_again;
+  EXPECT_TRUE(grid.get(mesh, a_again, "a"));
+  EXPECT_TRUE(IsFieldEqual(a_again, expected_a));
+
+  int grid_nz{0};
+  EXPECT_TRUE(grid.get(mesh, grid_nz, "nz"));
+  EXPECT_EQ(grid_nz, nz);
+}
+
+TEST_F(GridFromFileTest, ReadMissingField) {
+  GridFile grid(filename);
+
+  Field2D missing;
+  EXPECT_FALSE(grid.get(mesh, missing, "missing", 2.0));
+  EXPECT_TRUE(IsFieldEqual(missing, 2.0));
+
+  // Failing to find a variable doesn't stop later reads
+  Field3D c;
+  EXPECT_TRUE(grid.get(mesh, c, "c"));
+  EXPECT_TRUE(IsFieldEqual(c, expected_c));
+}
+
+#endif
@@ -2,14 +2,21 @@
 #include "gtest/gtest.h"
 
 #include "../src/mesh/impls/bout/boutmesh.hxx"
+#include "bout/field3d.hxx"
+#include "bout/fieldgroup.hxx"
 #include "bout/griddata.hxx"
+#include "bout/mpi_wrapper.hxx"
 #include "bout/options.hxx"
 #include "bout/output.hxx"
+#include "bout/z_transpose.hxx"
 
 #include "test_extras.hxx"
 
 #include <array>
+#include <cstring>
+#include <memory>
 #include <ostream>
+#include <vector>
 
 /// Forward declaration so we can construct a `BoutMeshExposer` from this
 struct BoutMeshParameters;
@@ -30,23 +37,36 @@ public:
   // Make protected methods public for testing
   using BoutMesh::add_target;
   using BoutMesh::addBoundaryRegions;
+  using BoutMesh::calcParallelSlices_on_communicate;
   using BoutMesh::chooseProcessorSplit;
+  using BoutMesh::chooseWeightedDecomposition;
   using BoutMesh::ConnectionInfo;
   using BoutMesh::createXBoundaries;
   using BoutMesh::createYBoundaries;
   using BoutMesh::default_connections;
   using BoutMesh::findProcessorSplit;
   using BoutMesh::getConnectionInfo;
+  using BoutMesh::max_comm_plans;
+  using BoutMesh::numCommPlans;
+  using BoutMesh::persistent_comms;
   using BoutMesh::PROC_NUM;
   using BoutMesh::set_connection;
+  using BoutMesh::setDerivedGridSizes;
   using BoutMesh::setShiftAngle;
   using BoutMesh::setXDecompositionIndices;
   using BoutMesh::setYDecompositionIndices;
+  using BoutMesh::setZDecomposition;
   using BoutMesh::topology;
   using BoutMesh::XDecompositionIndices;
   using BoutMesh::XPROC;
   using BoutMesh::YDecompositionIndices;
   using BoutMesh::YPROC;
+
+  void setMpiWrapper(MpiWrapper* wrapper) { mpi = wrapper; }
+  /// Takes ownership of \p source_in
+  void setSource(GridDataSource* source_in) { source = source_in; }
+  /// Lets fields be created without making a Coordinates
+  void setNullCoordinates() { coords_map[CELL_CENTRE] = nullptr; }
 };
 
 /// Minimal parameters need to construct a grid useful for testing
@@ -517,6 +537,120 @@ TEST(BoutMeshTest, ChooseProcessorSplitNYPE) {
   EXPECT_EQ(mesh.getNYPE(), 4);
 }
 
+TEST(BoutMeshTest, YProcessorBoundaries) {
+  // Core only
+  EXPECT_TRUE(bout::boutMeshYProcessorBoundaries(24, -1, 12, 12, 23, 12).empty());
+  // Single null
+  EXPECT_EQ(bout::boutMeshYProcessorBoundaries(24, 3, 11, 11, 19, 11),
+            (std::vector<int>{4, 20}));
+  // Double null
+  EXPECT_EQ(bout::boutMeshYProcessorBoundaries(24, 3, 7, 15, 19, 12),
+            (std::vector<int>{4, 8, 12, 16, 20}));
+}
+
+TEST(BoutMeshTest, WeightedDecompositionUniform) {
+  const std::vector<BoutReal> weights(12, 1.0);
+  EXPECT_EQ(bout::weightedDecomposition(weights, 3, 1), (std::vector<int>{0, 4, 8, 12}));
+}
+
+TEST(BoutMeshTest, WeightedDecomposition) {
+  const std::vector<BoutReal> weights{3., 3., 1., 1., 1., 1., 1., 1., 1., 1., 1., 1.};
+  EXPECT_EQ(bout::weightedDecomposition(weights, 2, 1), (std::vector<int>{0, 4, 12}));
+}
+
+TEST(BoutMeshTest, WeightedDecompositionMinPoints) {
+  const std::vector<BoutReal> weights{10., 1., 1., 1., 1., 1.};
+  EXPECT_EQ(bout::weightedDecomposition(weights, 3, 2), (std::vector<int>{0, 2, 4, 6}));
+}
+
+TEST(BoutMeshTest, WeightedDecompositionBoundaries) {
+  const std::vector<BoutReal> weights(8, 1.0);
+  EXPECT_EQ(bout::weightedDecomposition(weights, 3, 1, {2}),
+            (std::vector<int>{0, 2, 5, 8}));
+}
+
+TEST(BoutMeshTest, WeightedDecompositionBad) {
+  const std::vector<BoutReal> weights(8, 1.0);
+  // Fewer processors than ranges between boundaries
+  EXPECT_THROW(bout::weightedDecomposition(weights, 2, 1, {2, 4}), BoutException);
+  // Not enough points for min_points on each processor
+  EXPECT_THROW(bout::weightedDecomposition(weights, 5, 2), BoutException);
+  // Negative weights
+  const std::vector<BoutReal> negative{1., -1., 1., 1.};
+  EXPECT_THROW(bout::weightedDecomposition(negative, 2, 1), BoutException);
+}
+
+TEST(BoutMeshTest, LoadBalance) {
+  WithQuietOutput info{output_info};
+  WithQuietOutput warn{output_warn};
+
+  // Points in the lower third of X and the lower half of Y cost three
+  // times as much as the rest
+  Options options;
+  options["cost_weight_x"] = "where(x - 1/3, 1, 3)";
+  options["cost_weight_y"] = "where(y - pi, 1, 3)";
+
+  constexpr int nxpe = 3;
+  constexpr int nype = 2;
+  const auto x_offsets =
+      bout::weightedDecomposition({3., 3., 3., 1., 1., 1., 1., 1., 1.}, nxpe, 1);
+  const auto y_offsets = bout::weightedDecomposition({3., 3., 3., 1., 1., 1.}, nype, 1);
+  // Check the decomposition really is uneven
+  ASSERT_NE(x_offsets, (std::vector<int>{0, 3, 6, 9}));
+  ASSERT_NE(y_offsets, (std::vector<int>{0, 3, 6}));
+
+  std::array<std::array<std::unique_ptr<BoutMeshExposer>, nype>, nxpe> meshes;
+  for (int px = 0; px < nxpe; ++px) {
+    for (int py = 0; py < nype; ++py) {
+      auto& mesh = meshes[px][py];
+      mesh = std::make_unique<BoutMeshExposer>(5, 3, 1, nxpe, nype, px, py, false);
+      mesh->setSource(new GridFromOptions(&options));
+      mesh->chooseWeightedDecomposition();
+      mesh->setDerivedGridSizes();
+      mesh->topology();
+    }
+  }
+
+  for (int px = 0; px < nxpe; ++px) {
+    for (int py = 0; py < nype; ++py) {
+      const auto& mesh = *meshes[px][py];
+      EXPECT_EQ(mesh.OffsetX, x_offsets[px]);
+      EXPECT_EQ(mesh.OffsetY, y_offsets[py]);
+      EXPECT_EQ(mesh.LocalNx, x_offsets[px + 1] - x_offsets[px] + 2);
+      EXPECT_EQ(mesh.LocalNy, y_offsets[py + 1] - y_offsets[py] + 2);
+      EXPECT_EQ(mesh.getGlobalXIndex(mesh.xstart), x_offsets[px] + 1);
+      EXPECT_EQ(mesh.getGlobalYIndexNoBoundaries(mesh.ystart), y_offsets[py]);
+      for (int i = 0; i <= nxpe; ++i) {
+        EXPECT_EQ(mesh.getXProcOffset(i), x_offsets[i]);
+      }
+      for (int i = 0; i <= nype; ++i) {
+        EXPECT_EQ(mesh.getYProcOffset(i), y_offsets[i]);
+      }
+
+      // Every processor agrees which one owns each point
+      EXPECT_EQ(mesh.XPROC(mesh.getGlobalXIndex(mesh.xstart)), px);
+      EXPECT_EQ(mesh.XPROC(mesh.getGlobalXIndex(mesh.xend)), px);
+      EXPECT_EQ(mesh.YPROC(mesh.getGlobalYIndexNoBoundaries(mesh.ystart)), py);
+      EXPECT_EQ(mesh.YPROC(mesh.getGlobalYIndexNoBoundaries(mesh.yend)), py);
+
+      // Neighbours' guard cells line up with this processor's edges
+      if (px < nxpe - 1) {
+        const auto& next = *meshes[px + 1][py];
+        EXPECT_EQ(next.OffsetX, mesh.OffsetX + mesh.LocalNx - 2);
+        EXPECT_EQ(next.LocalNy, mesh.LocalNy);
+        EXPECT_EQ(next.getGlobalXIndex(next.xstart), mesh.getGlobalXIndex(mesh.xend) + 1);
+      }
+      if (py < nype - 1) {
+        const auto& next = *meshes[px][py + 1];
+        EXPECT_EQ(next.OffsetY, mesh.OffsetY + mesh.LocalNy - 2);
+        EXPECT_EQ(next.LocalNx, mesh.LocalNx);
+        EXPECT_EQ(next.getGlobalYIndexNoBoundaries(next.ystart),
+                  mesh.getGlobalYIndexNoBoundaries(mesh.yend) + 1);
+      }
+    }
+  }
+}
+
 struct FindProcessorParameters {
   int total_processors;
   int nx;
@@ -1461,6 +1595,16 @@ TEST(BoutMeshTest, GetGlobalZIndexNoBoundaries) {
   EXPECT_EQ(mesh11.getGlobalZIndexNoBoundaries(4), 4);
 }
 
+TEST(BoutMeshTest, NoZDecompositionByDefault) {
+  WithQuietOutput info{output_info};
+  WithQuietOutput warn{output_warn};
+
+  BoutMeshExposer mesh(5, 3, 4, 2, 2, 1, 1);
+  EXPECT_EQ(mesh.getNZPE(), 1);
+  EXPECT_EQ(mesh.getZProcIndex(), 0);
+  EXPECT_EQ(mesh.getNguard(DIRECTION::Z), 2);
+}
+
 TEST(BoutMeshTest, GetLocalZIndex) {
   WithQuietOutput info{output_info};
   WithQuietOutput warn{output_warn};
@@ -1553,6 +1697,49 @@ TEST(BoutMeshTest, GetLocalZIndexNoBoundaries) {
   EXPECT_EQ(mesh11.getLocalZIndexNoBoundaries(4), 4);
 }
 
+TEST(BoutMeshTest, ZDecomposition) {
+  WithQuietOutput info{output_info};
+  WithQuietOutput warn{output_warn};
+  // 2x2 processors in X-Y, each split into 3 in Z, with 8 points and
+  // 2 guard cells on each Z processor. This is processor (1, 0, 2)
+
+  BoutMeshExposer mesh(5, 3, 24, 2, 2, 1, 0, false);
+  mesh.setZDecomposition(3, 2, 2);
+
+  EXPECT_EQ(mesh.getNZPE(), 3);
+  EXPECT_EQ(mesh.getZProcIndex(), 2);
+  EXPECT_EQ(mesh.getNguard(DIRECTION::Z), 2);
+  EXPECT_EQ(mesh.GlobalNz, 24);
+  EXPECT_EQ(mesh.LocalNz, 12);
+  EXPECT_EQ(mesh.zstart, 2);
+  EXPECT_EQ(mesh.zend, 9);
+  EXPECT_EQ(mesh.OffsetZ, 16);
+
+  // The guard cells are the neighbouring processors' points, and wrap
+  // around from the last processor to the first
+  EXPECT_EQ(mesh.getGlobalZIndex(0), 14);
+  EXPECT_EQ(mesh.getGlobalZIndex(2), 16);
+  EXPECT_EQ(mesh.getGlobalZIndex(9), 23);
+  EXPECT_EQ(mesh.getGlobalZIndex(11), 25);
+  EXPECT_EQ(mesh.getGlobalZIndexNoBoundaries(2), 16);
+  EXPECT_EQ(mesh.getLocalZIndex(16), 2);
+  EXPECT_EQ(mesh.getLocalZIndex(23), 9);
+  EXPECT_EQ(mesh.getLocalZIndexNoBoundaries(20), 6);
+
+  // Processors are numbered in X, then Y, then Z
+  EXPECT_EQ(mesh.getNXPE(), 2);
+  EXPECT_EQ(mesh.getNYPE(), 2);
+  EXPECT_EQ(mesh.PROC_NUM(0, 0), 8);
+  EXPECT_EQ(mesh.PROC_NUM(1, 0), 9);
+  EXPECT_EQ(mesh.PROC_NUM(0, 1), 10);
+  EXPECT_EQ(mesh.PROC_NUM(1, 1), 11);
+  EXPECT_EQ(mesh.PROC_NUM(2, 0), -1);
+  EXPECT_EQ(mesh.PROC_NUM(0, 2), -1);
+  EXPECT_EQ(mesh.XPROC(3), 0);
+  EXPECT_EQ(mesh.XPROC(4), 1);
+  EXPECT_EQ(mesh.YPROC(3), 1);
+}
+
 TEST(BoutMeshTest, FirstX) {
   WithQuietOutput info{output_info};
   WithQuietOutput warn{output_warn};
@@ -2157,3 +2344,299 @@ TEST(BoutMeshTest, GetPossibleBoundariesDND) {
   EXPECT_EQ(mesh_DND_1x6.getPossibleBoundaries(), boundaries);
   EXPECT_EQ(mesh_DND_32x64.getPossibleBoundaries(), boundaries);
 }
+
+/// Passes calls on to MPI, counting the persistent requests created
+/// and freed
+class CountingMpiWrapper : public MpiWrapper {
+public:
+  int MPI_Send_init(const void* buf, int count, MPI_Datatype datatype, int dest, int tag,
+                    MPI_Comm comm, MPI_Request* request) override {
+    ++created;
+    return MpiWrapper::MPI_Send_init(buf, count, datatype, dest, tag, comm, request);
+  }
+  int MPI_Recv_init(void* buf, int count, MPI_Datatype datatype, int source, int tag,
+                    MPI_Comm comm, MPI_Request* request) override {
+    ++created;
+    return MpiWrapper::MPI_Recv_init(buf, count, datatype, source, tag, comm, request);
+  }
+  int MPI_Request_free(MPI_Request* request) override {
+    ++freed;
+    return MpiWrapper::MPI_Request_free(request);
+  }
+
+  int created{0};
+  int freed{0};
+};
+
+TEST(BoutMeshTest, PersistentCommPlans) {
+  WithQuietOutput info{output_info};
+  WithQuietOutput warn{output_warn};
+
+  CountingMpiWrapper counting_mpi;
+
+  // One processor, connected to itself in Y so that the guard cells
+  // are really sent and received
+  BoutMeshExposer mesh(5, 3, 2, 1, 1, 0, 0, false);
+  mesh.setMpiWrapper(&counting_mpi);
+  mesh.default_connections();
+  mesh.set_connection(0, 2, 0, 5);
+  mesh.createDefaultRegions();
+  mesh.setNullCoordinates();
+  mesh.persistent_comms = true;
+
+  Field3D field{&mesh};
+  field.allocate();
+  for (int x = 0; x < mesh.LocalNx; ++x) {
+    for (int y = 0; y < mesh.LocalNy; ++y) {
+      for (int z = 0; z < mesh.LocalNz; ++z) {
+        field(x, y, z) = y;
+      }
+    }
+  }
+
+  FieldGroup group(field);
+  mesh.wait(mesh.sendY(group, nullptr));
+  EXPECT_EQ(mesh.numCommPlans(), 1);
+  const int created = counting_mpi.created;
+  EXPECT_GT(created, 0);
+
+  for (int x = mesh.xstart; x <= mesh.xend; ++x) {
+    for (int z = 0; z < mesh.LocalNz; ++z) {
+      EXPECT_EQ(field(x, 0, z), 3);
+      EXPECT_EQ(field(x, 4, z), 1);
+    }
+  }
+
+  // Communicating the same group again reuses the plan
+  field(mesh.xstart, 3, 0) = 5;
+  mesh.wait(mesh.sendY(group, nullptr));
+  EXPECT_EQ(mesh.numCommPlans(), 1);
+  EXPECT_EQ(counting_mpi.created, created);
+  EXPECT_EQ(counting_mpi.freed, 0);
+  EXPECT_EQ(field(mesh.xstart, 0, 0), 5);
+
+  // Each new group makes a plan, until the least recently used one,
+  // the first, is freed
+  std::vector<Field3D> fields;
+  fields.reserve(BoutMeshExposer::max_comm_plans);
+  for (std::size_t i = 0; i < BoutMeshExposer::max_comm_plans; ++i) {
+    fields.emplace_back(&mesh);
+    fields.back().allocate();
+    FieldGroup other(fields.back());
+    mesh.wait(mesh.sendY(other, nullptr));
+  }
+  EXPECT_EQ(mesh.numCommPlans(), BoutMeshExposer::max_comm_plans);
+  EXPECT_EQ(counting_mpi.created,
+            static_cast<int>(BoutMeshExposer::max_comm_plans + 1) * created);
+  EXPECT_EQ(counting_mpi.freed, created);
+
+  // The first group now needs a new plan
+  mesh.wait(mesh.sendY(group, nullptr));
+  EXPECT_EQ(mesh.numCommPlans(), BoutMeshExposer::max_comm_plans);
+  EXPECT_EQ(counting_mpi.created,
+            static_cast<int>(BoutMeshExposer::max_comm_plans + 2) * created);
+  EXPECT_EQ(counting_mpi.freed, 2 * created);
+}
+
+TEST(BoutMeshTest, StartCommunicateCorners) {
+  WithQuietOutput info{output_info};
+  WithQuietOutput warn{output_warn};
+
+  MpiWrapper mpi_wrapper;
+
+  for (const bool persistent : {false, true}) {
+    // One processor, connected to itself in both X and Y, so that
+    // the corner cells are only filled by sending the Y guard cells
+    // in X
+    BoutMeshExposer mesh(5, 3, 2, 1, 1, 0, 0, false);
+    mesh.setMpiWrapper(&mpi_wrapper);
+    mesh.periodicX = true;
+    mesh.default_connections();
+    mesh.set_connection(0, 2, 0, 5);
+    mesh.createDefaultRegions();
+    mesh.setNullCoordinates();
+    mesh.persistent_comms = persistent;
+    // There are no Coordinates to calculate the parallel slices with
+    mesh.calcParallelSlices_on_communicate = false;
+
+    ASSERT_TRUE(mesh.include_corner_cells);
+
+    const auto wrap = [](int i, int start, int end) {
+      const int n = end - start + 1;
+      return start + (((i - start) % n) + n) % n;
+    };
+    const auto value = [&](int x, int y) {
+      return 10 * wrap(x, mesh.xstart, mesh.xend) + wrap(y, mesh.ystart, mesh.yend);
+    };
+
+    Field3D field{&mesh};
+    field = -1.0;
+    for (int x = mesh.xstart; x <= mesh.xend; ++x) {
+      for (int y = mesh.ystart; y <= mesh.yend; ++y) {
+        for (int z = 0; z < mesh.LocalNz; ++z) {
+          field(x, y, z) = value(x, y);
+        }
+      }
+    }
+
+    FieldGroup group(field);
+    mesh.finishCommunicate(mesh.startCommunicate(group), group);
+
+    for (int x = 0; x < mesh.LocalNx; ++x) {
+      for (int y = 0; y < mesh.LocalNy; ++y) {
+        for (int z = 0; z < mesh.LocalNz; ++z) {
+          EXPECT_EQ(field(x, y, z), value(x, y)) << x << ", " << y << ", " << z;
+        }
+      }
+    }
+  }
+}
+
+/// Acts as though every processor in Z holds the same data as this
+/// one, which is Z processor \p zproc of \p nzpe. Persistent messages
+/// come back to this processor, and all-to-all exchanges give every
+/// processor the block this one sends to itself
+class LoopbackMpiWrapper : public MpiWrapper {
+public:
+  LoopbackMpiWrapper(int zproc, int nzpe) : zproc(zproc), nzpe(nzpe) {}
+
+  int MPI_Send_init(const void* buf, int count, MPI_Datatype datatype, int UNUSED(dest),
+                    int tag, MPI_Comm UNUSED(comm), MPI_Request* request) override {
+    return MpiWrapper::MPI_Send_init(buf, count, datatype, 0, tag, MPI_COMM_SELF,
+                                     request);
+  }
+  int MPI_Recv_init(void* buf, int count, MPI_Datatype datatype, int UNUSED(source),
+                    int tag, MPI_Comm UNUSED(comm), MPI_Request* request) override {
+    return MpiWrapper::MPI_Recv_init(buf, count, datatype, 0, tag, MPI_COMM_SELF,
+                                     request);
+  }
+  int MPI_Alltoallv(const void* sendbuf, const int* UNUSED(sendcounts),
+                    const int* sdispls, MPI_Datatype sendtype, void* recvbuf,
+                    const int* recvcounts, const int* rdispls,
+                    MPI_Datatype UNUSED(recvtype), MPI_Comm UNUSED(comm)) override {
+    int size;
+    MPI_Type_size(sendtype, &size);
+    for (int p = 0; p < nzpe; ++p) {
+      std::memcpy(static_cast<char*>(recvbuf) + rdispls[p] * size,
+                  static_cast<const char*>(sendbuf) + sdispls[zproc] * size,
+                  recvcounts[p] * size);
+    }
+    return MPI_SUCCESS;
+  }
+
+private:
+  int zproc, nzpe;
+};
+
+class ZHaloTest : public testing::TestWithParam<bool> {};
+
+INSTANTIATE_TEST_SUITE_P(PersistentComms, ZHaloTest, testing::Bool());
+
+TEST_P(ZHaloTest, Communicate) {
+  WithQuietOutput info{output_info};
+  WithQuietOutput warn{output_warn};
+
+  // One processor in X-Y, connected to itself in Y, and the first of
+  // two in Z. The other Z processor has the same data, so the guard
+  // cells are filled as if Z were periodic on this processor
+  LoopbackMpiWrapper loopback(0, 2);
+  BoutMeshExposer mesh(5, 3, 8, 1, 1, 0, 0, false);
+  mesh.setZDecomposition(2, 0, 2);
+  mesh.setMpiWrapper(&loopback);
+  mesh.default_connections();
+  mesh.set_connection(0, 2, 0, 5);
+  mesh.createDefaultRegions();
+  mesh.setNullCoordinates();
+  mesh.persistent_comms = GetParam();
+
+  ASSERT_EQ(mesh.LocalNz, 8);
+
+  // Wrap guard cells around to the points they are copies of
+  const auto wrap = [](int i, int start, int end) {
+    const int n = end - start + 1;
+    return start + (((i - start) % n) + n) % n;
+  };
+  const auto value = [&](int x, int y, int z) {
+    return 100 * x + 10 * wrap(y, mesh.ystart, mesh.yend)
+           + wrap(z, mesh.zstart, mesh.zend);
+  };
+
+  Field3D field{&mesh};
+  field = -1.0;
+  Field2D field2d{&mesh};
+  field2d = 3.0;
+  for (int x = 0; x < mesh.LocalNx; ++x) {
+    for (int y = mesh.ystart; y <= mesh.yend; ++y) {
+      for (int z = mesh.zstart; z <= mesh.zend; ++z) {
+        field(x, y, z) = value(x, y, z);
+      }
+    }
+  }
+
+  FieldGroup group(field, field2d);
+  for (int repeat = 0; repeat < 2; ++repeat) {
+    // As Mesh::communicate does with corner cells
+    mesh.wait(mesh.sendY(group, nullptr));
+    mesh.wait(mesh.sendX(group, nullptr));
+
+    // Including the corners with the Y guard cells, which are only
+    // filled by the Y communication
+    for (int x = 0; x < mesh.LocalNx; ++x) {
+      for (int y = 0; y < mesh.LocalNy; ++y) {
+        for (int z = 0; z < mesh.LocalNz; ++z) {
+          EXPECT_EQ(field(x, y, z), value(x, y, z)) << x << ", " << y << ", " << z;
+        }
+      }
+    }
+    EXPECT_TRUE(IsFieldEqual(field2d, 3.0, "RGN_ALL"));
+  }
+
+  // A Z plan for each of the X and Y communications is kept, and
+  // reused the second time
+  EXPECT_EQ(mesh.numCommPlans(), GetParam() ? 4 : 2);
+}
+
+TEST(BoutMeshTest, ForEachZLine) {
+  WithQuietOutput info{output_info};
+  WithQuietOutput warn{output_warn};
+
+  // Last of two processors in Z. The other has the same data, and the
+  // only line is transformed on this processor
+  LoopbackMpiWrapper loopback(1, 2);
+  BoutMeshExposer mesh(5, 3, 8, 1, 1, 0, 0, false);
+  mesh.setZDecomposition(2, 1, 1);
+  mesh.setMpiWrapper(&loopback);
+  mesh.default_connections();
+  mesh.createDefaultRegions();
+  mesh.setNullCoordinates();
+
+  Field3D field{&mesh};
+  field = -1.0;
+  for (int z = mesh.zstart; z <= mesh.zend; ++z) {
+    field(2, 2, z) = z - mesh.zstart;
+  }
+  Field3D result{&mesh};
+
+  const Region<Ind2D> region(2, 2, 2, 2, 0, 0, mesh.LocalNy, 1);
+  int calls = 0;
+  bout::forEachZLine(field, result, region,
+                     [&](Ind2D i, const BoutReal* in, BoutReal* out,
+                         dcomplex* UNUSED(modes)) {
+                       ++calls;
+                       EXPECT_EQ(i.x(), 2);
+                       EXPECT_EQ(i.y(), 2);
+                       // The whole line, in global Z order
+                       for (int k = 0; k < mesh.GlobalNz; ++k) {
+                         EXPECT_EQ(in[k], k % 4);
+                       }
+                       for (int k = 0; k < mesh.GlobalNz; ++k) {
+                         out[k] = 10 * k;
+                       }
+                     });
+  EXPECT_EQ(calls, 1);
+
+  // This processor's part of the result
+  for (int z = mesh.zstart; z <= mesh.zend; ++z) {
+    EXPECT_EQ(result(2, 2, z), 10 * mesh.getGlobalZIndex(z));
+  }
+}
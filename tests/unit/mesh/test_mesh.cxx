@@ -93,6 +93,41 @@ TEST_F(MeshTest, GetRegionTemplatedFromMesh) {
   EXPECT_THAT(regionT_Perp, ElementsAreArray(regionPerp));
 }
 
+TEST_F(MeshTest, InteriorAndShellRegions) {
+  // Large enough that the interior isn't empty
+  FakeMesh bigmesh(7, 9, 3);
+  bigmesh.createDefaultRegions();
+
+  const auto& nobndry = bigmesh.getRegion3D("RGN_NOBNDRY");
+  const auto& interior = bigmesh.getRegion3D("RGN_NOBNDRY_INTERIOR");
+  const auto& shell = bigmesh.getRegion3D("RGN_NOBNDRY_SHELL");
+
+  // One guard cell, so interior is x = 2..4, y = 2..6
+  EXPECT_EQ(interior.size(), 3 * 5 * 3);
+  EXPECT_EQ(interior.size() + shell.size(), nobndry.size());
+  EXPECT_EQ((interior + shell).unique().size(), nobndry.size());
+
+  for (const auto& i : interior) {
+    EXPECT_GE(i.x(), 2);
+    EXPECT_LE(i.x(), 4);
+    EXPECT_GE(i.y(), 2);
+    EXPECT_LE(i.y(), 6);
+  }
+
+  EXPECT_EQ(bigmesh.getRegion2D("RGN_NOBNDRY_INTERIOR").size(), 3 * 5);
+  EXPECT_EQ(bigmesh.getRegion2D("RGN_NOBNDRY_SHELL").size(), 5 * 7 - 3 * 5);
+  EXPECT_EQ(bigmesh.getRegionPerp("RGN_NOBNDRY_INTERIOR").size(), 3 * 3);
+  EXPECT_EQ(bigmesh.getRegionPerp("RGN_NOBNDRY_SHELL").size(), 5 * 3 - 3 * 3);
+}
+
+TEST_F(MeshTest, InteriorRegionEmptyForSmallMesh) {
+  localmesh.createDefaultRegions();
+
+  EXPECT_EQ(localmesh.getRegion3D("RGN_NOBNDRY_INTERIOR").size(), 0);
+  EXPECT_EQ(localmesh.getRegion3D("RGN_NOBNDRY_SHELL").size(),
+            localmesh.getRegion3D("RGN_NOBNDRY").size());
+}
+
 TEST_F(MeshTest, AddRegionToMesh) {
   Region<Ind3D> junk(0, 0, 0, 0, 0, 0, 1, 1);
   EXPECT_NO_THROW(localmesh.addRegion("RGN_JUNK", junk));
@@ -64,14 +64,23 @@ public:
   auto getMaxTimestepShim() const -> BoutReal { return max_dt; }
   using Solver::call_monitors;
   using Solver::call_timestep_monitors;
+  using Solver::create_solver_fields;
+  using Solver::forEachJacobianRow;
   using Solver::getLocalN;
   using Solver::getMonitors;
   using Solver::globalIndex;
   using Solver::hasJacobian;
   using Solver::hasPreconditioner;
+  using Solver::load_vars;
   using Solver::MonitorInfo;
+  using Solver::probeJacobianPattern;
+  using Solver::release_vars;
   using Solver::runJacobian;
   using Solver::runPreconditioner;
+  using Solver::save_derivs;
+  using Solver::save_vars;
+  using Solver::set_field_values;
+  using Solver::starJacobianPattern;
 };
 
 // Equality operator for tests
@@ -0,0 +1,300 @@
+#include "bout/build_defines.hxx"
+
+#if BOUT_HAS_SUNDIALS
+
+#include "gtest/gtest.h"
+
+#include "test_extras.hxx"
+#include "bout/boutcomm.hxx"
+#include "bout/field2d.hxx"
+#include "bout/field3d.hxx"
+#include "bout/field_nvector.hxx"
+#include "bout/solver.hxx"
+
+#include <cmath>
+#include <memory>
+
+#if SUNDIALS_VERSION_MAJOR >= 5
+
+namespace {
+/// Guard cells are not part of the vector, so are given a value which
+/// would change the result of any operation which used them
+constexpr BoutReal guard_value = 1e10;
+
+class FieldNVectorTest : public FakeMeshFixture {
+public:
+  FieldNVectorTest()
+      : FakeMeshFixture(), comm(BoutComm::get()), ctx(createSUNContext(comm)),
+        regions(std::make_shared<SolverFields::Regions>(SolverFields::Regions{
+            {bout::globals::mesh->getRegion2D("RGN_NOBNDRY")},
+            {bout::globals::mesh->getRegion3D("RGN_NOBNDRY")}})) {}
+
+  ~FieldNVectorTest() override {
+    for (auto* v : vectors) {
+      N_VDestroy(v);
+    }
+  }
+
+  /// A vector with one 2D and one 3D variable, equal to \p value2d
+  /// and \p value3d at all the evolving points
+  N_Vector makeVector(BoutReal value2d, BoutReal value3d) {
+    SolverFields fields;
+    fields.f2d.emplace_back(guard_value, bout::globals::mesh);
+    fields.f3d.emplace_back(guard_value, bout::globals::mesh);
+    fields.regions = regions;
+    BOUT_FOR_SERIAL(i, regions->f2d[0]) { fields.f2d[0][i] = value2d; }
+    BOUT_FOR_SERIAL(i, regions->f3d[0]) { fields.f3d[0][i] = value3d; }
+
+    N_Vector v = bout::createFieldNVector(std::move(fields), comm, ctx);
+    vectors.push_back(v);
+    return v;
+  }
+
+  /// A vector to hold results, with its guard cells unset
+  N_Vector makeResult() {
+    N_Vector v = N_VClone(vectors.front());
+    vectors.push_back(v);
+    return v;
+  }
+
+  static Field2D& field2d(N_Vector v) { return bout::getFieldNVectorFields(v).f2d[0]; }
+  static Field3D& field3d(N_Vector v) { return bout::getFieldNVectorFields(v).f3d[0]; }
+
+  /// Check the evolving points of \p v are \p value2d and \p value3d
+  void expectValues(N_Vector v, BoutReal value2d, BoutReal value3d) const {
+    BOUT_FOR_SERIAL(i, regions->f2d[0]) {
+      EXPECT_DOUBLE_EQ(field2d(v)[i], value2d) << "at " << i.x() << ", " << i.y();
+    }
+    BOUT_FOR_SERIAL(i, regions->f3d[0]) {
+      EXPECT_DOUBLE_EQ(field3d(v)[i], value3d)
+          << "at " << i.x() << ", " << i.y() << ", " << i.z();
+    }
+  }
+
+  /// Number of evolving points of each variable
+  int n2d() const { return regions->f2d[0].size(); }
+  int n3d() const { return regions->f3d[0].size(); }
+
+  MPI_Comm comm;
+  sundials::Context ctx;
+  std::shared_ptr<const SolverFields::Regions> regions;
+
+private:
+  std::vector<N_Vector> vectors;
+};
+} // namespace
+
+TEST_F(FieldNVectorTest, CreateVector) {
+  N_Vector v = makeVector(1.0, 2.0);
+
+  EXPECT_TRUE(bout::isFieldNVector(v));
+  EXPECT_EQ(N_VGetVectorID(v), SUNDIALS_NVEC_CUSTOM);
+  EXPECT_EQ(N_VGetLength(v), n2d() + n3d());
+  // The guard cells are not part of the vector
+  EXPECT_LT(N_VGetLength(v), nx * ny + nx * ny * nz);
+
+  expectValues(v, 1.0, 2.0);
+}
+
+TEST_F(FieldNVectorTest, CloneHasOwnData) {
+  N_Vector v = makeVector(1.0, 2.0);
+  N_Vector clone = makeResult();
+
+  EXPECT_TRUE(bout::isFieldNVector(clone));
+  EXPECT_EQ(N_VGetLength(clone), N_VGetLength(v));
+  EXPECT_NE(&field3d(clone)(0, 0, 0), &field3d(v)(0, 0, 0));
+  EXPECT_NE(&field2d(clone)(0, 0), &field2d(v)(0, 0));
+
+  N_VConst(3.0, clone);
+  expectValues(v, 1.0, 2.0);
+}
+
+TEST_F(FieldNVectorTest, OutputSharingData) {
+  // The output may share its data with another field, such as an
+  // evolving variable, which mustn't be changed
+  N_Vector v = makeVector(1.0, 2.0);
+  const Field3D shared = field3d(v);
+
+  N_VConst(3.0, v);
+
+  expectValues(v, 3.0, 3.0);
+  EXPECT_DOUBLE_EQ(shared(1, 1, 1), 2.0);
+}
+
+TEST_F(FieldNVectorTest, LinearSum) {
+  N_Vector x = makeVector(1.0, 2.0);
+  N_Vector y = makeVector(3.0, 4.0);
+  N_Vector z = makeResult();
+
+  N_VLinearSum(2.0, x, -1.0, y, z);
+  expectValues(z, -1.0, 0.0);
+}
+
+TEST_F(FieldNVectorTest, Const) {
+  N_Vector z = makeVector(1.0, 2.0);
+
+  N_VConst(-4.0, z);
+  expectValues(z, -4.0, -4.0);
+}
+
+TEST_F(FieldNVectorTest, Prod) {
+  N_Vector x = makeVector(2.0, 3.0);
+  N_Vector y = makeVector(4.0, 5.0);
+  N_Vector z = makeResult();
+
+  N_VProd(x, y, z);
+  expectValues(z, 8.0, 15.0);
+}
+
+TEST_F(FieldNVectorTest, Div) {
+  N_Vector x = makeVector(2.0, 3.0);
+  N_Vector y = makeVector(4.0, 5.0);
+  N_Vector z = makeResult();
+
+  N_VDiv(x, y, z);
+  expectValues(z, 0.5, 0.6);
+}
+
+TEST_F(FieldNVectorTest, Scale) {
+  N_Vector x = makeVector(2.0, 3.0);
+  N_Vector z = makeResult();
+
+  N_VScale(1.5, x, z);
+  expectValues(z, 3.0, 4.5);
+
+  // In place
+  N_VScale(2.0, z, z);
+  expectValues(z, 6.0, 9.0);
+}
+
+TEST_F(FieldNVectorTest, Abs) {
+  N_Vector x = makeVector(-2.0, 3.0);
+  N_Vector z = makeResult();
+
+  N_VAbs(x, z);
+  expectValues(z, 2.0, 3.0);
+}
+
+TEST_F(FieldNVectorTest, Inv) {
+  N_Vector x = makeVector(-2.0, 4.0);
+  N_Vector z = makeResult();
+
+  N_VInv(x, z);
+  expectValues(z, -0.5, 0.25);
+}
+
+TEST_F(FieldNVectorTest, AddConst) {
+  N_Vector x = makeVector(-2.0, 4.0);
+  N_Vector z = makeResult();
+
+  N_VAddConst(x, 1.5, z);
+  expectValues(z, -0.5, 5.5);
+}
+
+TEST_F(FieldNVectorTest, Compare) {
+  N_Vector x = makeVector(-2.0, 0.5);
+  N_Vector z = makeResult();
+
+  N_VCompare(1.0, x, z);
+  expectValues(z, 1.0, 0.0);
+}
+
+TEST_F(FieldNVectorTest, DotProd) {
+  N_Vector x = makeVector(2.0, 3.0);
+  N_Vector y = makeVector(4.0, -1.0);
+
+  EXPECT_DOUBLE_EQ(N_VDotProd(x, y), 8.0 * n2d() - 3.0 * n3d());
+}
+
+TEST_F(FieldNVectorTest, MaxNorm) {
+  N_Vector x = makeVector(2.0, -3.0);
+  EXPECT_DOUBLE_EQ(N_VMaxNorm(x), 3.0);
+
+  field3d(x)(1, 2, 3) = -7.0;
+  EXPECT_DOUBLE_EQ(N_VMaxNorm(x), 7.0);
+}
+
+TEST_F(FieldNVectorTest, WrmsNorm) {
+  N_Vector x = makeVector(2.0, 3.0);
+  N_Vector w = makeVector(0.5, 2.0);
+
+  const BoutReal expected = std::sqrt((1.0 * n2d() + 36.0 * n3d()) / (n2d() + n3d()));
+  EXPECT_DOUBLE_EQ(N_VWrmsNorm(x, w), expected);
+}
+
+TEST_F(FieldNVectorTest, WrmsNormMask) {
+  N_Vector x = makeVector(2.0, 3.0);
+  N_Vector w = makeVector(0.5, 2.0);
+  // Only the 2D variable is included
+  N_Vector id = makeVector(1.0, 0.0);
+
+  const BoutReal expected = std::sqrt((1.0 * n2d()) / (n2d() + n3d()));
+  EXPECT_DOUBLE_EQ(N_VWrmsNormMask(x, w, id), expected);
+}
+
+TEST_F(FieldNVectorTest, WL2Norm) {
+  N_Vector x = makeVector(2.0, 3.0);
+  N_Vector w = makeVector(0.5, 2.0);
+
+  EXPECT_DOUBLE_EQ(N_VWL2Norm(x, w), std::sqrt(1.0 * n2d() + 36.0 * n3d()));
+}
+
+TEST_F(FieldNVectorTest, Min) {
+  N_Vector x = makeVector(2.0, 3.0);
+  EXPECT_DOUBLE_EQ(N_VMin(x), 2.0);
+
+  field3d(x)(1, 2, 3) = -7.0;
+  EXPECT_DOUBLE_EQ(N_VMin(x), -7.0);
+}
+
+TEST_F(FieldNVectorTest, L1Norm) {
+  N_Vector x = makeVector(-2.0, 3.0);
+
+  EXPECT_DOUBLE_EQ(N_VL1Norm(x), 2.0 * n2d() + 3.0 * n3d());
+}
+
+TEST_F(FieldNVectorTest, InvTest) {
+  N_Vector x = makeVector(-2.0, 4.0);
+  N_Vector z = makeResult();
+
+  EXPECT_TRUE(N_VInvTest(x, z));
+  expectValues(z, -0.5, 0.25);
+
+  field2d(x)(1, 2) = 0.0;
+  EXPECT_FALSE(N_VInvTest(x, z));
+}
+
+TEST_F(FieldNVectorTest, ConstrMask) {
+  // x must be positive in the 2D variable, and not negative in the 3D
+  // variable
+  N_Vector c = makeVector(2.0, 1.0);
+  N_Vector m = makeResult();
+
+  N_Vector good = makeVector(1.0, 0.0);
+  EXPECT_TRUE(N_VConstrMask(c, good, m));
+  expectValues(m, 0.0, 0.0);
+
+  N_Vector bad = makeVector(0.0, -1.0);
+  EXPECT_FALSE(N_VConstrMask(c, bad, m));
+  expectValues(m, 1.0, 1.0);
+
+  // No constraint
+  N_VConst(0.0, c);
+  EXPECT_TRUE(N_VConstrMask(c, bad, m));
+}
+
+TEST_F(FieldNVectorTest, MinQuotient) {
+  N_Vector num = makeVector(2.0, 3.0);
+  N_Vector denom = makeVector(4.0, 2.0);
+
+  EXPECT_DOUBLE_EQ(N_VMinQuotient(num, denom), 0.5);
+
+  // Points with zero denominators are skipped
+  N_VConst(0.0, denom);
+  field3d(denom)(1, 2, 3) = 10.0;
+  EXPECT_DOUBLE_EQ(N_VMinQuotient(num, denom), 0.3);
+}
+
+#endif // SUNDIALS_VERSION_MAJOR >= 5
+
+#endif // BOUT_HAS_SUNDIALS
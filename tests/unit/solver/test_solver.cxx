@@ -11,6 +11,7 @@
 #include "bout/sys/uuid.h"
 
 #include <algorithm>
+#include <numeric>
 #include <string>
 #include <vector>
 
@@ -635,6 +636,252 @@ TEST_F(SolverTest, GetLocalN) {
   EXPECT_EQ(solver.getLocalN(), expected_total);
 }
 
+TEST_F(SolverTest, BlockLayout) {
+  Options options;
+  options["layout"] = "block";
+  FakeSolver solver{&options};
+
+  Options::root()["input"]["transform_from_field_aligned"] = false;
+
+  Field2D field2d{bout::globals::mesh};
+  Field3D field3d{bout::globals::mesh};
+  solver.add(field2d, "field");
+  solver.add(field3d, "another_field");
+  solver.init();
+
+  // Give every point a different value
+  BOUT_FOR_SERIAL(i, field2d.getRegion("RGN_ALL")) { field2d[i] = i.ind; }
+  BOUT_FOR_SERIAL(i, field3d.getRegion("RGN_ALL")) { field3d[i] = 1000 + i.ind; }
+
+  const auto& region2d = field2d.getRegion("RGN_NOBNDRY");
+  const auto& region3d = field3d.getRegion("RGN_NOBNDRY");
+  std::vector<BoutReal> state(region2d.size() + region3d.size());
+
+  solver.save_vars(state.data());
+
+  // Each variable is one contiguous block, in the same order as in memory
+  std::size_t p = 0;
+  for (const auto& i : region2d) {
+    EXPECT_EQ(state[p++], field2d[i]);
+  }
+  for (const auto& i : region3d) {
+    EXPECT_EQ(state[p++], field3d[i]);
+  }
+
+  field2d = 0.0;
+  field3d = 0.0;
+  solver.load_vars(state.data());
+
+  for (const auto& i : region2d) {
+    EXPECT_EQ(field2d[i], i.ind);
+  }
+  for (const auto& i : region3d) {
+    EXPECT_EQ(field3d[i], 1000 + i.ind);
+  }
+
+  EXPECT_THROW(solver.globalIndex(0), BoutException);
+
+  solver.set_field_values(state.data(), {1.0}, {2.0});
+  p = 0;
+  for (std::size_t i = 0; i < region2d.size(); ++i) {
+    EXPECT_EQ(state[p++], 1.0);
+  }
+  for (std::size_t i = 0; i < region3d.size(); ++i) {
+    EXPECT_EQ(state[p++], 2.0);
+  }
+}
+
+TEST_F(SolverTest, SolverFields) {
+  Options options;
+  FakeSolver solver{&options};
+
+  Options::root()["input"]["transform_from_field_aligned"] = false;
+
+  Field2D field2d{bout::globals::mesh};
+  Field3D field3d{bout::globals::mesh};
+  solver.add(field2d, "field");
+  solver.add(field3d, "another_field");
+  solver.init();
+
+  field2d = 1.0;
+  field3d = 2.0;
+
+  auto state = solver.create_solver_fields();
+  ASSERT_EQ(state.f2d.size(), 1);
+  ASSERT_EQ(state.f3d.size(), 1);
+  EXPECT_EQ(state.regions->f2d[0].size(), field2d.getRegion("RGN_NOBNDRY").size());
+  EXPECT_EQ(state.regions->f3d[0].size(), field3d.getRegion("RGN_NOBNDRY").size());
+
+  // Saving copies the variables
+  solver.save_vars(state);
+  EXPECT_TRUE(IsFieldEqual(state.f2d[0], 1.0));
+  EXPECT_TRUE(IsFieldEqual(state.f3d[0], 2.0));
+  EXPECT_NE(&state.f3d[0](0, 0, 0), &field3d(0, 0, 0));
+
+  // Loading shares the data
+  solver.load_vars(state);
+  EXPECT_EQ(&field2d(0, 0), &state.f2d[0](0, 0));
+  EXPECT_EQ(&field3d(0, 0, 0), &state.f3d[0](0, 0, 0));
+
+  auto derivs = solver.create_solver_fields();
+
+  ddt(field2d) = 3.0;
+  ddt(field3d) = 4.0;
+  const BoutReal* ddt_data = &ddt(field3d)(0, 0, 0);
+  const BoutReal* derivs_data = &derivs.f3d[0](0, 0, 0);
+
+  // Saving the derivatives exchanges the data
+  solver.save_derivs(derivs);
+  EXPECT_TRUE(IsFieldEqual(derivs.f2d[0], 3.0));
+  EXPECT_TRUE(IsFieldEqual(derivs.f3d[0], 4.0));
+  EXPECT_EQ(&derivs.f3d[0](0, 0, 0), ddt_data);
+  EXPECT_EQ(&ddt(field3d)(0, 0, 0), derivs_data);
+
+  solver.release_vars();
+  EXPECT_FALSE(field2d.isAllocated());
+  EXPECT_FALSE(field3d.isAllocated());
+  EXPECT_TRUE(IsFieldEqual(state.f3d[0], 2.0));
+}
+
+TEST_F(SolverTest, ProbeJacobianPattern) {
+  Options options;
+  FakeSolver solver{&options};
+
+  Options::root()["input"]["transform_from_field_aligned"] = false;
+
+  Field2D field2d{bout::globals::mesh};
+  Field3D field3d{bout::globals::mesh};
+  solver.add(field2d, "field");
+  solver.add(field3d, "another_field");
+  solver.init();
+
+  field2d = 2.0;
+  field3d = 1.0;
+
+  const int nz = bout::globals::mesh->LocalNz;
+  const auto rhs = [&]() {
+    ddt(field2d) = field2d;
+    ddt(field3d).allocate();
+    BOUT_FOR_SERIAL(i, field3d.getRegion("RGN_NOBNDRY")) {
+      ddt(field3d)[i] =
+          field3d(i.x(), i.y() - 1, (i.z() + 2) % nz) + field2d(i.x(), i.y());
+    }
+  };
+
+  const auto pattern = solver.probeJacobianPattern(rhs, 2);
+
+  const auto contains = [&](int row, int column, int x, int y, int z) {
+    return std::any_of(pattern.begin(), pattern.end(), [&](const auto& coupling) {
+      return coupling.row == row and coupling.column == column and coupling.x == x
+             and coupling.y == y and coupling.z == z;
+    });
+  };
+
+  // The 2D variable is first, then the 3D variable
+  EXPECT_EQ(pattern.size(), 4);
+  EXPECT_TRUE(contains(0, 0, 0, 0, 0));
+  EXPECT_TRUE(contains(1, 0, 0, 0, 0));
+  EXPECT_TRUE(contains(1, 1, 0, 0, 0));
+  EXPECT_TRUE(contains(1, 1, 0, -1, 2));
+
+  // The state is restored
+  EXPECT_TRUE(IsFieldEqual(field2d, 2.0, "RGN_NOBNDRY"));
+  EXPECT_TRUE(IsFieldEqual(field3d, 1.0, "RGN_NOBNDRY"));
+
+  // Each row of the Jacobian has the columns in the pattern, apart
+  // from those outside the domain
+  const Field3D index = solver.globalIndex(0);
+  int nrows = 0;
+  solver.forEachJacobianRow(pattern, index,
+                            [&](int row, const std::vector<int>& columns) {
+                              ++nrows;
+                              EXPECT_TRUE(std::is_sorted(columns.begin(), columns.end()));
+                              EXPECT_TRUE(std::find(columns.begin(), columns.end(), row)
+                                          != columns.end());
+                            });
+  EXPECT_EQ(nrows, solver.getLocalN());
+
+  // The star pattern couples each 3D variable to its neighbours in Z
+  const auto star = solver.starJacobianPattern();
+  EXPECT_EQ(std::count_if(star.begin(), star.end(),
+                          [](const auto& coupling) { return coupling.z != 0; }),
+            2);
+
+  // A coupling one point wider than the probe width is found at the
+  // edge of the lattice, rather than folded onto a nearer offset
+  WithQuietOutput quiet{output_warn};
+  const auto narrow = solver.probeJacobianPattern(rhs, 0);
+  EXPECT_EQ(narrow.size(), 4);
+  EXPECT_TRUE(std::any_of(narrow.begin(), narrow.end(), [](const auto& coupling) {
+    return coupling.row == 1 and coupling.column == 1 and coupling.x == 0
+           and coupling.y == -1 and coupling.z == 2;
+  }));
+}
+
+TEST_F(SolverTest, ZGuardCells) {
+  // As if Z were split between processors, with one guard cell at
+  // each end of this processor's part
+  FakeMesh zmesh{nx, ny, nz + 2};
+  zmesh.GlobalNz = nz;
+  zmesh.zstart = 1;
+  zmesh.zend = nz;
+  zmesh.createDefaultRegions();
+  zmesh.createBoundaryRegions();
+  zmesh.setCoordinates(nullptr);
+
+  // The solver packs the variables on the global mesh
+  Mesh* global_mesh = bout::globals::mesh;
+  bout::globals::mesh = &zmesh;
+
+  // Communicating the index needs a parallel transform
+  zmesh.setCoordinates(std::make_shared<Coordinates>(
+      &zmesh, Field2D{1.0}, Field2D{1.0}, BoutReal{1.0}, Field2D{1.0}, Field2D{0.0},
+      Field2D{1.0}, Field2D{1.0}, Field2D{1.0}, Field2D{0.0}, Field2D{0.0}, Field2D{0.0},
+      Field2D{1.0}, Field2D{1.0}, Field2D{1.0}, Field2D{0.0}, Field2D{0.0}, Field2D{0.0},
+      Field2D{0.0}, Field2D{0.0}));
+  zmesh.getCoordinates()->setParallelTransform(
+      bout::utils::make_unique<ParallelTransformIdentity>(zmesh));
+
+  Options options;
+  FakeSolver solver{&options};
+
+  Options::root()["input"]["transform_from_field_aligned"] = false;
+
+  Field2D field2d{&zmesh};
+  Field3D field3d{&zmesh};
+  solver.add(field2d, "field");
+  solver.add(field3d, "another_field");
+  solver.init();
+
+  constexpr int n2d = (nx - 2) * (ny - 2);
+  EXPECT_EQ(solver.getLocalN(), n2d * (1 + nz));
+
+  // The guard cells aren't evolved
+  field2d = 1.0;
+  field3d = -1.0;
+  BOUT_FOR_SERIAL(i, field3d.getRegion("RGN_NOBNDRY")) { field3d[i] = 2.0; }
+  std::vector<BoutReal> state(solver.getLocalN());
+  solver.save_vars(state.data());
+  EXPECT_EQ(std::count(state.begin(), state.end(), 1.0), n2d);
+  EXPECT_EQ(std::count(state.begin(), state.end(), 2.0), n2d * nz);
+
+  // Each evolving value is one row of the Jacobian
+  const Field3D index = solver.globalIndex(0);
+  std::vector<int> rows;
+  solver.forEachJacobianRow(solver.starJacobianPattern(), index,
+                            [&](int row, const std::vector<int>& columns) {
+                              rows.push_back(row);
+                              EXPECT_GE(columns.front(), 0);
+                              EXPECT_LT(columns.back(), solver.getLocalN());
+                            });
+  std::sort(rows.begin(), rows.end());
+  std::vector<int> expected_rows(solver.getLocalN());
+  std::iota(expected_rows.begin(), expected_rows.end(), 0);
+  EXPECT_EQ(rows, expected_rows);
+
+  bout::globals::mesh = global_mesh;
+}
+
 TEST_F(SolverTest, HavePreconditioner) {
   Options options;
   FakeSolver solver{&options};
@@ -679,3 +679,93 @@ TEST_F(ExpressionParserTest, FuzzyFind) {
   EXPECT_EQ(first_CAPS_match->name, "multiply");
   EXPECT_EQ(first_CAPS_match->distance, 1);
 }
+
+TEST_F(ExpressionParserTest, CompileArithmetic) {
+  auto fieldgen = parser.parseString("(x + 2*y) * z - t / 4 ^ 2");
+
+  const bout::generator::Program program(fieldgen);
+  EXPECT_EQ(program.numGeneric(), 0);
+
+  const int n = static_cast<int>(x_array.size());
+  bout::generator::Program::Workspace workspace(program, n);
+  std::vector<BoutReal> result(n);
+
+  for (auto t : t_array) {
+    program.evaluate(workspace, n, x_array.data(), y_array.data(), z_array.data(), t,
+                     result.data(), [&](int i) {
+                       return LegacyContext(x_array[i], y_array[i], z_array[i], t);
+                     });
+    for (int i = 0; i < n; ++i) {
+      EXPECT_DOUBLE_EQ(result[i], fieldgen->generate(LegacyContext(
+                                      x_array[i], y_array[i], z_array[i], t)));
+    }
+  }
+}
+
+TEST_F(ExpressionParserTest, CompileGeneric) {
+  // The context changes and sums aren't compiled, so they are evaluated
+  // point by point
+  auto fieldgen = parser.parseString("x + [x = 2 * x](x) * sum(i, 3, {i} * y)");
+
+  const bout::generator::Program program(fieldgen);
+  EXPECT_EQ(program.numGeneric(), 2);
+
+  const int n = static_cast<int>(x_array.size());
+  bout::generator::Program::Workspace workspace(program, n);
+  std::vector<BoutReal> result(n);
+
+  const BoutReal t = 1.0;
+  program.evaluate(workspace, n, x_array.data(), y_array.data(), z_array.data(), t,
+                   result.data(), [&](int i) {
+                     return LegacyContext(x_array[i], y_array[i], z_array[i], t);
+                   });
+  for (int i = 0; i < n; ++i) {
+    EXPECT_DOUBLE_EQ(result[i], x_array[i] + 2 * x_array[i] * 3 * y_array[i]);
+  }
+}
+
+TEST(GeneratorContextTest, Slots) {
+  EXPECT_EQ(Context::slot("x"), Context::x_slot);
+  EXPECT_EQ(Context::slot("t"), Context::t_slot);
+
+  const int slot = Context::slot("test_slot_parameter");
+  EXPECT_GT(slot, Context::t_slot);
+  EXPECT_EQ(Context::slot("test_slot_parameter"), slot);
+  EXPECT_EQ(Context::slotName(slot), "test_slot_parameter");
+
+  auto ctx = Context().set(slot, 3.0).set(Context::y_slot, 2.0);
+  EXPECT_DOUBLE_EQ(ctx.get("test_slot_parameter"), 3.0);
+  EXPECT_DOUBLE_EQ(ctx.get(slot), 3.0);
+  EXPECT_DOUBLE_EQ(ctx.y(), 2.0);
+}
+
+TEST(GeneratorContextTest, ManySlots) {
+  // More names than fit in the Context itself
+  Context ctx;
+  std::vector<int> slots;
+  for (int i = 0; i < 2 * Context::inline_slots; ++i) {
+    slots.push_back(Context::slot(fmt::format("test_many_slots_{:d}", i)));
+    ctx.set(slots.back(), static_cast<BoutReal>(i));
+  }
+  EXPECT_GE(slots.back(), Context::inline_slots);
+  for (int i = 0; i < 2 * Context::inline_slots; ++i) {
+    EXPECT_DOUBLE_EQ(ctx.get(slots[i]), static_cast<BoutReal>(i));
+  }
+  EXPECT_DOUBLE_EQ(ctx.get(fmt::format("test_many_slots_{:d}", Context::inline_slots)),
+                   static_cast<BoutReal>(Context::inline_slots));
+
+  const Context unset;
+  EXPECT_THROW(unset.get(slots.back()), BoutException);
+
+  // Names past the inline slots can be used in expressions
+  auto gen = ExpressionParserSubClass().parseString(
+      fmt::format("2 * {{test_many_slots_{:d}}}", 2 * Context::inline_slots - 1));
+  EXPECT_DOUBLE_EQ(gen->generate(ctx), 2.0 * (2 * Context::inline_slots - 1));
+}
+
+TEST(GeneratorContextTest, GetUnset) {
+  const Context ctx;
+  EXPECT_DOUBLE_EQ(ctx.x(), 0.0);
+  EXPECT_THROW(ctx.get(Context::slot("test_unset_parameter")), BoutException);
+  EXPECT_THROW(ctx.get("test_never_added_parameter"), BoutException);
+}
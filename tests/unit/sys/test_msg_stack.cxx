@@ -1,3 +1,5 @@
+#include "bout/build_config.hxx"
+
 // These tests rely on MsgStack::getDump, and so won't work without it
 #if BOUT_USE_MSGSTACK
 
@@ -7,6 +9,7 @@
 
 #include <iostream>
 #include <string>
+#include <thread>
 
 TEST(MsgStackTest, BasicTest) {
   MsgStack msg_stack;
@@ -92,6 +95,24 @@ TEST(MsgStackTest, ClearTest) {
   EXPECT_EQ(dump, expected_dump);
 }
 
+TEST(MsgStackTest, OtherThreadTest) {
+  MsgStack msg_stack;
+
+  msg_stack.push("First");
+
+  // Other threads neither change nor read the stack
+  std::string other_dump;
+  std::thread other([&msg_stack, &other_dump]() {
+    msg_stack.push("Other");
+    msg_stack.clear();
+    other_dump = msg_stack.getDump();
+  });
+  other.join();
+
+  EXPECT_EQ(other_dump, "====== Back trace ======\n");
+  EXPECT_EQ(msg_stack.getDump(), "====== Back trace ======\n -> First\n");
+}
+
 TEST(MsgStackTest, CanUseGlobal) {
   msg_stack.clear();
 
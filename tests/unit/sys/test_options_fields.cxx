@@ -4,10 +4,13 @@
 #include "gtest/gtest.h"
 
 #include "test_extras.hxx"
+#include "bout/async_writer.hxx"
 #include "bout/field3d.hxx"
 #include "bout/mesh.hxx"
 #include "bout/unused.hxx"
 
+#include <algorithm>
+
 /// Global mesh
 namespace bout {
 namespace globals {
@@ -136,3 +139,24 @@ TEST_F(OptionsFieldTest, RetrieveField2DfromBadString) {
 
   EXPECT_THROW(Field2D other = options.as<Field2D>(), ParseException);
 }
+
+TEST_F(OptionsFieldTest, SnapshotDoesNotShareData) {
+  Field3D field = 1.0;
+  Array<BoutReal> array(3);
+  std::fill(array.begin(), array.end(), 1.0);
+
+  // The options share data with field and array
+  Options options;
+  options["field"] = field;
+  options["section"]["array"] = array;
+
+  Options copied = bout::snapshot(options);
+
+  // Modify the original data in place
+  field(1, 1, 1) = 2.0;
+  array[0] = 3.0;
+
+  EXPECT_DOUBLE_EQ(options["field"].as<Field3D>()(1, 1, 1), 2.0);
+  EXPECT_DOUBLE_EQ(copied["field"].as<Field3D>()(1, 1, 1), 1.0);
+  EXPECT_DOUBLE_EQ(copied["section"]["array"].as<Array<BoutReal>>()[0], 1.0);
+}
@@ -7,13 +7,21 @@
 #include "gtest/gtest.h"
 
 #include "test_extras.hxx"
+#include "bout/async_writer.hxx"
 #include "bout/field3d.hxx"
 #include "bout/mesh.hxx"
 #include "bout/options_netcdf.hxx"
 
+#include <netcdf>
+#include <netcdf_meta.h>
+
 using bout::OptionsNetCDF;
 
 #include <cstdio>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
 
 /// Global mesh
 namespace bout {
@@ -271,6 +279,31 @@ TEST_F(OptionsNetCDFTest, VerifyTimesteps) {
   EXPECT_THROW(OptionsNetCDF(filename).verifyTimesteps(), BoutException);
 }
 
+TEST_F(OptionsNetCDFTest, BackfillTimesteps) {
+  {
+    Options options;
+    options["thing1"].assignRepeat(1.0);
+    OptionsNetCDF(filename).write(options);
+  }
+  {
+    Options options;
+    options["thing1"].assignRepeat(2.0);
+    // Not written in the first time slice
+    options["thing2"].assignRepeat(3.0);
+    options["thing2"].attributes["backfill"] = 0.0;
+    OptionsNetCDF(filename, OptionsNetCDF::FileMode::append).write(options);
+  }
+
+  EXPECT_NO_THROW(OptionsNetCDF(filename).verifyTimesteps());
+
+  Options data = OptionsNetCDF(filename).read();
+  const auto thing2 = data["thing2"].as<Array<BoutReal>>();
+  ASSERT_EQ(thing2.size(), 2);
+  EXPECT_DOUBLE_EQ(thing2[0], 0.0);
+  EXPECT_DOUBLE_EQ(thing2[1], 3.0);
+  EXPECT_FALSE(data["thing2"].hasAttribute("backfill"));
+}
+
 TEST_F(OptionsNetCDFTest, WriteTimeDimension) {
   {
     Options options;
@@ -305,4 +338,247 @@ TEST_F(OptionsNetCDFTest, WriteMultipleTimeDimensions) {
   EXPECT_NO_THROW(OptionsNetCDF(filename).verifyTimesteps());
 }
 
+TEST_F(OptionsNetCDFTest, ReadWriteCompressed) {
+  {
+    Options options;
+    options["evolving"].assignRepeat(Field2D(2.4));
+    options["constant"] = Field3D(1.5);
+    // Override the file's settings
+    options["constant"].attributes["deflate"] = 0;
+
+    bout::NetCDFStorage storage;
+    storage.deflate = 4;
+    storage.shuffle = true;
+
+    OptionsNetCDF file(filename);
+    file.setStorage(storage);
+    file.write(options);
+    file.write(options);
+  }
+
+  Options data = OptionsNetCDF(filename).read();
+
+  Tensor<BoutReal> evolving = data["evolving"].as<Tensor<BoutReal>>();
+  EXPECT_DOUBLE_EQ(evolving(1, 1, 1), 2.4);
+
+  Field3D constant = data["constant"].as<Field3D>(bout::globals::mesh);
+  EXPECT_DOUBLE_EQ(constant(1, 1, 1), 1.5);
+
+  // The overriding attribute is not written to the file
+  EXPECT_FALSE(data["constant"].hasAttribute("deflate"));
+
+  // Check the settings were applied to the variables
+  const Mesh* mesh = bout::globals::mesh;
+  netCDF::NcFile file(filename, netCDF::NcFile::read);
+
+  netCDF::NcVar::ChunkMode chunk_mode;
+  std::vector<size_t> chunks;
+  bool shuffle = false;
+  bool deflate = false;
+  int deflate_level = 0;
+
+  auto evolving_var = file.getVar("evolving");
+  evolving_var.getChunkingParameters(chunk_mode, chunks);
+  EXPECT_EQ(chunk_mode, netCDF::NcVar::nc_CHUNKED);
+  EXPECT_EQ(chunks, (std::vector<size_t>{1, static_cast<size_t>(mesh->LocalNx),
+                                         static_cast<size_t>(mesh->LocalNy)}));
+  evolving_var.getCompressionParameters(shuffle, deflate, deflate_level);
+  EXPECT_TRUE(shuffle);
+  EXPECT_TRUE(deflate);
+  EXPECT_EQ(deflate_level, 4);
+
+  auto constant_var = file.getVar("constant");
+  constant_var.getChunkingParameters(chunk_mode, chunks);
+  EXPECT_EQ(chunk_mode, netCDF::NcVar::nc_CHUNKED);
+  EXPECT_EQ(chunks, (std::vector<size_t>{static_cast<size_t>(mesh->LocalNx),
+                                         static_cast<size_t>(mesh->LocalNy),
+                                         static_cast<size_t>(mesh->LocalNz)}));
+  constant_var.getCompressionParameters(shuffle, deflate, deflate_level);
+  EXPECT_TRUE(shuffle);
+  EXPECT_FALSE(deflate);
+}
+
+TEST_F(OptionsNetCDFTest, RestartStorageIsLossless) {
+  Options options;
+  options["deflate"] = 2;
+  options["shuffle"] = true;
+  options["quantize"] = 3;
+  options["chunk_time"] = 4;
+
+  const auto storage = bout::getNetCDFStorage(options, true);
+  EXPECT_EQ(storage.deflate, 2);
+  EXPECT_TRUE(storage.shuffle);
+  EXPECT_EQ(storage.quantize, 0);
+  EXPECT_EQ(storage.chunk_time, 4);
+
+  EXPECT_EQ(bout::getNetCDFStorage(options).quantize, 3);
+}
+
+TEST_F(OptionsNetCDFTest, ReadSlab) {
+  {
+    Field3D field{bout::globals::mesh};
+    field.allocate();
+    for (const auto& i : field.getRegion("RGN_ALL")) {
+      field[i] = 100 * i.x() + 10 * i.y() + i.z();
+    }
+
+    Options options;
+    options["scalar"] = 3;
+    options["field"] = field;
+    options["field"].attributes["units"] = "m";
+
+    OptionsNetCDF(filename).write(options);
+  }
+
+  OptionsNetCDF file(filename);
+  std::map<std::string, std::vector<int>> skipped;
+  Options data = file.read(1, skipped);
+
+  EXPECT_EQ(data["scalar"], 3);
+  EXPECT_FALSE(data.isSet("field"));
+  EXPECT_EQ(data["field"].attributes["units"].as<std::string>(), "m");
+  ASSERT_EQ(skipped.count("field"), 1);
+  EXPECT_EQ(skipped["field"], (std::vector<int>{bout::globals::mesh->LocalNx,
+                                                bout::globals::mesh->LocalNy,
+                                                bout::globals::mesh->LocalNz}));
+
+  const auto slab = file.readSlab("field", {1, 2, 3}, {2, 2, 2}).as<Tensor<BoutReal>>();
+  EXPECT_EQ(slab.shape(), std::make_tuple(2, 2, 2));
+  EXPECT_DOUBLE_EQ(slab(0, 0, 0), 123);
+  EXPECT_DOUBLE_EQ(slab(1, 1, 1), 234);
+
+  EXPECT_THROW(file.readSlab("field", {0, 0}, {1, 1}), BoutException);
+  EXPECT_THROW(file.readSlab("missing", {0}, {1}), BoutException);
+  EXPECT_THROW(file.readSlab("field", {1, 2, 3}, {2, 2, 1000}), BoutException);
+  EXPECT_THROW(file.readSlab("field", {-1, 2, 3}, {2, 2, 2}), BoutException);
+}
+
+TEST_F(OptionsNetCDFTest, ReadSlabAfterWrite) {
+  const auto makeArray = [](BoutReal start) {
+    Array<BoutReal> values(4);
+    for (int i = 0; i < 4; ++i) {
+      values[i] = start + i;
+    }
+    return values;
+  };
+
+  {
+    Options options;
+    options["x"] = makeArray(1.);
+    options["y"] = makeArray(5.);
+    OptionsNetCDF(filename).write(options);
+  }
+
+  OptionsNetCDF file(filename, OptionsNetCDF::FileMode::append);
+
+  // Several reads through the same open file
+  EXPECT_DOUBLE_EQ(file.readSlab("x", {1}, {2}).as<Array<BoutReal>>()[1], 3.);
+  EXPECT_DOUBLE_EQ(file.readSlab("y", {0}, {4}).as<Array<BoutReal>>()[3], 8.);
+  EXPECT_DOUBLE_EQ(file.readSlab("x", {3}, {1}).as<Array<BoutReal>>()[0], 4.);
+
+  // Writing to the file means later reads see the new values
+  Options options;
+  options["x"] = makeArray(-4.);
+  file.write(options);
+
+  EXPECT_DOUBLE_EQ(file.readSlab("x", {1}, {2}).as<Array<BoutReal>>()[1], -2.);
+  EXPECT_DOUBLE_EQ(file.readSlab("y", {0}, {4}).as<Array<BoutReal>>()[3], 8.);
+}
+
+TEST_F(OptionsNetCDFTest, AsyncWriteSnapshotsData) {
+  {
+    OptionsNetCDF file(filename);
+    bout::AsyncWriter writer(true);
+
+    Field2D field = 1.0;
+    Options options;
+    options["field"].assignRepeat(field);
+
+    writer.write(file, options);
+    writer.finishStep();
+
+    // Modifying the field in place after the write is queued doesn't
+    // change what is written
+    field(1, 1) = 2.0;
+    writer.write(file, options);
+    writer.verifyTimesteps(file);
+    writer.flush();
+  }
+
+  Options data = OptionsNetCDF(filename).read();
+  Tensor<BoutReal> values = data["field"].as<Tensor<BoutReal>>();
+
+  EXPECT_DOUBLE_EQ(values(0, 1, 1), 1.0);
+  EXPECT_DOUBLE_EQ(values(1, 1, 1), 2.0);
+}
+
+TEST_F(OptionsNetCDFTest, AsyncWriteRethrowsErrors) {
+  {
+    Options options;
+    options["thing1"].assignRepeat(1.0);
+    options["thing2"].assignRepeat(1.0, "t2");
+    OptionsNetCDF(filename).write(options, "t2");
+  }
+
+  OptionsNetCDF file(filename, OptionsNetCDF::FileMode::append);
+  bout::AsyncWriter writer(true);
+  writer.verifyTimesteps(file);
+
+  EXPECT_THROW(writer.flush(), BoutException);
+}
+
+#if NC_HAS_PARALLEL4
+TEST_F(OptionsNetCDFTest, ParallelWrite) {
+  Mesh* mesh = bout::globals::mesh;
+  {
+    Field3D field{mesh};
+    field.allocate();
+    for (const auto& i : field.getRegion("RGN_ALL")) {
+      field[i] = 100 * i.x() + 10 * i.y() + i.z();
+    }
+
+    FieldPerp inside(2.0);
+    inside.setIndex(mesh->ystart + 1);
+    // In the Y boundary, so not part of the global arrays
+    FieldPerp boundary(3.0);
+    boundary.setIndex(0);
+
+    Options options;
+    options["scalar"] = 3;
+    options["field"] = field;
+    options["inside"] = inside;
+    options["boundary"] = boundary;
+
+    OptionsNetCDF file(filename, OptionsNetCDF::FileMode::replace, true);
+    for (int t = 0; t < 2; ++t) {
+      options["time"].assignRepeat(static_cast<BoutReal>(t));
+      file.write(options);
+    }
+  }
+
+  Options data = OptionsNetCDF(filename).read();
+
+  EXPECT_EQ(data["scalar"], 3);
+
+  const auto time = data["time"].as<Array<BoutReal>>();
+  ASSERT_EQ(time.size(), 2);
+  EXPECT_DOUBLE_EQ(time[0], 0.0);
+  EXPECT_DOUBLE_EQ(time[1], 1.0);
+
+  // Y boundary cells are not written
+  const auto field = data["field"].as<Tensor<BoutReal>>();
+  const int ny = mesh->yend - mesh->ystart + 1;
+  EXPECT_EQ(field.shape(), std::make_tuple(mesh->LocalNx, ny, mesh->LocalNz));
+  EXPECT_DOUBLE_EQ(field(1, 0, 2), 100 + 10 * mesh->ystart + 2);
+  EXPECT_DOUBLE_EQ(field(2, ny - 1, 1), 200 + 10 * mesh->yend + 1);
+
+  EXPECT_EQ(data["inside"].attributes["yindex_global"].as<int>(),
+            mesh->getGlobalYIndex(mesh->ystart + 1));
+  const auto inside = data["inside"].as<Matrix<BoutReal>>();
+  EXPECT_DOUBLE_EQ(inside(1, 1), 2.0);
+
+  EXPECT_EQ(data["boundary"].attributes["yindex_global"].as<int>(), -1);
+}
+#endif // NC_HAS_PARALLEL4
+
 #endif // BOUT_HAS_NETCDF
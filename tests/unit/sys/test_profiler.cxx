@@ -0,0 +1,208 @@
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "bout/options.hxx"
+#include "bout/sys/profiler.hxx"
+#include "bout/sys/timer.hxx"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+using bout::Profiler;
+
+namespace {
+using ms = std::chrono::duration<double, std::chrono::milliseconds::period>;
+constexpr double ProfilerTolerance{0.5e-3};
+constexpr auto sleep_length = ms(1.);
+} // namespace
+
+class ProfilerTest : public ::testing::Test {
+public:
+  ProfilerTest() { Profiler::setEnabled(true, true); }
+  ~ProfilerTest() override { Profiler::cleanup(); }
+};
+
+TEST_F(ProfilerTest, NestedRegions) {
+  {
+    BOUT_PROFILE_REGION("outer");
+    for (int i = 0; i < 3; ++i) {
+      BOUT_PROFILE_REGION("inner");
+    }
+  }
+
+  EXPECT_EQ(Profiler::getCalls("outer"), 1U);
+  EXPECT_EQ(Profiler::getCalls("outer/inner"), 3U);
+  EXPECT_EQ(Profiler::getCalls("inner"), 0U);
+  EXPECT_GE(Profiler::getTime("outer"), Profiler::getTime("outer/inner"));
+}
+
+TEST_F(ProfilerTest, GetTime) {
+  const auto start = Timer::clock_type::now();
+  {
+    BOUT_PROFILE_REGION("sleep");
+    std::this_thread::sleep_for(sleep_length);
+  }
+  const Timer::seconds elapsed = Timer::clock_type::now() - start;
+
+  EXPECT_NEAR(Profiler::getTime("sleep"), elapsed.count(), ProfilerTolerance);
+}
+
+TEST_F(ProfilerTest, OpenRegionTime) {
+  BOUT_PROFILE_REGION("open");
+  std::this_thread::sleep_for(sleep_length);
+
+  EXPECT_GE(Profiler::getTime("open"), Timer::seconds{sleep_length}.count());
+  EXPECT_EQ(Profiler::getCalls("open"), 0U);
+}
+
+TEST_F(ProfilerTest, Counters) {
+  {
+    BOUT_PROFILE_REGION("kernel");
+    Profiler::addBytes(64);
+    Profiler::addFlops(10);
+    {
+      BOUT_PROFILE_REGION("comms");
+      Profiler::addBytes(8);
+    }
+  }
+  {
+    BOUT_PROFILE_REGION("kernel");
+    Profiler::addFlops(5);
+  }
+
+  EXPECT_EQ(Profiler::getCalls("kernel"), 2U);
+  EXPECT_EQ(Profiler::getBytes("kernel"), 64U);
+  EXPECT_EQ(Profiler::getFlops("kernel"), 15U);
+  EXPECT_EQ(Profiler::getBytes("kernel/comms"), 8U);
+  EXPECT_EQ(Profiler::getFlops("kernel/comms"), 0U);
+}
+
+TEST_F(ProfilerTest, Timer) {
+  {
+    Timer timer("rhs");
+    Timer inner("comms");
+  }
+
+  EXPECT_EQ(Profiler::getCalls("rhs"), 1U);
+  EXPECT_EQ(Profiler::getCalls("rhs/comms"), 1U);
+}
+
+TEST_F(ProfilerTest, Disabled) {
+  Profiler::setEnabled(false);
+  {
+    BOUT_PROFILE_REGION("disabled");
+    Profiler::addBytes(8);
+  }
+
+  EXPECT_EQ(Profiler::getCalls("disabled"), 0U);
+  EXPECT_EQ(Profiler::getBytes("disabled"), 0U);
+}
+
+TEST_F(ProfilerTest, Cleanup) {
+  {
+    BOUT_PROFILE_REGION("region");
+  }
+  Profiler::cleanup();
+
+  EXPECT_FALSE(Profiler::enabled());
+  EXPECT_EQ(Profiler::getCalls("region"), 0U);
+}
+
+TEST_F(ProfilerTest, Configure) {
+  Profiler::setEnabled(false);
+
+  Options options{{"enabled", true}, {"max_trace_events", 10}};
+  Profiler::configure(options);
+
+  EXPECT_TRUE(Profiler::enabled());
+
+  Options bad_options{{"max_trace_events", -1}};
+  EXPECT_THROW(Profiler::configure(bad_options), BoutException);
+}
+
+TEST_F(ProfilerTest, ConfigureNoTraceByDefault) {
+  Options options{{"enabled", true}};
+  Profiler::configure(options);
+  {
+    BOUT_PROFILE_REGION("untraced");
+  }
+
+  const std::string filename = "test_profiler_notrace.json";
+  Profiler::writeTrace(filename);
+
+  std::ifstream file(filename);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  std::remove(filename.c_str());
+
+  using ::testing::HasSubstr;
+  using ::testing::Not;
+  EXPECT_EQ(Profiler::getCalls("untraced"), 1U);
+  EXPECT_THAT(contents.str(), Not(HasSubstr(R"("ph":"X")")));
+}
+
+TEST_F(ProfilerTest, OutputVars) {
+  {
+    BOUT_PROFILE_REGION("run");
+    BOUT_PROFILE_REGION("rhs");
+    Profiler::addFlops(100);
+  }
+
+  Options output;
+  Profiler::outputVars(output);
+
+  EXPECT_TRUE(output.isSet("profile_run_time_min"));
+  EXPECT_TRUE(output.isSet("profile_run_time_max"));
+  EXPECT_TRUE(output.isSet("profile_run_time_mean"));
+  EXPECT_DOUBLE_EQ(output["profile_run_calls"].as<BoutReal>(), 1.0);
+  EXPECT_DOUBLE_EQ(output["profile_run.rhs_flops_max"].as<BoutReal>(), 100.0);
+  EXPECT_DOUBLE_EQ(output["profile_run.rhs_flops_mean"].as<BoutReal>(), 100.0);
+  // No bytes were counted, so these aren't written
+  EXPECT_FALSE(output.isSet("profile_run.rhs_bytes_max"));
+  // Each output step is kept
+  EXPECT_EQ(output["profile_run_time_max"].attributes["time_dimension"].as<std::string>(),
+            "t");
+  EXPECT_EQ(output["profile_run_calls"].attributes["time_dimension"].as<std::string>(),
+            "t");
+  // Filled with zeros in earlier outputs if first written later
+  EXPECT_DOUBLE_EQ(output["profile_run_time_max"].attributes["backfill"].as<BoutReal>(),
+                   0.0);
+  EXPECT_DOUBLE_EQ(
+      output["profile_run.rhs_flops_mean"].attributes["backfill"].as<BoutReal>(), 0.0);
+}
+
+TEST_F(ProfilerTest, OutputVarsDisabled) {
+  {
+    BOUT_PROFILE_REGION("run");
+  }
+  Profiler::setEnabled(false);
+
+  Options output;
+  Profiler::outputVars(output);
+
+  EXPECT_FALSE(output.isSet("profile_run_time_max"));
+}
+
+TEST_F(ProfilerTest, WriteTrace) {
+  {
+    BOUT_PROFILE_REGION("traced \"region\"");
+    Profiler::addBytes(16);
+  }
+
+  const std::string filename = "test_profiler_trace.json";
+  Profiler::writeTrace(filename);
+
+  std::ifstream file(filename);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  std::remove(filename.c_str());
+
+  using ::testing::HasSubstr;
+  EXPECT_THAT(contents.str(), HasSubstr(R"("traceEvents")"));
+  EXPECT_THAT(contents.str(), HasSubstr(R"("name":"traced \"region\"","cat":"bout")"));
+  EXPECT_THAT(contents.str(), HasSubstr(R"("bytes":16)"));
+  EXPECT_THAT(contents.str(), HasSubstr(R"("dropped_events":0)"));
+}
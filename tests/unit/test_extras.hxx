@@ -6,6 +6,7 @@
 #include <functional>
 #include <iostream>
 #include <numeric>
+#include <random>
 #include <vector>
 
 #include "bout/boutcomm.hxx"
@@ -29,6 +30,23 @@ void fillField(Field2D& f, std::vector<std::vector<BoutReal>> values);
 
 using bout::utils::EnableIfField;
 
+/// Creates a Field filled with random, uniformly distributed numbers
+///
+/// Usage
+///   std::default_random_engine re;
+///   auto field = random_field<Field3D>(re);
+///
+template <class FieldType>
+FieldType random_field(std::default_random_engine& re) {
+  std::uniform_real_distribution<double> unif(-1.0, 1.0);
+  // Create a field of requested type
+  FieldType result;
+  result.allocate();
+  // Fill with random numbers
+  BOUT_FOR(i, result.getRegion("RGN_ALL")) { result[i] = unif(re); }
+  return result;
+}
+
 /// Returns a field filled with the result of \p fill_function at each point
 /// Arbitrary arguments can be passed to the field constructor
 template <class T, class... Args, typename = EnableIfField<T>>
@@ -239,12 +257,12 @@ public:
   BoutReal GlobalY(int jy) const override { return jy; }
   BoutReal GlobalX(BoutReal jx) const override { return jx; }
   BoutReal GlobalY(BoutReal jy) const override { return jy; }
-  int getGlobalXIndex(int) const override { return 0; }
+  int getGlobalXIndex(int x) const override { return x; }
   int getGlobalXIndexNoBoundaries(int) const override { return 0; }
   int getGlobalYIndex(int y) const override { return y; }
   int getGlobalYIndexNoBoundaries(int y) const override { return y; }
-  int getGlobalZIndex(int) const override { return 0; }
-  int getGlobalZIndexNoBoundaries(int) const override { return 0; }
+  int getGlobalZIndex(int z) const override { return z - zstart; }
+  int getGlobalZIndexNoBoundaries(int z) const override { return z - zstart; }
   int getLocalXIndex(int) const override { return 0; }
   int getLocalXIndexNoBoundaries(int) const override { return 0; }
   int getLocalYIndex(int y) const override { return y; }
@@ -260,37 +278,37 @@ public:
   void createBoundaryRegions() {
     addRegion2D("RGN_LOWER_Y",
                 Region<Ind2D>(0, LocalNx - 1, 0, ystart - 1, 0, 0, LocalNy, 1));
-    addRegion3D("RGN_LOWER_Y", Region<Ind3D>(0, LocalNx - 1, 0, ystart - 1, 0,
-                                             LocalNz - 1, LocalNy, LocalNz));
+    addRegion3D("RGN_LOWER_Y", Region<Ind3D>(0, LocalNx - 1, 0, ystart - 1, zstart,
+                                             zend, LocalNy, LocalNz));
     addRegion2D("RGN_LOWER_Y_THIN", getRegion2D("RGN_LOWER_Y"));
     addRegion3D("RGN_LOWER_Y_THIN", getRegion3D("RGN_LOWER_Y"));
 
     addRegion2D("RGN_UPPER_Y",
                 Region<Ind2D>(0, LocalNx - 1, yend + 1, LocalNy - 1, 0, 0, LocalNy, 1));
-    addRegion3D("RGN_UPPER_Y", Region<Ind3D>(0, LocalNx - 1, yend + 1, LocalNy - 1, 0,
-                                             LocalNz - 1, LocalNy, LocalNz));
+    addRegion3D("RGN_UPPER_Y", Region<Ind3D>(0, LocalNx - 1, yend + 1, LocalNy - 1,
+                                             zstart, zend, LocalNy, LocalNz));
     addRegion2D("RGN_UPPER_Y_THIN", getRegion2D("RGN_UPPER_Y"));
     addRegion3D("RGN_UPPER_Y_THIN", getRegion3D("RGN_UPPER_Y"));
 
     addRegion2D("RGN_INNER_X",
                 Region<Ind2D>(0, xstart - 1, ystart, yend, 0, 0, LocalNy, 1));
-    addRegion3D("RGN_INNER_X", Region<Ind3D>(0, xstart - 1, ystart, yend, 0, LocalNz - 1,
+    addRegion3D("RGN_INNER_X", Region<Ind3D>(0, xstart - 1, ystart, yend, zstart, zend,
                                              LocalNy, LocalNz));
     addRegionPerp("RGN_INNER_X",
-                  Region<IndPerp>(0, xstart - 1, 0, 0, 0, LocalNz - 1, 1, LocalNz));
+                  Region<IndPerp>(0, xstart - 1, 0, 0, zstart, zend, 1, LocalNz));
     addRegionPerp("RGN_INNER_X_THIN",
-                  Region<IndPerp>(0, xstart - 1, 0, 0, 0, LocalNz - 1, 1, LocalNz));
+                  Region<IndPerp>(0, xstart - 1, 0, 0, zstart, zend, 1, LocalNz));
     addRegion2D("RGN_INNER_X_THIN", getRegion2D("RGN_INNER_X"));
     addRegion3D("RGN_INNER_X_THIN", getRegion3D("RGN_INNER_X"));
 
     addRegion2D("RGN_OUTER_X",
                 Region<Ind2D>(xend + 1, LocalNx - 1, ystart, yend, 0, 0, LocalNy, 1));
-    addRegion3D("RGN_OUTER_X", Region<Ind3D>(xend + 1, LocalNx - 1, ystart, yend, 0,
-                                             LocalNz - 1, LocalNy, LocalNz));
-    addRegionPerp("RGN_OUTER_X", Region<IndPerp>(xend + 1, LocalNx - 1, 0, 0, 0,
-                                                 LocalNz - 1, 1, LocalNz));
-    addRegionPerp("RGN_OUTER_X_THIN", Region<IndPerp>(xend + 1, LocalNx - 1, 0, 0, 0,
-                                                      LocalNz - 1, 1, LocalNz));
+    addRegion3D("RGN_OUTER_X", Region<Ind3D>(xend + 1, LocalNx - 1, ystart, yend, zstart,
+                                             zend, LocalNy, LocalNz));
+    addRegionPerp("RGN_OUTER_X", Region<IndPerp>(xend + 1, LocalNx - 1, 0, 0, zstart,
+                                                 zend, 1, LocalNz));
+    addRegionPerp("RGN_OUTER_X_THIN", Region<IndPerp>(xend + 1, LocalNx - 1, 0, 0, zstart,
+                                                      zend, 1, LocalNz));
     addRegion2D("RGN_OUTER_X_THIN", getRegion2D("RGN_OUTER_X"));
     addRegion3D("RGN_OUTER_X_THIN", getRegion3D("RGN_OUTER_X"));
 